@@ -7,25 +7,41 @@
 #include "FeedProvider.hpp"
 #include <aliceVision/config.hpp>
 #include "ImageFeed.hpp"
+#include "PrefetchFeed.hpp"
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENCV)
 #include "VideoFeed.hpp"
 #endif
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <string>
 #include <limits>
+#include <utility>
+#include <vector>
 #include <ctype.h>
 
 namespace aliceVision{
 namespace dataio{
 
-FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calibPath) 
-: _isVideo(false), _isLiveFeed(false)
+namespace {
+
+/**
+ * @brief Create the feed of a media.
+ * @param[in] feedPath The media path.
+ * @param[in] calibPath The camera intrinsics path.
+ * @param[out] isVideo True if the feed is a video.
+ * @param[out] isLiveFeed True if the feed is a live stream.
+ */
+std::unique_ptr<IFeed> createFeed(const std::string &feedPath, const std::string &calibPath,
+                                  bool &isVideo, bool &isLiveFeed)
 {
   namespace bf = boost::filesystem;
+  std::unique_ptr<IFeed> feeder;
+  isVideo = false;
+  isLiveFeed = false;
   if(feedPath.empty())
   {
     throw std::invalid_argument("Empty filepath.");
@@ -36,14 +52,14 @@ FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calib
     const std::string extension = bf::path(feedPath).extension().string();
     if(ImageFeed::isSupported(extension))
     {
-      _feeder.reset(new ImageFeed(feedPath, calibPath));
+      feeder.reset(new ImageFeed(feedPath, calibPath));
     }
     else 
     {
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENCV)
       // let's try it with a video
-      _feeder.reset(new VideoFeed(feedPath, calibPath));
-      _isVideo = true;
+      feeder.reset(new VideoFeed(feedPath, calibPath));
+      isVideo = true;
 #else
       throw std::invalid_argument("Unsupported mode! If you intended to use a video"
                                   " please add OpenCV support");
@@ -55,22 +71,48 @@ FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calib
   else if(bf::is_directory(bf::path(feedPath)) || bf::is_directory(bf::path(feedPath).parent_path()))
   {
     // Folder or sequence of images
-    _feeder.reset(new ImageFeed(feedPath, calibPath));
+    feeder.reset(new ImageFeed(feedPath, calibPath));
   }
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENCV)
   else if(isdigit(feedPath[0]))
   {
     // let's try it with a video
     const int deviceNumber =  std::atoi(feedPath.c_str());
-    _feeder.reset(new VideoFeed(deviceNumber, calibPath));
-    _isVideo = true;
-    _isLiveFeed = true;
+    feeder.reset(new VideoFeed(deviceNumber, calibPath));
+    isVideo = true;
+    isLiveFeed = true;
   }
 #endif
   else
   {
     throw std::invalid_argument(std::string("Input filepath not supported: ") + feedPath);
   }
+  return feeder;
+}
+
+} // namespace
+
+FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calibPath) 
+: _isVideo(false), _isLiveFeed(false)
+{
+  _feeder = createFeed(feedPath, calibPath, _isVideo, _isLiveFeed);
+}
+
+FeedProvider::FeedProvider(const std::string &feedPath, const std::string &calibPath,
+                           const PrefetchOptions &prefetchOptions)
+: _isVideo(false), _isLiveFeed(false)
+{
+  std::vector<std::unique_ptr<IFeed>> feeds;
+  feeds.push_back(createFeed(feedPath, calibPath, _isVideo, _isLiveFeed));
+
+  // a video is decoded sequentially, by a single thread
+  const std::size_t nbFeeds = _isVideo ? 1 : std::max<std::size_t>(1, prefetchOptions.nbThreads);
+  bool isVideo = false;
+  bool isLiveFeed = false;
+  while(feeds.size() < nbFeeds)
+    feeds.push_back(createFeed(feedPath, calibPath, isVideo, isLiveFeed));
+
+  _feeder.reset(new PrefetchFeed(std::move(feeds), prefetchOptions));
 }
 
 bool FeedProvider::readImage(image::Image<image::RGBColor> &imageRGB,
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "IFeed.hpp"
+#include "PrefetchFeed.hpp"
 
 #include <string>
 #include <memory>
@@ -19,6 +20,19 @@ class FeedProvider
 public:
   
   FeedProvider(const std::string &feedPath, const std::string &calibPath = "");
+
+  /**
+   * @brief Set up a feed whose next frames are decoded in background threads.
+   * A video is decoded by a single thread, an image sequence by
+   * \p prefetchOptions.nbThreads threads.
+   *
+   * @param[in] feedPath The media path.
+   * @param[in] calibPath The camera intrinsics path.
+   * @param[in] prefetchOptions The prefetching options.
+   * @see PrefetchFeed
+   */
+  FeedProvider(const std::string &feedPath, const std::string &calibPath,
+               const PrefetchOptions &prefetchOptions);
   
   /**
    * @brief Provide a new RGB image from the feed.
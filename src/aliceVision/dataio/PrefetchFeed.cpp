@@ -0,0 +1,324 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PrefetchFeed.hpp"
+#include <aliceVision/image/convertion.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace aliceVision{
+namespace dataio{
+
+namespace {
+
+const std::size_t invalidFrame = std::numeric_limits<std::size_t>::max();
+
+/**
+ * @brief Downscale an image of unsigned char channels, each output pixel is the mean of factor x factor pixels.
+ */
+template<typename T>
+void downscaleImage(const image::Image<T> &in, int factor, image::Image<T> &out)
+{
+  static_assert(sizeof(T) % sizeof(unsigned char) == 0, "unsigned char channels expected");
+  const int nbChannels = sizeof(T);
+  const int width = in.Width() / factor;
+  const int height = in.Height() / factor;
+  const int area = factor * factor;
+
+  out.resize(width, height);
+  std::vector<int> rowSum(width * nbChannels);
+
+  for(int y = 0; y < height; ++y)
+  {
+    std::fill(rowSum.begin(), rowSum.end(), 0);
+    for(int dy = 0; dy < factor; ++dy)
+    {
+      const unsigned char* inRow = reinterpret_cast<const unsigned char*>(in.data() + (y * factor + dy) * in.Width());
+      for(int x = 0; x < width; ++x)
+      {
+        for(int i = 0; i < factor * nbChannels; ++i)
+          rowSum[x * nbChannels + i % nbChannels] += inRow[x * factor * nbChannels + i];
+      }
+    }
+    unsigned char* outRow = reinterpret_cast<unsigned char*>(out.data() + y * width);
+    for(int i = 0; i < width * nbChannels; ++i)
+      outRow[i] = static_cast<unsigned char>((rowSum[i] + area / 2) / area);
+  }
+}
+
+/**
+ * @brief Rescale the intrinsics of a downscaled image.
+ * The output pixel x is the mean of the input pixels factor * x to factor * x + factor - 1.
+ */
+void downscaleIntrinsics(camera::PinholeRadialK3 &intrinsics, int factor)
+{
+  const Vec2 principalPoint = intrinsics.principal_point();
+  const double offset = 0.5 * (factor - 1);
+  intrinsics.setK(intrinsics.focal() / factor,
+                  (principalPoint(0) - offset) / factor,
+                  (principalPoint(1) - offset) / factor);
+  intrinsics.setWidth(intrinsics.w() / factor);
+  intrinsics.setHeight(intrinsics.h() / factor);
+}
+
+void copyFrameImage(const image::Image<image::RGBColor> &imageRGB,
+                    const image::Image<unsigned char> &imageGray,
+                    bool grayscale,
+                    image::Image<image::RGBColor> &out)
+{
+  if(grayscale)
+    image::ConvertPixelType(imageGray, &out);
+  else
+    out = imageRGB;
+}
+
+void copyFrameImage(const image::Image<image::RGBColor> &imageRGB,
+                    const image::Image<unsigned char> &imageGray,
+                    bool grayscale,
+                    image::Image<unsigned char> &out)
+{
+  if(grayscale)
+    out = imageGray;
+  else
+    image::ConvertPixelType(imageRGB, &out);
+}
+
+} // namespace
+
+PrefetchFeed::PrefetchFeed(std::vector<std::unique_ptr<IFeed>> feeds, const PrefetchOptions& options)
+  : _options(options)
+  , _feeds(std::move(feeds))
+  , _endFrame(std::numeric_limits<std::size_t>::max())
+{
+  if(_feeds.empty())
+    throw std::invalid_argument("PrefetchFeed: no feed to decode");
+  if(_options.downscale < 1)
+    throw std::invalid_argument("PrefetchFeed: invalid downscale factor " + std::to_string(_options.downscale));
+
+  _isInit = std::all_of(_feeds.begin(), _feeds.end(), [](const std::unique_ptr<IFeed>& feed) { return feed->isInit(); });
+  _nbFrames = _feeds.front()->nbFrames();
+  _slots.resize(std::max<std::size_t>(1, _options.queueSize));
+
+  if(!_isInit)
+  {
+    _endFrame = 0;
+    return;
+  }
+
+  for(std::size_t i = 0; i < _feeds.size(); ++i)
+    _workers.emplace_back(&PrefetchFeed::decodingWorker, this, i);
+}
+
+PrefetchFeed::~PrefetchFeed()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _decodeCondition.notify_all();
+  for(std::thread& worker : _workers)
+    worker.join();
+}
+
+void PrefetchFeed::decodingWorker(std::size_t workerIndex)
+{
+  IFeed& feed = *_feeds.at(workerIndex);
+  // all the feeds start at the first frame
+  std::size_t feedPosition = 0;
+  // buffers owned by the worker, swapped with the slots buffers
+  Frame decoded;
+  Frame out;
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while(true)
+  {
+    _decodeCondition.wait(lock, [this] {
+      return _stop || (_nextFrame < _endFrame && _nextFrame < _currentFrame + _slots.size());
+    });
+    if(_stop)
+      return;
+
+    const std::size_t frameIndex = _nextFrame++;
+    const std::size_t queueGeneration = _queueGeneration;
+    Slot& slot = _slots[frameIndex % _slots.size()];
+    slot.frameIndex = frameIndex;
+    slot.state = Slot::EState::Decoding;
+
+    lock.unlock();
+    decodeFrame(feed, frameIndex, feedPosition, decoded, out);
+    lock.lock();
+
+    // the frame is dropped if the queue has restarted or moved past it
+    if(queueGeneration != _queueGeneration || slot.frameIndex != frameIndex)
+      continue;
+
+    std::swap(slot.frame, out);
+    slot.state = Slot::EState::Done;
+    if(!slot.frame.isValid)
+      _endFrame = std::min(_endFrame, frameIndex + 1);
+    _frameCondition.notify_all();
+  }
+}
+
+void PrefetchFeed::decodeFrame(IFeed& feed, std::size_t frameIndex, std::size_t& feedPosition, Frame& decoded, Frame& out) const
+{
+  out.isValid = false;
+  out.error = nullptr;
+  try
+  {
+    // the feed is read sequentially if possible
+    if(feedPosition != frameIndex && !feed.goToFrame(frameIndex))
+    {
+      feedPosition = invalidFrame;
+      return;
+    }
+    feedPosition = frameIndex;
+
+    Frame& frame = (_options.downscale > 1) ? decoded : out;
+    const bool isValid = _options.grayscale ?
+          feed.readImage(frame.imageGray, frame.intrinsics, frame.mediaPath, frame.hasIntrinsics) :
+          feed.readImage(frame.imageRGB, frame.intrinsics, frame.mediaPath, frame.hasIntrinsics);
+    if(!isValid)
+      return;
+
+    // the next frame is grabbed while the queue is consumed
+    feed.goToNextFrame();
+    feedPosition = frameIndex + 1;
+
+    if(_options.downscale > 1)
+    {
+      if(_options.grayscale)
+        downscaleImage(decoded.imageGray, _options.downscale, out.imageGray);
+      else
+        downscaleImage(decoded.imageRGB, _options.downscale, out.imageRGB);
+
+      out.intrinsics = decoded.intrinsics;
+      out.hasIntrinsics = decoded.hasIntrinsics;
+      out.mediaPath = decoded.mediaPath;
+      if(out.hasIntrinsics)
+        downscaleIntrinsics(out.intrinsics, _options.downscale);
+    }
+    out.isValid = true;
+  }
+  catch(...)
+  {
+    out.error = std::current_exception();
+    feedPosition = invalidFrame;
+  }
+}
+
+PrefetchFeed::Slot* PrefetchFeed::waitCurrentFrame()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  Slot& slot = _slots[_currentFrame % _slots.size()];
+  _frameCondition.wait(lock, [&] {
+    return _currentFrame >= _endFrame || (slot.frameIndex == _currentFrame && slot.state == Slot::EState::Done);
+  });
+  if(slot.frameIndex != _currentFrame || slot.state != Slot::EState::Done)
+    return nullptr;
+  // the slot of the current frame is not modified by the workers until the next frame
+  return &slot;
+}
+
+void PrefetchFeed::restartQueue(std::size_t frameIndex)
+{
+  ++_queueGeneration;
+  _currentFrame = frameIndex;
+  _nextFrame = frameIndex;
+  _endFrame = _isInit ? std::numeric_limits<std::size_t>::max() : 0;
+  for(Slot& slot : _slots)
+    slot.state = Slot::EState::Empty;
+}
+
+template<typename T>
+bool PrefetchFeed::readFrame(image::Image<T> &image,
+                             camera::PinholeRadialK3 &camIntrinsics,
+                             std::string &mediaPath,
+                             bool &hasIntrinsics)
+{
+  const Slot* slot = waitCurrentFrame();
+  if(slot == nullptr)
+    return false;
+
+  const Frame& frame = slot->frame;
+  if(frame.error)
+    std::rethrow_exception(frame.error);
+  if(!frame.isValid)
+    return false;
+
+  copyFrameImage(frame.imageRGB, frame.imageGray, _options.grayscale, image);
+  hasIntrinsics = frame.hasIntrinsics;
+  if(hasIntrinsics)
+    camIntrinsics = frame.intrinsics;
+  mediaPath = frame.mediaPath;
+  return true;
+}
+
+bool PrefetchFeed::readImage(image::Image<image::RGBColor> &imageRGB,
+                             camera::PinholeRadialK3 &camIntrinsics,
+                             std::string &mediaPath,
+                             bool &hasIntrinsics)
+{
+  return readFrame(imageRGB, camIntrinsics, mediaPath, hasIntrinsics);
+}
+
+bool PrefetchFeed::readImage(image::Image<unsigned char> &imageGray,
+                             camera::PinholeRadialK3 &camIntrinsics,
+                             std::string &mediaPath,
+                             bool &hasIntrinsics)
+{
+  return readFrame(imageGray, camIntrinsics, mediaPath, hasIntrinsics);
+}
+
+std::size_t PrefetchFeed::nbFrames() const
+{
+  return _nbFrames;
+}
+
+bool PrefetchFeed::goToFrame(const unsigned int frame)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(frame < _currentFrame || frame >= _currentFrame + _slots.size() || frame >= _endFrame)
+    {
+      restartQueue(frame);
+    }
+    else
+    {
+      // the frames already decoded in the queue are kept
+      _currentFrame = frame;
+      _nextFrame = std::max(_nextFrame, _currentFrame);
+    }
+  }
+  _decodeCondition.notify_all();
+
+  const Slot* slot = waitCurrentFrame();
+  return slot != nullptr && slot->frame.isValid;
+}
+
+bool PrefetchFeed::goToNextFrame()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_currentFrame;
+    _nextFrame = std::max(_nextFrame, _currentFrame);
+  }
+  _decodeCondition.notify_all();
+
+  const Slot* slot = waitCurrentFrame();
+  return slot != nullptr && slot->frame.isValid;
+}
+
+bool PrefetchFeed::isInit() const
+{
+  return _isInit;
+}
+
+}//namespace dataio
+}//namespace aliceVision
@@ -0,0 +1,154 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "IFeed.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aliceVision{
+namespace dataio{
+
+/**
+ * @brief Options of the frames prefetching.
+ */
+struct PrefetchOptions
+{
+  /// number of decoding threads
+  std::size_t nbThreads = 2;
+  /// maximum number of frames decoded ahead, the current frame included
+  std::size_t queueSize = 4;
+  /// decode the frames in grayscale
+  bool grayscale = false;
+  /// downscale factor of the frames, each output pixel is the mean of factor x factor pixels
+  int downscale = 1;
+};
+
+/**
+ * @brief Feed decoding the next frames in background threads.
+ *
+ * Each decoding thread owns one of the wrapped feeds, which must read the same media.
+ * The frames following the current one are decoded in a bounded queue and delivered in order.
+ * The frame buffers are recycled: a decoded frame is swapped with the buffer of the queue slot.
+ * The frames are converted to grayscale and downscaled by the decoding threads,
+ * the intrinsics are rescaled accordingly.
+ */
+class PrefetchFeed : public IFeed
+{
+public:
+  /**
+   * @param[in] feeds The feeds of the decoding threads, on the same media and at the first frame.
+   * A single feed reads the frames sequentially, which suits the videos and the live feeds.
+   * @param[in] options The prefetching options.
+   */
+  PrefetchFeed(std::vector<std::unique_ptr<IFeed>> feeds, const PrefetchOptions& options);
+
+  /**
+   * @brief Provide the current RGB frame, waiting for its decoding if needed.
+   * @see IFeed::readImage
+   */
+  bool readImage(image::Image<image::RGBColor> &imageRGB,
+            camera::PinholeRadialK3 &camIntrinsics,
+            std::string &mediaPath,
+            bool &hasIntrinsics);
+
+  /**
+   * @brief Provide the current grayscale frame, waiting for its decoding if needed.
+   * @see IFeed::readImage
+   */
+  bool readImage(image::Image<unsigned char> &imageGray,
+            camera::PinholeRadialK3 &camIntrinsics,
+            std::string &mediaPath,
+            bool &hasIntrinsics);
+
+  std::size_t nbFrames() const;
+
+  /**
+   * @brief Go to a frame. The decoded frames are kept if it is in the queue,
+   * otherwise the queue restarts from this frame.
+   * @return true if the frame is available, waiting for its decoding if needed.
+   */
+  bool goToFrame(const unsigned int frame);
+
+  bool goToNextFrame();
+
+  bool isInit() const;
+
+  virtual ~PrefetchFeed();
+
+private:
+  /// Decoded frame
+  struct Frame
+  {
+    image::Image<image::RGBColor> imageRGB;
+    image::Image<unsigned char> imageGray;
+    camera::PinholeRadialK3 intrinsics;
+    bool hasIntrinsics = false;
+    std::string mediaPath;
+    bool isValid = false;
+    std::exception_ptr error;
+  };
+
+  /// Queue slot of the frames whose index modulo the queue size is the slot index
+  struct Slot
+  {
+    enum class EState { Empty, Decoding, Done };
+
+    std::size_t frameIndex = 0;
+    EState state = EState::Empty;
+    Frame frame;
+  };
+
+  void decodingWorker(std::size_t workerIndex);
+
+  /// Decode a frame with the feed of a worker, the feed position is updated
+  void decodeFrame(IFeed& feed, std::size_t frameIndex, std::size_t& feedPosition, Frame& decoded, Frame& out) const;
+
+  /// Wait for the decoding of the current frame, return its slot or nullptr if it is after the end of the feed
+  Slot* waitCurrentFrame();
+
+  /// Restart the queue from a frame, under the lock
+  void restartQueue(std::size_t frameIndex);
+
+  template<typename T>
+  bool readFrame(image::Image<T> &image,
+                 camera::PinholeRadialK3 &camIntrinsics,
+                 std::string &mediaPath,
+                 bool &hasIntrinsics);
+
+  const PrefetchOptions _options;
+  std::vector<std::unique_ptr<IFeed>> _feeds;
+  bool _isInit;
+  std::size_t _nbFrames;
+
+  std::vector<Slot> _slots;
+  /// frame delivered by readImage
+  std::size_t _currentFrame = 0;
+  /// next frame to decode
+  std::size_t _nextFrame = 0;
+  /// first frame known to be unavailable
+  std::size_t _endFrame;
+  /// incremented when the queue restarts, the frames decoded for a previous queue are dropped
+  std::size_t _queueGeneration = 0;
+  bool _stop = false;
+
+  std::mutex _mutex;
+  /// notified when frames can be decoded
+  std::condition_variable _decodeCondition;
+  /// notified when a frame is decoded
+  std::condition_variable _frameCondition;
+  std::vector<std::thread> _workers;
+};
+
+}//namespace dataio
+}//namespace aliceVision
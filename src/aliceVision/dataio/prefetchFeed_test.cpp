@@ -0,0 +1,353 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/dataio/PrefetchFeed.hpp>
+#include <aliceVision/image/convertion.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE prefetchFeed
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::dataio;
+
+namespace {
+
+const int frameWidth = 37;
+const int frameHeight = 23;
+
+/**
+ * @brief Sequential feed of synthetic frames, with an optional frame which is not available
+ * and an optional frame whose decoding throws.
+ */
+class FakeFeed : public IFeed
+{
+public:
+  FakeFeed(std::size_t nbFrames, int invalidFrame = -1, int failingFrame = -1)
+    : _nbFrames(nbFrames)
+    , _invalidFrame(invalidFrame)
+    , _failingFrame(failingFrame)
+  {}
+
+  bool isInit() const { return true; }
+
+  bool readImage(image::Image<image::RGBColor> &imageRGB,
+                 camera::PinholeRadialK3 &camIntrinsics,
+                 std::string &mediaPath,
+                 bool &hasIntrinsics)
+  {
+    return readFrame(imageRGB, camIntrinsics, mediaPath, hasIntrinsics);
+  }
+
+  bool readImage(image::Image<unsigned char> &imageGray,
+                 camera::PinholeRadialK3 &camIntrinsics,
+                 std::string &mediaPath,
+                 bool &hasIntrinsics)
+  {
+    return readFrame(imageGray, camIntrinsics, mediaPath, hasIntrinsics);
+  }
+
+  std::size_t nbFrames() const { return _nbFrames; }
+
+  bool goToFrame(const unsigned int frame)
+  {
+    _position = frame;
+    return _position < _nbFrames;
+  }
+
+  bool goToNextFrame()
+  {
+    ++_position;
+    return _position < _nbFrames;
+  }
+
+private:
+  template<typename T>
+  bool readFrame(image::Image<T> &image,
+                 camera::PinholeRadialK3 &camIntrinsics,
+                 std::string &mediaPath,
+                 bool &hasIntrinsics)
+  {
+    if(_position >= _nbFrames || static_cast<int>(_position) == _invalidFrame)
+      return false;
+    if(static_cast<int>(_position) == _failingFrame)
+      throw std::runtime_error("FakeFeed: cannot decode frame " + std::to_string(_position));
+
+    image::Image<image::RGBColor> imageRGB(frameWidth, frameHeight);
+    for(int y = 0; y < frameHeight; ++y)
+      for(int x = 0; x < frameWidth; ++x)
+        imageRGB(y, x) = image::RGBColor((x * 7 + _position) % 256, (y * 5 + _position) % 256, (x + y + _position * 3) % 256);
+    image::ConvertPixelType(imageRGB, &image);
+
+    camIntrinsics = camera::PinholeRadialK3(frameWidth, frameHeight, 100.0, 18.0, 11.0, 0.1, 0.0, 0.0);
+    hasIntrinsics = true;
+    mediaPath = std::to_string(_position);
+    return true;
+  }
+
+  std::size_t _nbFrames;
+  int _invalidFrame;
+  int _failingFrame;
+  std::size_t _position = 0;
+};
+
+std::unique_ptr<PrefetchFeed> createPrefetchFeed(std::size_t nbFrames, const PrefetchOptions& options,
+                                                 int invalidFrame = -1, int failingFrame = -1)
+{
+  std::vector<std::unique_ptr<IFeed>> feeds;
+  for(std::size_t i = 0; i < options.nbThreads; ++i)
+    feeds.emplace_back(new FakeFeed(nbFrames, invalidFrame, failingFrame));
+  return std::unique_ptr<PrefetchFeed>(new PrefetchFeed(std::move(feeds), options));
+}
+
+/// Each pixel of the expected downscaled image is the rounded mean of factor x factor pixels
+template<typename T>
+image::Image<T> downscale(const image::Image<T> &in, int factor)
+{
+  const int nbChannels = sizeof(T);
+  image::Image<T> out(in.Width() / factor, in.Height() / factor);
+  for(int y = 0; y < out.Height(); ++y)
+  {
+    for(int x = 0; x < out.Width(); ++x)
+    {
+      for(int c = 0; c < nbChannels; ++c)
+      {
+        int sum = 0;
+        for(int dy = 0; dy < factor; ++dy)
+          for(int dx = 0; dx < factor; ++dx)
+            sum += reinterpret_cast<const unsigned char*>(&in(y * factor + dy, x * factor + dx))[c];
+        reinterpret_cast<unsigned char*>(&out(y, x))[c] = static_cast<unsigned char>((sum + factor * factor / 2) / (factor * factor));
+      }
+    }
+  }
+  return out;
+}
+
+/// Check that the current frame of the feed is the frame @p frameIndex of a FakeFeed
+template<typename T>
+void checkFrame(PrefetchFeed &feed, std::size_t frameIndex, const PrefetchOptions& options)
+{
+  // the frames are decoded in the type of the options, then converted to the read type
+  FakeFeed reference(frameIndex + 1);
+  reference.goToFrame(frameIndex);
+  image::Image<T> expected;
+  camera::PinholeRadialK3 intrinsics;
+  std::string mediaPath;
+  bool hasIntrinsics = false;
+  if(options.grayscale)
+  {
+    image::Image<unsigned char> imageGray;
+    BOOST_REQUIRE(reference.readImage(imageGray, intrinsics, mediaPath, hasIntrinsics));
+    if(options.downscale > 1)
+      imageGray = downscale(imageGray, options.downscale);
+    image::ConvertPixelType(imageGray, &expected);
+  }
+  else
+  {
+    image::Image<image::RGBColor> imageRGB;
+    BOOST_REQUIRE(reference.readImage(imageRGB, intrinsics, mediaPath, hasIntrinsics));
+    if(options.downscale > 1)
+      imageRGB = downscale(imageRGB, options.downscale);
+    image::ConvertPixelType(imageRGB, &expected);
+  }
+
+  image::Image<T> image;
+  camera::PinholeRadialK3 camIntrinsics;
+  hasIntrinsics = false;
+  BOOST_REQUIRE(feed.readImage(image, camIntrinsics, mediaPath, hasIntrinsics));
+  BOOST_CHECK_EQUAL(mediaPath, std::to_string(frameIndex));
+  BOOST_CHECK(hasIntrinsics);
+  BOOST_REQUIRE_EQUAL(image.Width(), frameWidth / options.downscale);
+  BOOST_REQUIRE_EQUAL(image.Height(), frameHeight / options.downscale);
+  BOOST_CHECK(image == expected);
+  BOOST_CHECK_EQUAL(camIntrinsics.w(), frameWidth / options.downscale);
+  BOOST_CHECK_EQUAL(camIntrinsics.h(), frameHeight / options.downscale);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(PrefetchFeed_inOrder)
+{
+  const std::size_t nbFrames = 30;
+  for(const std::size_t nbThreads : {1, 3})
+  {
+    for(const std::size_t queueSize : {1, 4})
+    {
+      for(const bool grayscale : {false, true})
+      {
+        PrefetchOptions options;
+        options.nbThreads = nbThreads;
+        options.queueSize = queueSize;
+        options.grayscale = grayscale;
+        std::unique_ptr<PrefetchFeed> feed = createPrefetchFeed(nbFrames, options);
+        BOOST_CHECK(feed->isInit());
+        BOOST_CHECK_EQUAL(feed->nbFrames(), nbFrames);
+
+        for(std::size_t i = 0; i < nbFrames; ++i)
+        {
+          if(i % 2 == 0)
+            checkFrame<image::RGBColor>(*feed, i, options);
+          else
+            checkFrame<unsigned char>(*feed, i, options);
+          BOOST_CHECK_EQUAL(feed->goToNextFrame(), i + 1 < nbFrames);
+        }
+
+        // end of the stream
+        image::Image<unsigned char> image;
+        camera::PinholeRadialK3 intrinsics;
+        std::string mediaPath;
+        bool hasIntrinsics = false;
+        BOOST_CHECK(!feed->readImage(image, intrinsics, mediaPath, hasIntrinsics));
+        BOOST_CHECK(!feed->goToNextFrame());
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PrefetchFeed_goToFrame)
+{
+  const std::size_t nbFrames = 30;
+  for(const std::size_t nbThreads : {1, 3})
+  {
+    PrefetchOptions options;
+    options.nbThreads = nbThreads;
+    options.queueSize = 4;
+    std::unique_ptr<PrefetchFeed> feed = createPrefetchFeed(nbFrames, options);
+
+    for(std::size_t i = 0; i < 10; ++i)
+    {
+      checkFrame<image::RGBColor>(*feed, i, options);
+      feed->goToNextFrame();
+    }
+
+    // backward: the queue restarts from the frame
+    BOOST_CHECK(feed->goToFrame(2));
+    for(std::size_t i = 2; i < 6; ++i)
+    {
+      checkFrame<image::RGBColor>(*feed, i, options);
+      feed->goToNextFrame();
+    }
+
+    // forward inside the queue, then after the queue
+    BOOST_CHECK(feed->goToFrame(8));
+    checkFrame<image::RGBColor>(*feed, 8, options);
+    BOOST_CHECK(feed->goToFrame(20));
+    checkFrame<image::RGBColor>(*feed, 20, options);
+
+    // the last frame, then after the end and back
+    BOOST_CHECK(feed->goToFrame(nbFrames - 1));
+    checkFrame<image::RGBColor>(*feed, nbFrames - 1, options);
+    BOOST_CHECK(!feed->goToFrame(nbFrames + 5));
+    BOOST_CHECK(feed->goToFrame(0));
+    checkFrame<unsigned char>(*feed, 0, options);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PrefetchFeed_invalidFrame)
+{
+  const std::size_t nbFrames = 20;
+  const int invalidFrame = 5;
+  for(const std::size_t nbThreads : {1, 3})
+  {
+    PrefetchOptions options;
+    options.nbThreads = nbThreads;
+    std::unique_ptr<PrefetchFeed> feed = createPrefetchFeed(nbFrames, options, invalidFrame);
+
+    for(int i = 0; i < invalidFrame; ++i)
+    {
+      checkFrame<image::RGBColor>(*feed, i, options);
+      BOOST_CHECK_EQUAL(feed->goToNextFrame(), i + 1 < invalidFrame);
+    }
+
+    // the unavailable frame ends the stream
+    image::Image<image::RGBColor> image;
+    camera::PinholeRadialK3 intrinsics;
+    std::string mediaPath;
+    bool hasIntrinsics = false;
+    BOOST_CHECK(!feed->readImage(image, intrinsics, mediaPath, hasIntrinsics));
+    BOOST_CHECK(!feed->goToNextFrame());
+
+    // the following frames are still available
+    BOOST_CHECK(feed->goToFrame(invalidFrame + 1));
+    checkFrame<image::RGBColor>(*feed, invalidFrame + 1, options);
+    BOOST_CHECK(feed->goToNextFrame());
+    checkFrame<image::RGBColor>(*feed, invalidFrame + 2, options);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PrefetchFeed_decodingError)
+{
+  const std::size_t nbFrames = 20;
+  const int failingFrame = 7;
+  for(const std::size_t nbThreads : {1, 3})
+  {
+    PrefetchOptions options;
+    options.nbThreads = nbThreads;
+    std::unique_ptr<PrefetchFeed> feed = createPrefetchFeed(nbFrames, options, -1, failingFrame);
+
+    for(int i = 0; i < failingFrame; ++i)
+    {
+      checkFrame<image::RGBColor>(*feed, i, options);
+      feed->goToNextFrame();
+    }
+
+    // the exception of the decoding thread is rethrown by the read of the frame
+    image::Image<image::RGBColor> image;
+    camera::PinholeRadialK3 intrinsics;
+    std::string mediaPath;
+    bool hasIntrinsics = false;
+    BOOST_CHECK_THROW(feed->readImage(image, intrinsics, mediaPath, hasIntrinsics), std::runtime_error);
+    BOOST_CHECK(!feed->goToNextFrame());
+
+    BOOST_CHECK(feed->goToFrame(failingFrame + 2));
+    checkFrame<image::RGBColor>(*feed, failingFrame + 2, options);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PrefetchFeed_downscale)
+{
+  const std::size_t nbFrames = 10;
+  for(const int factor : {2, 3})
+  {
+    for(const bool grayscale : {false, true})
+    {
+      PrefetchOptions options;
+      options.nbThreads = 2;
+      options.grayscale = grayscale;
+      options.downscale = factor;
+      std::unique_ptr<PrefetchFeed> feed = createPrefetchFeed(nbFrames, options);
+
+      for(std::size_t i = 0; i < nbFrames; ++i)
+      {
+        checkFrame<image::RGBColor>(*feed, i, options);
+        checkFrame<unsigned char>(*feed, i, options);
+
+        // the output pixel x is the mean of the input pixels factor * x to factor * x + factor - 1
+        image::Image<unsigned char> image;
+        camera::PinholeRadialK3 intrinsics;
+        std::string mediaPath;
+        bool hasIntrinsics = false;
+        BOOST_REQUIRE(feed->readImage(image, intrinsics, mediaPath, hasIntrinsics));
+        const double offset = 0.5 * (factor - 1);
+        BOOST_CHECK_CLOSE(intrinsics.focal(), 100.0 / factor, 1e-9);
+        BOOST_CHECK_CLOSE(intrinsics.principal_point()(0), (18.0 - offset) / factor, 1e-9);
+        BOOST_CHECK_CLOSE(intrinsics.principal_point()(1), (11.0 - offset) / factor, 1e-9);
+        BOOST_CHECK_EQUAL(intrinsics.getDistortionParams().at(0), 0.1);
+
+        feed->goToNextFrame();
+      }
+    }
+  }
+
+  PrefetchOptions options;
+  options.downscale = 0;
+  BOOST_CHECK_THROW(createPrefetchFeed(nbFrames, options), std::invalid_argument);
+}
@@ -0,0 +1,112 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Color.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsData/Point2d.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/Point4d.hpp>
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/PreMatchCams.hpp>
+#include <aliceVision/depthMap/DepthSimMap.hpp>
+
+#include <memory>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Plane sweeping backend.
+ *
+ * Common interface of the plane sweeping implementations used by the depth map estimation
+ * (SemiGlobalMatching and Refine steps). The depth range computation is shared by all the
+ * backends, the similarity volume, SGM and refine/fuse steps are backend specific.
+ */
+class PlaneSweeping
+{
+public:
+    int scales;
+
+    mvsUtils::MultiViewParams* mp;
+    mvsUtils::PreMatchCams* pc;
+    mvsUtils::ImagesCache* ic;
+
+    bool verbose;
+
+    PlaneSweeping(mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc, int _scales);
+    virtual ~PlaneSweeping() = default;
+
+    void getMinMaxdepths(int rc, StaticVector<int>* tcams, float& minDepth, float& midDepth, float& maxDepth);
+    StaticVector<float>* getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth, int scale,
+                                              int step, int maxDepthsHalf = 1024);
+    StaticVector<float>* getDepthsRcTc(int rc, int tc, int scale, float midDepth, int maxDepthsHalf = 1024);
+
+    /**
+     * @brief Compute the similarity volume of the rc camera against the first camera of tcams.
+     * @return the size of the volume in MB in the backend memory
+     */
+    virtual float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX,
+                                      int volDimY, int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
+                                      StaticVector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
+                                      StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
+                                      float epipShift) = 0;
+
+    /**
+     * @param[inout] volume input similarity volume (after Z reduction)
+     * @param[in] P1 SGM penalty of the depth changes of one step
+     * @param[in] P2 SGM penalty of the larger depth changes
+     */
+    virtual bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                                      int volDimZ, int volStepXY, int volLUX, int volLUY, int scale,
+                                      unsigned char P1, unsigned char P2) = 0;
+
+    virtual bool refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                                    StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
+                                    float gammaP, float epipShift, int xFrom, int wPart) = 0;
+
+    virtual bool smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float igammaP,
+                                int wsh) = 0;
+    virtual bool filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float minCostThr,
+                                int wsh) = 0;
+
+    virtual bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                                      const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                                      int nSamplesHalf, int nDepthsToRefine, float sigma) = 0;
+    virtual bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                                    StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc, int nIters,
+                                                    int yFrom, int hPart) = 0;
+
+    virtual bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc) = 0;
+
+    /**
+     * @brief Memory available for the volumes of the backend.
+     * @return (available, total, used) in MB
+     */
+    virtual Point3d getDeviceMemoryInfo() = 0;
+};
+
+/**
+ * @brief Create the plane sweeping backend.
+ * @param[in] CUDADeviceNo the CUDA device to use, a negative value selects the CPU backend
+ */
+std::unique_ptr<PlaneSweeping> createPlaneSweeping(int CUDADeviceNo, mvsUtils::ImagesCache* ic,
+                                                   mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc,
+                                                   int scales);
+
+/**
+ * @brief Number of CUDA devices usable by the plane sweeping, 0 if the CPU backend has to be used.
+ */
+int getNbPlaneSweepingCUDADevices(const mvsUtils::MultiViewParams* mp);
+
+} // namespace depthMap
+} // namespace aliceVision
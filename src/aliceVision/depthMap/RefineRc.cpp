@@ -218,8 +218,8 @@ DepthSimMap* RefineRc::optimizeDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis,
         {
             int yFrom = part * hPart;
             int hPartAct = std::min(hPart, h11 - yFrom);
-            sp->cps->optimizeDepthSimMapGradientDescent(depthSimMapOptimized->dsm, dataMapsPtrs, rc, _nSamplesHalf,
-                                                        _ndepthsToRefine, _sigma, _niters, yFrom, hPartAct);
+            sp->cps->optimizeDepthSimMapGradientDescent(depthSimMapOptimized->dsm, dataMapsPtrs, rc, _niters, yFrom,
+                                                        hPartAct);
         }
 
         for(int i = 0; i < dataMaps->size(); i++)
@@ -323,8 +323,8 @@ void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::
 
     int bandType = 0;
     mvsUtils::ImagesCache* ic = new mvsUtils::ImagesCache(mp, bandType, true);
-    PlaneSweepingCuda* cps = new PlaneSweepingCuda(CUDADeviceNo, ic, mp, pc, sgmScale);
-    SemiGlobalMatchingParams* sp = new SemiGlobalMatchingParams(mp, pc, cps);
+    std::unique_ptr<PlaneSweeping> cps = createPlaneSweeping(CUDADeviceNo, ic, mp, pc, sgmScale);
+    SemiGlobalMatchingParams* sp = new SemiGlobalMatchingParams(mp, pc, cps.get());
 
     //////////////////////////////////////////////////////////////////////////////////////////
 
@@ -340,14 +340,23 @@ void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::
 
     delete sp;
     delete ic;
-    delete cps;
+    cps.reset();
 }
 
 void refineDepthMaps(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
 {
-    int num_gpus = listCUDADevices(true);
+    int num_gpus = getNbPlaneSweepingCUDADevices(mp);
     int num_cpu_threads = omp_get_num_procs();
     ALICEVISION_LOG_INFO("Number of GPU devices: " << num_gpus << ", number of CPU threads: " << num_cpu_threads);
+
+    if(num_gpus == 0)
+    {
+        // the CPU backend is parallelized internally
+        ALICEVISION_LOG_INFO("No CUDA device available, use the CPU plane sweeping.");
+        refineDepthMaps(-1, mp, pc, cams);
+        return;
+    }
+
     int numthreads = std::min(num_gpus, num_cpu_threads);
 
     int num_gpus_to_use = mp->_ini.get<int>("refineRc.num_gpus_to_use", 1);
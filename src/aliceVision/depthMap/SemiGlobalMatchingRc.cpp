@@ -711,10 +711,10 @@ void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsU
     
     // load images from files into RAM 
     mvsUtils::ImagesCache ic(mp, bandType, true);
-    // load stuff on GPU memory and creates multi-level images and computes gradients
-    PlaneSweepingCuda cps(CUDADeviceNo, &ic, mp, pc, sgmScale);
+    // load stuff on GPU (or CPU) memory and creates multi-level images and computes gradients
+    std::unique_ptr<PlaneSweeping> cps = createPlaneSweeping(CUDADeviceNo, &ic, mp, pc, sgmScale);
     // init plane sweeping parameters
-    SemiGlobalMatchingParams sp(mp, pc, &cps);
+    SemiGlobalMatchingParams sp(mp, pc, cps.get());
 
     //////////////////////////////////////////////////////////////////////////////////////////
 
@@ -736,9 +736,18 @@ void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsU
 
 void computeDepthMapsPSSGM(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
 {
-    int num_gpus = listCUDADevices(true);
+    int num_gpus = getNbPlaneSweepingCUDADevices(mp);
     int num_cpu_threads = omp_get_num_procs();
     ALICEVISION_LOG_INFO("Number of GPU devices: " << num_gpus << ", number of CPU threads: " << num_cpu_threads);
+
+    if(num_gpus == 0)
+    {
+        // the CPU backend is parallelized internally
+        ALICEVISION_LOG_INFO("No CUDA device available, use the CPU plane sweeping.");
+        computeDepthMapsPSSGM(-1, mp, pc, cams);
+        return;
+    }
+
     int numthreads = std::min(num_gpus, num_cpu_threads);
 
     int num_gpus_to_use = mp->_ini.get<int>("semiGlobalMatching.num_gpus_to_use", 1);
@@ -0,0 +1,1230 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PlaneSweepingCpu.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+struct Vec2f
+{
+    float x, y;
+
+    Vec2f() = default;
+    Vec2f(float _x, float _y) : x(_x), y(_y) {}
+};
+
+struct Vec3f
+{
+    float x, y, z;
+
+    Vec3f() = default;
+    Vec3f(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+    explicit Vec3f(const Point3d& p) : x(float(p.x)), y(float(p.y)), z(float(p.z)) {}
+};
+
+inline Vec2f operator+(const Vec2f& a, const Vec2f& b) { return Vec2f(a.x + b.x, a.y + b.y); }
+inline Vec2f operator-(const Vec2f& a, const Vec2f& b) { return Vec2f(a.x - b.x, a.y - b.y); }
+inline Vec2f operator*(const Vec2f& a, float d) { return Vec2f(a.x * d, a.y * d); }
+
+inline Vec3f operator+(const Vec3f& a, const Vec3f& b) { return Vec3f(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline Vec3f operator-(const Vec3f& a, const Vec3f& b) { return Vec3f(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline Vec3f operator*(const Vec3f& a, float d) { return Vec3f(a.x * d, a.y * d, a.z * d); }
+inline Vec3f operator/(const Vec3f& a, float d) { return Vec3f(a.x / d, a.y / d, a.z / d); }
+
+inline float dot(const Vec3f& a, const Vec3f& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline float size(const Vec3f& a) { return std::sqrt(dot(a, a)); }
+inline float size(const Vec2f& a) { return std::sqrt(a.x * a.x + a.y * a.y); }
+
+inline Vec3f cross(const Vec3f& a, const Vec3f& b)
+{
+    return Vec3f(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline Vec3f normalize(const Vec3f& a) { return a / size(a); }
+
+inline Vec2f normalize(const Vec2f& a)
+{
+    const float d = size(a);
+    return Vec2f(a.x / d, a.y / d);
+}
+
+inline float sigmoid(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((xval - sigMid) / sigwidth))));
+}
+
+inline float sigmoid2(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((sigMid - xval) / sigwidth))));
+}
+
+/**
+ * @brief Camera matrices at a given scale (row-major).
+ */
+struct CameraParams
+{
+    float P[12];
+    float iP[9];
+    Vec3f C;
+    Vec3f zVect;
+};
+
+CameraParams getCameraParams(const mvsUtils::MultiViewParams* mp, int c, int scale)
+{
+    Matrix3x3 scaleM;
+    scaleM.m11 = 1.0 / (double)scale;
+    scaleM.m12 = 0.0;
+    scaleM.m13 = 0.0;
+    scaleM.m21 = 0.0;
+    scaleM.m22 = 1.0 / (double)scale;
+    scaleM.m23 = 0.0;
+    scaleM.m31 = 0.0;
+    scaleM.m32 = 0.0;
+    scaleM.m33 = 1.0;
+    const Matrix3x3 K = scaleM * mp->KArr[c];
+    const Matrix3x3 iK = K.inverse();
+    const Matrix3x4 P = K * (mp->RArr[c] | (Point3d(0.0, 0.0, 0.0) - mp->RArr[c] * mp->CArr[c]));
+    const Matrix3x3 iP = mp->iRArr[c] * iK;
+
+    CameraParams cam;
+    const double Pm[12] = {P.m11, P.m12, P.m13, P.m14, P.m21, P.m22, P.m23, P.m24, P.m31, P.m32, P.m33, P.m34};
+    const double iPm[9] = {iP.m11, iP.m12, iP.m13, iP.m21, iP.m22, iP.m23, iP.m31, iP.m32, iP.m33};
+    for(int i = 0; i < 12; ++i)
+        cam.P[i] = float(Pm[i]);
+    for(int i = 0; i < 9; ++i)
+        cam.iP[i] = float(iPm[i]);
+    cam.C = Vec3f(mp->CArr[c]);
+    cam.zVect = normalize(Vec3f(mp->iRArr[c] * Point3d(0.0, 0.0, 1.0)));
+    return cam;
+}
+
+inline Vec3f mulP(const float* P, const Vec3f& X)
+{
+    return Vec3f(P[0] * X.x + P[1] * X.y + P[2] * X.z + P[3],
+                 P[4] * X.x + P[5] * X.y + P[6] * X.z + P[7],
+                 P[8] * X.x + P[9] * X.y + P[10] * X.z + P[11]);
+}
+
+/// linear part of the projection (used to project directions)
+inline Vec3f mulP3x3(const float* P, const Vec3f& V)
+{
+    return Vec3f(P[0] * V.x + P[1] * V.y + P[2] * V.z,
+                 P[4] * V.x + P[5] * V.y + P[6] * V.z,
+                 P[8] * V.x + P[9] * V.y + P[10] * V.z);
+}
+
+inline Vec2f project(const CameraParams& cam, const Vec3f& X)
+{
+    const Vec3f p = mulP(cam.P, X);
+    return Vec2f(p.x / p.z, p.y / p.z);
+}
+
+/// same as project but returns (-1,-1) for points behind the camera
+inline Vec2f projectChecked(const CameraParams& cam, const Vec3f& X)
+{
+    const Vec3f p = mulP(cam.P, X);
+    if(p.z < 0.0f)
+        return Vec2f(-1.0f, -1.0f);
+    return Vec2f(p.x / p.z, p.y / p.z);
+}
+
+inline Vec3f pixelRay(const CameraParams& cam, const Vec2f& pix)
+{
+    const float* iP = cam.iP;
+    return normalize(Vec3f(iP[0] * pix.x + iP[1] * pix.y + iP[2],
+                           iP[3] * pix.x + iP[4] * pix.y + iP[5],
+                           iP[6] * pix.x + iP[7] * pix.y + iP[8]));
+}
+
+inline Vec3f get3DPointForPixelAndDepth(const CameraParams& cam, const Vec2f& pix, float depth)
+{
+    return cam.C + pixelRay(cam, pix) * depth;
+}
+
+inline Vec3f get3DPointForPixelAndFrontoParallelPlane(const CameraParams& cam, const Vec2f& pix, float fpPlaneDepth)
+{
+    const Vec3f v = pixelRay(cam, pix);
+    const float k = fpPlaneDepth / dot(v, cam.zVect);
+    return cam.C + v * k;
+}
+
+inline float pointLineDistance3D(const Vec3f& point, const Vec3f& linePoint, const Vec3f& lineVectNormalized)
+{
+    return size(cross(lineVectNormalized, linePoint - point));
+}
+
+inline Vec3f closestPointToLine3D(const Vec3f& point, const Vec3f& linePoint, const Vec3f& lineVectNormalized)
+{
+    return linePoint + lineVectNormalized * dot(lineVectNormalized, point - linePoint);
+}
+
+/// angle in degrees between the vectors AB and AC
+inline float angleBetwABandAC(const Vec3f& A, const Vec3f& B, const Vec3f& C)
+{
+    const Vec3f V1 = normalize(B - A);
+    const Vec3f V2 = normalize(C - A);
+    const float a = std::acos(std::max(-1.0f, std::min(1.0f, dot(V1, V2))));
+    return std::abs(a) * (180.0f / float(M_PI));
+}
+
+/// size of the rc pixel at the 3D point p
+inline float computeRcPixSize(const CameraParams& rcam, const Vec3f& p)
+{
+    const Vec2f rp = project(rcam, p);
+    const Vec3f refvect = pixelRay(rcam, rp + Vec2f(1.0f, 0.0f));
+    return pointLineDistance3D(p, rcam.C, refvect);
+}
+
+/// closest point of the ray from the rc pixel to the ray from the tc pixel
+inline Vec3f triangulateMatchRef(const CameraParams& rcam, const CameraParams& tcam, const Vec2f& rpix,
+                                 const Vec2f& tpix)
+{
+    const Vec3f u = pixelRay(rcam, rpix);
+    const Vec3f v = pixelRay(tcam, tpix);
+    const Vec3f w0 = rcam.C - tcam.C;
+    const float b = dot(u, v);
+    const float d = dot(u, w0);
+    const float e = dot(v, w0);
+    const float k = (b * e - d) / (1.0f - b * b);
+    return rcam.C + u * k;
+}
+
+void move3DPointByTcPixStep(const CameraParams& rcam, const CameraParams& tcam, Vec3f& p, float tcPixStep)
+{
+    const Vec3f prp1 = p + (rcam.C - p) / 2.0f;
+    const Vec2f rp = projectChecked(rcam, p);
+    const Vec2f tpo = projectChecked(tcam, p);
+    const Vec2f tpv = normalize(projectChecked(tcam, prp1) - tpo);
+    p = triangulateMatchRef(rcam, tcam, rp, tpo + tpv * tcPixStep);
+}
+
+void move3DPointByTcOrRcPixStep(const CameraParams& rcam, const CameraParams& tcam, Vec3f& p, float pixStep,
+                                bool moveByTcOrRc)
+{
+    if(moveByTcOrRc)
+    {
+        move3DPointByTcPixStep(rcam, tcam, p, pixStep);
+    }
+    else
+    {
+        const float pixSize = pixStep * computeRcPixSize(rcam, p);
+        p = p + normalize(p - rcam.C) * pixSize;
+    }
+}
+
+/**
+ * @brief Local coordinate system of a patch: x and n on the epipolar plane, y orthogonal to it.
+ */
+struct Patch
+{
+    Vec3f p;
+    Vec3f n;
+    Vec3f x;
+    Vec3f y;
+    float d;
+};
+
+inline void computeRotCSEpip(Patch& ptch, const Vec3f& p, const Vec3f& rC, const Vec3f& tC)
+{
+    ptch.p = p;
+    const Vec3f v1 = normalize(rC - p);
+    const Vec3f v2 = normalize(tC - p);
+    ptch.y = normalize(cross(v1, v2));
+    ptch.n = normalize((v1 + v2) / 2.0f);
+    ptch.x = normalize(cross(ptch.y, ptch.n));
+}
+
+/**
+ * @brief Bilinear interpolation of the Lab image at the pixel position (x, y) with clamping at the borders.
+ */
+inline void sampleLab(const LabImage& img, float x, float y, float& L, float& a, float& b)
+{
+    const float fx = std::floor(x);
+    const float fy = std::floor(y);
+    const float ax = x - fx;
+    const float ay = y - fy;
+    const int x0 = std::min(std::max(int(fx), 0), img.width - 1);
+    const int y0 = std::min(std::max(int(fy), 0), img.height - 1);
+    const int x1 = std::min(std::max(int(fx) + 1, 0), img.width - 1);
+    const int y1 = std::min(std::max(int(fy) + 1, 0), img.height - 1);
+    const int i00 = y0 * img.width + x0;
+    const int i01 = y0 * img.width + x1;
+    const int i10 = y1 * img.width + x0;
+    const int i11 = y1 * img.width + x1;
+    const float w00 = (1.0f - ax) * (1.0f - ay);
+    const float w01 = ax * (1.0f - ay);
+    const float w10 = (1.0f - ax) * ay;
+    const float w11 = ax * ay;
+    L = w00 * img.L[i00] + w01 * img.L[i01] + w10 * img.L[i10] + w11 * img.L[i11];
+    a = w00 * img.a[i00] + w01 * img.a[i01] + w10 * img.a[i10] + w11 * img.a[i11];
+    b = w00 * img.b[i00] + w01 * img.b[i01] + w10 * img.b[i10] + w11 * img.b[i11];
+}
+
+inline int clampedPixelId(const LabImage& img, int x, int y)
+{
+    x = std::min(std::max(x, 0), img.width - 1);
+    y = std::min(std::max(y, 0), img.height - 1);
+    return y * img.width + x;
+}
+
+inline float labDistance(const LabImage& img, int i0, int i1)
+{
+    const float dL = img.L[i0] - img.L[i1];
+    const float da = img.a[i0] - img.a[i1];
+    const float db = img.b[i0] - img.b[i1];
+    return std::sqrt(dL * dL + da * da + db * db);
+}
+
+/**
+ * @brief Spatial part of the Yoon & Kweon weights of the rc and tc patches: exp(-2 * deltaP / gammaP)
+ */
+std::vector<float> computePatchSpatialWeights(int wsh, float gammaP)
+{
+    std::vector<float> weights;
+    weights.reserve((2 * wsh + 1) * (2 * wsh + 1));
+    for(int yp = -wsh; yp <= wsh; ++yp)
+        for(int xp = -wsh; xp <= wsh; ++xp)
+            weights.push_back(std::exp(-2.0f * std::sqrt(float(xp * xp + yp * yp)) / gammaP));
+    return weights;
+}
+
+/**
+ * @brief Weighted NCC of the L channel between the rc and tc projections of the patch (Yoon & Kweon weights).
+ * @return similarity in range (-1, 1), 1 if the patch is not visible in both images
+ */
+float compNCCby3DptsYK(const Patch& ptch, int wsh, const CameraParams& rcam, const LabImage& rimg,
+                       const CameraParams& tcam, const LabImage& timg, float gammaC,
+                       const std::vector<float>& spatialWeights, float epipShift)
+{
+    const Vec2f rp = project(rcam, ptch.p);
+    Vec2f tp = project(tcam, ptch.p);
+
+    // assuming that ptch.y is ortogonal to epipolar plane
+    const Vec2f tvUp = normalize(project(tcam, ptch.p + ptch.y * (ptch.d * 10.0f)) - tp);
+    const Vec2f vEpipShift = tvUp * epipShift;
+    tp = tp + vEpipShift;
+
+    const float dd = wsh + 2.0f;
+    if((rp.x < dd) || (rp.x > (float)(rimg.width - 1) - dd) || (rp.y < dd) || (rp.y > (float)(rimg.height - 1) - dd) ||
+       (tp.x < dd) || (tp.x > (float)(timg.width - 1) - dd) || (tp.y < dd) || (tp.y > (float)(timg.height - 1) - dd))
+    {
+        return 1.0f;
+    }
+
+    float rL, ra, rb, tL, ta, tb;
+    sampleLab(rimg, rp.x, rp.y, rL, ra, rb);
+    sampleLab(timg, tp.x, tp.y, tL, ta, tb);
+
+    // the patch points are p + x*d*xp + y*d*yp so their homogeneous projections are linear in (xp, yp)
+    const Vec3f rh = mulP(rcam.P, ptch.p);
+    const Vec3f rhx = mulP3x3(rcam.P, ptch.x * ptch.d);
+    const Vec3f rhy = mulP3x3(rcam.P, ptch.y * ptch.d);
+    const Vec3f th = mulP(tcam.P, ptch.p);
+    const Vec3f thx = mulP3x3(tcam.P, ptch.x * ptch.d);
+    const Vec3f thy = mulP3x3(tcam.P, ptch.y * ptch.d);
+
+    float wsum = 0.0f, xsum = 0.0f, ysum = 0.0f, xxsum = 0.0f, yysum = 0.0f, xysum = 0.0f;
+    int k = 0;
+    for(int yp = -wsh; yp <= wsh; ++yp)
+    {
+        for(int xp = -wsh; xp <= wsh; ++xp, ++k)
+        {
+            const Vec3f rh1 = rh + rhx * float(xp) + rhy * float(yp);
+            const Vec3f th1 = th + thx * float(xp) + thy * float(yp);
+
+            float rL1, ra1, rb1, tL1, ta1, tb1;
+            sampleLab(rimg, rh1.x / rh1.z, rh1.y / rh1.z, rL1, ra1, rb1);
+            sampleLab(timg, th1.x / th1.z + vEpipShift.x, th1.y / th1.z + vEpipShift.y, tL1, ta1, tb1);
+
+            const float dCr = std::sqrt((rL - rL1) * (rL - rL1) + (ra - ra1) * (ra - ra1) + (rb - rb1) * (rb - rb1));
+            const float dCt = std::sqrt((tL - tL1) * (tL - tL1) + (ta - ta1) * (ta - ta1) + (tb - tb1) * (tb - tb1));
+            const float w = std::exp(-(dCr + dCt) / gammaC) * spatialWeights[k];
+
+            wsum += w;
+            xsum += w * rL1;
+            ysum += w * tL1;
+            xxsum += w * rL1 * rL1;
+            yysum += w * tL1 * tL1;
+            xysum += w * rL1 * tL1;
+        }
+    }
+
+    const float varX = (xxsum - xsum * xsum / wsum) / wsum;
+    const float varY = (yysum - ysum * ysum / wsum) / wsum;
+    const float varXY = (xysum - xsum * ysum / wsum) / wsum;
+    const float sim = -varXY / std::sqrt(varX * varY);
+    if(!std::isfinite(sim))
+        return 1.0f;
+    return std::max(-1.0f, std::min(1.0f, sim));
+}
+
+float refineDepthSubPixel(float depthM1, float depthP1, float simM1, float sim, float simP1)
+{
+    simM1 = (simM1 + 1.0f) / 2.0f;
+    simP1 = (simP1 + 1.0f) / 2.0f;
+    sim = (sim + 1.0f) / 2.0f;
+
+    if((simM1 > sim) && (simP1 > sim))
+    {
+        const float dispStep = -((simP1 - simM1) / (2.0f * (simP1 + simM1 - 2.0f * sim)));
+        const float b = (depthP1 + depthM1) / 2.0f;
+        const float a = b - depthM1;
+        return a * dispStep + b;
+    }
+    return -1.0f;
+}
+
+/**
+ * @brief Aggregate one SGM path.
+ *
+ * The similarity volume is seen as [depth][pathPos][lane]: the path walks along pathPos and
+ * the lanes are independent, so each thread processes a block of contiguous lanes.
+ *
+ * @param[in] P1 penalty of the depth changes of one step
+ * @param[in] P2 penalty of the larger depth changes in the uniform areas, lowered along the image edges
+ * @param[in] deltaC Lab distance in the rc image between pathPos and pathPos-1 for each lane
+ * @param[inout] volAgr aggregated volume, updated with the running average over the paths
+ */
+void aggregateSGMPath(const unsigned char* volSim, std::size_t simPosStride, std::size_t simLaneStride,
+                      unsigned char* volAgr, std::size_t agrPosStride, std::size_t agrLaneStride,
+                      std::size_t depthStride, int nLanes, int pathLen, int nDepths, bool invZ, unsigned int P1,
+                      unsigned int P2, const std::vector<float>& deltaC, int lastN)
+{
+    const int laneBlockSize = 64;
+    const int nLaneBlocks = (nLanes + laneBlockSize - 1) / laneBlockSize;
+
+#pragma omp parallel for schedule(dynamic)
+    for(int block = 0; block < nLaneBlocks; ++block)
+    {
+        const int laneFrom = block * laneBlockSize;
+        const int nbl = std::min(laneBlockSize, nLanes - laneFrom);
+
+        std::vector<unsigned int> prev(nDepths * nbl);
+        std::vector<unsigned int> cur(nDepths * nbl);
+        std::vector<unsigned int> minPrev(nbl);
+        std::vector<unsigned int> P2Lane(nbl);
+
+        const auto updateAgr = [&](int d, int pos, int l, unsigned int cost)
+        {
+            unsigned char& agr = volAgr[d * depthStride + pos * agrPosStride + (laneFrom + l) * agrLaneStride];
+            const float val = (float(agr) * float(lastN) + float(std::min(255u, cost))) / float(lastN + 1);
+            agr = (unsigned char)(std::min(255.0f, val));
+        };
+
+        const int pos0 = invZ ? pathLen - 1 : 0;
+        for(int d = 0; d < nDepths; ++d)
+        {
+            for(int l = 0; l < nbl; ++l)
+            {
+                prev[d * nbl + l] = volSim[d * depthStride + pos0 * simPosStride + (laneFrom + l) * simLaneStride];
+                updateAgr(d, pos0, l, 255);
+            }
+        }
+
+        for(int step = 1; step < pathLen; ++step)
+        {
+            const int pos = invZ ? pathLen - 1 - step : step;
+            const int deltaCPos = invZ ? pos + 1 : pos;
+
+            for(int l = 0; l < nbl; ++l)
+            {
+                minPrev[l] = prev[l];
+                P2Lane[l] = std::max(P1, (unsigned int)sigmoid(15.0f, (float)P2, 80.0f, 20.0f,
+                                                               deltaC[deltaCPos * nLanes + laneFrom + l]));
+            }
+            for(int d = 1; d < nDepths; ++d)
+            {
+                const unsigned int* prevD = &prev[d * nbl];
+                for(int l = 0; l < nbl; ++l)
+                    minPrev[l] = std::min(minPrev[l], prevD[l]);
+            }
+
+            for(int d = 0; d < nDepths; ++d)
+            {
+                unsigned int* curD = &cur[d * nbl];
+                if((d == 0) || (d == nDepths - 1))
+                {
+                    for(int l = 0; l < nbl; ++l)
+                        curD[l] = 255;
+                }
+                else
+                {
+                    const unsigned int* prevD = &prev[d * nbl];
+                    const unsigned int* prevDM1 = &prev[(d - 1) * nbl];
+                    const unsigned int* prevDP1 = &prev[(d + 1) * nbl];
+                    const unsigned char* simD = &volSim[d * depthStride + pos * simPosStride + laneFrom * simLaneStride];
+                    for(int l = 0; l < nbl; ++l)
+                    {
+                        unsigned int minCost = std::min(prevD[l], prevDM1[l] + P1);
+                        minCost = std::min(minCost, prevDP1[l] + P1);
+                        minCost = std::min(minCost, minPrev[l] + P2Lane[l]);
+                        curD[l] = (unsigned int)simD[l * simLaneStride] + minCost - minPrev[l];
+                    }
+                }
+                for(int l = 0; l < nbl; ++l)
+                    updateAgr(d, pos, l, curD[l]);
+            }
+            std::swap(prev, cur);
+        }
+    }
+}
+
+void rgb2lab(float r, float g, float b, float& L, float& A, float& B)
+{
+    // linear RGB (0..1) to XYZ using sRGB primaries
+    const float x = 0.4124564f * r + 0.3575761f * g + 0.1804375f * b;
+    const float y = 0.2126729f * r + 0.7151522f * g + 0.0721750f * b;
+    const float z = 0.0193339f * r + 0.1191920f * g + 0.9503041f * b;
+
+    // XYZ to CIELAB (0..255) assuming D65 whitepoint
+    const auto f = [](float t) {
+        return (t > 216.0f / 24389.0f) ? std::cbrt(t) : (24389.0f / 27.0f * t + 16.0f) / 116.0f;
+    };
+    const float fx = f(x / 0.95047f);
+    const float fy = f(y);
+    const float fz = f(z / 1.08883f);
+
+    L = (116.0f * fy - 16.0f) * 2.55f;
+    A = 500.0f * (fx - fy) * 2.55f;
+    B = 200.0f * (fy - fz) * 2.55f;
+}
+
+void computeGradientSizeOfL(LabImage& img)
+{
+#pragma omp parallel for
+    for(int y = 0; y < img.height; ++y)
+    {
+        for(int x = 0; x < img.width; ++x)
+        {
+            const float gx = img.L[clampedPixelId(img, x - 1, y)] - img.L[clampedPixelId(img, x + 1, y)];
+            const float gy = img.L[clampedPixelId(img, x, y - 1)] - img.L[clampedPixelId(img, x, y + 1)];
+            img.grad[y * img.width + x] = std::sqrt(gx * gx + gy * gy);
+        }
+    }
+}
+
+} // namespace
+
+void LabImage::resize(int w, int h)
+{
+    width = w;
+    height = h;
+    L.resize(w * h);
+    a.resize(w * h);
+    b.resize(w * h);
+    grad.assign(w * h, 0.0f);
+}
+
+PlaneSweepingCpu::PlaneSweepingCpu(mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp,
+                                   mvsUtils::PreMatchCams* _pc, int _scales)
+  : PlaneSweeping(_ic, _mp, _pc, _scales)
+{
+    const int maxImageWidth = mp->getMaxImageWidth();
+    const int maxImageHeight = mp->getMaxImageHeight();
+
+    // L, a, b and gradient channels in float for all the scales
+    float oneimagemb = 16.0f * (((float)(maxImageWidth * maxImageHeight) / 1024.0f) / 1024.0f);
+    for(int scale = 2; scale <= scales; ++scale)
+    {
+        oneimagemb += 16.0f * (((float)((maxImageWidth / scale) * (maxImageHeight / scale)) / 1024.0f) / 1024.0f);
+    }
+    const float maxmbCPU = (float)mp->_ini.get<int>("planeSweeping.maxmbCPU", 2000);
+    _nImgsInCache = std::max(2, std::min(mp->ncams, (int)(maxmbCPU / oneimagemb)));
+
+    _varianceWSH = mp->_ini.get<int>("global.varianceWSH", 4);
+
+    ALICEVISION_LOG_INFO("PlaneSweepingCpu:" << std::endl
+                         << "\t- nImgsInCache: " << _nImgsInCache << std::endl
+                         << "\t- scales: " << scales << std::endl
+                         << "\t- nThreads: " << omp_get_max_threads() << std::endl
+                         << "\t- varianceWSH: " << _varianceWSH);
+
+    _cams.resize(_nImgsInCache);
+}
+
+PlaneSweepingCpu::~PlaneSweepingCpu() = default;
+
+void PlaneSweepingCpu::loadCam(CachedCam& cam, int rc)
+{
+    long t1 = clock();
+
+    const int w = mp->getWidth(rc);
+    const int h = mp->getHeight(rc);
+
+    cam.rc = rc;
+    cam.levels.resize(scales);
+
+    LabImage& img = cam.levels[0];
+    img.resize(w, h);
+
+    const mvsUtils::ImagesCache::ImgSharedPtr cacheImg = ic->getImg(rc);
+    Pixel pix;
+    for(pix.y = 0; pix.y < h; ++pix.y)
+    {
+        for(pix.x = 0; pix.x < w; ++pix.x)
+        {
+            const rgb c = cacheImg->getPixelValue(pix);
+            const int i = pix.y * w + pix.x;
+            img.L[i] = c.r;
+            img.a[i] = c.g;
+            img.b[i] = c.b;
+        }
+    }
+
+#pragma omp parallel for
+    for(int i = 0; i < w * h; ++i)
+    {
+        rgb2lab(img.L[i] / 255.0f, img.a[i] / 255.0f, img.b[i] / 255.0f, img.L[i], img.a[i], img.b[i]);
+    }
+
+    if(_varianceWSH > 0)
+        computeGradientSizeOfL(img);
+
+    for(int s = 1; s < scales; ++s)
+    {
+        // gaussian downscale by factor (s+1) of the full resolution image
+        const int factor = s + 1;
+        const int radius = s + 1;
+        std::vector<float> gaussian(2 * radius + 1);
+        for(int i = -radius; i <= radius; ++i)
+            gaussian[i + radius] = std::exp(-float(i * i) / 2.0f);
+
+        LabImage& level = cam.levels[s];
+        level.resize(w / factor, h / factor);
+
+#pragma omp parallel for
+        for(int y = 0; y < level.height; ++y)
+        {
+            for(int x = 0; x < level.width; ++x)
+            {
+                float L = 0.0f, A = 0.0f, B = 0.0f, G = 0.0f, sum = 0.0f;
+                for(int i = -radius; i <= radius; ++i)
+                {
+                    for(int j = -radius; j <= radius; ++j)
+                    {
+                        const float factorW = gaussian[i + radius] * gaussian[j + radius];
+                        const float px = (float)(x * factor + j) + (float)factor / 2.0f - 0.5f;
+                        const float py = (float)(y * factor + i) + (float)factor / 2.0f - 0.5f;
+                        float pL, pA, pB;
+                        sampleLab(img, px, py, pL, pA, pB);
+                        L += factorW * pL;
+                        A += factorW * pA;
+                        B += factorW * pB;
+                        G += factorW * img.grad[clampedPixelId(img, int(px + 0.5f), int(py + 0.5f))];
+                        sum += factorW;
+                    }
+                }
+                const int id = y * level.width + x;
+                level.L[id] = L / sum;
+                level.a[id] = A / sum;
+                level.b[id] = B / sum;
+                level.grad[id] = G / sum;
+            }
+        }
+
+        if(_varianceWSH > 0)
+            computeGradientSizeOfL(level);
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1, "load image " + std::to_string(rc) + " in the CPU plane sweeping cache");
+}
+
+const LabImage& PlaneSweepingCpu::getImage(int rc, int scale)
+{
+    if((scale < 1) || (scale > scales))
+        throw std::runtime_error("PlaneSweepingCpu: invalid scale " + std::to_string(scale) + " (" +
+                                 std::to_string(scales) + " scales)");
+
+    auto it = std::find_if(_cams.begin(), _cams.end(), [rc](const CachedCam& cam) { return cam.rc == rc; });
+    if(it == _cams.end())
+    {
+        // replace the oldest one
+        it = std::min_element(_cams.begin(), _cams.end(),
+                              [](const CachedCam& a, const CachedCam& b) { return a.time < b.time; });
+        loadCam(*it, rc);
+    }
+    it->time = clock();
+    return it->levels[scale - 1];
+}
+
+float PlaneSweepingCpu::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX,
+                                            int volDimY, int volDimZ, int volStepXY, int volLUX, int volLUY,
+                                            int volLUZ, StaticVector<float>* depths, int rc, int wsh, float gammaC,
+                                            float gammaP, StaticVector<Voxel>* pixels, int scale, int step,
+                                            StaticVector<int>* tcams, float epipShift)
+{
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("sweepPixelsVolume:" << std::endl
+                              << "\t- scale: " << scale << std::endl
+                              << "\t- step: " << step << std::endl
+                              << "\t- npixels: " << pixels->size() << std::endl
+                              << "\t- volStepXY: " << volStepXY << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    long t1 = clock();
+
+    if((tcams->size() == 0) || (pixels->size() == 0))
+        return -1.0f;
+
+    const int tc = (*tcams)[0];
+    const CameraParams rcam = getCameraParams(mp, rc, scale);
+    const CameraParams tcam = getCameraParams(mp, tc, scale);
+    const LabImage& rimg = getImage(rc, scale);
+    const LabImage& timg = getImage(tc, scale);
+    const std::vector<float> spatialWeights = computePatchSpatialWeights(wsh, gammaP);
+
+    const int nDepths = depths->size();
+    const std::vector<float>& depthsData = depths->getData();
+    const std::vector<Voxel>& pixelsData = pixels->getData();
+    unsigned char* volumeData = volume->getDataWritable().data();
+
+    // each pixel writes its own voxels column
+#pragma omp parallel for schedule(dynamic, 64)
+    for(int i = 0; i < pixels->size(); ++i)
+    {
+        const Voxel& volPix = pixelsData[i];
+        const int vx = (volPix.x - volLUX) / volStepXY;
+        const int vy = (volPix.y - volLUY) / volStepXY;
+        if((vx < 0) || (vx >= volDimX) || (vy < 0) || (vy >= volDimY))
+            continue;
+
+        const Vec2f pix((float)volPix.x, (float)volPix.y);
+        for(int sdptid = 0; sdptid < nDepthsToSearch; ++sdptid)
+        {
+            const int depthid = sdptid + volPix.z;
+            if(depthid >= nDepths)
+                break;
+            const int vz = depthid - volLUZ;
+            if((vz < 0) || (vz >= volDimZ))
+                continue;
+
+            Patch ptch;
+            const Vec3f p = get3DPointForPixelAndFrontoParallelPlane(rcam, pix, depthsData[depthid]);
+            ptch.d = computeRcPixSize(rcam, p);
+            computeRotCSEpip(ptch, p, rcam.C, tcam.C);
+
+            const float fsim = compNCCby3DptsYK(ptch, wsh, rcam, rimg, tcam, timg, gammaC, spatialWeights, epipShift);
+            const float sim01 = std::min(1.0f, std::max(0.0f, (fsim + 1.0f) / 2.0f));
+            const unsigned char sim = (unsigned char)(sim01 * 255.0f);
+
+            unsigned char& volsim = volumeData[vz * volDimX * volDimY + vy * volDimX + vx];
+            volsim = std::min(sim, volsim);
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return (float)volDimX * (float)volDimY * (float)volDimZ / (1024.0f * 1024.0f);
+}
+
+bool PlaneSweepingCpu::SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                                            int volDimZ, int volStepXY, int volLUX, int volLUY, int scale,
+                                            unsigned char P1, unsigned char P2)
+{
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("SGM optimizing volume:" << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    long t1 = clock();
+
+    const LabImage& rimg = getImage(rc, scale);
+
+    // Lab distance between consecutive pixels of the paths in X and in Y: P2 is the penalty of the depth
+    // jumps in the uniform areas, it decreases along the image edges (down to P1)
+    const auto imgPixelId = [&](int vx, int vy) {
+        return clampedPixelId(rimg, volLUX + vx * volStepXY, volLUY + vy * volStepXY);
+    };
+    std::vector<float> deltaCAlongY(volDimX * volDimY, 0.0f); // [y][x]
+    std::vector<float> deltaCAlongX(volDimX * volDimY, 0.0f); // [x][y]
+#pragma omp parallel for
+    for(int vy = 0; vy < volDimY; ++vy)
+    {
+        for(int vx = 0; vx < volDimX; ++vx)
+        {
+            const int i = imgPixelId(vx, vy);
+            if(vy > 0)
+                deltaCAlongY[vy * volDimX + vx] = labDistance(rimg, i, imgPixelId(vx, vy - 1));
+            if(vx > 0)
+                deltaCAlongX[vx * volDimY + vy] = labDistance(rimg, i, imgPixelId(vx - 1, vy));
+        }
+    }
+
+    const std::vector<unsigned char> volSim = volume->getData();
+    unsigned char* volAgr = volume->getDataWritable().data();
+    const std::size_t depthStride = std::size_t(volDimX) * volDimY;
+
+    int npaths = 0;
+    for(bool invZ : {false, true})
+    {
+        // along Y, lanes are the contiguous X
+        aggregateSGMPath(volSim.data(), volDimX, 1, volAgr, volDimX, 1, depthStride, volDimX, volDimY, volDimZ,
+                         invZ, P1, P2, deltaCAlongY, npaths++);
+    }
+    for(bool invZ : {false, true})
+    {
+        // along X, lanes are Y
+        aggregateSGMPath(volSim.data(), 1, volDimX, volAgr, 1, volDimX, depthStride, volDimY, volDimX, volDimZ,
+                         invZ, P1, P2, deltaCAlongX, npaths++);
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                                          StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh,
+                                          float gammaC, float gammaP, float epipShift, int xFrom, int wPart)
+{
+    const int w = wPart;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("\t- rc: " << rc << std::endl << "\t- tcams: " << tc);
+
+    const CameraParams rcam = getCameraParams(mp, rc, scale);
+    const CameraParams tcam = getCameraParams(mp, tc, scale);
+    const LabImage& rimg = getImage(rc, scale);
+    const LabImage& timg = getImage(tc, scale);
+    const std::vector<float> spatialWeights = computePatchSpatialWeights(wsh, gammaP);
+
+    const auto computeSim = [&](const Vec3f& p) {
+        Patch ptch;
+        ptch.d = computeRcPixSize(rcam, p);
+        computeRotCSEpip(ptch, p, rcam.C, tcam.C);
+        return compNCCby3DptsYK(ptch, wsh, rcam, rimg, tcam, timg, gammaC, spatialWeights, epipShift);
+    };
+
+#pragma omp parallel for schedule(dynamic)
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const Vec2f pix((float)(x + xFrom), (float)y);
+            const float idpt = (*rcDepthMap)[y * w + x];
+
+            float bestSim = 1.0f;
+            float bestDpt = idpt;
+
+            if(idpt > 0.0f)
+            {
+                // search the best depth along the ray
+                for(int i = 0; i < nStepsToRefine; ++i)
+                {
+                    Vec3f p = get3DPointForPixelAndDepth(rcam, pix, idpt);
+                    move3DPointByTcOrRcPixStep(rcam, tcam, p, (float)(i - (nStepsToRefine - 1) / 2), useTcOrRcPixSize);
+                    const float osim = computeSim(p);
+                    if((i == 0) || (osim < bestSim))
+                    {
+                        bestSim = osim;
+                        bestDpt = size(p - rcam.C);
+                    }
+                }
+
+                // sub-pixel refinement from the similarities around the best depth
+                const Vec3f pMid = get3DPointForPixelAndDepth(rcam, pix, bestDpt);
+                Vec3f pm1 = pMid;
+                Vec3f pp1 = pMid;
+                move3DPointByTcOrRcPixStep(rcam, tcam, pm1, -1.0f, useTcOrRcPixSize);
+                move3DPointByTcOrRcPixStep(rcam, tcam, pp1, +1.0f, useTcOrRcPixSize);
+
+                const float refinedDepth = refineDepthSubPixel(size(pm1 - rcam.C), size(pp1 - rcam.C),
+                                                               computeSim(pm1), bestSim, computeSim(pp1));
+                if(refinedDepth > 0.0f)
+                    bestDpt = refinedDepth;
+            }
+
+            (*simMap)[y * w + x] = bestSim;
+            (*rcDepthMap)[y * w + x] = bestDpt;
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC,
+                                      float igammaP, int wsh)
+{
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("smoothDepthMap rc: " << rc);
+
+    const CameraParams rcam = getCameraParams(mp, rc, scale);
+    const LabImage& rimg = getImage(rc, scale);
+    const std::vector<float> idepthMap = depthMap->getData();
+
+#pragma omp parallel for
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const float depth = idepthMap[y * w + x];
+            if(depth <= 0.0f)
+                continue;
+
+            const float pixSize = size(get3DPointForPixelAndDepth(rcam, Vec2f((float)x, (float)y), depth) -
+                                       get3DPointForPixelAndDepth(rcam, Vec2f((float)(x + 1), (float)y), depth));
+            const int ic0 = clampedPixelId(rimg, x, y);
+
+            float depthUp = 0.0f;
+            float depthDown = 0.0f;
+            for(int yp = -wsh; yp <= wsh; ++yp)
+            {
+                for(int xp = -wsh; xp <= wsh; ++xp)
+                {
+                    const int xn = std::min(std::max(x + xp, 0), w - 1);
+                    const int yn = std::min(std::max(y + yp, 0), h - 1);
+                    const float depthn = idepthMap[yn * w + xn];
+                    if(std::abs(depthn - depth) < 10.0f * pixSize)
+                    {
+                        const float deltaC = labDistance(rimg, ic0, clampedPixelId(rimg, x + xp, y + yp));
+                        const float deltaP = std::sqrt(float(xp * xp + yp * yp));
+                        const float wgt = std::exp(-(deltaC / igammaC + deltaP / igammaP));
+                        depthUp += wgt * depthn;
+                        depthDown += wgt;
+                    }
+                }
+            }
+            (*depthMap)[y * w + x] = depthUp / depthDown;
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC,
+                                      float minCostThr, int wsh)
+{
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("filterDepthMap rc: " << rc);
+
+    const CameraParams rcam = getCameraParams(mp, rc, scale);
+    const LabImage& rimg = getImage(rc, scale);
+    const std::vector<float> idepthMap = depthMap->getData();
+
+#pragma omp parallel for
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const float depth = idepthMap[y * w + x];
+            if(depth <= 0.0f)
+                continue;
+
+            const float pixSize = size(get3DPointForPixelAndDepth(rcam, Vec2f((float)x, (float)y), depth) -
+                                       get3DPointForPixelAndDepth(rcam, Vec2f((float)(x + 1), (float)y), depth));
+            const int ic0 = clampedPixelId(rimg, x, y);
+
+            float depthDown = 0.0f;
+            for(int yp = -wsh; yp <= wsh; ++yp)
+            {
+                for(int xp = -wsh; xp <= wsh; ++xp)
+                {
+                    const int xn = std::min(std::max(x + xp, 0), w - 1);
+                    const int yn = std::min(std::max(y + yp, 0), h - 1);
+                    const float depthn = idepthMap[yn * w + xn];
+                    if(std::abs(depthn - depth) < 10.0f * pixSize)
+                    {
+                        const float deltaC = labDistance(rimg, ic0, clampedPixelId(rimg, x + xp, y + yp));
+                        depthDown += std::exp(-deltaC / igammaC);
+                    }
+                }
+            }
+            (*depthMap)[y * w + x] = (depthDown < minCostThr) ? -1.0f : depth;
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                                            const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                                            int nSamplesHalf, int nDepthsToRefine, float sigma)
+{
+    long t1 = clock();
+
+    const float samplesPerPixSize = (float)(nSamplesHalf / ((nDepthsToRefine - 1) / 2));
+    const float twoTimesSigmaPowerTwo = 2.0f * sigma * sigma;
+    const int nTcs = dataMaps->size() - 1;
+
+#pragma omp parallel
+    {
+        // per Tc: sample position of the Tc depth and its similarity weight
+        std::vector<float> tcSamples(nTcs);
+        std::vector<float> tcSims(nTcs);
+
+#pragma omp for
+        for(int i = 0; i < w * h; ++i)
+        {
+            const DepthSim& midDepthPixSize = (*(*dataMaps)[0])[i];
+            if(midDepthPixSize.depth <= 0.0f)
+            {
+                (*oDepthSimMap)[i] = DepthSim(-1.0f, 1.0f);
+                continue;
+            }
+            const float depthStep = midDepthPixSize.sim / samplesPerPixSize;
+
+            int nValid = 0;
+            for(int c = 0; c < nTcs; ++c)
+            {
+                const DepthSim& depthSim = (*(*dataMaps)[c + 1])[i];
+                if(depthSim.depth > 0.0f)
+                {
+                    tcSamples[nValid] = (midDepthPixSize.depth - depthSim.depth) / depthStep;
+                    tcSims[nValid] = -sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthSim.sim);
+                    ++nValid;
+                }
+            }
+
+            float bestGsvSample = 0.0f;
+            float bestS = 0.0f;
+            for(int s = -nSamplesHalf; s <= nSamplesHalf; ++s)
+            {
+                float gsvSample = 0.0f;
+                for(int c = 0; c < nValid; ++c)
+                {
+                    const float d = tcSamples[c] - (float)s;
+                    gsvSample += tcSims[c] * std::exp(-(d * d) / twoTimesSigmaPowerTwo);
+                }
+                if((s == -nSamplesHalf) || (gsvSample < bestGsvSample))
+                {
+                    bestGsvSample = gsvSample;
+                    bestS = (float)s;
+                }
+            }
+            (*oDepthSimMap)[i] = DepthSim(midDepthPixSize.depth - bestS * depthStep, bestGsvSample);
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                                          StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc,
+                                                          int nIters, int yFrom, int hPart)
+{
+    if(mp->verbose)
+        ALICEVISION_LOG_DEBUG("optimizeDepthSimMapGradientDescent.");
+
+    const int scale = 1;
+    const int w = mp->getWidth(rc);
+    const int h = hPart;
+
+    long t1 = clock();
+
+    const CameraParams rcam = getCameraParams(mp, rc, scale);
+    const LabImage& rimg = getImage(rc, scale);
+
+    const StaticVector<DepthSim>& midDepthPixSizeMap = *(*dataMaps)[0];
+    const StaticVector<DepthSim>& fusedDepthSimMap = *(*dataMaps)[1];
+
+    std::vector<DepthSim> optDepthSimMap(w * h);
+    for(int y = 0; y < h; ++y)
+        for(int x = 0; x < w; ++x)
+            optDepthSimMap[y * w + x] = midDepthPixSizeMap[(y + yFrom) * w + x];
+    std::vector<float> optDepthMap(w * h);
+
+    const auto get3DPoint = [&](int x, int y, float depth) {
+        return get3DPointForPixelAndDepth(rcam, Vec2f((float)x, (float)(y + yFrom)), depth);
+    };
+    const auto getDepth = [&](int x, int y) {
+        return optDepthMap[std::min(std::max(y, 0), h - 1) * w + std::min(std::max(x, 0), w - 1)];
+    };
+
+    for(int iter = 0; iter < nIters; ++iter)
+    {
+        for(int i = 0; i < w * h; ++i)
+            optDepthMap[i] = optDepthSimMap[i].depth;
+
+#pragma omp parallel for
+        for(int y = 0; y < h; ++y)
+        {
+            for(int x = 0; x < w; ++x)
+            {
+                const int jO = (y + yFrom) * w + x;
+                const DepthSim& midDepthPixSize = midDepthPixSizeMap[jO];
+                const DepthSim& fusedDepthSim = fusedDepthSimMap[jO];
+                DepthSim& optDepthSim = optDepthSimMap[y * w + x];
+                if(iter == 0)
+                    optDepthSim.sim = fusedDepthSim.sim;
+
+                const float depthOpt = optDepthSim.depth;
+                if(depthOpt <= 0.0f)
+                    continue;
+
+                // smoothing step and energy from the 4 neighbours
+                float depthSmoothStep = 0.0f;
+                float depthSmoothVal = 180.0f;
+                {
+                    const float dL = getDepth(x, y - 1);
+                    const float dR = getDepth(x, y + 1);
+                    const float dU = getDepth(x - 1, y);
+                    const float dB = getDepth(x + 1, y);
+                    const Vec3f p0 = get3DPoint(x, y, depthOpt);
+                    const Vec3f pL = get3DPoint(x, y - 1, dL);
+                    const Vec3f pR = get3DPoint(x, y + 1, dR);
+                    const Vec3f pU = get3DPoint(x - 1, y, dU);
+                    const Vec3f pB = get3DPoint(x + 1, y, dB);
+
+                    Vec3f cg(0.0f, 0.0f, 0.0f);
+                    float n = 0.0f;
+                    if(dL > 0.0f) { cg = cg + pL; n++; }
+                    if(dR > 0.0f) { cg = cg + pR; n++; }
+                    if(dU > 0.0f) { cg = cg + pU; n++; }
+                    if(dB > 0.0f) { cg = cg + pB; n++; }
+                    if(n > 1.0f)
+                    {
+                        cg = cg / n;
+                        const Vec3f vcn = normalize(rcam.C - p0);
+                        // projection of cg on the line from p0 to the camera
+                        const Vec3f pS = closestPointToLine3D(cg, p0, vcn);
+                        depthSmoothStep = size(rcam.C - pS) - depthOpt;
+                    }
+
+                    // large angle between neighbours means flat area, so low energy
+                    float e = 0.0f;
+                    n = 0.0f;
+                    if(dL > 0.0f && dR > 0.0f)
+                    {
+                        e = std::max(e, 180.0f - angleBetwABandAC(p0, pL, pR));
+                        n++;
+                    }
+                    if(dU > 0.0f && dB > 0.0f)
+                    {
+                        e = std::max(e, 180.0f - angleBetwABandAC(p0, pU, pB));
+                        n++;
+                    }
+                    if(n > 0.0f)
+                        depthSmoothVal = e;
+                }
+
+                const float maxStep = midDepthPixSize.sim / 10.0f;
+                depthSmoothStep = std::copysign(std::min(std::abs(depthSmoothStep), maxStep), depthSmoothStep);
+                float depthPhotoStep = fusedDepthSim.depth - depthOpt;
+                depthPhotoStep = std::copysign(std::min(std::abs(depthPhotoStep), maxStep), depthPhotoStep);
+                const float depthVisStep = midDepthPixSize.depth - depthOpt;
+                const float depthPhotoStepVal = fusedDepthSim.sim;
+
+                const float varianceGray = rimg.grad[clampedPixelId(rimg, x, y + yFrom)];
+                const float varianceGrayAndleWeight = sigmoid2(5.0f, 30.0f, 40.0f, 20.0f, varianceGray);
+                const float simWeight = sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthPhotoStepVal);
+                const float photoWeight = sigmoid(0.0f, 1.0f, 30.0f, varianceGrayAndleWeight, depthSmoothVal);
+                const float smoothWeight = 1.0f - photoWeight;
+                const float visWeight =
+                    1.0f - sigmoid(0.0f, 1.0f, 10.0f, 17.0f, std::abs(depthVisStep / midDepthPixSize.sim));
+
+                const float depthOptStep =
+                    visWeight * depthVisStep +
+                    (1.0f - visWeight) * (photoWeight * simWeight * depthPhotoStep + smoothWeight * depthSmoothStep);
+
+                optDepthSim.depth = depthOpt + depthOptStep;
+                optDepthSim.sim = (1.0f - visWeight) * photoWeight * simWeight * depthPhotoStepVal +
+                                  (1.0f - visWeight) * smoothWeight * (depthSmoothVal / 20.0f);
+            }
+        }
+    }
+
+    for(int y = 0; y < h; ++y)
+        for(int x = 0; x < w; ++x)
+            (*oDepthSimMap)[(y + yFrom) * w + x] = optDepthSimMap[y * w + x];
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc)
+{
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("getSilhoueteeMap: rc: " << rc);
+
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    const LabImage& rimg = getImage(rc, scale);
+
+    float maskL, maskA, maskB;
+    rgb2lab(maskColor.r / 255.0f, maskColor.g / 255.0f, maskColor.b / 255.0f, maskL, maskA, maskB);
+
+    // compare the colors with the same 8 bits precision as the CUDA implementation
+    const auto quantize = [](float v) { return (int)v; };
+
+#pragma omp parallel for
+    for(int y = 0; y < h / step; ++y)
+    {
+        for(int x = 0; x < w / step; ++x)
+        {
+            const int i = clampedPixelId(rimg, x * step, y * step);
+            (*oMap)[y * (w / step) + x] = (quantize(rimg.L[i]) == quantize(maskL)) &&
+                                          (quantize(rimg.a[i]) == quantize(maskA)) &&
+                                          (quantize(rimg.b[i]) == quantize(maskB));
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+// (avail, total, used) in MB
+Point3d PlaneSweepingCpu::getDeviceMemoryInfo()
+{
+    const system::MemoryInfo memInfo = system::getMemoryInfo();
+    const double freeMB = double(memInfo.freeRam) / (1024.0 * 1024.0);
+    const double totalMB = double(memInfo.totalRam) / (1024.0 * 1024.0);
+    return Point3d(freeMB, totalMB, totalMB - freeMB);
+}
+
+} // namespace depthMap
+} // namespace aliceVision
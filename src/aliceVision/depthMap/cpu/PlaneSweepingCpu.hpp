@@ -0,0 +1,92 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/depthMap/PlaneSweeping.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Image in Lab colorspace (0..255 range) at one scale, stored channel by channel.
+ *        The gradient channel contains the gradient magnitude of L (used as texture indicator).
+ */
+struct LabImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<float> L;
+    std::vector<float> a;
+    std::vector<float> b;
+    std::vector<float> grad;
+
+    void resize(int w, int h);
+};
+
+/**
+ * @brief CPU implementation of the plane sweeping backend.
+ *
+ * Follows the CUDA implementation (same similarity measure, SGM aggregation and refine/fuse
+ * steps) so that the depth maps can be compared. Pixels and depths are processed in parallel
+ * with OpenMP and the inner loops work on contiguous buffers to be vectorized by the compiler.
+ */
+class PlaneSweepingCpu : public PlaneSweeping
+{
+public:
+    PlaneSweepingCpu(mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc,
+                     int _scales);
+    ~PlaneSweepingCpu() override;
+
+    float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                              int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
+                              StaticVector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
+                              StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
+                              float epipShift) override;
+    bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
+                              int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1,
+                              unsigned char P2) override;
+    bool refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                            StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
+                            float gammaP, float epipShift, int xFrom, int wPart) override;
+    bool smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float igammaP,
+                        int wsh) override;
+    bool filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float minCostThr,
+                        int wsh) override;
+    bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                              const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                              int nSamplesHalf, int nDepthsToRefine, float sigma) override;
+    bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                            StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc, int nIters,
+                                            int yFrom, int hPart) override;
+    bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc) override;
+    Point3d getDeviceMemoryInfo() override;
+
+private:
+    struct CachedCam
+    {
+        int rc = -1;
+        long time = 0;
+        std::vector<LabImage> levels; //< one image per scale
+    };
+
+    /**
+     * @brief Get the Lab image of the camera rc at the given scale (1 is the full resolution),
+     *        loading the camera into the cache if needed.
+     */
+    const LabImage& getImage(int rc, int scale);
+    void loadCam(CachedCam& cam, int rc);
+
+    int _nImgsInCache;
+    int _varianceWSH;
+    std::vector<CachedCam> _cams;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -199,8 +199,7 @@ extern void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2
 extern void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
                                                   CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
                                                   CudaHostMemoryHeap<float2, 2>** dataMaps_hmh, int ndataMaps,
-                                                  int nSamplesHalf, int nDepthsToRefine, int nIters, float sigma,
-                                                  cameraStruct** cams, int ncams, int width, int height, int scale,
+                                                  int nIters, cameraStruct** cams, int ncams, int width, int height, int scale,
                                                   int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose,
                                                   int yFrom);
 
@@ -347,7 +346,7 @@ void cps_fillCameraData(mvsUtils::ImagesCache* ic, cameraStruct* cam, int c, mvs
     //	cam->tex_hmh_g->getBuffer(),
     //	cam->tex_hmh_b->getBuffer(), mp->indexes[c], mp, true, 1, 0);
 
-    ic->refreshData(c);
+    const mvsUtils::ImagesCache::ImgSharedPtr img = ic->getImg(c);
 
     Pixel pix;
     for(pix.y = 0; pix.y < mp->getHeight(c); pix.y++)
@@ -355,7 +354,7 @@ void cps_fillCameraData(mvsUtils::ImagesCache* ic, cameraStruct* cam, int c, mvs
         for(pix.x = 0; pix.x < mp->getWidth(c); pix.x++)
         {
              uchar4& pix_rgba = ic->transposed ? (*cam->tex_rgba_hmh)(pix.x, pix.y) : (*cam->tex_rgba_hmh)(pix.y, pix.x);
-             const rgb& pc = ic->getPixelValue(pix, c);
+             const rgb pc = img->getPixelValue(pix);
              pix_rgba.x = pc.r;
              pix_rgba.y = pc.g;
              pix_rgba.z = pc.b;
@@ -379,19 +378,13 @@ void cps_updateCamH(cameraStruct* cam, float** H)
 
 PlaneSweepingCuda::PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp,
                                          mvsUtils::PreMatchCams* _pc, int _scales)
+  : PlaneSweeping(_ic, _mp, _pc, _scales)
 {
     CUDADeviceNo = _CUDADeviceNo;
 
-    ic = _ic;
-    scales = _scales;
-    mp = _mp;
-    pc = _pc;
-
     const int maxImageWidth = mp->getMaxImageWidth();
     const int maxImageHeight = mp->getMaxImageHeight();
 
-    verbose = mp->verbose;
-
     float oneimagemb = 4.0f * (((float)(maxImageWidth * maxImageHeight) / 1024.0f) / 1024.0f);
     for(int scale = 2; scale <= scales; ++scale)
     {
@@ -506,364 +499,6 @@ PlaneSweepingCuda::~PlaneSweepingCuda(void)
     mp = NULL;
 }
 
-void PlaneSweepingCuda::getMinMaxdepths(int rc, StaticVector<int>* tcams, float& minDepth, float& midDepth,
-                                          float& maxDepth)
-{
-    StaticVector<SeedPoint>* seeds;
-    mvsUtils::loadSeedsFromFile(&seeds, rc, mp, mvsUtils::EFileType::seeds);
-
-    float minCamDist = (float)mp->_ini.get<double>("prematching.minCamDist", 0.0f);
-    float maxCamDist = (float)mp->_ini.get<double>("prematching.maxCamDist", 15.0f);
-    float maxDepthScale = (float)mp->_ini.get<double>("prematching.maxDepthScale", 1.5f);
-    bool minMaxDepthDontUseSeeds = mp->_ini.get<bool>("prematching.minMaxDepthDontUseSeeds", false);
-
-    if((seeds->empty()) || minMaxDepthDontUseSeeds)
-    {
-        minDepth = 0.0f;
-        maxDepth = 0.0f;
-        for(int c = 0; c < tcams->size(); c++)
-        {
-            int tc = (*tcams)[c];
-            minDepth += (mp->CArr[rc] - mp->CArr[tc]).size() * minCamDist;
-            maxDepth += (mp->CArr[rc] - mp->CArr[tc]).size() * maxCamDist;
-        }
-        minDepth /= (float)tcams->size();
-        maxDepth /= (float)tcams->size();
-        midDepth = (minDepth + maxDepth) / 2.0f;
-    }
-    else
-    {
-        OrientedPoint rcplane;
-        rcplane.p = mp->CArr[rc];
-        rcplane.n = mp->iRArr[rc] * Point3d(0.0, 0.0, 1.0);
-        rcplane.n = rcplane.n.normalize();
-
-        minDepth = std::numeric_limits<float>::max();
-        maxDepth = -std::numeric_limits<float>::max();
-
-        // StaticVector<sortedId> *sos = new StaticVector<sortedId>();
-        // sos->reserve(seeds->size());
-        // for (int i=0;i<seeds->size();i++) {
-        //	sos->push_back(sortedId(i,pointPlaneDistance((*seeds)[i].op.p,rcplane.p,rcplane.n)));
-        //};
-        // qsort(&(*sos)[0],sos->size(),sizeof(sortedId),qsortCompareSortedIdAsc);
-        // minDepth = (*sos)[(int)((float)sos->size()*0.1f)].value;
-        // maxDepth = (*sos)[(int)((float)sos->size()*0.9f)].value;
-
-        Point3d cg = Point3d(0.0f, 0.0f, 0.0f);
-        for(int i = 0; i < seeds->size(); i++)
-        {
-            SeedPoint* sp = &(*seeds)[i];
-            cg = cg + sp->op.p;
-            float depth = pointPlaneDistance(sp->op.p, rcplane.p, rcplane.n);
-            minDepth = std::min(minDepth, depth);
-            maxDepth = std::max(maxDepth, depth);
-        }
-        cg = cg / (float)seeds->size();
-        midDepth = pointPlaneDistance(cg, rcplane.p, rcplane.n);
-
-        maxDepth = maxDepth * maxDepthScale;
-    }
-
-    delete seeds;
-}
-
-StaticVector<float>* PlaneSweepingCuda::getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth,
-                                                               int scale, int step, int maxDepthsHalf)
-{
-    float d = (float)step;
-
-    OrientedPoint rcplane;
-    rcplane.p = mp->CArr[rc];
-    rcplane.n = mp->iRArr[rc] * Point3d(0.0, 0.0, 1.0);
-    rcplane.n = rcplane.n.normalize();
-
-    int ndepthsMidMax = 0;
-    float maxdepth = midDepth;
-    while((maxdepth < maxDepth) && (ndepthsMidMax < maxDepthsHalf))
-    {
-        Point3d p = rcplane.p + rcplane.n * maxdepth;
-        float pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
-        maxdepth += pixSize;
-        ndepthsMidMax++;
-    }
-
-    int ndepthsMidMin = 0;
-    float mindepth = midDepth;
-    while((mindepth > minDepth) && (ndepthsMidMin < maxDepthsHalf * 2 - ndepthsMidMax))
-    {
-        Point3d p = rcplane.p + rcplane.n * mindepth;
-        float pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
-        mindepth -= pixSize;
-        ndepthsMidMin++;
-    }
-
-    // getNumberOfDepths
-    float depth = mindepth;
-    int ndepths = 0;
-    float pixSize = 1.0f;
-    while((depth < maxdepth) && (pixSize > 0.0f) && (ndepths < 2 * maxDepthsHalf))
-    {
-        Point3d p = rcplane.p + rcplane.n * depth;
-        pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
-        depth += pixSize;
-        ndepths++;
-    }
-
-    StaticVector<float>* out = new StaticVector<float>();
-    out->reserve(ndepths);
-
-    // fill
-    depth = mindepth;
-    pixSize = 1.0f;
-    ndepths = 0;
-    while((depth < maxdepth) && (pixSize > 0.0f) && (ndepths < 2 * maxDepthsHalf))
-    {
-        out->push_back(depth);
-        Point3d p = rcplane.p + rcplane.n * depth;
-        pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
-        depth += pixSize;
-        ndepths++;
-    }
-
-    // check if it is asc
-    for(int i = 0; i < out->size() - 1; i++)
-    {
-        if((*out)[i] >= (*out)[i + 1])
-        {
-
-            for(int j = 0; j <= i + 1; j++)
-            {
-                ALICEVISION_LOG_TRACE("getDepthsByPixelSize: check if it is asc: " << (*out)[j]);
-            }
-            throw std::runtime_error("getDepthsByPixelSize not asc.");
-        }
-    }
-
-    return out;
-}
-
-StaticVector<float>* PlaneSweepingCuda::getDepthsRcTc(int rc, int tc, int scale, float midDepth,
-                                                        int maxDepthsHalf)
-{
-    OrientedPoint rcplane;
-    rcplane.p = mp->CArr[rc];
-    rcplane.n = mp->iRArr[rc] * Point3d(0.0, 0.0, 1.0);
-    rcplane.n = rcplane.n.normalize();
-
-    Point2d rmid = Point2d((float)mp->getWidth(rc) / 2.0f, (float)mp->getHeight(rc) / 2.0f);
-    Point2d pFromTar, pToTar; // segment of epipolar line of the principal point of the rc camera to the tc camera
-    getTarEpipolarDirectedLine(&pFromTar, &pToTar, rmid, rc, tc, mp);
-
-    int allDepths = static_cast<int>((pToTar - pFromTar).size());
-    if(verbose == true)
-    {
-        ALICEVISION_LOG_DEBUG("allDepths: " << allDepths);
-    }
-
-    Point2d pixelVect = ((pToTar - pFromTar).normalize()) * std::max(1.0f, (float)scale);
-    // printf("%f %f %i %i\n",pixelVect.size(),((float)(scale*step)/3.0f),scale,step);
-
-    Point2d cg = Point2d(0.0f, 0.0f);
-    Point3d cg3 = Point3d(0.0f, 0.0f, 0.0f);
-    int ncg = 0;
-    // navigate through all pixels of the epilolar segment
-    // Compute the middle of the valid pixels of the epipolar segment (in rc camera) of the principal point (of the rc camera)
-    for(int i = 0; i < allDepths; i++)
-    {
-        Point2d tpix = pFromTar + pixelVect * (float)i;
-        Point3d p;
-        if(triangulateMatch(p, rmid, tpix, rc, tc, mp)) // triangulate principal point from rc with tpix
-        {
-            float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n); // todo: can compute the distance to the camera (as it's the principal point it's the same)
-            if( mp->isPixelInImage(tpix, tc)
-                && (depth > 0.0f)
-                && checkPair(p, rc, tc, mp, pc->minang, pc->maxang) )
-            {
-                cg = cg + tpix;
-                cg3 = cg3 + p;
-                ncg++;
-            }
-        }
-    }
-    if(ncg == 0)
-    {
-        return new StaticVector<float>();
-    }
-    cg = cg / (float)ncg;
-    cg3 = cg3 / (float)ncg;
-    allDepths = ncg;
-
-    if(verbose == true)
-    {
-        ALICEVISION_LOG_DEBUG("All correct depths: " << allDepths);
-    }
-
-    Point2d midpoint = cg;
-    if(midDepth > 0.0f)
-    {
-        Point3d midPt = rcplane.p + rcplane.n * midDepth;
-        mp->getPixelFor3DPoint(&midpoint, midPt, tc);
-    }
-
-    // compute the direction
-    float direction = 1.0f;
-    {
-        Point3d p;
-        if(!triangulateMatch(p, rmid, midpoint, rc, tc, mp))
-        {
-            StaticVector<float>* out = new StaticVector<float>();
-            return out;
-        }
-
-        float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
-
-        if(!triangulateMatch(p, rmid, midpoint + pixelVect, rc, tc, mp))
-        {
-            StaticVector<float>* out = new StaticVector<float>();
-            return out;
-        }
-
-        float depthP1 = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
-        if(depth > depthP1)
-        {
-            direction = -1.0f;
-        }
-    }
-
-    StaticVector<float>* out1 = new StaticVector<float>();
-    out1->reserve(2 * maxDepthsHalf);
-
-    Point2d tpix = midpoint;
-    float depthOld = -1.0f;
-    int istep = 0;
-    bool ok = true;
-
-    // compute depths for all pixels from the middle point to on one side of the epipolar line
-    while((out1->size() < maxDepthsHalf) && (mp->isPixelInImage(tpix, tc) == true) && (ok == true))
-    {
-        tpix = tpix + pixelVect * direction;
-
-        Point3d refvect = mp->iCamArr[rc] * rmid;
-        Point3d tarvect = mp->iCamArr[tc] * tpix;
-        float rptpang = angleBetwV1andV2(refvect, tarvect);
-
-        Point3d p;
-        ok = triangulateMatch(p, rmid, tpix, rc, tc, mp);
-
-        float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
-        if (mp->isPixelInImage(tpix, tc)
-            && (depth > 0.0f) && (depth > depthOld)
-            && checkPair(p, rc, tc, mp, pc->minang, pc->maxang)
-            && (rptpang > pc->minang)  // WARNING if vects are near parallel thaen this results to strange angles ...
-            && (rptpang < pc->maxang)) // this is the propper angle ... beacause is does not depend on the triangluated p
-        {
-            out1->push_back(depth);
-            // if ((tpix.x!=tpixold.x)||(tpix.y!=tpixold.y)||(depthOld>=depth))
-            //{
-            // printf("after %f %f %f %f %i %f %f\n",tpix.x,tpix.y,depth,depthOld,istep,ang,kk);
-            //};
-        }
-        else
-        {
-            ok = false;
-        }
-        depthOld = depth;
-        istep++;
-    }
-
-    StaticVector<float>* out2 = new StaticVector<float>();
-    out2->reserve(2 * maxDepthsHalf);
-    tpix = midpoint;
-    istep = 0;
-    ok = true;
-
-    // compute depths for all pixels from the middle point to the other side of the epipolar line
-    while((out2->size() < maxDepthsHalf) && (mp->isPixelInImage(tpix, tc) == true) && (ok == true))
-    {
-        Point3d refvect = mp->iCamArr[rc] * rmid;
-        Point3d tarvect = mp->iCamArr[tc] * tpix;
-        float rptpang = angleBetwV1andV2(refvect, tarvect);
-
-        Point3d p;
-        ok = triangulateMatch(p, rmid, tpix, rc, tc, mp);
-
-        float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
-        if(mp->isPixelInImage(tpix, tc)
-            && (depth > 0.0f) && (depth < depthOld) 
-            && checkPair(p, rc, tc, mp, pc->minang, pc->maxang)
-            && (rptpang > pc->minang)  // WARNING if vects are near parallel thaen this results to strange angles ...
-            && (rptpang < pc->maxang)) // this is the propper angle ... beacause is does not depend on the triangluated p
-        {
-            out2->push_back(depth);
-            // printf("%f %f\n",tpix.x,tpix.y);
-        }
-        else
-        {
-            ok = false;
-        }
-
-        depthOld = depth;
-        tpix = tpix - pixelVect * direction;
-    }
-
-    // printf("out2\n");
-    StaticVector<float>* out = new StaticVector<float>();
-    out->reserve(2 * maxDepthsHalf);
-    for(int i = out2->size() - 1; i >= 0; i--)
-    {
-        out->push_back((*out2)[i]);
-        // printf("%f\n",(*out2)[i]);
-    }
-    // printf("out1\n");
-    for(int i = 0; i < out1->size(); i++)
-    {
-        out->push_back((*out1)[i]);
-        // printf("%f\n",(*out1)[i]);
-    }
-
-    delete out2;
-    delete out1;
-
-    // we want to have it in ascending order
-    if((*out)[0] > (*out)[out->size() - 1])
-    {
-        StaticVector<float>* outTmp = new StaticVector<float>();
-        outTmp->reserve(out->size());
-        for(int i = out->size() - 1; i >= 0; i--)
-        {
-            outTmp->push_back((*out)[i]);
-        }
-        delete out;
-        out = outTmp;
-    }
-
-    // check if it is asc
-    for(int i = 0; i < out->size() - 1; i++)
-    {
-        if((*out)[i] > (*out)[i + 1])
-        {
-
-            for(int j = 0; j <= i + 1; j++)
-            {
-                ALICEVISION_LOG_TRACE("getDepthsRcTc: check if it is asc: " << (*out)[j]);
-            }
-            ALICEVISION_LOG_WARNING("getDepthsRcTc: not asc");
-
-            if(out->size() > 1)
-            {
-                qsort(&(*out)[0], out->size(), sizeof(float), qSortCompareFloatAsc);
-            }
-        }
-    }
-
-    if(verbose == true)
-    {
-        ALICEVISION_LOG_DEBUG("used depths: " << out->size());
-    }
-
-    return out;
-}
 /*
 
 bool PlaneSweepingCuda::refinePixelsAll(bool useTcOrRcPixSize, int ndepthsToRefine, StaticVector<float>* pxsdepths,
@@ -890,6 +525,14 @@ bool PlaneSweepingCuda::refinePixelsAll(bool useTcOrRcPixSize, int ndepthsToRefi
 
     StaticVector<int>* camsids = new StaticVector<int>();
     camsids->reserve(tcams->size() + 1);
+
+    // load the images of the tcams missing in the GPU in the background
+    for(int c = 0; c < tcams->size(); c++)
+    {
+        if(camsRcs->indexOf((*tcams)[c]) == -1)
+            ic->prefetch((*tcams)[c]);
+    }
+
     camsids->push_back(addCam(rc, NULL, scale));
     if(verbose)
         printf("rc: %i, ", rc);
@@ -994,6 +637,14 @@ bool PlaneSweepingCuda::refinePixelsAllFine(StaticVector<Color>* pxsnormals, Sta
 
     StaticVector<int>* camsids = new StaticVector<int>();
     camsids->reserve(tcams->size() + 1);
+
+    // load the images of the tcams missing in the GPU in the background
+    for(int c = 0; c < tcams->size(); c++)
+    {
+        if(camsRcs->indexOf((*tcams)[c]) == -1)
+            ic->prefetch((*tcams)[c]);
+    }
+
     camsids->push_back(addCam(rc, NULL, scale));
     if(verbose)
         printf("rc: %i, ", rc);
@@ -1593,6 +1244,14 @@ float PlaneSweepingCuda::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<u
 
     StaticVector<int> *camsids = new StaticVector<int>();
     camsids->reserve(tcams->size() + 1);
+
+    // load the images of the tcams missing in the GPU in the background
+    for(int c = 0; c < tcams->size(); c++)
+    {
+        if(camsRcs->indexOf((*tcams)[c]) == -1)
+            ic->prefetch((*tcams)[c]);
+    }
+
     camsids->push_back(addCam(rc, NULL, scale));
     if(verbose)
         ALICEVISION_LOG_DEBUG("rc: " << rc << std::endl << "tcams: ");
@@ -2155,7 +1814,6 @@ bool PlaneSweepingCuda::fuseDepthSimMapsGaussianKernelVoting(int w, int h, Stati
 
 bool PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
                                                              StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc,
-                                                             int nSamplesHalf, int nDepthsToRefine, float sigma,
                                                              int nIters, int yFrom, int hPart)
 {
     if(mp->verbose)
@@ -2202,7 +1860,7 @@ bool PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim
     CudaHostMemoryHeap<float2, 2> oDepthSimMap_hmh(CudaSize<2>(w, h));
 
     ps_optimizeDepthSimMapGradientDescent((CudaArray<uchar4, 2>**)ps_texs_arr, &oDepthSimMap_hmh, dataMaps_hmh,
-                                          dataMaps->size(), nSamplesHalf, nDepthsToRefine, nIters, sigma, ttcams,
+                                          dataMaps->size(), nIters, ttcams,
                                           camsids->size(), w, h, scale - 1, CUDADeviceNo, nImgsInGPUAtTime, scales,
                                           verbose, yFrom);
 
@@ -18,11 +18,12 @@
 #include <aliceVision/mvsUtils/ImagesCache.hpp>
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
 #include <aliceVision/depthMap/DepthSimMap.hpp>
+#include <aliceVision/depthMap/PlaneSweeping.hpp>
 
 namespace aliceVision {
 namespace depthMap {
 
-class PlaneSweepingCuda
+class PlaneSweepingCuda : public PlaneSweeping
 {
 public:
     struct parameters
@@ -47,12 +48,8 @@ public:
         }
     };
 
-    int scales;
     int nbest;
 
-    mvsUtils::MultiViewParams* mp;
-    mvsUtils::PreMatchCams* pc;
-
     int CUDADeviceNo;
     void** ps_texs_arr;
 
@@ -60,7 +57,6 @@ public:
     StaticVector<int>* camsRcs;
     StaticVector<long>* camsTimes;
 
-    bool verbose;
     bool doVizualizePartialDepthMaps;
     int nbestkernelSizeHalf;
 
@@ -71,20 +67,13 @@ public:
     bool subPixel;
     int varianceWSH;
 
-    // float gammaC,gammaP;
-    mvsUtils::ImagesCache* ic;
-
     PlaneSweepingCuda(int _CUDADeviceNo, mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc,
                         int _scales);
-    ~PlaneSweepingCuda(void);
+    ~PlaneSweepingCuda(void) override;
 
     int addCam(int rc, float** H, int scale);
 
-    void getMinMaxdepths(int rc, StaticVector<int>* tcams, float& minDepth, float& midDepth, float& maxDepth);
     void getAverageMinMaxdepths(float& avMinDist, float& avMaxDist);
-    StaticVector<float>* getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth, int scale,
-                                              int step, int maxDepthsHalf = 1024);
-    StaticVector<float>* getDepthsRcTc(int rc, int tc, int scale, float midDepth, int maxDepthsHalf = 1024);
 
     bool refinePixelsAll(bool useTcOrRcPixSize, int ndepthsToRefine, StaticVector<float>* pxsdepths,
                          StaticVector<float>* pxssims, int rc, int wsh, float igammaC, float igammaP,
@@ -92,8 +81,8 @@ public:
     bool refinePixelsAllFine(StaticVector<Color>* pxsnormals, StaticVector<float>* pxsdepths,
                              StaticVector<float>* pxssims, int rc, int wsh, float gammaC, float gammaP,
                              StaticVector<Pixel>* pixels, int scale, StaticVector<int>* tcams, float epipShift = 0.0f);
-    bool smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float igammaP, int wsh);
-    bool filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float minCostThr, int wsh);
+    bool smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float igammaP, int wsh) override;
+    bool filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float minCostThr, int wsh) override;
     bool computeNormalMap(StaticVector<float>* depthMap, StaticVector<Color>* normalMap, int rc, int scale,
                           float igammaC, float igammaP, int wsh);
     void alignSourceDepthMapToTarget(StaticVector<float>* sourceDepthMap, StaticVector<float>* targetDepthMap, int rc,
@@ -109,16 +98,16 @@ public:
                                       int wsh, float gammaC, float gammaP, float epipShift);
     bool refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
                             StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
-                            float gammaP, float epipShift, int xFrom, int wPart);
+                            float gammaP, float epipShift, int xFrom, int wPart) override;
 
     float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
                               int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
                               StaticVector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
                               StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
-                              float epipShift);
+                              float epipShift) override;
     bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
-                              int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1, unsigned char P2);
-    Point3d getDeviceMemoryInfo();
+                              int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1, unsigned char P2) override;
+    Point3d getDeviceMemoryInfo() override;
     bool transposeVolume(StaticVector<unsigned char>* volume, const Voxel& dimIn, const Voxel& dimTrn, Voxel& dimOut);
 
     bool computeRcVolumeForRcTcsDepthSimMaps(StaticVector<unsigned int>* volume,
@@ -139,10 +128,10 @@ public:
 
     bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim> *oDepthSimMap,
                                               const StaticVector<StaticVector<DepthSim> *> *dataMaps, int nSamplesHalf,
-                                              int nDepthsToRefine, float sigma);
+                                              int nDepthsToRefine, float sigma) override;
     bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim> *oDepthSimMap,
-                                            StaticVector<StaticVector<DepthSim> *> *dataMaps, int rc, int nSamplesHalf,
-                                            int nDepthsToRefine, float sigma, int nIters, int yFrom, int hPart);
+                                            StaticVector<StaticVector<DepthSim> *> *dataMaps, int rc, int nIters,
+                                            int yFrom, int hPart) override;
     bool computeDP1Volume(StaticVector<int>* ovolume, StaticVector<unsigned int>* ivolume, int _volDimX, int volDimY,
                           int volDimZ, int xFrom, int xTo);
 
@@ -151,7 +140,7 @@ public:
                                                      bool moveByTcOrRc, float moveStep);
     bool computeRcTcdepthMap(StaticVector<float>* iRcDepthMap_oRcTcDepthMap, StaticVector<float>* tcDdepthMap, int rc,
                              int tc, float pixSizeRatioThr);
-    bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc);
+    bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc) override;
 };
 
 int listCUDADevices(bool verbose);
@@ -169,7 +169,7 @@ __device__ float2 getCellSmoothStepEnergy(const int2& cell0)
 __global__ void fuse_optimizeDepthSimMap_kernel(float2* out_optDepthSimMap, int optDepthSimMap_p,
                                                 float2* midDepthPixSizeMap, int midDepthPixSizeMap_p,
                                                 float2* fusedDepthSimMap, int fusedDepthSimMap_p, int width, int height,
-                                                int iter, float samplesPerPixSize, int yFrom)
+                                                int iter, int yFrom)
 {
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
@@ -323,8 +323,8 @@ __global__ void volume_agregateCostVolumeAtZinSlices_kernel(unsigned int* xySlic
             // unsigned int P1 = (unsigned int)sigmoid(5.0f,20.0f,60.0f,10.0f,deltaC);
             unsigned int P1 = _P1;
             // 15.0 + (255.0 - 15.0) * (1.0 / (1.0 + exp(10.0 * ((x - 20.) / 80.))))
-            unsigned int P2 = (unsigned int)sigmoid(15.0f, 255.0f, 80.0f, 20.0f, deltaC);
-            // unsigned int P2 = _P2;
+            // the color adaptive penalty is capped by the user P2, as in the CPU backend
+            unsigned int P2 = max(_P1, (unsigned int)sigmoid(15.0f, (float)_P2, 80.0f, 20.0f, deltaC));
 
             unsigned int bestCostInColM1 = xSliceBestInColSimForZM1[vx];
             unsigned int pathCostMDM1 = *get2DBufferAt(xySliceForZM1, xySliceForZM1_p, vx, vy - 1); // M1: minus 1 over depths
@@ -2849,15 +2849,12 @@ void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2>* odep
 void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
                                            CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
                                            CudaHostMemoryHeap<float2, 2>** dataMaps_hmh, int ndataMaps,
-                                           int nSamplesHalf, int nDepthsToRefine, int nIters, float sigma,
-                                           cameraStruct** cams, int ncams, int width, int height, int scale,
+                                           int nIters, cameraStruct** cams, int ncams, int width, int height, int scale,
                                            int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose, int yFrom)
 {
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
-    float samplesPerPixSize = (float)(nSamplesHalf / ((nDepthsToRefine - 1) / 2));
-
     ///////////////////////////////////////////////////////////////////////////////
     // setup block and grid
     int block_size = 16;
@@ -2897,7 +2894,7 @@ void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
         fuse_optimizeDepthSimMap_kernel<<<grid, block>>>(optDepthSimMap_dmp.getBuffer(), optDepthSimMap_dmp.stride()[0],
                                                          dataMaps_dmp[0]->getBuffer(), dataMaps_dmp[0]->stride()[0],
                                                          dataMaps_dmp[1]->getBuffer(), dataMaps_dmp[1]->stride()[0],
-                                                         width, height, iter, samplesPerPixSize, yFrom);
+                                                         width, height, iter, yFrom);
         cudaThreadSynchronize();
 
         cudaUnbindTexture(depthsTex);
@@ -0,0 +1,200 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/depthMap/cpu/PlaneSweepingCpu.hpp>
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/imageIO/image.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#define BOOST_TEST_MODULE planeSweepingCpu
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::depthMap;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const int imageWidth = 96;
+const int imageHeight = 64;
+const double focal = 100.0;
+const double baseline = 0.5;
+/// depth of the fronto-parallel textured plane, the disparity is 10 pixels
+const double planeDepth = 5.0;
+/// size of the texture cells on the plane, 4 pixels in the images
+const double cellSize = 0.2;
+
+/// Random value in [0;1] of a texture cell
+float cellValue(int i, int j, int channel)
+{
+    std::uint32_t h = static_cast<std::uint32_t>(i) * 73856093u ^ static_cast<std::uint32_t>(j) * 19349663u ^
+                      static_cast<std::uint32_t>(channel) * 83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return static_cast<float>(h & 0xffff) / 65535.0f;
+}
+
+/// Bilinear value noise texture of the plane, in [0.1;0.9]
+Color texture(double X, double Y)
+{
+    const double u = X / cellSize;
+    const double v = Y / cellSize;
+    const int i = static_cast<int>(std::floor(u));
+    const int j = static_cast<int>(std::floor(v));
+    const float fu = static_cast<float>(u - i);
+    const float fv = static_cast<float>(v - j);
+
+    Color c;
+    for(int k = 0; k < 3; ++k)
+    {
+        const float top = cellValue(i, j, k) * (1.0f - fu) + cellValue(i + 1, j, k) * fu;
+        const float bottom = cellValue(i, j + 1, k) * (1.0f - fu) + cellValue(i + 1, j + 1, k) * fu;
+        c.m[k] = 0.1f + 0.8f * (top * (1.0f - fv) + bottom * fv);
+    }
+    return c;
+}
+
+/**
+ * @brief Two cameras looking along z, the second one translated by the baseline along x,
+ * in front of a textured fronto-parallel plane.
+ * The images are written with the AliceVision:P metadata, with an ini file.
+ */
+std::unique_ptr<mvsUtils::MultiViewParams> createScene(const std::string& folder)
+{
+    bfs::create_directories(folder);
+    {
+        std::ofstream ini((bfs::path(folder) / "mvs.ini").string());
+        ini << "[global]\n"
+            << "ncams=2\n"
+            << "imgExt=exr\n"
+            << "verbose=0\n"
+            << "[imageResolutions]\n"
+            << "0=" << imageWidth << "x" << imageHeight << "\n"
+            << "1=" << imageWidth << "x" << imageHeight << "\n";
+    }
+
+    Matrix3x3 K;
+    K.m11 = focal; K.m12 = 0.0;   K.m13 = imageWidth / 2;
+    K.m21 = 0.0;   K.m22 = focal; K.m23 = imageHeight / 2;
+    K.m31 = 0.0;   K.m32 = 0.0;   K.m33 = 1.0;
+    Matrix3x3 R;
+    R.m11 = 1.0; R.m12 = 0.0; R.m13 = 0.0;
+    R.m21 = 0.0; R.m22 = 1.0; R.m23 = 0.0;
+    R.m31 = 0.0; R.m32 = 0.0; R.m33 = 1.0;
+
+    for(int c = 0; c < 2; ++c)
+    {
+        const double cx = c * baseline;
+        const Matrix3x4 P = K * (R | Point3d(-cx, 0.0, 0.0));
+
+        std::vector<Color> image(imageWidth * imageHeight);
+        for(int y = 0; y < imageHeight; ++y)
+            for(int x = 0; x < imageWidth; ++x)
+                image[y * imageWidth + x] = texture(cx + (x - K.m13) * planeDepth / focal, (y - K.m23) * planeDepth / focal);
+
+        std::vector<double> matrixP(16, 0.0);
+        std::copy_n(P.m, 12, matrixP.begin());
+        matrixP[15] = 1.0;
+        oiio::ParamValueList metadata;
+        metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
+        metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, matrixP.data()));
+        imageIO::writeImage((bfs::path(folder) / (std::to_string(c) + ".exr")).string(), imageWidth, imageHeight,
+                            image, imageIO::EImageQuality::LOSSLESS, metadata);
+    }
+
+    return std::unique_ptr<mvsUtils::MultiViewParams>(new mvsUtils::MultiViewParams((bfs::path(folder) / "mvs.ini").string()));
+}
+
+/**
+ * @brief Ratio of the pixels seen by both cameras whose best depth in the volume is the plane one (up to one step).
+ * The pixels near the image borders, whose patches are not fully inside both images, are ignored.
+ * @param[out] bestDepthsHistogram number of pixels per best depth index
+ */
+float getRatioOfGoodDepths(const StaticVector<unsigned char>& volume, int volDimZ, int planeDepthId, int border,
+                           std::vector<int>& bestDepthsHistogram)
+{
+    const int disparity = static_cast<int>(focal * baseline / planeDepth);
+    const int depthStride = imageWidth * imageHeight;
+    bestDepthsHistogram.assign(volDimZ, 0);
+    int nbPixels = 0;
+    int nbGood = 0;
+    for(int y = border; y < imageHeight - border; ++y)
+    {
+        for(int x = border + disparity; x < imageWidth - border; ++x)
+        {
+            const int pixelId = y * imageWidth + x;
+            int bestZ = 0;
+            for(int z = 1; z < volDimZ; ++z)
+                if(volume[z * depthStride + pixelId] < volume[bestZ * depthStride + pixelId])
+                    bestZ = z;
+            ++bestDepthsHistogram[bestZ];
+            ++nbPixels;
+            if(std::abs(bestZ - planeDepthId) <= 1)
+                ++nbGood;
+        }
+    }
+    return static_cast<float>(nbGood) / static_cast<float>(nbPixels);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_frontoParallelPlane)
+{
+    const std::unique_ptr<mvsUtils::MultiViewParams> mp = createScene("planeSweepingCpu_test");
+    mvsUtils::ImagesCache ic(mp.get(), 0);
+    PlaneSweepingCpu ps(&ic, mp.get(), nullptr, 1);
+
+    // depths of the disparities from 20 to 4 pixels by half pixel, the plane depth is sampled
+    const int planeDepthId = 20;
+    StaticVector<float> depths;
+    for(int i = 0; i <= 32; ++i)
+        depths.push_back(static_cast<float>(focal * baseline / (20.0 - i * 0.5)));
+
+    const int volDimZ = depths.size();
+    const int wsh = 4;
+    StaticVector<Voxel> pixels;
+    for(int y = 0; y < imageHeight; ++y)
+        for(int x = 0; x < imageWidth; ++x)
+            pixels.push_back(Voxel(x, y, 0));
+    StaticVector<int> tcams;
+    tcams.push_back(1);
+
+    StaticVector<unsigned char> simVolume;
+    simVolume.resize_with(imageWidth * imageHeight * volDimZ, 255);
+    ps.sweepPixelsToVolume(volDimZ, &simVolume, imageWidth, imageHeight, volDimZ, 1, 0, 0, 0, &depths, 0, wsh, 5.5f,
+                           8.0f, &pixels, 1, 1, &tcams, 0.0f);
+
+    // with the color weighted patches, the similarity alone is noisy but the plane is its most frequent best depth
+    const int border = 2 * wsh;
+    std::vector<int> histogram;
+    const float simRatio = getRatioOfGoodDepths(simVolume, volDimZ, planeDepthId, border, histogram);
+    BOOST_CHECK_EQUAL(std::max_element(histogram.begin(), histogram.end()) - histogram.begin(), planeDepthId);
+
+    // the SGM finds the plane with the default penalties and with a P2 under the color adaptive one
+    for(const unsigned char P2 : {125, 40})
+    {
+        StaticVector<unsigned char> volume = simVolume;
+        BOOST_REQUIRE(ps.SGMoptimizeSimVolume(0, &volume, imageWidth, imageHeight, volDimZ, 1, 0, 0, 1, 10, P2));
+        const float sgmRatio = getRatioOfGoodDepths(volume, volDimZ, planeDepthId, border, histogram);
+        BOOST_CHECK_GT(sgmRatio, simRatio);
+        BOOST_CHECK_GT(sgmRatio, 0.95f);
+    }
+
+    bfs::remove_all("planeSweepingCpu_test");
+}
@@ -66,6 +66,28 @@ public:
   virtual void LoadFeatures(
     const std::string& sfileNameFeats) = 0;
 
+  //--
+  // Raw IO - used by the binary regions container
+  //--
+
+  /// Size in bytes of one region feature
+  virtual std::size_t FeatureByteSize() const = 0;
+
+  /// Size in bytes of one region descriptor
+  virtual std::size_t DescriptorByteSize() const = 0;
+
+  /// Return a pointer to the first value of the features array
+  virtual const void* FeaturesRawData() const = 0;
+
+  /**
+   * @brief Replace the regions by a copy of raw contiguous arrays.
+   * @param[in] count number of regions
+   * @param[in] featuresData count features of FeatureByteSize() bytes
+   * @param[in] descriptorsData count descriptors of DescriptorByteSize() bytes,
+   *            nullptr to load only the features
+   */
+  virtual void LoadRawData(std::size_t count, const void* featuresData, const void* descriptorsData) = 0;
+
   //--
   //- Basic description of a descriptor [Type, Length]
   //--
@@ -149,6 +171,10 @@ public:
     return Vec2f(_vec_feats[i].coords()).cast<double>();
   }
 
+  std::size_t FeatureByteSize() const { return sizeof(FeatureT); }
+
+  const void* FeaturesRawData() const { return _vec_feats.data(); }
+
   /// Return the number of defined regions
   std::size_t RegionCount() const {return _vec_feats.size();}
 
@@ -247,6 +273,22 @@ public:
 
   inline const void* DescriptorRawData() const override { return &_vec_descs[0];}
 
+  std::size_t DescriptorByteSize() const override { return sizeof(DescriptorT); }
+
+  void LoadRawData(std::size_t count, const void* featuresData, const void* descriptorsData) override
+  {
+    const FeatT* feats = static_cast<const FeatT*>(featuresData);
+    this->_vec_feats.assign(feats, feats + count);
+
+    if(descriptorsData == nullptr)
+    {
+      _vec_descs.clear();
+      return;
+    }
+    const DescriptorT* descs = static_cast<const DescriptorT*>(descriptorsData);
+    _vec_descs.assign(descs, descs + count);
+  }
+
   inline void clearDescriptors() override { _vec_descs.clear(); }
 
   inline void swap(This& other)
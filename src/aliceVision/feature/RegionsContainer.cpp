@@ -0,0 +1,236 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "RegionsContainer.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+const char REGIONS_CONTAINER_MAGIC[8] = {'A', 'V', 'R', 'E', 'G', 'C', 'N', 'T'};
+
+/// magic, version, number of entries, offset of the entries table
+const std::uint64_t REGIONS_CONTAINER_HEADER_SIZE = 8 + 4 + 4 + 8;
+
+/// viewId, describerType, count, featureByteSize, descriptorByteSize, featuresOffset, descriptorsOffset
+const std::uint64_t REGIONS_CONTAINER_ENTRY_SIZE = 4 + 4 + 8 + 4 + 4 + 8 + 8;
+
+template<typename T>
+void writeValue(std::ostream& stream, const T& value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T readValue(const char*& data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  data += sizeof(T);
+  return value;
+}
+
+} // namespace
+
+RegionsContainerWriter::RegionsContainerWriter(const std::string& filepath)
+  : _filepath(filepath)
+  , _stream(filepath, std::ios::binary | std::ios::trunc)
+{
+  if(!_stream.is_open())
+    throw std::runtime_error("Can't create regions container file '" + filepath + "'.");
+
+  // header placeholder, updated by close()
+  const std::string header(REGIONS_CONTAINER_HEADER_SIZE, '\0');
+  _stream.write(header.data(), header.size());
+  writePadding();
+}
+
+RegionsContainerWriter::~RegionsContainerWriter()
+{
+  try
+  {
+    close();
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR(e.what());
+  }
+}
+
+void RegionsContainerWriter::writePadding()
+{
+  const std::uint64_t position = _stream.tellp();
+  const std::uint64_t padding = (REGIONS_CONTAINER_ALIGNMENT - position % REGIONS_CONTAINER_ALIGNMENT) % REGIONS_CONTAINER_ALIGNMENT;
+  const std::string zeros(padding, '\0');
+  _stream.write(zeros.data(), zeros.size());
+}
+
+void RegionsContainerWriter::add(IndexT viewId, EImageDescriberType describerType, const Regions& regions)
+{
+  RegionsContainerEntry entry;
+  entry.viewId = viewId;
+  entry.describerType = static_cast<std::uint32_t>(describerType);
+  entry.count = regions.RegionCount();
+  entry.featureByteSize = regions.FeatureByteSize();
+  entry.descriptorByteSize = regions.DescriptorByteSize();
+
+  const std::uint64_t featuresSize = entry.count * entry.featureByteSize;
+  const std::uint64_t descriptorsSize = entry.count * entry.descriptorByteSize;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if(!_stream.is_open())
+    throw std::runtime_error("Can't add regions to the closed regions container file '" + _filepath + "'.");
+
+  entry.featuresOffset = _stream.tellp();
+  if(featuresSize > 0)
+    _stream.write(static_cast<const char*>(regions.FeaturesRawData()), featuresSize);
+  writePadding();
+
+  entry.descriptorsOffset = _stream.tellp();
+  if(descriptorsSize > 0)
+    _stream.write(static_cast<const char*>(regions.DescriptorRawData()), descriptorsSize);
+  writePadding();
+
+  if(!_stream.good())
+    throw std::runtime_error("Can't write regions of the view " + std::to_string(viewId) + " in the regions container file '" + _filepath + "'.");
+
+  _entries.push_back(entry);
+}
+
+void RegionsContainerWriter::close()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if(!_stream.is_open())
+    return;
+
+  const std::uint64_t entriesOffset = _stream.tellp();
+  for(const RegionsContainerEntry& entry : _entries)
+  {
+    writeValue(_stream, entry.viewId);
+    writeValue(_stream, entry.describerType);
+    writeValue(_stream, entry.count);
+    writeValue(_stream, entry.featureByteSize);
+    writeValue(_stream, entry.descriptorByteSize);
+    writeValue(_stream, entry.featuresOffset);
+    writeValue(_stream, entry.descriptorsOffset);
+  }
+
+  // write the header
+  _stream.seekp(0);
+  _stream.write(REGIONS_CONTAINER_MAGIC, sizeof(REGIONS_CONTAINER_MAGIC));
+  writeValue(_stream, REGIONS_CONTAINER_VERSION);
+  writeValue(_stream, static_cast<std::uint32_t>(_entries.size()));
+  writeValue(_stream, entriesOffset);
+
+  const bool good = _stream.good();
+  _stream.close();
+
+  if(!good)
+    throw std::runtime_error("Can't write the regions container file '" + _filepath + "'.");
+}
+
+RegionsContainerReader::RegionsContainerReader(const std::string& filepath)
+  : _filepath(filepath)
+{
+  try
+  {
+    _file = boost::interprocess::file_mapping(filepath.c_str(), boost::interprocess::read_only);
+    _region = boost::interprocess::mapped_region(_file, boost::interprocess::read_only);
+  }
+  catch(const boost::interprocess::interprocess_exception& e)
+  {
+    throw std::runtime_error("Can't map regions container file '" + filepath + "': " + e.what());
+  }
+
+  const char* begin = static_cast<const char*>(_region.get_address());
+  const std::uint64_t fileSize = _region.get_size();
+
+  if(fileSize < REGIONS_CONTAINER_HEADER_SIZE || std::memcmp(begin, REGIONS_CONTAINER_MAGIC, sizeof(REGIONS_CONTAINER_MAGIC)) != 0)
+    throw std::runtime_error("Invalid regions container file '" + filepath + "'.");
+
+  const char* data = begin + sizeof(REGIONS_CONTAINER_MAGIC);
+  const std::uint32_t version = readValue<std::uint32_t>(data);
+  const std::uint32_t nbEntries = readValue<std::uint32_t>(data);
+  const std::uint64_t entriesOffset = readValue<std::uint64_t>(data);
+
+  if(version != REGIONS_CONTAINER_VERSION)
+    throw std::runtime_error("Unsupported regions container version " + std::to_string(version) + " in file '" + filepath + "'.");
+
+  if(entriesOffset > fileSize || nbEntries * REGIONS_CONTAINER_ENTRY_SIZE > fileSize - entriesOffset)
+    throw std::runtime_error("Invalid regions container file '" + filepath + "', the file is truncated.");
+
+  data = begin + entriesOffset;
+  for(std::uint32_t i = 0; i < nbEntries; ++i)
+  {
+    RegionsContainerEntry entry;
+    entry.viewId = readValue<std::uint32_t>(data);
+    entry.describerType = readValue<std::uint32_t>(data);
+    entry.count = readValue<std::uint64_t>(data);
+    entry.featureByteSize = readValue<std::uint32_t>(data);
+    entry.descriptorByteSize = readValue<std::uint32_t>(data);
+    entry.featuresOffset = readValue<std::uint64_t>(data);
+    entry.descriptorsOffset = readValue<std::uint64_t>(data);
+
+    if(entry.featuresOffset + entry.count * entry.featureByteSize > fileSize ||
+       entry.descriptorsOffset + entry.count * entry.descriptorByteSize > fileSize)
+      throw std::runtime_error("Invalid regions container file '" + filepath + "', the regions of the view " + std::to_string(entry.viewId) + " are truncated.");
+
+    _entries[std::make_pair(static_cast<IndexT>(entry.viewId), static_cast<EImageDescriberType>(entry.describerType))] = entry;
+  }
+}
+
+bool RegionsContainerReader::hasRegions(IndexT viewId, EImageDescriberType describerType) const
+{
+  return _entries.count(std::make_pair(viewId, describerType)) > 0;
+}
+
+std::set<IndexT> RegionsContainerReader::getViewIds() const
+{
+  std::set<IndexT> viewIds;
+  for(const auto& entry : _entries)
+    viewIds.insert(entry.first.first);
+  return viewIds;
+}
+
+const RegionsContainerEntry& RegionsContainerReader::getEntry(IndexT viewId, EImageDescriberType describerType) const
+{
+  const auto it = _entries.find(std::make_pair(viewId, describerType));
+  if(it == _entries.end())
+    throw std::out_of_range("No " + EImageDescriberType_enumToString(describerType) + " regions for the view " + std::to_string(viewId) + " in the regions container file '" + _filepath + "'.");
+  return it->second;
+}
+
+const void* RegionsContainerReader::getFeaturesData(IndexT viewId, EImageDescriberType describerType) const
+{
+  return static_cast<const char*>(_region.get_address()) + getEntry(viewId, describerType).featuresOffset;
+}
+
+const void* RegionsContainerReader::getDescriptorsData(IndexT viewId, EImageDescriberType describerType) const
+{
+  return static_cast<const char*>(_region.get_address()) + getEntry(viewId, describerType).descriptorsOffset;
+}
+
+void RegionsContainerReader::load(IndexT viewId, EImageDescriberType describerType, Regions& regions, bool loadDescriptors) const
+{
+  const RegionsContainerEntry& entry = getEntry(viewId, describerType);
+
+  if(entry.featureByteSize != regions.FeatureByteSize() ||
+     (loadDescriptors && entry.descriptorByteSize != regions.DescriptorByteSize()))
+    throw std::runtime_error("Incompatible " + EImageDescriberType_enumToString(describerType) + " regions for the view " + std::to_string(viewId) + " in the regions container file '" + _filepath + "'.");
+
+  const char* begin = static_cast<const char*>(_region.get_address());
+  regions.LoadRawData(entry.count, begin + entry.featuresOffset, loadDescriptors ? begin + entry.descriptorsOffset : nullptr);
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,171 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/feature/Regions.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Binary container of the regions (features and descriptors) of many views.
+ *
+ * File layout (native endianness):
+ * - header: magic "AVREGCNT", version, number of entries, offset of the entries table
+ * - data: for each (view, describer type) the features array followed by the descriptors array,
+ *         each array aligned on REGIONS_CONTAINER_ALIGNMENT bytes
+ * - entries table: for each (view, describer type) the number of regions, the byte size of
+ *   one feature and one descriptor and the offsets of the arrays
+ *
+ * The arrays are the raw memory of the Regions containers, so they are read without any parsing
+ * and the file can be memory-mapped: only the pages of the requested views are read from disk.
+ */
+
+/// Extension of the regions container files
+const std::string REGIONS_CONTAINER_EXTENSION = ".regions";
+
+/// Current version of the regions container file format
+const std::uint32_t REGIONS_CONTAINER_VERSION = 1;
+
+/// Alignment in bytes of the arrays in the regions container file
+const std::uint64_t REGIONS_CONTAINER_ALIGNMENT = 64;
+
+/**
+ * @brief Entry of the regions container table
+ */
+struct RegionsContainerEntry
+{
+  std::uint32_t viewId = 0;
+  std::uint32_t describerType = 0;
+  std::uint64_t count = 0;
+  std::uint32_t featureByteSize = 0;
+  std::uint32_t descriptorByteSize = 0;
+  std::uint64_t featuresOffset = 0;
+  std::uint64_t descriptorsOffset = 0;
+};
+
+/**
+ * @brief Write the regions of many views in a single regions container file.
+ *
+ * The regions are streamed to the file when they are added,
+ * the entries table is written by close().
+ * add() can be called from several threads.
+ */
+class RegionsContainerWriter
+{
+public:
+  /**
+   * @brief Create the regions container file
+   * @param[in] filepath the container file path (*.regions)
+   */
+  explicit RegionsContainerWriter(const std::string& filepath);
+
+  /// Close the file if not already done
+  ~RegionsContainerWriter();
+
+  /**
+   * @brief Append the regions (features and descriptors) of a view
+   * @param[in] viewId the view id
+   * @param[in] describerType the regions describer type
+   * @param[in] regions the regions
+   */
+  void add(IndexT viewId, EImageDescriberType describerType, const Regions& regions);
+
+  /**
+   * @brief Write the entries table and close the file
+   */
+  void close();
+
+private:
+  void writePadding();
+
+  std::string _filepath;
+  std::ofstream _stream;
+  std::vector<RegionsContainerEntry> _entries;
+  std::mutex _mutex;
+};
+
+/**
+ * @brief Read the regions of a regions container file through a memory mapping.
+ *
+ * Only the header and the entries table are read when the container is opened,
+ * the regions of a view are only read when they are requested.
+ * The reader can be used from several threads.
+ */
+class RegionsContainerReader
+{
+public:
+  /**
+   * @brief Open and map a regions container file
+   * @param[in] filepath the container file path (*.regions)
+   */
+  explicit RegionsContainerReader(const std::string& filepath);
+
+  /**
+   * @brief Return true if the container has the regions of the given view and describer type
+   */
+  bool hasRegions(IndexT viewId, EImageDescriberType describerType) const;
+
+  /**
+   * @brief Get the ids of the views stored in the container
+   */
+  std::set<IndexT> getViewIds() const;
+
+  /**
+   * @brief Get the container entry of the given view and describer type
+   * @throw std::out_of_range if the container doesn't have the regions
+   */
+  const RegionsContainerEntry& getEntry(IndexT viewId, EImageDescriberType describerType) const;
+
+  /**
+   * @brief Get a pointer to the features array of the given view in the mapped file (no copy).
+   * The pointer is valid during the lifetime of the reader.
+   */
+  const void* getFeaturesData(IndexT viewId, EImageDescriberType describerType) const;
+
+  /**
+   * @brief Get a pointer to the descriptors array of the given view in the mapped file (no copy).
+   * The pointer is valid during the lifetime of the reader.
+   */
+  const void* getDescriptorsData(IndexT viewId, EImageDescriberType describerType) const;
+
+  /**
+   * @brief Load the regions of the given view.
+   * @param[in] viewId the view id
+   * @param[in] describerType the regions describer type
+   * @param[out] regions allocated regions of the describer type
+   * @param[in] loadDescriptors if false, only the features are loaded
+   */
+  void load(IndexT viewId, EImageDescriberType describerType, Regions& regions, bool loadDescriptors = true) const;
+
+  const std::string& getFilepath() const
+  {
+    return _filepath;
+  }
+
+private:
+  std::string _filepath;
+  boost::interprocess::file_mapping _file;
+  boost::interprocess::mapped_region _region;
+  std::map<std::pair<IndexT, EImageDescriberType>, RegionsContainerEntry> _entries;
+};
+
+} // namespace feature
+} // namespace aliceVision
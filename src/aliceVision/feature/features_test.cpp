@@ -6,7 +6,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/feature/feature.hpp"
+#include "aliceVision/feature/RegionsContainer.hpp"
+#include "aliceVision/feature/sift/ImageDescriber_SIFT_vlfeat.hpp"
 
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <iterator>
@@ -122,3 +126,120 @@ BOOST_AUTO_TEST_CASE(descriptorIO_BINARY) {
       BOOST_CHECK_EQUAL(vec_descs[i][j], vec_descs_read[i][j]);
   }
 }
+
+//Test the binary regions container
+BOOST_AUTO_TEST_CASE(regionsContainer_BINARY) {
+  const std::string filename = "tempRegions" + REGIONS_CONTAINER_EXTENSION;
+  const int nbViews = 5;
+
+  // Create the regions of several views with a different number of regions
+  std::vector<SIFT_Regions> regionsPerView(nbViews);
+  for(int v = 0; v < nbViews; ++v)
+  {
+    for(int i = 0; i < CARD * v; ++i)
+    {
+      regionsPerView[v].Features().push_back(SIOPointFeature(v, i, i*2, i*3));
+      SIFT_Regions::DescriptorT desc;
+      for(int j = 0; j < 128; ++j)
+        desc[j] = (v + i + j) % 256;
+      regionsPerView[v].Descriptors().push_back(desc);
+    }
+  }
+
+  {
+    RegionsContainerWriter writer(filename);
+    for(int v = 0; v < nbViews; ++v)
+      BOOST_CHECK_NO_THROW(writer.add(v * 10, EImageDescriberType::SIFT, regionsPerView[v]));
+    BOOST_CHECK_NO_THROW(writer.close());
+  }
+
+  RegionsContainerReader reader(filename);
+  BOOST_CHECK_EQUAL(reader.getViewIds().size(), nbViews);
+  BOOST_CHECK(!reader.hasRegions(1, EImageDescriberType::SIFT));
+  BOOST_CHECK(!reader.hasRegions(10, EImageDescriberType::AKAZE));
+
+  // Read the views in reverse order
+  for(int v = nbViews - 1; v >= 0; --v)
+  {
+    BOOST_CHECK(reader.hasRegions(v * 10, EImageDescriberType::SIFT));
+
+    SIFT_Regions regions;
+    BOOST_CHECK_NO_THROW(reader.load(v * 10, EImageDescriberType::SIFT, regions));
+    BOOST_CHECK_EQUAL(regions.RegionCount(), regionsPerView[v].RegionCount());
+    BOOST_CHECK_EQUAL(regions.Descriptors().size(), regionsPerView[v].Descriptors().size());
+    for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+    {
+      BOOST_CHECK_EQUAL(regions.Features()[i], regionsPerView[v].Features()[i]);
+      BOOST_CHECK(regions.Descriptors()[i] == regionsPerView[v].Descriptors()[i]);
+    }
+
+    // Load only the features
+    SIFT_Regions features;
+    BOOST_CHECK_NO_THROW(reader.load(v * 10, EImageDescriberType::SIFT, features, false));
+    BOOST_CHECK_EQUAL(features.RegionCount(), regionsPerView[v].RegionCount());
+    BOOST_CHECK(features.Descriptors().empty());
+  }
+
+  // Incompatible regions type
+  SIFT_Float_Regions floatRegions;
+  BOOST_CHECK_THROW(reader.load(10, EImageDescriberType::SIFT, floatRegions), std::runtime_error);
+  BOOST_CHECK_THROW(reader.load(1, EImageDescriberType::SIFT, floatRegions), std::out_of_range);
+
+  // Non-existing and invalid files
+  BOOST_CHECK_THROW(RegionsContainerReader("x" + REGIONS_CONTAINER_EXTENSION), std::runtime_error);
+  BOOST_CHECK_THROW(RegionsContainerReader("tempDescsBin.desc"), std::runtime_error);
+}
+
+/**
+ * @brief Generate an image of gaussian blobs with a random position and size.
+ */
+static void generateBlobsImage(int width, int height, int nbBlobs, image::Image<float>& image)
+{
+  image.resize(width, height, true, 0.f);
+  std::srand(width * height);
+  for(int b = 0; b < nbBlobs; ++b)
+  {
+    const double cx = std::rand() % width;
+    const double cy = std::rand() % height;
+    const double sigma = 2.0 + std::rand() % 8;
+    const float value = (std::rand() % 2) ? 1.f : -1.f;
+    for(int y = 0; y < height; ++y)
+      for(int x = 0; x < width; ++x)
+        image(y, x) += value * std::exp(-((x - cx) * (x - cx) + (y - cy) * (y - cy)) / (2.0 * sigma * sigma));
+  }
+}
+
+//Test that a reused SIFT extractor gives the same regions as a new one
+BOOST_AUTO_TEST_CASE(siftExtractor_REUSE) {
+  image::Image<float> image, otherImage;
+  generateBlobsImage(320, 240, 80, image);
+  generateBlobsImage(200, 280, 40, otherImage);
+
+  const SiftParams params(0, 6, 3, 10.0f, 0.01f, 0, 0);
+
+  // the describer keeps its extractors from one image to another
+  ImageDescriber_SIFT_vlfeat describer(params);
+  std::unique_ptr<Regions> regionsFirst, regionsOther, regionsReused, regionsNew;
+  BOOST_CHECK(describer.describe(image, regionsFirst));
+  BOOST_CHECK(describer.describe(otherImage, regionsOther));
+  BOOST_CHECK(describer.describe(image, regionsReused));
+  BOOST_CHECK(extractSIFT<unsigned char>(image, regionsNew, params, true, nullptr));
+
+  const SIFT_Regions& first = dynamic_cast<const SIFT_Regions&>(*regionsFirst);
+  BOOST_CHECK(first.RegionCount() > 0);
+  BOOST_CHECK(regionsOther->RegionCount() > 0);
+
+  for(const Regions* regionsPtr : {regionsReused.get(), regionsNew.get()})
+  {
+    const SIFT_Regions& regions = dynamic_cast<const SIFT_Regions&>(*regionsPtr);
+    BOOST_CHECK_EQUAL(regions.RegionCount(), first.RegionCount());
+    if(regions.RegionCount() != first.RegionCount())
+      continue;
+
+    for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+    {
+      BOOST_CHECK_EQUAL(regions.Features()[i], first.Features()[i]);
+      BOOST_CHECK(regions.Descriptors()[i] == first.Descriptors()[i]);
+    }
+  }
+}
@@ -111,7 +111,11 @@ public:
     std::unique_ptr<Regions>& regions,
     const image::Image<unsigned char>* mask = NULL) override
   {
-    return extractSIFT<float>(image, regions, _params, _isOriented, mask);
+    // the extractors are reused by the next images, even if describe is called concurrently
+    std::unique_ptr<SiftExtractor> extractor = _extractorPool.acquire();
+    const bool ok = extractSIFT<float>(image, regions, _params, _isOriented, mask, *extractor);
+    _extractorPool.release(std::move(extractor));
+    return ok;
   }
 
   /**
@@ -126,6 +130,7 @@ public:
 private:
   SiftParams _params;
   bool _isOriented;
+  SiftExtractorPool _extractorPool;
 };
 
 } // namespace feature
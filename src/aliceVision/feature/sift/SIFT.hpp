@@ -10,6 +10,7 @@
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
 #include <aliceVision/feature/regionsFactory.hpp>
+#include <aliceVision/feature/sift/SiftExtractor.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 
@@ -185,7 +186,10 @@ inline std::size_t getMemoryConsumptionVLFeat(std::size_t width, std::size_t hei
   }
   pyramidMemoryConsuption *= params._numScales * sizeof(float);
 
-  return 4 * pyramidMemoryConsuption + (3 * width * height * sizeof(float)) + (params._maxTotalKeypoints * 128 * sizeof(float));
+  // second gradient buffer of the SiftExtractor, to describe an octave while the next one is computed
+  const std::size_t spareGradientMemoryConsumption = 2 * (params._numScales + 2) * fullImgSize * sizeof(float);
+
+  return 4 * pyramidMemoryConsuption + spareGradientMemoryConsumption + (3 * width * height * sizeof(float)) + (params._maxTotalKeypoints * 128 * sizeof(float));
 }
 
 /**
@@ -196,6 +200,7 @@ inline std::size_t getMemoryConsumptionVLFeat(std::size_t width, std::size_t hei
  * @param params
  * @param orientation
  * @param mask
+ * @param extractor The extraction engine, its filter and buffers are reused from one image to another
  * @return
  */
 template <typename T>
@@ -203,81 +208,28 @@ bool extractSIFT(const image::Image<float>& image,
     std::unique_ptr<Regions>& regions,
     const SiftParams& params,
     bool orientation,
-    const image::Image<unsigned char>* mask)
+    const image::Image<unsigned char>* mask,
+    SiftExtractor& extractor)
 {
   const int w = image.Width(), h = image.Height();
-  VlSiftFilt *filt = vl_sift_new(w, h, params._numOctaves, params._numScales, params._firstOctave);
-  if (params._edgeThreshold >= 0)
-    vl_sift_set_edge_thresh(filt, params._edgeThreshold);
-  if (params._peakThreshold >= 0)
-    vl_sift_set_peak_thresh(filt, params._peakThreshold/params._numScales);
-
-  Descriptor<vl_sift_pix, 128> vlFeatDescriptor;
-  Descriptor<T, 128> descriptor;
 
   // Process SIFT computation
-  vl_sift_process_first_octave(filt, image.data());
+  extractor.extract(image, params, orientation, mask);
+
+  const std::vector<SIOPointFeature>& extractedFeatures = extractor.getFeatures();
+  const std::vector<vl_sift_pix>& extractedDescriptors = extractor.getDescriptors();
 
   typedef ScalarRegions<SIOPointFeature,T,128> SIFT_Region_T;
   regions.reset( new SIFT_Region_T );
-  
+
   // Build alias to cached data
   SIFT_Region_T * regionsCasted = dynamic_cast<SIFT_Region_T*>(regions.get());
-  // reserve some memory for faster keypoint saving
-  const std::size_t reserveSize = (params._gridSize && params._maxTotalKeypoints) ? params._maxTotalKeypoints : 2000;
-  regionsCasted->Features().reserve(reserveSize);
-  regionsCasted->Descriptors().reserve(reserveSize);
-
-  while (true)
-  {
-    vl_sift_detect(filt);
-
-    VlSiftKeypoint const *keys  = vl_sift_get_keypoints(filt);
-    const int nkeys = vl_sift_get_nkeypoints(filt);
-
-    // Update gradient before launching parallel extraction
-    vl_sift_update_gradient(filt);
-
-    #pragma omp parallel for private(vlFeatDescriptor, descriptor)
-    for (int i = 0; i < nkeys; ++i)
-    {
-
-      // Feature masking
-      if (mask)
-      {
-        const image::Image<unsigned char> & maskIma = *mask;
-        if (maskIma(keys[i].y, keys[i].x) > 0)
-          continue;
-      }
-
-      double angles [4] = {0.0, 0.0, 0.0, 0.0};
-      int nangles = 1; // by default (1 upright feature)
-      if (orientation)
-      { // compute from 1 to 4 orientations
-        nangles = vl_sift_calc_keypoint_orientations(filt, angles, keys+i);
-      }
-
-      for (int q=0 ; q < nangles ; ++q)
-      {
-        vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptor[0], keys+i, angles[q]);
-        const SIOPointFeature fp(keys[i].x, keys[i].y,
-          keys[i].sigma, static_cast<float>(angles[q]));
+  regionsCasted->Features() = extractedFeatures;
+  regionsCasted->Descriptors().resize(extractedFeatures.size());
 
-        convertSIFT<T>(&vlFeatDescriptor[0], descriptor, params._rootSift);
-        
-        #pragma omp critical
-        {
-          regionsCasted->Descriptors().push_back(descriptor);
-          regionsCasted->Features().push_back(fp);
-        }
-        
-      }
-    }
-    
-    if (vl_sift_process_next_octave(filt))
-      break; // Last octave
-  }
-  vl_sift_delete(filt);
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(extractedFeatures.size()); ++i)
+    convertSIFT<T>(&extractedDescriptors[i * 128], regionsCasted->Descriptors()[i], params._rootSift);
 
   const auto& features = regionsCasted->Features();
   const auto& descriptors = regionsCasted->Descriptors();
@@ -361,6 +313,21 @@ bool extractSIFT(const image::Image<float>& image,
   return true;
 }
 
+/**
+ * @brief Extract SIFT regions (in float or unsigned char) with a new extraction engine.
+ * @see extractSIFT
+ */
+template <typename T>
+bool extractSIFT(const image::Image<float>& image,
+    std::unique_ptr<Regions>& regions,
+    const SiftParams& params,
+    bool orientation,
+    const image::Image<unsigned char>* mask)
+{
+  SiftExtractor extractor;
+  return extractSIFT<T>(image, regions, params, orientation, mask, extractor);
+}
+
 } //namespace aliceVision
 } //namespace feature
 
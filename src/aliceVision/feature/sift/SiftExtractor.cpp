@@ -0,0 +1,235 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "SiftExtractor.hpp"
+#include <aliceVision/feature/sift/SIFT.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+/// number of keypoints described by a thread at once
+const int keypointsPerBlock = 32;
+
+const std::size_t descriptorSize = 128;
+
+} // namespace
+
+SiftExtractor::~SiftExtractor()
+{
+  releaseFilter();
+}
+
+void SiftExtractor::extract(const image::Image<float>& image,
+                            const SiftParams& params,
+                            bool orientation,
+                            const image::Image<unsigned char>* mask)
+{
+  _features.clear();
+  _descriptors.clear();
+  _blocks.clear();
+
+  const int nbThreads = omp_get_max_threads();
+  if(_threadBuffers.size() < static_cast<std::size_t>(nbThreads))
+    _threadBuffers.resize(nbThreads);
+
+  // keep the capacity of the buffers for the next images
+  for(ThreadBuffer& buffer : _threadBuffers)
+  {
+    buffer.features.clear();
+    buffer.descriptors.clear();
+  }
+
+  initFilter(image.Width(), image.Height(), params);
+
+  VlSiftFilt* filter = _filter;
+  vl_sift_set_edge_thresh(filter, (params._edgeThreshold >= 0) ? params._edgeThreshold : 10.0);
+  vl_sift_set_peak_thresh(filter, (params._peakThreshold >= 0) ? params._peakThreshold / params._numScales : 0.0);
+  // the gradient of a reused filter is not valid for this image
+  filter->grad_o = filter->o_min - 1;
+
+  if(vl_sift_process_first_octave(filter, image.data()) == VL_ERR_EOF)
+    return;
+
+  vl_sift_detect(filter);
+  vl_sift_update_gradient(filter);
+
+  bool hasNextOctave = true;
+  while(hasNextOctave)
+  {
+    // the keypoints buffer of the filter is overwritten by the detection of the next octave
+    const VlSiftKeypoint* keys = vl_sift_get_keypoints(filter);
+    _keypoints.assign(keys, keys + vl_sift_get_nkeypoints(filter));
+
+    // the current octave is described from a copy of the filter state,
+    // the filter computes the gradient of the next octave in the other buffer
+    VlSiftFilt octaveFilter = *filter;
+    std::swap(filter->grad, _spareGradient);
+
+    const int nbBlocks = (static_cast<int>(_keypoints.size()) + keypointsPerBlock - 1) / keypointsPerBlock;
+    const std::size_t firstBlock = _blocks.size();
+    _blocks.resize(firstBlock + nbBlocks);
+
+    #pragma omp parallel num_threads(nbThreads)
+    {
+      #pragma omp single nowait
+      {
+        hasNextOctave = (vl_sift_process_next_octave(filter) != VL_ERR_EOF);
+        if(hasNextOctave)
+        {
+          vl_sift_detect(filter);
+          vl_sift_update_gradient(filter);
+        }
+      }
+
+      describeKeypoints(octaveFilter, orientation, mask, nbBlocks, firstBlock);
+    }
+  }
+
+  mergeThreadBuffers();
+}
+
+void SiftExtractor::initFilter(int width, int height, const SiftParams& params)
+{
+  if(_filter != nullptr &&
+     _filter->width == width &&
+     _filter->height == height &&
+     _filter->S == params._numScales &&
+     _filter->o_min == params._firstOctave &&
+     _numOctaves == params._numOctaves)
+    return;
+
+  releaseFilter();
+
+  _filter = vl_sift_new(width, height, params._numOctaves, params._numScales, params._firstOctave);
+  _numOctaves = params._numOctaves;
+
+  if(_filter != nullptr)
+  {
+    // same size as the gradient buffer allocated by vl_sift_new
+    const std::size_t octaveSize = static_cast<std::size_t>(VL_SHIFT_LEFT(width, -_filter->o_min)) * VL_SHIFT_LEFT(height, -_filter->o_min);
+    _spareGradient = static_cast<vl_sift_pix*>(vl_malloc(sizeof(vl_sift_pix) * octaveSize * 2 * (_filter->s_max - _filter->s_min)));
+  }
+
+  if(_filter == nullptr || _spareGradient == nullptr)
+  {
+    releaseFilter();
+    throw std::runtime_error("Unable to allocate the SIFT filter.");
+  }
+}
+
+void SiftExtractor::releaseFilter()
+{
+  if(_filter != nullptr)
+    vl_sift_delete(_filter);
+  if(_spareGradient != nullptr)
+    vl_free(_spareGradient);
+  _filter = nullptr;
+  _spareGradient = nullptr;
+}
+
+void SiftExtractor::describeKeypoints(VlSiftFilt& octaveFilter,
+                                      bool orientation,
+                                      const image::Image<unsigned char>* mask,
+                                      int nbBlocks,
+                                      std::size_t firstBlock)
+{
+  // the gradient is already computed: octaveFilter is only read by VLFeat
+  #pragma omp for schedule(dynamic)
+  for(int b = 0; b < nbBlocks; ++b)
+  {
+    const int thread = omp_get_thread_num();
+    ThreadBuffer& buffer = _threadBuffers[thread];
+    Block& block = _blocks[firstBlock + b];
+    block.thread = thread;
+    block.begin = buffer.features.size();
+
+    const std::size_t end = std::min(_keypoints.size(), static_cast<std::size_t>(b + 1) * keypointsPerBlock);
+    for(std::size_t i = static_cast<std::size_t>(b) * keypointsPerBlock; i < end; ++i)
+    {
+      const VlSiftKeypoint& keypoint = _keypoints[i];
+
+      // Feature masking
+      if(mask)
+      {
+        const image::Image<unsigned char>& maskIma = *mask;
+        if(maskIma(keypoint.y, keypoint.x) > 0)
+          continue;
+      }
+
+      double angles[4] = {0.0, 0.0, 0.0, 0.0};
+      int nangles = 1; // by default (1 upright feature)
+      if(orientation)
+      { // compute from 1 to 4 orientations
+        nangles = vl_sift_calc_keypoint_orientations(&octaveFilter, angles, &keypoint);
+      }
+
+      for(int q = 0; q < nangles; ++q)
+      {
+        const std::size_t offset = buffer.descriptors.size();
+        buffer.descriptors.resize(offset + descriptorSize);
+        vl_sift_calc_keypoint_descriptor(&octaveFilter, &buffer.descriptors[offset], &keypoint, angles[q]);
+        buffer.features.emplace_back(keypoint.x, keypoint.y, keypoint.sigma, static_cast<float>(angles[q]));
+      }
+    }
+    block.end = buffer.features.size();
+  }
+}
+
+void SiftExtractor::mergeThreadBuffers()
+{
+  // offset of each block in the merged buffers
+  std::vector<std::size_t> offsets(_blocks.size() + 1, 0);
+  for(std::size_t b = 0; b < _blocks.size(); ++b)
+    offsets[b + 1] = offsets[b] + (_blocks[b].end - _blocks[b].begin);
+
+  _features.resize(offsets.back());
+  _descriptors.resize(offsets.back() * descriptorSize);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int b = 0; b < static_cast<int>(_blocks.size()); ++b)
+  {
+    const Block& block = _blocks[b];
+    const ThreadBuffer& buffer = _threadBuffers[block.thread];
+    const std::size_t size = block.end - block.begin;
+    if(size == 0)
+      continue;
+
+    std::copy_n(buffer.features.begin() + block.begin, size, _features.begin() + offsets[b]);
+    std::memcpy(&_descriptors[offsets[b] * descriptorSize],
+                &buffer.descriptors[block.begin * descriptorSize],
+                size * descriptorSize * sizeof(vl_sift_pix));
+  }
+}
+
+std::unique_ptr<SiftExtractor> SiftExtractorPool::acquire()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(!_extractors.empty())
+    {
+      std::unique_ptr<SiftExtractor> extractor = std::move(_extractors.back());
+      _extractors.pop_back();
+      return extractor;
+    }
+  }
+  return std::unique_ptr<SiftExtractor>(new SiftExtractor);
+}
+
+void SiftExtractorPool::release(std::unique_ptr<SiftExtractor> extractor)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _extractors.push_back(std::move(extractor));
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,132 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/PointFeature.hpp>
+#include <aliceVision/image/Image.hpp>
+
+extern "C" {
+#include <nonFree/sift/vl/sift.h>
+}
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+struct SiftParams;
+
+/**
+ * @brief VLFeat SIFT extraction engine, reusable from one image to another.
+ *
+ * The VLFeat filter and all the scratch buffers are kept between two extractions,
+ * the filter is only created again if the image size or the scale space parameters change.
+ *
+ * The octaves are pipelined: while the keypoints of an octave are described
+ * in parallel, the scale space, the detection and the gradient of the next octave
+ * are computed in a second gradient buffer.
+ * Each thread writes its features and descriptors in its own buffer, and the buffers
+ * are merged without lock in the detection order, so the result is deterministic.
+ *
+ * An extractor is not thread-safe, use a SiftExtractorPool to share them between threads.
+ */
+class SiftExtractor
+{
+public:
+  SiftExtractor() = default;
+  ~SiftExtractor();
+
+  SiftExtractor(const SiftExtractor&) = delete;
+  SiftExtractor& operator=(const SiftExtractor&) = delete;
+
+  /**
+   * @brief Detect and describe the SIFT keypoints of an image.
+   * @param[in] image The input image
+   * @param[in] params The SIFT parameters
+   * @param[in] orientation Compute from 1 to 4 orientations per keypoint (or upright features)
+   * @param[in] mask 8-bit grayscale image for keypoint filtering (optional)
+   */
+  void extract(const image::Image<float>& image,
+               const SiftParams& params,
+               bool orientation,
+               const image::Image<unsigned char>* mask = nullptr);
+
+  /// @return the features of the last extraction
+  const std::vector<SIOPointFeature>& getFeatures() const { return _features; }
+
+  /// @return the VLFeat descriptors of the last extraction (128 values per feature)
+  const std::vector<vl_sift_pix>& getDescriptors() const { return _descriptors; }
+
+private:
+  /// features and descriptors written by one thread
+  struct ThreadBuffer
+  {
+    std::vector<SIOPointFeature> features;
+    std::vector<vl_sift_pix> descriptors;
+  };
+
+  /// range of features written in a thread buffer for a block of keypoints
+  struct Block
+  {
+    int thread;
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  /// Create the VLFeat filter, if the current one cannot be reused
+  void initFilter(int width, int height, const SiftParams& params);
+  void releaseFilter();
+
+  /// Describe the keypoints of the current octave in the thread buffers
+  void describeKeypoints(VlSiftFilt& octaveFilter,
+                         bool orientation,
+                         const image::Image<unsigned char>* mask,
+                         int nbBlocks,
+                         std::size_t firstBlock);
+
+  /// Merge the thread buffers in the detection order
+  void mergeThreadBuffers();
+
+  VlSiftFilt* _filter = nullptr;
+  /// gradient buffer of the octave being described, swapped with the filter one
+  vl_sift_pix* _spareGradient = nullptr;
+  /// number of octaves requested at the filter creation (can be negative)
+  int _numOctaves = 0;
+
+  std::vector<VlSiftKeypoint> _keypoints;
+  std::vector<ThreadBuffer> _threadBuffers;
+  std::vector<Block> _blocks;
+
+  std::vector<SIOPointFeature> _features;
+  std::vector<vl_sift_pix> _descriptors;
+};
+
+/**
+ * @brief Thread-safe pool of SIFT extractors.
+ *
+ * Each concurrent extraction takes its own extractor,
+ * which is given back to the pool to be reused by the next image.
+ */
+class SiftExtractorPool
+{
+public:
+  /// @return an extractor of the pool, or a new one if they are all used
+  std::unique_ptr<SiftExtractor> acquire();
+
+  /// Give back an extractor to the pool
+  void release(std::unique_ptr<SiftExtractor> extractor);
+
+private:
+  std::mutex _mutex;
+  std::vector<std::unique_ptr<SiftExtractor>> _extractors;
+};
+
+} // namespace feature
+} // namespace aliceVision
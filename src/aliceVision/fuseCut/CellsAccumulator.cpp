@@ -0,0 +1,76 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CellsAccumulator.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+
+// OpenMP >= 3.1 for advanced atomic clauses (https://software.intel.com/en-us/node/608160)
+#if defined _OPENMP && _OPENMP >= 201107
+#define OMP_ATOMIC_UPDATE _Pragma("omp atomic update")
+#define OMP_ATOMIC_WRITE  _Pragma("omp atomic write")
+#else
+#define OMP_ATOMIC_UPDATE _Pragma("omp atomic")
+#define OMP_ATOMIC_WRITE  _Pragma("omp atomic")
+#endif
+
+namespace aliceVision {
+namespace fuseCut {
+
+namespace {
+
+float& getField(GC_cellInfo& cell, CellsAccumulator::EField field)
+{
+    switch(field)
+    {
+        case CellsAccumulator::IN:            return cell.in;
+        case CellsAccumulator::OUT:           return cell.out;
+        case CellsAccumulator::ON:            return cell.on;
+        case CellsAccumulator::CELL_T_WEIGHT: return cell.cellTWeight;
+        case CellsAccumulator::CELL_S_WEIGHT: return cell.cellSWeight;
+        default:                              return cell.gEdgeVisWeight[field - CellsAccumulator::GEDGE_VIS_WEIGHT_0];
+    }
+}
+
+} // namespace
+
+void CellsAccumulator::flush(std::vector<GC_cellInfo>& cellsAttr)
+{
+    std::sort(_contributions.begin(), _contributions.end(), [](const Contribution& a, const Contribution& b) {
+        return a.cellIndex < b.cellIndex || (a.cellIndex == b.cellIndex && a.field < b.field);
+    });
+
+    for(std::size_t i = 0; i < _contributions.size();)
+    {
+        const Contribution& first = _contributions[i];
+        float value = first.value;
+        std::size_t j = i + 1;
+        for(; j < _contributions.size() && _contributions[j].cellIndex == first.cellIndex && _contributions[j].field == first.field; ++j)
+        {
+            if(first.field != CELL_S_WEIGHT)
+                value += _contributions[j].value;
+        }
+
+        float& target = getField(cellsAttr[first.cellIndex], first.field);
+        if(first.field == CELL_S_WEIGHT)
+        {
+OMP_ATOMIC_WRITE
+            target = value;
+        }
+        else
+        {
+OMP_ATOMIC_UPDATE
+            target += value;
+        }
+        i = j;
+    }
+    _contributions.clear();
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
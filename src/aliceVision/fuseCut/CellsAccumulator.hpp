@@ -0,0 +1,70 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/fuseCut/delaunayGraphCutTypes.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Per-thread scratch buffer for the weights added to the cells while walking along the rays.
+ *
+ * The contributions of a batch of rays are stored locally, then sorted by cell and merged into the
+ * shared cells attributes with one atomic operation per modified value. Neighboring rays go through
+ * the same cells, so it replaces most of the atomic operations (and the cache line contention) of the
+ * ray walking by local writes.
+ */
+class CellsAccumulator
+{
+public:
+    enum EField : std::uint8_t
+    {
+        GEDGE_VIS_WEIGHT_0 = 0, ///< gEdgeVisWeight[0..3]
+        IN = 4,
+        OUT,
+        ON,
+        CELL_T_WEIGHT,
+        CELL_S_WEIGHT           ///< the value is assigned instead of added
+    };
+
+    inline void add(std::size_t cellIndex, EField field, float value)
+    {
+        _contributions.push_back({cellIndex, field, value});
+    }
+
+    inline void addEdgeVisWeight(std::size_t cellIndex, int localVertexIndex, float value)
+    {
+        add(cellIndex, static_cast<EField>(GEDGE_VIS_WEIGHT_0 + localVertexIndex), value);
+    }
+
+    std::size_t size() const { return _contributions.size(); }
+
+    /**
+     * @brief Merge the contributions into the cells attributes and clear the buffer.
+     * Can be called concurrently by several threads on the same cells.
+     * @param[in,out] cellsAttr the cells attributes
+     */
+    void flush(std::vector<GC_cellInfo>& cellsAttr);
+
+private:
+    struct Contribution
+    {
+        std::size_t cellIndex;
+        EField field;
+        float value;
+    };
+
+    std::vector<Contribution> _contributions;
+};
+
+} // namespace fuseCut
+} // namespace aliceVision
@@ -7,6 +7,10 @@
 #include "DelaunayGraphCut.hpp"
 // #include <aliceVision/fuseCut/MaxFlow_CSR.hpp>
 #include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_PushRelabel.hpp>
+#include <aliceVision/fuseCut/MaxFlowGraph.hpp>
+#include <aliceVision/fuseCut/PointsHashGrid.hpp>
+#include <aliceVision/fuseCut/PointsSpill.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/jetColorMap.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
@@ -23,6 +27,11 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
 // OpenMP >= 3.1 for advanced atomic clauses (https://software.intel.com/en-us/node/608160)
 // OpenMP preprocessor version: https://github.com/jeffhammond/HPCInfo/wiki/Preprocessor-Macros
 #if defined _OPENMP && _OPENMP >= 201107 
@@ -127,7 +136,8 @@ public:
      */
     inline bool addPoint(DistanceType dist, IndexType index)
     {
-        if(dist < radius)
+        // the points discarded before the filtering are ignored
+        if(dist < radius && m_pixSizePrepare[index] != -1.0)
         {
             ++m_result;
             if(m_simScorePrepare[index] * m_pixSizePrepare[index] * m_pixSizePrepare[index] < m_simScorePrepare[m_i] * m_pixSizePrepare[m_i] * m_pixSizePrepare[m_i])
@@ -144,7 +154,6 @@ public:
 #endif
 
 
-/// Filter by pixSize
 void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, double pixSizeMarginCoef, std::vector<float>& simScorePrepare)
 {
 #ifdef USE_GEOGRAM_KDTREE
@@ -160,6 +169,9 @@ void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vec
 #endif
     ALICEVISION_LOG_INFO("KdTree created for " << verticesCoordsPrepare.size() << " points.");
 
+    // the points are discarded at the end, so the result doesn't depend on the processing order
+    std::vector<char> discarded(verticesCoordsPrepare.size(), 0);
+
     #pragma omp parallel for
     for(int vIndex = 0; vIndex < verticesCoordsPrepare.size(); ++vIndex)
     {
@@ -170,7 +182,7 @@ void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vec
         const double pixSizeScore = pixSizeMarginCoef * simScorePrepare[vIndex] * pixSizePrepare[vIndex] * pixSizePrepare[vIndex];
         if(pixSizeScore < std::numeric_limits<double>::epsilon())
         {
-            pixSizePrepare[vIndex] = -1.0;
+            discarded[vIndex] = 1;
             continue;
         }
 #ifdef USE_GEOGRAM_KDTREE
@@ -185,14 +197,14 @@ void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vec
         {
             // NOTE: we don't need to test the distance regarding pixSizePrepare[nnIndex[vIndex]]
             //       as we kill ourself only if our pixSize is bigger
-            if(sqDist[n] < pixSizeScore)
+            if(sqDist[n] < pixSizeScore && pixSizePrepare[nnIndex[n]] != -1.0)
             {
                 if(pixSizePrepare[nnIndex[n]] < pixSizePrepare[vIndex] ||
                    (pixSizePrepare[nnIndex[n]] == pixSizePrepare[vIndex] && nnIndex[n] < vIndex)
                    )
                 {
                     // Kill itself if inside our volume (defined by marginCoef*pixSize) there is another point with a smaller pixSize
-                    pixSizePrepare[vIndex] = -1.0;
+                    discarded[vIndex] = 1;
                     break;
                 }
             }
@@ -207,9 +219,14 @@ void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vec
         SmallerPixSizeInRadius<double, std::size_t> resultSet(pixSizeScore, pixSizePrepare, simScorePrepare, vIndex);
         kdTree.findNeighbors(resultSet, verticesCoordsPrepare[vIndex].m, searchParams);
         if(resultSet.found)
-            pixSizePrepare[vIndex] = -1.0;
+            discarded[vIndex] = 1;
 #endif
     }
+    for(std::size_t vIndex = 0; vIndex < discarded.size(); ++vIndex)
+    {
+        if(discarded[vIndex])
+            pixSizePrepare[vIndex] = -1.0;
+    }
     ALICEVISION_LOG_INFO("Filtering done.");
 }
 
@@ -386,6 +403,206 @@ void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<P
 }
 
 
+/**
+ * @brief Load the depth map of a camera and select the best depth value in each tile of step x step pixels.
+ *
+ * @param[out] coords 3D point of each tile, (width / step) x (height / step) tiles in row-major order
+ * @param[out] pixSize pixel size of each tile point, -1 for the discarded tiles
+ * @param[out] simScore similarity score of each tile point
+ * @return false if the depth map is empty
+ */
+bool sampleDepthMapTiles(mvsUtils::MultiViewParams* mp, int c, int step, const FuseParams& params, const Point3d voxel[8],
+                         Point3d* coords, double* pixSize, float* simScore)
+{
+    std::vector<float> depthMap;
+    std::vector<float> simMap;
+    std::vector<unsigned char> numOfModalsMap;
+    int width, height;
+    {
+        const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
+        imageIO::readImage(depthMapFilepath, width, height, depthMap);
+        if(depthMap.empty())
+        {
+            ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
+            return false;
+        }
+        int wTmp, hTmp;
+        const std::string simMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::simMap, 0);
+        imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap);
+        if(wTmp != width || hTmp != height)
+            throw std::runtime_error("Wrong sim map dimensions: " + simMapFilepath);
+        {
+            std::vector<float> simMapTmp(simMap.size());
+            imageIO::convolveImage(width, height, simMap, simMapTmp, "gaussian", params.simGaussianSizeInit, params.simGaussianSizeInit);
+            simMap.swap(simMapTmp);
+        }
+
+        const std::string nmodMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::nmodMap, 0);
+        imageIO::readImage(nmodMapFilepath, wTmp, hTmp, numOfModalsMap);
+        if(wTmp != width || hTmp != height)
+            throw std::runtime_error("Wrong nmod map dimensions: " + nmodMapFilepath);
+    }
+
+    int syMax = std::ceil(height/step);
+    int sxMax = std::ceil(width/step);
+    #pragma omp parallel for
+    for(int sy = 0; sy < syMax; ++sy)
+    {
+        for(int sx = 0; sx < sxMax; ++sx)
+        {
+            int index = sy * sxMax + sx;
+            float bestDepth = std::numeric_limits<float>::max();
+            float bestScore = 0;
+            float bestSimScore = 0;
+            int bestX = 0;
+            int bestY = 0;
+            for(int y = sy * step, ymax = std::min((sy+1) * step, height);
+                y < ymax; ++y)
+            {
+                for(int x = sx * step, xmax = std::min((sx+1) * step, width);
+                    x < xmax; ++x)
+                {
+                    const std::size_t index = y * width + x;
+                    const float depth = depthMap[index];
+                    if(depth <= 0.0f)
+                        continue;
+
+                    int numOfModals = 0;
+                    const int scoreKernelSize = 1;
+                    for(int ly = std::max(y-scoreKernelSize, 0), lyMax = std::min(y+scoreKernelSize, height-1); ly < lyMax; ++ly)
+                    {
+                        for(int lx = std::max(x-scoreKernelSize, 0), lxMax = std::min(x+scoreKernelSize, width-1); lx < lxMax; ++lx)
+                        {
+                            if(depthMap[ly * width + lx] > 0.0f)
+                            {
+                                numOfModals += 10 + int(numOfModalsMap[ly * width + lx]);
+                            }
+                        }
+                    }
+                    float sim = simMap[index];
+                    sim = sim < 0.0f ?  0.0f : sim; // clamp values < 0
+                    // remap similarity values from [-1;+1] to [+1;+simScale]
+                    // interpretation is [goodSimilarity;badSimilarity]
+                    const float simScore = 1.0f + sim * params.simFactor;
+
+                    const float score = numOfModals + (1.0f / simScore);
+                    if(score > bestScore)
+                    {
+                        bestDepth = depth;
+                        bestScore = score;
+                        bestSimScore = simScore;
+                        bestX = x;
+                        bestY = y;
+                    }
+                }
+            }
+            if(bestScore < 3*13)
+            {
+                // discard the point
+                pixSize[index] = -1.0;
+            }
+            else
+            {
+                Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)bestX, (float)bestY)).normalize() * bestDepth;
+
+                // TODO: isPointInHexahedron: here or in the previous loop per pixel to not loose point?
+                if(voxel == nullptr || mvsUtils::isPointInHexahedron(p, voxel))
+                {
+                    coords[index] = p;
+                    simScore[index] = bestSimScore;
+                    pixSize[index] = mp->getCamPixelSize(p, c);
+                }
+                else
+                {
+                    // discard the point
+                    pixSize[index] = -1.0;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Load the points of the depth maps and filter them by pixel size with a memory budget.
+ *
+ * The points sampled in the depth maps are spilled to a temporary file, then filtered by spatial
+ * buckets fitting in the memory budget (see filterPointsOutOfCore) with the same result as with all
+ * the points in memory. Only the remaining points are kept in memory.
+ */
+void loadFilteredPointsOutOfCore(mvsUtils::MultiViewParams* mp, const StaticVector<int>& cams, int step, const FuseParams& params, const Point3d voxel[8],
+                                 std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, std::vector<float>& simScorePrepare)
+{
+    const std::size_t maxMemory = std::size_t(params.maxMemory) * 1024 * 1024;
+
+    // temporary folder removed at the end, even on error
+    const bfs::path tmpFolder = bfs::unique_path((params.tmpFolder.empty() ? bfs::temp_directory_path() : bfs::path(params.tmpFolder)) / "fuse_%%%%-%%%%-%%%%");
+    bfs::create_directories(tmpFolder);
+    std::shared_ptr<void> tmpFolderRemover(nullptr, [&tmpFolder](void*) { boost::system::error_code ec; bfs::remove_all(tmpFolder, ec); });
+
+    Point3d origin;
+    for(int i = 0; i < cams.size(); ++i)
+        origin = origin + mp->CArr[cams[i]];
+    origin = origin / double(std::max(1, cams.size()));
+
+    PointsSpill allPoints((tmpFolder / "points.bin").string(), origin);
+    Point3d bbMin(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    Point3d bbMax = -bbMin;
+
+    // depth, similarity (and its convolution) and number of modals maps loaded together
+    std::size_t maxNbPixels = 0;
+    for(int c = 0; c < cams.size(); ++c)
+        maxNbPixels = std::max(maxNbPixels, std::size_t(mp->getWidth(c)) * mp->getHeight(c));
+    const std::size_t depthMapMemory = maxNbPixels * (3 * sizeof(float) + sizeof(unsigned char));
+    const int nbParallelMaps = int(std::max(std::size_t(1), std::min(std::size_t(3), maxMemory / (2 * depthMapMemory + 1))));
+
+    ALICEVISION_LOG_INFO("Load depth maps and spill points to: " << tmpFolder.string() << " (" << nbParallelMaps << " depth maps in parallel).");
+    {
+        omp_set_nested(1);
+        #pragma omp parallel for num_threads(nbParallelMaps)
+        for(int c = 0; c < cams.size(); c++)
+        {
+            const int nbTiles = std::ceil(mp->getHeight(c) / step) * std::ceil(mp->getWidth(c) / step);
+            std::vector<Point3d> coords(nbTiles);
+            std::vector<double> pixSize(nbTiles, -1.0);
+            std::vector<float> simScore(nbTiles);
+            if(!sampleDepthMapTiles(mp, c, step, params, voxel, coords.data(), pixSize.data(), simScore.data()))
+                continue;
+
+            std::vector<SpilledPoint> points;
+            // the shared bounding box is only read and written in the critical section
+            Point3d camBbMin(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+            Point3d camBbMax = -camBbMin;
+            for(int i = 0; i < nbTiles; ++i)
+            {
+                if(pixSize[i] == -1.0)
+                    continue;
+                const Point3d& p = coords[i];
+                points.push_back(allPoints.toSpilledPoint(p, pixSize[i], simScore[i]));
+                camBbMin = Point3d(std::min(camBbMin.x, p.x), std::min(camBbMin.y, p.y), std::min(camBbMin.z, p.z));
+                camBbMax = Point3d(std::max(camBbMax.x, p.x), std::max(camBbMax.y, p.y), std::max(camBbMax.z, p.z));
+            }
+
+            #pragma omp critical (fuseSpillPoints)
+            {
+                allPoints.append(points);
+                bbMin = Point3d(std::min(camBbMin.x, bbMin.x), std::min(camBbMin.y, bbMin.y), std::min(camBbMin.z, bbMin.z));
+                bbMax = Point3d(std::max(camBbMax.x, bbMax.x), std::max(camBbMax.y, bbMax.y), std::max(camBbMax.z, bbMax.z));
+            }
+        }
+        omp_set_nested(0);
+    }
+    ALICEVISION_LOG_INFO(allPoints.size() << " points spilled.");
+
+    if(allPoints.size() == 0)
+        return;
+
+    ALICEVISION_LOG_INFO("Filter initial 3D points by pixel size to remove duplicates.");
+    const std::size_t peakMemory = filterPointsOutOfCore(allPoints, bbMin, bbMax, params.pixSizeMarginInitCoef, maxMemory, filterByPixSize,
+                                                         verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
+    ALICEVISION_LOG_INFO("Points filtered with an estimated peak memory of " << peakMemory / (1024 * 1024) << " MB.");
+}
+
 DelaunayGraphCut::DelaunayGraphCut(mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc)
 {
     mp = _mp;
@@ -631,23 +848,23 @@ StaticVector<int> DelaunayGraphCut::getSortedUsedCams() const
 
 void DelaunayGraphCut::addPointsFromCameraCenters(const StaticVector<int>& cams, float minDist)
 {
+    // the tetrahedralization is not computed yet, so the existing vertices are indexed in a grid
+    PointsHashGrid verticesGrid(_verticesCoords, minDist);
+    verticesGrid.build();
+
     for(int camid = 0; camid < cams.size(); camid++)
     {
         int rc = cams[camid];
         {
             Point3d p(mp->CArr[rc].x, mp->CArr[rc].y, mp->CArr[rc].z);
 
-            GEO::index_t vi = locateNearestVertex(p);
-            Point3d npp;
-            if(vi != GEO::NO_VERTEX)
-            {
-                npp = _verticesCoords[vi];
-            }
+            std::size_t vi = verticesGrid.findNearest(p, minDist);
 
-            if((vi == GEO::NO_VERTEX) || ((npp - mp->CArr[rc]).size() > minDist))
+            if(vi == PointsHashGrid::noPoint)
             {
                 vi = _verticesCoords.size();
                 _verticesCoords.push_back(p);
+                verticesGrid.add(vi);
 
                 GC_vertexInfo newv;
                 newv.nrc = 0;
@@ -685,19 +902,16 @@ void DelaunayGraphCut::addPointsToPreventSingularities(Point3d voxel[8], float m
     extrPts[4] = fcg + (fcg - vcg) / 10.0f;
     fcg = (voxel[3] + voxel[2] + voxel[6] + voxel[7]) / 4.0f;
     extrPts[5] = fcg + (fcg - vcg) / 10.0f;
+    PointsHashGrid verticesGrid(_verticesCoords, minDist);
+    verticesGrid.build();
+
     for(int i = 0; i < 6; i++)
     {
         Point3d p(extrPts[i].x, extrPts[i].y, extrPts[i].z);
-        GEO::index_t vi = locateNearestVertex(p);
-        Point3d npp;
-
-        if(vi != GEO::NO_VERTEX)
-        {
-            npp = _verticesCoords[vi];
-        }
 
-        if((vi == GEO::NO_VERTEX) || ((npp - extrPts[i]).size() > minDist))
+        if(verticesGrid.findNearest(p, minDist) == PointsHashGrid::noPoint)
         {
+            verticesGrid.add(_verticesCoords.size());
             _verticesCoords.push_back(p);
             GC_vertexInfo newv;
             newv.nrc = 0;
@@ -729,6 +943,10 @@ void DelaunayGraphCut::addHelperPoints(int nGridHelperVolumePointsDim, Point3d v
     float maxSize = 2.0f * (O - voxel[0]).size();
     Point3d CG = (voxel[0] + voxel[1] + voxel[2] + voxel[3] + voxel[4] + voxel[5] + voxel[6] + voxel[7]) / 8.0f;
 
+    // index the fused points to skip the helper points too close to them
+    PointsHashGrid verticesGrid(_verticesCoords, minDist);
+    verticesGrid.build();
+
     for(int x = 0; x <= ns; x++)
     {
         for(int y = 0; y <= ns; y++)
@@ -740,18 +958,12 @@ void DelaunayGraphCut::addHelperPoints(int nGridHelperVolumePointsDim, Point3d v
                 pt = pt + (CG - pt).normalize() * (maxSize * ((float)rand() / (float)RAND_MAX));
 
                 Point3d p(pt.x, pt.y, pt.z);
-                GEO::index_t vi = locateNearestVertex(p);
-                Point3d npp;
 
-                if(vi != GEO::NO_VERTEX)
-                {
-                    npp = _verticesCoords[vi];
-                }
-
-                // if there is no nearest vertex or the nearest vertex is not too close
-                if((vi == GEO::NO_VERTEX) || ((npp - pt).size() > minDist))
+                // if there is no vertex too close
+                if(verticesGrid.findNearest(p, minDist) == PointsHashGrid::noPoint)
                 {
                     _verticesCoords.push_back(p);
+                    verticesGrid.add(_verticesCoords.size() - 1);
                     GC_vertexInfo newv;
                     newv.nrc = 0;
                     newv.segSize = 0;
@@ -786,146 +998,53 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
     }
     int step = std::floor(std::sqrt(double(nbPixels) / double(params.maxInputPoints)));
     step = std::max(step, params.minStep);
-    std::size_t realMaxVertices = 0;
-    std::vector<int> startIndex(mp->getNbCameras(), 0);
-    for(int i = 0; i < mp->getNbCameras(); ++i)
-    {
-        const auto& imgParams = mp->getImageParams(i);
-        startIndex[i] = realMaxVertices;
-        realMaxVertices += std::ceil(imgParams.width / step) * std::ceil(imgParams.height / step);
-    }
-    verticesCoordsPrepare.resize(realMaxVertices);
-    std::vector<double> pixSizePrepare(realMaxVertices);
-    std::vector<float> simScorePrepare(realMaxVertices);
-
     ALICEVISION_LOG_INFO("simFactor: " << params.simFactor);
     ALICEVISION_LOG_INFO("nbPixels: " << nbPixels);
     ALICEVISION_LOG_INFO("maxVertices: " << params.maxPoints);
     ALICEVISION_LOG_INFO("step: " << step);
-    ALICEVISION_LOG_INFO("realMaxVertices: " << realMaxVertices);
 
-    ALICEVISION_LOG_INFO("Load depth maps and add points.");
+    std::vector<double> pixSizePrepare;
+    std::vector<float> simScorePrepare;
+
+    if(params.maxMemory > 0)
     {
-        omp_set_nested(1);
-        #pragma omp parallel for num_threads(3)
-        for(int c = 0; c < cams.size(); c++)
+        ALICEVISION_LOG_INFO("Fusion with a memory budget of " << params.maxMemory << " MB.");
+        loadFilteredPointsOutOfCore(mp, cams, step, params, voxel, verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
+    }
+    else
+    {
+        std::size_t realMaxVertices = 0;
+        std::vector<int> startIndex(mp->getNbCameras(), 0);
+        for(int i = 0; i < mp->getNbCameras(); ++i)
         {
-            std::vector<float> depthMap;
-            std::vector<float> simMap;
-            std::vector<unsigned char> numOfModalsMap;
-            int width, height;
-            {
-                const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
-                imageIO::readImage(depthMapFilepath, width, height, depthMap);
-                if(depthMap.empty())
-                {
-                    ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
-                    continue;
-                }
-                int wTmp, hTmp;
-                const std::string simMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::simMap, 0);
-                imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap);
-                if(wTmp != width || hTmp != height)
-                    throw std::runtime_error("Wrong sim map dimensions: " + simMapFilepath);
-                {
-                    std::vector<float> simMapTmp(simMap.size());
-                    imageIO::convolveImage(width, height, simMap, simMapTmp, "gaussian", params.simGaussianSizeInit, params.simGaussianSizeInit);
-                    simMap.swap(simMapTmp);
-                }
+            const auto& imgParams = mp->getImageParams(i);
+            startIndex[i] = realMaxVertices;
+            realMaxVertices += std::ceil(imgParams.width / step) * std::ceil(imgParams.height / step);
+        }
+        verticesCoordsPrepare.resize(realMaxVertices);
+        pixSizePrepare.resize(realMaxVertices);
+        simScorePrepare.resize(realMaxVertices);
 
-                const std::string nmodMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::nmodMap, 0);
-                imageIO::readImage(nmodMapFilepath, wTmp, hTmp, numOfModalsMap);
-                if(wTmp != width || hTmp != height)
-                    throw std::runtime_error("Wrong nmod map dimensions: " + nmodMapFilepath);
-            }
+        ALICEVISION_LOG_INFO("realMaxVertices: " << realMaxVertices);
 
-            int syMax = std::ceil(height/step);
-            int sxMax = std::ceil(width/step);
-            #pragma omp parallel for
-            for(int sy = 0; sy < syMax; ++sy)
+        ALICEVISION_LOG_INFO("Load depth maps and add points.");
+        {
+            omp_set_nested(1);
+            #pragma omp parallel for num_threads(3)
+            for(int c = 0; c < cams.size(); c++)
             {
-                for(int sx = 0; sx < sxMax; ++sx)
-                {
-                    int index = startIndex[c] + sy * sxMax + sx;
-                    float bestDepth = std::numeric_limits<float>::max();
-                    float bestScore = 0;
-                    float bestSimScore = 0;
-                    int bestX = 0;
-                    int bestY = 0;
-                    for(int y = sy * step, ymax = std::min((sy+1) * step, height);
-                        y < ymax; ++y)
-                    {
-                        for(int x = sx * step, xmax = std::min((sx+1) * step, width);
-                            x < xmax; ++x)
-                        {
-                            const std::size_t index = y * width + x;
-                            const float depth = depthMap[index];
-                            if(depth <= 0.0f)
-                                continue;
-
-                            int numOfModals = 0;
-                            const int scoreKernelSize = 1;
-                            for(int ly = std::max(y-scoreKernelSize, 0), lyMax = std::min(y+scoreKernelSize, height-1); ly < lyMax; ++ly)
-                            {
-                                for(int lx = std::max(x-scoreKernelSize, 0), lxMax = std::min(x+scoreKernelSize, width-1); lx < lxMax; ++lx)
-                                {
-                                    if(depthMap[ly * width + lx] > 0.0f)
-                                    {
-                                        numOfModals += 10 + int(numOfModalsMap[ly * width + lx]);
-                                    }
-                                }
-                            }
-                            float sim = simMap[index];
-                            sim = sim < 0.0f ?  0.0f : sim; // clamp values < 0
-                            // remap similarity values from [-1;+1] to [+1;+simScale]
-                            // interpretation is [goodSimilarity;badSimilarity]
-                            const float simScore = 1.0f + sim * params.simFactor;
-
-                            const float score = numOfModals + (1.0f / simScore);
-                            if(score > bestScore)
-                            {
-                                bestDepth = depth;
-                                bestScore = score;
-                                bestSimScore = simScore;
-                                bestX = x;
-                                bestY = y;
-                            }
-                        }
-                    }
-                    if(bestScore < 3*13)
-                    {
-                        // discard the point
-                        pixSizePrepare[index] = -1.0;
-                    }
-                    else
-                    {
-                        Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)bestX, (float)bestY)).normalize() * bestDepth;
-                        
-                        // TODO: isPointInHexahedron: here or in the previous loop per pixel to not loose point?
-                        if(voxel == nullptr || mvsUtils::isPointInHexahedron(p, voxel)) 
-                        {
-                            verticesCoordsPrepare[index] = p;
-                            simScorePrepare[index] = bestSimScore;
-                            pixSizePrepare[index] = mp->getCamPixelSize(p, c);
-                        }
-                        else
-                        {
-                            // discard the point
-                            // verticesCoordsPrepare[index] = p;
-                            pixSizePrepare[index] = -1.0;
-                        }
-                    }
-                }
+                sampleDepthMapTiles(mp, c, step, params, voxel, &verticesCoordsPrepare[startIndex[c]],
+                                    &pixSizePrepare[startIndex[c]], &simScorePrepare[startIndex[c]]);
             }
+            omp_set_nested(0);
         }
-        omp_set_nested(0);
-    }
 
-    ALICEVISION_LOG_INFO("Filter initial 3D points by pixel size to remove duplicates.");
+        ALICEVISION_LOG_INFO("Filter initial 3D points by pixel size to remove duplicates.");
 
-    filterByPixSize(verticesCoordsPrepare, pixSizePrepare, params.pixSizeMarginInitCoef, simScorePrepare);
-    // remove points if pixSize == -1
-    removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
+        filterByPixSize(verticesCoordsPrepare, pixSizePrepare, params.pixSizeMarginInitCoef, simScorePrepare);
+        // remove points if pixSize == -1
+        removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
+    }
 
     ALICEVISION_LOG_INFO("3D points loaded and filtered to " << verticesCoordsPrepare.size() << " points.");
 
@@ -1525,6 +1644,61 @@ float DelaunayGraphCut::weightFcn(float nrc, bool labatutWeights, int  /*ncams*/
     return weight;
 }
 
+/// Number of vertices given to a thread at once by the ray walking loops
+static const int RAY_WALKING_BATCH_SIZE = 64;
+/// Number of contributions stored in a CellsAccumulator before merging them into the cells
+static const std::size_t RAY_WALKING_MAX_CONTRIBUTIONS = 1 << 16;
+
+/**
+ * @brief Spread the 21 lower bits of a value to every third bit.
+ */
+static std::uint64_t spreadBitsBy3(std::uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | (v << 32)) & 0x1f00000000ffffULL;
+    v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+    v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+    v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+    v = (v | (v << 2)) & 0x1249249249249249ULL;
+    return v;
+}
+
+/**
+ * @brief Sort the vertices along a Morton (Z-order) curve.
+ * Consecutive vertices are close in space, so their rays go through the same cells: processed by
+ * batches, it keeps the cells in the cache of the thread and the threads work on different cells.
+ * @param[in] verticesCoords the vertices
+ * @return the vertices indexes in the spatial order
+ */
+std::vector<int> getVerticesSpatialOrder(const std::vector<Point3d>& verticesCoords)
+{
+    const int nbVertices = verticesCoords.size();
+    Point3d bbMin(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    Point3d bbMax(std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest());
+    for(const Point3d& p : verticesCoords)
+    {
+        bbMin = Point3d(std::min(bbMin.x, p.x), std::min(bbMin.y, p.y), std::min(bbMin.z, p.z));
+        bbMax = Point3d(std::max(bbMax.x, p.x), std::max(bbMax.y, p.y), std::max(bbMax.z, p.z));
+    }
+    const double extent = std::max(std::max(bbMax.x - bbMin.x, bbMax.y - bbMin.y), std::max(bbMax.z - bbMin.z, 1e-12));
+    const double scale = double((1 << 21) - 1) / extent;
+
+    std::vector<std::pair<std::uint64_t, int>> codes(nbVertices);
+#pragma omp parallel for
+    for(int i = 0; i < nbVertices; ++i)
+    {
+        const Point3d p = (verticesCoords[i] - bbMin) * scale;
+        codes[i].first = spreadBitsBy3(std::uint64_t(p.x)) | (spreadBitsBy3(std::uint64_t(p.y)) << 1) | (spreadBitsBy3(std::uint64_t(p.z)) << 2);
+        codes[i].second = i;
+    }
+    std::sort(codes.begin(), codes.end());
+
+    std::vector<int> order(nbVertices);
+    for(int i = 0; i < nbVertices; ++i)
+        order[i] = codes[i].second;
+    return order;
+}
+
 void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind,
                                bool labatutWeights, bool fillOut, float distFcnHeight) // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 labatutWeights=0 fillOut=1 distFcnHeight=0
 {
@@ -1547,8 +1721,9 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
         }
     }
 
-    // choose random order to prevent waiting
-    StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
+    // spatial order: each thread walks the rays of a batch of neighboring vertices
+    const std::vector<int> verticesOrder = getVerticesSpatialOrder(_verticesCoords);
+    const int nbVertices = verticesOrder.size();
 
     int64_t avStepsFront = 0;
     int64_t aAvStepsFront = 0;
@@ -1557,10 +1732,14 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
     int avCams = 0;
     int nAvCams = 0;
 
-#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
-    for(int i = 0; i < vetexesToProcessIdsRand->size(); i++)
+#pragma omp parallel reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
+    {
+    CellsAccumulator accumulator;
+
+#pragma omp for schedule(dynamic, RAY_WALKING_BATCH_SIZE) nowait
+    for(int i = 0; i < nbVertices; i++)
     {
-        int iV = (*vetexesToProcessIdsRand)[i];
+        int iV = verticesOrder[i];
         const GC_vertexInfo& v = _verticesAttr[iV];
 
         if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
@@ -1576,7 +1755,7 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
                 int nstepsFront = 0;
                 int nstepsBehind = 0;
                 fillGraphPartPtRc(nstepsFront, nstepsBehind, iV, v.cams[c], weight, fixesSigma, nPixelSizeBehind,
-                                  allPoints, behind, fillOut, distFcnHeight);
+                                  allPoints, behind, fillOut, distFcnHeight, accumulator);
 
                 avStepsFront += nstepsFront;
                 aAvStepsFront += 1;
@@ -1586,10 +1765,14 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
 
             avCams += v.cams.size();
             nAvCams += 1;
+
+            if(accumulator.size() > RAY_WALKING_MAX_CONTRIBUTIONS)
+                accumulator.flush(_cellsAttr);
         }
     }
 
-    delete vetexesToProcessIdsRand;
+    accumulator.flush(_cellsAttr);
+    }
 
     ALICEVISION_LOG_DEBUG("avStepsFront " << avStepsFront);
     ALICEVISION_LOG_DEBUG("avStepsFront = " << mvsUtils::num2str(avStepsFront) << " // " << mvsUtils::num2str(aAvStepsFront));
@@ -1601,7 +1784,7 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
 
 void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam,
                                        float weight, bool fixesSigma, float nPixelSizeBehind, bool allPoints,
-                                       bool behind, bool fillOut, float distFcnHeight)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
+                                       bool behind, bool fillOut, float distFcnHeight, CellsAccumulator& accumulator)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
 {
     out_nstepsFront = 0;
     out_nstepsBehind = 0;
@@ -1634,10 +1817,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         bool ok = ci != GEO::NO_CELL;
         while(ok)
         {
-            {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].out += weight;
-            }
+            accumulator.add(ci, CellsAccumulator::OUT, weight);
 
             ++out_nstepsFront;
             ++nsteps;
@@ -1654,10 +1834,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
             {
                 float dist = distFcn(maxDist, (po - pold).size(), distFcnHeight);
 
-                {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f1.cellIndex].gEdgeVisWeight[f1.localVertexIndex] += weight * dist;
-                }
+                accumulator.addEdgeVisWeight(f1.cellIndex, f1.localVertexIndex, weight * dist);
 
                 if(f2.cellIndex == GEO::NO_CELL)
                     ok = false;
@@ -1669,8 +1846,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         // get the outer tetrahedron of camera c for the ray to p = the last tetrahedron
         if(lastFinite != GEO::NO_CELL)
         {
-#pragma OMP_ATOMIC_WRITE
-            _cellsAttr[lastFinite].cellSWeight = (float)maxint;
+            accumulator.add(lastFinite, CellsAccumulator::CELL_S_WEIGHT, (float)maxint);
         }
     }
 
@@ -1683,8 +1859,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         CellIndex ci = f1.cellIndex;
         if(ci != GEO::NO_CELL)
         {
-#pragma OMP_ATOMIC_UPDATE
-            _cellsAttr[ci].on += weight;
+            accumulator.add(ci, CellsAccumulator::ON, weight);
         }
 
         Point3d p = po; // HAS TO BE HERE !!!
@@ -1692,15 +1867,12 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         bool ok = (ci != GEO::NO_CELL) && allPoints;
         while(ok)
         {
-            GC_cellInfo& c = _cellsAttr[ci];
             {
                 if(behind)
                 {
-#pragma OMP_ATOMIC_UPDATE
-                    c.cellTWeight += weight;
+                    accumulator.add(ci, CellsAccumulator::CELL_T_WEIGHT, weight);
                 }
-#pragma OMP_ATOMIC_UPDATE
-                c.in += weight;
+                accumulator.add(ci, CellsAccumulator::IN, weight);
             }
 
             ++out_nstepsBehind;
@@ -1730,8 +1902,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
                 }
                 else
                 {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f2.cellIndex].gEdgeVisWeight[f2.localVertexIndex] += weight * dist;
+                    accumulator.addEdgeVisWeight(f2.cellIndex, f2.localVertexIndex, weight * dist);
                 }
                 ci = f2.cellIndex;
             }
@@ -1742,8 +1913,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         {
             if(ci != GEO::NO_CELL)
             {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].cellTWeight += weight;
+                accumulator.add(ci, CellsAccumulator::CELL_T_WEIGHT, weight);
             }
         }
     }
@@ -1880,18 +2050,23 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSi
         // c.out = c.gEdgeVisWeight[0] + c.gEdgeVisWeight[1] + c.gEdgeVisWeight[2] + c.gEdgeVisWeight[3];
     }
 
-    // choose random order to prevent waiting
-    StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
+    // spatial order: each thread walks the rays of a batch of neighboring vertices
+    const std::vector<int> verticesOrder = getVerticesSpatialOrder(_verticesCoords);
+    const int nbVertices = verticesOrder.size();
 
     int64_t avStepsFront = 0;
     int64_t aAvStepsFront = 0;
     int64_t avStepsBehind = 0;
     int64_t nAvStepsBehind = 0;
 
-#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind)
-    for(int i = 0; i < vetexesToProcessIdsRand->size(); ++i)
+#pragma omp parallel reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind)
     {
-        int vi = (*vetexesToProcessIdsRand)[i];
+    CellsAccumulator accumulator;
+
+#pragma omp for schedule(dynamic, RAY_WALKING_BATCH_SIZE) nowait
+    for(int i = 0; i < nbVertices; ++i)
+    {
+        int vi = verticesOrder[i];
         GC_vertexInfo& v = _verticesAttr[vi];
         if(v.isVirtual())
             continue;
@@ -2011,8 +2186,7 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSi
                        (maxSilent < maxSilentPartRange)) // g < k_outl                  //// k_outl=100  // 400 in the paper
                         //(maxSilent-minSilent<maxSilentPartRange))
                     {
-#pragma OMP_ATOMIC_UPDATE
-                        _cellsAttr[ci].on += (maxJump - midSilent);
+                        accumulator.add(ci, CellsAccumulator::ON, maxJump - midSilent);
                     }
                 }
             }
@@ -2022,9 +2196,13 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSi
             avStepsBehind += nstepsBehind;
             nAvStepsBehind += 1;
         }
+
+        if(accumulator.size() > RAY_WALKING_MAX_CONTRIBUTIONS)
+            accumulator.flush(_cellsAttr);
     }
 
-    delete vetexesToProcessIdsRand;
+    accumulator.flush(_cellsAttr);
+    }
 
     for(GC_cellInfo& c: _cellsAttr)
     {
@@ -2472,14 +2650,9 @@ void DelaunayGraphCut::reconstructGC(const Point3d* hexah)
     ALICEVISION_LOG_INFO("reconstructGC done.");
 }
 
-void DelaunayGraphCut::maxflow()
+template <typename MaxFlow>
+void DelaunayGraphCut::fillMaxFlowGraph(MaxFlow& maxFlowGraph)
 {
-    long t_maxflow = clock();
-
-    ALICEVISION_LOG_INFO("Maxflow: start allocation.");
-    // MaxFlow_CSR maxFlowGraph(_cellsAttr.size());
-    MaxFlow_AdjList maxFlowGraph(_cellsAttr.size());
-
     ALICEVISION_LOG_INFO("Maxflow: add nodes.");
     // fill s-t edges
     for(CellIndex ci = 0; ci < _cellsAttr.size(); ++ci)
@@ -2532,6 +2705,15 @@ void DelaunayGraphCut::maxflow()
             maxFlowGraph.addEdge(fu.cellIndex, fv.cellIndex, wFuFv, wFvFu);
         }
     }
+}
+
+template <typename MaxFlow>
+void DelaunayGraphCut::computeMaxFlow()
+{
+    ALICEVISION_LOG_INFO("Maxflow: start allocation.");
+    MaxFlow maxFlowGraph(_cellsAttr.size());
+
+    fillMaxFlowGraph(maxFlowGraph);
 
     ALICEVISION_LOG_INFO("Maxflow: clear cells info.");
     const std::size_t nbCells = _cellsAttr.size();
@@ -2551,6 +2733,31 @@ void DelaunayGraphCut::maxflow()
     {
         _cellIsFull[ci] = maxFlowGraph.isTarget(ci);
     }
+}
+
+void DelaunayGraphCut::maxflow()
+{
+    long t_maxflow = clock();
+
+    // save the graph to replay it with the maxflow benchmark
+    const std::string maxflowGraphFilepath = mp->_ini.get<std::string>("delaunaycut.saveMaxflowGraph", "");
+    if(!maxflowGraphFilepath.empty())
+    {
+        MaxFlowGraph maxFlowGraph(_cellsAttr.size());
+        fillMaxFlowGraph(maxFlowGraph);
+        maxFlowGraph.save(maxflowGraphFilepath);
+        ALICEVISION_LOG_INFO("Maxflow graph saved: " << maxflowGraphFilepath);
+    }
+
+    const EMaxFlowSolver solver = EMaxFlowSolver_stringToEnum(
+        mp->_ini.get<std::string>("delaunaycut.maxflowSolver", EMaxFlowSolver_enumToString(EMaxFlowSolver::BOYKOV_KOLMOGOROV)));
+    ALICEVISION_LOG_INFO("Maxflow solver: " << solver);
+
+    switch(solver)
+    {
+        case EMaxFlowSolver::BOYKOV_KOLMOGOROV: computeMaxFlow<MaxFlow_AdjList>(); break;
+        case EMaxFlowSolver::PUSH_RELABEL:      computeMaxFlow<MaxFlow_PushRelabel>(); break;
+    }
 
     mvsUtils::printfElapsedTime(t_maxflow, "Full maxflow step");
 
@@ -14,6 +14,7 @@
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
 #include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/fuseCut/CellsAccumulator.hpp>
 #include <aliceVision/fuseCut/delaunayGraphCutTypes.hpp>
 #include <aliceVision/fuseCut/VoxelsGrid.hpp>
 
@@ -24,6 +25,8 @@
 
 #include <map>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace fuseCut {
@@ -31,10 +34,15 @@ namespace fuseCut {
 
 struct FuseParams
 {
-    /// Max input points loaded from images
+    /// Max input points loaded from images (density of the depth values sampled in the depth maps)
     int maxInputPoints = 50000000;
     /// Max points at the end of the depth maps fusion
     int maxPoints = 5000000;
+    /// Memory budget (in MB) of the depth maps fusion. If not 0, the input points are spilled to disk
+    /// and filtered by spatial buckets fitting in this budget, otherwise they are all fused in memory.
+    int maxMemory = 0;
+    /// Folder of the temporary files of the fusion with a memory budget (system temporary folder if empty)
+    std::string tmpFolder;
     /// The step used to load depth values from depth maps is computed from maxInputPts. Here we define the minimal value for this step,
     /// so on small datasets we will not spend too much time at the beginning loading all depth values.
     int minStep = 2;
@@ -51,6 +59,13 @@ struct FuseParams
     bool refineFuse = true;
 };
 
+/**
+ * @brief Filter the points by pixel size to remove the duplicates: a point is discarded (pixSize set to -1)
+ * if a point of smaller simScore * pixSize^2 is closer than sqrt(pixSizeMarginCoef * simScore * pixSize^2).
+ * The points with a pixSize of -1 before the filtering are ignored.
+ */
+void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, double pixSizeMarginCoef, std::vector<float>& simScorePrepare);
+
 
 class DelaunayGraphCut
 {
@@ -291,7 +306,7 @@ public:
                            bool fillOut, float distFcnHeight = 0.0f);
     void fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam, float weight,
                            bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool fillOut,
-                           float distFcnHeight);
+                           float distFcnHeight, CellsAccumulator& accumulator);
 
     void forceTedgesByGradientCVPR11(bool fixesSigma, float nPixelSizeBehind);
     void forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSizeBehind);
@@ -309,8 +324,20 @@ public:
 
     void reconstructGC(const Point3d* hexah);
 
+    /**
+     * @brief Compute the graph-cut of the cells with the maxflow solver of the "delaunaycut.maxflowSolver" setting
+     * and update the full/empty status of the cells.
+     */
     void maxflow();
 
+    /// Add the cells (with their source/sink weights) and facets (with their weights) to a maxflow graph
+    template <typename MaxFlow>
+    void fillMaxFlowGraph(MaxFlow& maxFlowGraph);
+
+    /// Compute the graph-cut with a maxflow solver (the cells info are cleared to save memory)
+    template <typename MaxFlow>
+    void computeMaxFlow();
+
     void reconstructExpetiments(const StaticVector<int>& cams, const std::string& folderName,
                                 bool update, Point3d hexahInflated[8], const std::string& tmpCamsPtsFolderName,
                                 const Point3d& spaceSteps);
@@ -0,0 +1,110 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MaxFlowGraph.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace fuseCut {
+
+namespace {
+
+const std::uint32_t maxFlowGraphMagic = 0x464d5641; // "AVMF"
+const std::uint32_t maxFlowGraphVersion = 1;
+
+} // namespace
+
+std::string EMaxFlowSolver_enumToString(EMaxFlowSolver solver)
+{
+    switch(solver)
+    {
+        case EMaxFlowSolver::BOYKOV_KOLMOGOROV: return "boykov_kolmogorov";
+        case EMaxFlowSolver::PUSH_RELABEL:      return "push_relabel";
+    }
+    throw std::out_of_range("Invalid EMaxFlowSolver enum");
+}
+
+EMaxFlowSolver EMaxFlowSolver_stringToEnum(const std::string& solver)
+{
+    std::string type = solver;
+    std::transform(type.begin(), type.end(), type.begin(), ::tolower); //tolower
+
+    if(type == "boykov_kolmogorov") return EMaxFlowSolver::BOYKOV_KOLMOGOROV;
+    if(type == "push_relabel")      return EMaxFlowSolver::PUSH_RELABEL;
+
+    throw std::out_of_range("Invalid maxflow solver: " + solver);
+}
+
+std::ostream& operator<<(std::ostream& os, EMaxFlowSolver solver)
+{
+    return os << EMaxFlowSolver_enumToString(solver);
+}
+
+std::istream& operator>>(std::istream& in, EMaxFlowSolver& solver)
+{
+    std::string token;
+    in >> token;
+    solver = EMaxFlowSolver_stringToEnum(token);
+    return in;
+}
+
+void MaxFlowGraph::save(const std::string& filepath) const
+{
+    FILE* f = fopen(filepath.c_str(), "wb");
+    if(f == nullptr)
+        throw std::runtime_error("Unable to open maxflow graph file: " + filepath);
+
+    const std::uint64_t nbNodes = _source.size();
+    const std::uint64_t nbEdges = _edges.size();
+    bool ok = fwrite(&maxFlowGraphMagic, sizeof(maxFlowGraphMagic), 1, f) == 1 &&
+              fwrite(&maxFlowGraphVersion, sizeof(maxFlowGraphVersion), 1, f) == 1 &&
+              fwrite(&nbNodes, sizeof(nbNodes), 1, f) == 1 &&
+              fwrite(&nbEdges, sizeof(nbEdges), 1, f) == 1;
+    ok = ok && fwrite(_source.data(), sizeof(ValueType), nbNodes, f) == nbNodes;
+    ok = ok && fwrite(_sink.data(), sizeof(ValueType), nbNodes, f) == nbNodes;
+    ok = ok && fwrite(_edges.data(), sizeof(Edge), nbEdges, f) == nbEdges;
+    fclose(f);
+
+    if(!ok)
+        throw std::runtime_error("Unable to write maxflow graph file: " + filepath);
+}
+
+void MaxFlowGraph::load(const std::string& filepath)
+{
+    FILE* f = fopen(filepath.c_str(), "rb");
+    if(f == nullptr)
+        throw std::runtime_error("Unable to open maxflow graph file: " + filepath);
+
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint64_t nbNodes = 0;
+    std::uint64_t nbEdges = 0;
+    bool ok = fread(&magic, sizeof(magic), 1, f) == 1 &&
+              fread(&version, sizeof(version), 1, f) == 1 &&
+              magic == maxFlowGraphMagic && version == maxFlowGraphVersion &&
+              fread(&nbNodes, sizeof(nbNodes), 1, f) == 1 &&
+              fread(&nbEdges, sizeof(nbEdges), 1, f) == 1;
+    if(ok)
+    {
+        _source.resize(nbNodes);
+        _sink.resize(nbNodes);
+        _edges.resize(nbEdges);
+        ok = fread(_source.data(), sizeof(ValueType), nbNodes, f) == nbNodes &&
+             fread(_sink.data(), sizeof(ValueType), nbNodes, f) == nbNodes &&
+             fread(_edges.data(), sizeof(Edge), nbEdges, f) == nbEdges;
+    }
+    fclose(f);
+
+    if(!ok)
+        throw std::runtime_error("Invalid maxflow graph file: " + filepath);
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
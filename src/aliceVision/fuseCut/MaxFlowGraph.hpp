@@ -0,0 +1,104 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Maxflow solver used by the graph-cut of DelaunayGraphCut.
+ */
+enum class EMaxFlowSolver
+{
+    /// Boykov-Kolmogorov on a boost adjacency list (MaxFlow_AdjList)
+    BOYKOV_KOLMOGOROV = 0,
+    /// Multithreaded push-relabel on a compressed sparse row graph (MaxFlow_PushRelabel)
+    PUSH_RELABEL
+};
+
+std::string EMaxFlowSolver_enumToString(EMaxFlowSolver solver);
+EMaxFlowSolver EMaxFlowSolver_stringToEnum(const std::string& solver);
+
+std::ostream& operator<<(std::ostream& os, EMaxFlowSolver solver);
+std::istream& operator>>(std::istream& in, EMaxFlowSolver& solver);
+
+/**
+ * @brief Maxflow graph stored as it is given to a maxflow solver, to save it and replay it with any solver.
+ *
+ * It has the same interface than the solvers to build the graph.
+ */
+class MaxFlowGraph
+{
+public:
+    using NodeType = unsigned int;
+    using ValueType = float;
+
+    struct Edge
+    {
+        NodeType n1;
+        NodeType n2;
+        ValueType capacity;
+        ValueType reverseCapacity;
+    };
+
+    explicit MaxFlowGraph(std::size_t numNodes = 0)
+        : _source(numNodes, 0.0f)
+        , _sink(numNodes, 0.0f)
+    {}
+
+    inline void addNode(NodeType n, ValueType source, ValueType sink)
+    {
+        _source[n] = source;
+        _sink[n] = sink;
+    }
+
+    inline void addEdge(NodeType n1, NodeType n2, ValueType capacity, ValueType reverseCapacity)
+    {
+        _edges.push_back({n1, n2, capacity, reverseCapacity});
+    }
+
+    std::size_t getNbNodes() const { return _source.size(); }
+    std::size_t getNbEdges() const { return _edges.size(); }
+
+    /**
+     * @brief Give the nodes and edges to a maxflow solver, in the order they were added.
+     * @param[in,out] maxFlow solver created with getNbNodes() nodes
+     */
+    template <typename MaxFlow>
+    void fill(MaxFlow& maxFlow) const
+    {
+        for(std::size_t n = 0; n < _source.size(); ++n)
+            maxFlow.addNode(n, _source[n], _sink[n]);
+        for(const Edge& edge : _edges)
+            maxFlow.addEdge(edge.n1, edge.n2, edge.capacity, edge.reverseCapacity);
+    }
+
+    /**
+     * @brief Save the graph in a binary file.
+     * @param[in] filepath the output file path
+     */
+    void save(const std::string& filepath) const;
+
+    /**
+     * @brief Load a graph saved with save().
+     * @param[in] filepath the input file path
+     */
+    void load(const std::string& filepath);
+
+private:
+    std::vector<ValueType> _source;
+    std::vector<ValueType> _sink;
+    std::vector<Edge> _edges;
+};
+
+} // namespace fuseCut
+} // namespace aliceVision
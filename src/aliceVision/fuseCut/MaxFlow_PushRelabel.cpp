@@ -0,0 +1,324 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MaxFlow_PushRelabel.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace aliceVision {
+namespace fuseCut {
+
+MaxFlow_PushRelabel::MaxFlow_PushRelabel(std::size_t numNodes)
+    : _numNodes(static_cast<unsigned int>(numNodes))
+    , _unreachableLabel(static_cast<unsigned int>(numNodes) + 1)
+    , _excess(numNodes, 0.0f)
+    , _sinkResidual(numNodes, 0.0f)
+{
+    // the labels go up to numNodes + 1, and are incremented
+    if(numNodes >= std::numeric_limits<unsigned int>::max() - 2)
+        throw std::runtime_error("Too many nodes for the maxflow graph: " + std::to_string(numNodes));
+
+    // estimation of the number of edges of a tetrahedralization: 4 facets, added from both cells
+    _inputEdges.reserve(numNodes * 4);
+}
+
+void MaxFlow_PushRelabel::buildGraph()
+{
+    _firstEdge.assign(_numNodes + 1, 0);
+    for(const InputEdge& edge : _inputEdges)
+    {
+        ++_firstEdge[edge.n1 + 1];
+        ++_firstEdge[edge.n2 + 1];
+    }
+    for(std::size_t n = 0; n < _numNodes; ++n)
+        _firstEdge[n + 1] += _firstEdge[n];
+
+    const EdgeIndex nbEdges = _firstEdge[_numNodes];
+    _edgeTarget.resize(nbEdges);
+    _edgeReverse.resize(nbEdges);
+    std::vector<std::atomic<ValueType>>(nbEdges).swap(_residual);
+
+    std::vector<EdgeIndex> position(_firstEdge.begin(), _firstEdge.end() - 1);
+    for(const InputEdge& edge : _inputEdges)
+    {
+        const EdgeIndex e1 = position[edge.n1]++;
+        const EdgeIndex e2 = position[edge.n2]++;
+        _edgeTarget[e1] = edge.n2;
+        _edgeTarget[e2] = edge.n1;
+        _edgeReverse[e1] = e2;
+        _edgeReverse[e2] = e1;
+        _residual[e1].store(edge.capacity, std::memory_order_relaxed);
+        _residual[e2].store(edge.reverseCapacity, std::memory_order_relaxed);
+    }
+    std::vector<InputEdge>().swap(_inputEdges); // force clear
+
+    ALICEVISION_LOG_INFO("# vertices: " << _numNodes);
+    ALICEVISION_LOG_INFO("# edges: " << nbEdges);
+}
+
+void MaxFlow_PushRelabel::globalRelabel()
+{
+    const long numNodes = _numNodes;
+    std::vector<NodeType> frontier;
+
+    // nodes connected to the sink
+    #pragma omp parallel
+    {
+        std::vector<NodeType> localFrontier;
+        #pragma omp for
+        for(long v = 0; v < numNodes; ++v)
+        {
+            if(_sinkResidual[v] > 0)
+            {
+                _label[v] = 1;
+                _isDiscovered[v].store(true, std::memory_order_relaxed);
+                localFrontier.push_back(v);
+            }
+            else
+            {
+                _label[v] = _unreachableLabel;
+            }
+        }
+        #pragma omp critical
+        frontier.insert(frontier.end(), localFrontier.begin(), localFrontier.end());
+    }
+
+    // breadth-first search in the reverse residual graph
+    for(unsigned int level = 2; !frontier.empty(); ++level)
+    {
+        const long frontierSize = frontier.size();
+        std::vector<NodeType> nextFrontier;
+        #pragma omp parallel
+        {
+            std::vector<NodeType> localFrontier;
+            #pragma omp for schedule(dynamic, 256)
+            for(long i = 0; i < frontierSize; ++i)
+            {
+                const NodeType w = frontier[i];
+                for(EdgeIndex e = _firstEdge[w]; e < _firstEdge[w + 1]; ++e)
+                {
+                    const NodeType u = _edgeTarget[e];
+                    if(_residual[_edgeReverse[e]].load(std::memory_order_relaxed) > 0 &&
+                       !_isDiscovered[u].load(std::memory_order_relaxed) &&
+                       !_isDiscovered[u].exchange(true))
+                    {
+                        _label[u] = level;
+                        localFrontier.push_back(u);
+                    }
+                }
+            }
+            #pragma omp critical
+            nextFrontier.insert(nextFrontier.end(), localFrontier.begin(), localFrontier.end());
+        }
+        frontier.swap(nextFrontier);
+    }
+
+    #pragma omp parallel for
+    for(long v = 0; v < numNodes; ++v)
+        _isDiscovered[v].store(false, std::memory_order_relaxed);
+}
+
+void MaxFlow_PushRelabel::updateActiveNodes()
+{
+    const long numNodes = _numNodes;
+    _activeNodes.clear();
+    #pragma omp parallel
+    {
+        std::vector<NodeType> localActiveNodes;
+        #pragma omp for
+        for(long v = 0; v < numNodes; ++v)
+        {
+            if(_excess[v] > 0 && _label[v] < _unreachableLabel)
+                localActiveNodes.push_back(v);
+        }
+        #pragma omp critical
+        _activeNodes.insert(_activeNodes.end(), localActiveNodes.begin(), localActiveNodes.end());
+    }
+}
+
+std::size_t MaxFlow_PushRelabel::discharge(NodeType v, std::vector<NodeType>& discoveredNodes)
+{
+    const unsigned int labelV = _label[v];
+    unsigned int label = labelV;
+    ValueType excess = _excess[v];
+    std::size_t work = 0;
+
+    while(excess > 0)
+    {
+        unsigned int newLabel = _unreachableLabel;
+        bool skipped = false;
+
+        // sink edge (the sink has the label 0)
+        if(_sinkResidual[v] > 0)
+        {
+            if(label == 1)
+            {
+                const ValueType delta = std::min(_sinkResidual[v], excess);
+                _sinkResidual[v] -= delta;
+                excess -= delta;
+            }
+            if(_sinkResidual[v] > 0)
+                newLabel = 1;
+        }
+
+        for(EdgeIndex e = _firstEdge[v]; e < _firstEdge[v + 1] && excess > 0; ++e)
+        {
+            ++work;
+            ValueType residual = _residual[e].load(std::memory_order_relaxed);
+            if(residual <= 0)
+                continue;
+
+            const NodeType w = _edgeTarget[e];
+            const unsigned int labelW = _label[w];
+            const bool admissible = (label == labelW + 1);
+
+            // if both nodes are active, only one of them is allowed to push on the edge between them
+            if(admissible && _excess[w] > 0 && labelW < _unreachableLabel)
+            {
+                const bool win = (labelV == labelW + 1) || (labelV + 1 < labelW) || (labelV == labelW && v < w);
+                if(!win)
+                {
+                    skipped = true;
+                    continue;
+                }
+            }
+
+            if(admissible)
+            {
+                const ValueType delta = std::min(residual, excess);
+                residual -= delta;
+                _residual[e].store(residual, std::memory_order_relaxed);
+                atomicAdd(_residual[_edgeReverse[e]], delta);
+                atomicAdd(_addedExcess[w], delta);
+                excess -= delta;
+                if(!_isDiscovered[w].exchange(true))
+                    discoveredNodes.push_back(w);
+            }
+            if(residual > 0)
+                newLabel = std::min(newLabel, labelW + 1);
+        }
+
+        if(excess <= 0 || skipped)
+            break;
+
+        // relabel
+        label = newLabel;
+        if(label >= _unreachableLabel)
+            break;
+    }
+
+    _newLabel[v] = label;
+    atomicAdd(_addedExcess[v], excess - _excess[v]);
+    if(excess > 0 && label < _unreachableLabel && !_isDiscovered[v].exchange(true))
+        discoveredNodes.push_back(v);
+
+    return work;
+}
+
+MaxFlow_PushRelabel::ValueType MaxFlow_PushRelabel::compute()
+{
+    ALICEVISION_LOG_INFO("Compute parallel push-relabel max flow.");
+
+    buildGraph();
+
+    const long numNodes = _numNodes;
+    _sinkCapacity = _sinkResidual;
+    _label.assign(_numNodes, _unreachableLabel);
+    _newLabel.assign(_numNodes, _unreachableLabel);
+    std::vector<std::atomic<ValueType>>(_numNodes).swap(_addedExcess);
+    std::vector<std::atomic<bool>>(_numNodes).swap(_isDiscovered);
+    #pragma omp parallel for
+    for(long v = 0; v < numNodes; ++v)
+    {
+        _addedExcess[v].store(0.0f, std::memory_order_relaxed);
+        _isDiscovered[v].store(false, std::memory_order_relaxed);
+    }
+
+    // work between two global relabels
+    const std::size_t maxWork = 6 * std::size_t(_numNodes) + _edgeTarget.size();
+    std::size_t work = 0;
+    std::size_t nbRounds = 0;
+    std::size_t nbGlobalRelabels = 0;
+    bool exactLabels = false;
+
+    std::vector<NodeType> discoveredNodes;
+
+    for(;;)
+    {
+        if(!exactLabels && (_activeNodes.empty() || work > maxWork))
+        {
+            // the search stops only if there is no active node with exact labels
+            globalRelabel();
+            updateActiveNodes();
+            ++nbGlobalRelabels;
+            work = 0;
+            exactLabels = true;
+        }
+        if(_activeNodes.empty())
+            break;
+
+        const long nbActiveNodes = _activeNodes.size();
+        discoveredNodes.clear();
+
+        #pragma omp parallel reduction(+:work)
+        {
+            std::vector<NodeType> localDiscoveredNodes;
+            #pragma omp for schedule(dynamic, 64)
+            for(long i = 0; i < nbActiveNodes; ++i)
+                work += discharge(_activeNodes[i], localDiscoveredNodes);
+
+            #pragma omp critical
+            discoveredNodes.insert(discoveredNodes.end(), localDiscoveredNodes.begin(), localDiscoveredNodes.end());
+        }
+
+        // apply the new labels and excesses
+        #pragma omp parallel for
+        for(long i = 0; i < nbActiveNodes; ++i)
+        {
+            const NodeType v = _activeNodes[i];
+            _label[v] = _newLabel[v];
+            _excess[v] += _addedExcess[v].exchange(0.0f, std::memory_order_relaxed);
+        }
+        const long nbDiscoveredNodes = discoveredNodes.size();
+        #pragma omp parallel for
+        for(long i = 0; i < nbDiscoveredNodes; ++i)
+        {
+            const NodeType v = discoveredNodes[i];
+            _excess[v] += _addedExcess[v].exchange(0.0f, std::memory_order_relaxed);
+            _isDiscovered[v].store(false, std::memory_order_relaxed);
+        }
+
+        _activeNodes.clear();
+        for(NodeType v : discoveredNodes)
+        {
+            if(_excess[v] > 0 && _label[v] < _unreachableLabel)
+                _activeNodes.push_back(v);
+        }
+        // keep the memory access pattern close to the graph layout
+        std::sort(_activeNodes.begin(), _activeNodes.end());
+
+        exactLabels = false;
+        ++nbRounds;
+    }
+
+    double flow = 0.0;
+    #pragma omp parallel for reduction(+:flow)
+    for(long v = 0; v < numNodes; ++v)
+        flow += _sinkCapacity[v] - _sinkResidual[v];
+
+    ALICEVISION_LOG_INFO("Parallel push-relabel max flow: " << nbRounds << " rounds, " << nbGlobalRelabels << " global relabels.");
+
+    return static_cast<ValueType>(flow);
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
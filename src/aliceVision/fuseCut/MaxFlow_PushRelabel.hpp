@@ -0,0 +1,138 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Multithreaded maxflow computation based on a synchronous parallel push-relabel algorithm
+ * on a compressed sparse row graph.
+ *
+ * Each round discharges all the active nodes in parallel (with a deterministic rule to decide which
+ * node of a pair of active neighbors is allowed to push), then applies the excess received by the nodes.
+ * The labels are regularly recomputed by a parallel breadth-first search from the sink (global relabel).
+ * See "Efficient Implementation of a Synchronous Parallel Push-Relabel Algorithm", Baumstark et al., ESA 2015.
+ *
+ * Only the first phase of push-relabel is computed (maximum preflow), which is enough to get the minimum cut:
+ * the target nodes are the nodes that can still reach the sink in the residual graph.
+ * It is the same cut as the one given by the Boykov-Kolmogorov algorithm (sink tree) in MaxFlow_AdjList.
+ *
+ * The source and sink edges are not stored as edges of the graph: the source capacities are the initial
+ * excesses of the nodes and the sink capacities are stored per node. An edge only stores its target,
+ * its reverse edge and its residual capacity.
+ */
+class MaxFlow_PushRelabel
+{
+public:
+    using NodeType = unsigned int;
+    using ValueType = float;
+    using EdgeIndex = std::size_t;
+
+    explicit MaxFlow_PushRelabel(std::size_t numNodes);
+
+    inline void addNode(NodeType n, ValueType source, ValueType sink)
+    {
+        assert(source >= 0 && sink >= 0);
+        const ValueType score = source - sink;
+        if(score > 0)
+            _excess[n] = score;
+        else
+            _sinkResidual[n] = -score;
+    }
+
+    inline void addEdge(NodeType n1, NodeType n2, ValueType capacity, ValueType reverseCapacity)
+    {
+        assert(capacity >= 0 && reverseCapacity >= 0);
+        _inputEdges.push_back({n1, n2, capacity, reverseCapacity});
+    }
+
+    /**
+     * @brief Compute the maximum flow.
+     * @return the value of the flow
+     */
+    ValueType compute();
+
+    /// is empty
+    inline bool isSource(NodeType n) const
+    {
+        return !isTarget(n);
+    }
+    /// is full
+    inline bool isTarget(NodeType n) const
+    {
+        return _label[n] < _unreachableLabel;
+    }
+
+private:
+    struct InputEdge
+    {
+        NodeType n1;
+        NodeType n2;
+        ValueType capacity;
+        ValueType reverseCapacity;
+    };
+
+    /// Build the compressed sparse row graph from the input edges
+    void buildGraph();
+
+    /**
+     * @brief Compute the exact distance of all nodes to the sink in the residual graph.
+     * The nodes which cannot reach the sink get the label _unreachableLabel.
+     */
+    void globalRelabel();
+
+    /// Fill the active nodes (positive excess and connected to the sink)
+    void updateActiveNodes();
+
+    /**
+     * @brief Push the excess of an active node to its admissible neighbors and relabel it
+     * until it has no excess or cannot be processed anymore in this round.
+     * @param[in] v the active node
+     * @param[out] discoveredNodes the nodes which received some excess (and v if it is still active)
+     * @return the number of visited edges
+     */
+    std::size_t discharge(NodeType v, std::vector<NodeType>& discoveredNodes);
+
+    static void atomicAdd(std::atomic<ValueType>& value, ValueType delta)
+    {
+        ValueType current = value.load(std::memory_order_relaxed);
+        while(!value.compare_exchange_weak(current, current + delta, std::memory_order_relaxed))
+            ;
+    }
+
+    const unsigned int _numNodes;
+    /// label of the nodes which cannot reach the sink, the distance to the sink is at most _numNodes
+    const unsigned int _unreachableLabel;
+
+    std::vector<InputEdge> _inputEdges;
+
+    // compressed sparse row graph
+    std::vector<EdgeIndex> _firstEdge;
+    std::vector<NodeType> _edgeTarget;
+    std::vector<EdgeIndex> _edgeReverse;
+    std::vector<std::atomic<ValueType>> _residual;
+
+    // nodes
+    std::vector<ValueType> _excess;
+    std::vector<ValueType> _sinkCapacity;
+    std::vector<ValueType> _sinkResidual;
+    std::vector<std::atomic<ValueType>> _addedExcess;
+    std::vector<unsigned int> _label;
+    std::vector<unsigned int> _newLabel;
+    std::vector<std::atomic<bool>> _isDiscovered;
+
+    std::vector<NodeType> _activeNodes;
+};
+
+} // namespace fuseCut
+} // namespace aliceVision
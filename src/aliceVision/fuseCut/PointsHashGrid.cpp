@@ -0,0 +1,100 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PointsHashGrid.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace fuseCut {
+
+const std::size_t PointsHashGrid::noPoint;
+
+PointsHashGrid::PointsHashGrid(const std::vector<Point3d>& points, double cellSize)
+    : _points(points)
+    , _cellSize(cellSize)
+{
+    if(!(cellSize > 0.0))
+        throw std::invalid_argument("PointsHashGrid: the cell size should be strictly positive.");
+}
+
+PointsHashGrid::CellKey PointsHashGrid::getCellKey(std::int64_t x, std::int64_t y, std::int64_t z) const
+{
+    // 21 bits per axis: far cells may share the same key, which is fine as the distances are checked
+    const std::uint64_t mask = (1 << 21) - 1;
+    return (std::uint64_t(x) & mask) | ((std::uint64_t(y) & mask) << 21) | ((std::uint64_t(z) & mask) << 42);
+}
+
+void PointsHashGrid::getCellCoords(const Point3d& p, std::int64_t& x, std::int64_t& y, std::int64_t& z) const
+{
+    x = static_cast<std::int64_t>(std::floor(p.x / _cellSize));
+    y = static_cast<std::int64_t>(std::floor(p.y / _cellSize));
+    z = static_cast<std::int64_t>(std::floor(p.z / _cellSize));
+}
+
+void PointsHashGrid::build()
+{
+    const long nbPoints = _points.size();
+    std::vector<CellKey> keys(nbPoints);
+
+    #pragma omp parallel for
+    for(long i = 0; i < nbPoints; ++i)
+    {
+        std::int64_t x, y, z;
+        getCellCoords(_points[i], x, y, z);
+        keys[i] = getCellKey(x, y, z);
+    }
+
+    _cells.clear();
+    _cells.reserve(nbPoints / 4 + 1);
+    for(long i = 0; i < nbPoints; ++i)
+        _cells[keys[i]].push_back(i);
+}
+
+void PointsHashGrid::add(std::size_t pointIndex)
+{
+    std::int64_t x, y, z;
+    getCellCoords(_points[pointIndex], x, y, z);
+    _cells[getCellKey(x, y, z)].push_back(pointIndex);
+}
+
+std::size_t PointsHashGrid::findNearest(const Point3d& p, double radius) const
+{
+    std::int64_t cx, cy, cz;
+    getCellCoords(p, cx, cy, cz);
+
+    std::size_t nearest = noPoint;
+    double nearestDist2 = radius * radius;
+    for(std::int64_t z = cz - 1; z <= cz + 1; ++z)
+    {
+        for(std::int64_t y = cy - 1; y <= cy + 1; ++y)
+        {
+            for(std::int64_t x = cx - 1; x <= cx + 1; ++x)
+            {
+                const auto it = _cells.find(getCellKey(x, y, z));
+                if(it == _cells.end())
+                    continue;
+                for(std::size_t pointIndex : it->second)
+                {
+                    const Point3d d = _points[pointIndex] - p;
+                    const double dist2 = d.x * d.x + d.y * d.y + d.z * d.z;
+                    if(dist2 <= nearestDist2)
+                    {
+                        nearestDist2 = dist2;
+                        nearest = pointIndex;
+                    }
+                }
+            }
+        }
+    }
+    return nearest;
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
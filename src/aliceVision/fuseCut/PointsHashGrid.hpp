@@ -0,0 +1,71 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Uniform hash grid over a vector of points, to find the points close to a position.
+ *
+ * The grid does not own the points: it keeps a reference on the vector, so points can be
+ * appended to the vector and then added to the grid with add().
+ * The cell size should be close to the search radius, as only the 27 cells around the query are visited.
+ */
+class PointsHashGrid
+{
+public:
+    static const std::size_t noPoint = std::numeric_limits<std::size_t>::max();
+
+    /**
+     * @param[in] points the indexed points
+     * @param[in] cellSize the size of the grid cells (should be the search radius)
+     */
+    PointsHashGrid(const std::vector<Point3d>& points, double cellSize);
+
+    /**
+     * @brief Index all the points of the vector (in parallel), replacing the previous content of the grid.
+     */
+    void build();
+
+    /**
+     * @brief Index a point of the vector (typically just appended).
+     * @param[in] pointIndex the index of the point in the vector
+     */
+    void add(std::size_t pointIndex);
+
+    /**
+     * @brief Find the nearest indexed point in a radius around a position.
+     * @param[in] p the position
+     * @param[in] radius the search radius, lower or equal to the cell size
+     * @return the index of the nearest point or noPoint if there is no point in the radius
+     */
+    std::size_t findNearest(const Point3d& p, double radius) const;
+
+    std::size_t getNbCells() const { return _cells.size(); }
+
+private:
+    using CellKey = std::uint64_t;
+
+    CellKey getCellKey(std::int64_t x, std::int64_t y, std::int64_t z) const;
+    void getCellCoords(const Point3d& p, std::int64_t& x, std::int64_t& y, std::int64_t& z) const;
+
+    const std::vector<Point3d>& _points;
+    const double _cellSize;
+    std::unordered_map<CellKey, std::vector<std::size_t>> _cells;
+};
+
+} // namespace fuseCut
+} // namespace aliceVision
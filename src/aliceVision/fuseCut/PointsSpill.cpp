@@ -0,0 +1,349 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PointsSpill.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace fuseCut {
+
+PointsSpill::PointsSpill(const std::string& filepath, const Point3d& origin)
+    : _filepath(filepath)
+    , _origin(origin)
+{
+}
+
+PointsSpill::~PointsSpill()
+{
+    clear();
+}
+
+void PointsSpill::append(const SpilledPoint* points, std::size_t count)
+{
+    if(count == 0)
+        return;
+
+    FILE* f = fopen(_filepath.c_str(), "ab");
+    if(f == nullptr)
+        throw std::runtime_error("Unable to open temporary points file: " + _filepath);
+    const std::size_t written = fwrite(points, sizeof(SpilledPoint), count, f);
+    fclose(f);
+    if(written != count)
+        throw std::runtime_error("Unable to write temporary points file: " + _filepath);
+    _size += count;
+}
+
+void PointsSpill::read(std::size_t chunkSize, const std::function<void(const std::vector<SpilledPoint>&)>& callback) const
+{
+    if(_size == 0)
+        return;
+
+    FILE* f = fopen(_filepath.c_str(), "rb");
+    if(f == nullptr)
+        throw std::runtime_error("Unable to open temporary points file: " + _filepath);
+
+    std::vector<SpilledPoint> chunk;
+    for(std::size_t begin = 0; begin < _size; begin += chunkSize)
+    {
+        chunk.resize(std::min(chunkSize, _size - begin));
+        if(fread(chunk.data(), sizeof(SpilledPoint), chunk.size(), f) != chunk.size())
+        {
+            fclose(f);
+            throw std::runtime_error("Unable to read temporary points file: " + _filepath);
+        }
+        callback(chunk);
+    }
+    fclose(f);
+}
+
+void PointsSpill::clear()
+{
+    if(_size != 0)
+        std::remove(_filepath.c_str());
+    _size = 0;
+}
+
+namespace {
+
+namespace bfs = boost::filesystem;
+
+/// Memory used per point to filter a bucket: coordinates, pixel size, sim score, owner and discard flags and kd-tree index
+const std::size_t filterPointMemory = sizeof(Point3d) + sizeof(double) + sizeof(float) + 2 * sizeof(char) + 2 * sizeof(std::size_t);
+
+/// Maximum number of splits of a bucket exceeding the memory budget
+const int maxSplitDepth = 6;
+
+/// Point of the distribution buffer with its destination bucket
+struct BucketPoint
+{
+    std::uint32_t bucket;
+    SpilledPoint point;
+};
+
+double squaredDistanceToBox(const Point3d& p, const Point3d& boxMin, const Point3d& boxMax)
+{
+    double d2 = 0.0;
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        const double d = std::max(0.0, std::max(boxMin.m[axis] - p.m[axis], p.m[axis] - boxMax.m[axis]));
+        d2 += d * d;
+    }
+    return d2;
+}
+
+class OutOfCoreFilter
+{
+public:
+    OutOfCoreFilter(double pixSizeMarginCoef, std::size_t maxMemory, const PointsFilterFunction& filter,
+                    std::vector<Point3d>& coords, std::vector<double>& pixSize, std::vector<float>& simScore)
+        : _pixSizeMarginCoef(pixSizeMarginCoef)
+        , _filter(filter)
+        , _coords(coords)
+        , _pixSize(pixSize)
+        , _simScore(simScore)
+    {
+        // an eighth of the budget to read the points, a quarter for the distribution buffer
+        _chunkSize = std::max(std::size_t(1), maxMemory / 8 / sizeof(SpilledPoint));
+        _bufferSize = std::max(std::size_t(1), maxMemory / 4 / sizeof(BucketPoint));
+        const std::size_t chunkMemory = _chunkSize * sizeof(SpilledPoint);
+        _maxBucketPoints = std::max(std::size_t(1), (maxMemory - std::min(maxMemory, chunkMemory)) / filterPointMemory);
+    }
+
+    /**
+     * @brief Filter the points of a bucket, or split it if it exceeds the budget.
+     * The owned points (positive pixSize) of the bucket are inside [bbMin, bbMax], the other ones are only their neighbors.
+     */
+    void filterBucket(PointsSpill& points, const Point3d& bbMin, const Point3d& bbMax, int depth);
+
+    std::size_t getPeakMemory() const { return _peakMemory; }
+
+private:
+    void filterInMemory(PointsSpill& points);
+
+    const double _pixSizeMarginCoef;
+    const PointsFilterFunction& _filter;
+    std::vector<Point3d>& _coords;
+    std::vector<double>& _pixSize;
+    std::vector<float>& _simScore;
+    std::size_t _chunkSize;
+    std::size_t _bufferSize;
+    std::size_t _maxBucketPoints;
+    std::size_t _peakMemory = 0;
+};
+
+void OutOfCoreFilter::filterInMemory(PointsSpill& points)
+{
+    std::vector<Point3d> coords;
+    std::vector<double> pixSize;
+    std::vector<float> simScore;
+    std::vector<char> owned;
+    coords.reserve(points.size());
+    pixSize.reserve(points.size());
+    simScore.reserve(points.size());
+    owned.reserve(points.size());
+    points.read(_chunkSize, [&](const std::vector<SpilledPoint>& chunk)
+    {
+        for(const SpilledPoint& point : chunk)
+        {
+            coords.push_back(points.getPosition(point));
+            pixSize.push_back(std::abs(point.pixSize));
+            simScore.push_back(point.simScore);
+            owned.push_back(point.pixSize > 0.0f);
+        }
+    });
+    _peakMemory = std::max(_peakMemory, points.size() * filterPointMemory + _chunkSize * sizeof(SpilledPoint));
+    points.clear();
+
+    _filter(coords, pixSize, _pixSizeMarginCoef, simScore);
+
+    for(std::size_t i = 0; i < coords.size(); ++i)
+    {
+        if(owned[i] && pixSize[i] != -1.0)
+        {
+            _coords.push_back(coords[i]);
+            _pixSize.push_back(pixSize[i]);
+            _simScore.push_back(simScore[i]);
+        }
+    }
+}
+
+void OutOfCoreFilter::filterBucket(PointsSpill& points, const Point3d& bbMin, const Point3d& bbMax, int depth)
+{
+    if(points.size() == 0)
+        return;
+    if(points.size() <= _maxBucketPoints || depth >= maxSplitDepth)
+    {
+        if(points.size() > _maxBucketPoints)
+            ALICEVISION_LOG_WARNING("The bucket of " << points.size() << " points can't be split, it exceeds the memory budget.");
+        filterInMemory(points);
+        return;
+    }
+
+    // regular grid with cells as cubic as possible, the longest side of the cells is split until there are
+    // enough buckets, the budget is an estimate for uniformly distributed points
+    const std::size_t minNbBuckets = (points.size() + _maxBucketPoints - 1) / _maxBucketPoints;
+    const Point3d extent = bbMax - bbMin;
+    const double maxExtent = std::max(std::max(extent.x, extent.y), std::max(extent.z, std::numeric_limits<double>::epsilon()));
+    const Point3d validExtent(std::max(extent.x, maxExtent * 1e-6), std::max(extent.y, maxExtent * 1e-6), std::max(extent.z, maxExtent * 1e-6));
+    int gridDim[3] = {1, 1, 1};
+    while(std::size_t(gridDim[0]) * gridDim[1] * gridDim[2] < minNbBuckets)
+    {
+        int axis = 0;
+        for(int a = 1; a < 3; ++a)
+        {
+            if(validExtent.m[a] / gridDim[a] > validExtent.m[axis] / gridDim[axis])
+                axis = a;
+        }
+        ++gridDim[axis];
+    }
+    const Point3d cellSizes(validExtent.x / gridDim[0], validExtent.y / gridDim[1], validExtent.z / gridDim[2]);
+    const std::size_t nbBuckets = std::size_t(gridDim[0]) * gridDim[1] * gridDim[2];
+    // the cells are enlarged to contain their points despite the rounding errors
+    const double margin = 1e-6 * std::max(std::max(cellSizes.x, cellSizes.y), cellSizes.z);
+
+    const auto cellCoord = [&](double value, int axis) {
+        return std::min(gridDim[axis] - 1, std::max(0, int(std::floor((value - bbMin.m[axis]) / cellSizes.m[axis]))));
+    };
+    const auto cellMin = [&](int x, int y, int z) {
+        return Point3d(bbMin.x + x * cellSizes.x - margin, bbMin.y + y * cellSizes.y - margin, bbMin.z + z * cellSizes.z - margin);
+    };
+    const auto cellMax = [&](int x, int y, int z) {
+        return Point3d(bbMin.x + (x + 1) * cellSizes.x + margin, bbMin.y + (y + 1) * cellSizes.y + margin, bbMin.z + (z + 1) * cellSizes.z + margin);
+    };
+
+    // largest score of the owned points of each bucket: a point can only discard the points of larger score
+    // closer than sqrt(pixSizeMarginCoef * score)
+    std::vector<double> maxScores(nbBuckets, 0.0);
+    double maxScore = 0.0;
+    points.read(_chunkSize, [&](const std::vector<SpilledPoint>& chunk)
+    {
+        for(const SpilledPoint& point : chunk)
+        {
+            if(point.pixSize <= 0.0f)
+                continue;
+            const Point3d p = points.getPosition(point);
+            const std::size_t b = (std::size_t(cellCoord(p.z, 2)) * gridDim[1] + cellCoord(p.y, 1)) * gridDim[0] + cellCoord(p.x, 0);
+            const double score = point.simScore * double(point.pixSize) * double(point.pixSize);
+            maxScores[b] = std::max(maxScores[b], score);
+            maxScore = std::max(maxScore, score);
+        }
+    });
+    const double maxRadius = std::sqrt(_pixSizeMarginCoef * maxScore) + margin;
+
+    ALICEVISION_LOG_INFO("Distribute " << points.size() << " points in " << gridDim[0] << "x" << gridDim[1] << "x" << gridDim[2] << " buckets.");
+
+    const bfs::path pointsPath(points.getFilepath());
+    std::vector<std::unique_ptr<PointsSpill>> buckets(nbBuckets);
+    for(std::size_t b = 0; b < nbBuckets; ++b)
+    {
+        const bfs::path bucketPath = pointsPath.parent_path() / (pointsPath.stem().string() + "_" + std::to_string(b) + ".bin");
+        buckets[b].reset(new PointsSpill(bucketPath.string(), points.getOrigin()));
+    }
+    {
+        // single buffer for all the buckets, appended to the bucket files by bucket when full
+        std::vector<BucketPoint> buffer;
+        buffer.reserve(_bufferSize);
+        const auto flush = [&]() {
+            std::sort(buffer.begin(), buffer.end(), [](const BucketPoint& a, const BucketPoint& b) { return a.bucket < b.bucket; });
+            std::vector<SpilledPoint> bucketPoints;
+            for(std::size_t begin = 0; begin < buffer.size();)
+            {
+                std::size_t end = begin;
+                while(end < buffer.size() && buffer[end].bucket == buffer[begin].bucket)
+                    ++end;
+                // write by pieces of the buffer to stay in the budget
+                for(std::size_t i = begin; i < end; i += _chunkSize)
+                {
+                    bucketPoints.clear();
+                    for(std::size_t j = i; j < std::min(end, i + _chunkSize); ++j)
+                        bucketPoints.push_back(buffer[j].point);
+                    buckets[buffer[begin].bucket]->append(bucketPoints);
+                }
+                begin = end;
+            }
+            buffer.clear();
+        };
+        _peakMemory = std::max(_peakMemory, 2 * _chunkSize * sizeof(SpilledPoint) + _bufferSize * sizeof(BucketPoint) +
+                               nbBuckets * (sizeof(double) + sizeof(PointsSpill)));
+
+        points.read(_chunkSize, [&](const std::vector<SpilledPoint>& chunk)
+        {
+            for(const SpilledPoint& point : chunk)
+            {
+                const Point3d p = points.getPosition(point);
+                const bool owned = point.pixSize > 0.0f;
+                const double score = point.simScore * double(point.pixSize) * double(point.pixSize);
+                int ownerCell[3], firstCell[3], lastCell[3];
+                for(int axis = 0; axis < 3; ++axis)
+                {
+                    ownerCell[axis] = cellCoord(p.m[axis], axis);
+                    firstCell[axis] = cellCoord(p.m[axis] - maxRadius, axis);
+                    lastCell[axis] = cellCoord(p.m[axis] + maxRadius, axis);
+                }
+                for(int z = firstCell[2]; z <= lastCell[2]; ++z)
+                {
+                    for(int y = firstCell[1]; y <= lastCell[1]; ++y)
+                    {
+                        for(int x = firstCell[0]; x <= lastCell[0]; ++x)
+                        {
+                            const std::size_t b = (std::size_t(z) * gridDim[1] + y) * gridDim[0] + x;
+                            BucketPoint bucketPoint{std::uint32_t(b), point};
+                            if(!owned || x != ownerCell[0] || y != ownerCell[1] || z != ownerCell[2])
+                            {
+                                // only a neighbor of the points of this bucket, if it can discard one of them
+                                if(score >= maxScores[b] ||
+                                   squaredDistanceToBox(p, cellMin(x, y, z), cellMax(x, y, z)) >= _pixSizeMarginCoef * maxScores[b])
+                                    continue;
+                                bucketPoint.point.pixSize = -std::abs(point.pixSize);
+                            }
+                            buffer.push_back(bucketPoint);
+                            if(buffer.size() >= _bufferSize)
+                                flush();
+                        }
+                    }
+                }
+            }
+        });
+        flush();
+    }
+    points.clear();
+
+    for(int z = 0; z < gridDim[2]; ++z)
+    {
+        for(int y = 0; y < gridDim[1]; ++y)
+        {
+            for(int x = 0; x < gridDim[0]; ++x)
+            {
+                PointsSpill& bucket = *buckets[(std::size_t(z) * gridDim[1] + y) * gridDim[0] + x];
+                filterBucket(bucket, cellMin(x, y, z), cellMax(x, y, z), depth + 1);
+            }
+        }
+    }
+}
+
+} // namespace
+
+std::size_t filterPointsOutOfCore(PointsSpill& points, const Point3d& bbMin, const Point3d& bbMax,
+                                  double pixSizeMarginCoef, std::size_t maxMemory, const PointsFilterFunction& filter,
+                                  std::vector<Point3d>& coords, std::vector<double>& pixSize, std::vector<float>& simScore)
+{
+    OutOfCoreFilter outOfCoreFilter(pixSizeMarginCoef, maxMemory, filter, coords, pixSize, simScore);
+    outOfCoreFilter.filterBucket(points, bbMin, bbMax, 0);
+    return outOfCoreFilter.getPeakMemory();
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
@@ -0,0 +1,112 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Candidate point of the depth maps fusion in the compact on-disk format of PointsSpill.
+ *
+ * The position is stored in float, relative to the origin of the spill.
+ * A negative pixSize marks a point that is only a neighbor of the points of a spatial bucket
+ * (see filterPointsOutOfCore).
+ */
+struct SpilledPoint
+{
+    float x, y, z;
+    float pixSize;
+    float simScore;
+};
+
+/**
+ * @brief Append-only file of SpilledPoint, written and read by chunks to bound the memory usage.
+ * The file is created on the first append and removed with the object.
+ */
+class PointsSpill
+{
+public:
+    PointsSpill(const std::string& filepath, const Point3d& origin);
+    ~PointsSpill();
+
+    PointsSpill(const PointsSpill&) = delete;
+    PointsSpill& operator=(const PointsSpill&) = delete;
+
+    /// Number of points in the file
+    std::size_t size() const { return _size; }
+    const std::string& getFilepath() const { return _filepath; }
+    const Point3d& getOrigin() const { return _origin; }
+
+    SpilledPoint toSpilledPoint(const Point3d& p, double pixSize, float simScore) const
+    {
+        const Point3d d = p - _origin;
+        return {float(d.x), float(d.y), float(d.z), float(pixSize), simScore};
+    }
+
+    Point3d getPosition(const SpilledPoint& p) const
+    {
+        return _origin + Point3d(p.x, p.y, p.z);
+    }
+
+    /// Append points at the end of the file (not thread-safe).
+    void append(const SpilledPoint* points, std::size_t count);
+
+    void append(const std::vector<SpilledPoint>& points)
+    {
+        append(points.data(), points.size());
+    }
+
+    /**
+     * @brief Read all the points in insertion order.
+     * @param[in] chunkSize maximum number of points given to each call of the callback
+     * @param[in] callback function called for each chunk of points
+     */
+    void read(std::size_t chunkSize, const std::function<void(const std::vector<SpilledPoint>&)>& callback) const;
+
+    /// Remove the file, the spill is empty after it.
+    void clear();
+
+private:
+    std::string _filepath;
+    Point3d _origin;
+    std::size_t _size = 0;
+};
+
+/**
+ * @brief Filter of the points of a spatial bucket, the discarded points get a pixSize of -1 (see filterByPixSize).
+ */
+using PointsFilterFunction = std::function<void(const std::vector<Point3d>& coords, std::vector<double>& pixSize,
+                                                double pixSizeMarginCoef, std::vector<float>& simScore)>;
+
+/**
+ * @brief Filter the points of a spill by spatial buckets fitting in a memory budget.
+ *
+ * The filter discards a point if a point of smaller simScore * pixSize^2 is closer than
+ * sqrt(pixSizeMarginCoef * simScore * pixSize^2). The points are distributed in a regular grid of buckets,
+ * and each bucket also receives the points that can discard one of its points, according to the largest
+ * radius of its points. The buckets still exceeding the budget are split again.
+ *
+ * @param[in,out] points the points to filter, inside [bbMin, bbMax], the spill is emptied
+ * @param[in] maxMemory the memory budget in bytes of the distribution buffers and of the points of a bucket,
+ *            the kept points are not included
+ * @param[in] filter the filter of the points of a bucket
+ * @param[out] coords, pixSize, simScore the kept points are appended
+ * @return the estimated peak memory in bytes used by the buffers and the points of a bucket
+ */
+std::size_t filterPointsOutOfCore(PointsSpill& points, const Point3d& bbMin, const Point3d& bbMax,
+                                  double pixSizeMarginCoef, std::size_t maxMemory, const PointsFilterFunction& filter,
+                                  std::vector<Point3d>& coords, std::vector<double>& pixSize, std::vector<float>& simScore);
+
+} // namespace fuseCut
+} // namespace aliceVision
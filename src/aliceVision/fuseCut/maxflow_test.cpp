@@ -0,0 +1,184 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_PushRelabel.hpp>
+#include <aliceVision/fuseCut/MaxFlowGraph.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE maxflow
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+namespace {
+
+/// Integer capacities, so the flow values are exact in float whatever the order of the operations
+MaxFlowGraph createRandomGraph(std::size_t nbNodes, std::size_t nbEdges, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> terminalCapacity(0, 20);
+    std::uniform_int_distribution<int> edgeCapacity(0, 10);
+    std::uniform_int_distribution<MaxFlowGraph::NodeType> node(0, nbNodes - 1);
+
+    MaxFlowGraph graph(nbNodes);
+    for(std::size_t n = 0; n < nbNodes; ++n)
+        graph.addNode(n, terminalCapacity(generator), terminalCapacity(generator));
+    for(std::size_t e = 0; e < nbEdges; ++e)
+    {
+        const MaxFlowGraph::NodeType n1 = node(generator);
+        MaxFlowGraph::NodeType n2 = node(generator);
+        if(n1 == n2)
+            n2 = (n1 + 1) % nbNodes;
+        graph.addEdge(n1, n2, edgeCapacity(generator), edgeCapacity(generator));
+    }
+    return graph;
+}
+
+/// 3D grid like the cells of a tetrahedralization, with source nodes on one side and sink nodes on the other
+MaxFlowGraph createGridGraph(int size, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> capacity(1, 100);
+
+    const auto index = [size](int x, int y, int z) { return MaxFlowGraph::NodeType((z * size + y) * size + x); };
+    MaxFlowGraph graph(size * size * size);
+    for(int z = 0; z < size; ++z)
+    {
+        for(int y = 0; y < size; ++y)
+        {
+            for(int x = 0; x < size; ++x)
+            {
+                graph.addNode(index(x, y, z), (x < size / 4) ? capacity(generator) : 0, (x >= 3 * size / 4) ? capacity(generator) : 0);
+                if(x + 1 < size)
+                    graph.addEdge(index(x, y, z), index(x + 1, y, z), capacity(generator), capacity(generator));
+                if(y + 1 < size)
+                    graph.addEdge(index(x, y, z), index(x, y + 1, z), capacity(generator), capacity(generator));
+                if(z + 1 < size)
+                    graph.addEdge(index(x, y, z), index(x, y, z + 1), capacity(generator), capacity(generator));
+            }
+        }
+    }
+    return graph;
+}
+
+template <typename MaxFlow>
+float computeCut(const MaxFlowGraph& graph, std::vector<bool>& isTarget)
+{
+    MaxFlow maxFlow(graph.getNbNodes());
+    graph.fill(maxFlow);
+    const float flow = maxFlow.compute();
+    isTarget.resize(graph.getNbNodes());
+    for(std::size_t n = 0; n < graph.getNbNodes(); ++n)
+        isTarget[n] = maxFlow.isTarget(n);
+    return flow;
+}
+
+/**
+ * @brief Check that the push-relabel solver gives the flow value and the cut of the Boykov-Kolmogorov solver,
+ * with 1 and several threads.
+ */
+void checkSolvers(const MaxFlowGraph& graph)
+{
+    std::vector<bool> referenceIsTarget;
+    const float referenceFlow = computeCut<MaxFlow_AdjList>(graph, referenceIsTarget);
+
+    const int nbThreads = omp_get_max_threads();
+    for(int threads : {1, std::max(4, omp_get_num_procs())})
+    {
+        omp_set_num_threads(threads);
+        std::vector<bool> isTarget;
+        const float flow = computeCut<MaxFlow_PushRelabel>(graph, isTarget);
+        BOOST_CHECK_EQUAL(flow, referenceFlow);
+        BOOST_CHECK(isTarget == referenceIsTarget);
+    }
+    omp_set_num_threads(nbThreads);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(maxflow_randomGraphs)
+{
+    for(unsigned int seed = 0; seed < 10; ++seed)
+    {
+        checkSolvers(createRandomGraph(1000, 4000, seed));
+        // sparse graph with isolated nodes
+        checkSolvers(createRandomGraph(1000, 300, seed));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(maxflow_gridGraphs)
+{
+    checkSolvers(createGridGraph(10, 0));
+    checkSolvers(createGridGraph(20, 1));
+}
+
+BOOST_AUTO_TEST_CASE(maxflow_degenerateGraphs)
+{
+    // single node
+    {
+        MaxFlowGraph graph(1);
+        graph.addNode(0, 5, 3);
+        checkSolvers(graph);
+    }
+    // no edge
+    {
+        MaxFlowGraph graph(4);
+        graph.addNode(0, 5, 0);
+        graph.addNode(1, 0, 5);
+        graph.addNode(2, 2, 2);
+        checkSolvers(graph);
+    }
+    // only source nodes, only sink nodes, no terminal capacity
+    for(int type = 0; type < 3; ++type)
+    {
+        MaxFlowGraph graph(100);
+        for(MaxFlowGraph::NodeType n = 0; n < 100; ++n)
+        {
+            graph.addNode(n, type == 0 ? 1 : 0, type == 1 ? 1 : 0);
+            if(n > 0)
+                graph.addEdge(n - 1, n, 3, 3);
+        }
+        checkSolvers(graph);
+    }
+    // zero capacity edges
+    {
+        MaxFlowGraph graph(3);
+        graph.addNode(0, 10, 0);
+        graph.addNode(2, 0, 10);
+        graph.addEdge(0, 1, 0, 0);
+        graph.addEdge(1, 2, 5, 0);
+        checkSolvers(graph);
+    }
+    // long chain with a bottleneck, and duplicated edges
+    {
+        const MaxFlowGraph::NodeType nbNodes = 2000;
+        MaxFlowGraph graph(nbNodes);
+        graph.addNode(0, 100, 0);
+        graph.addNode(nbNodes - 1, 0, 100);
+        for(MaxFlowGraph::NodeType n = 1; n < nbNodes; ++n)
+        {
+            graph.addEdge(n - 1, n, n == nbNodes / 2 ? 7 : 50, 0);
+            graph.addEdge(n - 1, n, 1, 1);
+        }
+        checkSolvers(graph);
+    }
+    // disconnected components
+    {
+        MaxFlowGraph graph(6);
+        graph.addNode(0, 4, 0);
+        graph.addNode(1, 0, 4);
+        graph.addNode(3, 4, 0);
+        graph.addNode(5, 0, 4);
+        graph.addEdge(0, 1, 2, 2);
+        graph.addEdge(3, 4, 1, 0);
+        checkSolvers(graph);
+    }
+}
@@ -0,0 +1,165 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+#include <aliceVision/fuseCut/PointsSpill.hpp>
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#define BOOST_TEST_MODULE pointsSpill
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+namespace {
+
+const double pixSizeMarginCoef = 2.0;
+
+typedef std::tuple<double, double, double, double, float> PointTuple;
+
+/**
+ * @brief Duplicated points around random positions, with values exactly stored in the spill.
+ * Half of the positions are in a small area, so the buckets of this area are split again.
+ */
+void createPoints(std::size_t nbPositions, std::size_t nbDuplicates, std::vector<SpilledPoint>& points)
+{
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> densePosition(0.0f, 5.0f);
+    std::uniform_real_distribution<float> offset(-0.1f, 0.1f);
+    std::uniform_real_distribution<float> pixSize(0.02f, 0.2f);
+    std::uniform_real_distribution<float> simScore(1.0f, 4.0f);
+
+    for(std::size_t i = 0; i < nbPositions; ++i)
+    {
+        const bool dense = (i % 2 == 0);
+        const float x = dense ? densePosition(generator) : position(generator);
+        const float y = dense ? densePosition(generator) : position(generator);
+        const float z = position(generator) * 0.1f;
+        for(std::size_t j = 0; j < nbDuplicates; ++j)
+            points.push_back({x + offset(generator), y + offset(generator), z + offset(generator), pixSize(generator), simScore(generator)});
+    }
+}
+
+/// Kept points of the in-memory filtering, sorted
+std::vector<PointTuple> filterInCore(const std::vector<SpilledPoint>& points)
+{
+    std::vector<Point3d> coords;
+    std::vector<double> pixSize;
+    std::vector<float> simScore;
+    for(const SpilledPoint& point : points)
+    {
+        coords.emplace_back(point.x, point.y, point.z);
+        pixSize.push_back(point.pixSize);
+        simScore.push_back(point.simScore);
+    }
+    filterByPixSize(coords, pixSize, pixSizeMarginCoef, simScore);
+
+    std::vector<PointTuple> kept;
+    for(std::size_t i = 0; i < coords.size(); ++i)
+    {
+        if(pixSize[i] != -1.0)
+            kept.emplace_back(coords[i].x, coords[i].y, coords[i].z, pixSize[i], simScore[i]);
+    }
+    std::sort(kept.begin(), kept.end());
+    return kept;
+}
+
+/// Kept points of the filtering with a memory budget, sorted
+std::vector<PointTuple> filterOutOfCore(const std::vector<SpilledPoint>& points, std::size_t maxMemory, std::size_t& peakMemory)
+{
+    PointsSpill spill("pointsSpill_test.bin", Point3d(0.0, 0.0, 0.0));
+    spill.append(points);
+
+    Point3d bbMin(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    Point3d bbMax = -bbMin;
+    for(const SpilledPoint& point : points)
+    {
+        bbMin = Point3d(std::min<double>(bbMin.x, point.x), std::min<double>(bbMin.y, point.y), std::min<double>(bbMin.z, point.z));
+        bbMax = Point3d(std::max<double>(bbMax.x, point.x), std::max<double>(bbMax.y, point.y), std::max<double>(bbMax.z, point.z));
+    }
+
+    std::vector<Point3d> coords;
+    std::vector<double> pixSize;
+    std::vector<float> simScore;
+    peakMemory = filterPointsOutOfCore(spill, bbMin, bbMax, pixSizeMarginCoef, maxMemory, filterByPixSize, coords, pixSize, simScore);
+    BOOST_CHECK_EQUAL(spill.size(), 0);
+
+    std::vector<PointTuple> kept;
+    for(std::size_t i = 0; i < coords.size(); ++i)
+        kept.emplace_back(coords[i].x, coords[i].y, coords[i].z, pixSize[i], simScore[i]);
+    std::sort(kept.begin(), kept.end());
+    return kept;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(pointsSpill_appendRead)
+{
+    const Point3d origin(10.0, -5.0, 2.0);
+    PointsSpill spill("pointsSpill_appendRead.bin", origin);
+
+    std::vector<SpilledPoint> points;
+    for(int i = 0; i < 1000; ++i)
+        points.push_back(spill.toSpilledPoint(origin + Point3d(i, -i, 0.5 * i), 0.01 * i, float(i)));
+    spill.append(points.data(), 600);
+    spill.append(points.data() + 600, 400);
+    BOOST_CHECK_EQUAL(spill.size(), points.size());
+
+    std::vector<SpilledPoint> readPoints;
+    spill.read(300, [&](const std::vector<SpilledPoint>& chunk)
+    {
+        BOOST_CHECK(chunk.size() <= 300);
+        readPoints.insert(readPoints.end(), chunk.begin(), chunk.end());
+    });
+    BOOST_REQUIRE_EQUAL(readPoints.size(), points.size());
+    for(std::size_t i = 0; i < points.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(readPoints[i].x, points[i].x);
+        BOOST_CHECK_EQUAL(readPoints[i].pixSize, points[i].pixSize);
+        BOOST_CHECK_EQUAL(readPoints[i].simScore, points[i].simScore);
+    }
+    BOOST_CHECK_EQUAL(spill.getPosition(readPoints[10]).y, origin.y - 10.0);
+
+    spill.clear();
+    BOOST_CHECK_EQUAL(spill.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(pointsSpill_filterOutOfCore)
+{
+    std::vector<SpilledPoint> points;
+    createPoints(5000, 4, points);
+
+    const std::vector<PointTuple> inCore = filterInCore(points);
+    BOOST_CHECK(inCore.size() < points.size());
+
+    // from a single bucket to buckets split several times
+    for(const std::size_t maxMemory : {std::size_t(1) << 30, std::size_t(1) << 20, std::size_t(1) << 18, std::size_t(1) << 16})
+    {
+        std::size_t peakMemory = 0;
+        const std::vector<PointTuple> outOfCore = filterOutOfCore(points, maxMemory, peakMemory);
+        BOOST_CHECK(outOfCore == inCore);
+        BOOST_CHECK_LE(peakMemory, maxMemory);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pointsSpill_filterOutOfCore_sameScores)
+{
+    // many points with the same score in the radius of each other: no point discards them
+    std::vector<SpilledPoint> points;
+    for(int i = 0; i < 2000; ++i)
+        points.push_back({float(i % 100) * 0.01f, float(i / 100) * 0.01f, 0.0f, 0.1f, 2.0f});
+    points.push_back({0.5f, 0.1f, 0.0f, 0.05f, 2.0f});
+
+    const std::vector<PointTuple> inCore = filterInCore(points);
+    std::size_t peakMemory = 0;
+    const std::vector<PointTuple> outOfCore = filterOutOfCore(points, std::size_t(1) << 16, peakMemory);
+    BOOST_CHECK(outOfCore == inCore);
+}
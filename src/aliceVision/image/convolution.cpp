@@ -7,72 +7,216 @@
 
 #include "convolution.hpp"
 
+#include <algorithm>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <emmintrin.h>
+#endif
+
 namespace aliceVision {
 namespace image {
 
+namespace {
+
+/// number of rows of the image processed by a thread at once
+const int rowsPerBand = 32;
+
+/**
+ * @brief Weighted sum of rows: out[x] = sum_k kernel[k] * rows[k][x]
+ * The sum is done in the kernel order for each pixel.
+ * A horizontal convolution is the same sum on a padded line, with rows[k] = line + k.
+ * @tparam KernelSize the kernel size known at compile time, or 0 for any size
+ */
+template<int KernelSize>
+void convolveRows(const float* const* rows, const float* kernel, int kernelSize, float* out, int width)
+{
+  const int size = (KernelSize > 0) ? KernelSize : kernelSize;
+  int x = 0;
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128 sum = _mm_mul_ps(_mm_loadu_ps(rows[0] + x), _mm_set1_ps(kernel[0]));
+    for(int k = 1; k < size; ++k)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + x), _mm_set1_ps(kernel[k])));
+    _mm_storeu_ps(out + x, sum);
+  }
+#endif
+
+  for(; x < width; ++x)
+  {
+    float sum = rows[0][x] * kernel[0];
+    for(int k = 1; k < size; ++k)
+      sum += rows[k][x] * kernel[k];
+    out[x] = sum;
+  }
+}
+
+typedef void (*ConvolveRowsFunction)(const float* const*, const float*, int, float*, int);
+
+/// Get the unrolled version for the common kernel sizes
+ConvolveRowsFunction getConvolveRows(int kernelSize)
+{
+  switch(kernelSize)
+  {
+    case 3:  return &convolveRows<3>;
+    case 5:  return &convolveRows<5>;
+    case 7:  return &convolveRows<7>;
+    case 9:  return &convolveRows<9>;
+    case 11: return &convolveRows<11>;
+    case 13: return &convolveRows<13>;
+    case 15: return &convolveRows<15>;
+    case 17: return &convolveRows<17>;
+    case 19: return &convolveRows<19>;
+    case 21: return &convolveRows<21>;
+    default: return &convolveRows<0>;
+  }
+}
+
+/// Mirror an index out of [0, size[ without repeating the border (dcb|abcd|cba)
+inline int reflect101(int i, int size)
+{
+  if(size == 1)
+    return 0;
+  while(i < 0 || i >= size)
+    i = (i < 0) ? -i : 2 * size - 2 - i;
+  return i;
+}
+
+inline int clampIndex(int i, int size)
+{
+  return std::min(std::max(i, 0), size - 1);
+}
+
+/// Same conversion as the generic convolution for the values in range, saturated otherwise
+inline unsigned char toUChar(float value)
+{
+  return static_cast<unsigned char>(std::min(std::max(value, 0.f), 255.f));
+}
+
+} // namespace
+
 void SeparableConvolution2d(const RowMatrixXf& image,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
-                            RowMatrixXf* out) {
-  const int sigma_y = static_cast<int>( kernel_y.cols() );
-  const int half_sigma_y = static_cast<int>( kernel_y.cols() ) / 2;
+                            RowMatrixXf* out)
+{
+  const int width = static_cast<int>(image.cols());
+  const int height = static_cast<int>(image.rows());
+  const int size_x = static_cast<int>(kernel_x.cols());
+  const int size_y = static_cast<int>(kernel_y.cols());
+  const int half_size_x = size_x / 2;
+  const int half_size_y = size_y / 2;
 
-  // Convolving a vertical filter across rows is the same thing as transpose
-  // multiply i.e. kernel_y^t * rows. This will give us the convoled value for
-  // each row. However, care must be taken at the top and bottom borders.
-  const Eigen::Matrix<float, 1, Eigen::Dynamic> reverse_kernel_y = kernel_y.reverse();
+  out->resize(height, width);
+  if(width == 0 || height == 0)
+    return;
 
-  #pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < half_sigma_y; i++)
-  {
-    const int forward_size = i + half_sigma_y + 1;
-    const int reverse_size = sigma_y - forward_size;
-    out->row(i) = kernel_y.tail(forward_size) *
-                  image.block(0, 0, forward_size, image.cols()) +
-                  reverse_kernel_y.tail(reverse_size) *
-                  image.block(1, 0, reverse_size, image.cols());
-
-    // Apply the same technique for the end rows.
-    out->row(image.rows() - i - 1) =
-      kernel_y.head(forward_size) *
-      image.block(image.rows() - forward_size, 0, forward_size, image.cols())
-      +
-      reverse_kernel_y.head(reverse_size) *
-      image.block(image.rows() - reverse_size - 1, 0, reverse_size, image.cols());
-  }
+  const ConvolveRowsFunction convolveX = getConvolveRows(size_x);
+  const ConvolveRowsFunction convolveY = getConvolveRows(size_y);
+  const int nbBands = (height + rowsPerBand - 1) / rowsPerBand;
 
-  // Applying the rest of the y filter.
-  #pragma omp parallel for schedule(dynamic)
-  for (int row = half_sigma_y; row < image.rows() - half_sigma_y; row++)
+  // Each thread filters bands of consecutive rows: the source rows of the
+  // vertical pass stay in the cache from one output row to the next one.
+  // The vertical pass is done in a padded line, used by the horizontal pass.
+  // The borders are mirrored (dcb|abcd|cba).
+  #pragma omp parallel
   {
-    out->row(row) =  kernel_y * image.block(row - half_sigma_y, 0, sigma_y, out->cols());
+    std::vector<const float*> rows(std::max(size_x, size_y));
+    std::vector<float> line(width + 2 * half_size_x);
+
+    #pragma omp for schedule(dynamic)
+    for(int band = 0; band < nbBands; ++band)
+    {
+      const int rowEnd = std::min(height, (band + 1) * rowsPerBand);
+      for(int row = band * rowsPerBand; row < rowEnd; ++row)
+      {
+        for(int k = 0; k < size_y; ++k)
+          rows[k] = image.data() + static_cast<std::size_t>(reflect101(row + k - half_size_y, height)) * width;
+        convolveY(rows.data(), kernel_y.data(), size_y, &line[half_size_x], width);
+
+        for(int k = 1; k <= half_size_x; ++k)
+        {
+          line[half_size_x - k] = line[half_size_x + reflect101(-k, width)];
+          line[half_size_x + width - 1 + k] = line[half_size_x + reflect101(width - 1 + k, width)];
+        }
+
+        for(int k = 0; k < size_x; ++k)
+          rows[k] = &line[k];
+        convolveX(rows.data(), kernel_x.data(), size_x, out->data() + static_cast<std::size_t>(row) * width, width);
+      }
+    }
   }
+}
 
-  const int sigma_x = static_cast<int>(kernel_x.cols());
-  const int half_sigma_x = static_cast<int>(kernel_x.cols() / 2);
+void SeparableConvolution2d(const RowMatrixXuc& image,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
+                            RowMatrixXuc* out)
+{
+  const int width = static_cast<int>(image.cols());
+  const int height = static_cast<int>(image.rows());
+  const int size_x = static_cast<int>(kernel_x.cols());
+  const int size_y = static_cast<int>(kernel_y.cols());
+  const int half_size_x = size_x / 2;
+  const int half_size_y = size_y / 2;
 
-  // Convolving with the horizontal filter is easy. Rather than using the kernel
-  // as a sliding window, we use the row pixels as a sliding window around the
-  // filter. We prepend and append the proper border values so that we are sure
-  // to end up with the correct convolved values.
-  Eigen::RowVectorXf temp_row(image.cols() + sigma_x - 1);
+  out->resize(height, width);
+  if(width == 0 || height == 0)
+    return;
 
-  #pragma omp parallel for firstprivate(temp_row), schedule(dynamic)
-  for (int row = 0; row < out->rows(); row++)
+  const ConvolveRowsFunction convolveX = getConvolveRows(size_x);
+  const ConvolveRowsFunction convolveY = getConvolveRows(size_y);
+  const int nbBands = (height + rowsPerBand - 1) / rowsPerBand;
+
+  // Same result as the generic ImageSeparableConvolution: the borders are replicated
+  // and the horizontal pass is done first, with a result rounded to unsigned char.
+  // The horizontal pass of a band and of its margins is kept in a float buffer.
+  #pragma omp parallel
   {
-    temp_row.head(half_sigma_x) =
-      out->row(row).segment(1, half_sigma_x).reverse();
-    temp_row.segment(half_sigma_x, image.cols()) = out->row(row);
-    temp_row.tail(half_sigma_x) =
-      out->row(row)
-      .segment(image.cols() - 2 - half_sigma_x, half_sigma_x)
-      .reverse();
-
-    // Convolve the row. We perform the first step here explicitly so that we
-    // avoid setting the row equal to zero.
-    out->row(row) = kernel_x(0) * temp_row.head(image.cols());
-    for (int i = 1; i < sigma_x; i++) {
-      out->row(row) += kernel_x(i) * temp_row.segment(i, image.cols());
+    std::vector<const float*> rows(std::max(size_x, size_y));
+    std::vector<float> line(width + 2 * half_size_x);
+    std::vector<float> bandBuffer(static_cast<std::size_t>(rowsPerBand + 2 * half_size_y) * width);
+
+    #pragma omp for schedule(dynamic)
+    for(int band = 0; band < nbBands; ++band)
+    {
+      const int rowBegin = band * rowsPerBand;
+      const int rowEnd = std::min(height, rowBegin + rowsPerBand);
+      const int bufferBegin = std::max(0, rowBegin - half_size_y);
+      const int bufferEnd = std::min(height, rowEnd + half_size_y);
+
+      // horizontal pass
+      for(int row = bufferBegin; row < bufferEnd; ++row)
+      {
+        const unsigned char* src = image.data() + static_cast<std::size_t>(row) * width;
+        for(int x = 0; x < width; ++x)
+          line[half_size_x + x] = src[x];
+        for(int k = 0; k < half_size_x; ++k)
+        {
+          line[k] = src[0];
+          line[half_size_x + width + k] = src[width - 1];
+        }
+
+        for(int k = 0; k < size_x; ++k)
+          rows[k] = &line[k];
+        float* dst = &bandBuffer[static_cast<std::size_t>(row - bufferBegin) * width];
+        convolveX(rows.data(), kernel_x.data(), size_x, dst, width);
+        for(int x = 0; x < width; ++x)
+          dst[x] = toUChar(dst[x]);
+      }
+
+      // vertical pass
+      for(int row = rowBegin; row < rowEnd; ++row)
+      {
+        for(int k = 0; k < size_y; ++k)
+          rows[k] = &bandBuffer[static_cast<std::size_t>(clampIndex(row + k - half_size_y, height) - bufferBegin) * width];
+        convolveY(rows.data(), kernel_y.data(), size_y, &line[0], width);
+
+        unsigned char* dst = out->data() + static_cast<std::size_t>(row) * width;
+        for(int x = 0; x < width; ++x)
+          dst[x] = toUChar(line[x]);
+      }
     }
   }
 }
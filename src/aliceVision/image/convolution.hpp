@@ -13,6 +13,7 @@
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/config.hpp>
 
+#include <algorithm>
 #include <vector>
 #include <cassert>
 
@@ -93,6 +94,7 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
 
   std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
 
+  #pragma omp parallel for firstprivate(line)
   for( int row = 0 ; row < rows ; ++row )
   {
     // Copy line
@@ -126,6 +128,7 @@ template< typename ImageTypeIn , typename ImageTypeOut, typename Kernel >
 void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel , ImageTypeOut & out)
 {
   typedef typename ImageTypeIn::Tpixel pix_t ;
+  typedef typename Kernel::Scalar kernel_t ;
 
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
@@ -135,30 +138,31 @@ void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel ,
 
   out.resize( cols , rows ) ;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( rows + kernel_width );
+  // Accumulate the weighted rows: the rows are read contiguously,
+  // with the same summation order than conv_buffer_ for each pixel
+  std::vector<kernel_t> sum( cols );
 
-  for( int col = 0 ; col < cols ; ++col )
+  #pragma omp parallel for firstprivate(sum)
+  for( int row = 0 ; row < rows ; ++row )
   {
-    // Copy column
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k ] = img.coeffRef( 0 , col ) ;
-    }
-    for( int k = 0 ; k < rows ; ++k )
-    {
-      line[ k + half_kernel_width ] = img.coeffRef( k , col ) ;
-    }
-    for( int k = 0 ; k < half_kernel_width ; ++k )
+    std::fill( sum.begin() , sum.end() , kernel_t( 0 ) );
+
+    for( int k = 0 ; k < kernel_width ; ++k )
     {
-      line[ k + half_kernel_width + rows ] = img.coeffRef( rows - 1 , col ) ;
-    }
+      // border pixels are copied
+      const int src_row = std::min( std::max( row + k - half_kernel_width , 0 ) , rows - 1 ) ;
+      const pix_t* src = img.data() + src_row * cols ;
+      const kernel_t weight = kernel.data()[ k ] ;
 
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , rows , kernel_width );
+      for( int col = 0 ; col < cols ; ++col )
+      {
+        sum[ col ] += src[ col ] * weight ;
+      }
+    }
 
-    for( int row = 0 ; row < rows ; ++row )
+    for( int col = 0 ; col < cols ; ++col )
     {
-      out.coeffRef( row , col ) = line[row];
+      out.coeffRef( row , col ) = static_cast<pix_t>( sum[ col ] );
     }
   }
 }
@@ -189,13 +193,29 @@ void ImageSeparableConvolution( const ImageType & img ,
 }
 
 typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXf;
+typedef Eigen::Matrix<unsigned char, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXuc;
 
-/// Specialization for Float based image (for arbitrary sized kernel)
+/**
+ ** Specialization for Float based image (for arbitrary sized kernel)
+ ** The borders are mirrored (dcb|abcd|cba).
+ ** The rows are filtered in parallel by bands, with vectorized kernels unrolled for the common kernel sizes.
+ **/
 void SeparableConvolution2d(const RowMatrixXf& image,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
                             RowMatrixXf* out);
 
+/**
+ ** Specialization for unsigned char based image (for arbitrary sized kernel)
+ ** Same computation as the generic ImageSeparableConvolution (borders are copied,
+ ** horizontal pass truncated to unsigned char),
+ ** computed in parallel by bands with the vectorized float kernels.
+ **/
+void SeparableConvolution2d(const RowMatrixXuc& image,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
+                            RowMatrixXuc* out);
+
 // Specialization for Image<float> in order to use SeparableConvolution2d
 template<typename Kernel>
 void ImageSeparableConvolution( const Image<float> & img ,
@@ -213,5 +233,20 @@ void ImageSeparableConvolution( const Image<float> & img ,
   SeparableConvolution2d(img.GetMat(), horiz_k_cast, vert_k_cast, &((Image<float>::Base&)out));
 }
 
+// Specialization for Image<unsigned char> in order to use SeparableConvolution2d
+template<typename Kernel>
+void ImageSeparableConvolution( const Image<unsigned char> & img ,
+                                const Kernel & horiz_k ,
+                                const Kernel & vert_k ,
+                                Image<unsigned char> & out)
+{
+  typedef Eigen::Matrix<float, Eigen::Dynamic, 1> VecKernel;
+  const VecKernel horiz_k_cast = horiz_k.template cast<float>();
+  const VecKernel vert_k_cast = vert_k.template cast<float>();
+
+  out.resize(img.Width(), img.Height());
+  SeparableConvolution2d(img.GetMat(), horiz_k_cast, vert_k_cast, &((Image<unsigned char>::Base&)out));
+}
+
 } // namespace image
 } // namespace aliceVision
@@ -56,32 +56,29 @@ void ImageFEDCentral( const Image & src , const Image & diff , const typename Im
 {
   typedef typename Image::Tpixel Real ;
   const int width = src.Width() ;
-  Real n_diff[4] ;
-  Real n_src[4] ;
   // Compute FED step on general range
   for( int i = row_start ; i < row_end ; ++i )
   {
+    // Rows of the neighbors: the pixels of a row are computed independently and can be vectorized
+    const Real* __restrict src_row = src.data() + i * width ;
+    const Real* __restrict src_prev = src_row - width ;
+    const Real* __restrict src_next = src_row + width ;
+    const Real* __restrict diff_row = diff.data() + i * width ;
+    const Real* __restrict diff_prev = diff_row - width ;
+    const Real* __restrict diff_next = diff_row + width ;
+    Real* __restrict out_row = out.data() + i * width ;
+
     for( int j = 1 ; j < width - 1 ; ++j )
     {
-      // Retrieve neighbors : TODO check if we need a cache efficient version ?
-      n_diff[0] = diff( i , j + 1 ) ;
-      n_diff[1] = diff( i - 1 , j ) ;
-      n_diff[2] = diff( i , j - 1 ) ;
-      n_diff[3] = diff( i + 1 , j ) ;
-      n_src[0] = src( i , j + 1 ) ;
-      n_src[1] = src( i - 1 , j ) ;
-      n_src[2] = src( i , j - 1 ) ;
-      n_src[3] = src( i + 1 , j ) ;
-
       // Compute diffusion factor for given pixel
-      const Real cur_src = src( i , j ) ;
-      const Real cur_diff = diff( i , j ) ;
-      const Real a = ( cur_diff + n_diff[0] ) * ( n_src[0] - cur_src ) ;
-      const Real b = ( cur_diff + n_diff[1] ) * ( cur_src - n_src[1] ) ;
-      const Real c = ( cur_diff + n_diff[2] ) * ( cur_src - n_src[2] ) ;
-      const Real d = ( cur_diff + n_diff[3] ) * ( n_src[3] - cur_src ) ;
+      const Real cur_src = src_row[ j ] ;
+      const Real cur_diff = diff_row[ j ] ;
+      const Real a = ( cur_diff + diff_row[ j + 1 ] ) * ( src_row[ j + 1 ] - cur_src ) ;
+      const Real b = ( cur_diff + diff_prev[ j ] ) * ( cur_src - src_prev[ j ] ) ;
+      const Real c = ( cur_diff + diff_row[ j - 1 ] ) * ( cur_src - src_row[ j - 1 ] ) ;
+      const Real d = ( cur_diff + diff_next[ j ] ) * ( src_next[ j ] - cur_src ) ;
       const Real value = half_t * ( a - c + d - b ) ;
-      out( i , j ) = value ;
+      out_row[ j ] = value ;
     }
   }
 }
@@ -135,3 +135,88 @@ BOOST_AUTO_TEST_CASE(Image_Convolution_Sobel_X_Y)
   outFilteredCast = Image<unsigned char>(outFiltered.cast<unsigned char>());
   BOOST_CHECK_NO_THROW(writeImage("out_SobelY.png", outFilteredCast));
 }
+
+BOOST_AUTO_TEST_CASE(Image_SeparableConvolution_Float)
+{
+  // odd sizes, with a size smaller than the kernels
+  const int sizes[][2] = {{1, 1}, {5, 7}, {67, 41}, {250, 133}};
+  const int kernelSizes[] = {1, 3, 9, 23};
+
+  // reference convolution with mirrored borders (dcb|abcd|cba)
+  const auto reflect = [](int i, int size)
+  {
+    if(size == 1)
+      return 0;
+    while(i < 0 || i >= size)
+      i = (i < 0) ? -i : 2 * size - 2 - i;
+    return i;
+  };
+
+  for(const auto& size : sizes)
+  {
+    Image<float> in(size[0], size[1]);
+    for(int i = 0; i < in.Height(); ++i)
+      for(int j = 0; j < in.Width(); ++j)
+        in(i, j) = static_cast<float>(rand() % 256);
+
+    for(const int kernelSize : kernelSizes)
+    {
+      const Vec kernel_x = Vec::Random(kernelSize);
+      const Vec kernel_y = Vec::Random(kernelSize);
+      const int half = kernelSize / 2;
+
+      Image<float> out;
+      ImageSeparableConvolution(in, kernel_x, kernel_y, out);
+      BOOST_CHECK_EQUAL(out.Width(), in.Width());
+      BOOST_CHECK_EQUAL(out.Height(), in.Height());
+
+      Image<double> tmp(in.Width(), in.Height());
+      for(int i = 0; i < in.Height(); ++i)
+        for(int j = 0; j < in.Width(); ++j)
+        {
+          double sum = 0.0;
+          for(int k = 0; k < kernelSize; ++k)
+            sum += kernel_y(k) * in(reflect(i + k - half, in.Height()), j);
+          tmp(i, j) = sum;
+        }
+
+      double maxError = 0.0;
+      for(int i = 0; i < in.Height(); ++i)
+        for(int j = 0; j < in.Width(); ++j)
+        {
+          double sum = 0.0;
+          for(int k = 0; k < kernelSize; ++k)
+            sum += kernel_x(k) * tmp(i, reflect(j + k - half, in.Width()));
+          maxError = std::max(maxError, std::abs(sum - out(i, j)));
+        }
+      BOOST_CHECK_SMALL(maxError, 1e-2);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Image_SeparableConvolution_UChar)
+{
+  Image<unsigned char> in(131, 77);
+  for(int i = 0; i < in.Height(); ++i)
+    for(int j = 0; j < in.Width(); ++j)
+      in(i, j) = rand() % 256;
+
+  for(const double sigma : {0.8, 1.6, 4.0})
+  {
+    const Vec kernel = ComputeGaussianKernel(0, sigma);
+
+    // generic implementation
+    typedef Eigen::Matrix<float, Eigen::Dynamic, 1> VecKernel;
+    const VecKernel kernel_cast = kernel.cast<float>();
+    Image<unsigned char> tmp, expected;
+    ImageHorizontalConvolution(in, kernel_cast, tmp);
+    ImageVerticalConvolution(tmp, kernel_cast, expected);
+
+    Image<unsigned char> out;
+    ImageSeparableConvolution(in, kernel, kernel, out);
+
+    // identical computations, up to the floating point contractions done by the compiler
+    const int maxError = (out.GetMat().cast<int>() - expected.GetMat().cast<int>()).cwiseAbs().maxCoeff();
+    BOOST_CHECK_LE(maxError, 1);
+  }
+}
@@ -25,14 +25,17 @@ namespace image {
 
     out.resize( new_width , new_height ) ;
 
-    const Sampler2d<SamplerLinear> sampler;
-
+    // The bilinear sampling at 2 * (i + .5) falls exactly on the pixel 2 * i + 1
+    // (see Sampler2d<SamplerLinear>), so the pixels are directly copied.
+    #pragma omp parallel for
     for( int i = 0 ; i < new_height ; ++i )
     {
+      const typename Image::Tpixel* src_row = src.data() + ( 2 * i + 1 ) * src.Width() ;
+      typename Image::Tpixel* out_row = out.data() + i * new_width ;
+
       for( int j = 0 ; j < new_width ; ++j )
       {
-        // Use .5f offset to ensure mid pixel and correct bilinear sampling
-        out( i , j ) =  sampler( src, 2.f * (i+.5f), 2.f * (j+.5f) );
+        out_row[ j ] = src_row[ 2 * j + 1 ] ;
       }
     }
   }
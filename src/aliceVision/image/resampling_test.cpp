@@ -122,3 +122,36 @@ BOOST_AUTO_TEST_CASE(Ressampling_SampleRotate)
   BOOST_CHECK_NO_THROW(ImageRotation(image, Sampler2d< SamplerSpline16 >(), "SamplerSpline16"));
   BOOST_CHECK_NO_THROW(ImageRotation(image, Sampler2d< SamplerSpline64 >(), "SamplerSpline64"));
 }
+
+// The half sampling has to give the same result as a bilinear sampling at the pixel centers
+template<typename ImageT>
+void checkHalfSample(const ImageT& image)
+{
+  ImageT imageOut;
+  ImageHalfSample(image, imageOut);
+
+  BOOST_CHECK_EQUAL(imageOut.Width(), image.Width() / 2);
+  BOOST_CHECK_EQUAL(imageOut.Height(), image.Height() / 2);
+
+  const Sampler2d< SamplerLinear > sampler;
+  for(int i = 0; i < imageOut.Height(); ++i)
+    for(int j = 0; j < imageOut.Width(); ++j)
+      BOOST_CHECK_EQUAL(imageOut(i, j), sampler(image, 2.f * (i + .5f), 2.f * (j + .5f)));
+}
+
+BOOST_AUTO_TEST_CASE(Ressampling_HalfSample)
+{
+  Image<unsigned char> imageUChar(33, 20);
+  Image<float> imageFloat(40, 27);
+
+  for(int i = 0; i < imageUChar.Height(); ++i)
+    for(int j = 0; j < imageUChar.Width(); ++j)
+      imageUChar(i, j) = rand() % 256;
+
+  for(int i = 0; i < imageFloat.Height(); ++i)
+    for(int j = 0; j < imageFloat.Width(); ++j)
+      imageFloat(i, j) = static_cast<float>(rand()) / RAND_MAX;
+
+  checkHalfSample(imageUChar);
+  checkHalfSample(imageFloat);
+}
@@ -49,7 +49,8 @@ KeyframeSelector::KeyframeSelector(const std::vector<std::string>& mediaPaths,
   for(const auto& path : _mediaPaths)
   {
     // create a feed provider per mediaPaths
-    _feeds.emplace_back(new dataio::FeedProvider(path));
+    // the next frames are decoded while the current one is processed
+    _feeds.emplace_back(new dataio::FeedProvider(path, "", dataio::PrefetchOptions()));
 
     const auto& feed = *_feeds.back();
 
@@ -0,0 +1,209 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "aliceVision/numeric/numeric.hpp"
+#include "aliceVision/matching/ArrayMatcher.hpp"
+#include "aliceVision/matching/metric.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/config.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Brute force matcher computing the squared L2 distances by blocks.
+ *
+ * The query and database descriptors are tiled in blocks that fit in the cache and the
+ * distances of a (query block, database block) are computed with a matrix product:
+ *   |q - d|^2 = |q|^2 + |d|^2 - 2 q.d
+ * The N best distances of each query are kept while the database blocks are processed,
+ * so the full distance matrix is never stored. The query blocks are processed in parallel.
+ *
+ * Integer descriptors are converted to float: the products of unsigned char descriptors
+ * (up to 256 dimensions) are exact in float.
+ */
+template < typename Scalar = float, typename Metric = L2_Simple<Scalar> >
+class ArrayMatcher_bruteForceBlocked : public ArrayMatcher<Scalar, Metric>
+{
+public:
+  typedef typename Metric::ResultType DistanceType;
+  /// Scalar type of the matrix products
+  typedef typename std::conditional<std::is_same<Scalar, double>::value, double, float>::type BlockScalar;
+
+  /**
+   * @param[in] queryBlockSize number of query descriptors per block
+   * @param[in] databaseBlockSize number of database descriptors per block
+   */
+  explicit ArrayMatcher_bruteForceBlocked(int queryBlockSize = 256, int databaseBlockSize = 1024)
+    : _queryBlockSize(queryBlockSize)
+    , _databaseBlockSize(databaseBlockSize)
+  {}
+
+  virtual ~ArrayMatcher_bruteForceBlocked() {}
+
+  /**
+   * Build the matching structure
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build(const Scalar * dataset, int nbRows, int dimension)
+  {
+    if (nbRows < 1)
+    {
+      _database.resize(0, 0);
+      _databaseSqNorms.resize(0);
+      return false;
+    }
+    _database = Eigen::Map<const BaseMat>(dataset, nbRows, dimension).template cast<BlockScalar>();
+    _databaseSqNorms = _database.rowwise().squaredNorm();
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour( const Scalar * query,
+                        int * indice, DistanceType * distance)
+  {
+    IndMatches indices;
+    std::vector<DistanceType> distances;
+    if (!SearchNeighbours(query, 1, &indices, &distances, 1))
+      return false;
+    *indice = indices.front()._j;
+    *distance = distances.front();
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[out]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  )
+  {
+    const int nbDatabase = _database.rows();
+    if (nbDatabase == 0 || NN > static_cast<size_t>(nbDatabase) || NN < 1 || nbQuery < 1)
+      return false;
+
+    const int dimension = _database.cols();
+    const BlockMat queries = Eigen::Map<const BaseMat>(query, nbQuery, dimension).template cast<BlockScalar>();
+    const Eigen::Matrix<BlockScalar, Eigen::Dynamic, 1> queriesSqNorms = queries.rowwise().squaredNorm();
+
+    pvec_distances->resize(nbQuery * NN);
+    pvec_indices->resize(nbQuery * NN);
+
+    // smaller query blocks if there are not enough queries for all the threads
+    const int nbThreads = omp_get_max_threads();
+    const int queryBlockSize = std::max(1, std::min(_queryBlockSize, (nbQuery + nbThreads - 1) / nbThreads));
+    const int nbQueryBlocks = (nbQuery + queryBlockSize - 1) / queryBlockSize;
+
+    #pragma omp parallel
+    {
+      BlockMat products;
+      std::vector<BlockScalar> bestDistances;
+      std::vector<int> bestIndices;
+
+      #pragma omp for schedule(dynamic)
+      for (int queryBlock = 0; queryBlock < nbQueryBlocks; ++queryBlock)
+      {
+        const int queryBegin = queryBlock * queryBlockSize;
+        const int queryCount = std::min(queryBlockSize, nbQuery - queryBegin);
+
+        // N best (distance, index) of each query of the block, sorted by distance
+        bestDistances.assign(queryCount * NN, std::numeric_limits<BlockScalar>::max());
+        bestIndices.assign(queryCount * NN, -1);
+
+        for (int databaseBegin = 0; databaseBegin < nbDatabase; databaseBegin += _databaseBlockSize)
+        {
+          const int databaseCount = std::min(_databaseBlockSize, nbDatabase - databaseBegin);
+
+          products.noalias() = queries.middleRows(queryBegin, queryCount) *
+                               _database.middleRows(databaseBegin, databaseCount).transpose();
+
+          for (int q = 0; q < queryCount; ++q)
+          {
+            const BlockScalar querySqNorm = queriesSqNorms(queryBegin + q);
+            BlockScalar* qBestDistances = &bestDistances[q * NN];
+            int* qBestIndices = &bestIndices[q * NN];
+            const BlockScalar* qProducts = products.row(q).data();
+
+            for (int d = 0; d < databaseCount; ++d)
+            {
+              const BlockScalar distance = querySqNorm + _databaseSqNorms(databaseBegin + d) - 2 * qProducts[d];
+              if (distance >= qBestDistances[NN - 1])
+                continue;
+              // insert in the sorted N best
+              size_t i = NN - 1;
+              for (; i > 0 && qBestDistances[i - 1] > distance; --i)
+              {
+                qBestDistances[i] = qBestDistances[i - 1];
+                qBestIndices[i] = qBestIndices[i - 1];
+              }
+              qBestDistances[i] = distance;
+              qBestIndices[i] = databaseBegin + d;
+            }
+          }
+        }
+
+        for (int q = 0; q < queryCount; ++q)
+        {
+          const int queryIndex = queryBegin + q;
+          for (size_t i = 0; i < NN; ++i)
+          {
+            // rounding errors of the expanded formula may give small negative values
+            (*pvec_distances)[queryIndex * NN + i] = static_cast<DistanceType>(std::max(BlockScalar(0), bestDistances[q * NN + i]));
+            (*pvec_indices)[queryIndex * NN + i] = IndMatch(queryIndex, bestIndices[q * NN + i]);
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> BaseMat;
+  typedef Eigen::Matrix<BlockScalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> BlockMat;
+
+  int _queryBlockSize;
+  int _databaseBlockSize;
+  /// database descriptors converted to the products scalar type
+  BlockMat _database;
+  /// squared norm of each database descriptor
+  Eigen::Matrix<BlockScalar, Eigen::Dynamic, 1> _databaseSqNorms;
+};
+
+}  // namespace matching
+}  // namespace aliceVision
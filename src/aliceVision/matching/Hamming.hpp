@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/matching/metric.hpp>
+#include <aliceVision/matching/metricSimd.hpp>
 
 #include <bitset>
 
@@ -26,7 +27,7 @@ typedef unsigned __int64 uint64_t;
 // Brief:
 // Hamming distance count the number of bits in common between descriptors
 //  by using a XOR operation + a count.
-// For maximal performance SSE4 must be enable for builtin popcount activation.
+// The raw memory version uses the AVX2/AVX-512 kernels when the CPU supports them.
 
 namespace aliceVision {
 namespace matching {
@@ -111,58 +112,10 @@ struct Hamming
   template <typename Iterator1, typename Iterator2>
   inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
   {
-    ResultType result = 0;
-// Windows & generic platforms:
-
-#ifdef PLATFORM_64_BIT
-    if(size%sizeof(uint64_t) == 0)
-    {
-      const uint64_t* pa = reinterpret_cast<const uint64_t*>(a);
-      const uint64_t* pb = reinterpret_cast<const uint64_t*>(b);
-      size /= (sizeof(uint64_t)/sizeof(unsigned char));
-      for(size_t i = 0; i < size; ++i, ++pa, ++pb ) {
-        result += popcnt64(*pa ^ *pb);
-      }
-    }
-    else if(size%sizeof(uint32_t) == 0)
-    {
-      const uint32_t* pa = reinterpret_cast<const uint32_t*>(a);
-      const uint32_t* pb = reinterpret_cast<const uint32_t*>(b);
-      size /= (sizeof(uint32_t)/sizeof(unsigned char));
-      for(size_t i = 0; i < size; ++i, ++pa, ++pb ) {
-        result += popcnt32(*pa ^ *pb);
-      }
-    }
-    else
-    {
-      const ElementType * a2 = reinterpret_cast<const ElementType*> (a);
-      const ElementType * b2 = reinterpret_cast<const ElementType*> (b);
-      for (size_t i = 0;
-           i < size / (sizeof(unsigned char)); ++i) {
-        result += pop_count_LUT[a2[i] ^ b2[i]];
-      }
-    }
-#else // PLATFORM_64_BIT
-    if(size%sizeof(uint32_t) == 0)
-    {
-      const uint32_t* pa = reinterpret_cast<const uint32_t*>(a);
-      const uint32_t* pb = reinterpret_cast<const uint32_t*>(b);
-      size /= (sizeof(uint32_t)/sizeof(unsigned char));
-      for(size_t i = 0; i < size; ++i, ++pa, ++pb ) {
-        result += popcnt32(*pa ^ *pb);
-      }
-    }
-    else
-    {
-      const ElementType * a2 = reinterpret_cast<const ElementType*> (a);
-      const ElementType * b2 = reinterpret_cast<const ElementType*> (b);
-      for (size_t i = 0;
-           i < size / (sizeof(unsigned char)); ++i) {
-        result += pop_count_LUT[a2[i] ^ b2[i]];
-      }
-    }
-#endif // PLATFORM_64_BIT
-    return result;
+    // AVX2/AVX-512 popcount selected at runtime
+    return simd::hamming(reinterpret_cast<const unsigned char*>(a),
+                         reinterpret_cast<const unsigned char*>(b),
+                         size * sizeof(ElementType));
   }
 };
 
@@ -8,6 +8,7 @@
 #include "aliceVision/matching/matcherType.hpp"
 #include "aliceVision/matching/RegionsMatcher.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceBlocked.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
 
@@ -81,6 +82,13 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BRUTE_FORCE_BLOCKED_L2:
+        {
+          typedef L2_Vectorized<unsigned char> MetricT;
+          typedef ArrayMatcher_bruteForceBlocked<unsigned char, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<unsigned char> MatcherT;
@@ -110,6 +118,13 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BRUTE_FORCE_BLOCKED_L2:
+        {
+          typedef L2_Vectorized<float> MetricT;
+          typedef ArrayMatcher_bruteForceBlocked<float, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<float> MatcherT;
@@ -139,6 +154,13 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BRUTE_FORCE_BLOCKED_L2:
+        {
+          typedef L2_Vectorized<double> MetricT;
+          typedef ArrayMatcher_bruteForceBlocked<double, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<double> MatcherT;
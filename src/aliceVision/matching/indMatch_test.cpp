@@ -69,6 +69,48 @@ BOOST_AUTO_TEST_CASE(IndMatch_IO)
   }
 }
 
+BOOST_AUTO_TEST_CASE(IndMatch_IO_BINARY)
+{
+  PairwiseMatches matches;
+  matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}};
+  matches[std::make_pair(0,2)][EImageDescriberType::UNKNOWN] = {{1000000,3},{2,5000000},{7,7}};
+  matches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{5,0},{1,1},{2,2}};
+  matches[std::make_pair(1,2)][EImageDescriberType::SIFT] = {{42,12}};
+  matches[std::make_pair(2,3)][EImageDescriberType::UNKNOWN] = {};
+
+  for(bool matchFilePerImage : {false, true})
+  {
+    const std::string mode = matchFilePerImage ? "test_bin_per_image" : "test_bin";
+    BOOST_CHECK(Save(matches, ".", mode, "bin", matchFilePerImage));
+
+    // load all the pairs
+    {
+      PairwiseMatches loadedMatches;
+      BOOST_CHECK(Load(loadedMatches, {0, 1, 2, 3}, {"."}, {}, mode));
+      BOOST_CHECK(loadedMatches == matches);
+    }
+
+    // load the pairs of a subset of views
+    {
+      PairwiseMatches loadedMatches;
+      BOOST_CHECK(Load(loadedMatches, {1, 2}, {"."}, {}, mode));
+      BOOST_CHECK_EQUAL(1, loadedMatches.size());
+      BOOST_CHECK(loadedMatches.at(std::make_pair(1,2)) == matches.at(std::make_pair(1,2)));
+    }
+  }
+
+  // random access to one pair
+  {
+    BinaryMatchesReader reader("./matches.test_bin.bin");
+    BOOST_CHECK_EQUAL(matches.size(), reader.getPairs().size());
+
+    MatchesPerDescType pairMatches;
+    BOOST_CHECK(reader.load(std::make_pair(0,2), pairMatches));
+    BOOST_CHECK(pairMatches == matches.at(std::make_pair(0,2)));
+    BOOST_CHECK(!reader.load(std::make_pair(0,3), pairMatches));
+  }
+}
+
 BOOST_AUTO_TEST_CASE(IndMatch_DuplicateRemoval_NoRemoval)
 {
   std::vector<IndMatch> vec_indMatch;
@@ -12,9 +12,12 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include <fstream>
 #include <iterator>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -23,14 +26,214 @@ namespace fs = boost::filesystem;
 namespace aliceVision {
 namespace matching {
 
-bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
+namespace {
+
+const char MATCHES_BINARY_MAGIC[8] = {'A', 'V', 'M', 'A', 'T', 'C', 'H', 'S'};
+const std::uint32_t MATCHES_BINARY_VERSION = 1;
+
+/// magic, version, number of pairs, offset of the pairs table
+const std::uint64_t MATCHES_BINARY_HEADER_SIZE = 8 + 4 + 4 + 8;
+
+/// I, J, offset, size
+const std::uint64_t MATCHES_BINARY_PAIR_ENTRY_SIZE = 4 + 4 + 8 + 8;
+
+template<typename T>
+void writeValue(std::ostream& stream, const T& value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T readValue(const char*& data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  data += sizeof(T);
+  return value;
+}
+
+/// Append an unsigned LEB128 varint
+inline void writeVarint(std::string& buffer, std::uint64_t value)
+{
+  while(value >= 0x80)
+  {
+    buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<char>(value));
+}
+
+/// Read an unsigned LEB128 varint
+inline std::uint64_t readVarint(const char*& data, const char* end)
+{
+  std::uint64_t value = 0;
+  for(int shift = 0; shift < 64; shift += 7)
+  {
+    if(data == end)
+      throw std::runtime_error("Truncated varint.");
+    const std::uint8_t byte = static_cast<std::uint8_t>(*data++);
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if((byte & 0x80) == 0)
+      return value;
+  }
+  throw std::runtime_error("Invalid varint.");
+}
+
+/// Map the signed difference between two indices to an unsigned value (small for small differences)
+inline std::uint64_t zigzagEncode(IndexT value, IndexT previous)
+{
+  const std::int64_t delta = static_cast<std::int64_t>(value) - static_cast<std::int64_t>(previous);
+  return (static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63);
+}
+
+inline IndexT zigzagDecode(std::uint64_t value, IndexT previous)
+{
+  const std::int64_t delta = static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+  return static_cast<IndexT>(static_cast<std::int64_t>(previous) + delta);
+}
+
+/// Encode the matches of one image pair
+void encodePairMatches(const MatchesPerDescType& matchesPerDesc, std::string& buffer)
+{
+  buffer.clear();
+  writeVarint(buffer, matchesPerDesc.size());
+  for(const auto& matches : matchesPerDesc)
+  {
+    buffer.push_back(static_cast<char>(matches.first));
+    writeVarint(buffer, matches.second.size());
+    IndexT previousI = 0;
+    IndexT previousJ = 0;
+    for(const IndMatch& match : matches.second)
+    {
+      writeVarint(buffer, zigzagEncode(match._i, previousI));
+      writeVarint(buffer, zigzagEncode(match._j, previousJ));
+      previousI = match._i;
+      previousJ = match._j;
+    }
+  }
+}
+
+} // namespace
+
+BinaryMatchesReader::BinaryMatchesReader(const std::string& filepath)
+  : _filepath(filepath)
+{
+  try
+  {
+    _file = boost::interprocess::file_mapping(filepath.c_str(), boost::interprocess::read_only);
+    _region = boost::interprocess::mapped_region(_file, boost::interprocess::read_only);
+  }
+  catch(const boost::interprocess::interprocess_exception& e)
+  {
+    throw std::runtime_error("Can't map match file '" + filepath + "': " + e.what());
+  }
+
+  const char* begin = static_cast<const char*>(_region.get_address());
+  const std::uint64_t fileSize = _region.get_size();
+
+  if(fileSize < MATCHES_BINARY_HEADER_SIZE || std::memcmp(begin, MATCHES_BINARY_MAGIC, sizeof(MATCHES_BINARY_MAGIC)) != 0)
+    throw std::runtime_error("Invalid binary match file '" + filepath + "'.");
+
+  const char* data = begin + sizeof(MATCHES_BINARY_MAGIC);
+  const std::uint32_t version = readValue<std::uint32_t>(data);
+  const std::uint32_t nbPairs = readValue<std::uint32_t>(data);
+  const std::uint64_t tableOffset = readValue<std::uint64_t>(data);
+
+  if(version != MATCHES_BINARY_VERSION)
+    throw std::runtime_error("Unsupported binary match file version " + std::to_string(version) + " in file '" + filepath + "'.");
+
+  if(tableOffset > fileSize || nbPairs * MATCHES_BINARY_PAIR_ENTRY_SIZE > fileSize - tableOffset)
+    throw std::runtime_error("Invalid binary match file '" + filepath + "', the file is truncated.");
+
+  _pairs.resize(nbPairs);
+  data = begin + tableOffset;
+  for(PairEntry& entry : _pairs)
+  {
+    entry.pair.first = readValue<std::uint32_t>(data);
+    entry.pair.second = readValue<std::uint32_t>(data);
+    entry.offset = readValue<std::uint64_t>(data);
+    entry.size = readValue<std::uint64_t>(data);
+
+    if(entry.offset > tableOffset || entry.size > tableOffset - entry.offset)
+      throw std::runtime_error("Invalid binary match file '" + filepath + "', the file is truncated.");
+  }
+}
+
+void BinaryMatchesReader::load(const PairEntry& entry, MatchesPerDescType& matchesPerDesc) const
+{
+  const char* data = static_cast<const char*>(_region.get_address()) + entry.offset;
+  const char* end = data + entry.size;
+
+  const std::uint64_t nbDescTypes = readVarint(data, end);
+  for(std::uint64_t d = 0; d < nbDescTypes; ++d)
+  {
+    if(data == end)
+      throw std::runtime_error("Invalid binary match file '" + _filepath + "', the file is truncated.");
+
+    const feature::EImageDescriberType descType = static_cast<feature::EImageDescriberType>(*data++);
+    const std::uint64_t nbMatches = readVarint(data, end);
+
+    // each match takes at least 2 bytes
+    if(nbMatches > static_cast<std::uint64_t>(end - data) / 2)
+      throw std::runtime_error("Invalid binary match file '" + _filepath + "', the file is truncated.");
+
+    IndMatches matches(nbMatches);
+    IndexT previousI = 0;
+    IndexT previousJ = 0;
+    for(IndMatch& match : matches)
+    {
+      match._i = previousI = zigzagDecode(readVarint(data, end), previousI);
+      match._j = previousJ = zigzagDecode(readVarint(data, end), previousJ);
+    }
+    matchesPerDesc[descType] = std::move(matches);
+  }
+}
+
+bool BinaryMatchesReader::load(const Pair& pair, MatchesPerDescType& matches) const
+{
+  const auto it = std::lower_bound(_pairs.begin(), _pairs.end(), pair,
+                                   [](const PairEntry& entry, const Pair& p) { return entry.pair < p; });
+  if(it == _pairs.end() || it->pair != pair)
+    return false;
+  load(*it, matches);
+  return true;
+}
+
+void BinaryMatchesReader::load(PairwiseMatches& matches, const std::set<IndexT>& viewsKeysFilter) const
+{
+  for(const PairEntry& entry : _pairs)
+  {
+    if(!viewsKeysFilter.empty() &&
+       (viewsKeysFilter.find(entry.pair.first) == viewsKeysFilter.end() ||
+        viewsKeysFilter.find(entry.pair.second) == viewsKeysFilter.end()))
+      continue;
+
+    load(entry, matches[entry.pair]);
+  }
+}
+
+bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath, const std::set<IndexT>& viewsKeysFilter)
 {
   const std::string ext = fs::extension(filepath);
 
   if(!fs::exists(filepath))
     return false;
 
-  if(ext == ".txt")
+  if(ext == ".bin")
+  {
+    try
+    {
+      BinaryMatchesReader reader(filepath);
+      reader.load(matches, viewsKeysFilter);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING(e.what());
+      return false;
+    }
+    return true;
+  }
+  else if(ext == ".txt")
   {
     std::ifstream stream(filepath.c_str());
     if (!stream.is_open())
@@ -82,18 +285,20 @@ void filterMatchesByViews(
   PairwiseMatches & matches,
   const std::set<IndexT> & viewsKeys)
 {
-  matching::PairwiseMatches filteredMatches;
-  for (matching::PairwiseMatches::const_iterator iter = matches.begin();
-    iter != matches.end();
-    ++iter)
+  // erase in place to avoid copying the matches of the kept pairs
+  for (matching::PairwiseMatches::iterator iter = matches.begin();
+    iter != matches.end();)
   {
     if(viewsKeys.find(iter->first.first) != viewsKeys.end() &&
        viewsKeys.find(iter->first.second) != viewsKeys.end())
     {
-      filteredMatches.insert(*iter);
+      ++iter;
+    }
+    else
+    {
+      iter = matches.erase(iter);
     }
   }
-  matches.swap(filteredMatches);
 }
 
 void filterTopMatches(
@@ -148,8 +353,14 @@ bool LoadMatchFilePerImage(
     std::advance(it, i);
     const IndexT idView = *it;
     const std::string matchFilename = std::to_string(idView) + "." + basename;
+    // use the binary match file if available
+    fs::path matchFilepath = fs::path(folder) / matchFilename;
+    const fs::path binMatchFilepath = fs::path(matchFilepath).replace_extension(".bin");
+    if(fs::exists(binMatchFilepath))
+      matchFilepath = binMatchFilepath;
+
     PairwiseMatches fileMatches;
-    if(!LoadMatchFile(fileMatches, (fs::path(folder) / matchFilename).string() ))
+    if(!LoadMatchFile(fileMatches, matchFilepath.string(), viewsKeys))
     {
       #pragma omp critical
       {
@@ -194,12 +405,19 @@ bool Load(
 {
   bool res = false;
   const std::string fileName = "matches." + mode + ".txt";
+  const std::string binFileName = "matches." + mode + ".bin";
 
   for(const std::string& folder : folders)
   {
     const fs::path filePath = fs::path(folder) / fileName;
+    const fs::path binFilePath = fs::path(folder) / binFileName;
 
-    if(fs::exists(filePath))
+    if(fs::exists(binFilePath))
+    {
+      // only read the pairs of the filtered views
+      res = LoadMatchFile(matches, binFilePath.string(), viewsKeysFilter);
+    }
+    else if(fs::exists(filePath))
     {
       res = LoadMatchFile(matches, filePath.string());
     }
@@ -273,6 +491,59 @@ private:
     fs::rename(tmpPath, filepath);
   }
 
+  void saveBin(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    const fs::path bPath = fs::path(filepath);
+    const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+    // write temporary file
+    {
+      std::ofstream stream(tmpPath.c_str(), std::ios::out | std::ios::binary);
+      if(!stream.is_open())
+        throw std::runtime_error("Can't write match file '" + tmpPath + "'.");
+
+      // header placeholder
+      const std::string header(MATCHES_BINARY_HEADER_SIZE, '\0');
+      stream.write(header.data(), header.size());
+
+      std::vector<BinaryMatchesReader::PairEntry> pairs;
+      std::string buffer;
+      for(PairwiseMatches::const_iterator match = matchBegin;
+        match != matchEnd;
+        ++match)
+      {
+        encodePairMatches(match->second, buffer);
+        pairs.push_back({match->first, static_cast<std::uint64_t>(stream.tellp()), buffer.size()});
+        stream.write(buffer.data(), buffer.size());
+      }
+
+      // pairs table (PairwiseMatches is sorted by pair)
+      const std::uint64_t tableOffset = stream.tellp();
+      for(const auto& entry : pairs)
+      {
+        writeValue(stream, static_cast<std::uint32_t>(entry.pair.first));
+        writeValue(stream, static_cast<std::uint32_t>(entry.pair.second));
+        writeValue(stream, entry.offset);
+        writeValue(stream, entry.size);
+      }
+
+      stream.seekp(0);
+      stream.write(MATCHES_BINARY_MAGIC, sizeof(MATCHES_BINARY_MAGIC));
+      writeValue(stream, MATCHES_BINARY_VERSION);
+      writeValue(stream, static_cast<std::uint32_t>(pairs.size()));
+      writeValue(stream, tableOffset);
+
+      if(!stream.good())
+        throw std::runtime_error("Can't write match file '" + tmpPath + "'.");
+    }
+
+    // rename temporary file
+    fs::rename(tmpPath, filepath);
+  }
+
 public:
   MatchExporter(
     const PairwiseMatches& matches,
@@ -297,6 +568,10 @@ public:
     {
       saveTxt(filepath, m_matches.begin(), m_matches.end());
     }
+    else if(m_ext == ".bin")
+    {
+      saveBin(filepath, m_matches.begin(), m_matches.end());
+    }
     else
     {
       throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
@@ -317,7 +592,7 @@ public:
     for(IndexT key: keys)
     {
       PairwiseMatches::const_iterator match = matchBegin;
-      while(match->first.first == key && match != matchEnd)
+      while(match != matchEnd && match->first.first == key)
       {
         ++match;
       }
@@ -328,6 +603,10 @@ public:
       {
         saveTxt(filepath, matchBegin, match);
       }
+      else if(m_ext == ".bin")
+      {
+        saveBin(filepath, matchBegin, match);
+      }
       else
       {
         throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
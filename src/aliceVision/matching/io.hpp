@@ -9,23 +9,88 @@
 
 #include <aliceVision/matching/IndMatch.hpp>
 
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <set>
 #include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace matching {
 
   
 /**
- * @brief Load a match file.
+ * @brief Read a binary match file (*.bin) with a random access to each image pair.
+ *
+ * File layout (native endianness):
+ * - header: magic "AVMATCHS", version, number of pairs, offset of the pairs table
+ * - data: for each pair, the number of describer types then for each describer type
+ *         its id, the number of matches and the matches. The matches are stored as the
+ *         zigzag varint encoded differences with the previous match indices.
+ * - pairs table: for each pair sorted by (I, J), the view ids and the data offset and size
+ *
+ * The file is memory-mapped, only the table is read when the file is opened.
+ */
+class BinaryMatchesReader
+{
+public:
+  struct PairEntry
+  {
+    Pair pair;
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  /**
+   * @brief Open and map a binary match file
+   * @param[in] filepath the binary match file path
+   */
+  explicit BinaryMatchesReader(const std::string& filepath);
+
+  /// Return the pairs stored in the file sorted by (I, J)
+  const std::vector<PairEntry>& getPairs() const
+  {
+    return _pairs;
+  }
+
+  /**
+   * @brief Load the matches of an image pair.
+   * @param[in] pair the image pair
+   * @param[out] matches the matches of the pair for each describer type
+   * @return false if the file doesn't contain the pair
+   */
+  bool load(const Pair& pair, MatchesPerDescType& matches) const;
+
+  /**
+   * @brief Load the matches of the image pairs with both views in the filter.
+   * @param[out] matches: container for the output matches
+   * @param[in] viewsKeysFilter: views to load, all the pairs are loaded if empty
+   */
+  void load(PairwiseMatches& matches, const std::set<IndexT>& viewsKeysFilter = std::set<IndexT>()) const;
+
+private:
+  void load(const PairEntry& entry, MatchesPerDescType& matches) const;
+
+  std::string _filepath;
+  boost::interprocess::file_mapping _file;
+  boost::interprocess::mapped_region _region;
+  std::vector<PairEntry> _pairs;
+};
+
+/**
+ * @brief Load a match file (*.txt or *.bin).
  *
  * @param[out] matches: container for the output matches
- * @param[in] folder: folder containing the match files
- * @param[in] mode: type of matching, it could be: "f", "e" or "putative".
+ * @param[in] filepath: the match file path
+ * @param[in] viewsKeysFilter: with a binary file, only the pairs with both views
+ *            in the filter are read (if not empty)
  */
 bool LoadMatchFile(
   PairwiseMatches & matches,
-  const std::string & folder,
-  const std::string & filename);
+  const std::string & filepath,
+  const std::set<IndexT> & viewsKeysFilter = std::set<IndexT>());
 
 /**
  * @brief Load the match file for each image.
@@ -42,6 +107,7 @@ bool LoadMatchFilePerImage(
 
 /**
  * @brief Load match files.
+ * The binary match files (*.bin) are used in priority, only the pairs of the filtered views are read.
  *
  * @param[out] matches: container for the output matches
  * @param[in] sfm_data
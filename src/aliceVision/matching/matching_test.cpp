@@ -7,9 +7,11 @@
 
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceBlocked.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
 #include <iostream>
+#include <random>
 
 #define BOOST_TEST_MODULE matching
 #include <boost/test/included/unit_test.hpp>
@@ -82,6 +84,71 @@ BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Simple_Dim4)
   BOOST_CHECK_SMALL(static_cast<double>(fDistance), 1e-8); //distance
 }
 
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_NN)
+{
+  const float array[] = {0, 1, 2, 5, 6};
+  // no 3, because it involve the same dist as 1,1
+  ArrayMatcher_bruteForceBlocked<float> matcher(2, 2);
+  BOOST_CHECK( matcher.Build(array, 5, 1) );
+
+  const float query[] = {2};
+  IndMatches vec_nIndice;
+  vector<float> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(query,1, &vec_nIndice, &vec_fDistance, 5) );
+
+  BOOST_CHECK_EQUAL( 5, vec_nIndice.size());
+  BOOST_CHECK_EQUAL( 5, vec_fDistance.size());
+
+  // Check distances:
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[0]- Square(2.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[1]- Square(1.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[2]- Square(0.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[3]- Square(5.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[4]- Square(6.0f-2.0f)), 1e-6);
+
+  // Check indexes:
+  BOOST_CHECK_EQUAL(IndMatch(0,2), vec_nIndice[0]);
+  BOOST_CHECK_EQUAL(IndMatch(0,1), vec_nIndice[1]);
+  BOOST_CHECK_EQUAL(IndMatch(0,0), vec_nIndice[2]);
+  BOOST_CHECK_EQUAL(IndMatch(0,3), vec_nIndice[3]);
+  BOOST_CHECK_EQUAL(IndMatch(0,4), vec_nIndice[4]);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_SameAsBruteForce)
+{
+  // random SIFT like descriptors, the blocks don't divide the number of descriptors
+  const int dimension = 128;
+  const int nbDatabase = 300;
+  const int nbQuery = 70;
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<unsigned char> database(nbDatabase * dimension), query(nbQuery * dimension);
+  for(unsigned char& v : database)
+    v = static_cast<unsigned char>(distribution(generator));
+  for(unsigned char& v : query)
+    v = static_cast<unsigned char>(distribution(generator));
+
+  typedef L2_Vectorized<unsigned char> MetricT;
+  ArrayMatcher_bruteForce<unsigned char, MetricT> bruteForceMatcher;
+  ArrayMatcher_bruteForceBlocked<unsigned char, MetricT> blockedMatcher(16, 64);
+  BOOST_CHECK( bruteForceMatcher.Build(&database[0], nbDatabase, dimension) );
+  BOOST_CHECK( blockedMatcher.Build(&database[0], nbDatabase, dimension) );
+
+  IndMatches bruteForceIndices, blockedIndices;
+  vector<float> bruteForceDistances, blockedDistances;
+  BOOST_CHECK( bruteForceMatcher.SearchNeighbours(&query[0], nbQuery, &bruteForceIndices, &bruteForceDistances, 2) );
+  BOOST_CHECK( blockedMatcher.SearchNeighbours(&query[0], nbQuery, &blockedIndices, &blockedDistances, 2) );
+
+  BOOST_CHECK_EQUAL(bruteForceIndices.size(), blockedIndices.size());
+  for(std::size_t i = 0; i < bruteForceIndices.size(); ++i)
+  {
+    // unsigned char distances are exact, the indices only differ for equal distances
+    BOOST_CHECK_EQUAL(bruteForceDistances[i], blockedDistances[i]);
+    if(bruteForceDistances[i] != bruteForceDistances[i ^ 1])
+      BOOST_CHECK_EQUAL(bruteForceIndices[i], blockedIndices[i]);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_Simple__NN)
 {
   const float array[] = {0, 1, 2, 5, 6};
@@ -0,0 +1,162 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "metricSimd.hpp"
+#include <aliceVision/system/cpu.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace matching {
+namespace simd {
+
+// kernels built with specific compiler flags (see CMakeLists.txt)
+#ifdef ALICEVISION_MATCHING_AVX2
+namespace avx2 {
+float l2Float(const float* a, const float* b, std::size_t size);
+float l2Uchar(const unsigned char* a, const unsigned char* b, std::size_t size);
+unsigned int hamming(const unsigned char* a, const unsigned char* b, std::size_t size);
+} // namespace avx2
+#endif
+
+#ifdef ALICEVISION_MATCHING_AVX512
+namespace avx512 {
+float l2Float(const float* a, const float* b, std::size_t size);
+float l2Uchar(const unsigned char* a, const unsigned char* b, std::size_t size);
+unsigned int hamming(const unsigned char* a, const unsigned char* b, std::size_t size);
+} // namespace avx512
+#endif
+
+namespace scalar {
+
+float l2Float(const float* a, const float* b, std::size_t size)
+{
+  // 4 accumulators to let the compiler vectorize with the baseline instruction set
+  float sum0 = 0.f, sum1 = 0.f, sum2 = 0.f, sum3 = 0.f;
+  std::size_t i = 0;
+  for(; i + 4 <= size; i += 4)
+  {
+    const float d0 = a[i] - b[i];
+    const float d1 = a[i + 1] - b[i + 1];
+    const float d2 = a[i + 2] - b[i + 2];
+    const float d3 = a[i + 3] - b[i + 3];
+    sum0 += d0 * d0;
+    sum1 += d1 * d1;
+    sum2 += d2 * d2;
+    sum3 += d3 * d3;
+  }
+  for(; i < size; ++i)
+  {
+    const float d = a[i] - b[i];
+    sum0 += d * d;
+  }
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
+float l2Uchar(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  std::uint64_t sum = 0;
+  for(std::size_t i = 0; i < size; ++i)
+  {
+    const int d = int(a[i]) - int(b[i]);
+    sum += d * d;
+  }
+  return static_cast<float>(sum);
+}
+
+unsigned int hamming(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  unsigned int result = 0;
+  std::size_t i = 0;
+  for(; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
+  {
+    std::uint64_t va, vb;
+    std::memcpy(&va, a + i, sizeof(va));
+    std::memcpy(&vb, b + i, sizeof(vb));
+    std::uint64_t n = va ^ vb;
+    // popcount, http://en.wikipedia.org/wiki/Hamming_weight
+    n -= ((n >> 1) & 0x5555555555555555ULL);
+    n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+    result += static_cast<unsigned int>((((n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fULL) * 0x0101010101010101ULL) >> 56);
+  }
+  for(; i < size; ++i)
+  {
+    unsigned int n = a[i] ^ b[i];
+    for(; n; n &= n - 1)
+      ++result;
+  }
+  return result;
+}
+
+} // namespace scalar
+
+std::string EInstructionSet_enumToString(EInstructionSet instructionSet)
+{
+  switch(instructionSet)
+  {
+    case EInstructionSet::SCALAR: return "scalar";
+    case EInstructionSet::AVX2:   return "avx2";
+    case EInstructionSet::AVX512: return "avx512";
+  }
+  throw std::out_of_range("Invalid instruction set enum");
+}
+
+const DistanceKernels* getKernels(EInstructionSet instructionSet)
+{
+  static const DistanceKernels scalarKernels = {&scalar::l2Float, &scalar::l2Uchar, &scalar::hamming};
+#ifdef ALICEVISION_MATCHING_AVX2
+  static const DistanceKernels avx2Kernels = {&avx2::l2Float, &avx2::l2Uchar, &avx2::hamming};
+#endif
+#ifdef ALICEVISION_MATCHING_AVX512
+  static const DistanceKernels avx512Kernels = {&avx512::l2Float, &avx512::l2Uchar, &avx512::hamming};
+#endif
+
+  switch(instructionSet)
+  {
+    case EInstructionSet::SCALAR:
+      return &scalarKernels;
+    case EInstructionSet::AVX2:
+#ifdef ALICEVISION_MATCHING_AVX2
+      if(system::cpu_supports_avx2())
+        return &avx2Kernels;
+#endif
+      return nullptr;
+    case EInstructionSet::AVX512:
+#ifdef ALICEVISION_MATCHING_AVX512
+      if(system::cpu_supports_avx512())
+        return &avx512Kernels;
+#endif
+      return nullptr;
+  }
+  return nullptr;
+}
+
+EInstructionSet getBestInstructionSet()
+{
+  for(EInstructionSet instructionSet : {EInstructionSet::AVX512, EInstructionSet::AVX2})
+  {
+    if(getKernels(instructionSet) != nullptr)
+      return instructionSet;
+  }
+  return EInstructionSet::SCALAR;
+}
+
+const DistanceKernels& getBestKernels()
+{
+  static const DistanceKernels& kernels = []() -> const DistanceKernels& {
+    const EInstructionSet instructionSet = getBestInstructionSet();
+    ALICEVISION_LOG_DEBUG("Descriptor distance kernels: " << EInstructionSet_enumToString(instructionSet));
+    return *getKernels(instructionSet);
+  }();
+  return kernels;
+}
+
+} // namespace simd
+} // namespace matching
+} // namespace aliceVision
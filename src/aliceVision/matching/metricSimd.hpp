@@ -0,0 +1,75 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace aliceVision {
+namespace matching {
+namespace simd {
+
+/**
+ * @brief Instruction sets of the descriptor distance kernels.
+ */
+enum class EInstructionSet
+{
+  SCALAR = 0,
+  AVX2,
+  AVX512
+};
+
+std::string EInstructionSet_enumToString(EInstructionSet instructionSet);
+
+/**
+ * @brief Descriptor distance kernels of one instruction set.
+ * The kernels accept any size and unaligned data.
+ */
+struct DistanceKernels
+{
+  /// Squared L2 distance between float descriptors
+  float (*l2Float)(const float* a, const float* b, std::size_t size);
+  /// Squared L2 distance between unsigned char descriptors
+  float (*l2Uchar)(const unsigned char* a, const unsigned char* b, std::size_t size);
+  /// Hamming distance between binary descriptors of size bytes
+  unsigned int (*hamming)(const unsigned char* a, const unsigned char* b, std::size_t size);
+};
+
+/**
+ * @brief Get the kernels of an instruction set.
+ * @return nullptr if the instruction set is not supported by the CPU or not built
+ */
+const DistanceKernels* getKernels(EInstructionSet instructionSet);
+
+/**
+ * @brief Get the best instruction set supported by the CPU and the build.
+ */
+EInstructionSet getBestInstructionSet();
+
+/**
+ * @brief Get the kernels of the best instruction set, selected on the first call.
+ */
+const DistanceKernels& getBestKernels();
+
+inline float l2Float(const float* a, const float* b, std::size_t size)
+{
+  return getBestKernels().l2Float(a, b, size);
+}
+
+inline float l2Uchar(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  return getBestKernels().l2Uchar(a, b, size);
+}
+
+inline unsigned int hamming(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  return getBestKernels().hamming(a, b, size);
+}
+
+} // namespace simd
+} // namespace matching
+} // namespace aliceVision
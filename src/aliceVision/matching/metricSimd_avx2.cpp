@@ -0,0 +1,131 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+// Built with the AVX2 and FMA compiler flags, only called if the CPU supports them.
+// Don't include headers with inline functions or templates here: the linker could keep
+// their AVX2 versions for the other translation units.
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aliceVision {
+namespace matching {
+namespace simd {
+namespace avx2 {
+
+namespace {
+
+inline float horizontalSum(__m256 v)
+{
+  const __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  const __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  const __m128 sum1 = _mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 1));
+  return _mm_cvtss_f32(sum1);
+}
+
+inline int horizontalSum(__m256i v)
+{
+  const __m128i sum4 = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  const __m128i sum2 = _mm_add_epi32(sum4, _mm_unpackhi_epi64(sum4, sum4));
+  const __m128i sum1 = _mm_add_epi32(sum2, _mm_shuffle_epi32(sum2, 1));
+  return _mm_cvtsi128_si32(sum1);
+}
+
+inline unsigned int popcount64(std::uint64_t v)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+  return static_cast<unsigned int>(_mm_popcnt_u64(v));
+#else
+  return _mm_popcnt_u32(static_cast<unsigned int>(v)) + _mm_popcnt_u32(static_cast<unsigned int>(v >> 32));
+#endif
+}
+
+} // namespace
+
+float l2Float(const float* a, const float* b, std::size_t size)
+{
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    const __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    sum0 = _mm256_fmadd_ps(d0, d0, sum0);
+    sum1 = _mm256_fmadd_ps(d1, d1, sum1);
+  }
+  if(i + 8 <= size)
+  {
+    const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    sum0 = _mm256_fmadd_ps(d, d, sum0);
+    i += 8;
+  }
+  float result = horizontalSum(_mm256_add_ps(sum0, sum1));
+  for(; i < size; ++i)
+  {
+    const float d = a[i] - b[i];
+    result += d * d;
+  }
+  return result;
+}
+
+float l2Uchar(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  // squared differences of 16 bits values summed by pairs in 32 bits lanes (no overflow below 256k values)
+  __m256i sum = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+    const __m256i vb = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+    const __m256i d = _mm256_sub_epi16(va, vb);
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(d, d));
+  }
+  std::uint64_t result = static_cast<unsigned int>(horizontalSum(sum));
+  for(; i < size; ++i)
+  {
+    const int d = int(a[i]) - int(b[i]);
+    result += d * d;
+  }
+  return static_cast<float>(result);
+}
+
+unsigned int hamming(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  // popcount of each nibble with a lookup table, summed with sad
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i lowMask = _mm256_set1_epi8(0x0f);
+  __m256i sum = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, lowMask));
+    const __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask));
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+  }
+  const __m128i sum2 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  unsigned int result = static_cast<unsigned int>(_mm_cvtsi128_si32(sum2) + _mm_extract_epi32(sum2, 2));
+  for(; i + 8 <= size; i += 8)
+  {
+    std::uint64_t va, vb;
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&va), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + i)));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&vb), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + i)));
+    result += popcount64(va ^ vb);
+  }
+  for(; i < size; ++i)
+    result += _mm_popcnt_u32(a[i] ^ b[i]);
+  return result;
+}
+
+} // namespace avx2
+} // namespace simd
+} // namespace matching
+} // namespace aliceVision
@@ -0,0 +1,111 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+// Built with the AVX-512 F/BW compiler flags, only called if the CPU supports them.
+// Don't include headers with inline functions or templates here: the linker could keep
+// their AVX-512 versions for the other translation units.
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aliceVision {
+namespace matching {
+namespace simd {
+namespace avx512 {
+
+namespace {
+
+/// Mask of the first n lanes (n < 64)
+inline __mmask64 tailMask64(std::size_t n)
+{
+  return (static_cast<std::uint64_t>(1) << n) - 1;
+}
+
+inline __m512i popcountBytes(__m512i v)
+{
+  // popcount of each nibble with a lookup table
+  const __m512i lookup = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+  const __m512i lowMask = _mm512_set1_epi8(0x0f);
+  const __m512i low = _mm512_shuffle_epi8(lookup, _mm512_and_si512(v, lowMask));
+  const __m512i high = _mm512_shuffle_epi8(lookup, _mm512_and_si512(_mm512_srli_epi16(v, 4), lowMask));
+  return _mm512_add_epi8(low, high);
+}
+
+inline __m512i squaredDiff(__m512i va, __m512i vb)
+{
+  // squared differences of 16 bits values summed by pairs in 32 bits lanes
+  const __m512i dLow = _mm512_sub_epi16(_mm512_cvtepu8_epi16(_mm512_castsi512_si256(va)),
+                                        _mm512_cvtepu8_epi16(_mm512_castsi512_si256(vb)));
+  const __m512i dHigh = _mm512_sub_epi16(_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(va, 1)),
+                                         _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(vb, 1)));
+  return _mm512_add_epi32(_mm512_madd_epi16(dLow, dLow), _mm512_madd_epi16(dHigh, dHigh));
+}
+
+} // namespace
+
+float l2Float(const float* a, const float* b, std::size_t size)
+{
+  __m512 sum0 = _mm512_setzero_ps();
+  __m512 sum1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    const __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+    sum0 = _mm512_fmadd_ps(d0, d0, sum0);
+    sum1 = _mm512_fmadd_ps(d1, d1, sum1);
+  }
+  for(; i < size; i += 16)
+  {
+    // masked loads for the last values
+    const __mmask16 mask = (size - i >= 16) ? __mmask16(0xFFFF) : __mmask16((1u << (size - i)) - 1);
+    const __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+    sum0 = _mm512_fmadd_ps(d, d, sum0);
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(sum0, sum1));
+}
+
+float l2Uchar(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  // no overflow of the 32 bits lanes below 256k values
+  __m512i sum = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 64 <= size; i += 64)
+  {
+    sum = _mm512_add_epi32(sum, squaredDiff(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i)));
+  }
+  if(i < size)
+  {
+    const __mmask64 mask = tailMask64(size - i);
+    sum = _mm512_add_epi32(sum, squaredDiff(_mm512_maskz_loadu_epi8(mask, a + i), _mm512_maskz_loadu_epi8(mask, b + i)));
+  }
+  return static_cast<float>(static_cast<unsigned int>(_mm512_reduce_add_epi32(sum)));
+}
+
+unsigned int hamming(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m512i sum = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 64 <= size; i += 64)
+  {
+    const __m512i v = _mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+    sum = _mm512_add_epi64(sum, _mm512_sad_epu8(popcountBytes(v), _mm512_setzero_si512()));
+  }
+  if(i < size)
+  {
+    const __mmask64 mask = tailMask64(size - i);
+    const __m512i v = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, a + i), _mm512_maskz_loadu_epi8(mask, b + i));
+    sum = _mm512_add_epi64(sum, _mm512_sad_epu8(popcountBytes(v), _mm512_setzero_si512()));
+  }
+  return static_cast<unsigned int>(_mm512_reduce_add_epi64(sum));
+}
+
+} // namespace avx512
+} // namespace simd
+} // namespace matching
+} // namespace aliceVision
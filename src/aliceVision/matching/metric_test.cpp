@@ -6,8 +6,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/matching/metric.hpp"
+#include "aliceVision/matching/metricSimd.hpp"
 #include <iostream>
+#include <random>
 #include <string>
+#include <vector>
 
 #define BOOST_TEST_MODULE matchingMetric
 #include <boost/test/included/unit_test.hpp>
@@ -133,3 +136,53 @@ BOOST_AUTO_TEST_CASE(Metric_HAMMING_BITSET_RAW_MEMORY_32BITS)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(Metric_SIMD_Kernels)
+{
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> floatDistribution(-1.f, 1.f);
+  std::uniform_int_distribution<int> ucharDistribution(0, 255);
+
+  const simd::DistanceKernels* scalarKernels = simd::getKernels(simd::EInstructionSet::SCALAR);
+  BOOST_REQUIRE(scalarKernels != nullptr);
+
+  for(simd::EInstructionSet instructionSet : {simd::EInstructionSet::AVX2, simd::EInstructionSet::AVX512})
+  {
+    const simd::DistanceKernels* kernels = simd::getKernels(instructionSet);
+    if(kernels == nullptr)
+    {
+      BOOST_TEST_MESSAGE("Instruction set not supported: " << simd::EInstructionSet_enumToString(instructionSet));
+      continue;
+    }
+
+    // all the sizes, including the ones that are not a multiple of the SIMD registers
+    for(std::size_t size = 0; size < 300; ++size)
+    {
+      // unaligned data
+      std::vector<float> a(size + 1), b(size + 1);
+      std::vector<unsigned char> ua(size + 1), ub(size + 1);
+      for(std::size_t i = 0; i < size + 1; ++i)
+      {
+        a[i] = floatDistribution(generator);
+        b[i] = floatDistribution(generator);
+        ua[i] = static_cast<unsigned char>(ucharDistribution(generator));
+        ub[i] = static_cast<unsigned char>(ucharDistribution(generator));
+      }
+
+      const float l2 = scalarKernels->l2Float(&a[1], &b[1], size);
+      BOOST_CHECK_SMALL(kernels->l2Float(&a[1], &b[1], size) - l2, 1e-4f * (1.f + l2));
+      BOOST_CHECK_EQUAL(scalarKernels->l2Uchar(&ua[1], &ub[1], size), kernels->l2Uchar(&ua[1], &ub[1], size));
+      BOOST_CHECK_EQUAL(scalarKernels->hamming(&ua[1], &ub[1], size), kernels->hamming(&ua[1], &ub[1], size));
+    }
+  }
+
+  // dispatched kernels
+  const float a[] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+  const float b[] = {8, 7, 6, 5, 4, 3, 2, 1, 0};
+  BOOST_CHECK_EQUAL(240, L2_Vectorized<float>()(a, b, 9));
+
+  const unsigned char ua[] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+  const unsigned char ub[] = {8, 7, 6, 5, 4, 3, 2, 1, 0};
+  BOOST_CHECK_EQUAL(240, L2_Vectorized<unsigned char>()(ua, ub, 9));
+  BOOST_CHECK_EQUAL(scalarKernels->hamming(ua, ub, 9), Hamming<unsigned char>()(ua, ub, 9));
+}
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <random>
+
 namespace aliceVision {
 
 
@@ -30,10 +33,14 @@ struct GeometricFilterMatrix
 {
   GeometricFilterMatrix(double precision,
                         double precisionRobust,
-                        std::size_t stIteration)
+                        std::size_t stIteration,
+                        std::size_t nbParallelHypotheses,
+                        std::mt19937::result_type randomSeed)
     : m_dPrecision(precision)
     , m_dPrecision_robust(precisionRobust)
     , m_stIteration(stIteration)
+    , m_nbParallelHypotheses(nbParallelHypotheses)
+    , m_randomSeed(randomSeed)
   {}
 
   /**
@@ -58,6 +65,8 @@ struct GeometricFilterMatrix
   double m_dPrecision;  //upper_bound precision used for robust estimation
   double m_dPrecision_robust;
   std::size_t m_stIteration; //maximal number of iteration for robust estimation
+  std::size_t m_nbParallelHypotheses; //number of hypotheses evaluated together by the robust estimation
+  std::mt19937::result_type m_randomSeed; //seed of the samples of each estimation, the result does not depend on the pairs order
 };
 
 
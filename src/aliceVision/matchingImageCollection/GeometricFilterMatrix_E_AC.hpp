@@ -28,8 +28,10 @@ struct GeometricFilterMatrix_E_AC : public GeometricFilterMatrix
 {
   GeometricFilterMatrix_E_AC(
     double dPrecision = std::numeric_limits<double>::infinity(),
-    size_t iteration = 1024)
-    : GeometricFilterMatrix(dPrecision, std::numeric_limits<double>::infinity(), iteration)
+    size_t iteration = 1024,
+    size_t nbParallelHypotheses = 1,
+    std::mt19937::result_type randomSeed = std::mt19937::default_seed)
+    : GeometricFilterMatrix(dPrecision, std::numeric_limits<double>::infinity(), iteration, nbParallelHypotheses, randomSeed)
     , m_E(Mat3::Identity())
   {}
 
@@ -94,7 +96,9 @@ struct GeometricFilterMatrix_E_AC : public GeometricFilterMatrix
     const double upper_bound_precision = Square(m_dPrecision);
 
     std::vector<size_t> inliers;
-    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_E, upper_bound_precision);
+    std::mt19937 randomNumberGenerator(m_randomSeed);
+    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_E, upper_bound_precision,
+                                                          false, m_nbParallelHypotheses, &randomNumberGenerator);
 
     if (inliers.empty())
       return EstimationStatus(false, false);
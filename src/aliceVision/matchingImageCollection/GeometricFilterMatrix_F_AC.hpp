@@ -31,8 +31,10 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
   GeometricFilterMatrix_F_AC(
     double dPrecision = std::numeric_limits<double>::infinity(),
     size_t iteration = 1024,
-    robustEstimation::ERobustEstimator estimator = robustEstimation::ERobustEstimator::ACRANSAC)
-    : GeometricFilterMatrix(dPrecision, std::numeric_limits<double>::infinity(), iteration)
+    robustEstimation::ERobustEstimator estimator = robustEstimation::ERobustEstimator::ACRANSAC,
+    size_t nbParallelHypotheses = 1,
+    std::mt19937::result_type randomSeed = std::mt19937::default_seed)
+    : GeometricFilterMatrix(dPrecision, std::numeric_limits<double>::infinity(), iteration, nbParallelHypotheses, randomSeed)
     , m_F(Mat3::Identity())
     , m_estimator(estimator)
   {}
@@ -171,8 +173,10 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
 
         // Robustly estimate the Fundamental matrix with A Contrario ransac
         const double upper_bound_precision = Square(m_dPrecision);
+        std::mt19937 randomNumberGenerator(m_randomSeed);
         const std::pair<double,double> ACRansacOut =
-          ACRANSAC(kernel, out_inliers, m_stIteration, &m_F, upper_bound_precision);
+          ACRANSAC(kernel, out_inliers, m_stIteration, &m_F, upper_bound_precision,
+                   false, m_nbParallelHypotheses, &randomNumberGenerator);
 
         if(out_inliers.empty())
           return std::make_pair(false, KernelType::MINIMUM_SAMPLES);
@@ -26,8 +26,10 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
 {
   GeometricFilterMatrix_H_AC(
     double dPrecision = std::numeric_limits<double>::infinity(),
-    size_t iteration = 1024)
-    : GeometricFilterMatrix(dPrecision, std::numeric_limits<double>::infinity(), iteration)
+    size_t iteration = 1024,
+    size_t nbParallelHypotheses = 1,
+    std::mt19937::result_type randomSeed = std::mt19937::default_seed)
+    : GeometricFilterMatrix(dPrecision, std::numeric_limits<double>::infinity(), iteration, nbParallelHypotheses, randomSeed)
     , m_H(Mat3::Identity())
   {}
 
@@ -76,7 +78,9 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
     const double upper_bound_precision = Square(m_dPrecision);
 
     std::vector<size_t> inliers;
-    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_H, upper_bound_precision);
+    std::mt19937 randomNumberGenerator(m_randomSeed);
+    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_H, upper_bound_precision,
+                                                          false, m_nbParallelHypotheses, &randomNumberGenerator);
 
     if (inliers.empty())
       return EstimationStatus(false, false);
@@ -0,0 +1,89 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_F_AC.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE geometricFilterMatrix
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matchingImageCollection;
+
+namespace {
+
+/// Correspondences of two views of a ring dataset, with 30% of outliers
+void createCorrespondences(Mat& xI, Mat& xJ)
+{
+  const std::size_t nbPoints = 300;
+  const NViewDataSet d = NRealisticCamerasRing(2, nbPoints, NViewDatasetConfigurator(1000, 1000, 500, 500, 5, 0));
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> position(0.0, 1000.0);
+  std::normal_distribution<double> noise(0.0, 0.5);
+
+  xI = d._x[0];
+  xJ = d._x[1];
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    if(i % 10 < 3)
+    {
+      xJ(0, i) = position(generator);
+      xJ(1, i) = position(generator);
+    }
+    else
+    {
+      xJ(0, i) += noise(generator);
+      xJ(1, i) += noise(generator);
+    }
+  }
+}
+
+} // namespace
+
+// Check that the fundamental matrix filter of featureMatching gives the same model and inliers
+// for a given seed, whatever the number of threads evaluating the hypotheses
+
+BOOST_AUTO_TEST_CASE(GeometricFilterMatrix_F_AC_threads)
+{
+  Mat xI, xJ;
+  createCorrespondences(xI, xJ);
+  const std::pair<std::size_t, std::size_t> imageSize(1000, 1000);
+
+  const int nbThreads = omp_get_max_threads();
+  for(const std::size_t nbParallelHypotheses : {1, 8})
+  {
+    omp_set_num_threads(1);
+    GeometricFilterMatrix_F_AC filterRef(std::numeric_limits<double>::infinity(), 1024,
+                                         robustEstimation::ERobustEstimator::ACRANSAC, nbParallelHypotheses, 42);
+    std::vector<std::size_t> inliersRef;
+    BOOST_CHECK(filterRef.geometricEstimation_Mat(xI, xJ, imageSize, imageSize, inliersRef).first);
+    // the outliers are rejected
+    BOOST_CHECK(inliersRef.size() > 150);
+    BOOST_CHECK(inliersRef.size() <= 210);
+
+    for(const int threads : {1, std::max(4, omp_get_num_procs())})
+    {
+      omp_set_num_threads(threads);
+      for(int run = 0; run < 2; ++run)
+      {
+        GeometricFilterMatrix_F_AC filter(std::numeric_limits<double>::infinity(), 1024,
+                                          robustEstimation::ERobustEstimator::ACRANSAC, nbParallelHypotheses, 42);
+        std::vector<std::size_t> inliers;
+        BOOST_CHECK(filter.geometricEstimation_Mat(xI, xJ, imageSize, imageSize, inliers).first);
+        BOOST_CHECK(inliers == inliersRef);
+        BOOST_CHECK(filter.m_F == filterRef.m_F);
+        BOOST_CHECK_EQUAL(filter.m_dPrecision_robust, filterRef.m_dPrecision_robust);
+      }
+    }
+  }
+  omp_set_num_threads(nbThreads);
+}
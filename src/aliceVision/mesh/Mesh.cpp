@@ -5,6 +5,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Mesh.hpp"
+#include <aliceVision/mesh/meshRasterizer.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
@@ -635,327 +636,35 @@ StaticVector<StaticVector<int>*>* Mesh::getPtsNeighPtsOrdered()
     return out_ptsNeighPts;
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getTrisMap(const mvsUtils::MultiViewParams* mp, int rc, int  /*scale*/, int w, int h)
+StaticVector<int>* Mesh::getTrisMap(const mvsUtils::MultiViewParams* mp, int rc, int w, int h, const StaticVector<int>* visTris) const
 {
-    long tstart = clock();
+    MeshRendering rendering;
+    rasterizeMesh(*this, *mp, rc, w, h, rendering, visTris);
 
-    ALICEVISION_LOG_INFO("getTrisMap.");
-    StaticVector<int>* nmap = new StaticVector<int>();
-    nmap->reserve(w * h);
-    nmap->resize_with(w * h, 0);
-
-    long t1 = mvsUtils::initEstimate();
-    for(int i = 0; i < tris->size(); i++)
-    {
-        triangle_proj tp = getTriangleProjection(i, mp, rc, w, h);
-        if((isTriangleProjectionInImage(tp, w, h)))
-        {
-            Pixel pix;
-            for(pix.x = tp.lu.x; pix.x <= tp.rd.x; pix.x++)
-            {
-                for(pix.y = tp.lu.y; pix.y <= tp.rd.y; pix.y++)
-                {
-                    Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    if(doesTriangleIntersectsRectangle(&tp, &re))
-                    {
-                        (*nmap)[pix.x * h + pix.y] += 1;
-                    }
-                } // for y
-            }     // for x
-        }         // isthere
-        mvsUtils::printfEstimate(i, tris->size(), t1);
-    } // for i ntris
-    mvsUtils::finishEstimate();
-
-    // allocate
-    StaticVector<StaticVector<int>*>* tmp = new StaticVector<StaticVector<int>*>();
-    tmp->reserve(w * h);
-    tmp->resize_with(w * h, nullptr);
-    StaticVector<int>** ptmp = &(*tmp)[0];
-    for(int i = 0; i < w * h; i++)
-    {
-        if((*nmap)[i] > 0)
-        {
-            *ptmp = new StaticVector<int>();
-            (*ptmp)->reserve((*nmap)[i]);
-        }
-        ptmp++;
-    }
-    delete nmap;
-
-    // fill
-    t1 = mvsUtils::initEstimate();
-    for(int i = 0; i < tris->size(); i++)
-    {
-        triangle_proj tp = getTriangleProjection(i, mp, rc, w, h);
-        if((isTriangleProjectionInImage(tp, w, h)))
-        {
-            Pixel pix;
-            for(pix.x = tp.lu.x; pix.x <= tp.rd.x; pix.x++)
-            {
-                for(pix.y = tp.lu.y; pix.y <= tp.rd.y; pix.y++)
-                {
-                    Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    if(doesTriangleIntersectsRectangle(&tp, &re))
-                    {
-                        (*tmp)[pix.x * h + pix.y]->push_back(i);
-                    }
-                } // for y
-            }     // for x
-        }         // isthere
-        mvsUtils::printfEstimate(i, tris->size(), t1);
-    } // for i ntris
-    mvsUtils::finishEstimate();
-
-    mvsUtils::printfElapsedTime(tstart);
-
-    return tmp;
+    StaticVector<int>* trisMap = new StaticVector<int>();
+    trisMap->swap(rendering.trisMap);
+    return trisMap;
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getTrisMap(StaticVector<int>* visTris, const mvsUtils::MultiViewParams* mp, int rc,
-                                                      int  /*scale*/, int w, int h)
+void Mesh::getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int w, int h) const
 {
-    long tstart = clock();
-
-    ALICEVISION_LOG_INFO("getTrisMap.");
-    StaticVector<int>* nmap = new StaticVector<int>();
-    nmap->reserve(w * h);
-    nmap->resize_with(w * h, 0);
-
-    long t1 = mvsUtils::initEstimate();
-    for(int m = 0; m < visTris->size(); m++)
-    {
-        int i = (*visTris)[m];
-        triangle_proj tp = getTriangleProjection(i, mp, rc, w, h);
-        if((isTriangleProjectionInImage(tp, w, h)))
-        {
-            Pixel pix;
-            for(pix.x = tp.lu.x; pix.x <= tp.rd.x; pix.x++)
-            {
-                for(pix.y = tp.lu.y; pix.y <= tp.rd.y; pix.y++)
-                {
-                    Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    if(doesTriangleIntersectsRectangle(&tp, &re))
-                    {
-                        (*nmap)[pix.x * h + pix.y] += 1;
-                    }
-                } // for y
-            }     // for x
-        }         // isthere
-        mvsUtils::printfEstimate(i, tris->size(), t1);
-    } // for i ntris
-    mvsUtils::finishEstimate();
-
-    // allocate
-    StaticVector<StaticVector<int>*>* tmp = new StaticVector<StaticVector<int>*>();
-    tmp->reserve(w * h);
-    tmp->resize_with(w * h, nullptr);
-    StaticVector<int>** ptmp = &(*tmp)[0];
-    for(int i = 0; i < w * h; i++)
-    {
-        if((*nmap)[i] > 0)
-        {
-            *ptmp = new StaticVector<int>();
-            (*ptmp)->reserve((*nmap)[i]);
-        }
-        ptmp++;
-    }
-    delete nmap;
-
-    // fill
-    t1 = mvsUtils::initEstimate();
-    for(int m = 0; m < visTris->size(); m++)
-    {
-        int i = (*visTris)[m];
-        triangle_proj tp = getTriangleProjection(i, mp, rc, w, h);
-        if((isTriangleProjectionInImage(tp, w, h)))
-        {
-            Pixel pix;
-            for(pix.x = tp.lu.x; pix.x <= tp.rd.x; pix.x++)
-            {
-                for(pix.y = tp.lu.y; pix.y <= tp.rd.y; pix.y++)
-                {
-                    Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    if(doesTriangleIntersectsRectangle(&tp, &re))
-                    {
-                        (*tmp)[pix.x * h + pix.y]->push_back(i);
-                    }
-                } // for y
-            }     // for x
-        }         // isthere
-        mvsUtils::printfEstimate(i, tris->size(), t1);
-    } // for i ntris
-    mvsUtils::finishEstimate();
-
-    mvsUtils::printfElapsedTime(tstart);
-
-    return tmp;
+    MeshRendering rendering;
+    rasterizeMesh(*this, *mp, rc, w, h, rendering);
+    depthMap->swap(rendering.depthMap);
 }
 
-void Mesh::getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h)
+StaticVector<int>* Mesh::getVisibleTrianglesIndexes(const mvsUtils::MultiViewParams* mp, int rc, int w, int h) const
 {
-    StaticVector<StaticVector<int>*>* tmp = getTrisMap(mp, rc, scale, w, h);
-    getDepthMap(depthMap, tmp, mp, rc, scale, w, h);
-    deleteArrayOfArrays<int>(&tmp);
-}
+    MeshRendering rendering;
+    rasterizeMesh(*this, *mp, rc, w, h, rendering);
 
-void Mesh::getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<int>*>* tmp, const mvsUtils::MultiViewParams* mp,
-                          int rc, int scale, int w, int h)
-{
-    depthMap->resize_with(w * h, -1.0f);
-
-    Pixel pix;
-    for(pix.x = 0; pix.x < w; pix.x++)
+    StaticVector<int>* out = new StaticVector<int>();
+    for(int i = 0; i < rendering.visibility.size(); i++)
     {
-        for(pix.y = 0; pix.y < h; pix.y++)
-        {
-
-            StaticVector<int>* ti = (*tmp)[pix.x * h + pix.y];
-            if((ti != nullptr) && (ti->size() > 0))
-            {
-                Point2d p;
-                p.x = (double)pix.x;
-                p.y = (double)pix.y;
-
-                double mindepth = 10000000.0;
-
-                for(int i = 0; i < ti->size(); i++)
-                {
-                    int idTri = (*ti)[i];
-                    OrientedPoint tri;
-                    tri.p = (*pts)[(*tris)[idTri].v[0]];
-                    tri.n = cross(((*pts)[(*tris)[idTri].v[1]] - (*pts)[(*tris)[idTri].v[0]]).normalize(),
-                                  ((*pts)[(*tris)[idTri].v[2]] - (*pts)[(*tris)[idTri].v[0]]).normalize());
-
-                    Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    triangle_proj tp = getTriangleProjection(idTri, mp, rc, w, h);
-
-                    /*
-                    if ((pix.x==66)&&(pix.y==117))
-                    {
-                            printf("plot([%f %f],[%f %f],'r-');\n",
-                                    tp.tp2ds[0].x,tp.tp2ds[1].x,tp.tp2ds[0].y,tp.tp2ds[1].y);
-                            printf("plot([%f %f],[%f %f],'r-');\n",
-                                    tp.tp2ds[1].x,tp.tp2ds[2].x,tp.tp2ds[1].y,tp.tp2ds[2].y);
-                            printf("plot([%f %f],[%f %f],'r-');\n",
-                                    tp.tp2ds[2].x,tp.tp2ds[0].x,tp.tp2ds[2].y,tp.tp2ds[0].y);
-                    };
-
-
-                    if ((pix.x==67)&&(pix.y==118))
-                    {
-                            printf("%f\n", angleBetwV1andV2((mp->CArr[rc]-tri.p).normalize(),tri.n));
-                    }
-                    */
-
-                    StaticVector<Point2d>* tpis = getTrianglePixelIntersectionsAndInternalPoints(&tp, &re);
-
-                    double maxd = -1.0;
-                    for(int k = 0; k < tpis->size(); k++)
-                    {
-                        Point3d lpi = linePlaneIntersect(
-                            mp->CArr[rc], (mp->iCamArr[rc] * ((*tpis)[k] * (float)scale)).normalize(), tri.p, tri.n);
-                        if(!std::isnan(angleBetwV1andV2((mp->CArr[rc] - tri.p).normalize(), tri.n)))
-                        {
-                            maxd = std::max(maxd, (mp->CArr[rc] - lpi).size());
-                        }
-                        else
-                        {
-                            /*
-                            printf("A %f %f %f\n", (*pts)[(*tris)[idTri].i[0]].x, (*pts)[(*tris)[idTri].i[0]].y,
-                            (*pts)[(*tris)[idTri].i[0]].z);
-                            printf("B %f %f %f\n", (*pts)[(*tris)[idTri].i[1]].x, (*pts)[(*tris)[idTri].i[1]].y,
-                            (*pts)[(*tris)[idTri].i[1]].z);
-                            printf("C %f %f %f\n", (*pts)[(*tris)[idTri].i[2]].x, (*pts)[(*tris)[idTri].i[2]].y,
-                            (*pts)[(*tris)[idTri].i[2]].z);
-                            printf("n %f %f %f\n", tri.n.x, tri.n.y, tri.n.z);
-                            printf("ids %i %i %i\n", (*tris)[idTri].i[0], (*tris)[idTri].i[1], (*tris)[idTri].i[2]);
-                            */
-
-                            maxd = std::max(maxd, (mp->CArr[rc] - (*pts)[(*tris)[idTri].v[1]]).size());
-
-                            /*
-                            StaticVector<Point3d> *tpis1 = getTrianglePixelIntersectionsAndInternalPoints(mp, idTri,
-                            pix, rc, &tp, &re);
-
-                            float maxd = -1.0;
-                            for (int k=0;k<tpis1->size();k++) {
-                                    maxd = std::max(maxd,(mp->CArr[rc]-(*tpis1)[k]).size());
-                            };
-
-                            delete tpis1;
-                            */
-                        }
-                        //};
-                    }
-                    mindepth = std::min(mindepth, maxd);
-
-                    delete tpis;
-                }
-
-                /*
-                //for (int idTri=0;idTri<tris->size();idTri++)
-                for (int i=0;i<ti->size();i++)
-                {
-                        int idTri = (*ti)[i];
-                        orientedPoint tri;
-                        tri.p = (*pts)[(*tris)[idTri].i[0]];
-                        tri.n = cross( ((*pts)[(*tris)[idTri].i[1]]-(*pts)[(*tris)[idTri].i[0]]).normalize(),
-                                                   ((*pts)[(*tris)[idTri].i[2]]-(*pts)[(*tris)[idTri].i[0]]).normalize()
-                );
-                        Point3d lpi =
-                linePlaneIntersect(mp->CArr[rc],(mp->iCamArr[rc]*Point2d(p.x,p.y)).normalize(),tri.p,tri.n);
-                        if ((mp->is3DPointInFrontOfCam(&lpi,rc)==true)&&
-                                (isLineInTriangle(
-                                        &(*pts)[(*tris)[idTri].i[0]],
-                                        &(*pts)[(*tris)[idTri].i[1]],
-                                        &(*pts)[(*tris)[idTri].i[2]],
-                                        &mp->CArr[rc],
-                                        &(mp->iCamArr[rc]*Point2d(p.x,p.y)).normalize())==true))
-                        {
-                                mindepth=std::min(mindepth,(mp->CArr[rc]-lpi).size());
-                        };
-                };
-                */
-
-                (*depthMap)[pix.x * h + pix.y] = mindepth;
-            }
-            else
-            {
-                (*depthMap)[pix.x * h + pix.y] = -1.0f;
-            }
-        } // for pix.y
-    }     // for pix.x
-}
-
-StaticVector<int>* Mesh::getVisibleTrianglesIndexes(std::string depthMapFileName, std::string trisMapFileName,
-                                                       const mvsUtils::MultiViewParams* mp, int rc, int w, int h)
-{
-    StaticVector<float>* depthMap = loadArrayFromFile<float>(depthMapFileName);
-    StaticVector<StaticVector<int>*>* trisMap = loadArrayOfArraysFromFile<int>(trisMapFileName);
-
-    StaticVector<int>* vistri = getVisibleTrianglesIndexes(trisMap, depthMap, mp, rc, w, h);
-
-    deleteArrayOfArrays<int>(&trisMap);
-    delete depthMap;
-
-    return vistri;
-}
-
-StaticVector<int>* Mesh::getVisibleTrianglesIndexes(std::string tmpDir, const mvsUtils::MultiViewParams* mp, int rc, int w, int h)
-{
-    std::string depthMapFileName = tmpDir + "depthMap" + std::to_string(mp->getViewId(rc)) + ".bin";
-    std::string trisMapFileName = tmpDir + "trisMap" + std::to_string(mp->getViewId(rc)) + ".bin";
-
-    StaticVector<float>* depthMap = loadArrayFromFile<float>(depthMapFileName);
-    StaticVector<StaticVector<int>*>* trisMap = loadArrayOfArraysFromFile<int>(trisMapFileName);
-
-    StaticVector<int>* vistri = getVisibleTrianglesIndexes(trisMap, depthMap, mp, rc, w, h);
-
-    deleteArrayOfArrays<int>(&trisMap);
-    delete depthMap;
-
-    return vistri;
+        if(rendering.visibility[i])
+            out->push_back(i);
+    }
+    return out;
 }
 
 StaticVector<int>* Mesh::getVisibleTrianglesIndexes(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc,
@@ -988,103 +697,6 @@ StaticVector<int>* Mesh::getVisibleTrianglesIndexes(StaticVector<float>* depthMa
     return out;
 }
 
-StaticVector<int>* Mesh::getVisibleTrianglesIndexes(StaticVector<StaticVector<int>*>* trisMap,
-                                                       StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc,
-                                                       int w, int h)
-{
-    int ow = mp->getWidth(rc);
-    int oh = mp->getHeight(rc);
-
-    StaticVectorBool* btris = new StaticVectorBool();
-    btris->reserve(tris->size());
-    btris->resize_with(tris->size(), false);
-
-    Pixel pix;
-    for(pix.x = 0; pix.x < w; pix.x++)
-    {
-        for(pix.y = 0; pix.y < h; pix.y++)
-        {
-
-            StaticVector<int>* ti = (*trisMap)[pix.x * h + pix.y];
-            if(ti != nullptr)
-            {
-                Point2d p;
-                p.x = (float)pix.x;
-                p.y = (float)pix.y;
-
-                float depth = (*depthMap)[pix.x * h + pix.y];
-                for(int i = 0; i < ti->size(); i++)
-                {
-                    int idTri = (*ti)[i];
-                    OrientedPoint tri;
-                    tri.p = (*pts)[(*tris)[idTri].v[0]];
-                    tri.n = cross(((*pts)[(*tris)[idTri].v[1]] - (*pts)[(*tris)[idTri].v[0]]).normalize(),
-                                  ((*pts)[(*tris)[idTri].v[2]] - (*pts)[(*tris)[idTri].v[0]]).normalize());
-
-                    Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    triangle_proj tp = getTriangleProjection(idTri, mp, rc, w, h);
-
-                    /*
-                    StaticVector<Point2d> *tpis = getTrianglePixelIntersectionsAndInternalPoints(&tp, &re);
-                    float mindepth = 10000000.0f;
-                    Point3d minlpi;
-                    for (int k=0;k<tpis->size();k++) {
-                            Point3d lpi =
-                    linePlaneIntersect(mp->CArr[rc],(mp->iCamArr[rc]*((*tpis)[k]*(float)scale)).normalize(),tri.p,tri.n);
-                            if (mindepth>(mp->CArr[rc]-lpi).size()) {
-                                    mindepth = (mp->CArr[rc]-lpi).size();
-                                    minlpi = lpi;
-                            };
-                    };
-                    float pixSize = mp->getCamPixelSize(minlpi,rc) * 2.0f;
-                    if (fabs(depth-mindepth)<pixSize) {
-                            (*btris)[idTri] = true;
-                    };
-                    delete tpis;
-                    */
-
-                    Point2d tpip = getTrianglePixelInternalPoint(&tp, &re);
-                    tpip.x = (tpip.x / (float)w) * (float)ow;
-                    tpip.y = (tpip.y / (float)h) * (float)oh;
-
-                    Point3d lpi = linePlaneIntersect(mp->CArr[rc], (mp->iCamArr[rc] * tpip).normalize(), tri.p, tri.n);
-                    float lpidepth = (mp->CArr[rc] - lpi).size();
-                    float pixSize = mp->getCamPixelSize(lpi, rc) * 2.0f;
-                    if(fabs(depth - lpidepth) < pixSize)
-                    {
-                        (*btris)[idTri] = true;
-                    }
-                }
-            }
-        } // for pix.y
-    }     // for pix.x
-
-    int nvistris = 0;
-    for(int i = 0; i < btris->size(); i++)
-    {
-        if((*btris)[i])
-        {
-            nvistris++;
-        }
-    }
-
-    StaticVector<int>* out = new StaticVector<int>();
-    out->reserve(nvistris);
-
-    for(int i = 0; i < btris->size(); i++)
-    {
-        if((*btris)[i])
-        {
-            out->push_back(i);
-        }
-    }
-
-    // deallocate
-    delete btris;
-
-    return out;
-}
-
 Mesh* Mesh::generateMeshFromTrianglesSubset(const StaticVector<int>& visTris, StaticVector<int>** out_ptIdToNewPtId) const
 {
     Mesh* outMesh = new Mesh();
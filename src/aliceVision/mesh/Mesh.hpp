@@ -120,22 +120,18 @@ public:
 
     void addMesh(Mesh* me);
 
-    StaticVector<StaticVector<int>*>* getTrisMap(const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h);
-    StaticVector<StaticVector<int>*>* getTrisMap(StaticVector<int>* visTris, const mvsUtils::MultiViewParams* mp, int rc, int scale,
-                                                 int w, int h);
-    void getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h);
-    void getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<int>*>* tmp, const mvsUtils::MultiViewParams* mp, int rc,
-                     int scale, int w, int h);
+    /// Nearest triangle at each pixel center of the camera rc rendered at w x h (index x * h + y), -1 if none
+    /// @see rasterizeMesh
+    StaticVector<int>* getTrisMap(const mvsUtils::MultiViewParams* mp, int rc, int w, int h,
+                                  const StaticVector<int>* visTris = nullptr) const;
+    /// Distance to the nearest surface at each pixel center of the camera rc rendered at w x h, -1 if none
+    void getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int w, int h) const;
 
     StaticVector<StaticVector<int>*>* getPtsNeighborTriangles();
     StaticVector<StaticVector<int>*>* getPtsNeighPtsOrdered();
 
-    StaticVector<int>* getVisibleTrianglesIndexes(std::string tmpDir, const mvsUtils::MultiViewParams* mp, int rc, int w, int h);
-    StaticVector<int>* getVisibleTrianglesIndexes(std::string depthMapFileName, std::string trisMapFileName,
-                                                  const mvsUtils::MultiViewParams* mp, int rc, int w, int h);
-    StaticVector<int>* getVisibleTrianglesIndexes(StaticVector<StaticVector<int>*>* trisMap,
-                                                  StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int w,
-                                                  int h);
+    /// Triangles nearest to the camera rc in at least one pixel center of the rendering at w x h
+    StaticVector<int>* getVisibleTrianglesIndexes(const mvsUtils::MultiViewParams* mp, int rc, int w, int h) const;
     StaticVector<int>* getVisibleTrianglesIndexes(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int w,
                                                   int h);
 
@@ -6,20 +6,22 @@
 
 #include "Texturing.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/mvsData/Color.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/imageIO/image.hpp>
 #include <aliceVision/mesh/UVAtlas.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <geogram/basic/geometry_nd.h>
 #include <geogram/mesh/mesh.h>
 #include <geogram/mesh/mesh_io.h>
 #include <geogram/parameterization/mesh_atlas_maker.h>
 
+#include <algorithm>
 #include <map>
-#include <set>
 
 namespace aliceVision {
 namespace mesh {
@@ -49,14 +51,6 @@ std::string EUnwrapMethod_enumToString(EUnwrapMethod method)
     throw std::out_of_range("Unrecognized EUnwrapMethod");
 }
 
-/**
- * @brief Return whether a pixel is contained in or intersected by a 2D triangle.
- * @param[in] triangle the triangle as an array of 3 point2Ds
- * @param[in] pixel the pixel to test
- * @param[out] barycentricCoords the barycentric
- *  coordinates of this pixel relative to \p triangle
- * @return
- */
 bool isPixelInTriangle(const Point2d* triangle, const Pixel& pixel, Point2d& barycentricCoords)
 {
     // get pixel center
@@ -231,15 +225,6 @@ void Texturing::generateUVs(mvsUtils::MultiViewParams& mp)
     deleteArrayOfArrays<int>(&updatedPointsCams);
 }
 
-void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
-                                 const boost::filesystem::path &outPath, EImageFileType textureFileType)
-{
-    mvsUtils::ImagesCache imageCache(&mp, 0, false);
-    for(size_t atlasID = 0; atlasID < _atlases.size(); ++atlasID)
-        generateTexture(mp, atlasID, imageCache, outPath, textureFileType);
-}
-
-
 /// accumulates colors and keeps count for providing average
 struct AccuColor {
     Color colorSum;
@@ -267,120 +252,20 @@ struct AccuColor {
     }
 };
 
+/// number of texture rows rasterized by a thread at once
+const int rasterBandHeight = 64;
 
-void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
-                                size_t atlasID, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
+/**
+ * @brief Fill the gutter of an atlas, compute the average colors, and write the texture file.
+ * @param[in] texParams the texturing parameters
+ * @param[in,out] perPixelColors the accumulated colors, released
+ * @param[in,out] colorIDs the pixel whose color is used for each pixel of the texture (-1 if none), released
+ * @param[in] texturePath the output texture file
+ */
+void writeTexture(const TexturingParams& texParams, std::vector<AccuColor>& perPixelColors, std::vector<int>& colorIDs,
+                  const bfs::path& texturePath)
 {
-    if(atlasID >= _atlases.size())
-        throw std::runtime_error("Invalid atlas ID " + std::to_string(atlasID));
-
-    unsigned int textureSize = texParams.textureSide * texParams.textureSide;
-    std::vector<int> colorIDs(textureSize, -1);
-
-    std::vector<std::vector<unsigned int>> camTriangles(mp.ncams);
-
-    ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasID + 1 << "/" << _atlases.size()
-              << " (" << _atlases[atlasID].size() << " triangles).");
-
-    // iterate over atlas' triangles
-    for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
-    {
-        int triangleId = _atlases[atlasID][i];
-
-        std::set<int> triCams;
-        // retrieve triangle visibilities (set of triangle's points visibilities)
-        for(int k = 0; k < 3; k++)
-        {
-            const int pointIndex = (*me->tris)[triangleId].v[k];
-            const StaticVector<int>* pointVisibilities = (*pointsVisibilities)[pointIndex];
-            if(pointVisibilities != nullptr)
-            {
-                std::copy(pointVisibilities->begin(), pointVisibilities->end(), std::inserter(triCams, triCams.end()));
-            }
-        }
-        // register this triangle in cameras seeing it
-        for(int camId : triCams)
-            camTriangles[camId].push_back(triangleId);
-    }
-
-    ALICEVISION_LOG_INFO("Reading pixel color.");
-
-    std::vector<AccuColor> perPixelColors(textureSize);
-
-    // iterate over triangles for each camera
-    int camId = 0;
-    for(const std::vector<unsigned int>& triangles : camTriangles)
-    {
-        ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams << " (" << triangles.size() << " triangles)");
-
-        for(const auto& triangleId : triangles)
-        {
-            // retrieve triangle 3D and UV coordinates
-            Point2d triPixs[3];
-            Point3d triPts[3];
-
-            for(int k = 0; k < 3; k++)
-            {
-                const int pointIndex = (*me->tris)[triangleId].v[k];
-                triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
-                const int uvPointIndex = trisUvIds[triangleId].m[k];
-                triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
-            }
-
-            // compute triangle bounding box in pixel indexes
-            // min values: floor(value)
-            // max values: ceil(value)
-            Pixel LU, RD;
-            LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-            RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-
-            // sanity check: clamp values to [0; textureSide]
-            int texSide = static_cast<int>(texParams.textureSide);
-            LU.x = clamp(LU.x, 0, texSide);
-            LU.y = clamp(LU.y, 0, texSide);
-            RD.x = clamp(RD.x, 0, texSide);
-            RD.y = clamp(RD.y, 0, texSide);
-
-            // iterate over bounding box's pixels
-            for(int y = LU.y; y < RD.y; y++)
-            {
-                for(int x = LU.x; x < RD.x; x++)
-                {
-                    Pixel pix(x, y); // top-left corner of the pixel
-                    Point2d barycCoords;
-
-                    // test if the pixel is inside triangle
-                    // and retrieve its barycentric coordinates
-                    if(!isPixelInTriangle(triPixs, pix, barycCoords))
-                    {
-                        continue;
-                    }
-
-                    // remap 'y' to image coordinates system (inverted Y axis)
-                    const unsigned int y_ = (texParams.textureSide - 1) - y;
-                    // 1D pixel index
-                    unsigned int xyoffset = y_ * texParams.textureSide + x;
-                    // get 3D coordinates
-                    Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
-                    // get 2D coordinates in source image
-                    Point2d pixRC;
-                    mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
-                    // exclude out of bounds pixels
-                    if(!mp.isPixelInImage(pixRC, camId))
-                        continue;
-                    // fill the colorID map
-                    colorIDs[xyoffset] = xyoffset;
-                    // fill the accumulated color map for this pixel
-                    perPixelColors[xyoffset] += imageCache.getPixelValueInterpolated(&pixRC, camId);
-                }
-            }
-        }
-        // increment current cam index
-        camId++;
-    }
-    camTriangles.clear();
+    const unsigned int textureSize = texParams.textureSide * texParams.textureSide;
 
     if(!texParams.fillHoles && texParams.padding > 0)
     {
@@ -430,7 +315,8 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
     if(texParams.fillHoles)
         alphaBuffer.resize(colorBuffer.size(), 0.0f);
 
-    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    #pragma omp parallel for
+    for(int yp = 0; yp < static_cast<int>(texParams.textureSide); ++yp)
     {
         unsigned int yoffset = yp * texParams.textureSide;
         for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
@@ -448,11 +334,10 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
         }
     }
 
-    perPixelColors.clear();
-    colorIDs.clear();
+    // release the accumulation buffers before the post-processing
+    std::vector<AccuColor>().swap(perPixelColors);
+    std::vector<int>().swap(colorIDs);
 
-    std::string textureName = "texture_" + std::to_string(atlasID) + "." + EImageFileType_enumToString(textureFileType);
-    bfs::path texturePath = outPath / textureName;
     ALICEVISION_LOG_INFO("Writing texture file: " << texturePath.string());
 
     unsigned int outTextureSide = texParams.textureSide;
@@ -477,6 +362,235 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
     imageIO::writeImage(texturePath.string(), outTextureSide, outTextureSide, colorBuffer);
 }
 
+void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
+                                 const boost::filesystem::path &outPath, EImageFileType textureFileType)
+{
+    mvsUtils::ImagesCache imageCache(&mp, 0, false);
+
+    // peak memory of an atlas: accumulated colors and color ids, then color and alpha buffers
+    const std::size_t textureSize = std::size_t(texParams.textureSide) * texParams.textureSide;
+    const std::size_t atlasMemory = textureSize * (sizeof(AccuColor) + sizeof(int) + sizeof(Color) + sizeof(float));
+
+    // the atlases are textured by batches fitting in the available memory,
+    // each image is read once per batch
+    const system::MemoryInfo memInfo = system::getMemoryInfo();
+    const std::size_t memoryBudget = 0.9 * memInfo.freeRam;
+    const std::size_t atlasesMemoryBudget = (memoryBudget > imageCache.getMaxMemory()) ? memoryBudget - imageCache.getMaxMemory() : 0;
+    const std::size_t nbAtlasesPerBatch = std::max(std::size_t(1), std::min(_atlases.size(), atlasesMemoryBudget / atlasMemory));
+
+    ALICEVISION_LOG_INFO("Texturing " << _atlases.size() << " atlases by batches of " << nbAtlasesPerBatch << " atlases.");
+    if(memInfo.freeRam == 0)
+        ALICEVISION_LOG_WARNING("Can't find available system memory, the atlases are textured one at a time.");
+
+    for(size_t firstAtlasID = 0; firstAtlasID < _atlases.size(); firstAtlasID += nbAtlasesPerBatch)
+    {
+        std::vector<size_t> atlasIDs;
+        for(size_t atlasID = firstAtlasID; atlasID < std::min(_atlases.size(), firstAtlasID + nbAtlasesPerBatch); ++atlasID)
+            atlasIDs.push_back(atlasID);
+        generateTextures(mp, atlasIDs, imageCache, outPath, textureFileType);
+    }
+}
+
+void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
+                                size_t atlasID, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
+{
+    generateTextures(mp, std::vector<size_t>(1, atlasID), imageCache, outPath, textureFileType);
+}
+
+void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp,
+                                 const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache,
+                                 const bfs::path& outPath, EImageFileType textureFileType)
+{
+    for(size_t atlasID : atlasIDs)
+    {
+        if(atlasID >= _atlases.size())
+            throw std::runtime_error("Invalid atlas ID " + std::to_string(atlasID));
+    }
+
+    const int nbAtlases = static_cast<int>(atlasIDs.size());
+    const int texSide = static_cast<int>(texParams.textureSide);
+    const unsigned int textureSize = texParams.textureSide * texParams.textureSide;
+    const int nbBands = (texSide + rasterBandHeight - 1) / rasterBandHeight;
+
+    // triangles of each atlas seen by each camera
+    std::vector<std::vector<std::vector<unsigned int>>> camTriangles(nbAtlases);
+
+    #pragma omp parallel for
+    for(int a = 0; a < nbAtlases; ++a)
+    {
+        const std::vector<int>& atlas = _atlases[atlasIDs[a]];
+        std::vector<std::vector<unsigned int>>& atlasCamTriangles = camTriangles[a];
+        atlasCamTriangles.resize(mp.ncams);
+
+        ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasIDs[a] + 1 << "/" << _atlases.size()
+                  << " (" << atlas.size() << " triangles).");
+
+        std::vector<int> triCams;
+        // iterate over atlas' triangles
+        for(int triangleId : atlas)
+        {
+            triCams.clear();
+            // retrieve triangle visibilities (set of triangle's points visibilities)
+            for(int k = 0; k < 3; k++)
+            {
+                const int pointIndex = (*me->tris)[triangleId].v[k];
+                const StaticVector<int>* pointVisibilities = (*pointsVisibilities)[pointIndex];
+                if(pointVisibilities != nullptr)
+                    triCams.insert(triCams.end(), pointVisibilities->begin(), pointVisibilities->end());
+            }
+            std::sort(triCams.begin(), triCams.end());
+            triCams.erase(std::unique(triCams.begin(), triCams.end()), triCams.end());
+
+            // register this triangle in cameras seeing it
+            for(int camId : triCams)
+                atlasCamTriangles[camId].push_back(triangleId);
+        }
+    }
+
+    ALICEVISION_LOG_INFO("Reading pixel color.");
+
+    std::vector<std::vector<AccuColor>> perPixelColors(nbAtlases);
+    std::vector<std::vector<int>> colorIDs(nbAtlases);
+    for(int a = 0; a < nbAtlases; ++a)
+    {
+        perPixelColors[a].resize(textureSize);
+        colorIDs[a].resize(textureSize, -1);
+    }
+
+    const auto nbCamTriangles = [&](int camId) {
+        std::size_t nbTriangles = 0;
+        for(int a = 0; a < nbAtlases; ++a)
+            nbTriangles += camTriangles[a][camId].size();
+        return nbTriangles;
+    };
+    const auto prefetchNextCam = [&](int camId) {
+        while(camId < mp.ncams && nbCamTriangles(camId) == 0)
+            ++camId;
+        if(camId < mp.ncams)
+            imageCache.prefetch(camId);
+    };
+
+    // triangles of the current camera overlapping each band of rows of each atlas
+    std::vector<std::vector<unsigned int>> bandTriangles(nbAtlases * nbBands);
+
+    // load the image of the first camera seeing triangles in the background
+    prefetchNextCam(0);
+
+    // iterate over the cameras: each image is read once for all the atlases,
+    // the atlases and bands of rows are filled in parallel
+    for(int camId = 0; camId < mp.ncams; ++camId)
+    {
+        const std::size_t nbTriangles = nbCamTriangles(camId);
+        ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams << " (" << nbTriangles << " triangles)");
+
+        if(nbTriangles == 0)
+            continue;
+
+        // the image of the next camera is loaded during the processing of this one
+        prefetchNextCam(camId + 1);
+
+        const mvsUtils::ImagesCache::ImgSharedPtr img = imageCache.getImg(camId);
+
+        for(std::vector<unsigned int>& triangles : bandTriangles)
+            triangles.clear();
+
+        for(int a = 0; a < nbAtlases; ++a)
+        {
+            for(unsigned int triangleId : camTriangles[a][camId])
+            {
+                int minY = texSide;
+                int maxY = 0;
+                for(int k = 0; k < 3; k++)
+                {
+                    const double y = uvCoords[trisUvIds[triangleId].m[k]].y * texParams.textureSide;
+                    minY = std::min(minY, static_cast<int>(std::floor(y)));
+                    maxY = std::max(maxY, static_cast<int>(std::ceil(y)));
+                }
+                minY = clamp(minY, 0, texSide);
+                maxY = clamp(maxY, 0, texSide);
+                for(int band = minY / rasterBandHeight; band * rasterBandHeight < maxY; ++band)
+                    bandTriangles[a * nbBands + band].push_back(triangleId);
+            }
+        }
+
+        #pragma omp parallel
+        {
+            std::vector<double> rowBuffer;
+
+            #pragma omp for schedule(dynamic)
+            for(int i = 0; i < nbAtlases * nbBands; ++i)
+            {
+                const int a = i / nbBands;
+                const int bandBegin = (i % nbBands) * rasterBandHeight;
+                const int bandEnd = std::min(texSide, bandBegin + rasterBandHeight);
+                std::vector<AccuColor>& atlasColors = perPixelColors[a];
+                std::vector<int>& atlasColorIDs = colorIDs[a];
+
+                // the triangles are kept in the same order for each pixel
+                for(unsigned int triangleId : bandTriangles[i])
+                {
+                    // retrieve triangle 3D and UV coordinates
+                    Point2d triPixs[3];
+                    Point3d triPts[3];
+
+                    for(int k = 0; k < 3; k++)
+                    {
+                        const int pointIndex = (*me->tris)[triangleId].v[k];
+                        triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
+                        const int uvPointIndex = trisUvIds[triangleId].m[k];
+                        triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
+                    }
+
+                    // compute triangle bounding box in pixel indexes
+                    // min values: floor(value)
+                    // max values: ceil(value)
+                    Pixel LU, RD;
+                    LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+                    LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+                    RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+                    RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+
+                    // sanity check: clamp values to [0; textureSide]
+                    LU.x = clamp(LU.x, 0, texSide);
+                    LU.y = clamp(LU.y, 0, texSide);
+                    RD.x = clamp(RD.x, 0, texSide);
+                    RD.y = clamp(RD.y, 0, texSide);
+
+                    // iterate over bounding box's pixels in this band
+                    rasterizeTriangle(triPixs, LU.x, RD.x, std::max(LU.y, bandBegin), std::min(RD.y, bandEnd), rowBuffer,
+                                      [&](int x, int y, const Point2d& barycCoords)
+                    {
+                        // remap 'y' to image coordinates system (inverted Y axis)
+                        const unsigned int y_ = (texParams.textureSide - 1) - y;
+                        // 1D pixel index
+                        unsigned int xyoffset = y_ * texParams.textureSide + x;
+                        // get 3D coordinates
+                        Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
+                        // get 2D coordinates in source image
+                        Point2d pixRC;
+                        mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
+                        // exclude out of bounds pixels
+                        if(!mp.isPixelInImage(pixRC, camId))
+                            return;
+                        // fill the colorID map
+                        atlasColorIDs[xyoffset] = xyoffset;
+                        // fill the accumulated color map for this pixel
+                        atlasColors[xyoffset] += img->getInterpolateColor(pixRC);
+                    });
+                }
+            }
+        }
+    }
+    camTriangles.clear();
+
+    // the textures of the batch are written in parallel
+    #pragma omp parallel for schedule(dynamic)
+    for(int a = 0; a < nbAtlases; ++a)
+    {
+        const std::string textureName = "texture_" + std::to_string(atlasIDs[a]) + "." + EImageFileType_enumToString(textureFileType);
+        writeTexture(texParams, perPixelColors[a], colorIDs[a], outPath / textureName);
+    }
+}
 
 void Texturing::clear()
 {
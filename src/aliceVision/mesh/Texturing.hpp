@@ -7,6 +7,7 @@
 #pragma once
 
 #include <aliceVision/mvsData/image.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
@@ -17,6 +18,9 @@
 
 #include <boost/filesystem.hpp>
 
+#include <cmath>
+#include <vector>
+
 namespace bfs = boost::filesystem;
 
 namespace aliceVision {
@@ -45,6 +49,105 @@ EUnwrapMethod EUnwrapMethod_stringToEnum(const std::string& method);
  */
 std::string EUnwrapMethod_enumToString(EUnwrapMethod method);
 
+/**
+ * @brief Return whether a pixel is contained in or intersected by a 2D triangle.
+ * @param[in] triangle the triangle as an array of 3 point2Ds
+ * @param[in] pixel the pixel to test
+ * @param[out] barycentricCoords the barycentric
+ *  coordinates of this pixel relative to \p triangle
+ * @return
+ */
+bool isPixelInTriangle(const Point2d* triangle, const Pixel& pixel, Point2d& barycentricCoords);
+
+/**
+ * @brief Rasterize a 2D triangle in a range of rows and columns.
+ *
+ * The rasterized pixels are the ones accepted by isPixelInTriangle.
+ * The barycentric coordinates of a row are computed with the edge functions in
+ * vectorizable loops. The exact distance to the triangle is only computed for the
+ * pixels outside of the triangle but close to its edges.
+ *
+ * @param[in] triangle the triangle as an array of 3 point2Ds
+ * @param[in] xBegin, xEnd, yBegin, yEnd the pixels to test
+ * @param[in,out] rowBuffer buffer of the barycentric coordinates of a row
+ * @param[in] f the function called with each pixel and its barycentric coordinates
+ */
+template<typename PixelFunction>
+void rasterizeTriangle(const Point2d* triangle, int xBegin, int xEnd, int yBegin, int yEnd,
+                       std::vector<double>& rowBuffer, PixelFunction f)
+{
+    if(xBegin >= xEnd || yBegin >= yEnd)
+        return;
+
+    const Point2d& V0 = triangle[0];
+    const Point2d& V1 = triangle[1];
+    const Point2d& V2 = triangle[2];
+    const double area = (V1.x - V0.x) * (V2.y - V0.y) - (V1.y - V0.y) * (V2.x - V0.x);
+
+    Point2d barycCoords;
+
+    if(std::abs(area) < 1e-12)
+    {
+        // degenerated triangle: exact test of each pixel
+        for(int y = yBegin; y < yEnd; ++y)
+            for(int x = xBegin; x < xEnd; ++x)
+                if(isPixelInTriangle(triangle, Pixel(x, y), barycCoords))
+                    f(x, y, barycCoords);
+        return;
+    }
+
+    // barycentric coordinate of each vertex: l_i(p) = a_i * p.x + b_i * p.y + c_i
+    const double a0 = (V1.y - V2.y) / area, b0 = (V2.x - V1.x) / area, c0 = (V1.x * V2.y - V1.y * V2.x) / area;
+    const double a1 = (V2.y - V0.y) / area, b1 = (V0.x - V2.x) / area, c1 = (V2.x * V0.y - V2.y * V0.x) / area;
+    const double a2 = (V0.y - V1.y) / area, b2 = (V1.x - V0.x) / area, c2 = (V0.x * V1.y - V0.y * V1.x) / area;
+
+    // a pixel whose center is farther than sqrt(0.5) from an edge line, on its outer side, is rejected
+    const double maxDist = std::sqrt(0.5) * (1.0 + 1e-6);
+    const double t0 = maxDist * (V2 - V1).size() / std::abs(area);
+    const double t1 = maxDist * (V0 - V2).size() / std::abs(area);
+    const double t2 = maxDist * (V1 - V0).size() / std::abs(area);
+
+    const int width = xEnd - xBegin;
+    rowBuffer.resize(3 * width);
+    double* __restrict l0 = &rowBuffer[0];
+    double* __restrict l1 = &rowBuffer[width];
+    double* __restrict l2 = &rowBuffer[2 * width];
+
+    for(int y = yBegin; y < yEnd; ++y)
+    {
+        // pixel center
+        const double py = y + 0.5;
+        const double r0 = b0 * py + c0;
+        const double r1 = b1 * py + c1;
+        const double r2 = b2 * py + c2;
+
+        for(int i = 0; i < width; ++i)
+        {
+            const double px = xBegin + i + 0.5;
+            l0[i] = a0 * px + r0;
+            l1[i] = a1 * px + r1;
+            l2[i] = a2 * px + r2;
+        }
+
+        for(int i = 0; i < width; ++i)
+        {
+            if(l0[i] >= 0.0 && l1[i] >= 0.0 && l2[i] >= 0.0)
+            {
+                // same coordinates as isPixelInTriangle
+                barycCoords.x = l2[i];
+                barycCoords.y = l1[i];
+                f(xBegin + i, y, barycCoords);
+            }
+            else if(l0[i] > -t0 && l1[i] > -t1 && l2[i] > -t2)
+            {
+                // close to an edge: exact distance to the triangle
+                if(isPixelInTriangle(triangle, Pixel(xBegin + i, y), barycCoords))
+                    f(xBegin + i, y, barycCoords);
+            }
+        }
+    }
+}
+
 
 struct TexturingParams
 {
@@ -121,8 +224,28 @@ public:
      */
     void generateUVs(mvsUtils::MultiViewParams &mp);
 
-    /// Generate texture files for all texture atlases
+    /**
+     * @brief Generate texture files for all texture atlases.
+     *
+     * The atlases are generated by batches fitting in the available memory.
+     */
+    void generateTextures(const mvsUtils::MultiViewParams& mp,
+                          const bfs::path &outPath, EImageFileType textureFileType = EImageFileType::PNG);
+
+    /**
+     * @brief Generate texture files for the given texture atlas indexes.
+     *
+     * The cameras are processed in sequence and each image is read once for all the atlases.
+     * The pixels of an image are projected in parallel over the atlases and the bands of texture rows.
+     *
+     * @param[in] mp the multi-view parameters
+     * @param[in] atlasIDs the atlas indexes
+     * @param[in] imageCache the images cache
+     * @param[in] outPath the output folder
+     * @param[in] textureFileType the texture file type
+     */
     void generateTextures(const mvsUtils::MultiViewParams& mp,
+                          const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache,
                           const bfs::path &outPath, EImageFileType textureFileType = EImageFileType::PNG);
 
     /// Generate texture files for the given texture atlas index
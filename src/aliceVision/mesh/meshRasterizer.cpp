@@ -0,0 +1,320 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "meshRasterizer.hpp"
+#include <aliceVision/mvsData/Point2d.hpp>
+#include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/// size in pixels of the square tiles rendered by a thread at once
+const int tileSize = 32;
+
+/**
+ * @brief Triangle prepared for the rasterization.
+ * The barycentric coordinates (k = 0..2) and the inverse depth (k = 3) are linear functions
+ * of the pixel indexes: f_k(x, y) = a[k] * x + b[k] * y + c[k], evaluated at the pixel center.
+ */
+struct TriangleSetup
+{
+    int triId;
+    /// pixels whose center is in the bounding box of the triangle
+    int xBegin, xEnd, yBegin, yEnd;
+    double a[4], b[4], c[4];
+};
+
+/// First pixel index whose center is after the given coordinate, clamped to [0; size]
+inline int firstPixelAfter(double v, int size)
+{
+    return static_cast<int>(std::ceil(std::min(std::max(v - 0.5, 0.0), static_cast<double>(size))));
+}
+
+/// Index after the last pixel whose center is before the given coordinate, clamped to [0; size]
+inline int endPixelBefore(double v, int size)
+{
+    return static_cast<int>(std::floor(std::min(std::max(v - 0.5, -1.0), static_cast<double>(size - 1)))) + 1;
+}
+
+bool setupTriangle(const Mesh& mesh, const RasterCamera& camera, double scaleX, double scaleY, int width, int height,
+                   int triId, TriangleSetup& setup)
+{
+    Point2d p[3];
+    double invZ[3];
+    for(int k = 0; k < 3; ++k)
+    {
+        const Point3d XT = camera.P * (*mesh.pts)[(*mesh.tris)[triId].v[k]];
+        if(XT.z <= 0.0)
+            return false;
+        invZ[k] = 1.0 / XT.z;
+        p[k].x = XT.x * invZ[k] * scaleX;
+        p[k].y = XT.y * invZ[k] * scaleY;
+    }
+
+    setup.triId = triId;
+    setup.xBegin = firstPixelAfter(std::min(std::min(p[0].x, p[1].x), p[2].x), width);
+    setup.yBegin = firstPixelAfter(std::min(std::min(p[0].y, p[1].y), p[2].y), height);
+    setup.xEnd = endPixelBefore(std::max(std::max(p[0].x, p[1].x), p[2].x), width);
+    setup.yEnd = endPixelBefore(std::max(std::max(p[0].y, p[1].y), p[2].y), height);
+    if(setup.xBegin >= setup.xEnd || setup.yBegin >= setup.yEnd)
+        return false;
+
+    const double area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+    if(std::abs(area) < 1e-12)
+        return false;
+
+    // barycentric coordinate of each vertex, from the edge function of the opposite edge
+    for(int k = 0; k < 3; ++k)
+    {
+        const Point2d& p1 = p[(k + 1) % 3];
+        const Point2d& p2 = p[(k + 2) % 3];
+        setup.a[k] = (p1.y - p2.y) / area;
+        setup.b[k] = (p2.x - p1.x) / area;
+        setup.c[k] = (p1.x * p2.y - p1.y * p2.x) / area;
+    }
+    // the inverse depth is linear in image space
+    setup.a[3] = setup.b[3] = setup.c[3] = 0.0;
+    for(int k = 0; k < 3; ++k)
+    {
+        setup.a[3] += invZ[k] * setup.a[k];
+        setup.b[3] += invZ[k] * setup.b[k];
+        setup.c[3] += invZ[k] * setup.c[k];
+    }
+    // evaluation at the pixel center
+    for(int k = 0; k < 4; ++k)
+        setup.c[k] += 0.5 * (setup.a[k] + setup.b[k]);
+
+    return true;
+}
+
+/**
+ * @brief Render the binned triangles in a tile.
+ * @param[in] setups the triangles
+ * @param[in] triBegin, triEnd the indexes of the triangles overlapping the tile, in rendering order
+ * @param[in] x0, y0 the first pixel of the tile
+ * @param[out] tileInvZ the inverse depth of each pixel of the tile (row by row), 0 if empty
+ * @param[out] tileTris the nearest triangle of each pixel of the tile, -1 if empty
+ */
+void renderTile(const std::vector<TriangleSetup>& setups, const int* triBegin, const int* triEnd, int x0, int y0,
+                float* tileInvZ, int* tileTris)
+{
+    std::fill(tileInvZ, tileInvZ + tileSize * tileSize, 0.f);
+    std::fill(tileTris, tileTris + tileSize * tileSize, -1);
+
+    for(const int* t = triBegin; t != triEnd; ++t)
+    {
+        const TriangleSetup& setup = setups[*t];
+        const int triId = setup.triId;
+
+        // bounding box in the tile
+        const int xb = std::max(setup.xBegin, x0) - x0;
+        const int xe = std::min(setup.xEnd, x0 + tileSize) - x0;
+        const int yb = std::max(setup.yBegin, y0) - y0;
+        const int ye = std::min(setup.yEnd, y0 + tileSize) - y0;
+
+        // functions relative to the tile origin, accurate in single precision
+        float a[4], b[4], c[4];
+        for(int k = 0; k < 4; ++k)
+        {
+            a[k] = static_cast<float>(setup.a[k]);
+            b[k] = static_cast<float>(setup.b[k]);
+            c[k] = static_cast<float>(setup.a[k] * x0 + setup.b[k] * y0 + setup.c[k]);
+        }
+
+        for(int y = yb; y < ye; ++y)
+        {
+            float* rowInvZ = tileInvZ + y * tileSize;
+            int* rowTris = tileTris + y * tileSize;
+            const float r0 = b[0] * y + c[0];
+            const float r1 = b[1] * y + c[1];
+            const float r2 = b[2] * y + c[2];
+            const float r3 = b[3] * y + c[3];
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+            // 4 pixels at once, the pixels out of the bounding box are masked
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 xbv = _mm_set1_ps(static_cast<float>(xb));
+            const __m128 xev = _mm_set1_ps(static_cast<float>(xe));
+            const __m128i triIdv = _mm_set1_epi32(triId);
+            for(int x = xb & ~3; x < xe; x += 4)
+            {
+                const __m128 xv = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_set_ps(3.f, 2.f, 1.f, 0.f));
+                const __m128 l0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), xv), _mm_set1_ps(r0));
+                const __m128 l1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), xv), _mm_set1_ps(r1));
+                const __m128 l2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), xv), _mm_set1_ps(r2));
+                const __m128 invZ = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[3]), xv), _mm_set1_ps(r3));
+                const __m128 prevInvZ = _mm_loadu_ps(rowInvZ + x);
+
+                __m128 mask = _mm_and_ps(_mm_cmpge_ps(xv, xbv), _mm_cmplt_ps(xv, xev));
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(l0, zero));
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(l1, zero));
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(l2, zero));
+                mask = _mm_and_ps(mask, _mm_cmpgt_ps(invZ, prevInvZ));
+                if(_mm_movemask_ps(mask) == 0)
+                    continue;
+
+                _mm_storeu_ps(rowInvZ + x, _mm_or_ps(_mm_and_ps(mask, invZ), _mm_andnot_ps(mask, prevInvZ)));
+                const __m128i maski = _mm_castps_si128(mask);
+                const __m128i prevTris = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowTris + x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rowTris + x),
+                                 _mm_or_si128(_mm_and_si128(maski, triIdv), _mm_andnot_si128(maski, prevTris)));
+            }
+#else
+            for(int x = xb; x < xe; ++x)
+            {
+                const float l0 = a[0] * x + r0;
+                const float l1 = a[1] * x + r1;
+                const float l2 = a[2] * x + r2;
+                const float invZ = a[3] * x + r3;
+                const bool inside = (l0 >= 0.f) & (l1 >= 0.f) & (l2 >= 0.f) & (invZ > rowInvZ[x]);
+                rowInvZ[x] = inside ? invZ : rowInvZ[x];
+                rowTris[x] = inside ? triId : rowTris[x];
+            }
+#endif
+        }
+    }
+}
+
+} // namespace
+
+RasterCamera::RasterCamera(const mvsUtils::MultiViewParams& mp, int rc)
+  : P(mp.camArr[rc])
+  , iCam(mp.iCamArr[rc])
+  , C(mp.CArr[rc])
+  , imageWidth(mp.getWidth(rc))
+  , imageHeight(mp.getHeight(rc))
+{}
+
+void rasterizeMesh(const Mesh& mesh, const RasterCamera& camera, int width, int height, MeshRendering& out,
+                   const StaticVector<int>* visTris)
+{
+    out.width = std::max(0, width);
+    out.height = std::max(0, height);
+    out.depthMap.clear();
+    out.trisMap.clear();
+    out.visibility.clear();
+    out.depthMap.resize_with(out.width * out.height, -1.0f);
+    out.trisMap.resize_with(out.width * out.height, -1);
+    out.visibility.resize_with(mesh.tris->size(), 0);
+
+    if(out.width == 0 || out.height == 0)
+        return;
+
+    const double scaleX = static_cast<double>(width) / camera.imageWidth;
+    const double scaleY = static_cast<double>(height) / camera.imageHeight;
+    const int nbTris = (visTris != nullptr) ? visTris->size() : mesh.tris->size();
+
+    // triangles setup
+    std::vector<TriangleSetup> setups(nbTris);
+    std::vector<char> isValid(nbTris);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
+    {
+        const int triId = (visTris != nullptr) ? (*visTris)[i] : i;
+        isValid[i] = setupTriangle(mesh, camera, scaleX, scaleY, width, height, triId, setups[i]);
+    }
+
+    std::size_t nbValid = 0;
+    for(int i = 0; i < nbTris; ++i)
+    {
+        if(isValid[i])
+            setups[nbValid++] = setups[i];
+    }
+    setups.resize(nbValid);
+    std::vector<char>().swap(isValid);
+
+    // triangles binning, in rendering order
+    const int nbTilesX = (width + tileSize - 1) / tileSize;
+    const int nbTilesY = (height + tileSize - 1) / tileSize;
+    std::vector<int> binOffsets(nbTilesX * nbTilesY + 1, 0);
+
+    for(const TriangleSetup& setup : setups)
+        for(int ty = setup.yBegin / tileSize; ty <= (setup.yEnd - 1) / tileSize; ++ty)
+            for(int tx = setup.xBegin / tileSize; tx <= (setup.xEnd - 1) / tileSize; ++tx)
+                ++binOffsets[ty * nbTilesX + tx + 1];
+
+    for(std::size_t t = 1; t < binOffsets.size(); ++t)
+        binOffsets[t] += binOffsets[t - 1];
+
+    std::vector<int> bins(binOffsets.back());
+    {
+        std::vector<int> binEnds(binOffsets.begin(), binOffsets.end() - 1);
+        for(std::size_t s = 0; s < setups.size(); ++s)
+        {
+            const TriangleSetup& setup = setups[s];
+            for(int ty = setup.yBegin / tileSize; ty <= (setup.yEnd - 1) / tileSize; ++ty)
+                for(int tx = setup.xBegin / tileSize; tx <= (setup.xEnd - 1) / tileSize; ++tx)
+                    bins[binEnds[ty * nbTilesX + tx]++] = static_cast<int>(s);
+        }
+    }
+
+    // the depth is the distance along the ray of the pixel center:
+    // the third coordinate of P * X is proportional to the depth in the camera
+    const double depthScale = (camera.P * (camera.C + camera.iCam * Point2d(0.0, 0.0))).z;
+
+    // tiles rendering
+    #pragma omp parallel
+    {
+        std::vector<float> tileInvZ(tileSize * tileSize);
+        std::vector<int> tileTris(tileSize * tileSize);
+
+        #pragma omp for schedule(dynamic)
+        for(int tile = 0; tile < nbTilesX * nbTilesY; ++tile)
+        {
+            const int x0 = (tile % nbTilesX) * tileSize;
+            const int y0 = (tile / nbTilesX) * tileSize;
+            const int tileWidth = std::min(tileSize, width - x0);
+            const int tileHeight = std::min(tileSize, height - y0);
+            const int* tileBins = bins.data();
+
+            renderTile(setups, tileBins + binOffsets[tile], tileBins + binOffsets[tile + 1], x0, y0,
+                       tileInvZ.data(), tileTris.data());
+
+            for(int x = 0; x < tileWidth; ++x)
+            {
+                const double u = (x0 + x + 0.5) / scaleX;
+                for(int y = 0; y < tileHeight; ++y)
+                {
+                    const int triId = tileTris[y * tileSize + x];
+                    if(triId < 0)
+                        continue;
+                    const int index = (x0 + x) * height + (y0 + y);
+                    const double v = (y0 + y + 0.5) / scaleY;
+                    out.trisMap[index] = triId;
+                    out.depthMap[index] = static_cast<float>((camera.iCam * Point2d(u, v)).size() /
+                                                             (tileInvZ[y * tileSize + x] * depthScale));
+                }
+            }
+        }
+    }
+
+    for(int i = 0; i < out.trisMap.size(); ++i)
+    {
+        if(out.trisMap[i] >= 0)
+            out.visibility[out.trisMap[i]] = 1;
+    }
+}
+
+void rasterizeMesh(const Mesh& mesh, const mvsUtils::MultiViewParams& mp, int rc, int width, int height, MeshRendering& out,
+                   const StaticVector<int>* visTris)
+{
+    rasterizeMesh(mesh, RasterCamera(mp, rc), width, height, out, visTris);
+}
+
+} // namespace mesh
+} // namespace aliceVision
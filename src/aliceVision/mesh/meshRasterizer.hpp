@@ -0,0 +1,84 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Pinhole camera in which a mesh is rendered.
+ */
+struct RasterCamera
+{
+    /// camera projection matrix P
+    Matrix3x4 P;
+    /// K * R inverse matrix
+    Matrix3x3 iCam;
+    /// camera position C in world coordinate system
+    Point3d C;
+    /// image size in the pixel coordinates of P
+    int imageWidth = 0;
+    int imageHeight = 0;
+
+    RasterCamera() = default;
+
+    /// Camera rc of the multi-view parameters
+    RasterCamera(const mvsUtils::MultiViewParams& mp, int rc);
+};
+
+/**
+ * @brief Rendering of a mesh in a camera.
+ * The maps are stored column by column (index x * height + y), like Mesh::getDepthMap.
+ */
+struct MeshRendering
+{
+    int width = 0;
+    int height = 0;
+    /// distance between the camera center and the nearest surface at each pixel center, -1 if none
+    StaticVector<float> depthMap;
+    /// index of the nearest triangle at each pixel center, -1 if none
+    StaticVector<int> trisMap;
+    /// for each triangle of the mesh, whether it is the nearest one in at least one pixel
+    StaticVectorBool visibility;
+};
+
+/**
+ * @brief Render the depth, the nearest triangle and the triangles visibility of a mesh with a z-buffer.
+ *
+ * The image is split in tiles rendered in parallel, the triangles are binned by tile.
+ * The edge functions of a triangle are stepped over several pixels at once.
+ * A pixel is covered by a triangle if its center is inside the triangle,
+ * the depth is interpolated with a perspective correction.
+ * The triangles with a vertex behind the camera are not rendered.
+ * The result does not depend on the number of threads: on equal depths, the first triangle wins.
+ *
+ * @param[in] mesh the mesh
+ * @param[in] camera the camera
+ * @param[in] width the rendering width, the image is rescaled to this size
+ * @param[in] height the rendering height
+ * @param[out] out the rendering
+ * @param[in] visTris the indexes of the triangles to render, all the triangles if nullptr
+ */
+void rasterizeMesh(const Mesh& mesh, const RasterCamera& camera, int width, int height, MeshRendering& out,
+                   const StaticVector<int>* visTris = nullptr);
+
+/**
+ * @brief Render a mesh in the camera rc of the multi-view parameters.
+ * @see rasterizeMesh
+ */
+void rasterizeMesh(const Mesh& mesh, const mvsUtils::MultiViewParams& mp, int rc, int width, int height, MeshRendering& out,
+                   const StaticVector<int>* visTris = nullptr);
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,306 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/meshRasterizer.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/imageIO/image.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#define BOOST_TEST_MODULE meshRasterizer
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const int imageWidth = 320;
+const int imageHeight = 240;
+
+/**
+ * @brief Multi-view parameters of a single camera at the origin looking along z,
+ * loaded from an ini file and an image with the AliceVision:P metadata.
+ */
+std::unique_ptr<mvsUtils::MultiViewParams> createMultiViewParams(const std::string& folder)
+{
+    bfs::create_directories(folder);
+    {
+        std::ofstream ini((bfs::path(folder) / "mvs.ini").string());
+        ini << "[global]\n"
+            << "ncams=1\n"
+            << "imgExt=exr\n"
+            << "verbose=0\n"
+            << "[imageResolutions]\n"
+            << "0=" << imageWidth << "x" << imageHeight << "\n";
+    }
+
+    Matrix3x3 K;
+    K.m11 = 400.0; K.m12 = 0.0;   K.m13 = imageWidth / 2;
+    K.m21 = 0.0;   K.m22 = 400.0; K.m23 = imageHeight / 2;
+    K.m31 = 0.0;   K.m32 = 0.0;   K.m33 = 1.0;
+    Matrix3x3 R;
+    R.m11 = 1.0; R.m12 = 0.0; R.m13 = 0.0;
+    R.m21 = 0.0; R.m22 = 1.0; R.m23 = 0.0;
+    R.m31 = 0.0; R.m32 = 0.0; R.m33 = 1.0;
+    const Matrix3x4 P = K * (R | Point3d(0.0, 0.0, 0.0));
+
+    std::vector<double> matrixP(16, 0.0);
+    std::copy_n(P.m, 12, matrixP.begin());
+    matrixP[15] = 1.0;
+    oiio::ParamValueList metadata;
+    metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
+    metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, matrixP.data()));
+    imageIO::writeImage((bfs::path(folder) / "0.exr").string(), imageWidth, imageHeight,
+                        std::vector<float>(imageWidth * imageHeight, 0.f), imageIO::EImageQuality::LOSSLESS, metadata);
+
+    return std::unique_ptr<mvsUtils::MultiViewParams>(new mvsUtils::MultiViewParams((bfs::path(folder) / "mvs.ini").string()));
+}
+
+/// Add a grid of nx x ny cells on the surface z = depth(x, y), x in [x0, x1] and y in [y0, y1]
+template <typename DepthFunction>
+void addGrid(Mesh& mesh, double x0, double x1, double y0, double y1, int nx, int ny, DepthFunction depth)
+{
+    const int first = mesh.pts->size();
+    for(int j = 0; j <= ny; ++j)
+    {
+        for(int i = 0; i <= nx; ++i)
+        {
+            const double x = x0 + (x1 - x0) * i / nx;
+            const double y = y0 + (y1 - y0) * j / ny;
+            mesh.pts->push_back(Point3d(x, y, depth(x, y)));
+        }
+    }
+    for(int j = 0; j < ny; ++j)
+    {
+        for(int i = 0; i < nx; ++i)
+        {
+            const int v = first + j * (nx + 1) + i;
+            mesh.tris->push_back(Mesh::triangle(v, v + 1, v + nx + 2));
+            mesh.tris->push_back(Mesh::triangle(v, v + nx + 2, v + nx + 1));
+        }
+    }
+}
+
+/**
+ * @brief A bumpy background surface, a tilted occluding plane in front of it,
+ * and a copy of the first occluder triangle at the end.
+ */
+void createMesh(Mesh& mesh, int& nbBackgroundTris, int& duplicatedTri)
+{
+    mesh.pts = new StaticVector<Point3d>();
+    mesh.tris = new StaticVector<Mesh::triangle>();
+
+    addGrid(mesh, -3.0, 3.0, -2.2, 2.2, 30, 20, [](double x, double y) { return 10.0 + 0.5 * std::sin(x) * std::cos(y); });
+    nbBackgroundTris = mesh.tris->size();
+    addGrid(mesh, -1.0, 1.0, -0.8, 0.8, 6, 5, [](double x, double) { return 6.0 + 0.2 * x; });
+
+    mesh.tris->push_back((*mesh.tris)[nbBackgroundTris]);
+    duplicatedTri = mesh.tris->size() - 1;
+}
+
+/// Intersection of the ray from C along dir with a triangle
+struct RayHit
+{
+    int triId = -1;
+    /// distance between C and the intersection
+    double depth = -1.0;
+    /// smallest barycentric coordinate of the intersection, negative outside the triangle
+    double minBarycentric = -1.0;
+};
+
+RayHit intersectTriangle(const Mesh& mesh, int triId, const Point3d& C, const Point3d& dir)
+{
+    const Point3d& p0 = (*mesh.pts)[(*mesh.tris)[triId].v[0]];
+    const Point3d e1 = (*mesh.pts)[(*mesh.tris)[triId].v[1]] - p0;
+    const Point3d e2 = (*mesh.pts)[(*mesh.tris)[triId].v[2]] - p0;
+
+    RayHit hit;
+    const Point3d pv = cross(dir, e2);
+    const double det = dot(e1, pv);
+    if(std::abs(det) < 1e-12)
+        return hit;
+    const Point3d tv = C - p0;
+    const double b1 = dot(tv, pv) / det;
+    const Point3d qv = cross(tv, e1);
+    const double b2 = dot(dir, qv) / det;
+    const double t = dot(e2, qv) / det;
+    if(t <= 0.0)
+        return hit;
+
+    hit.triId = triId;
+    hit.depth = t;
+    hit.minBarycentric = std::min({b1, b2, 1.0 - b1 - b2});
+    return hit;
+}
+
+/**
+ * @brief Compare the rendering with rays cast through the pixel centers against all the rendered triangles:
+ * - a pixel center inside a triangle, away from its edges and from any other surface at the same depth,
+ *   is rendered with the nearest triangle and its depth;
+ * - a rendered pixel center is on its triangle, up to the edges tolerance.
+ */
+void checkRendering(const Mesh& mesh, const mvsUtils::MultiViewParams& mp, const StaticVector<int>* visTris,
+                    const MeshRendering& rendering)
+{
+    const int w = rendering.width;
+    const int h = rendering.height;
+    BOOST_REQUIRE_EQUAL(rendering.trisMap.size(), w * h);
+    BOOST_REQUIRE_EQUAL(rendering.depthMap.size(), w * h);
+    BOOST_REQUIRE_EQUAL(rendering.visibility.size(), mesh.tris->size());
+
+    std::vector<int> renderedTris;
+    if(visTris != nullptr)
+        renderedTris.assign(visTris->begin(), visTris->end());
+    else
+        for(int i = 0; i < mesh.tris->size(); ++i)
+            renderedTris.push_back(i);
+
+    const RasterCamera camera(mp, 0);
+    const double edgeTolerance = 1e-4;
+    int nbCoveredPixels = 0;
+    int nbComparedPixels = 0;
+    for(int x = 0; x < w; ++x)
+    {
+        for(int y = 0; y < h; ++y)
+        {
+            const int index = x * h + y;
+            const Point2d pixelCenter((x + 0.5) * camera.imageWidth / w, (y + 0.5) * camera.imageHeight / h);
+            const Point3d dir = (camera.iCam * pixelCenter).normalize();
+
+            // nearest hit inside a triangle and nearest hit up to the edges tolerance
+            RayHit nearest;
+            RayHit nearestWithTolerance;
+            for(const int triId : renderedTris)
+            {
+                const RayHit hit = intersectTriangle(mesh, triId, camera.C, dir);
+                if(hit.minBarycentric >= 0.0 && (nearest.triId < 0 || hit.depth < nearest.depth))
+                    nearest = hit;
+                if(hit.minBarycentric >= -edgeTolerance && (nearestWithTolerance.triId < 0 || hit.depth < nearestWithTolerance.depth))
+                    nearestWithTolerance = hit;
+            }
+
+            const int triId = rendering.trisMap[index];
+            if(triId >= 0)
+            {
+                ++nbCoveredPixels;
+                BOOST_CHECK(rendering.visibility[triId]);
+                const RayHit hit = intersectTriangle(mesh, triId, camera.C, dir);
+                BOOST_CHECK_GE(hit.minBarycentric, -edgeTolerance);
+                BOOST_CHECK_CLOSE(rendering.depthMap[index], hit.depth, 1e-3);
+            }
+            else
+            {
+                BOOST_CHECK_EQUAL(rendering.depthMap[index], -1.0f);
+            }
+
+            // unambiguous pixels: the nearest triangle is the same with and without tolerance, away from its edges
+            if(nearest.triId >= 0 && nearest.minBarycentric > edgeTolerance && nearestWithTolerance.triId == nearest.triId)
+            {
+                ++nbComparedPixels;
+                BOOST_CHECK_EQUAL(triId, nearest.triId);
+                BOOST_CHECK_CLOSE(rendering.depthMap[index], nearest.depth, 1e-3);
+            }
+            else if(nearestWithTolerance.triId < 0)
+            {
+                BOOST_CHECK_EQUAL(triId, -1);
+            }
+        }
+    }
+    BOOST_CHECK(nbCoveredPixels > w * h / 2);
+    BOOST_CHECK(nbComparedPixels > nbCoveredPixels * 9 / 10);
+}
+
+/// The Mesh maps are the ones of the rendering
+void checkMeshMaps(const Mesh& mesh, const mvsUtils::MultiViewParams& mp, const StaticVector<int>* visTris,
+                   const MeshRendering& rendering)
+{
+    const int w = rendering.width;
+    const int h = rendering.height;
+
+    std::unique_ptr<StaticVector<int>> trisMap(mesh.getTrisMap(&mp, 0, w, h, visTris));
+    BOOST_CHECK(std::equal(trisMap->begin(), trisMap->end(), rendering.trisMap.begin()));
+
+    if(visTris != nullptr)
+        return;
+
+    StaticVector<float> depthMap;
+    mesh.getDepthMap(&depthMap, &mp, 0, w, h);
+    BOOST_CHECK(std::equal(depthMap.begin(), depthMap.end(), rendering.depthMap.begin()));
+
+    std::unique_ptr<StaticVector<int>> visibleTris(mesh.getVisibleTrianglesIndexes(&mp, 0, w, h));
+    std::vector<int> expectedVisibleTris;
+    for(int i = 0; i < rendering.visibility.size(); ++i)
+        if(rendering.visibility[i])
+            expectedVisibleTris.push_back(i);
+    BOOST_CHECK(std::vector<int>(visibleTris->begin(), visibleTris->end()) == expectedVisibleTris);
+}
+
+void checkEqual(const MeshRendering& a, const MeshRendering& b)
+{
+    BOOST_CHECK(std::equal(a.trisMap.begin(), a.trisMap.end(), b.trisMap.begin()));
+    BOOST_CHECK(std::equal(a.depthMap.begin(), a.depthMap.end(), b.depthMap.begin()));
+    BOOST_CHECK(std::equal(a.visibility.begin(), a.visibility.end(), b.visibility.begin()));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(meshRasterizer_compareWithRayCasting)
+{
+    const std::unique_ptr<mvsUtils::MultiViewParams> mp = createMultiViewParams("meshRasterizer_test");
+
+    Mesh mesh;
+    int nbBackgroundTris = 0;
+    int duplicatedTri = 0;
+    createMesh(mesh, nbBackgroundTris, duplicatedTri);
+
+    StaticVector<int> backgroundTris;
+    for(int i = 0; i < nbBackgroundTris; ++i)
+        backgroundTris.push_back(i);
+
+    const int nbThreads = omp_get_max_threads();
+    for(const int scale : {1, 2})
+    {
+        const int w = imageWidth / scale;
+        const int h = imageHeight / scale;
+
+        for(StaticVector<int>* visTris : {static_cast<StaticVector<int>*>(nullptr), &backgroundTris})
+        {
+            omp_set_num_threads(1);
+            MeshRendering reference;
+            rasterizeMesh(mesh, *mp, 0, w, h, reference, visTris);
+            BOOST_CHECK_EQUAL(reference.width, w);
+            BOOST_CHECK_EQUAL(reference.height, h);
+            checkRendering(mesh, *mp, visTris, reference);
+            checkMeshMaps(mesh, *mp, visTris, reference);
+
+            // the occluder hides a part of the background
+            const bool hasOccluder = std::any_of(reference.trisMap.begin(), reference.trisMap.end(), [&](int t) { return t >= nbBackgroundTris; });
+            BOOST_CHECK_EQUAL(hasOccluder, visTris == nullptr);
+            // on equal depths, the first triangle wins
+            BOOST_CHECK(!reference.visibility[duplicatedTri]);
+
+            for(const int threads : {2, std::max(4, omp_get_num_procs())})
+            {
+                omp_set_num_threads(threads);
+                MeshRendering rendering;
+                rasterizeMesh(mesh, *mp, 0, w, h, rendering, visTris);
+                checkEqual(reference, rendering);
+            }
+        }
+    }
+    omp_set_num_threads(nbThreads);
+}
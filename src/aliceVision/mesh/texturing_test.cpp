@@ -0,0 +1,177 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Texturing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE texturing
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace {
+
+struct RasterizedPixel
+{
+    int x;
+    int y;
+    Point2d barycentricCoords;
+};
+
+/**
+ * @brief Compare rasterizeTriangle with isPixelInTriangle on all the pixels of the triangle
+ * bounding box, extended by 2 pixels on each side.
+ * @return the number of rasterized pixels
+ */
+std::size_t checkRasterization(const Point2d* triangle)
+{
+    const int xBegin = static_cast<int>(std::floor(std::min({triangle[0].x, triangle[1].x, triangle[2].x}))) - 2;
+    const int yBegin = static_cast<int>(std::floor(std::min({triangle[0].y, triangle[1].y, triangle[2].y}))) - 2;
+    const int xEnd = static_cast<int>(std::ceil(std::max({triangle[0].x, triangle[1].x, triangle[2].x}))) + 2;
+    const int yEnd = static_cast<int>(std::ceil(std::max({triangle[0].y, triangle[1].y, triangle[2].y}))) + 2;
+
+    std::vector<RasterizedPixel> expected;
+    for(int y = yBegin; y < yEnd; ++y)
+    {
+        for(int x = xBegin; x < xEnd; ++x)
+        {
+            Point2d barycentricCoords;
+            if(isPixelInTriangle(triangle, Pixel(x, y), barycentricCoords))
+                expected.push_back({x, y, barycentricCoords});
+        }
+    }
+
+    std::vector<RasterizedPixel> rasterized;
+    std::vector<double> rowBuffer;
+    rasterizeTriangle(triangle, xBegin, xEnd, yBegin, yEnd, rowBuffer,
+                      [&](int x, int y, const Point2d& barycentricCoords) { rasterized.push_back({x, y, barycentricCoords}); });
+
+    // same pixels, in the same order, with the same barycentric coordinates
+    BOOST_REQUIRE_EQUAL(rasterized.size(), expected.size());
+    for(std::size_t i = 0; i < expected.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(rasterized[i].x, expected[i].x);
+        BOOST_CHECK_EQUAL(rasterized[i].y, expected[i].y);
+        BOOST_CHECK_SMALL(rasterized[i].barycentricCoords.x - expected[i].barycentricCoords.x, 1e-9);
+        BOOST_CHECK_SMALL(rasterized[i].barycentricCoords.y - expected[i].barycentricCoords.y, 1e-9);
+    }
+
+    // a part of the range gives the same pixels of this part
+    const int xMid = (xBegin + xEnd) / 2;
+    const int yMid = (yBegin + yEnd) / 2;
+    std::size_t nbInPart = 0;
+    rasterizeTriangle(triangle, xMid, xEnd, yMid, yEnd, rowBuffer,
+                      [&](int x, int y, const Point2d&) {
+                          BOOST_CHECK(x >= xMid && y >= yMid);
+                          ++nbInPart;
+                      });
+    BOOST_CHECK_EQUAL(nbInPart, std::count_if(expected.begin(), expected.end(), [&](const RasterizedPixel& p) {
+                          return p.x >= xMid && p.y >= yMid;
+                      }));
+
+    return expected.size();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(texturing_rasterizeRandomTriangles)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> coordinate(0.0, 40.0);
+
+    for(int i = 0; i < 500; ++i)
+    {
+        const Point2d triangle[3] = {Point2d(coordinate(generator), coordinate(generator)),
+                                     Point2d(coordinate(generator), coordinate(generator)),
+                                     Point2d(coordinate(generator), coordinate(generator))};
+        BOOST_CHECK_GT(checkRasterization(triangle), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(texturing_rasterizeThinTriangles)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> coordinate(0.0, 40.0);
+    std::uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+
+    for(const double thickness : {0.3, 1e-3, 1e-7, 1e-11})
+    {
+        for(int i = 0; i < 100; ++i)
+        {
+            // a third vertex close to the middle of the first edge
+            const Point2d v0(coordinate(generator), coordinate(generator));
+            const Point2d v1(coordinate(generator), coordinate(generator));
+            const double a = angle(generator);
+            const Point2d v2 = (v0 + v1) * 0.5 + Point2d(std::cos(a), std::sin(a)) * thickness;
+            const Point2d triangle[3] = {v0, v1, v2};
+            BOOST_CHECK_GT(checkRasterization(triangle), 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(texturing_rasterizeDegenerateTriangles)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> coordinate(0.0, 40.0);
+
+    for(int i = 0; i < 100; ++i)
+    {
+        const Point2d v0(coordinate(generator), coordinate(generator));
+        const Point2d v1(coordinate(generator), coordinate(generator));
+
+        // aligned vertices
+        const Point2d aligned[3] = {v0, v1, v0 + (v1 - v0) * 0.25};
+        BOOST_CHECK_GT(checkRasterization(aligned), 0);
+
+        // two identical vertices
+        const Point2d segment[3] = {v0, v1, v1};
+        BOOST_CHECK_GT(checkRasterization(segment), 0);
+
+        // a point
+        const Point2d point[3] = {v0, v0, v0};
+        BOOST_CHECK_GT(checkRasterization(point), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(texturing_rasterizePixelsNearEdges)
+{
+    // the vertices on the pixel corners and centers: the pixel centers are on the edges,
+    // or at sqrt(0.5) from them for the diagonal edges
+    for(const double offset : {0.0, 0.5, 1e-9, 0.5 - 1e-9, 0.5 + 1e-9})
+    {
+        const Point2d axisAligned[3] = {Point2d(2.0 + offset, 3.0 + offset), Point2d(12.0 + offset, 3.0 + offset),
+                                        Point2d(2.0 + offset, 9.0 + offset)};
+        BOOST_CHECK_GT(checkRasterization(axisAligned), 0);
+
+        const Point2d diagonal[3] = {Point2d(5.0 + offset, 1.0 + offset), Point2d(11.0 + offset, 7.0 + offset),
+                                     Point2d(1.0 + offset, 5.0 + offset)};
+        BOOST_CHECK_GT(checkRasterization(diagonal), 0);
+
+        // both orientations
+        const Point2d reversed[3] = {diagonal[2], diagonal[1], diagonal[0]};
+        BOOST_CHECK_GT(checkRasterization(reversed), 0);
+    }
+
+    // the pixels at the tolerance distance from the edges
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+    std::uniform_real_distribution<double> shift(-1e-6, 1e-6);
+    for(int i = 0; i < 200; ++i)
+    {
+        // an edge at sqrt(0.5) from the center of the pixel (10, 10), up to a small shift
+        const double a = angle(generator);
+        const Point2d normal(std::cos(a), std::sin(a));
+        const Point2d tangent(-normal.y, normal.x);
+        const Point2d onEdge = Point2d(10.5, 10.5) + normal * (std::sqrt(0.5) + shift(generator));
+        const Point2d triangle[3] = {onEdge - tangent * 5.0, onEdge + tangent * 5.0, onEdge + normal * 5.0};
+        BOOST_CHECK_GT(checkRasterization(triangle), 0);
+    }
+}
@@ -0,0 +1,345 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ArrayFile.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace aliceVision {
+
+namespace {
+
+const std::uint32_t blockVersion = 1;
+
+/// marker, version, element size, number of elements, chunk size, chunk table offset
+const std::uint64_t headerSize = 2 * sizeof(std::int32_t) + 4 * sizeof(std::uint64_t);
+
+std::int64_t tellFile(FILE* file)
+{
+#ifdef _WIN32
+    return _ftelli64(file);
+#else
+    return ftello(file);
+#endif
+}
+
+void seekFile(FILE* file, std::int64_t position)
+{
+#ifdef _WIN32
+    const int err = _fseeki64(file, position, SEEK_SET);
+#else
+    const int err = fseeko(file, static_cast<off_t>(position), SEEK_SET);
+#endif
+    if(err != 0)
+        throw std::runtime_error("Array file: can't seek to position " + std::to_string(position));
+}
+
+void writeFile(FILE* file, const void* data, std::size_t size)
+{
+    if(size > 0 && fwrite(data, 1, size, file) != size)
+        throw std::runtime_error("Array file: write error");
+}
+
+void readFile(FILE* file, void* data, std::size_t size)
+{
+    if(size > 0 && fread(data, 1, size, file) != size)
+        throw std::runtime_error("Array file: unexpected end of file");
+}
+
+template <class T>
+void writeValue(FILE* file, T value)
+{
+    writeFile(file, &value, sizeof(T));
+}
+
+template <class T>
+T readValue(FILE* file)
+{
+    T value;
+    readFile(file, &value, sizeof(T));
+    return value;
+}
+
+/// number of chunks compressed or uncompressed in parallel at once
+std::size_t getNbChunksPerBatch()
+{
+    return 2 * static_cast<std::size_t>(omp_get_max_threads());
+}
+
+} // namespace
+
+ArrayFileWriter::ArrayFileWriter(FILE* file, std::size_t elementSize, std::size_t chunkBytes, int compressionLevel)
+  : _file(file)
+  , _blockStart(tellFile(file))
+  , _elementSize(elementSize)
+  , _chunkSize(std::max<std::size_t>(1, chunkBytes / std::max<std::size_t>(1, elementSize)))
+  , _compressionLevel(compressionLevel)
+  , _nbChunksPerBatch(getNbChunksPerBatch())
+{
+    if(elementSize == 0)
+        throw std::invalid_argument("ArrayFileWriter: invalid element size");
+    if(_blockStart < 0)
+        throw std::runtime_error("ArrayFileWriter: invalid file");
+
+    // the number of elements and the chunk table offset are written by close
+    writeValue<std::int32_t>(_file, arrayFile::blockMarker);
+    writeValue<std::uint32_t>(_file, blockVersion);
+    writeValue<std::uint64_t>(_file, _elementSize);
+    writeValue<std::uint64_t>(_file, 0);
+    writeValue<std::uint64_t>(_file, _chunkSize);
+    writeValue<std::uint64_t>(_file, 0);
+    _position = headerSize;
+}
+
+void ArrayFileWriter::write(const void* data, std::size_t nbElements)
+{
+    if(_closed)
+        throw std::logic_error("ArrayFileWriter: the block is closed");
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    std::size_t remaining = nbElements * _elementSize;
+    const std::size_t batchBytes = _nbChunksPerBatch * _chunkSize * _elementSize;
+
+    while(remaining > 0)
+    {
+        const std::size_t size = std::min(remaining, batchBytes - _pending.size());
+        _pending.insert(_pending.end(), bytes, bytes + size);
+        bytes += size;
+        remaining -= size;
+        if(_pending.size() == batchBytes)
+            flush(false);
+    }
+    _nbElements += nbElements;
+}
+
+void ArrayFileWriter::flush(bool all)
+{
+    const std::size_t chunkBytes = _chunkSize * _elementSize;
+    std::size_t nbChunks = _pending.size() / chunkBytes;
+    if(all && _pending.size() % chunkBytes != 0)
+        ++nbChunks;
+    if(nbChunks == 0)
+        return;
+
+    std::vector<std::vector<unsigned char>> stored(nbChunks);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0; c < static_cast<int>(nbChunks); ++c)
+    {
+        const unsigned char* src = _pending.data() + c * chunkBytes;
+        const std::size_t size = std::min(chunkBytes, _pending.size() - c * chunkBytes);
+        std::vector<unsigned char>& chunk = stored[c];
+
+        uLongf compressedSize = compressBound(static_cast<uLong>(size));
+        chunk.resize(compressedSize);
+        const int err = compress2(chunk.data(), &compressedSize, src, static_cast<uLong>(size), _compressionLevel);
+
+        // the raw data is stored if the compression fails or does not reduce the size
+        if(err != Z_OK || compressedSize >= size)
+            chunk.assign(src, src + size);
+        else
+            chunk.resize(compressedSize);
+    }
+
+    for(const std::vector<unsigned char>& chunk : stored)
+    {
+        writeFile(_file, chunk.data(), chunk.size());
+        _chunkOffsets.push_back(_position);
+        _chunkStoredSizes.push_back(chunk.size());
+        _position += chunk.size();
+    }
+
+    _pending.erase(_pending.begin(), _pending.begin() + std::min(_pending.size(), nbChunks * chunkBytes));
+}
+
+void ArrayFileWriter::close()
+{
+    if(_closed)
+        return;
+
+    flush(true);
+
+    const std::uint64_t tableOffset = _position;
+    for(std::size_t c = 0; c < _chunkOffsets.size(); ++c)
+    {
+        writeValue<std::uint64_t>(_file, _chunkOffsets[c]);
+        writeValue<std::uint64_t>(_file, _chunkStoredSizes[c]);
+    }
+    const std::int64_t blockEnd = tellFile(_file);
+
+    seekFile(_file, _blockStart + 2 * sizeof(std::int32_t) + sizeof(std::uint64_t));
+    writeValue<std::uint64_t>(_file, _nbElements);
+    writeValue<std::uint64_t>(_file, _chunkSize);
+    writeValue<std::uint64_t>(_file, tableOffset);
+    seekFile(_file, blockEnd);
+
+    if(fflush(_file) != 0)
+        throw std::runtime_error("ArrayFileWriter: write error");
+    _closed = true;
+}
+
+ArrayFileReader::ArrayFileReader(FILE* file)
+  : _file(file)
+  , _blockStart(tellFile(file))
+  , _cachedChunk(std::numeric_limits<std::size_t>::max())
+{
+    if(_blockStart < 0)
+        throw std::runtime_error("ArrayFileReader: invalid file");
+
+    if(readValue<std::int32_t>(_file) != arrayFile::blockMarker)
+        throw std::runtime_error("ArrayFileReader: not a chunked array block");
+    const std::uint32_t version = readValue<std::uint32_t>(_file);
+    if(version != blockVersion)
+        throw std::runtime_error("ArrayFileReader: unsupported version " + std::to_string(version));
+
+    _elementSize = readValue<std::uint64_t>(_file);
+    _nbElements = readValue<std::uint64_t>(_file);
+    _chunkSize = readValue<std::uint64_t>(_file);
+    const std::uint64_t tableOffset = readValue<std::uint64_t>(_file);
+
+    if(_elementSize == 0 || _chunkSize == 0 || tableOffset < headerSize)
+        throw std::runtime_error("ArrayFileReader: invalid block header");
+
+    const std::size_t nbChunks = static_cast<std::size_t>((_nbElements + _chunkSize - 1) / _chunkSize);
+    _chunkOffsets.resize(nbChunks);
+    _chunkStoredSizes.resize(nbChunks);
+
+    seekFile(_file, _blockStart + static_cast<std::int64_t>(tableOffset));
+    for(std::size_t c = 0; c < nbChunks; ++c)
+    {
+        _chunkOffsets[c] = readValue<std::uint64_t>(_file);
+        _chunkStoredSizes[c] = readValue<std::uint64_t>(_file);
+        if(_chunkOffsets[c] < headerSize || _chunkOffsets[c] + _chunkStoredSizes[c] > tableOffset)
+            throw std::runtime_error("ArrayFileReader: invalid chunk table");
+    }
+    _blockEnd = tellFile(_file);
+}
+
+std::uint64_t ArrayFileReader::getChunkBytes(std::size_t chunk) const
+{
+    return std::min(_chunkSize, _nbElements - chunk * _chunkSize) * _elementSize;
+}
+
+void ArrayFileReader::readStoredChunk(std::size_t chunk, std::vector<unsigned char>& stored)
+{
+    seekFile(_file, _blockStart + static_cast<std::int64_t>(_chunkOffsets[chunk]));
+    stored.resize(_chunkStoredSizes[chunk]);
+    readFile(_file, stored.data(), stored.size());
+}
+
+void ArrayFileReader::uncompressChunk(const std::vector<unsigned char>& stored, std::uint64_t size, unsigned char* out) const
+{
+    // raw data
+    if(stored.size() == size)
+    {
+        std::memcpy(out, stored.data(), size);
+        return;
+    }
+
+    uLongf uncompressedSize = static_cast<uLongf>(size);
+    const int err = uncompress(out, &uncompressedSize, stored.data(), static_cast<uLong>(stored.size()));
+    if(err != Z_OK || uncompressedSize != size)
+        throw std::runtime_error("ArrayFileReader: uncompress error " + std::to_string(err));
+}
+
+void ArrayFileReader::read(std::uint64_t first, std::uint64_t nbElements, void* data)
+{
+    if(first > _nbElements || nbElements > _nbElements - first)
+        throw std::out_of_range("ArrayFileReader: elements out of the array");
+    if(nbElements == 0)
+        return;
+
+    unsigned char* out = static_cast<unsigned char*>(data);
+    const std::uint64_t last = first + nbElements;
+    const std::size_t firstChunk = static_cast<std::size_t>(first / _chunkSize);
+    const std::size_t endChunk = static_cast<std::size_t>((last - 1) / _chunkSize) + 1;
+    const std::size_t nbChunksPerBatch = getNbChunksPerBatch();
+
+    // the first and last chunks may be partially read
+    const auto isPartial = [&](std::size_t chunk) {
+        const std::uint64_t chunkFirst = chunk * _chunkSize;
+        return first > chunkFirst || last < chunkFirst + getChunkBytes(chunk) / _elementSize;
+    };
+
+    std::vector<std::vector<unsigned char>> stored(nbChunksPerBatch);
+    std::vector<char> isValid(nbChunksPerBatch);
+    std::vector<char> isCached(nbChunksPerBatch);
+    std::vector<unsigned char> partialData;
+
+    for(std::size_t batchBegin = firstChunk; batchBegin < endChunk; batchBegin += nbChunksPerBatch)
+    {
+        const std::size_t batchEnd = std::min(endChunk, batchBegin + nbChunksPerBatch);
+
+        // the file is read sequentially, the full chunks are uncompressed in parallel
+        for(std::size_t c = batchBegin; c < batchEnd; ++c)
+        {
+            isCached[c - batchBegin] = (isPartial(c) && c == _cachedChunk);
+            if(isCached[c - batchBegin])
+                stored[c - batchBegin].clear();
+            else
+                readStoredChunk(c, stored[c - batchBegin]);
+        }
+
+        #pragma omp parallel for schedule(dynamic)
+        for(int i = 0; i < static_cast<int>(batchEnd - batchBegin); ++i)
+        {
+            const std::size_t c = batchBegin + i;
+            isValid[i] = 1;
+            if(isPartial(c))
+                continue;
+            try
+            {
+                uncompressChunk(stored[i], getChunkBytes(c), out + (c * _chunkSize - first) * _elementSize);
+            }
+            catch(const std::exception&)
+            {
+                isValid[i] = 0;
+            }
+        }
+
+        for(std::size_t c = batchBegin; c < batchEnd; ++c)
+        {
+            if(!isValid[c - batchBegin])
+                throw std::runtime_error("ArrayFileReader: uncompress error in chunk " + std::to_string(c));
+            if(!isPartial(c))
+                continue;
+
+            // the last chunk is kept for the next read
+            const std::vector<unsigned char>* chunkData = &_cachedData;
+            if(!isCached[c - batchBegin])
+            {
+                std::vector<unsigned char>* buffer = &partialData;
+                if(c + 1 == endChunk)
+                {
+                    _cachedChunk = std::numeric_limits<std::size_t>::max();
+                    buffer = &_cachedData;
+                }
+                buffer->resize(getChunkBytes(c));
+                uncompressChunk(stored[c - batchBegin], getChunkBytes(c), buffer->data());
+                if(c + 1 == endChunk)
+                    _cachedChunk = c;
+                chunkData = buffer;
+            }
+            const std::uint64_t chunkFirst = c * _chunkSize;
+            const std::uint64_t begin = std::max(first, chunkFirst);
+            const std::uint64_t end = std::min(last, chunkFirst + getChunkBytes(c) / _elementSize);
+            std::memcpy(out + (begin - first) * _elementSize,
+                        chunkData->data() + (begin - chunkFirst) * _elementSize,
+                        (end - begin) * _elementSize);
+        }
+    }
+
+    seekFile(_file, _blockEnd);
+}
+
+} // namespace aliceVision
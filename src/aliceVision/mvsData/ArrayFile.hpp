@@ -0,0 +1,146 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace aliceVision {
+
+/**
+ * Chunked array files
+ *
+ * An array is stored in a block of chunks compressed independently:
+ * - header: int32 marker (-2), uint32 version, uint64 element size, uint64 number of elements,
+ *   uint64 number of elements per chunk, uint64 offset of the chunk table from the block start
+ * - chunks: data compressed with zlib, or raw data if the compression does not reduce the size
+ * - chunk table: uint64 offset from the block start and uint64 stored size of each chunk
+ *
+ * The marker distinguishes the blocks from the legacy array files, which start
+ * with the number of elements (raw data) or -1 (data compressed at once).
+ * The chunks are compressed and uncompressed in parallel. An array is written and read
+ * by parts, without the whole data in memory, and any range of elements can be read.
+ * As in the legacy files, the header fields and the elements are stored in the native
+ * byte order, so the files are not portable between little and big endian machines.
+ */
+namespace arrayFile {
+
+/// first int32 of a block
+const int blockMarker = -2;
+
+/// default size of the uncompressed chunks in bytes
+const std::size_t defaultChunkBytes = 1 << 20;
+
+} // namespace arrayFile
+
+/**
+ * @brief Write an array in a chunked block, at the current position of a file.
+ */
+class ArrayFileWriter
+{
+public:
+    /**
+     * @param[in] file the file, opened in binary write mode
+     * @param[in] elementSize the size of an element in bytes
+     * @param[in] chunkBytes the size of the uncompressed chunks in bytes, rounded to a number of elements
+     * @param[in] compressionLevel the zlib compression level, the fastest by default
+     */
+    ArrayFileWriter(FILE* file, std::size_t elementSize,
+                    std::size_t chunkBytes = arrayFile::defaultChunkBytes, int compressionLevel = 1);
+
+    ArrayFileWriter(const ArrayFileWriter&) = delete;
+    ArrayFileWriter& operator=(const ArrayFileWriter&) = delete;
+
+    /**
+     * @brief Append elements to the array.
+     * The full chunks are compressed in parallel by batches.
+     */
+    void write(const void* data, std::size_t nbElements);
+
+    /**
+     * @brief Write the last chunks and the chunk table.
+     * The file position is then at the end of the block.
+     */
+    void close();
+
+private:
+    /// Compress and write the pending chunks, the last one only if it is full or if @p all
+    void flush(bool all);
+
+    FILE* _file;
+    std::int64_t _blockStart;
+    std::uint64_t _elementSize;
+    std::uint64_t _chunkSize;
+    int _compressionLevel;
+    std::size_t _nbChunksPerBatch;
+
+    std::uint64_t _nbElements = 0;
+    /// current position from the block start
+    std::uint64_t _position = 0;
+    /// uncompressed data not written yet
+    std::vector<unsigned char> _pending;
+    std::vector<std::uint64_t> _chunkOffsets;
+    std::vector<std::uint64_t> _chunkStoredSizes;
+    bool _closed = false;
+};
+
+/**
+ * @brief Read an array from a chunked block, at the current position of a file.
+ */
+class ArrayFileReader
+{
+public:
+    /**
+     * @brief Read the block header and the chunk table.
+     * The file position is then at the end of the block, and is restored after each read.
+     * @param[in] file the file, opened in binary read mode
+     */
+    explicit ArrayFileReader(FILE* file);
+
+    ArrayFileReader(const ArrayFileReader&) = delete;
+    ArrayFileReader& operator=(const ArrayFileReader&) = delete;
+
+    std::uint64_t getElementSize() const { return _elementSize; }
+    std::uint64_t getNbElements() const { return _nbElements; }
+    std::uint64_t getChunkSize() const { return _chunkSize; }
+    std::size_t getNbChunks() const { return _chunkOffsets.size(); }
+
+    /**
+     * @brief Read a range of elements.
+     * The full chunks of the range are uncompressed in parallel by batches,
+     * the last chunk of a partial read is kept for the next read.
+     * @param[in] first the first element
+     * @param[in] nbElements the number of elements
+     * @param[out] data the elements
+     */
+    void read(std::uint64_t first, std::uint64_t nbElements, void* data);
+
+private:
+    /// Read the stored data of a chunk
+    void readStoredChunk(std::size_t chunk, std::vector<unsigned char>& stored);
+    /// Uncompress a chunk to its @p size bytes
+    void uncompressChunk(const std::vector<unsigned char>& stored, std::uint64_t size, unsigned char* out) const;
+
+    std::uint64_t getChunkBytes(std::size_t chunk) const;
+
+    FILE* _file;
+    std::int64_t _blockStart;
+    std::int64_t _blockEnd;
+    std::uint64_t _elementSize = 0;
+    std::uint64_t _nbElements = 0;
+    std::uint64_t _chunkSize = 0;
+    std::vector<std::uint64_t> _chunkOffsets;
+    std::vector<std::uint64_t> _chunkStoredSizes;
+
+    /// last chunk of the last partial read
+    std::size_t _cachedChunk;
+    std::vector<unsigned char> _cachedData;
+};
+
+} // namespace aliceVision
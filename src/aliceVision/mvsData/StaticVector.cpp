@@ -21,7 +21,20 @@ int getArrayLengthFromFile(std::string fileName)
 
     int n = 0;
     fread(&n, sizeof(int), 1, f);
-    if(n == -1)
+    if(n == arrayFile::blockMarker)
+    {
+        try
+        {
+            fseek(f, 0, SEEK_SET);
+            n = static_cast<int>(ArrayFileReader(f).getNbElements());
+        }
+        catch(const std::exception& e)
+        {
+            ALICEVISION_LOG_WARNING("Invalid array file " << fileName << ": " << e.what());
+            n = 0;
+        }
+    }
+    else if(n == -1)
     {
         fread(&n, sizeof(int), 1, f);
     }
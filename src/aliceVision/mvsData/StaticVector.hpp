@@ -7,6 +7,7 @@
 #pragma once
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/mvsData/ArrayFile.hpp>
 
 #include <algorithm>
 #include <assert.h>
@@ -15,6 +16,7 @@
 #include <vector>
 #include <zlib.h>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 
 namespace aliceVision {
@@ -190,31 +192,45 @@ int indexOf(T* arr, int n, const T& what)
     return isthereindex;
 }
 
+template <class T>
+void deleteArrayOfArrays(StaticVector<StaticVector<T>*>** aa);
+
+/**
+ * @brief Save an array of arrays in two chunked blocks: the size of each array, then the concatenated arrays.
+ * The null arrays are saved as empty arrays.
+ */
 template <class T>
 void saveArrayOfArraysToFile(std::string fileName, StaticVector<StaticVector<T>*>* aa)
 {
     ALICEVISION_LOG_DEBUG("[IO] saveArrayOfArraysToFile: " << fileName);
     FILE* f = fopen(fileName.c_str(), "wb");
-    int n = aa->size();
-    fwrite(&n, sizeof(int), 1, f);
-    for(int i = 0; i < n; i++)
+    if(f == nullptr)
+        throw std::runtime_error("saveArrayOfArraysToFile: can't open file " + fileName);
+
+    try
     {
-        int m = 0;
-        StaticVector<T>* a = (*aa)[i];
-        if(a == NULL)
+        ArrayFileWriter sizesWriter(f, sizeof(int));
+        for(int i = 0; i < aa->size(); i++)
         {
-            fwrite(&m, sizeof(int), 1, f);
+            const int m = ((*aa)[i] == nullptr) ? 0 : (*aa)[i]->size();
+            sizesWriter.write(&m, 1);
         }
-        else
+        sizesWriter.close();
+
+        ArrayFileWriter valuesWriter(f, sizeof(T));
+        for(int i = 0; i < aa->size(); i++)
         {
-            m = a->size();
-            fwrite(&m, sizeof(int), 1, f);
-            if(m > 0)
-            {
-                fwrite(&(*a)[0], sizeof(T), m, f);
-            };
-        };
-    };
+            const StaticVector<T>* a = (*aa)[i];
+            if(a != nullptr && !a->empty())
+                valuesWriter.write(a->getData().data(), a->size());
+        }
+        valuesWriter.close();
+    }
+    catch(...)
+    {
+        fclose(f);
+        throw;
+    }
     fclose(f);
 }
 
@@ -229,6 +245,47 @@ StaticVector<StaticVector<T>*>* loadArrayOfArraysFromFile(std::string fileName)
     int n = 0;
     fread(&n, sizeof(int), 1, f);
     StaticVector<StaticVector<T>*>* aa = new StaticVector<StaticVector<T>*>();
+
+    if(n == arrayFile::blockMarker)
+    {
+        try
+        {
+            fseek(f, 0, SEEK_SET);
+            ArrayFileReader sizesReader(f);
+            if(sizesReader.getElementSize() != sizeof(int))
+                throw std::runtime_error("loadArrayOfArraysFromFile: invalid element size in file " + fileName);
+            StaticVector<int> sizes;
+            sizes.resize(sizesReader.getNbElements());
+            sizesReader.read(0, sizes.size(), sizes.getDataWritable().data());
+
+            // the arrays are read sequentially, each chunk is uncompressed once
+            ArrayFileReader valuesReader(f);
+            if(valuesReader.getElementSize() != sizeof(T))
+                throw std::runtime_error("loadArrayOfArraysFromFile: invalid element size in file " + fileName);
+            aa->resize_with(sizes.size(), nullptr);
+            std::uint64_t offset = 0;
+            for(int i = 0; i < sizes.size(); i++)
+            {
+                if(sizes[i] <= 0)
+                    continue;
+                StaticVector<T>* a = new StaticVector<T>();
+                (*aa)[i] = a;
+                a->resize(sizes[i]);
+                valuesReader.read(offset, sizes[i], a->getDataWritable().data());
+                offset += sizes[i];
+            }
+        }
+        catch(...)
+        {
+            deleteArrayOfArrays<T>(&aa);
+            fclose(f);
+            throw;
+        }
+        fclose(f);
+        return aa;
+    }
+
+    // legacy format: raw arrays
     aa->reserve(n);
     aa->resize_with(n, NULL);
     for(int i = 0; i < n; i++)
@@ -248,6 +305,40 @@ StaticVector<StaticVector<T>*>* loadArrayOfArraysFromFile(std::string fileName)
     return aa;
 }
 
+/**
+ * @brief Read an array from a file whose first chunked block is at the current position.
+ * @param[in] f the file
+ * @param[out] a the array, resized if @p expectedSize is negative
+ * @param[in] expectedSize the expected number of elements, or -1
+ * @param[in] fileName the file name for the error messages
+ */
+template <class T>
+void readArrayBlock(FILE* f, StaticVector<T>& a, int expectedSize, const std::string& fileName)
+{
+    ArrayFileReader reader(f);
+    if(reader.getElementSize() != sizeof(T))
+        throw std::runtime_error("Invalid element size in file " + fileName);
+    if(reader.getNbElements() > static_cast<std::uint64_t>(std::numeric_limits<int>::max()))
+        throw std::runtime_error("Too many elements for a StaticVector in file " + fileName);
+
+    const int n = static_cast<int>(reader.getNbElements());
+    if(expectedSize < 0)
+    {
+        a.resize(n);
+    }
+    else if(expectedSize != n)
+    {
+        std::stringstream s;
+        s << "expected length " << expectedSize << " loaded length " << n << " in file " << fileName;
+        throw std::runtime_error(s.str());
+    }
+    reader.read(0, n, a.getDataWritable().data());
+}
+
+/**
+ * @brief Save an array in a file.
+ * The compressed arrays are saved in a chunked block (see ArrayFileWriter), the small ones are saved raw.
+ */
 template <class T>
 void saveArrayToFile(std::string fileName, StaticVector<T>* a, bool docompress = true)
 {
@@ -258,53 +349,27 @@ void saveArrayToFile(std::string fileName, StaticVector<T>* a, bool docompress =
         FILE* f = fopen(fileName.c_str(), "wb");
         int n = a->size();
         fwrite(&n, sizeof(int), 1, f);
-        fwrite(&(*a)[0], sizeof(T), n, f);
+        if(n > 0)
+            fwrite(&(*a)[0], sizeof(T), n, f);
         fclose(f);
     }
     else
     {
-
-        /* ===========================================================================
-        //from zlib - compress.c
-             Compresses the source buffer into the destination buffer. The level
-           parameter has the same meaning as in deflateInit.  sourceLen is the byte
-           length of the source buffer. Upon entry, destLen is the total size of the
-           destination buffer, which must be at least 0.1% larger than sourceLen plus
-           12 bytes. Upon exit, destLen is the actual size of the compressed buffer.
-
-             compress2 returns Z_OK if success, Z_MEM_ERROR if there was not enough
-           memory, Z_BUF_ERROR if there was not enough room in the output buffer,
-           Z_STREAM_ERROR if the level parameter is invalid.
-        */
-
-        // uLong comprLen = sizeof(T)*a->size();
-        uLong comprLen = uLong((double)(sizeof(T) * a->size()) * 1.02) + 12;
-        Byte* compr = (Byte*)calloc((uInt)comprLen, 1);
-        int err = compress(compr, &comprLen, (const Bytef*)(&(*a)[0]), sizeof(T) * a->size());
-
-        if(err != Z_OK)
+        FILE* f = fopen(fileName.c_str(), "wb");
+        if(f == nullptr)
+            throw std::runtime_error("saveArrayToFile: can't open file " + fileName);
+        try
         {
-            ALICEVISION_LOG_ERROR("compress error " << err << " : " << (sizeof(T) * a->size()) << " -> " << comprLen << ", n " << a->size());
-
-            FILE* f = fopen(fileName.c_str(), "wb");
-            int n = a->size();
-            fwrite(&n, sizeof(int), 1, f);
-            fwrite(&(*a)[0], sizeof(T), n, f);
-            fclose(f);
+            ArrayFileWriter writer(f, sizeof(T));
+            writer.write(a->getData().data(), a->size());
+            writer.close();
         }
-        else
+        catch(...)
         {
-            FILE* f = fopen(fileName.c_str(), "wb");
-            int n = -1;
-            fwrite(&n, sizeof(int), 1, f);
-            n = a->size();
-            fwrite(&n, sizeof(int), 1, f);
-            fwrite(&comprLen, sizeof(uLong), 1, f);
-            fwrite(compr, sizeof(Byte), comprLen, f);
             fclose(f);
-        };
-
-        free(compr);
+            throw;
+        }
+        fclose(f);
     };
 }
 
@@ -324,7 +389,22 @@ StaticVector<T>* loadArrayFromFile(std::string fileName, bool printfWarning = fa
         fread(&n, sizeof(int), 1, f);
         StaticVector<T>* a = NULL;
 
-        if(n == -1)
+        if(n == arrayFile::blockMarker)
+        {
+            a = new StaticVector<T>();
+            try
+            {
+                fseek(f, 0, SEEK_SET);
+                readArrayBlock(f, *a, -1, fileName);
+            }
+            catch(...)
+            {
+                delete a;
+                fclose(f);
+                throw;
+            }
+        }
+        else if(n == -1)
         {
             fread(&n, sizeof(int), 1, f);
             a = new StaticVector<T>();
@@ -356,7 +436,8 @@ StaticVector<T>* loadArrayFromFile(std::string fileName, bool printfWarning = fa
         {
             a = new StaticVector<T>();
             a->resize(n);
-            fread(&(*a)[0], sizeof(T), n, f);
+            if(n > 0)
+                fread(&(*a)[0], sizeof(T), n, f);
         }
 
         fclose(f);
@@ -378,7 +459,20 @@ void loadArrayFromFileIntoArray(StaticVector<T>* a, std::string fileName, bool p
     int n = 0;
     fread(&n, sizeof(int), 1, f);
  
-    if(n == -1)
+    if(n == arrayFile::blockMarker)
+    {
+        try
+        {
+            fseek(f, 0, SEEK_SET);
+            readArrayBlock(f, *a, a->size(), fileName);
+        }
+        catch(...)
+        {
+            fclose(f);
+            throw;
+        }
+    }
+    else if(n == -1)
     {
         fread(&n, sizeof(int), 1, f);
         if(a->size() != n)
@@ -417,7 +511,8 @@ void loadArrayFromFileIntoArray(StaticVector<T>* a, std::string fileName, bool p
             s << "loadArrayFromFileIntoArray: expected length " << a->size() << " loaded length " << n;
             throw std::runtime_error(s.str());
         }
-        fread(&(*a)[0], sizeof(T), n, f);
+        if(n > 0)
+            fread(&(*a)[0], sizeof(T), n, f);
     }
  
     fclose(f);
@@ -0,0 +1,322 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mvsData/ArrayFile.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE arrayFile
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+/// Elements per chunk of the small chunks
+const std::size_t chunkSize = 100;
+
+/// Compressible values with some random ones, so both the compressed and the raw chunks are used
+std::vector<int> createValues(std::size_t n, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::vector<int> values(n);
+    for(std::size_t i = 0; i < n; ++i)
+        values[i] = (i % 7 == 0 || (i / chunkSize) % 3 == 2) ? static_cast<int>(generator()) : static_cast<int>(i / 2);
+    return values;
+}
+
+/// Write the values in a block of small chunks by parts of various sizes, followed by a tail value
+void writeBlock(const std::string& fileName, const std::vector<int>& values, int tail)
+{
+    FILE* f = std::fopen(fileName.c_str(), "wb");
+    BOOST_REQUIRE(f != nullptr);
+    ArrayFileWriter writer(f, sizeof(int), chunkSize * sizeof(int));
+    std::size_t position = 0;
+    for(std::size_t part = 0; position < values.size(); ++part)
+    {
+        const std::size_t n = std::min(values.size() - position, (part * 37) % 250);
+        writer.write(values.data() + position, n);
+        position += n;
+    }
+    writer.close();
+    std::fwrite(&tail, sizeof(int), 1, f);
+    std::fclose(f);
+}
+
+void checkRead(ArrayFileReader& reader, const std::vector<int>& values, std::size_t first, std::size_t n)
+{
+    std::vector<int> data(n);
+    reader.read(first, n, data.data());
+    BOOST_CHECK(std::equal(data.begin(), data.end(), values.begin() + first));
+}
+
+/// Legacy raw file: the number of elements and the elements
+template <class T>
+void writeLegacyRaw(const std::string& fileName, const std::vector<T>& values)
+{
+    FILE* f = std::fopen(fileName.c_str(), "wb");
+    const int n = values.size();
+    std::fwrite(&n, sizeof(int), 1, f);
+    std::fwrite(values.data(), sizeof(T), values.size(), f);
+    std::fclose(f);
+}
+
+/// Legacy compressed file: -1, the number of elements, the compressed size and the data compressed at once
+template <class T>
+void writeLegacyCompressed(const std::string& fileName, const std::vector<T>& values)
+{
+    uLong comprLen = compressBound(sizeof(T) * values.size());
+    std::vector<Byte> compr(comprLen);
+    BOOST_REQUIRE_EQUAL(compress(compr.data(), &comprLen, reinterpret_cast<const Bytef*>(values.data()), sizeof(T) * values.size()), Z_OK);
+
+    FILE* f = std::fopen(fileName.c_str(), "wb");
+    const int marker = -1;
+    const int n = values.size();
+    std::fwrite(&marker, sizeof(int), 1, f);
+    std::fwrite(&n, sizeof(int), 1, f);
+    std::fwrite(&comprLen, sizeof(uLong), 1, f);
+    std::fwrite(compr.data(), 1, comprLen, f);
+    std::fclose(f);
+}
+
+/// Load a file with all the StaticVector functions
+template <class T>
+void checkLoad(const std::string& fileName, const std::vector<T>& values)
+{
+    BOOST_CHECK_EQUAL(getArrayLengthFromFile(fileName), values.size());
+
+    StaticVector<T>* a = loadArrayFromFile<T>(fileName);
+    BOOST_CHECK(a->getData() == values);
+    delete a;
+
+    StaticVector<T> b;
+    b.resize(values.size());
+    loadArrayFromFileIntoArray(&b, fileName);
+    BOOST_CHECK(b.getData() == values);
+
+    StaticVector<T> c;
+    c.resize(values.size() + 1);
+    BOOST_CHECK_THROW(loadArrayFromFileIntoArray(&c, fileName), std::runtime_error);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ArrayFile_emptyArray)
+{
+    const std::string fileName = "arrayFile_empty.bin";
+    writeBlock(fileName, std::vector<int>(), 777);
+
+    FILE* f = std::fopen(fileName.c_str(), "rb");
+    {
+        ArrayFileReader reader(f);
+        BOOST_CHECK_EQUAL(reader.getElementSize(), sizeof(int));
+        BOOST_CHECK_EQUAL(reader.getNbElements(), 0);
+        BOOST_CHECK_EQUAL(reader.getNbChunks(), 0);
+        reader.read(0, 0, nullptr);
+        int value = 0;
+        BOOST_CHECK_THROW(reader.read(0, 1, &value), std::out_of_range);
+
+        // the file position is at the end of the block
+        BOOST_CHECK_EQUAL(std::fread(&value, sizeof(int), 1, f), 1);
+        BOOST_CHECK_EQUAL(value, 777);
+    }
+    std::fclose(f);
+
+    // saved raw
+    StaticVector<float> a;
+    saveArrayToFile("arrayFile_emptyRaw.bin", &a);
+    checkLoad("arrayFile_emptyRaw.bin", std::vector<float>());
+}
+
+BOOST_AUTO_TEST_CASE(ArrayFile_chunkBoundaries)
+{
+    for(const std::size_t n : {chunkSize - 1, chunkSize, chunkSize + 1, 5 * chunkSize, 5 * chunkSize + 1})
+    {
+        const std::string fileName = "arrayFile_chunks.bin";
+        const std::vector<int> values = createValues(n, n);
+        writeBlock(fileName, values, 777);
+
+        FILE* f = std::fopen(fileName.c_str(), "rb");
+        {
+            ArrayFileReader reader(f);
+            BOOST_CHECK_EQUAL(reader.getNbElements(), n);
+            BOOST_CHECK_EQUAL(reader.getChunkSize(), chunkSize);
+            BOOST_CHECK_EQUAL(reader.getNbChunks(), (n + chunkSize - 1) / chunkSize);
+
+            checkRead(reader, values, 0, n);
+            // the last element alone
+            checkRead(reader, values, n - 1, 1);
+            checkRead(reader, values, n, 0);
+
+            int value = 0;
+            BOOST_CHECK_THROW(reader.read(n, 1, &value), std::out_of_range);
+            BOOST_CHECK_THROW(reader.read(n - 1, 2, &value), std::out_of_range);
+            BOOST_CHECK_THROW(reader.read(n + 1, 0, &value), std::out_of_range);
+
+            // the file position is restored at the end of the block after the reads
+            BOOST_CHECK_EQUAL(std::fread(&value, sizeof(int), 1, f), 1);
+            BOOST_CHECK_EQUAL(value, 777);
+        }
+        std::fclose(f);
+    }
+
+    // with the default chunk size of the StaticVector files
+    const std::size_t defaultChunkSize = arrayFile::defaultChunkBytes / sizeof(float);
+    for(const std::size_t n : {defaultChunkSize, defaultChunkSize + 1, 2 * defaultChunkSize})
+    {
+        StaticVector<float> a;
+        a.resize(n);
+        for(std::size_t i = 0; i < n; ++i)
+            a[i] = (i % 5 == 0) ? static_cast<float>(i) : 0.5f;
+        saveArrayToFile("arrayFile_default.bin", &a);
+        checkLoad("arrayFile_default.bin", a.getData());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ArrayFile_partialReads)
+{
+    const std::size_t n = 12 * chunkSize + 45;
+    const std::string fileName = "arrayFile_partial.bin";
+    const std::vector<int> values = createValues(n, 0);
+    writeBlock(fileName, values, 777);
+
+    FILE* f = std::fopen(fileName.c_str(), "rb");
+    {
+        ArrayFileReader reader(f);
+
+        // inside a chunk, twice for the cached chunk
+        checkRead(reader, values, 110, 20);
+        checkRead(reader, values, 130, 20);
+        checkRead(reader, values, 110, 20);
+        // a full chunk, starting and ending at the chunk boundaries
+        checkRead(reader, values, 3 * chunkSize, chunkSize);
+        checkRead(reader, values, 0, 2 * chunkSize);
+        // across the chunk boundaries
+        checkRead(reader, values, chunkSize - 1, 2);
+        checkRead(reader, values, 250, 7 * chunkSize + 3);
+        // the last partial chunk
+        checkRead(reader, values, 12 * chunkSize, 45);
+        checkRead(reader, values, 12 * chunkSize + 10, 20);
+
+        std::mt19937 generator(0);
+        for(int i = 0; i < 500; ++i)
+        {
+            const std::size_t first = generator() % n;
+            checkRead(reader, values, first, generator() % std::min<std::size_t>(n - first + 1, 4 * chunkSize));
+        }
+    }
+    std::fclose(f);
+}
+
+BOOST_AUTO_TEST_CASE(ArrayFile_legacyFormats)
+{
+    for(const std::size_t n : {0, 1, 999, 1000, 100000})
+    {
+        std::vector<double> values(n);
+        for(std::size_t i = 0; i < n; ++i)
+            values[i] = 0.25 * (i % 11);
+
+        writeLegacyRaw("arrayFile_legacyRaw.bin", values);
+        checkLoad("arrayFile_legacyRaw.bin", values);
+        if(n > 0)
+        {
+            writeLegacyCompressed("arrayFile_legacyCompressed.bin", values);
+            checkLoad("arrayFile_legacyCompressed.bin", values);
+        }
+
+        // saved raw by StaticVector
+        StaticVector<double> a;
+        a.getDataWritable() = values;
+        saveArrayToFile("arrayFile_raw.bin", &a, false);
+        checkLoad("arrayFile_raw.bin", values);
+    }
+
+    // legacy arrays of arrays: the number of arrays, then the size and the elements of each array
+    std::vector<std::vector<int>> arrays = {{1, 2, 3}, {}, {4}, {}, {5, 6}};
+    FILE* f = std::fopen("arrayFile_legacyArrays.bin", "wb");
+    int nbArrays = arrays.size();
+    std::fwrite(&nbArrays, sizeof(int), 1, f);
+    for(const std::vector<int>& array : arrays)
+    {
+        const int m = array.size();
+        std::fwrite(&m, sizeof(int), 1, f);
+        std::fwrite(array.data(), sizeof(int), m, f);
+    }
+    std::fclose(f);
+
+    StaticVector<StaticVector<int>*>* aa = loadArrayOfArraysFromFile<int>("arrayFile_legacyArrays.bin");
+    BOOST_REQUIRE_EQUAL(aa->size(), arrays.size());
+    for(std::size_t i = 0; i < arrays.size(); ++i)
+    {
+        if(arrays[i].empty())
+            BOOST_CHECK((*aa)[i] == nullptr || (*aa)[i]->empty());
+        else
+            BOOST_CHECK((*aa)[i] != nullptr && (*aa)[i]->getData() == arrays[i]);
+    }
+    deleteArrayOfArrays<int>(&aa);
+}
+
+BOOST_AUTO_TEST_CASE(ArrayFile_arrayOfArrays)
+{
+    const std::string fileName = "arrayFile_arrays.bin";
+
+    // null, empty and non-empty arrays, the values spanning several chunks
+    std::mt19937 generator(0);
+    StaticVector<StaticVector<int>*>* aa = new StaticVector<StaticVector<int>*>();
+    std::size_t nbValues = 0;
+    for(int i = 0; i < 4000; ++i)
+    {
+        if(i % 5 == 0)
+        {
+            aa->push_back(nullptr);
+            continue;
+        }
+        StaticVector<int>* a = new StaticVector<int>();
+        if(i % 5 != 1)
+            a->getDataWritable() = createValues(generator() % 500, i);
+        nbValues += a->size();
+        aa->push_back(a);
+    }
+    saveArrayOfArraysToFile(fileName, aa);
+
+    // two blocks: the sizes of the arrays, then the concatenated values
+    FILE* f = std::fopen(fileName.c_str(), "rb");
+    {
+        ArrayFileReader sizesReader(f);
+        BOOST_CHECK_EQUAL(sizesReader.getNbElements(), aa->size());
+        ArrayFileReader valuesReader(f);
+        BOOST_CHECK_EQUAL(valuesReader.getNbElements(), nbValues);
+        BOOST_CHECK(valuesReader.getNbChunks() > 2);
+    }
+    std::fclose(f);
+
+    // the null and empty arrays are loaded as null arrays
+    StaticVector<StaticVector<int>*>* loaded = loadArrayOfArraysFromFile<int>(fileName);
+    BOOST_REQUIRE_EQUAL(loaded->size(), aa->size());
+    for(int i = 0; i < aa->size(); ++i)
+    {
+        if((*aa)[i] == nullptr || (*aa)[i]->empty())
+            BOOST_CHECK((*loaded)[i] == nullptr);
+        else
+            BOOST_CHECK((*loaded)[i] != nullptr && (*loaded)[i]->getData() == (*aa)[i]->getData());
+    }
+    deleteArrayOfArrays<int>(&loaded);
+    deleteArrayOfArrays<int>(&aa);
+
+    // no array
+    aa = new StaticVector<StaticVector<int>*>();
+    saveArrayOfArraysToFile(fileName, aa);
+    loaded = loadArrayOfArraysFromFile<int>(fileName);
+    BOOST_CHECK(loaded->empty());
+    deleteArrayOfArrays<int>(&loaded);
+    deleteArrayOfArrays<int>(&aa);
+}
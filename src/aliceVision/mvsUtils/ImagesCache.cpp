@@ -5,17 +5,105 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "ImagesCache.hpp"
+#include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 
+#include <OpenEXR/half.h>
+
+#include <algorithm>
+#include <limits>
+
 namespace aliceVision {
 namespace mvsUtils {
 
-int ImagesCache::getPixelId(int x, int y, int imgid)
+ImagesCache::Img::Img(int width, int height, bool transposed, const std::vector<Color>& buffer)
+  : _width(width)
+  , _height(height)
+  , _transposed(transposed)
+{
+    const std::size_t size = static_cast<std::size_t>(width) * height;
+
+    const bool isNormalized = std::all_of(buffer.begin(), buffer.begin() + size, [](const Color& c) {
+        return c.r >= 0.0f && c.r <= 1.0f && c.g >= 0.0f && c.g <= 1.0f && c.b >= 0.0f && c.b <= 1.0f;
+    });
+
+    if(isNormalized)
+    {
+        _data8.resize(size * 3);
+        for(std::size_t i = 0; i < size; ++i)
+            for(int k = 0; k < 3; ++k)
+                _data8[i * 3 + k] = static_cast<unsigned char>(buffer[i].m[k] * 255.0f + 0.5f);
+    }
+    else
+    {
+        _data16.resize(size * 3);
+        for(std::size_t i = 0; i < size; ++i)
+            for(int k = 0; k < 3; ++k)
+                _data16[i * 3 + k] = half(buffer[i].m[k]).bits();
+    }
+}
+
+std::size_t ImagesCache::Img::getMemorySize() const
+{
+    return _data8.size() * sizeof(unsigned char) + _data16.size() * sizeof(unsigned short);
+}
+
+Color ImagesCache::Img::at(int index) const
+{
+    const std::size_t i = static_cast<std::size_t>(index) * 3;
+    if(!_data8.empty())
+    {
+        const float scale = 1.0f / 255.0f;
+        return Color(_data8[i] * scale, _data8[i + 1] * scale, _data8[i + 2] * scale);
+    }
+    half r, g, b;
+    r.setBits(_data16[i]);
+    g.setBits(_data16[i + 1]);
+    b.setBits(_data16[i + 2]);
+    return Color(r, g, b);
+}
+
+Color ImagesCache::Img::getPixel(int x, int y) const
+{
+    return at(getPixelId(x, y));
+}
+
+Color ImagesCache::Img::getInterpolateColor(const Point2d& pix) const
+{
+    const int xp = static_cast<int>(pix.x);
+    const int yp = static_cast<int>(pix.y);
+
+    // precision to 4 decimal places
+    const float ui = pix.x - static_cast<float>(xp);
+    const float vi = pix.y - static_cast<float>(yp);
+
+    const Color lu = at(getPixelId(xp,     yp    ));
+    const Color ru = at(getPixelId(xp + 1, yp    ));
+    const Color rd = at(getPixelId(xp + 1, yp + 1));
+    const Color ld = at(getPixelId(xp,     yp + 1));
+
+    // bilinear interpolation of the pixel intensity value
+    const Color u = lu + (ru - lu) * ui;
+    const Color d = ld + (rd - ld) * ui;
+    const Color out = u + (d - u) * vi;
+
+    return out;
+}
+
+rgb ImagesCache::Img::getPixelValue(const Pixel& pix) const
 {
-    if(!transposed)
-        return x * mp->getHeight(imgid) + y;
-    return y * mp->getWidth(imgid) + x;
+    const int index = getPixelId(pix.x, pix.y);
+    if(!_data8.empty())
+    {
+        const unsigned char* c = &_data8[static_cast<std::size_t>(index) * 3];
+        return rgb(c[0], c[1], c[2]);
+    }
+    const Color floatRGB = at(index) * 255.0f;
+
+    return rgb(static_cast<unsigned char>(floatRGB.r),
+               static_cast<unsigned char>(floatRGB.g),
+               static_cast<unsigned char>(floatRGB.b));
 }
 
 ImagesCache::ImagesCache(const MultiViewParams* _mp, int _bandType, bool _transposed)
@@ -39,10 +127,11 @@ ImagesCache::ImagesCache(const MultiViewParams* _mp, int _bandType, std::vector<
 void ImagesCache::initIC(int _bandType, std::vector<std::string>& _imagesNames,
                              bool _transposed)
 {
-    float oneimagemb = (sizeof(Color) * mp->getMaxImageWidth() * mp->getMaxImageHeight()) / 1024.f / 1024.f;
-    float maxmbCPU = (float)mp->_ini.get<int>("images_cache.maxmbCPU", 5000);
-    int _npreload = std::max((int)(maxmbCPU / oneimagemb), mp->_ini.get<int>("grow.minNumOfConsistentCams", 10));
-    N_PRELOADED_IMAGES = std::min(mp->ncams, _npreload);
+    // the images are stored in 8 bits per channel if possible, in half float otherwise
+    const std::size_t oneImageMaxSize = std::size_t(mp->getMaxImageWidth()) * mp->getMaxImageHeight() * 3 * sizeof(unsigned short);
+    const std::size_t maxmbCPU = mp->_ini.get<int>("images_cache.maxmbCPU", 5000);
+    const std::size_t minNbImages = mp->_ini.get<int>("grow.minNumOfConsistentCams", 10);
+    setMaxMemory(std::max(maxmbCPU * 1024 * 1024, oneImageMaxSize * minNbImages));
 
     transposed = _transposed;
     bandType = _bandType;
@@ -51,120 +140,205 @@ void ImagesCache::initIC(int _bandType, std::vector<std::string>& _imagesNames,
     {
         imagesNames.push_back(_imagesNames[rc]);
     }
+}
 
-    imgs = new Color*[N_PRELOADED_IMAGES];
-
-    camIdMapId = new StaticVector<int>();
-    camIdMapId->reserve(mp->ncams);
-    mapIdCamId = new StaticVector<int>();
-    mapIdCamId->reserve(N_PRELOADED_IMAGES);
-    mapIdClock = new StaticVector<long>();
-    mapIdClock->reserve(N_PRELOADED_IMAGES);
-
-    for(int i = 0; i < mp->ncams; ++i)
+ImagesCache::~ImagesCache()
+{
     {
-        camIdMapId->push_back(-1);
+        std::lock_guard<std::mutex> lock(_prefetchMutex);
+        _stopPrefetch = true;
+        _prefetchQueue.clear();
     }
+    _prefetchCondition.notify_all();
+    if(_prefetchThread.joinable())
+        _prefetchThread.join();
+}
 
-    for (int ni = 0; ni < N_PRELOADED_IMAGES; ++ni)
-    {
-        imgs[ni] = nullptr;
-
-        (*camIdMapId)[ni] = -1;
-        mapIdCamId->push_back(-1);
-        mapIdClock->push_back(clock());
-    }
+void ImagesCache::setMaxMemory(std::size_t maxMemory)
+{
+    _maxMemory = maxMemory;
+    evict();
 }
 
-ImagesCache::~ImagesCache()
+ImagesCache::ImgSharedPtr ImagesCache::getImg(int camId)
 {
-    for(int ni = 0; ni < N_PRELOADED_IMAGES; ni++)
+    Shard& shard = getShard(camId);
+    std::shared_future<ImgSharedPtr> img;
+    std::promise<ImgSharedPtr> promise;
+    bool load = false;
     {
-        delete[] imgs[ni];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(camId);
+        if(it == shard.entries.end())
+        {
+            // this thread loads the image, the other ones wait for it
+            load = true;
+            it = shard.entries.emplace(camId, Entry()).first;
+            it->second.img = promise.get_future().share();
+            shard.lru.push_front(camId);
+            it->second.lruIt = shard.lru.begin();
+        }
+        else
+        {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lruIt);
+        }
+        it->second.lastUse = ++_clock;
+        img = it->second.img;
     }
-    delete[] imgs;
 
-    delete camIdMapId;
-    delete mapIdCamId;
-    delete mapIdClock;
+    if(load)
+        loadImg(camId, promise);
+
+    // throw the loading error, if any
+    return img.get();
 }
 
-void ImagesCache::refreshData(int camId)
+void ImagesCache::loadImg(int camId, std::promise<ImgSharedPtr>& promise)
 {
-    // printf("camId %i\n",camId);
-    // test if the image is in the memory
-    if((*camIdMapId)[camId] == -1)
+    Shard& shard = getShard(camId);
+    try
     {
-        // remove the oldest one
-        int mapId = mapIdClock->minValId();
-        int oldCamId = (*mapIdCamId)[mapId];
-        if(oldCamId>=0)
-            (*camIdMapId)[oldCamId] = -1;
-
-        // replace with new new
-        (*camIdMapId)[camId] = mapId;
-        (*mapIdCamId)[mapId] = camId;
-        (*mapIdClock)[mapId] = clock();
-
-        // reload data from files
-        long t1 = clock();
-        if (imgs[mapId] == nullptr)
-        {
-            const std::size_t maxSize = mp->getMaxImageWidth() * mp->getMaxImageHeight();
-            imgs[mapId] = new Color[maxSize];
-        }
+        const long t1 = clock();
+        const std::string& imagePath = imagesNames.at(camId);
+        const int width = mp->getWidth(camId);
+        const int height = mp->getHeight(camId);
 
-        std::string imagePath = imagesNames.at(camId);
-        memcpyRGBImageFromFileToArr(camId, imgs[mapId], imagePath, mp, transposed, bandType);
+        std::vector<Color> buffer(std::size_t(width) * height);
+        memcpyRGBImageFromFileToArr(camId, buffer.data(), imagePath, mp, transposed, bandType);
+        ImgSharedPtr img = std::make_shared<const Img>(width, height, transposed, buffer);
 
         if(mp->verbose)
         {
             std::string basename = imagePath.substr(imagePath.find_last_of("/\\") + 1);
             printfElapsedTime(t1, "add "+ basename +" to image cache");
         }
+
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            Entry& entry = shard.entries.at(camId);
+            entry.memorySize = img->getMemorySize();
+            _memoryUsed += entry.memorySize;
+        }
+        promise.set_value(img);
     }
+    catch(...)
+    {
+        // the next request of this image loads it again
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(camId);
+            shard.lru.erase(it->second.lruIt);
+            shard.entries.erase(it);
+        }
+        promise.set_exception(std::current_exception());
+        return;
+    }
+    evict();
 }
 
-Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
+void ImagesCache::evict()
 {
-    refreshData(camId);
+    std::lock_guard<std::mutex> evictionLock(_evictionMutex);
 
-    // get the image index in the memory
-    const int i = (*camIdMapId)[camId];
-    const Color* img = imgs[i];
-    
-    const int xp = static_cast<int>(pix->x);
-    const int yp = static_cast<int>(pix->y);
+    while(_memoryUsed > _maxMemory)
+    {
+        // find the least recently used image among the shards,
+        // the images being loaded are not evicted
+        int oldestShard = -1;
+        int oldestCamId = -1;
+        long oldestUse = std::numeric_limits<long>::max();
 
-    // precision to 4 decimal places
-    const float ui = pix->x - static_cast<float>(xp);
-    const float vi = pix->y - static_cast<float>(yp);
+        for(int s = 0; s < nbShards; ++s)
+        {
+            Shard& shard = _shards[s];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for(auto it = shard.lru.rbegin(); it != shard.lru.rend(); ++it)
+            {
+                const Entry& entry = shard.entries.at(*it);
+                if(entry.memorySize == 0)
+                    continue;
+                if(entry.lastUse < oldestUse)
+                {
+                    oldestShard = s;
+                    oldestCamId = *it;
+                    oldestUse = entry.lastUse;
+                }
+                break;
+            }
+        }
 
-    const Color lu = img[getPixelId(xp,     yp,     camId)];
-    const Color ru = img[getPixelId(xp + 1, yp,     camId)];
-    const Color rd = img[getPixelId(xp + 1, yp + 1, camId)];
-    const Color ld = img[getPixelId(xp,     yp + 1, camId)];
+        if(oldestShard < 0)
+            break;
 
-    // bilinear interpolation of the pixel intensity value
-    const Color u = lu + (ru - lu) * ui;
-    const Color d = ld + (rd - ld) * ui;
-    const Color out = u + (d - u) * vi;
+        Shard& shard = _shards[oldestShard];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(oldestCamId);
+        // the image may have been evicted by a failed reload in the meantime
+        if(it == shard.entries.end() || it->second.memorySize == 0)
+            continue;
+        _memoryUsed -= it->second.memorySize;
+        shard.lru.erase(it->second.lruIt);
+        shard.entries.erase(it);
+    }
+}
 
-    return out;
+void ImagesCache::prefetch(int camId)
+{
+    {
+        Shard& shard = getShard(camId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if(shard.entries.count(camId))
+            return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_prefetchMutex);
+        if(!_prefetchThread.joinable())
+            _prefetchThread = std::thread(&ImagesCache::prefetchWorker, this);
+        _prefetchQueue.push_back(camId);
+    }
+    _prefetchCondition.notify_one();
 }
 
-rgb ImagesCache::getPixelValue(const Pixel& pix, int camId)
+void ImagesCache::prefetchWorker()
 {
-    refreshData(camId);
+    while(true)
+    {
+        int camId;
+        {
+            std::unique_lock<std::mutex> lock(_prefetchMutex);
+            _prefetchCondition.wait(lock, [this] { return _stopPrefetch || !_prefetchQueue.empty(); });
+            if(_stopPrefetch)
+                return;
+            camId = _prefetchQueue.front();
+            _prefetchQueue.pop_front();
+        }
 
-    // get the image index in the memory
-    const int imageId = (*camIdMapId)[camId];
-    const Color* img = imgs[imageId];
-    const Color floatRGB = img[getPixelId(pix.x, pix.y, camId)] * 255.0f;
+        try
+        {
+            getImg(camId);
+        }
+        catch(const std::exception& e)
+        {
+            // the error is reported to the thread requesting this image
+            ALICEVISION_LOG_DEBUG("Cannot prefetch the image of the camera " << camId << ": " << e.what());
+        }
+    }
+}
 
-    return rgb(static_cast<unsigned char>(floatRGB.r),
-               static_cast<unsigned char>(floatRGB.g),
-               static_cast<unsigned char>(floatRGB.b));
+void ImagesCache::refreshData(int camId)
+{
+    getImg(camId);
+}
+
+Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
+{
+    return getImg(camId)->getInterpolateColor(*pix);
+}
+
+rgb ImagesCache::getPixelValue(const Pixel& pix, int camId)
+{
+    return getImg(camId)->getPixelValue(pix);
 }
 
 } // namespace mvsUtils
@@ -7,25 +7,95 @@
 #pragma once
 
 #include <aliceVision/mvsData/Color.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace aliceVision {
 namespace mvsUtils {
 
+/**
+ * @brief Thread-safe cache of the camera images, limited by a memory budget.
+ *
+ * The images are given as reference-counted handles: an image stays valid
+ * as long as a handle is held, even if the cache has evicted it.
+ * The least recently used images are evicted when the memory budget is exceeded.
+ * The cache is split in shards locked independently, and an image is loaded
+ * without holding any lock: the other threads only wait for the images they need.
+ * The next cameras can be prefetched, they are then loaded in a background thread.
+ */
 class ImagesCache
 {
 public:
-    const MultiViewParams* mp;
+    /**
+     * @brief Image of the cache.
+     * The colors are stored with 8 bits per channel if they are in [0;1], in half float otherwise
+     * (band-filtered images or high dynamic range images).
+     */
+    class Img
+    {
+    public:
+        /**
+         * @brief Build a compact image
+         * @param[in] width the image width
+         * @param[in] height the image height
+         * @param[in] transposed the buffer layout (see ImagesCache)
+         * @param[in] buffer the colors of the image
+         */
+        Img(int width, int height, bool transposed, const std::vector<Color>& buffer);
+
+        int getWidth() const { return _width; }
+        int getHeight() const { return _height; }
+
+        /// @return the memory used by the pixels in bytes
+        std::size_t getMemorySize() const;
+
+        Color getPixel(int x, int y) const;
+
+        /// @return the color at the given position, with a bilinear interpolation
+        Color getInterpolateColor(const Point2d& pix) const;
+
+        /// @return the color of the given pixel in [0;255]
+        rgb getPixelValue(const Pixel& pix) const;
+
+    private:
+        int getPixelId(int x, int y) const
+        {
+            if(!_transposed)
+                return x * _height + y;
+            return y * _width + x;
+        }
 
-    int N_PRELOADED_IMAGES;
-    Color** imgs;
+        Color at(int index) const;
 
-    StaticVector<int>* camIdMapId;
-    StaticVector<int>* mapIdCamId;
-    StaticVector<long>* mapIdClock;
+        int _width;
+        int _height;
+        bool _transposed;
+        /// colors in [0;255], if all the channels are in [0;1]
+        std::vector<unsigned char> _data8;
+        /// half float bits of the colors otherwise
+        std::vector<unsigned short> _data16;
+    };
+
+    typedef std::shared_ptr<const Img> ImgSharedPtr;
+
+    const MultiViewParams* mp;
     std::vector<std::string> imagesNames;
 
     int bandType;
@@ -34,13 +104,87 @@ public:
     ImagesCache(const MultiViewParams* _mp, int _bandType, bool _transposed = false);
     ImagesCache(const MultiViewParams* _mp, int _bandType, std::vector<std::string>& _imagesNames,
                     bool _transposed = false);
-    void initIC(int _bandType, std::vector<std::string>& _imagesNames, bool _transposed);
     ~ImagesCache();
 
-    int getPixelId(int x, int y, int imgid);
+    ImagesCache(const ImagesCache&) = delete;
+    ImagesCache& operator=(const ImagesCache&) = delete;
+
+    /**
+     * @brief Set the memory budget of the cache in bytes.
+     * The default budget is given by "images_cache.maxmbCPU" (in MB),
+     * with room for at least "grow.minNumOfConsistentCams" images.
+     */
+    void setMaxMemory(std::size_t maxMemory);
+    std::size_t getMaxMemory() const { return _maxMemory; }
+
+    /// @return the memory used by the images of the cache in bytes
+    std::size_t getMemoryUsed() const { return _memoryUsed; }
+
+    /**
+     * @brief Get an image, loaded if it is not in the cache.
+     * If the image is being loaded by another thread, wait for it.
+     * @param[in] camId the camera index
+     * @return a handle on the image
+     */
+    ImgSharedPtr getImg(int camId);
+
+    /**
+     * @brief Load an image in a background thread, if it is not in the cache.
+     * @param[in] camId the camera index
+     */
+    void prefetch(int camId);
+
+    /// Load an image if it is not in the cache
     void refreshData(int camId);
+
     Color getPixelValueInterpolated(const Point2d* pix, int camId);
     rgb getPixelValue(const Pixel& pix, int camId);
+
+private:
+    struct Entry
+    {
+        std::shared_future<ImgSharedPtr> img;
+        /// memory used by the image, 0 while it is loading
+        std::size_t memorySize = 0;
+        /// last use of the image, to find the least recently used one among the shards
+        long lastUse = 0;
+        std::list<int>::iterator lruIt;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::map<int, Entry> entries;
+        /// camera indexes, most recently used first
+        std::list<int> lru;
+    };
+
+    static const int nbShards = 16;
+
+    void initIC(int _bandType, std::vector<std::string>& _imagesNames, bool _transposed);
+
+    Shard& getShard(int camId) { return _shards[camId % nbShards]; }
+
+    /// Load an image and give it to the threads waiting for it
+    void loadImg(int camId, std::promise<ImgSharedPtr>& promise);
+
+    /// Evict the least recently used images until the memory budget is respected
+    void evict();
+
+    void prefetchWorker();
+
+    std::array<Shard, nbShards> _shards;
+    std::size_t _maxMemory = 0;
+    std::atomic<std::size_t> _memoryUsed{0};
+    std::atomic<long> _clock{0};
+    /// only one thread evicts images at a time
+    std::mutex _evictionMutex;
+
+    std::thread _prefetchThread;
+    std::mutex _prefetchMutex;
+    std::condition_variable _prefetchCondition;
+    std::deque<int> _prefetchQueue;
+    bool _stopPrefetch = false;
 };
 
 } // namespace mvsUtils
@@ -0,0 +1,234 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/imageIO/image.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE imagesCache
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mvsUtils;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const int imageWidth = 64;
+const int imageHeight = 48;
+
+/// Color of a pixel of the image of a camera, in [0;1]
+Color getColor(int camId, int x, int y)
+{
+    return Color(static_cast<float>((x + camId) % imageWidth) / 255.0f, static_cast<float>(y) / 255.0f,
+                 static_cast<float>(camId) / 255.0f);
+}
+
+/**
+ * @brief Multi-view parameters of nbCameras cameras along x, loaded from an ini file
+ * and images with the AliceVision:P metadata. The image of each camera is given by getColor.
+ */
+std::unique_ptr<MultiViewParams> createMultiViewParams(const std::string& folder, int nbCameras)
+{
+    bfs::create_directories(folder);
+    {
+        std::ofstream ini((bfs::path(folder) / "mvs.ini").string());
+        ini << "[global]\n"
+            << "ncams=" << nbCameras << "\n"
+            << "imgExt=exr\n"
+            << "verbose=0\n"
+            << "[imageResolutions]\n";
+        for(int c = 0; c < nbCameras; ++c)
+            ini << c << "=" << imageWidth << "x" << imageHeight << "\n";
+    }
+
+    Matrix3x3 K;
+    K.m11 = 100.0; K.m12 = 0.0;   K.m13 = imageWidth / 2;
+    K.m21 = 0.0;   K.m22 = 100.0; K.m23 = imageHeight / 2;
+    K.m31 = 0.0;   K.m32 = 0.0;   K.m33 = 1.0;
+    Matrix3x3 R;
+    R.m11 = 1.0; R.m12 = 0.0; R.m13 = 0.0;
+    R.m21 = 0.0; R.m22 = 1.0; R.m23 = 0.0;
+    R.m31 = 0.0; R.m32 = 0.0; R.m33 = 1.0;
+
+    for(int c = 0; c < nbCameras; ++c)
+    {
+        const Matrix3x4 P = K * (R | Point3d(-0.1 * c, 0.0, 0.0));
+
+        std::vector<Color> image(imageWidth * imageHeight);
+        for(int y = 0; y < imageHeight; ++y)
+            for(int x = 0; x < imageWidth; ++x)
+                image[y * imageWidth + x] = getColor(c, x, y);
+
+        std::vector<double> matrixP(16, 0.0);
+        std::copy_n(P.m, 12, matrixP.begin());
+        matrixP[15] = 1.0;
+        oiio::ParamValueList metadata;
+        metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
+        metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, matrixP.data()));
+        imageIO::writeImage((bfs::path(folder) / (std::to_string(c) + ".exr")).string(), imageWidth, imageHeight,
+                            image, imageIO::EImageQuality::LOSSLESS, metadata);
+    }
+
+    return std::unique_ptr<MultiViewParams>(new MultiViewParams((bfs::path(folder) / "mvs.ini").string()));
+}
+
+void checkImage(const ImagesCache::Img& img, int camId)
+{
+    BOOST_REQUIRE_EQUAL(img.getWidth(), imageWidth);
+    BOOST_REQUIRE_EQUAL(img.getHeight(), imageHeight);
+    for(int y = 0; y < imageHeight; ++y)
+    {
+        for(int x = 0; x < imageWidth; ++x)
+        {
+            const rgb value = img.getPixelValue(Pixel(x, y));
+            const Color expected = getColor(camId, x, y) * 255.0f;
+            BOOST_CHECK_EQUAL(value.r, static_cast<unsigned char>(expected.r + 0.5f));
+            BOOST_CHECK_EQUAL(value.g, static_cast<unsigned char>(expected.g + 0.5f));
+            BOOST_CHECK_EQUAL(value.b, static_cast<unsigned char>(expected.b + 0.5f));
+        }
+    }
+}
+
+/// Round trip of the colors through an Img of both layouts, within the given tolerance per channel
+void checkRoundTrip(const std::vector<Color>& colors, std::size_t expectedMemorySize,
+                    float (*tolerance)(float value))
+{
+    for(const bool transposed : {false, true})
+    {
+        std::vector<Color> buffer(colors.size());
+        for(int y = 0; y < imageHeight; ++y)
+            for(int x = 0; x < imageWidth; ++x)
+                buffer[transposed ? y * imageWidth + x : x * imageHeight + y] = colors[y * imageWidth + x];
+
+        const ImagesCache::Img img(imageWidth, imageHeight, transposed, buffer);
+        BOOST_CHECK_EQUAL(img.getMemorySize(), expectedMemorySize);
+
+        for(int y = 0; y < imageHeight; ++y)
+        {
+            for(int x = 0; x < imageWidth; ++x)
+            {
+                const Color& expected = colors[y * imageWidth + x];
+                const Color color = img.getPixel(x, y);
+                for(int k = 0; k < 3; ++k)
+                    BOOST_CHECK_SMALL(color.m[k] - expected.m[k], tolerance(expected.m[k]));
+            }
+        }
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(imagesCache_imgStorage)
+{
+    std::mt19937 generator(42);
+    const std::size_t nbPixels = imageWidth * imageHeight;
+
+    // colors in [0;1] are stored in 8 bits per channel
+    {
+        std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+        std::vector<Color> colors(nbPixels);
+        for(Color& c : colors)
+            c = Color(distribution(generator), distribution(generator), distribution(generator));
+        checkRoundTrip(colors, nbPixels * 3, [](float) { return 0.5f / 255.0f + 1e-6f; });
+    }
+
+    // high dynamic range or band-filtered colors are stored in half float
+    {
+        std::uniform_real_distribution<float> distribution(-2.0f, 100.0f);
+        std::vector<Color> colors(nbPixels);
+        for(Color& c : colors)
+            c = Color(distribution(generator), distribution(generator), distribution(generator));
+        // half float has an 11 bits significand
+        checkRoundTrip(colors, nbPixels * 3 * sizeof(unsigned short),
+                       [](float value) { return std::max(std::abs(value) * std::pow(2.0f, -11.0f), 1e-6f); });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(imagesCache_eviction)
+{
+    const std::string folder = "imagesCache_eviction";
+    const int nbCameras = 6;
+    const std::unique_ptr<MultiViewParams> mp = createMultiViewParams(folder, nbCameras);
+    const std::size_t imageMemorySize = imageWidth * imageHeight * 3;
+
+    ImagesCache ic(mp.get(), 0);
+    ic.setMaxMemory(3 * imageMemorySize);
+
+    // the handles stay valid after the eviction of their image
+    std::vector<ImagesCache::ImgSharedPtr> handles;
+    for(int c = 0; c < nbCameras; ++c)
+    {
+        handles.push_back(ic.getImg(c));
+        BOOST_CHECK_LE(ic.getMemoryUsed(), ic.getMaxMemory());
+    }
+    BOOST_CHECK_EQUAL(ic.getMemoryUsed(), 3 * imageMemorySize);
+    for(int c = 0; c < nbCameras; ++c)
+        checkImage(*handles[c], c);
+
+    // the 3 last images are in the cache, the least recently used one is evicted first
+    for(int c = nbCameras - 3; c < nbCameras; ++c)
+        BOOST_CHECK_EQUAL(ic.getImg(c), handles[c]);
+    BOOST_CHECK_EQUAL(ic.getImg(nbCameras - 3), handles[nbCameras - 3]);
+    const ImagesCache::ImgSharedPtr reloaded = ic.getImg(0);
+    BOOST_CHECK_NE(reloaded, handles[0]);
+    checkImage(*reloaded, 0);
+    BOOST_CHECK_EQUAL(ic.getImg(nbCameras - 3), handles[nbCameras - 3]);
+    BOOST_CHECK_EQUAL(ic.getImg(nbCameras - 1), handles[nbCameras - 1]);
+    BOOST_CHECK_NE(ic.getImg(nbCameras - 2), handles[nbCameras - 2]);
+    BOOST_CHECK_LE(ic.getMemoryUsed(), ic.getMaxMemory());
+
+    // a lower budget evicts images right away
+    ic.setMaxMemory(imageMemorySize);
+    BOOST_CHECK_EQUAL(ic.getMemoryUsed(), imageMemorySize);
+    ic.setMaxMemory(0);
+    BOOST_CHECK_EQUAL(ic.getMemoryUsed(), 0);
+
+    bfs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(imagesCache_concurrentGetImg)
+{
+    const std::string folder = "imagesCache_concurrentGetImg";
+    const int nbCameras = 2;
+    const std::unique_ptr<MultiViewParams> mp = createMultiViewParams(folder, nbCameras);
+    const std::size_t imageMemorySize = imageWidth * imageHeight * 3;
+
+    ImagesCache ic(mp.get(), 0);
+
+    // the threads requesting the same image wait for a single load
+    const int nbThreads = 8;
+    for(int c = 0; c < nbCameras; ++c)
+    {
+        std::vector<ImagesCache::ImgSharedPtr> images(nbThreads);
+        std::vector<std::thread> threads;
+        for(int t = 0; t < nbThreads; ++t)
+            threads.emplace_back([&ic, &images, c, t] { images[t] = ic.getImg(c); });
+        for(std::thread& thread : threads)
+            thread.join();
+
+        BOOST_REQUIRE(images[0] != nullptr);
+        checkImage(*images[0], c);
+        for(int t = 1; t < nbThreads; ++t)
+            BOOST_CHECK_EQUAL(images[t], images[0]);
+        BOOST_CHECK_EQUAL(ic.getMemoryUsed(), (c + 1) * imageMemorySize);
+    }
+
+    bfs::remove_all(folder);
+}
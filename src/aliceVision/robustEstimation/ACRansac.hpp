@@ -41,10 +41,12 @@
 #include <iterator>
 #include <limits>
 #include <numeric>
+#include <random>
 #include <vector>
 
 #include <aliceVision/robustEstimation/randSampling.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 namespace aliceVision {
 namespace robustEstimation{
@@ -116,11 +118,12 @@ void makelogcombi
 /// NFA and associated index
 typedef std::pair<double,size_t> ErrorIndex;
 
-/// Find best NFA and its index wrt square error threshold in e.
+/// Find best NFA and its index wrt square error threshold in the first nbResiduals elements of e.
 inline ErrorIndex bestNFA(
   int startIndex, //number of point required for estimation
   double logalpha0,
   const std::vector<ErrorIndex>& e,
+  size_t nbResiduals,
   double loge0,
   double maxThreshold,
   const std::vector<float> &logc_n,
@@ -128,7 +131,7 @@ inline ErrorIndex bestNFA(
   double multError = 1.0)
 {
   ErrorIndex bestIndex(std::numeric_limits<double>::infinity(), startIndex);
-  const size_t n = e.size();
+  const size_t n = nbResiduals;
   for(size_t k = startIndex + 1; k <= n && e[k - 1].first <= maxThreshold; ++k)
   {
     const double logalpha = logalpha0 +
@@ -144,16 +147,97 @@ inline ErrorIndex bestNFA(
   return bestIndex;
 }
 
+/// Find best NFA and its index wrt square error threshold in e.
+inline ErrorIndex bestNFA(
+  int startIndex, //number of point required for estimation
+  double logalpha0,
+  const std::vector<ErrorIndex>& e,
+  double loge0,
+  double maxThreshold,
+  const std::vector<float> &logc_n,
+  const std::vector<float> &logc_k,
+  double multError = 1.0)
+{
+  return bestNFA(startIndex, logalpha0, e, e.size(), loge0, maxThreshold, logc_n, logc_k, multError);
+}
+
+/**
+ * @brief Order the residuals and find the best NFA, without sorting the residuals which cannot give it.
+ *
+ * bestNFA only scans the residuals below maxThreshold. Moreover, a residual with a positive log(alpha)
+ * can only give a NFA greater than loge0, so these residuals are sorted only if neither the smaller
+ * residuals nor the best NFA found so far give a NFA lower than loge0.
+ * Compared to a full sort followed by bestNFA, the result and the order of the inliers are the same
+ * whenever the returned NFA is lower than minNFA.
+ *
+ * @param[in,out] e residuals [residual,index], the inliers of the returned NFA are sorted at the beginning
+ * @param[in] minNFA best NFA found so far
+ */
+inline ErrorIndex sortAndFindBestNFA(
+  int startIndex,
+  double logalpha0,
+  std::vector<ErrorIndex>& e,
+  double loge0,
+  double maxThreshold,
+  const std::vector<float> &logc_n,
+  const std::vector<float> &logc_k,
+  double multError,
+  double minNFA)
+{
+  // log(alpha) is positive above this error (with a margin for the rounding errors)
+  double positiveAlphaError = std::numeric_limits<double>::infinity();
+  if(multError > 0.0)
+    positiveAlphaError = std::pow(10.0, -logalpha0 / multError) * (1.0 + 1e-6);
+
+  const auto prefixEnd = std::partition(e.begin(), e.end(), [&](const ErrorIndex& r)
+  {
+    return r.first <= maxThreshold && r.first < positiveAlphaError;
+  });
+  std::sort(e.begin(), prefixEnd);
+
+  const size_t nbPrefix = std::distance(e.begin(), prefixEnd);
+  const ErrorIndex best = bestNFA(startIndex, logalpha0, e, nbPrefix, loge0, maxThreshold, logc_n, logc_k, multError);
+
+  if(nbPrefix == e.size() ||
+     positiveAlphaError > maxThreshold || // the other residuals are above maxThreshold
+     std::min(best.first, minNFA) <= loge0)
+    return best;
+
+  std::sort(prefixEnd, e.end());
+  return bestNFA(startIndex, logalpha0, e, loge0, maxThreshold, logc_n, logc_k, multError);
+}
+
+/// Sample and models of an ACRANSAC iteration, with the scores of the models
+template<typename Model>
+struct ACRansacHypothesis
+{
+  std::vector<std::size_t> sample;
+  std::vector<Model> models;
+  /// number of residuals below the maximum threshold of each model
+  std::vector<std::size_t> nbInliers;
+  /// best NFA of each model
+  std::vector<ErrorIndex> bestNFAs;
+  /// inliers and error threshold of each model, only if it may improve the best NFA
+  std::vector<std::vector<std::size_t>> inliers;
+  std::vector<double> errorsMax;
+};
 
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
  *
+ * The hypotheses can be evaluated in parallel: the samples of nbParallelHypotheses iterations are drawn,
+ * their models are scored in parallel, then the scores are used in the order of the iterations.
+ * When the sampling set changes, the remaining hypotheses are discarded, so the result only
+ * depends on the random number generator and on nbParallelHypotheses (not on the number of threads).
+ *
  * @param[in] kernel model and metric object
  * @param[out] vec_inliers points that fit the estimated model
  * @param[in] nIter maximum number of consecutive iterations
  * @param[out] model returned model if found
  * @param[in] precision upper bound of the precision (squared error)
  * @param[in] bVerbose display console log
+ * @param[in] nbParallelHypotheses number of hypotheses evaluated together
+ * @param[in,out] randomNumberGenerator generator of the samples (if nullptr, a randomly seeded one is used)
  *
  * @return (errorMax, minNFA)
  */
@@ -163,7 +247,9 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
   size_t nIter = 1024,
   typename Kernel::Model * model = nullptr,
   double precision = std::numeric_limits<double>::infinity(),
-  bool bVerbose = false)
+  bool bVerbose = false,
+  size_t nbParallelHypotheses = 1,
+  std::mt19937 * randomNumberGenerator = nullptr)
 {
   vec_inliers.clear();
 
@@ -176,9 +262,6 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
     std::numeric_limits<double>::infinity() :
     precision * kernel.normalizer2()(0,0) * kernel.normalizer2()(0,0);
 
-  std::vector<ErrorIndex> vec_residuals(nData); // [residual,index]
-  std::vector<double> vec_residuals_(nData);
-
   // Possible sampling indices [0,..,nData] (will change in the optimization phase)
   std::vector<size_t> vec_index(nData);
   std::iota(vec_index.begin(), vec_index.end(), 0);
@@ -198,102 +281,160 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
 
   bool bACRansacMode = (precision == std::numeric_limits<double>::infinity());
 
-  // Main estimation loop.
-  for (size_t iter=0; iter < nIter; ++iter)
+  std::mt19937 defaultGenerator;
+  if(randomNumberGenerator == nullptr)
   {
-    std::vector< std::size_t> vec_sample(sizeSample); // Sample indices
-    if (bACRansacMode)
-      UniformSample(sizeSample, vec_index, vec_sample); // Get random sample
-    else
-      UniformSample(sizeSample, nData, vec_sample); // Get random sample
+    std::random_device rd;
+    defaultGenerator.seed(rd());
+    randomNumberGenerator = &defaultGenerator;
+  }
 
-    std::vector<typename Kernel::Model> vec_models; // Up to max_models solutions
-    kernel.Fit(vec_sample, &vec_models);
+  // Hypotheses evaluated together and residuals buffers of each thread
+  nbParallelHypotheses = std::max<size_t>(1, nbParallelHypotheses);
+  const int nbThreads = std::max(1, std::min<int>(omp_get_max_threads(), nbParallelHypotheses));
+  std::vector<ACRansacHypothesis<typename Kernel::Model>> hypotheses(nbParallelHypotheses);
+  std::vector<std::vector<double>> vec_residuals_(nbThreads, std::vector<double>(nData));
+  std::vector<std::vector<ErrorIndex>> vec_residuals(nbThreads, std::vector<ErrorIndex>(nData)); // [residual,index]
+
+  // Main estimation loop.
+  size_t iter = 0;
+  bool stop = false;
+  while (iter < nIter && !stop)
+  {
+    const int nbHypotheses = std::min(nbParallelHypotheses, nIter - iter);
+    for (int h = 0; h < nbHypotheses; ++h)
+    {
+      // the sampling set is the whole data until the ACRANSAC mode, so both draws are equivalent
+      if (bACRansacMode)
+        UniformSample(sizeSample, vec_index, hypotheses[h].sample, *randomNumberGenerator); // Get random sample
+      else
+        UniformSample(sizeSample, nData, hypotheses[h].sample, *randomNumberGenerator); // Get random sample
+    }
 
     // Evaluate models
-    bool better = false;
-    for (size_t k = 0; k < vec_models.size(); ++k)
+    const double iterMinNFA = minNFA;
+    #pragma omp parallel for num_threads(nbThreads) if(nbHypotheses > 1)
+    for (int h = 0; h < nbHypotheses; ++h)
     {
-      // Residuals computation and ordering
-      kernel.Errors(vec_models[k], vec_residuals_);
+      ACRansacHypothesis<typename Kernel::Model>& hypothesis = hypotheses[h];
+      std::vector<double>& residuals = vec_residuals_[omp_get_thread_num()];
+      std::vector<ErrorIndex>& sortedResiduals = vec_residuals[omp_get_thread_num()];
+
+      hypothesis.models.clear(); // Up to max_models solutions
+      kernel.Fit(hypothesis.sample, &hypothesis.models);
+
+      const size_t nbModels = hypothesis.models.size();
+      hypothesis.nbInliers.assign(nbModels, 0);
+      hypothesis.bestNFAs.resize(nbModels);
+      hypothesis.inliers.resize(nbModels);
+      hypothesis.errorsMax.resize(nbModels);
 
-      if (!bACRansacMode)
+      for (size_t k = 0; k < nbModels; ++k)
       {
-        unsigned int nInlier = 0;
-        for (size_t i = 0; i < nData; ++i)
+        // Residuals computation and ordering
+        kernel.Errors(hypothesis.models[k], residuals);
+
+        if (maxThreshold != std::numeric_limits<double>::infinity())
         {
-          if (vec_residuals_[i] <= maxThreshold)
-            ++nInlier;
+          for (size_t i = 0; i < nData; ++i)
+          {
+            if (residuals[i] <= maxThreshold)
+              ++hypothesis.nbInliers[k];
+          }
         }
-        if (nInlier > 2.5 * sizeSample) // does the model is meaningful
-          bACRansacMode = true;
-      }
-      if (bACRansacMode)
-      {
         for (size_t i = 0; i < nData; ++i)
-        {
-          const double error = vec_residuals_[i];
-          vec_residuals[i] = ErrorIndex(error, i);
-        }
-        std::sort(vec_residuals.begin(), vec_residuals.end());
+          sortedResiduals[i] = ErrorIndex(residuals[i], i);
 
         // Most meaningful discrimination inliers/outliers
-        const ErrorIndex best = bestNFA(
+        const ErrorIndex best = sortAndFindBestNFA(
           sizeSample,
           kernel.logalpha0(),
-          vec_residuals,
+          sortedResiduals,
           loge0,
           maxThreshold,
           vec_logc_n,
           vec_logc_k,
-          kernel.multError());
+          kernel.multError(),
+          iterMinNFA);
 
-        if (best.first < minNFA /*&& vec_residuals[best.second-1].first < errorMax*/)
+        hypothesis.bestNFAs[k] = best;
+        hypothesis.inliers[k].clear();
+        if (best.first < iterMinNFA)
         {
-          // A better model was found
-          better = true;
-          minNFA = best.first;
-          vec_inliers.resize(best.second);
+          hypothesis.inliers[k].resize(best.second);
           for (size_t i=0; i<best.second; ++i)
-            vec_inliers[i] = vec_residuals[i].second;
-          errorMax = vec_residuals[best.second-1].first; // Error threshold
-          if(model) *model = vec_models[k];
+            hypothesis.inliers[k][i] = sortedResiduals[i].second;
+          hypothesis.errorsMax[k] = sortedResiduals[best.second-1].first; // Error threshold
+        }
+      }
+    }
 
-          if(bVerbose)
+    // Use the scores in the order of the iterations
+    for (int h = 0; h < nbHypotheses; ++h, ++iter)
+    {
+      const ACRansacHypothesis<typename Kernel::Model>& hypothesis = hypotheses[h];
+      bool better = false;
+      for (size_t k = 0; k < hypothesis.models.size(); ++k)
+      {
+        if (!bACRansacMode)
+        {
+          if (hypothesis.nbInliers[k] > 2.5 * sizeSample) // does the model is meaningful
+            bACRansacMode = true;
+        }
+        if (bACRansacMode)
+        {
+          const ErrorIndex& best = hypothesis.bestNFAs[k];
+          if (best.first < minNFA /*&& vec_residuals[best.second-1].first < errorMax*/)
           {
-            ALICEVISION_LOG_DEBUG("  nfa=" << minNFA
-              << " inliers=" << best.second << "/" << nData
-              << " precisionNormalized=" << errorMax
-              << " precision=" << kernel.unormalizeError(errorMax)
-              << " (iter=" << iter
-              << ",sample=" << vec_sample
-              << ")");
+            // A better model was found
+            better = true;
+            minNFA = best.first;
+            vec_inliers = hypothesis.inliers[k];
+            errorMax = hypothesis.errorsMax[k];
+            if(model) *model = hypothesis.models[k];
+
+            if(bVerbose)
+            {
+              ALICEVISION_LOG_DEBUG("  nfa=" << minNFA
+                << " inliers=" << best.second << "/" << nData
+                << " precisionNormalized=" << errorMax
+                << " precision=" << kernel.unormalizeError(errorMax)
+                << " (iter=" << iter
+                << ",sample=" << hypothesis.sample
+                << ")");
+            }
           }
-        }
-      } //if(bACRansacMode)
-    } //for(size_t k...
-    
-    // Early exit test -> no meaningful model found after nIterReserve*2 iterations
-    if (!bACRansacMode && iter > nIterReserve*2)
-      break;
-
-    // ACRANSAC optimization: draw samples among best set of inliers so far
-    if (bACRansacMode && ((better && minNFA<0) || (iter+1==nIter && nIterReserve)))
-    {
-      if (vec_inliers.empty())
+        } //if(bACRansacMode)
+      } //for(size_t k...
+
+      // Early exit test -> no meaningful model found after nIterReserve*2 iterations
+      if (!bACRansacMode && iter > nIterReserve*2)
       {
-        // No model found at all so far
-        ++nIter; // Continue to look for any model, even not meaningful
-        --nIterReserve;
+        stop = true;
+        break;
       }
-      else
+
+      // ACRANSAC optimization: draw samples among best set of inliers so far
+      if (bACRansacMode && ((better && minNFA<0) || (iter+1==nIter && nIterReserve)))
       {
-        // ACRANSAC optimization: draw samples among best set of inliers so far
-        vec_index = vec_inliers;
-        if(nIterReserve)
+        if (vec_inliers.empty())
         {
-          nIter = iter + 1 + nIterReserve;
-          nIterReserve = 0;
+          // No model found at all so far
+          ++nIter; // Continue to look for any model, even not meaningful
+          --nIterReserve;
+        }
+        else
+        {
+          // ACRANSAC optimization: draw samples among best set of inliers so far
+          vec_index = vec_inliers;
+          if(nIterReserve)
+          {
+            nIter = iter + 1 + nIterReserve;
+            nIterReserve = 0;
+          }
+          // the next hypotheses were drawn from the previous sampling set
+          ++iter;
+          break;
         }
       }
     }
@@ -11,6 +11,7 @@
 #include <aliceVision/robustEstimation/LineKernel.hpp>
 #include <aliceVision/robustEstimation/ACRansac.hpp>
 #include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <glog/logging.h>
 
 #include "lineTestGenerator.hpp"
@@ -362,3 +363,89 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSimu)
 
   }
 }
+
+// Check that the partial ordering of the residuals gives the same NFA and inliers than a full sort
+
+BOOST_AUTO_TEST_CASE(ACRansac_sortAndFindBestNFA)
+{
+  const std::size_t nbData = 500;
+  const std::size_t sizeSample = 2;
+  const double loge0 = log10(1.0 * (nbData - sizeSample));
+  std::vector<float> vec_logc_n, vec_logc_k;
+  makelogcombi(sizeSample, nbData, vec_logc_k, vec_logc_n);
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<> inlierError(0.0, 1.0);
+  std::uniform_real_distribution<> outlierError(0.0, 1000.0);
+
+  for(const double logalpha0 : {-4.0, -2.0, 0.5})
+  {
+    for(const double maxThreshold : {std::numeric_limits<double>::infinity(), 0.5, 50.0})
+    {
+      for(const double minNFA : {std::numeric_limits<double>::infinity(), loge0, -10.0})
+      {
+        std::vector<ErrorIndex> residuals(nbData);
+        for(std::size_t i = 0; i < nbData; ++i)
+          residuals[i] = ErrorIndex(i % 3 ? inlierError(gen) : outlierError(gen), i);
+
+        std::vector<ErrorIndex> sortedResiduals = residuals;
+        std::sort(sortedResiduals.begin(), sortedResiduals.end());
+        const ErrorIndex expected = bestNFA(sizeSample, logalpha0, sortedResiduals, loge0, maxThreshold, vec_logc_n, vec_logc_k, 0.5);
+
+        const ErrorIndex best = sortAndFindBestNFA(sizeSample, logalpha0, residuals, loge0, maxThreshold, vec_logc_n, vec_logc_k, 0.5, minNFA);
+
+        if(expected.first < minNFA)
+        {
+          BOOST_CHECK_EQUAL(expected.first, best.first);
+          BOOST_CHECK_EQUAL(expected.second, best.second);
+          for(std::size_t i = 0; i < best.second; ++i)
+            BOOST_CHECK(sortedResiduals[i] == residuals[i]);
+        }
+        else
+        {
+          BOOST_CHECK(!(best.first < minNFA));
+        }
+      }
+    }
+  }
+}
+
+// Check that ACRANSAC is deterministic for a given random number generator,
+// whatever the number of hypotheses evaluated together and the number of threads
+
+BOOST_AUTO_TEST_CASE(RansacLineFitter_ParallelHypotheses)
+{
+  Mat points;
+  generateLine(points, 200, 100, 100, 0.5f, 0.3f);
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, 100, 100);
+
+  const int nbThreads = omp_get_max_threads();
+  for(const std::size_t nbParallelHypotheses : {1, 4, 16})
+  {
+    omp_set_num_threads(1);
+    std::vector<std::size_t> vec_inliersRef;
+    Vec2 lineRef;
+    std::mt19937 genRef(42);
+    const std::pair<double, double> outRef = ACRANSAC(lineKernel, vec_inliersRef, 300, &lineRef,
+                                                      std::numeric_limits<double>::infinity(), false,
+                                                      nbParallelHypotheses, &genRef);
+    BOOST_CHECK(!vec_inliersRef.empty());
+
+    for(const int threads : {1, 2, std::max(4, omp_get_num_procs())})
+    {
+      omp_set_num_threads(threads);
+      std::vector<std::size_t> vec_inliers;
+      Vec2 line;
+      std::mt19937 gen(42);
+      const std::pair<double, double> out = ACRANSAC(lineKernel, vec_inliers, 300, &line,
+                                                     std::numeric_limits<double>::infinity(), false,
+                                                     nbParallelHypotheses, &gen);
+      BOOST_CHECK_EQUAL(outRef.first, out.first);
+      BOOST_CHECK_EQUAL(outRef.second, out.second);
+      BOOST_CHECK(vec_inliersRef == vec_inliers);
+      BOOST_CHECK_EQUAL(lineRef(0), line(0));
+      BOOST_CHECK_EQUAL(lineRef(1), line(1));
+    }
+  }
+  omp_set_num_threads(nbThreads);
+}
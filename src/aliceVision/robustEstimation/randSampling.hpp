@@ -31,12 +31,14 @@ namespace robustEstimation{
  * @param[in] lowerBound The lower bound of the range.
  * @param[in] upperBound The upper bound of the range (not included).
  * @param[in] numSamples Number of unique samples to draw.
+ * @param[in,out] generator The random number generator.
  * @return samples The vector containing the samples.
  */
 template<typename IntT>
 inline std::vector<IntT> randSample(IntT lowerBound,
                                     IntT upperBound,
-                                    IntT numSamples)
+                                    IntT numSamples,
+                                    std::mt19937& generator)
 {
   const auto rangeSize = upperBound - lowerBound;
   
@@ -44,10 +46,6 @@ inline std::vector<IntT> randSample(IntT lowerBound,
   assert(numSamples <= rangeSize);
   static_assert(std::is_integral<IntT>::value, "Only integer types are supported");
 
-  
-  std::random_device rd;
-  std::mt19937 generator(rd());
-
   if(numSamples * 1.5 > rangeSize)
   {
     // if the number of required samples is a large fraction of the range size
@@ -81,6 +79,25 @@ inline std::vector<IntT> randSample(IntT lowerBound,
   }
 }
 
+/**
+ * @brief Generate a unique random samples without replacement in the
+ * range [lowerBound upperBound), with a randomly seeded generator.
+ *
+ * @param[in] lowerBound The lower bound of the range.
+ * @param[in] upperBound The upper bound of the range (not included).
+ * @param[in] numSamples Number of unique samples to draw.
+ * @return samples The vector containing the samples.
+ */
+template<typename IntT>
+inline std::vector<IntT> randSample(IntT lowerBound,
+                                    IntT upperBound,
+                                    IntT numSamples)
+{
+  std::random_device rd;
+  std::mt19937 generator(rd());
+  return randSample<IntT>(lowerBound, upperBound, numSamples, generator);
+}
+
 /**
 * @brief Pick a random subset of the integers in the range [0, upperBound).
 *
@@ -156,5 +173,44 @@ inline void UniformSample(std::size_t sampleSize,
   }
 }
 
+/**
+ * @brief Generate a unique random samples in the range [0 upperBound).
+ *
+ * @param[in] numSamples Number of unique samples to draw.
+ * @param[in] upperBound The value at the end of the range (not included).
+ * @param[out] samples The vector containing the samples.
+ * @param[in,out] generator The random number generator.
+ */
+template<typename IntT>
+inline void UniformSample(std::size_t numSamples,
+                          std::size_t upperBound,
+                          std::vector<IntT> &samples,
+                          std::mt19937& generator)
+{
+  samples = randSample<IntT>(0, upperBound, numSamples, generator);
+}
+
+/**
+ * @brief Generate a random sequence containing a sampling without replacement of
+ * of the elements of the input vector.
+ *
+ * @param[in] sampleSize The size of the sample to generate.
+ * @param[in] elements The possible data indices.
+ * @param[out] sample The random sample of sizeSample indices.
+ * @param[in,out] generator The random number generator.
+ */
+inline void UniformSample(std::size_t sampleSize,
+                          const std::vector<std::size_t>& elements,
+                          std::vector<std::size_t>& sample,
+                          std::mt19937& generator)
+{
+  sample = randSample<std::size_t>(0, elements.size(), sampleSize, generator);
+  assert(sample.size() == sampleSize);
+  for(auto& s : sample)
+  {
+    s = elements[ s ];
+  }
+}
+
 } // namespace robustEstimation
 } // namespace aliceVision
@@ -14,7 +14,10 @@
 
 #include <boost/filesystem.hpp>
 
-#include <numeric>
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <thread>
 
 namespace fs = boost::filesystem;
 
@@ -24,6 +27,101 @@ namespace sfm {
 using namespace Alembic::Abc;
 using namespace Alembic::AbcGeom;
 
+namespace {
+
+/**
+ * @brief Alembic arrays of a chunk of landmarks
+ */
+struct LandmarksChunk
+{
+  std::vector<const Landmark*> landmarks;
+  std::vector<const Vec3*> uncertainties;
+
+  std::vector<V3f> positions;
+  std::vector<Imath::C3f> colors;
+  std::vector<Alembic::Util::uint32_t> descTypes;
+  std::vector<Alembic::Util::uint64_t> ids;
+
+  // Use std::vector<::uint32_t> and std::vector<float> instead of std::vector<V2i> and std::vector<V2f>
+  // Because Maya don't import them correctly
+  std::vector<::uint32_t> visibilitySize;
+  std::vector<::uint32_t> visibilityIds;
+  std::vector<float> featPos2d;
+
+  std::vector<V3d> uncertaintiesEigenValues;
+
+  /**
+   * @brief Fill the Alembic arrays in parallel from the landmarks
+   * @param[in] firstLandmarkIndex The index of the first landmark of the chunk in the point cloud
+   * @param[in] withVisibility Fill the visibility arrays
+   */
+  void fill(std::size_t firstLandmarkIndex, bool withVisibility)
+  {
+    const int nbLandmarks = static_cast<int>(landmarks.size());
+
+    positions.resize(nbLandmarks);
+    colors.resize(nbLandmarks);
+    descTypes.resize(nbLandmarks);
+    ids.resize(nbLandmarks);
+    visibilitySize.resize(withVisibility ? nbLandmarks : 0);
+    uncertaintiesEigenValues.resize(uncertainties.size());
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbLandmarks; ++i)
+    {
+      const Landmark& landmark = *landmarks[i];
+      const Vec3& pt = landmark.X;
+      const image::RGBColor& color = landmark.rgb;
+      positions[i] = V3f(pt[0], pt[1], pt[2]);
+      colors[i] = Imath::C3f(color.r()/255.f, color.g()/255.f, color.b()/255.f);
+      descTypes[i] = static_cast<Alembic::Util::uint8_t>(landmark.descType);
+      ids[i] = firstLandmarkIndex + i;
+
+      if(withVisibility)
+        visibilitySize[i] = landmark.observations.size();
+
+      if(!uncertainties.empty())
+      {
+        const Vec3& u = *uncertainties[i];
+        uncertaintiesEigenValues[i] = V3d(u[0], u[1], u[2]);
+      }
+    }
+
+    visibilityIds.clear();
+    featPos2d.clear();
+
+    if(!withVisibility)
+      return;
+
+    // offset of the observations of each landmark
+    std::vector<std::size_t> offsets(nbLandmarks + 1, 0);
+    for(int i = 0; i < nbLandmarks; ++i)
+      offsets[i + 1] = offsets[i] + visibilitySize[i];
+
+    visibilityIds.resize(offsets.back() * 2);
+    featPos2d.resize(offsets.back() * 2);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbLandmarks; ++i)
+    {
+      std::size_t obsIndex = offsets[i] * 2;
+      for(const auto& vObs : landmarks[i]->observations)
+      {
+        const Observation& obs = vObs.second;
+        // (View ID, Feature ID)
+        visibilityIds[obsIndex] = vObs.first;
+        visibilityIds[obsIndex + 1] = obs.id_feat;
+        // Feature 2D position (x, y))
+        featPos2d[obsIndex] = obs.x[0];
+        featPos2d[obsIndex + 1] = obs.x[1];
+        obsIndex += 2;
+      }
+    }
+  }
+};
+
+} // namespace
+
 struct AlembicExporter::DataImpl
 {
     explicit DataImpl(const std::string& filename)
@@ -64,7 +162,17 @@ struct AlembicExporter::DataImpl
                const camera::IntrinsicBase* intrinsic = nullptr,
                const Vec6* uncertainty = nullptr,
                Alembic::Abc::OObject* parent = nullptr);
-  
+
+  /**
+   * @brief Add a chunk of landmarks as a points object
+   * @param[in] chunk The filled chunk of landmarks
+   * @param[in] chunkIndex The index of the chunk in the point cloud
+   */
+  void addLandmarksChunk(const LandmarksChunk& chunk, std::size_t chunkIndex);
+
+  /// maximum number of landmarks per points object
+  std::size_t _landmarksChunkSize = 1000000;
+
   Alembic::Abc::OArchive _archive;
   Alembic::Abc::OObject _topObj;
   Alembic::Abc::OObject _mvgRoot;
@@ -226,6 +334,42 @@ void AlembicExporter::DataImpl::addCamera(const std::string& name,
   }
 }
 
+void AlembicExporter::DataImpl::addLandmarksChunk(const LandmarksChunk& chunk, std::size_t chunkIndex)
+{
+  // the first chunk keeps the name of a point cloud written in one object
+  OPoints partsOut(_mvgPointCloud, "particleShape" + std::to_string(chunkIndex + 1));
+  OPointsSchema &pSchema = partsOut.getSchema();
+
+  OPointsSchema::Sample psamp(V3fArraySample(chunk.positions), UInt64ArraySample(chunk.ids));
+  pSchema.set(psamp);
+
+  OCompoundProperty arbGeom = pSchema.getArbGeomParams();
+
+  C3fArraySample cval_samp(&chunk.colors[0], chunk.colors.size());
+  OC3fGeomParam::Sample color_samp(cval_samp, kVertexScope);
+
+  OC3fGeomParam rgbOut(arbGeom, "color", false, kVertexScope, 1);
+  rgbOut.set(color_samp);
+
+  OCompoundProperty userProps = pSchema.getUserProperties();
+
+  OUInt32ArrayProperty(userProps, "mvg_describerType").set(chunk.descTypes);
+
+  if(!chunk.visibilitySize.empty())
+  {
+    OUInt32ArrayProperty(userProps, "mvg_visibilitySize" ).set(chunk.visibilitySize);
+    OUInt32ArrayProperty(userProps, "mvg_visibilityIds" ).set(chunk.visibilityIds); // (viewID, featID)
+    OFloatArrayProperty(userProps, "mvg_visibilityFeatPos" ).set(chunk.featPos2d); // feature position (x,y)
+  }
+
+  if(!chunk.uncertaintiesEigenValues.empty())
+  {
+    // Uncertainty eigen values (x,y,z)
+    OV3dArrayProperty propUncertainty(userProps, "mvg_uncertaintyEigenValues");
+    propUncertainty.set(chunk.uncertaintiesEigenValues);
+  }
+}
+
 AlembicExporter::AlembicExporter(const std::string& filename)
   : _dataImpl(new DataImpl(filename))
 {}
@@ -375,95 +519,73 @@ void AlembicExporter::addLandmarks(const Landmarks& landmarks, const sfm::Landma
   if(landmarks.empty())
     return;
 
-  // Fill vector with the values taken from AliceVision
-  std::vector<V3f> positions;
-  std::vector<Imath::C3f> colors;
-  std::vector<Alembic::Util::uint32_t> descTypes;
-  positions.reserve(landmarks.size());
-  descTypes.reserve(landmarks.size());
-
-  // For all the 3d points in the hash_map
-  for(const auto& landmark : landmarks)
-  {
-    const Vec3& pt = landmark.second.X;
-    const image::RGBColor& color = landmark.second.rgb;
-    positions.emplace_back(pt[0], pt[1], pt[2]);
-    colors.emplace_back(color.r()/255.f, color.g()/255.f, color.b()/255.f);
-    descTypes.emplace_back(static_cast<Alembic::Util::uint8_t>(landmark.second.descType));
-  }
-
-  std::vector<Alembic::Util::uint64_t> ids(positions.size());
-  std::iota(begin(ids), end(ids), 0);
+  // The landmarks are written by chunks of fixed size, with one points object per chunk.
+  // A chunk is filled in parallel while the previous one is written by another thread:
+  // the Alembic archive is only accessed by one thread at a time.
+  LandmarksChunk chunks[2];
+  std::thread writer;
+  std::exception_ptr writerError;
 
-  OPoints partsOut(_dataImpl->_mvgPointCloud, "particleShape1");
-  OPointsSchema &pSchema = partsOut.getSchema();
-
-  OPointsSchema::Sample psamp(std::move(V3fArraySample(positions)), std::move(UInt64ArraySample(ids)));
-  pSchema.set(psamp);
-
-  OCompoundProperty arbGeom = pSchema.getArbGeomParams();
-
-  C3fArraySample cval_samp(&colors[0], colors.size());
-  OC3fGeomParam::Sample color_samp(cval_samp, kVertexScope);
+  const std::size_t chunkSize = _dataImpl->_landmarksChunkSize;
+  Landmarks::const_iterator itLandmark = landmarks.begin();
+  std::size_t firstLandmarkIndex = 0;
+  std::size_t chunkIndex = 0;
 
-  OC3fGeomParam rgbOut(arbGeom, "color", false, kVertexScope, 1);
-  rgbOut.set(color_samp);
+  try
+  {
+    while(itLandmark != landmarks.end())
+    {
+      LandmarksChunk& chunk = chunks[chunkIndex % 2];
+      chunk.landmarks.clear();
+      chunk.uncertainties.clear();
 
-  OCompoundProperty userProps = pSchema.getUserProperties();
+      for(; itLandmark != landmarks.end() && chunk.landmarks.size() < chunkSize; ++itLandmark)
+      {
+        chunk.landmarks.push_back(&itLandmark->second);
+        if(!landmarksUncertainty.empty())
+          chunk.uncertainties.push_back(&landmarksUncertainty.at(itLandmark->first));
+      }
 
-  OUInt32ArrayProperty(userProps, "mvg_describerType").set(descTypes);
+      chunk.fill(firstLandmarkIndex, withVisibility);
+      firstLandmarkIndex += chunk.landmarks.size();
 
-  if(withVisibility)
-  {
-    std::vector<::uint32_t> visibilitySize;
-    visibilitySize.reserve(positions.size());
-    for(const auto& landmark : landmarks)
-    {
-      visibilitySize.emplace_back(landmark.second.observations.size());
-    }
-    std::size_t nbObservations = std::accumulate(visibilitySize.begin(), visibilitySize.end(), 0);
+      if(writer.joinable())
+        writer.join();
 
-    // Use std::vector<::uint32_t> and std::vector<float> instead of std::vector<V2i> and std::vector<V2f>
-    // Because Maya don't import them correctly
-    std::vector<::uint32_t> visibilityIds;
-    visibilityIds.reserve(nbObservations*2);
-    std::vector<float>featPos2d;
-    featPos2d.reserve(nbObservations*2);
+      if(writerError)
+        break;
 
-    for (const auto &landmark : landmarks)
-    {
-      const Observations& observations = landmark.second.observations;
-      for(const auto& vObs: observations )
+      writer = std::thread([this, &chunk, chunkIndex, &writerError]()
       {
-        const Observation& obs = vObs.second;
-        // (View ID, Feature ID)
-        visibilityIds.emplace_back(vObs.first);
-        visibilityIds.emplace_back(obs.id_feat);
-        // Feature 2D position (x, y))
-        featPos2d.emplace_back(obs.x[0]);
-        featPos2d.emplace_back(obs.x[1]);
-      }
+        try
+        {
+          _dataImpl->addLandmarksChunk(chunk, chunkIndex);
+        }
+        catch(...)
+        {
+          writerError = std::current_exception();
+        }
+      });
+      ++chunkIndex;
     }
-
-    OUInt32ArrayProperty(userProps, "mvg_visibilitySize" ).set(visibilitySize);
-    OUInt32ArrayProperty(userProps, "mvg_visibilityIds" ).set(visibilityIds); // (viewID, featID)
-    OFloatArrayProperty(userProps, "mvg_visibilityFeatPos" ).set(featPos2d); // feature position (x,y)
   }
-  if(!landmarksUncertainty.empty())
+  catch(...)
   {
-    std::vector<V3d> uncertainties;
-
-    std::size_t indexLandmark = 0;
-    for (Landmarks::const_iterator itLandmark = landmarks.begin(); itLandmark != landmarks.end(); ++itLandmark, ++indexLandmark)
-    {
-      const IndexT idLandmark = itLandmark->first;
-      const Vec3& u = landmarksUncertainty.at(idLandmark);
-      uncertainties.emplace_back(u[0], u[1], u[2]);
-    }
-    // Uncertainty eigen values (x,y,z)
-    OV3dArrayProperty propUncertainty(userProps, "mvg_uncertaintyEigenValues");
-    propUncertainty.set(uncertainties);
+    if(writer.joinable())
+      writer.join();
+    throw;
   }
+
+  if(writer.joinable())
+    writer.join();
+
+  if(writerError)
+    std::rethrow_exception(writerError);
+}
+
+void AlembicExporter::setLandmarksChunkSize(std::size_t chunkSize)
+{
+  _dataImpl->_landmarksChunkSize = std::max(chunkSize, std::size_t(1));
 }
 
 void AlembicExporter::addCamera(const std::string& name,
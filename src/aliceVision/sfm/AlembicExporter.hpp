@@ -59,12 +59,23 @@ public:
 
   /**
    * @brief Add a set of 3d points
+   * @note The points are written by chunks (one points object per chunk),
+   *       each chunk is filled in parallel while the previous one is written.
    * @param[in] points The 3D points to add
+   * @param[in] landmarksUncertainty The 3D points uncertainty (empty if undefined)
+   * @param[in] withVisibility Add the observations of the 3D points
    */
   void addLandmarks(const Landmarks& points,
                     const sfm::LandmarksUncertainty &landmarksUncertainty = sfm::LandmarksUncertainty(),
                     bool withVisibility = true);
 
+  /**
+   * @brief Set the maximum number of 3d points per points object
+   *        (1 000 000 by default). It bounds the memory used by the export.
+   * @param[in] chunkSize The number of 3D points per chunk
+   */
+  void setLandmarksChunkSize(std::size_t chunkSize);
+
   /**
    * @brief Add a camera
    * @param[in] name The camera identifier
@@ -11,6 +11,8 @@
 #include <Alembic/AbcCoreFactory/All.h>
 #include <Alembic/AbcCoreOgawa/All.h>
 
+#include <vector>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -112,6 +114,9 @@ bool readPointCloud(IObject iObj, M44d mat, sfm::SfMData &sfmdata, sfm::ESfMData
     }
   }
 
+  // Landmarks of this points object, to fill their observations in parallel
+  std::vector<Landmark*> landmarks(positions->size());
+
   // Number of points before adding the Alembic data
   const std::size_t nbPointsInit = sfmdata.structure.size();
   for(std::size_t point3d_i = 0;
@@ -120,6 +125,7 @@ bool readPointCloud(IObject iObj, M44d mat, sfm::SfMData &sfmdata, sfm::ESfMData
   {
     const P3fArraySamplePtr::element_type::value_type & pos_i = positions->get()[point3d_i];
     Landmark& landmark = sfmdata.structure[nbPointsInit + point3d_i] = Landmark(Vec3(pos_i.x, pos_i.y, pos_i.z), feature::EImageDescriberType::UNKNOWN);
+    landmarks[point3d_i] = &landmark;
 
     if(sampleColors)
     {
@@ -137,7 +143,8 @@ bool readPointCloud(IObject iObj, M44d mat, sfm::SfMData &sfmdata, sfm::ESfMData
     }
   }
 
-  if(userProps &&
+  if((flags_part & sfm::ESfMData::OBSERVATIONS) &&
+     userProps &&
      userProps.getPropertyHeader("mvg_visibilitySize") &&
      userProps.getPropertyHeader("mvg_visibilityIds") &&
      userProps.getPropertyHeader("mvg_visibilityFeatPos"))
@@ -169,20 +176,28 @@ bool readPointCloud(IObject iObj, M44d mat, sfm::SfMData &sfmdata, sfm::ESfMData
       return false;
     }
 
-    std::size_t obsGlobal_i = 0;
-    for(std::size_t point3d_i = 0;
-        point3d_i < positions->size();
-        ++point3d_i)
+    // Offset of the observations of each 3d point
+    std::vector<std::size_t> obsOffsets(positions->size() + 1, 0);
+    for(std::size_t point3d_i = 0; point3d_i < positions->size(); ++point3d_i)
+      obsOffsets[point3d_i + 1] = obsOffsets[point3d_i] + (*sampleVisibilitySize)[point3d_i] * 2;
+
+    if( obsOffsets.back() > sampleVisibilityIds->size() )
     {
-      Landmark& landmark = sfmdata.structure[nbPointsInit + point3d_i];
-      // Number of observation for this 3d point
-      const std::size_t visibilitySize = (*sampleVisibilitySize)[point3d_i];
+      ALICEVISION_LOG_WARNING("ABC Error: number of observations per 3D point doesn't match the visibility Ids.");
+      ALICEVISION_LOG_WARNING("Number of observations is " << obsOffsets.back() / 2);
+      ALICEVISION_LOG_WARNING("Visibility Ids size is " << sampleVisibilityIds->size());
+      return false;
+    }
 
-      for(std::size_t obs_i = 0;
-          obs_i < visibilitySize*2;
-          obs_i+=2, obsGlobal_i+=2)
-      {
+    #pragma omp parallel for
+    for(int point3d_i = 0; point3d_i < static_cast<int>(positions->size()); ++point3d_i)
+    {
+      Landmark& landmark = *landmarks[point3d_i];
 
+      for(std::size_t obsGlobal_i = obsOffsets[point3d_i];
+          obsGlobal_i < obsOffsets[point3d_i + 1];
+          obsGlobal_i+=2)
+      {
         const int viewID = (*sampleVisibilityIds)[obsGlobal_i];
         const int featID = (*sampleVisibilityIds)[obsGlobal_i+1];
         Observation& observations = landmark.observations[viewID];
@@ -532,7 +547,17 @@ void visitObject(IObject iObj, M44d mat, sfm::SfMData& sfmdata, sfm::ESfMData fl
   // ALICEVISION_LOG_DEBUG("ABC visit: " << iObj.getFullName());
   if(iObj.getName() == "mvgCamerasUndefined")
     isReconstructed = false;
-  
+
+  // Skip the parts of the hierarchy that are not requested, they are not read from the archive
+  if(iObj.getName() == "mvgCloud" && !(flagsPart & sfm::ESfMData::STRUCTURE))
+    return;
+
+  if((iObj.getName() == "mvgCameras" || iObj.getName() == "mvgCamerasUndefined") &&
+     !(flagsPart & sfm::ESfMData::VIEWS) &&
+     !(flagsPart & sfm::ESfMData::INTRINSICS) &&
+     !(flagsPart & sfm::ESfMData::EXTRINSICS))
+    return;
+
   const MetaData& md = iObj.getMetaData();
   if(IPoints::matches(md) && (flagsPart & sfm::ESfMData::STRUCTURE))
   {
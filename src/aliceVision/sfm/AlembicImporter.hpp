@@ -25,6 +25,9 @@ public:
 
   /**
    * @brief populate a SfMData from the alembic file
+   * @note Only the requested parts are read from the archive:
+   *       the cameras are not read without VIEWS, INTRINSICS or EXTRINSICS,
+   *       the points are not read without STRUCTURE and their observations without OBSERVATIONS.
    * @param[out] sfmData The output SfMData
    * @param[in] flagsPart
    */
@@ -11,6 +11,8 @@
 
 #include <ceres/rotation.h>
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -82,59 +84,47 @@ ceres::CostFunction * createRigCostFunctionFromIntrinsics(IntrinsicBase * intrin
 }
 
 
-void addPose(ceres::Problem& problem,
-             BA_Refine refineOptions,
-             const Pose3 & pose,
-             std::vector<double*>& out_parameterBlocks,
-             std::vector<double>& out_poseParams)
+/// Convert a pose to the parameters of its block (angleAxis + translation), without reallocation
+void poseToParams(const Pose3& pose, std::vector<double>& out_poseParams)
 {
   const Mat3 R = pose.rotation();
   const Vec3 t = pose.translation();
 
-  double angleAxis[3];
-  ceres::RotationMatrixToAngleAxis((const double*)R.data(), angleAxis);
-  out_poseParams.reserve(6); //angleAxis + translation
-  out_poseParams.push_back(angleAxis[0]);
-  out_poseParams.push_back(angleAxis[1]);
-  out_poseParams.push_back(angleAxis[2]);
-  out_poseParams.push_back(t(0));
-  out_poseParams.push_back(t(1));
-  out_poseParams.push_back(t(2));
-
-  double * parameter_block = &out_poseParams[0];
-  problem.AddParameterBlock(parameter_block, 6);
-  out_parameterBlocks.push_back(parameter_block);
-  // Keep the camera extrinsics constants
-  if (!(refineOptions & BA_REFINE_TRANSLATION) && !(refineOptions & BA_REFINE_ROTATION))
-  {
-    //set the whole parameter block as constant for best performance.
-    problem.SetParameterBlockConstant(parameter_block);
-  }
-  else
+  out_poseParams.resize(6);
+  ceres::RotationMatrixToAngleAxis((const double*)R.data(), &out_poseParams[0]);
+  out_poseParams[3] = t(0);
+  out_poseParams[4] = t(1);
+  out_poseParams[5] = t(2);
+}
+
+Pose3 paramsToPose(const std::vector<double>& poseParams)
+{
+  Mat3 R_refined;
+  ceres::AngleAxisToRotationMatrix(&poseParams[0], R_refined.data());
+  const Vec3 t_refined(poseParams[3], poseParams[4], poseParams[5]);
+  return poseFromRT(R_refined, t_refined);
+}
+
+/// Number of views with a defined pose for each intrinsic
+HashMap<IndexT, std::size_t> computeIntrinsicsUsage(const SfMData& sfm_data)
+{
+  HashMap<IndexT, std::size_t> intrinsicsUsage;
+  for(const auto& itView: sfm_data.GetViews())
   {
-    // Subset parametrization
-    std::vector<int> vec_constant_extrinsic;
-    // Don't refine rotations (if BA_REFINE_ROTATION is not specified)
-    if(!(refineOptions & BA_REFINE_ROTATION))
-    {
-      vec_constant_extrinsic.push_back(0);
-      vec_constant_extrinsic.push_back(1);
-      vec_constant_extrinsic.push_back(2);
-    }
-    // Don't refine translations (if BA_REFINE_TRANSLATION is not specified)
-    if(!(refineOptions & BA_REFINE_TRANSLATION))
-    {
-      vec_constant_extrinsic.push_back(3);
-      vec_constant_extrinsic.push_back(4);
-      vec_constant_extrinsic.push_back(5);
-    }
-    if (!vec_constant_extrinsic.empty())
-    {
-      ceres::SubsetParameterization *subset_parameterization =
-        new ceres::SubsetParameterization(6, vec_constant_extrinsic);
-      problem.SetParameterization(parameter_block, subset_parameterization);
-    }
+    const View* v = itView.second.get();
+    std::size_t& usage = intrinsicsUsage[v->getIntrinsicId()];
+    if(sfm_data.IsPoseAndIntrinsicDefined(v))
+      ++usage;
   }
+  return intrinsicsUsage;
+}
+
+bool isRefineIntrinsics(BA_Refine refineOptions)
+{
+  return (refineOptions & BA_REFINE_INTRINSICS_FOCAL) ||
+         (refineOptions & BA_REFINE_INTRINSICS_DISTORTION) ||
+         (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) ||
+         (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA);
 }
 
 BundleAdjustmentCeres::BA_options::BA_options(const bool bVerbose, bool bmultithreaded)
@@ -196,6 +186,132 @@ BundleAdjustmentCeres::BundleAdjustmentCeres(
   : _aliceVision_options(options)
 {}
 
+BundleAdjustmentCeres::BlockSetup BundleAdjustmentCeres::getPoseSetup(BA_Refine refineOptions)
+{
+  BlockSetup setup;
+  // Keep the camera extrinsics constants
+  if(!(refineOptions & BA_REFINE_TRANSLATION) && !(refineOptions & BA_REFINE_ROTATION))
+  {
+    //set the whole parameter block as constant for best performance.
+    setup.constant = true;
+    return setup;
+  }
+  // Don't refine rotations (if BA_REFINE_ROTATION is not specified)
+  if(!(refineOptions & BA_REFINE_ROTATION))
+  {
+    setup.constantParams.push_back(0);
+    setup.constantParams.push_back(1);
+    setup.constantParams.push_back(2);
+  }
+  // Don't refine translations (if BA_REFINE_TRANSLATION is not specified)
+  if(!(refineOptions & BA_REFINE_TRANSLATION))
+  {
+    setup.constantParams.push_back(3);
+    setup.constantParams.push_back(4);
+    setup.constantParams.push_back(5);
+  }
+  return setup;
+}
+
+BundleAdjustmentCeres::BlockSetup BundleAdjustmentCeres::getIntrinsicSetup(const IntrinsicBase& intrinsic, std::size_t usage, BA_Refine refineOptions)
+{
+  BlockSetup setup;
+  if(!isRefineIntrinsics(refineOptions))
+  {
+    // Nothing to refine in the intrinsics,
+    // so set the whole parameter block as constant with better performances.
+    setup.constant = true;
+    return setup;
+  }
+
+  const std::size_t nbParams = intrinsic.getParams().size();
+
+  // Focal length
+  if(refineOptions & BA_REFINE_INTRINSICS_FOCAL)
+  {
+    // Refine the focal length
+    if(intrinsic.initialFocalLengthPix() > 0)
+    {
+      // If we have an initial guess, we only authorize a margin around this value.
+      assert(nbParams >= 1);
+      const unsigned int maxFocalErr = 0.2 * std::max(intrinsic.w(), intrinsic.h());
+      setup.lowerBounds[0] = (double)intrinsic.initialFocalLengthPix() - maxFocalErr;
+      setup.upperBounds[0] = (double)intrinsic.initialFocalLengthPix() + maxFocalErr;
+    }
+    else // no initial guess
+    {
+      // We don't have an initial guess, but we assume that we use
+      // a converging lens, so the focal length should be positive.
+      setup.lowerBounds[0] = 0.0;
+    }
+  }
+  else
+  {
+    // Set focal length as constant
+    setup.constantParams.push_back(0);
+  }
+
+  const std::size_t minImagesForOpticalCenter = 3;
+
+  // Optical center
+  if((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) ||
+     ((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA) && usage > minImagesForOpticalCenter)
+     )
+  {
+    // Refine optical center within 10% of the image size.
+    assert(nbParams >= 3);
+
+    const double opticalCenterMinPercent = 0.45;
+    const double opticalCenterMaxPercent = 0.55;
+
+    // Add bounds to the principal point
+    setup.lowerBounds[1] = opticalCenterMinPercent * intrinsic.w();
+    setup.upperBounds[1] = opticalCenterMaxPercent * intrinsic.w();
+
+    setup.lowerBounds[2] = opticalCenterMinPercent * intrinsic.h();
+    setup.upperBounds[2] = opticalCenterMaxPercent * intrinsic.h();
+  }
+  else
+  {
+    // Don't refine the optical center
+    setup.constantParams.push_back(1);
+    setup.constantParams.push_back(2);
+  }
+
+  // Lens distortion
+  if(!(refineOptions & BA_REFINE_INTRINSICS_DISTORTION))
+  {
+    for(std::size_t i = 3; i < nbParams; ++i)
+      setup.constantParams.push_back(i);
+  }
+  return setup;
+}
+
+void BundleAdjustmentCeres::addParameterBlock(ceres::Problem& problem, std::vector<double>& values, const BlockSetup& setup)
+{
+  double* parameter_block = &values[0];
+  problem.AddParameterBlock(parameter_block, values.size());
+
+  if(setup.constant)
+  {
+    problem.SetParameterBlockConstant(parameter_block);
+    return;
+  }
+
+  for(const auto& bound : setup.lowerBounds)
+    problem.SetParameterLowerBound(parameter_block, bound.first, bound.second);
+  for(const auto& bound : setup.upperBounds)
+    problem.SetParameterUpperBound(parameter_block, bound.first, bound.second);
+
+  // Subset parametrization
+  if(!setup.constantParams.empty())
+  {
+    ceres::SubsetParameterization *subset_parameterization =
+      new ceres::SubsetParameterization(values.size(), setup.constantParams);
+    problem.SetParameterization(parameter_block, subset_parameterization);
+  }
+}
+
 void BundleAdjustmentCeres::createProblem(SfMData & sfm_data, BA_Refine refineOptions, ceres::Problem& problem)
 {
   // Ensure we are not using incompatible options:
@@ -211,15 +327,23 @@ void BundleAdjustmentCeres::createProblem(SfMData & sfm_data, BA_Refine refineOp
   // parameters for cameras and points are added automatically.
   //----------
 
+  map_poses.clear();
+  map_subposes.clear();
+  map_intrinsics.clear();
+  parameterBlocks.clear();
   parameterBlocks.reserve(sfm_data.GetPoses().size() + sfm_data.structure.size());
 
+  const BlockSetup poseSetup = getPoseSetup(refineOptions);
+
   // Setup Poses data & subparametrization
   for (Poses::const_iterator itPose = sfm_data.GetPoses().begin(); itPose != sfm_data.GetPoses().end(); ++itPose)
   {
     const IndexT indexPose = itPose->first;
-    const Pose3& pose = itPose->second;
+    std::vector<double>& poseParams = map_poses[indexPose];
 
-    addPose(problem, refineOptions, pose, parameterBlocks, map_poses[indexPose]);
+    poseToParams(itPose->second, poseParams);
+    addParameterBlock(problem, poseParams, poseSetup);
+    parameterBlocks.push_back(&poseParams[0]);
   }
 
   for(const auto& rigIt : sfm_data.getRigs())
@@ -235,124 +359,27 @@ void BundleAdjustmentCeres::createProblem(SfMData & sfm_data, BA_Refine refineOp
       if(rigSubPose.status == ERigSubPoseStatus::UNINITIALIZED)
         continue;
 
-      addPose(problem, refineOptions, rigSubPose.pose, parameterBlocks, map_subposes[rigId][subPoseId]);
+      std::vector<double>& subPoseParams = map_subposes[rigId][subPoseId];
+      poseToParams(rigSubPose.pose, subPoseParams);
+      addParameterBlock(problem, subPoseParams, poseSetup);
+      parameterBlocks.push_back(&subPoseParams[0]);
     }
   }
 
-  HashMap<IndexT, std::size_t> intrinsicsUsage;
-
-  // Setup Intrinsics data & subparametrization
-  const bool refineIntrinsicsOpticalCenter = (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) || (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA);
-  const bool refineIntrinsics = (refineOptions & BA_REFINE_INTRINSICS_FOCAL) ||
-                                (refineOptions & BA_REFINE_INTRINSICS_DISTORTION) ||
-                                refineIntrinsicsOpticalCenter;
-  for(const auto& itView: sfm_data.GetViews())
-  {
-    const View* v = itView.second.get();
-    if (sfm_data.IsPoseAndIntrinsicDefined(v))
-    {
-      if(intrinsicsUsage.find(v->getIntrinsicId()) == intrinsicsUsage.end())
-        intrinsicsUsage[v->getIntrinsicId()] = 1;
-      else
-        ++intrinsicsUsage[v->getIntrinsicId()];
-    }
-    else
-    {
-      if(intrinsicsUsage.find(v->getIntrinsicId()) == intrinsicsUsage.end())
-        intrinsicsUsage[v->getIntrinsicId()] = 0;
-    }
-  }
+  const HashMap<IndexT, std::size_t> intrinsicsUsage = computeIntrinsicsUsage(sfm_data);
 
   // Setup Intrinsics data & subparametrization
   for(const auto& itIntrinsic: sfm_data.GetIntrinsics())
   {
     const IndexT idIntrinsics = itIntrinsic.first;
-    if(intrinsicsUsage[idIntrinsics] == 0)
+    const auto itUsage = intrinsicsUsage.find(idIntrinsics);
+    if(itUsage == intrinsicsUsage.end() || itUsage->second == 0)
     {
       continue;
     }
     assert(isValid(itIntrinsic.second->getType()));
     map_intrinsics[idIntrinsics] = itIntrinsic.second->getParams();
-
-    double * parameter_block = &map_intrinsics[idIntrinsics][0];
-    problem.AddParameterBlock(parameter_block, map_intrinsics[idIntrinsics].size());
-    if (!refineIntrinsics)
-    {
-      // Nothing to refine in the intrinsics,
-      // so set the whole parameter block as constant with better performances.
-      problem.SetParameterBlockConstant(parameter_block);
-    }
-    else
-    {
-      std::vector<int> vec_constant_params;
-      // Focal length
-      if(refineOptions & BA_REFINE_INTRINSICS_FOCAL)
-      {
-        // Refine the focal length
-        if(itIntrinsic.second->initialFocalLengthPix() > 0)
-        {
-          // If we have an initial guess, we only authorize a margin around this value.
-          assert(map_intrinsics[idIntrinsics].size() >= 1);
-          const unsigned int maxFocalErr = 0.2 * std::max(itIntrinsic.second->w(), itIntrinsic.second->h());
-          problem.SetParameterLowerBound(parameter_block, 0, (double)itIntrinsic.second->initialFocalLengthPix() - maxFocalErr);
-          problem.SetParameterUpperBound(parameter_block, 0, (double)itIntrinsic.second->initialFocalLengthPix() + maxFocalErr);
-        }
-        else // no initial guess
-        {
-          // We don't have an initial guess, but we assume that we use
-          // a converging lens, so the focal length should be positive.
-          problem.SetParameterLowerBound(parameter_block, 0, 0.0);
-        }
-      }
-      else
-      {
-        // Set focal length as constant
-        vec_constant_params.push_back(0);
-      }
-
-      const std::size_t minImagesForOpticalCenter = 3;
-
-      // Optical center
-      if((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) ||
-         ((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA) && intrinsicsUsage[idIntrinsics] > minImagesForOpticalCenter)
-         )
-      {
-        // Refine optical center within 10% of the image size.
-        assert(map_intrinsics[idIntrinsics].size() >= 3);
-        
-        const double opticalCenterMinPercent = 0.45;
-        const double opticalCenterMaxPercent = 0.55;
-        
-        // Add bounds to the principal point
-        problem.SetParameterLowerBound(parameter_block, 1, opticalCenterMinPercent * itIntrinsic.second->w());
-        problem.SetParameterUpperBound(parameter_block, 1, opticalCenterMaxPercent * itIntrinsic.second->w());
-
-        problem.SetParameterLowerBound(parameter_block, 2, opticalCenterMinPercent * itIntrinsic.second->h());
-        problem.SetParameterUpperBound(parameter_block, 2, opticalCenterMaxPercent * itIntrinsic.second->h());
-      }
-      else
-      {
-        // Don't refine the optical center
-        vec_constant_params.push_back(1);
-        vec_constant_params.push_back(2);
-      }
-
-      // Lens distortion
-      if(!(refineOptions & BA_REFINE_INTRINSICS_DISTORTION))
-      {
-        for(std::size_t i = 3; i < map_intrinsics[idIntrinsics].size(); ++i)
-        {
-          vec_constant_params.push_back(i);
-        }
-      }
-
-      if(!vec_constant_params.empty())
-      {
-        ceres::SubsetParameterization *subset_parameterization =
-          new ceres::SubsetParameterization(map_intrinsics[idIntrinsics].size(), vec_constant_params);
-        problem.SetParameterization(parameter_block, subset_parameterization);
-      }
-    }
+    addParameterBlock(problem, map_intrinsics[idIntrinsics], getIntrinsicSetup(*itIntrinsic.second, itUsage->second, refineOptions));
   }
 
   // Set a LossFunction to be less penalized by false measurements
@@ -426,15 +453,298 @@ void BundleAdjustmentCeres::createJacobian(SfMData & sfm_data, BA_Refine refineO
   problem.Evaluate(evalOpt, &cost, NULL, NULL, &jacobian);
 }
 
+void BundleAdjustmentCeres::resetProblem()
+{
+  _landmarkBlocks.clear();
+  _intrinsicBlocks.clear();
+  _subPoseBlocks.clear();
+  _poseBlocks.clear();
+  _ordering.Clear();
+  _problem.reset();
+  _lossFunction.reset();
+}
+
+void BundleAdjustmentCeres::updateProblem(const SfMData& sfm_data, BA_Refine refineOptions)
+{
+  if(!_problem)
+  {
+    ceres::Problem::Options problemOptions;
+    // the loss function is shared by all the residual blocks
+    problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    // residual and parameter blocks are removed from one call to another
+    problemOptions.enable_fast_removal = true;
+
+    // Set a LossFunction to be less penalized by false measurements
+    // TODO: make the LOSS function and the parameter an option
+    _lossFunction.reset(new ceres::HuberLoss(Square(4.0)));
+    _problem.reset(new ceres::Problem(problemOptions));
+  }
+  ceres::Problem& problem = *_problem;
+
+  const BlockSetup poseSetup = getPoseSetup(refineOptions);
+  const HashMap<IndexT, std::size_t> intrinsicsUsage = computeIntrinsicsUsage(sfm_data);
+
+  // 1. Find the outdated blocks: removed from the SfMData, or with another setup.
+  //    Their residual blocks are removed before them.
+  std::set<IndexT> outdatedPoses;
+  for(const auto& poseBlockIt : _poseBlocks)
+  {
+    if(!sfm_data.GetPoses().count(poseBlockIt.first) || !(poseBlockIt.second.setup == poseSetup))
+      outdatedPoses.insert(poseBlockIt.first);
+  }
+
+  std::set<std::pair<IndexT, IndexT>> outdatedSubPoses;
+  for(const auto& rigBlocksIt : _subPoseBlocks)
+  {
+    const auto itRig = sfm_data.getRigs().find(rigBlocksIt.first);
+    for(const auto& subPoseBlockIt : rigBlocksIt.second)
+    {
+      const bool isValidSubPose = itRig != sfm_data.getRigs().end() &&
+                                  subPoseBlockIt.first < itRig->second.getNbSubPoses() &&
+                                  itRig->second.getSubPose(subPoseBlockIt.first).status != ERigSubPoseStatus::UNINITIALIZED;
+      if(!isValidSubPose || !(subPoseBlockIt.second.setup == poseSetup))
+        outdatedSubPoses.emplace(rigBlocksIt.first, subPoseBlockIt.first);
+    }
+  }
+
+  std::set<IndexT> outdatedIntrinsics;
+  for(const auto& intrinsicBlockIt : _intrinsicBlocks)
+  {
+    const auto itIntrinsic = sfm_data.GetIntrinsics().find(intrinsicBlockIt.first);
+    const auto itUsage = intrinsicsUsage.find(intrinsicBlockIt.first);
+    if(itIntrinsic == sfm_data.GetIntrinsics().end() ||
+       itUsage == intrinsicsUsage.end() || itUsage->second == 0 ||
+       itIntrinsic->second->getType() != intrinsicBlockIt.second.intrinsicType ||
+       itIntrinsic->second->getParams().size() != intrinsicBlockIt.second.values.size() ||
+       !(getIntrinsicSetup(*itIntrinsic->second, itUsage->second, refineOptions) == intrinsicBlockIt.second.setup))
+      outdatedIntrinsics.insert(intrinsicBlockIt.first);
+  }
+
+  // 2. Remove the removed landmarks and the residual blocks of the removed or modified observations
+  for(auto itLandmarkBlock = _landmarkBlocks.begin(); itLandmarkBlock != _landmarkBlocks.end();)
+  {
+    const auto itLandmark = sfm_data.structure.find(itLandmarkBlock->first);
+    LandmarkBlock& landmarkBlock = itLandmarkBlock->second;
+
+    for(auto itResidual = landmarkBlock.residuals.begin(); itResidual != landmarkBlock.residuals.end();)
+    {
+      const ResidualBlock& residual = itResidual->second;
+      bool isValid = false;
+
+      if(itLandmark != sfm_data.structure.end())
+      {
+        const auto itObservation = itLandmark->second.observations.find(itResidual->first);
+        const auto itView = sfm_data.GetViews().find(itResidual->first);
+
+        isValid = itObservation != itLandmark->second.observations.end() &&
+                  itView != sfm_data.GetViews().end() &&
+                  itObservation->second.x(0) == residual.x[0] &&
+                  itObservation->second.x(1) == residual.x[1] &&
+                  itView->second->getIntrinsicId() == residual.intrinsicId &&
+                  itView->second->getPoseId() == residual.poseId &&
+                  itView->second->getRigId() == residual.rigId &&
+                  itView->second->getSubPoseId() == residual.subPoseId &&
+                  !outdatedIntrinsics.count(residual.intrinsicId) &&
+                  !outdatedPoses.count(residual.poseId) &&
+                  !(residual.rigId != UndefinedIndexT && outdatedSubPoses.count(std::make_pair(residual.rigId, residual.subPoseId)));
+      }
+
+      if(isValid)
+      {
+        ++itResidual;
+      }
+      else
+      {
+        problem.RemoveResidualBlock(residual.id);
+        itResidual = landmarkBlock.residuals.erase(itResidual);
+      }
+    }
+
+    if(itLandmark == sfm_data.structure.end())
+    {
+      problem.RemoveParameterBlock(landmarkBlock.X.data());
+      _ordering.Remove(landmarkBlock.X.data());
+      itLandmarkBlock = _landmarkBlocks.erase(itLandmarkBlock);
+    }
+    else
+    {
+      ++itLandmarkBlock;
+    }
+  }
+
+  // 3. Remove the outdated blocks, they are added again below if they still exist
+  for(IndexT poseId : outdatedPoses)
+  {
+    double* parameter_block = &_poseBlocks.at(poseId).values[0];
+    problem.RemoveParameterBlock(parameter_block);
+    _ordering.Remove(parameter_block);
+    _poseBlocks.erase(poseId);
+  }
+  for(const auto& subPose : outdatedSubPoses)
+  {
+    HashMap<IndexT, ParameterBlock>& rigBlocks = _subPoseBlocks.at(subPose.first);
+    double* parameter_block = &rigBlocks.at(subPose.second).values[0];
+    problem.RemoveParameterBlock(parameter_block);
+    _ordering.Remove(parameter_block);
+    rigBlocks.erase(subPose.second);
+    if(rigBlocks.empty())
+      _subPoseBlocks.erase(subPose.first);
+  }
+  for(IndexT intrinsicId : outdatedIntrinsics)
+  {
+    double* parameter_block = &_intrinsicBlocks.at(intrinsicId).values[0];
+    problem.RemoveParameterBlock(parameter_block);
+    _ordering.Remove(parameter_block);
+    _intrinsicBlocks.erase(intrinsicId);
+  }
+
+  // 4. Add the new pose and intrinsic blocks, update the values of the others.
+  //    The values are copied in the existing buffers, used by the problem.
+  for(const auto& poseIt : sfm_data.GetPoses())
+  {
+    auto itPoseBlock = _poseBlocks.find(poseIt.first);
+    if(itPoseBlock != _poseBlocks.end())
+    {
+      poseToParams(poseIt.second, itPoseBlock->second.values);
+      continue;
+    }
+    ParameterBlock& block = _poseBlocks[poseIt.first];
+    block.setup = poseSetup;
+    poseToParams(poseIt.second, block.values);
+    addParameterBlock(problem, block.values, block.setup);
+    _ordering.AddElementToGroup(&block.values[0], 1);
+  }
+
+  for(const auto& rigIt : sfm_data.getRigs())
+  {
+    const Rig& rig = rigIt.second;
+    for(std::size_t subPoseId = 0 ; subPoseId < rig.getNbSubPoses(); ++subPoseId)
+    {
+      const RigSubPose& rigSubPose = rig.getSubPose(subPoseId);
+      if(rigSubPose.status == ERigSubPoseStatus::UNINITIALIZED)
+        continue;
+
+      HashMap<IndexT, ParameterBlock>& rigBlocks = _subPoseBlocks[rigIt.first];
+      auto itSubPoseBlock = rigBlocks.find(subPoseId);
+      if(itSubPoseBlock != rigBlocks.end())
+      {
+        poseToParams(rigSubPose.pose, itSubPoseBlock->second.values);
+        continue;
+      }
+      ParameterBlock& block = rigBlocks[subPoseId];
+      block.setup = poseSetup;
+      poseToParams(rigSubPose.pose, block.values);
+      addParameterBlock(problem, block.values, block.setup);
+      _ordering.AddElementToGroup(&block.values[0], 1);
+    }
+  }
+
+  for(const auto& intrinsicIt : sfm_data.GetIntrinsics())
+  {
+    const auto itUsage = intrinsicsUsage.find(intrinsicIt.first);
+    if(itUsage == intrinsicsUsage.end() || itUsage->second == 0)
+      continue;
+
+    assert(isValid(intrinsicIt.second->getType()));
+    const std::vector<double> params = intrinsicIt.second->getParams();
+
+    auto itIntrinsicBlock = _intrinsicBlocks.find(intrinsicIt.first);
+    if(itIntrinsicBlock != _intrinsicBlocks.end())
+    {
+      std::copy(params.begin(), params.end(), itIntrinsicBlock->second.values.begin());
+      continue;
+    }
+    ParameterBlock& block = _intrinsicBlocks[intrinsicIt.first];
+    block.setup = getIntrinsicSetup(*intrinsicIt.second, itUsage->second, refineOptions);
+    block.intrinsicType = intrinsicIt.second->getType();
+    block.values = params;
+    addParameterBlock(problem, block.values, block.setup);
+    _ordering.AddElementToGroup(&block.values[0], 1);
+  }
+
+  // 5. Add the new landmarks and the residual blocks of the new observations
+  const bool constantStructure = !(refineOptions & BA_REFINE_STRUCTURE);
+  for(const auto& landmarkIt : sfm_data.structure)
+  {
+    const Landmark& landmark = landmarkIt.second;
+
+    auto itLandmarkBlock = _landmarkBlocks.find(landmarkIt.first);
+    const bool isNewLandmark = (itLandmarkBlock == _landmarkBlocks.end());
+    LandmarkBlock& landmarkBlock = isNewLandmark ? _landmarkBlocks[landmarkIt.first] : itLandmarkBlock->second;
+    landmarkBlock.X = landmark.X;
+
+    if(isNewLandmark)
+    {
+      problem.AddParameterBlock(landmarkBlock.X.data(), 3);
+      _ordering.AddElementToGroup(landmarkBlock.X.data(), 0);
+    }
+    if(isNewLandmark || landmarkBlock.constant != constantStructure)
+    {
+      if(constantStructure)
+        problem.SetParameterBlockConstant(landmarkBlock.X.data());
+      else
+        problem.SetParameterBlockVariable(landmarkBlock.X.data());
+      landmarkBlock.constant = constantStructure;
+    }
+
+    // Iterate over 2D observation associated to the 3D landmark
+    for(const auto& observationIt : landmark.observations)
+    {
+      if(landmarkBlock.residuals.count(observationIt.first))
+        continue;
+
+      // Build the residual block corresponding to the track observation:
+      const View* view = sfm_data.views.at(observationIt.first).get();
+      IntrinsicBase* intrinsic = sfm_data.intrinsics.at(view->getIntrinsicId()).get();
+
+      ResidualBlock residual;
+      residual.x[0] = observationIt.second.x(0);
+      residual.x[1] = observationIt.second.x(1);
+      residual.intrinsicId = view->getIntrinsicId();
+      residual.poseId = view->getPoseId();
+      residual.rigId = view->getRigId();
+      residual.subPoseId = view->getSubPoseId();
+
+      double* intrinsic_ptr = &_intrinsicBlocks.at(residual.intrinsicId).values[0];
+      double* pose_ptr = &_poseBlocks.at(residual.poseId).values[0];
+
+      if(view->isPartOfRig())
+      {
+        double* subpose_ptr = &_subPoseBlocks.at(residual.rigId).at(residual.subPoseId).values[0];
+
+        residual.id = problem.AddResidualBlock(
+          createRigCostFunctionFromIntrinsics(intrinsic, observationIt.second.x),
+          _lossFunction.get(),
+          intrinsic_ptr,
+          pose_ptr,
+          subpose_ptr, // subpose of the cameras rig
+          landmarkBlock.X.data());
+      }
+      else
+      {
+        residual.id = problem.AddResidualBlock(
+          createCostFunctionFromIntrinsics(intrinsic, observationIt.second.x),
+          _lossFunction.get(),
+          intrinsic_ptr,
+          pose_ptr,
+          landmarkBlock.X.data());
+      }
+      landmarkBlock.residuals.emplace(observationIt.first, residual);
+    }
+  }
+}
+
 bool BundleAdjustmentCeres::Adjust(
   SfMData & sfm_data,     // the SfM scene to refine
   BA_Refine refineOptions)
 {
-  ceres::Problem problem;
-  createProblem(sfm_data, refineOptions, problem);
+  // Ensure we are not using incompatible options:
+  //  - BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS and BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA cannot be used at the same time
+  assert(!((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) && (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA)));
+
+  updateProblem(sfm_data, refineOptions);
 
   // Configure a BA engine and run it
-  //  Make Ceres automatically detect the bundle structure.
   ceres::Solver::Options options;
   options.preconditioner_type = _aliceVision_options._preconditioner_type;
   options.linear_solver_type = _aliceVision_options._linear_solver_type;
@@ -443,10 +753,13 @@ bool BundleAdjustmentCeres::Adjust(
   options.logging_type = ceres::SILENT;
   options.num_threads = _aliceVision_options._nbThreads;
   options.num_linear_solver_threads = _aliceVision_options._nbThreads;
+  // Use the ordering kept with the problem instead of a new detection of the bundle structure.
+  // The solver removes the constant blocks from the ordering, so it works on a copy.
+  options.linear_solver_ordering.reset(new ceres::ParameterBlockOrdering(_ordering));
 
   // Solve BA
   ceres::Solver::Summary summary;
-  ceres::Solve(options, &problem, &summary);
+  ceres::Solve(options, _problem.get(), &summary);
   if (_aliceVision_options._bCeres_Summary)
     ALICEVISION_LOG_DEBUG(summary.FullReport());
 
@@ -479,49 +792,38 @@ bool BundleAdjustmentCeres::Adjust(
     for (Poses::iterator itPose = sfm_data.GetPoses().begin();
       itPose != sfm_data.GetPoses().end(); ++itPose)
     {
-      const IndexT indexPose = itPose->first;
-
-      Mat3 R_refined;
-      ceres::AngleAxisToRotationMatrix(&map_poses[indexPose][0], R_refined.data());
-      Vec3 t_refined(map_poses[indexPose][3], map_poses[indexPose][4], map_poses[indexPose][5]);
-      // Update the pose
-      Pose3 & pose = itPose->second;
-      pose = poseFromRT(R_refined, t_refined);
+      itPose->second = paramsToPose(_poseBlocks.at(itPose->first).values);
     }
 
-    for(const auto& rigIt : map_subposes)
+    for(const auto& rigIt : _subPoseBlocks)
     {
       Rig& rig = sfm_data.getRigs().at(rigIt.first);
 
       for(const auto& subPoseit : rigIt.second)
       {
         RigSubPose& subpose = rig.getSubPose(subPoseit.first);
-
-        Mat3 R_refined;
-        ceres::AngleAxisToRotationMatrix(&subPoseit.second[0], R_refined.data());
-        Vec3 t_refined(subPoseit.second[3], subPoseit.second[4], subPoseit.second[5]);
-
-        // Update the pose
-        subpose.pose = poseFromRT(R_refined, t_refined);
+        subpose.pose = paramsToPose(subPoseit.second.values);
       }
     }
   }
 
   // Update camera intrinsics with refined data
-  const bool refineIntrinsicsOpticalCenter = (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) || (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA);
-  const bool refineIntrinsics = (refineOptions & BA_REFINE_INTRINSICS_FOCAL) ||
-                                (refineOptions & BA_REFINE_INTRINSICS_DISTORTION) ||
-                                refineIntrinsicsOpticalCenter;
-  if (refineIntrinsics)
+  if (isRefineIntrinsics(refineOptions))
   {
-    for (const auto& intrinsicsV: map_intrinsics)
+    for (const auto& intrinsicsV: _intrinsicBlocks)
     {
-      sfm_data.intrinsics[intrinsicsV.first]->updateFromParams(intrinsicsV.second);
+      sfm_data.intrinsics[intrinsicsV.first]->updateFromParams(intrinsicsV.second.values);
     }
   }
+
+  // Update the landmarks with refined data
+  if (refineOptions & BA_REFINE_STRUCTURE)
+  {
+    for(auto& landmarkIt : sfm_data.structure)
+      landmarkIt.second.X = _landmarkBlocks.at(landmarkIt.first).X;
+  }
   return true;
 }
 
 } // namespace sfm
 } // namespace aliceVision
-
@@ -12,6 +12,11 @@
 #include <aliceVision/sfm/ResidualErrorFunctor.hpp>
 #include <ceres/ceres.h>
 
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -19,6 +24,16 @@ namespace sfm {
 ceres::CostFunction * createCostFunctionFromIntrinsics(camera::IntrinsicBase * intrinsic, const Vec2 & observation);
 ceres::CostFunction * createRigCostFunctionFromIntrinsics(camera::IntrinsicBase * intrinsic, const Vec2 & observation);
 
+/**
+ * @brief Bundle adjustment with Ceres.
+ *
+ * The Ceres problem is kept between two Adjust calls, to be reused by the incremental SfM:
+ * at each call, only the new poses, intrinsics, landmarks and observations are added
+ * and the removed ones are removed from the problem.
+ * The other parameter blocks and the cost functions of their residual blocks are reused,
+ * with the values of the given SfMData.
+ * The parameter ordering for the Schur elimination (landmarks first) is kept with the problem.
+ */
 class BundleAdjustmentCeres : public BundleAdjustment
 {
 public:
@@ -44,9 +59,86 @@ private:
     std::vector<double*> parameterBlocks;
     HashMap<IndexT, std::vector<double> > map_intrinsics;
 
+    /// Constant parameters and bounds of a pose or intrinsic parameter block
+    struct BlockSetup
+    {
+      bool constant = false;
+      std::vector<int> constantParams;
+      std::map<int, double> lowerBounds;
+      std::map<int, double> upperBounds;
+
+      bool operator==(const BlockSetup& other) const
+      {
+        return constant == other.constant &&
+               constantParams == other.constantParams &&
+               lowerBounds == other.lowerBounds &&
+               upperBounds == other.upperBounds;
+      }
+    };
+
+    /// Pose or intrinsic parameter block of the persistent problem
+    struct ParameterBlock
+    {
+      std::vector<double> values;
+      BlockSetup setup;
+      /// type of an intrinsic block, used by the cost functions of its residual blocks
+      camera::EINTRINSIC intrinsicType = camera::PINHOLE_CAMERA_START;
+    };
+
+    /// Reprojection residual block of the persistent problem
+    struct ResidualBlock
+    {
+      ceres::ResidualBlockId id;
+      /// observation of the cost function
+      double x[2];
+      IndexT intrinsicId;
+      IndexT poseId;
+      IndexT rigId;
+      IndexT subPoseId;
+    };
+
+    /// Landmark parameter block of the persistent problem, with its residual blocks per view
+    struct LandmarkBlock
+    {
+      Vec3 X;
+      bool constant = false;
+      std::map<IndexT, ResidualBlock> residuals;
+    };
+
+    // Persistent problem (the loss function is shared by all the residual blocks)
+    std::unique_ptr<ceres::LossFunction> _lossFunction;
+    std::unique_ptr<ceres::Problem> _problem;
+    /// Schur elimination ordering: landmarks in group 0, poses and intrinsics in group 1
+    ceres::ParameterBlockOrdering _ordering;
+    HashMap<IndexT, ParameterBlock> _poseBlocks;
+    HashMap<IndexT, HashMap<IndexT, ParameterBlock>> _subPoseBlocks;
+    HashMap<IndexT, ParameterBlock> _intrinsicBlocks;
+    HashMap<IndexT, LandmarkBlock> _landmarkBlocks;
+
+    static BlockSetup getPoseSetup(BA_Refine refineOptions);
+    static BlockSetup getIntrinsicSetup(const camera::IntrinsicBase& intrinsic, std::size_t usage, BA_Refine refineOptions);
+    static void addParameterBlock(ceres::Problem& problem, std::vector<double>& values, const BlockSetup& setup);
+
+    /**
+     * @brief Update the persistent problem from the SfMData:
+     *        remove the blocks of the removed or modified elements, add the new ones
+     *        and copy the values of the SfMData in the parameter blocks.
+     */
+    void updateProblem(const SfMData& sfm_data, BA_Refine refineOptions);
+
 public:
   BundleAdjustmentCeres(BundleAdjustmentCeres::BA_options options = BA_options());
 
+  /**
+   * @brief Change the solver options, the persistent problem is kept.
+   */
+  void setOptions(const BA_options& options) { _aliceVision_options = options; }
+
+  /**
+   * @brief Release the persistent problem, the next Adjust call builds a new one.
+   */
+  void resetProblem();
+
   void createProblem(SfMData& sfm_data, BA_Refine refineOptions, ceres::Problem& problem);
 
   void createJacobian(SfMData& sfm_data, BA_Refine refineOptions, ceres::CRSMatrix& jacobian);
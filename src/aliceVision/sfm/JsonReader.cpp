@@ -0,0 +1,370 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "JsonReader.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+bool isWhitespace(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+int hexDigitValue(char c)
+{
+  if(c >= '0' && c <= '9')
+    return c - '0';
+  if(c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if(c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+void appendUtf8(unsigned long codepoint, std::string& str)
+{
+  if(codepoint < 0x80)
+  {
+    str += static_cast<char>(codepoint);
+  }
+  else if(codepoint < 0x800)
+  {
+    str += static_cast<char>(0xC0 | (codepoint >> 6));
+    str += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+  else if(codepoint < 0x10000)
+  {
+    str += static_cast<char>(0xE0 | (codepoint >> 12));
+    str += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+    str += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+  else
+  {
+    str += static_cast<char>(0xF0 | (codepoint >> 18));
+    str += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+    str += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+    str += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+}
+
+} // namespace
+
+JsonReader::JsonReader(const char* begin, const char* end)
+  : _begin(begin)
+  , _end(end)
+  , _current(begin)
+{}
+
+void JsonReader::beginObject()
+{
+  beginContainer('{');
+}
+
+bool JsonReader::nextKey(std::string& key)
+{
+  if(!nextContainerItem('}'))
+    return false;
+
+  skipWhitespaces();
+  if(_current == _end || *_current != '"')
+    error("expected a key");
+  readString(key);
+  expect(':');
+  return true;
+}
+
+void JsonReader::beginArray()
+{
+  beginContainer('[');
+}
+
+bool JsonReader::nextElement()
+{
+  return nextContainerItem(']');
+}
+
+bool JsonReader::isContainer()
+{
+  skipWhitespaces();
+  return _current != _end && (*_current == '{' || *_current == '[');
+}
+
+void JsonReader::readString(std::string& value)
+{
+  value.clear();
+  skipWhitespaces();
+
+  if(_current == _end || *_current != '"')
+  {
+    // literal or number
+    const char* begin;
+    const char* end;
+    readToken(begin, end);
+    value.assign(begin, end);
+    return;
+  }
+
+  ++_current;
+  for(;;)
+  {
+    const char* begin = _current;
+    while(_current != _end && *_current != '"' && *_current != '\\')
+      ++_current;
+    value.append(begin, _current);
+
+    if(_current == _end)
+      error("unterminated string");
+
+    if(*_current++ == '"')
+      return;
+
+    // escape sequence
+    if(_current == _end)
+      error("unterminated string");
+
+    switch(*_current++)
+    {
+      case '"':  value += '"'; break;
+      case '\\': value += '\\'; break;
+      case '/':  value += '/'; break;
+      case 'b':  value += '\b'; break;
+      case 'f':  value += '\f'; break;
+      case 'n':  value += '\n'; break;
+      case 'r':  value += '\r'; break;
+      case 't':  value += '\t'; break;
+      case 'u':
+      {
+        const auto readCodeUnit = [this]() {
+          if(_end - _current < 4)
+            error("invalid unicode escape sequence");
+          unsigned long codeUnit = 0;
+          for(int i = 0; i < 4; ++i)
+          {
+            const int digit = hexDigitValue(*_current++);
+            if(digit < 0)
+              error("invalid unicode escape sequence");
+            codeUnit = codeUnit * 16 + digit;
+          }
+          return codeUnit;
+        };
+
+        unsigned long codepoint = readCodeUnit();
+        // surrogate pair
+        if(codepoint >= 0xD800 && codepoint < 0xDC00 && _end - _current >= 2 && _current[0] == '\\' && _current[1] == 'u')
+        {
+          _current += 2;
+          const unsigned long low = readCodeUnit();
+          if(low < 0xDC00 || low >= 0xE000)
+            error("invalid unicode surrogate pair");
+          codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+        }
+        appendUtf8(codepoint, value);
+        break;
+      }
+      default:
+        error("invalid escape sequence");
+    }
+  }
+}
+
+double JsonReader::readDouble()
+{
+  const char* begin;
+  const char* end;
+  readToken(begin, end);
+
+  // the buffer is not null-terminated
+  char str[64];
+  const std::size_t size = end - begin;
+  if(size >= sizeof(str))
+    error("invalid number");
+  std::memcpy(str, begin, size);
+  str[size] = '\0';
+
+  char* strEnd;
+  const double value = std::strtod(str, &strEnd);
+  if(strEnd != str + size)
+    error("invalid number");
+  return value;
+}
+
+void JsonReader::skipValue()
+{
+  skipWhitespaces();
+  if(_current == _end)
+    error("expected a value");
+
+  if(*_current == '"')
+  {
+    for(++_current; _current != _end && *_current != '"'; ++_current)
+    {
+      if(*_current == '\\' && _current + 1 != _end)
+        ++_current;
+    }
+    if(_current == _end)
+      error("unterminated string");
+    ++_current;
+    return;
+  }
+
+  if(*_current != '{' && *_current != '[')
+  {
+    const char* begin;
+    const char* end;
+    readToken(begin, end);
+    return;
+  }
+
+  // skip the whole container without parsing the values
+  std::size_t depth = 0;
+  while(_current != _end)
+  {
+    const char c = *_current;
+    if(c == '"')
+    {
+      skipValue();
+      continue;
+    }
+    ++_current;
+    if(c == '{' || c == '[')
+      ++depth;
+    else if((c == '}' || c == ']') && --depth == 0)
+      return;
+  }
+  error("unterminated container");
+}
+
+void JsonReader::error(const std::string& message) const
+{
+  const std::size_t line = 1 + std::count(_begin, std::min(_current, _end), '\n');
+  throw std::runtime_error("JSON parse error (line " + std::to_string(line) + "): " + message);
+}
+
+void JsonReader::skipWhitespaces()
+{
+  while(_current != _end && isWhitespace(*_current))
+    ++_current;
+}
+
+void JsonReader::expect(char c)
+{
+  skipWhitespaces();
+  if(_current == _end || *_current != c)
+    error(std::string("expected '") + c + "'");
+  ++_current;
+}
+
+bool JsonReader::beginContainer(char open)
+{
+  skipWhitespaces();
+
+  // boost::property_tree writes an empty container as an empty string
+  if(_end - _current >= 2 && _current[0] == '"' && _current[1] == '"')
+  {
+    _current += 2;
+    _isEmptyContainer = true;
+    return false;
+  }
+
+  expect(open);
+  _isFirstItem.push_back(true);
+  return true;
+}
+
+bool JsonReader::nextContainerItem(char close)
+{
+  if(_isEmptyContainer)
+  {
+    _isEmptyContainer = false;
+    return false;
+  }
+
+  if(_isFirstItem.empty())
+    error("no opened container");
+
+  skipWhitespaces();
+  if(_current != _end && *_current == close)
+  {
+    ++_current;
+    _isFirstItem.pop_back();
+    return false;
+  }
+
+  if(_isFirstItem.back())
+    _isFirstItem.back() = false;
+  else
+    expect(',');
+  return true;
+}
+
+void JsonReader::readToken(const char*& begin, const char*& end)
+{
+  skipWhitespaces();
+
+  if(_current != _end && *_current == '"')
+  {
+    // quoted value
+    begin = ++_current;
+    while(_current != _end && *_current != '"')
+    {
+      if(*_current == '\\')
+        error("unexpected escape sequence in a value");
+      ++_current;
+    }
+    if(_current == _end)
+      error("unterminated string");
+    end = _current++;
+
+    while(begin != end && isWhitespace(*begin))
+      ++begin;
+    while(end != begin && isWhitespace(*(end - 1)))
+      --end;
+  }
+  else
+  {
+    begin = _current;
+    while(_current != _end && !isWhitespace(*_current) && *_current != ',' && *_current != '}' && *_current != ']')
+      ++_current;
+    end = _current;
+  }
+
+  if(begin == end)
+    error("expected a value");
+}
+
+std::uint64_t JsonReader::readUInt64()
+{
+  const char* begin;
+  const char* end;
+  readToken(begin, end);
+
+  if(*begin == '+')
+    ++begin;
+  if(begin == end)
+    error("invalid integer");
+
+  std::uint64_t value = 0;
+  for(const char* c = begin; c != end; ++c)
+  {
+    if(*c < '0' || *c > '9')
+      error("invalid integer");
+    const std::uint64_t digit = *c - '0';
+    if(value > (std::numeric_limits<std::uint64_t>::max() - digit) / 10)
+      error("integer out of range");
+    value = value * 10 + digit;
+  }
+  return value;
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,129 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Streaming (pull) JSON reader over a memory buffer.
+ *
+ * The values are parsed directly from the buffer, without building a tree.
+ * As written by boost::property_tree, the values can be quoted, and an empty
+ * string is accepted as an empty object or array.
+ * Throws std::runtime_error on a syntax error.
+ */
+class JsonReader
+{
+public:
+  JsonReader(const char* begin, const char* end);
+
+  /**
+   * @brief Begin to read an object, then call nextKey() until it returns false.
+   */
+  void beginObject();
+
+  /**
+   * @brief Read the key of the next member of the current object.
+   * @param[out] key The member key
+   * @return false at the end of the object
+   */
+  bool nextKey(std::string& key);
+
+  /**
+   * @brief Begin to read an array, then call nextElement() until it returns false.
+   */
+  void beginArray();
+
+  /**
+   * @brief Go to the next element of the current array.
+   * @return false at the end of the array
+   */
+  bool nextElement();
+
+  /// @return true if the next value is an object or an array
+  bool isContainer();
+
+  /// Read a value as a string
+  void readString(std::string& value);
+
+  std::string readString()
+  {
+    std::string value;
+    readString(value);
+    return value;
+  }
+
+  double readDouble();
+
+  template<typename T>
+  T readUnsigned()
+  {
+    const std::uint64_t value = readUInt64();
+    if(value > std::numeric_limits<T>::max())
+      error("value out of range");
+    return static_cast<T>(value);
+  }
+
+  /// Read an array of values in an Eigen Matrix (or Vector)
+  template<typename Derived>
+  void readMatrix(Eigen::MatrixBase<Derived>& matrix)
+  {
+    typedef typename Derived::Scalar Scalar;
+    int i = 0;
+    beginArray();
+    while(nextElement())
+    {
+      if(i >= matrix.size())
+        error("invalid matrix / vector size");
+      matrix(i++) = readScalar(static_cast<Scalar*>(nullptr));
+    }
+    if(i != matrix.size())
+      error("invalid matrix / vector size");
+  }
+
+  /// Skip the next value (string, number, object or array)
+  void skipValue();
+
+  /// Throw a std::runtime_error with the current line
+  [[noreturn]] void error(const std::string& message) const;
+
+private:
+  void skipWhitespaces();
+  void expect(char c);
+  bool beginContainer(char open);
+  bool nextContainerItem(char close);
+  bool readEmptyContainer();
+  /// Get the characters of a number or a literal, quoted or not
+  void readToken(const char*& begin, const char*& end);
+  std::uint64_t readUInt64();
+
+  double readScalar(double*) { return readDouble(); }
+  float readScalar(float*) { return static_cast<float>(readDouble()); }
+  template<typename T>
+  T readScalar(T*) { return readUnsigned<T>(); }
+
+  const char* _begin;
+  const char* _end;
+  const char* _current;
+  /// for each opened container, true until its first item
+  std::vector<bool> _isFirstItem;
+  /// the last opened container is an empty string
+  bool _isEmptyContainer = false;
+};
+
+} // namespace sfm
+} // namespace aliceVision
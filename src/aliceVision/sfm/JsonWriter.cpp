@@ -0,0 +1,215 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "JsonWriter.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+/// size of the buffer written in the file at once
+const std::size_t flushSize = 1 << 20;
+
+} // namespace
+
+JsonWriter::JsonWriter(const std::string& filename)
+  : _file(std::fopen(filename.c_str(), "w"))
+{
+  if(_file == nullptr)
+    throw std::runtime_error("Unable to open the file: " + filename);
+
+  // the root object is always written
+  _buffer.reserve(2 * flushSize);
+  _buffer += "{\n";
+  _stack.push_back({false, true, 0});
+}
+
+JsonWriter::JsonWriter(int arrayDepth)
+  : _baseDepth(arrayDepth)
+{
+  // the elements are written without the brackets of the array
+  _stack.push_back({true, true, 0});
+}
+
+JsonWriter::~JsonWriter()
+{
+  if(_file != nullptr)
+    std::fclose(_file);
+}
+
+void JsonWriter::beginObject(const char* key)
+{
+  beginContainer(key, false);
+}
+
+void JsonWriter::endObject()
+{
+  endContainer(false);
+}
+
+void JsonWriter::beginArray(const char* key)
+{
+  beginContainer(key, true);
+}
+
+void JsonWriter::endArray()
+{
+  endContainer(true);
+}
+
+void JsonWriter::writeValue(const char* key, const std::string& value)
+{
+  beginElement(key);
+  _buffer += '"';
+  appendEscaped(value.data(), value.size());
+  _buffer += '"';
+}
+
+void JsonWriter::appendFragment(const JsonWriter& fragment)
+{
+  const std::size_t nbElements = fragment._stack.front().nbElements;
+  if(nbElements == 0)
+    return;
+
+  if(_stack.size() < 2 || !_stack.back().isArray || fragment._baseDepth != getDepth())
+    throw std::logic_error("JsonWriter: the fragment should be appended in an array of the same depth.");
+
+  beginSeparator();
+  _stack.back().nbElements += nbElements;
+  _buffer += fragment._buffer;
+  flush();
+}
+
+void JsonWriter::close()
+{
+  if(_file == nullptr || _stack.size() != 1)
+    throw std::logic_error("JsonWriter: the document is not complete.");
+
+  const bool isEmpty = (_stack.front().nbElements == 0);
+  _stack.clear();
+  if(!isEmpty)
+    _buffer += '\n';
+  _buffer += "}\n";
+  flush(true);
+
+  const bool ok = (std::fclose(_file) == 0);
+  _file = nullptr;
+  if(!ok)
+    throw std::runtime_error("Unable to write the JSON file.");
+}
+
+void JsonWriter::beginContainer(const char* key, bool isArray)
+{
+  beginElement(key);
+  // opened with the first element, as an empty container is written as an empty string
+  _stack.push_back({isArray, false, 0});
+}
+
+void JsonWriter::endContainer(bool isArray)
+{
+  if(_stack.size() < 2 || _stack.back().isArray != isArray)
+    throw std::logic_error("JsonWriter: invalid end of container.");
+
+  const Container container = _stack.back();
+  _stack.pop_back();
+
+  if(!container.isOpened)
+  {
+    _buffer += "\"\"";
+  }
+  else
+  {
+    _buffer += '\n';
+    _buffer.append(4 * (_baseDepth + _stack.size()), ' ');
+    _buffer += isArray ? ']' : '}';
+  }
+
+  // end of a top-level element or of an element of a top-level array
+  if(_stack.size() <= 2)
+    flush();
+}
+
+void JsonWriter::beginSeparator()
+{
+  Container& container = _stack.back();
+
+  if(container.nbElements > 0)
+  {
+    _buffer += ",\n";
+  }
+  else if(!container.isOpened)
+  {
+    _buffer += container.isArray ? "[\n" : "{\n";
+    container.isOpened = true;
+  }
+}
+
+void JsonWriter::beginElement(const char* key)
+{
+  beginSeparator();
+
+  Container& container = _stack.back();
+  ++container.nbElements;
+  _buffer.append(4 * (_baseDepth + _stack.size()), ' ');
+
+  if(!container.isArray)
+  {
+    _buffer += '"';
+    appendEscaped(key, std::strlen(key));
+    _buffer += "\": ";
+  }
+}
+
+void JsonWriter::appendEscaped(const char* str, std::size_t size)
+{
+  // same escapes as boost::property_tree::json_parser
+  for(std::size_t i = 0; i < size; ++i)
+  {
+    const unsigned char c = static_cast<unsigned char>(str[i]);
+
+    if(c == 0x20 || c == 0x21 || (c >= 0x23 && c <= 0x2E) || (c >= 0x30 && c <= 0x5B) || c >= 0x5D)
+    {
+      _buffer += static_cast<char>(c);
+      continue;
+    }
+
+    switch(c)
+    {
+      case '\b': _buffer += "\\b"; break;
+      case '\f': _buffer += "\\f"; break;
+      case '\n': _buffer += "\\n"; break;
+      case '\r': _buffer += "\\r"; break;
+      case '\t': _buffer += "\\t"; break;
+      case '/':  _buffer += "\\/"; break;
+      case '"':  _buffer += "\\\""; break;
+      case '\\': _buffer += "\\\\"; break;
+      default:
+      {
+        const char* hexDigits = "0123456789ABCDEF";
+        _buffer += "\\u00";
+        _buffer += hexDigits[c / 16];
+        _buffer += hexDigits[c % 16];
+      }
+    }
+  }
+}
+
+void JsonWriter::flush(bool force)
+{
+  if(_file == nullptr || (!force && _buffer.size() < flushSize))
+    return;
+
+  if(std::fwrite(_buffer.data(), 1, _buffer.size(), _file) != _buffer.size())
+    throw std::runtime_error("Unable to write the JSON file.");
+  _buffer.clear();
+}
+
+} // namespace sfm
+} // namespace aliceVision
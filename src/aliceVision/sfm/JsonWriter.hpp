@@ -0,0 +1,138 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Streaming JSON writer.
+ *
+ * The output is the same as boost::property_tree::write_json:
+ * 4 spaces indentation, all the values are quoted strings,
+ * and an empty object or array is written as an empty string.
+ */
+class JsonWriter
+{
+public:
+  /**
+   * @brief Write a JSON document in a file.
+   * The root object is opened by the constructor and closed by close().
+   * @param[in] filename The output filename
+   */
+  explicit JsonWriter(const std::string& filename);
+
+  /**
+   * @brief Write a fragment of a JSON document in a buffer:
+   * a sequence of elements of an array, to append later with appendFragment().
+   * @param[in] arrayDepth The depth of the parent array in the document
+   */
+  explicit JsonWriter(int arrayDepth);
+
+  ~JsonWriter();
+
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+
+  /// The key is ignored in an array
+  void beginObject(const char* key = "");
+  void endObject();
+
+  /// The key is ignored in an array
+  void beginArray(const char* key = "");
+  void endArray();
+
+  void writeValue(const char* key, const std::string& value);
+
+  template<typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value>::type writeValue(const char* key, T value)
+  {
+    beginElement(key);
+    _buffer += '"';
+    appendNumber(value, std::is_floating_point<T>());
+    _buffer += '"';
+  }
+
+  /// Write an Eigen Matrix (or Vector) as an array of values
+  template<typename Derived>
+  void writeMatrix(const char* key, const Eigen::MatrixBase<Derived>& matrix)
+  {
+    beginArray(key);
+    for(int i = 0; i < matrix.size(); ++i)
+      writeValue("", matrix(i));
+    endArray();
+  }
+
+  /**
+   * @brief Append the elements written by a fragment writer in the current array.
+   * @param[in] fragment The fragment writer, created with the depth of the current array
+   */
+  void appendFragment(const JsonWriter& fragment);
+
+  /// @return the depth of the current container in the document
+  int getDepth() const { return _baseDepth + static_cast<int>(_stack.size()) - 1; }
+
+  /// @return the content written in the buffer (not yet written in the file)
+  const std::string& getBuffer() const { return _buffer; }
+
+  /**
+   * @brief Close the root object and the file.
+   * Throws if the file cannot be written.
+   */
+  void close();
+
+private:
+  struct Container
+  {
+    bool isArray;
+    bool isOpened;
+    std::size_t nbElements;
+  };
+
+  void beginContainer(const char* key, bool isArray);
+  void endContainer(bool isArray);
+  void beginSeparator();
+  void beginElement(const char* key);
+  void appendEscaped(const char* str, std::size_t size);
+  void flush(bool force = false);
+
+  template<typename T>
+  void appendNumber(T value, std::true_type /*floating point*/)
+  {
+    // same precision as boost::property_tree
+    char str[64];
+    const int size = std::snprintf(str, sizeof(str), "%.*g", std::numeric_limits<T>::max_digits10, static_cast<double>(value));
+    _buffer.append(str, size);
+  }
+
+  template<typename T>
+  void appendNumber(T value, std::false_type /*integer*/)
+  {
+    // char types are written as numbers
+    if(std::is_signed<T>::value)
+      _buffer += std::to_string(static_cast<long long>(value));
+    else
+      _buffer += std::to_string(static_cast<unsigned long long>(value));
+  }
+
+  std::FILE* _file = nullptr;
+  std::string _buffer;
+  std::vector<Container> _stack;
+  int _baseDepth = 0;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -10,6 +10,8 @@
 #include <aliceVision/track/Track.hpp>
 #include <aliceVision/sfm/SfMData.hpp>
 
+#include <lemon/list_graph.h>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -5,6 +5,7 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file,
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
+#include "AlembicExporter.hpp"
 #include "AlembicImporter.hpp"
 #include "SfMData.hpp"
 #include "sfmDataIO.hpp"
@@ -262,3 +263,43 @@ BOOST_AUTO_TEST_CASE(AlembicImporter_importExport) {
     }
 
 }
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a random scene
+// - Export to Alembic with several points chunks
+// - Import all the parts
+// - Import only the points, then only the cameras
+//-----------------
+BOOST_AUTO_TEST_CASE(AlembicImporter_chunksAndParts)
+{
+    const SfMData sfmData = createTestScene(5, 50, 2, 3, true);
+
+    const std::string abcFile = "chunks.abc";
+    {
+        AlembicExporter exporter(abcFile);
+        exporter.setLandmarksChunkSize(7);
+        exporter.addSfM(sfmData, ESfMData(ALL));
+    }
+
+    SfMData sfmAll;
+    AlembicImporter(abcFile).populateSfM(sfmAll, ESfMData(ALL));
+    BOOST_CHECK(sfmData == sfmAll);
+
+    SfMData sfmPoints;
+    AlembicImporter(abcFile).populateSfM(sfmPoints, ESfMData(STRUCTURE));
+    BOOST_CHECK_EQUAL(sfmPoints.structure.size(), sfmData.structure.size());
+    BOOST_CHECK(sfmPoints.views.empty());
+    BOOST_CHECK(sfmPoints.intrinsics.empty());
+    BOOST_CHECK(sfmPoints.GetPoses().empty());
+    for(const auto& landmarkPair : sfmPoints.structure)
+      BOOST_CHECK(landmarkPair.second.observations.empty());
+
+    SfMData sfmCameras;
+    AlembicImporter(abcFile).populateSfM(sfmCameras, ESfMData(VIEWS|INTRINSICS|EXTRINSICS));
+    BOOST_CHECK(sfmCameras.structure.empty());
+    BOOST_CHECK_EQUAL(sfmCameras.views.size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL(sfmCameras.intrinsics.size(), sfmData.intrinsics.size());
+    BOOST_CHECK_EQUAL(sfmCameras.GetPoses().size(), sfmData.GetPoses().size());
+}
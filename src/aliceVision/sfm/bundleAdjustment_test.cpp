@@ -134,6 +134,44 @@ BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_EffectiveMinimization_PinholeFisheye) {
   BOOST_CHECK( dResidual_before > dResidual_after);
 }
 
+// Test summary:
+// - Adjust a scene, then modify it as the incremental SfM does (removed pose, landmark and
+//   observation, moved landmark, refined intrinsics) and adjust it again with the same object
+// - Check that the updated problem gives the same result as a new one
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_PersistentProblem) {
+
+  const int nviews = 4;
+  const int npoints = 8;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA_RADIAL3);
+
+  BundleAdjustmentCeres ba_object;
+  BOOST_CHECK( ba_object.Adjust(sfmData, BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE) );
+
+  // remove the pose of the view 3 and its observations
+  sfmData.GetPoses().erase(sfmData.views.at(3)->getPoseId());
+  for(auto& landmarkIt : sfmData.structure)
+    landmarkIt.second.observations.erase(3);
+  // remove a landmark and an observation, move a landmark
+  sfmData.structure.erase(0);
+  sfmData.structure.at(1).observations.erase(0);
+  sfmData.structure.at(2).X += Vec3(0.1, -0.1, 0.1);
+
+  SfMData sfmData_newProblem = sfmData;
+  const double dResidual_before = RMSE(sfmData);
+
+  BOOST_CHECK( ba_object.Adjust(sfmData) );
+  BOOST_CHECK( BundleAdjustmentCeres().Adjust(sfmData_newProblem) );
+
+  const double dResidual_after = RMSE(sfmData);
+  BOOST_CHECK( dResidual_before > dResidual_after);
+  BOOST_CHECK_SMALL( dResidual_after - RMSE(sfmData_newProblem), 1e-3);
+}
+
 BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_CamerasRing) {
 
   const int nviews = 4;
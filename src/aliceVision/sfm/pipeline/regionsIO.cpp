@@ -6,18 +6,153 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "regionsIO.hpp"
+#include <aliceVision/feature/RegionsContainer.hpp>
 
 #include <boost/progress.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <ctime>
+#include <map>
+#include <utility>
 
 namespace fs = boost::filesystem;
 
 namespace aliceVision {
 namespace sfm {
 
+namespace {
+
+typedef std::vector<std::unique_ptr<feature::RegionsContainerReader>> RegionsContainers;
+
+/**
+ * @brief Open the regions container files (*.regions) of the given folders.
+ * The containers of the last folders are first, as the per view files of the last folders are preferred.
+ */
+RegionsContainers openRegionsContainers(const std::vector<std::string>& folders)
+{
+  RegionsContainers containers;
+  for(auto folderIt = folders.rbegin(); folderIt != folders.rend(); ++folderIt)
+  {
+    if(!fs::is_directory(*folderIt))
+      continue;
+
+    std::vector<fs::path> containerPaths;
+    for(const auto& entry : fs::directory_iterator(*folderIt))
+    {
+      if(fs::is_regular_file(entry.path()) && entry.path().extension() == feature::REGIONS_CONTAINER_EXTENSION)
+        containerPaths.push_back(entry.path());
+    }
+    std::sort(containerPaths.begin(), containerPaths.end());
+
+    for(const fs::path& containerPath : containerPaths)
+    {
+      ALICEVISION_LOG_DEBUG("Regions container: " << containerPath.string());
+      containers.emplace_back(new feature::RegionsContainerReader(containerPath.string()));
+    }
+  }
+  return containers;
+}
+
+/**
+ * @brief Get the last write time of the per view files (*.feat, *.desc) of a view and describer type.
+ * @return 0 if there is no per view file
+ */
+std::time_t getLastPerViewFileWriteTime(const std::vector<std::string>& folders,
+                                        IndexT viewId,
+                                        feature::EImageDescriberType describerType)
+{
+  const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(describerType);
+  std::time_t lastWriteTime = 0;
+  for(const std::string& folder : folders)
+  {
+    for(const std::string extension : {".feat", ".desc"})
+    {
+      const fs::path path = fs::path(folder) / std::string(std::to_string(viewId) + "." + imageDescriberTypeName + extension);
+      boost::system::error_code ec;
+      const std::time_t writeTime = fs::last_write_time(path, ec);
+      if(!ec)
+        lastWriteTime = std::max(lastWriteTime, writeTime);
+    }
+  }
+  return lastWriteTime;
+}
+
+/// Container selected for each view and describer type
+typedef std::map<std::pair<IndexT, feature::EImageDescriberType>, const feature::RegionsContainerReader*> RegionsContainerPerView;
+
+/**
+ * @brief Select for each requested view and describer type the first container that has its regions
+ * and that is not older than its per view files. The views without such container use the per view files.
+ * The views may be spread over several containers (e.g. one per extraction range), and a stale container
+ * (e.g. written before a new extraction of some views) must not hide the per view files of these views.
+ */
+RegionsContainerPerView selectRegionsContainers(const RegionsContainers& containers,
+                                                const std::vector<std::string>& folders,
+                                                const std::set<IndexT>& viewIds,
+                                                const std::vector<feature::EImageDescriberType>& imageDescriberTypes)
+{
+  RegionsContainerPerView selected;
+  if(containers.empty())
+    return selected;
+
+  std::vector<std::time_t> containerWriteTimes;
+  for(const auto& container : containers)
+    containerWriteTimes.push_back(fs::last_write_time(container->getFilepath()));
+
+  std::size_t nbStaleRegions = 0;
+  for(IndexT viewId : viewIds)
+  {
+    for(feature::EImageDescriberType describerType : imageDescriberTypes)
+    {
+      const std::time_t lastPerViewFileWriteTime = getLastPerViewFileWriteTime(folders, viewId, describerType);
+      bool isStale = false;
+      for(std::size_t i = 0; i < containers.size(); ++i)
+      {
+        if(!containers[i]->hasRegions(viewId, describerType))
+          continue;
+        if(containerWriteTimes[i] < lastPerViewFileWriteTime)
+        {
+          isStale = true;
+          continue;
+        }
+        selected.emplace(std::make_pair(viewId, describerType), containers[i].get());
+        isStale = false;
+        break;
+      }
+      if(isStale)
+        ++nbStaleRegions;
+    }
+  }
+
+  ALICEVISION_LOG_INFO("Regions containers: " << selected.size() << " of " << viewIds.size() * imageDescriberTypes.size()
+                       << " view regions found, " << nbStaleRegions << " older than the view files.");
+  return selected;
+}
+
+/**
+ * @brief Load the regions of one view from its selected container.
+ * @return loaded Regions or nullptr if no container is selected for the view
+ */
+std::unique_ptr<feature::Regions> loadRegionsFromContainers(const RegionsContainerPerView& containers,
+                                                            IndexT viewId,
+                                                            const feature::ImageDescriber& imageDescriber,
+                                                            bool loadDescriptors)
+{
+  const auto it = containers.find(std::make_pair(viewId, imageDescriber.getDescriberType()));
+  if(it == containers.end())
+    return nullptr;
+
+  std::unique_ptr<feature::Regions> regionsPtr;
+  imageDescriber.allocate(regionsPtr);
+  it->second->load(viewId, imageDescriber.getDescriberType(), *regionsPtr, loadDescriptors);
+  return regionsPtr;
+}
+
+} // namespace
+
 std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
                                               IndexT viewId,
                                               const feature::ImageDescriber& imageDescriber)
@@ -135,6 +270,15 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
   for(std::size_t i =0; i < imageDescriberTypes.size(); ++i)
     imageDescribers[i] = createImageDescriber(imageDescriberTypes[i]);
 
+  std::set<IndexT> viewIds;
+  for(const auto& viewPair : sfmData.GetViews())
+  {
+    if(viewIdFilter.empty() || viewIdFilter.count(viewPair.first))
+      viewIds.insert(viewPair.first);
+  }
+  const RegionsContainers openedContainers = openRegionsContainers(featuresFolders);
+  const RegionsContainerPerView containers = selectRegionsContainers(openedContainers, featuresFolders, viewIds, imageDescriberTypes);
+
 #pragma omp parallel num_threads(3)
  for (auto iter = sfmData.GetViews().begin();
    iter != sfmData.GetViews().end() && !invalid; ++iter)
@@ -145,7 +289,10 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
      {
        if(viewIdFilter.empty() || viewIdFilter.find(iter->second.get()->getViewId()) != viewIdFilter.end())
        {
-         std::unique_ptr<feature::Regions> regionsPtr = loadRegions(featuresFolders, iter->second.get()->getViewId(), *imageDescribers[i]);
+         const IndexT viewId = iter->second.get()->getViewId();
+         std::unique_ptr<feature::Regions> regionsPtr = loadRegionsFromContainers(containers, viewId, *imageDescribers[i], true);
+         if(!regionsPtr)
+           regionsPtr = loadRegions(featuresFolders, viewId, *imageDescribers[i]);
 
          if(regionsPtr)
          {
@@ -188,6 +335,12 @@ bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
     imageDescribers[i] = createImageDescriber(imageDescriberTypes[i]);
   }
 
+  std::set<IndexT> viewIds;
+  for(const auto& viewPair : sfmData.GetViews())
+    viewIds.insert(viewPair.first);
+  const RegionsContainers openedContainers = openRegionsContainers(featuresFolders);
+  const RegionsContainerPerView containers = selectRegionsContainers(openedContainers, featuresFolders, viewIds, imageDescriberTypes);
+
 #pragma omp parallel
   for (auto iter = sfmData.GetViews().begin();
     (iter != sfmData.GetViews().end()) && (!invalid); ++iter)
@@ -196,7 +349,10 @@ bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
     {
       for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
       {
-        std::unique_ptr<feature::Regions> regionsPtr = loadFeatures(featuresFolders, iter->second.get()->getViewId(), *imageDescribers[i]);
+        const IndexT viewId = iter->second.get()->getViewId();
+        std::unique_ptr<feature::Regions> regionsPtr = loadRegionsFromContainers(containers, viewId, *imageDescribers[i], false);
+        if(!regionsPtr)
+          regionsPtr = loadFeatures(featuresFolders, viewId, *imageDescribers[i]);
 
 #pragma omp critical
         {
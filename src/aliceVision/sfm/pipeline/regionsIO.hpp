@@ -39,6 +39,8 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
 
 /**
  * @brief Load Regions (Features & Descriptors) for each view of the provided SfMData container.
+ * The regions of each view are read from the first regions container file (*.regions) of the feature folders
+ * that has them and is not older than the view files, otherwise from the view files (*.feat, *.desc).
  * @param[in,out] regionsPerView
  * @param[in] sfmData The provided SfMData container
  * @param[in] folder The feature Folder
@@ -54,6 +56,8 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
 
 /**
  * @brief Load Features for each view of the provided SfMData container.
+ * The features of each view are read from the first regions container file (*.regions) of the feature folders
+ * that has them and is not older than the view files, otherwise from the view files (*.feat).
  * @param[in,out] featuresPerView
  * @param[in] sfmData The provided SfMData container
  * @param[in] folder The feature Folder
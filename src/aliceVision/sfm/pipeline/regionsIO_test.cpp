@@ -0,0 +1,137 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/pipeline/regionsIO.hpp>
+#include <aliceVision/feature/RegionsContainer.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <ctime>
+#include <string>
+
+#define BOOST_TEST_MODULE regionsIO
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+const feature::EImageDescriberType describerType = feature::EImageDescriberType::SIFT;
+
+/// Offset of the features positions of the view files, to distinguish them from the containers ones
+const float viewFilesOffset = 1000.0f;
+
+/// Regions of a view, whose features positions identify the view and the source
+feature::SIFT_Regions createRegions(IndexT viewId, float offset)
+{
+  feature::SIFT_Regions regions;
+  for(IndexT i = 0; i <= viewId; ++i)
+  {
+    regions.Features().emplace_back(offset + viewId, static_cast<float>(i), 1.0f, 0.0f);
+    feature::SIFT_Regions::DescriptorT descriptor;
+    for(std::size_t d = 0; d < descriptor.size(); ++d)
+      descriptor[d] = static_cast<unsigned char>(viewId + i + d);
+    regions.Descriptors().push_back(descriptor);
+  }
+  return regions;
+}
+
+/// Write the view files (*.feat, *.desc) of a view with the given write time
+void writeViewFiles(const std::string& folder, IndexT viewId, std::time_t writeTime)
+{
+  const std::string basename = (fs::path(folder) / (std::to_string(viewId) + "." + feature::EImageDescriberType_enumToString(describerType))).string();
+  createRegions(viewId, viewFilesOffset).Save(basename + ".feat", basename + ".desc");
+  fs::last_write_time(basename + ".feat", writeTime);
+  fs::last_write_time(basename + ".desc", writeTime);
+}
+
+/// Write a regions container of a range of views with the given write time
+void writeContainer(const std::string& filepath, IndexT firstViewId, IndexT nbViews, std::time_t writeTime)
+{
+  {
+    feature::RegionsContainerWriter writer(filepath);
+    for(IndexT viewId = firstViewId; viewId < firstViewId + nbViews; ++viewId)
+      writer.add(viewId, describerType, createRegions(viewId, 0.0f));
+    writer.close();
+  }
+  fs::last_write_time(filepath, writeTime);
+}
+
+/// Check the loaded regions of each view, and if they come from a container
+void checkLoadedRegions(const SfMData& sfmData, const std::string& folder, const std::set<IndexT>& viewsFromFiles)
+{
+  feature::RegionsPerView regionsPerView;
+  BOOST_REQUIRE(loadRegionsPerView(regionsPerView, sfmData, folder, {describerType}));
+
+  feature::FeaturesPerView featuresPerView;
+  BOOST_REQUIRE(loadFeaturesPerView(featuresPerView, sfmData, folder, {describerType}));
+
+  for(const auto& viewPair : sfmData.GetViews())
+  {
+    const IndexT viewId = viewPair.first;
+    const float offset = viewsFromFiles.count(viewId) ? viewFilesOffset : 0.0f;
+    const feature::SIFT_Regions expected = createRegions(viewId, offset);
+
+    const auto& regions = dynamic_cast<const feature::SIFT_Regions&>(regionsPerView.getRegions(viewId, describerType));
+    BOOST_REQUIRE_EQUAL(regions.RegionCount(), expected.RegionCount());
+    for(std::size_t i = 0; i < expected.RegionCount(); ++i)
+    {
+      BOOST_CHECK_EQUAL(regions.Features()[i].x(), expected.Features()[i].x());
+      BOOST_CHECK_EQUAL(regions.Features()[i].y(), expected.Features()[i].y());
+      BOOST_CHECK(regions.Descriptors()[i] == expected.Descriptors()[i]);
+    }
+
+    const feature::PointFeatures& features = featuresPerView.getFeatures(viewId, describerType);
+    BOOST_REQUIRE_EQUAL(features.size(), expected.RegionCount());
+    for(std::size_t i = 0; i < features.size(); ++i)
+      BOOST_CHECK_EQUAL(features[i].x(), expected.Features()[i].x());
+  }
+}
+
+} // namespace
+
+// featureExtraction writes one container per range of views, next to the view files
+
+BOOST_AUTO_TEST_CASE(regionsIO_rangeContainers)
+{
+  const std::string folder = "regionsIO_rangeContainers";
+  fs::remove_all(folder);
+  fs::create_directories(folder);
+
+  const IndexT nbViews = 7;
+  SfMData sfmData;
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+    sfmData.views.emplace(viewId, std::make_shared<View>("", viewId, 0, 0, 100, 100));
+
+  const std::time_t t0 = std::time(nullptr) - 3600;
+
+  // the views of the two first ranges are in their containers, the last view only in view files
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+    writeViewFiles(folder, viewId, t0);
+  writeContainer((fs::path(folder) / ("regions_0" + feature::REGIONS_CONTAINER_EXTENSION)).string(), 0, 3, t0 + 10);
+  writeContainer((fs::path(folder) / ("regions_3" + feature::REGIONS_CONTAINER_EXTENSION)).string(), 3, 3, t0 + 20);
+  checkLoadedRegions(sfmData, folder, {6});
+
+  // the view files of the last range, written after the first container, don't make it stale
+  for(IndexT viewId = 3; viewId < 6; ++viewId)
+    writeViewFiles(folder, viewId, t0 + 15);
+  checkLoadedRegions(sfmData, folder, {6});
+
+  // a view extracted again after its container is read from its view files
+  writeViewFiles(folder, 1, t0 + 30);
+  checkLoadedRegions(sfmData, folder, {1, 6});
+
+  // a filter on the views
+  feature::RegionsPerView regionsPerView;
+  BOOST_REQUIRE(loadRegionsPerView(regionsPerView, sfmData, folder, {describerType}, {2, 4}));
+  BOOST_CHECK_EQUAL(regionsPerView.getData().size(), 2);
+
+  fs::remove_all(folder);
+}
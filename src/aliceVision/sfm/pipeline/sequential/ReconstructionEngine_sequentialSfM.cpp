@@ -1846,11 +1846,17 @@ bool ReconstructionEngine_sequentialSfM::BundleAdjustment(bool fixedIntrinsics)
     ALICEVISION_LOG_DEBUG("Global BundleAdjustment dense");
     options.setDenseBA();
   }
-  BundleAdjustmentCeres bundle_adjustment_obj(options);
+
+  // the problem of the previous call is updated with the new and removed elements of the scene
+  if(!_bundleAdjustment)
+    _bundleAdjustment = std::make_shared<BundleAdjustmentCeres>(options);
+  else
+    _bundleAdjustment->setOptions(options);
+
   BA_Refine refineOptions = BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE;
   if(!fixedIntrinsics)
     refineOptions |= BA_REFINE_INTRINSICS_ALL;
-  return bundle_adjustment_obj.Adjust(_sfm_data, refineOptions);
+  return _bundleAdjustment->Adjust(_sfm_data, refineOptions);
 }
 
 bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<IndexT>& newReconstructedViews)
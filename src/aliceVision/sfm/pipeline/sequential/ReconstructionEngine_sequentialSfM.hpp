@@ -27,6 +27,8 @@ namespace pt = boost::property_tree;
 namespace aliceVision {
 namespace sfm {
 
+class BundleAdjustmentCeres;
+
 /// Image score contains <ImageId, NbPutativeCommonPoint, score, isIntrinsicsReconstructed>
 typedef std::tuple<IndexT, std::size_t, std::size_t, bool> ViewConnectionScore;
 
@@ -376,6 +378,11 @@ private:
   /// Contains all the data used by the Local BA approach
   std::shared_ptr<LocalBundleAdjustmentData> _localBA_data;
 
+  // Global Bundle Adjustment data
+
+  /// Bundle adjustment problem, updated from one global BA to another
+  std::shared_ptr<BundleAdjustmentCeres> _bundleAdjustment;
+
   // Intermediate reconstructions
 
   /// extension of the intermediate reconstruction files
@@ -0,0 +1,674 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "sfmDataIO_binary.hpp"
+#include <aliceVision/camera/camera.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace bip = boost::interprocess;
+
+namespace {
+
+const char binaryMagic[8] = {'A', 'V', 'S', 'F', 'M', 'B', 'I', 'N'};
+const std::uint32_t binaryVersion = 1;
+
+enum class ESection : std::uint32_t
+{
+  FOLDERS = 0,
+  VIEWS,
+  INTRINSICS,
+  POSES,
+  RIGS,
+  STRUCTURE,
+  CONTROL_POINTS,
+  POSES_UNCERTAINTY,
+  LANDMARKS_UNCERTAINTY
+};
+
+struct SectionEntry
+{
+  std::uint32_t type;
+  std::uint32_t reserved;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+/// Fixed-size landmark record, its observations are stored in the observations array
+struct BinaryLandmark
+{
+  double X[3];
+  std::uint32_t landmarkId;
+  /// index in the describer types table of the section
+  std::uint32_t descType;
+  std::uint32_t nbObservations;
+  std::uint8_t rgb[3];
+  std::uint8_t padding;
+};
+
+/// Fixed-size observation record
+struct BinaryObservation
+{
+  double x[2];
+  std::uint32_t viewId;
+  std::uint32_t featureId;
+};
+
+static_assert(sizeof(BinaryLandmark) == 40, "Unexpected size of the binary landmark record");
+static_assert(sizeof(BinaryObservation) == 24, "Unexpected size of the binary observation record");
+
+/**
+ * @brief Sequential writer of a binary file.
+ */
+class BinaryWriter
+{
+public:
+  explicit BinaryWriter(const std::string& filename)
+    : _file(std::fopen(filename.c_str(), "wb"))
+  {
+    if(_file == nullptr)
+      throw std::runtime_error("Unable to open the file: " + filename);
+  }
+
+  ~BinaryWriter()
+  {
+    if(_file != nullptr)
+      std::fclose(_file);
+  }
+
+  std::uint64_t position() const { return _position; }
+
+  void writeData(const void* data, std::size_t size)
+  {
+    if(size > 0 && std::fwrite(data, 1, size, _file) != size)
+      throw std::runtime_error("Unable to write the binary SfMData file.");
+    _position += size;
+  }
+
+  template<typename T>
+  void write(const T& value)
+  {
+    writeData(&value, sizeof(T));
+  }
+
+  void writeString(const std::string& str)
+  {
+    write<std::uint64_t>(str.size());
+    writeData(str.data(), str.size());
+  }
+
+  template<typename Derived>
+  void writeMatrix(const Eigen::MatrixBase<Derived>& matrix)
+  {
+    for(int i = 0; i < matrix.size(); ++i)
+      write<double>(matrix(i));
+  }
+
+  void writePose3(const geometry::Pose3& pose)
+  {
+    writeMatrix(pose.rotation());
+    writeMatrix(pose.center());
+  }
+
+  /// Rewrite some data at the given position and go back to the end of the file
+  void rewriteData(std::uint64_t position, const void* data, std::size_t size)
+  {
+    if(std::fseek(_file, static_cast<long>(position), SEEK_SET) != 0 ||
+       std::fwrite(data, 1, size, _file) != size ||
+       std::fseek(_file, 0, SEEK_END) != 0)
+      throw std::runtime_error("Unable to write the binary SfMData file.");
+  }
+
+  void close()
+  {
+    const bool ok = (std::fclose(_file) == 0);
+    _file = nullptr;
+    if(!ok)
+      throw std::runtime_error("Unable to write the binary SfMData file.");
+  }
+
+private:
+  std::FILE* _file;
+  std::uint64_t _position = 0;
+};
+
+/**
+ * @brief Sequential reader of a memory buffer (a section of the mapped file).
+ */
+class BinaryReader
+{
+public:
+  BinaryReader(const char* data, std::size_t size)
+    : _data(data)
+    , _size(size)
+  {}
+
+  const char* readData(std::size_t size)
+  {
+    if(size > _size - _position)
+      throw std::runtime_error("Truncated binary SfMData section.");
+    const char* data = _data + _position;
+    _position += size;
+    return data;
+  }
+
+  template<typename T>
+  T read()
+  {
+    T value;
+    std::memcpy(&value, readData(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string readString()
+  {
+    const std::uint64_t size = read<std::uint64_t>();
+    const char* data = readData(size);
+    return std::string(data, size);
+  }
+
+  template<typename Derived>
+  void readMatrix(Eigen::MatrixBase<Derived>& matrix)
+  {
+    for(int i = 0; i < matrix.size(); ++i)
+      matrix(i) = read<double>();
+  }
+
+  geometry::Pose3 readPose3()
+  {
+    Mat3 rotation;
+    Vec3 center;
+    readMatrix(rotation);
+    readMatrix(center);
+    return geometry::Pose3(rotation, center);
+  }
+
+private:
+  const char* _data;
+  const std::size_t _size;
+  std::size_t _position = 0;
+};
+
+void writeFolders(BinaryWriter& writer, const std::vector<std::string>& folders)
+{
+  writer.write<std::uint64_t>(folders.size());
+  for(const std::string& folder : folders)
+    writer.writeString(folder);
+}
+
+void writeViews(BinaryWriter& writer, const Views& views)
+{
+  writer.write<std::uint64_t>(views.size());
+  for(const auto& viewPair : views)
+  {
+    const View& view = *viewPair.second;
+    writer.write<IndexT>(view.getViewId());
+    writer.write<IndexT>(view.getPoseId());
+    writer.write<IndexT>(view.getRigId());
+    writer.write<IndexT>(view.getSubPoseId());
+    writer.write<IndexT>(view.getIntrinsicId());
+    writer.write<IndexT>(view.getResectionId());
+    writer.writeString(view.getImagePath());
+    writer.write<std::uint64_t>(view.getWidth());
+    writer.write<std::uint64_t>(view.getHeight());
+
+    writer.write<std::uint64_t>(view.getMetadata().size());
+    for(const auto& metadataPair : view.getMetadata())
+    {
+      writer.writeString(metadataPair.first);
+      writer.writeString(metadataPair.second);
+    }
+  }
+}
+
+void readViews(BinaryReader& reader, Views& views)
+{
+  const std::uint64_t nbViews = reader.read<std::uint64_t>();
+  for(std::uint64_t i = 0; i < nbViews; ++i)
+  {
+    View view;
+    view.setViewId(reader.read<IndexT>());
+    view.setPoseId(reader.read<IndexT>());
+    const IndexT rigId = reader.read<IndexT>();
+    const IndexT subPoseId = reader.read<IndexT>();
+    if(rigId != UndefinedIndexT)
+      view.setRigAndSubPoseId(rigId, subPoseId);
+    view.setIntrinsicId(reader.read<IndexT>());
+    view.setResectionId(reader.read<IndexT>());
+    view.setImagePath(reader.readString());
+    view.setWidth(reader.read<std::uint64_t>());
+    view.setHeight(reader.read<std::uint64_t>());
+
+    const std::uint64_t nbMetadata = reader.read<std::uint64_t>();
+    for(std::uint64_t m = 0; m < nbMetadata; ++m)
+    {
+      const std::string key = reader.readString();
+      view.addMetadata(key, reader.readString());
+    }
+
+    views.emplace(view.getViewId(), std::make_shared<View>(view));
+  }
+}
+
+void writeIntrinsics(BinaryWriter& writer, const Intrinsics& intrinsics)
+{
+  writer.write<std::uint64_t>(intrinsics.size());
+  for(const auto& intrinsicPair : intrinsics)
+  {
+    const camera::IntrinsicBase& intrinsic = *intrinsicPair.second;
+    const camera::EINTRINSIC intrinsicType = intrinsic.getType();
+
+    writer.write<IndexT>(intrinsicPair.first);
+    writer.write<std::uint32_t>(intrinsic.w());
+    writer.write<std::uint32_t>(intrinsic.h());
+    writer.writeString(camera::EINTRINSIC_enumToString(intrinsicType));
+    writer.writeString(intrinsic.serialNumber());
+    writer.write<double>(intrinsic.initialFocalLengthPix());
+
+    const bool isPinhole = camera::isPinhole(intrinsicType);
+    writer.write<std::uint8_t>(isPinhole);
+    if(isPinhole)
+    {
+      const camera::Pinhole& pinholeIntrinsic = dynamic_cast<const camera::Pinhole&>(intrinsic);
+      writer.write<double>(pinholeIntrinsic.getFocalLengthPix());
+      writer.writeMatrix(pinholeIntrinsic.getPrincipalPoint());
+
+      const std::vector<double> distortionParams = pinholeIntrinsic.getDistortionParams();
+      writer.write<std::uint64_t>(distortionParams.size());
+      writer.writeData(distortionParams.data(), distortionParams.size() * sizeof(double));
+    }
+  }
+}
+
+void readIntrinsics(BinaryReader& reader, Intrinsics& intrinsics)
+{
+  const std::uint64_t nbIntrinsics = reader.read<std::uint64_t>();
+  for(std::uint64_t i = 0; i < nbIntrinsics; ++i)
+  {
+    const IndexT intrinsicId = reader.read<IndexT>();
+    const unsigned int width = reader.read<std::uint32_t>();
+    const unsigned int height = reader.read<std::uint32_t>();
+    const camera::EINTRINSIC intrinsicType = camera::EINTRINSIC_stringToEnum(reader.readString());
+    const std::string serialNumber = reader.readString();
+    const double pxInitialFocalLength = reader.read<double>();
+
+    // check if the camera is a Pinhole model
+    if(!reader.read<std::uint8_t>() || !camera::isPinhole(intrinsicType))
+      throw std::out_of_range("Only Pinhole camera model supported");
+
+    const double pxFocalLength = reader.read<double>();
+    Vec2 principalPoint;
+    reader.readMatrix(principalPoint);
+
+    std::shared_ptr<camera::Pinhole> pinholeIntrinsic = camera::createPinholeIntrinsic(intrinsicType, width, height, pxFocalLength, principalPoint(0), principalPoint(1));
+    pinholeIntrinsic->setInitialFocalLengthPix(pxInitialFocalLength);
+    pinholeIntrinsic->setSerialNumber(serialNumber);
+
+    std::vector<double> distortionParams(reader.read<std::uint64_t>());
+    for(double& param : distortionParams)
+      param = reader.read<double>();
+    pinholeIntrinsic->setDistortionParams(distortionParams);
+
+    intrinsics.emplace(intrinsicId, std::static_pointer_cast<camera::IntrinsicBase>(pinholeIntrinsic));
+  }
+}
+
+void writePoses(BinaryWriter& writer, const Poses& poses)
+{
+  writer.write<std::uint64_t>(poses.size());
+  for(const auto& posePair : poses)
+  {
+    writer.write<IndexT>(posePair.first);
+    writer.writePose3(posePair.second);
+  }
+}
+
+void readPoses(BinaryReader& reader, Poses& poses)
+{
+  const std::uint64_t nbPoses = reader.read<std::uint64_t>();
+  for(std::uint64_t i = 0; i < nbPoses; ++i)
+  {
+    const IndexT poseId = reader.read<IndexT>();
+    poses.emplace(poseId, reader.readPose3());
+  }
+}
+
+void writeRigs(BinaryWriter& writer, const Rigs& rigs)
+{
+  writer.write<std::uint64_t>(rigs.size());
+  for(const auto& rigPair : rigs)
+  {
+    writer.write<IndexT>(rigPair.first);
+    writer.write<std::uint64_t>(rigPair.second.getSubPoses().size());
+    for(const RigSubPose& rigSubPose : rigPair.second.getSubPoses())
+    {
+      writer.writeString(ERigSubPoseStatus_enumToString(rigSubPose.status));
+      writer.writePose3(rigSubPose.pose);
+    }
+  }
+}
+
+void readRigs(BinaryReader& reader, Rigs& rigs)
+{
+  const std::uint64_t nbRigs = reader.read<std::uint64_t>();
+  for(std::uint64_t i = 0; i < nbRigs; ++i)
+  {
+    const IndexT rigId = reader.read<IndexT>();
+    const std::uint64_t nbSubPoses = reader.read<std::uint64_t>();
+    Rig rig(nbSubPoses);
+    for(std::uint64_t subPoseId = 0; subPoseId < nbSubPoses; ++subPoseId)
+    {
+      RigSubPose subPose;
+      subPose.status = ERigSubPoseStatus_stringToEnum(reader.readString());
+      subPose.pose = reader.readPose3();
+      rig.setSubPose(subPoseId, subPose);
+    }
+    rigs.emplace(rigId, rig);
+  }
+}
+
+void writeLandmarks(BinaryWriter& writer, const Landmarks& landmarks)
+{
+  // describer types table
+  std::map<feature::EImageDescriberType, std::uint32_t> descTypes;
+  std::uint64_t nbObservations = 0;
+  for(const auto& landmarkPair : landmarks)
+  {
+    descTypes.emplace(landmarkPair.second.descType, descTypes.size());
+    nbObservations += landmarkPair.second.observations.size();
+  }
+
+  std::vector<std::string> descTypesNames(descTypes.size());
+  for(const auto& descTypePair : descTypes)
+    descTypesNames.at(descTypePair.second) = feature::EImageDescriberType_enumToString(descTypePair.first);
+  writeFolders(writer, descTypesNames);
+
+  writer.write<std::uint64_t>(landmarks.size());
+  writer.write<std::uint64_t>(nbObservations);
+
+  for(const auto& landmarkPair : landmarks)
+  {
+    const Landmark& landmark = landmarkPair.second;
+    BinaryLandmark record;
+    for(int i = 0; i < 3; ++i)
+    {
+      record.X[i] = landmark.X(i);
+      record.rgb[i] = landmark.rgb(i);
+    }
+    record.landmarkId = landmarkPair.first;
+    record.descType = descTypes.at(landmark.descType);
+    record.nbObservations = landmark.observations.size();
+    record.padding = 0;
+    writer.write(record);
+  }
+
+  for(const auto& landmarkPair : landmarks)
+  {
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      BinaryObservation record;
+      record.x[0] = observationPair.second.x(0);
+      record.x[1] = observationPair.second.x(1);
+      record.viewId = observationPair.first;
+      record.featureId = observationPair.second.id_feat;
+      writer.write(record);
+    }
+  }
+}
+
+void readLandmarks(BinaryReader& reader, Landmarks& landmarks, bool loadObservations)
+{
+  const std::uint64_t nbDescTypes = reader.read<std::uint64_t>();
+  std::vector<feature::EImageDescriberType> descTypes(nbDescTypes);
+  for(feature::EImageDescriberType& descType : descTypes)
+    descType = feature::EImageDescriberType_stringToEnum(reader.readString());
+
+  const std::uint64_t nbLandmarks = reader.read<std::uint64_t>();
+  const std::uint64_t nbObservations = reader.read<std::uint64_t>();
+
+  // records are read in place from the mapped file
+  const char* landmarksData = reader.readData(nbLandmarks * sizeof(BinaryLandmark));
+  const char* observationsData = loadObservations ? reader.readData(nbObservations * sizeof(BinaryObservation)) : nullptr;
+
+  std::uint64_t observationIndex = 0;
+  for(std::uint64_t i = 0; i < nbLandmarks; ++i)
+  {
+    BinaryLandmark record;
+    std::memcpy(&record, landmarksData + i * sizeof(BinaryLandmark), sizeof(BinaryLandmark));
+
+    Landmark& landmark = landmarks[record.landmarkId];
+    landmark.X = Vec3(record.X[0], record.X[1], record.X[2]);
+    landmark.rgb = image::RGBColor(record.rgb[0], record.rgb[1], record.rgb[2]);
+    landmark.descType = descTypes.at(record.descType);
+
+    if(!loadObservations)
+      continue;
+
+    if(record.nbObservations > nbObservations - observationIndex)
+      throw std::runtime_error("Invalid number of observations in binary SfMData file.");
+
+    landmark.observations.reserve(record.nbObservations);
+    for(std::uint32_t o = 0; o < record.nbObservations; ++o, ++observationIndex)
+    {
+      BinaryObservation observation;
+      std::memcpy(&observation, observationsData + observationIndex * sizeof(BinaryObservation), sizeof(BinaryObservation));
+      landmark.observations.emplace_hint(landmark.observations.end(), observation.viewId,
+                                         Observation(Vec2(observation.x[0], observation.x[1]), observation.featureId));
+    }
+  }
+}
+
+template<typename Uncertainty>
+void writeUncertainty(BinaryWriter& writer, const Uncertainty& uncertainty)
+{
+  writer.write<std::uint64_t>(uncertainty.size());
+  for(const auto& uncertaintyPair : uncertainty)
+  {
+    writer.write<IndexT>(uncertaintyPair.first);
+    writer.writeMatrix(uncertaintyPair.second);
+  }
+}
+
+template<typename Uncertainty>
+void readUncertainty(BinaryReader& reader, Uncertainty& uncertainty)
+{
+  const std::uint64_t nbElements = reader.read<std::uint64_t>();
+  for(std::uint64_t i = 0; i < nbElements; ++i)
+  {
+    const IndexT id = reader.read<IndexT>();
+    reader.readMatrix(uncertainty[id]);
+  }
+}
+
+} // namespace
+
+bool saveBinary(const SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+  const bool savePosesUncertainty = (partFlag & POSES_UNCERTAINTY) == POSES_UNCERTAINTY;
+  const bool saveLandmarksUncertainty = (partFlag & LANDMARKS_UNCERTAINTY) == LANDMARKS_UNCERTAINTY;
+
+  std::vector<ESection> sections = {ESection::FOLDERS};
+  if(saveViews)
+    sections.push_back(ESection::VIEWS);
+  if(saveIntrinsics)
+    sections.push_back(ESection::INTRINSICS);
+  if(saveExtrinsics)
+  {
+    sections.push_back(ESection::POSES);
+    sections.push_back(ESection::RIGS);
+  }
+  if(saveStructure)
+    sections.push_back(ESection::STRUCTURE);
+  if(saveControlPoints)
+    sections.push_back(ESection::CONTROL_POINTS);
+  if(savePosesUncertainty)
+    sections.push_back(ESection::POSES_UNCERTAINTY);
+  if(saveLandmarksUncertainty)
+    sections.push_back(ESection::LANDMARKS_UNCERTAINTY);
+
+  try
+  {
+    BinaryWriter writer(filename);
+
+    // header
+    writer.writeData(binaryMagic, sizeof(binaryMagic));
+    writer.write<std::uint32_t>(binaryVersion);
+    writer.write<std::uint32_t>(sections.size());
+
+    // table of contents, written again when the sections are saved
+    const std::uint64_t tocPosition = writer.position();
+    std::vector<SectionEntry> toc(sections.size());
+    writer.writeData(toc.data(), toc.size() * sizeof(SectionEntry));
+
+    for(std::size_t i = 0; i < sections.size(); ++i)
+    {
+      toc[i].type = static_cast<std::uint32_t>(sections[i]);
+      toc[i].reserved = 0;
+      toc[i].offset = writer.position();
+
+      switch(sections[i])
+      {
+        case ESection::FOLDERS:
+          writeFolders(writer, sfmData.getRelativeFeaturesFolders());
+          writeFolders(writer, sfmData.getRelativeMatchesFolders());
+          break;
+        case ESection::VIEWS:                 writeViews(writer, sfmData.GetViews()); break;
+        case ESection::INTRINSICS:            writeIntrinsics(writer, sfmData.GetIntrinsics()); break;
+        case ESection::POSES:                 writePoses(writer, sfmData.GetPoses()); break;
+        case ESection::RIGS:                  writeRigs(writer, sfmData.getRigs()); break;
+        case ESection::STRUCTURE:             writeLandmarks(writer, sfmData.GetLandmarks()); break;
+        case ESection::CONTROL_POINTS:        writeLandmarks(writer, sfmData.GetControl_Points()); break;
+        case ESection::POSES_UNCERTAINTY:     writeUncertainty(writer, sfmData._posesUncertainty); break;
+        case ESection::LANDMARKS_UNCERTAINTY: writeUncertainty(writer, sfmData._landmarksUncertainty); break;
+      }
+
+      toc[i].size = writer.position() - toc[i].offset;
+    }
+
+    writer.rewriteData(tocPosition, toc.data(), toc.size() * sizeof(SectionEntry));
+    writer.close();
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Cannot save the binary SfMData file '" << filename << "': " << e.what());
+    return false;
+  }
+
+  return true;
+}
+
+bool loadBinary(SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // load flags
+  const bool loadViews = (partFlag & VIEWS) == VIEWS;
+  const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool loadExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool loadObservations = (partFlag & OBSERVATIONS) == OBSERVATIONS;
+  const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+  const bool loadPosesUncertainty = (partFlag & POSES_UNCERTAINTY) == POSES_UNCERTAINTY;
+  const bool loadLandmarksUncertainty = (partFlag & LANDMARKS_UNCERTAINTY) == LANDMARKS_UNCERTAINTY;
+
+  try
+  {
+    const bip::file_mapping mapping(filename.c_str(), bip::read_only);
+    const bip::mapped_region region(mapping, bip::read_only);
+    const char* fileData = static_cast<const char*>(region.get_address());
+
+    BinaryReader header(fileData, region.get_size());
+    if(std::memcmp(header.readData(sizeof(binaryMagic)), binaryMagic, sizeof(binaryMagic)) != 0)
+      throw std::runtime_error("Not a binary SfMData file.");
+    const std::uint32_t version = header.read<std::uint32_t>();
+    if(version != binaryVersion)
+      throw std::runtime_error("Unsupported binary SfMData version: " + std::to_string(version));
+
+    const std::uint32_t nbSections = header.read<std::uint32_t>();
+    for(std::uint32_t i = 0; i < nbSections; ++i)
+    {
+      const SectionEntry entry = header.read<SectionEntry>();
+      if(entry.offset > region.get_size() || entry.size > region.get_size() - entry.offset)
+        throw std::runtime_error("Invalid section in binary SfMData file.");
+
+      // only the sections of the requested parts are read
+      BinaryReader reader(fileData + entry.offset, entry.size);
+      switch(static_cast<ESection>(entry.type))
+      {
+        case ESection::FOLDERS:
+        {
+          const std::uint64_t nbFeaturesFolders = reader.read<std::uint64_t>();
+          for(std::uint64_t f = 0; f < nbFeaturesFolders; ++f)
+            sfmData.addFeaturesFolder(reader.readString());
+          const std::uint64_t nbMatchesFolders = reader.read<std::uint64_t>();
+          for(std::uint64_t f = 0; f < nbMatchesFolders; ++f)
+            sfmData.addMatchesFolder(reader.readString());
+          break;
+        }
+        case ESection::VIEWS:
+          if(loadViews)
+            readViews(reader, sfmData.GetViews());
+          break;
+        case ESection::INTRINSICS:
+          if(loadIntrinsics)
+            readIntrinsics(reader, sfmData.GetIntrinsics());
+          break;
+        case ESection::POSES:
+          if(loadExtrinsics)
+            readPoses(reader, sfmData.GetPoses());
+          break;
+        case ESection::RIGS:
+          if(loadExtrinsics)
+            readRigs(reader, sfmData.getRigs());
+          break;
+        case ESection::STRUCTURE:
+          if(loadStructure)
+            readLandmarks(reader, sfmData.GetLandmarks(), loadObservations);
+          break;
+        case ESection::CONTROL_POINTS:
+          if(loadControlPoints)
+            readLandmarks(reader, sfmData.GetControl_Points(), loadObservations);
+          break;
+        case ESection::POSES_UNCERTAINTY:
+          if(loadPosesUncertainty)
+            readUncertainty(reader, sfmData._posesUncertainty);
+          break;
+        case ESection::LANDMARKS_UNCERTAINTY:
+          if(loadLandmarksUncertainty)
+            readUncertainty(reader, sfmData._landmarksUncertainty);
+          break;
+        default:
+          ALICEVISION_LOG_WARNING("Unknown section " << entry.type << " in binary SfMData file: " << filename);
+      }
+    }
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Cannot load the binary SfMData file '" << filename << "': " << e.what());
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,49 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfm/sfmDataIO.hpp>
+
+#include <string>
+
+namespace aliceVision {
+namespace sfm {
+
+// AliceVision binary SfMData file (.sfmbin), little-endian:
+// -- Header
+// magic "AVSFMBIN", version, number of sections
+// table of contents: [section type, offset, size] for each section
+// -- Sections (only the saved parts are present)
+// folders, views, intrinsics, poses, rigs,
+// structure, control points, poses uncertainty, landmarks uncertainty
+// --
+// The landmarks and the observations are stored in two arrays of fixed-size records,
+// so the structure is read directly from the memory-mapped file and the observations
+// are skipped if they are not requested.
+// It contains the same data than the JSON format.
+
+/**
+ * @brief Save an SfMData in a binary file.
+ * @param[in] sfmData The input SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData save flag
+ * @return true if completed
+ */
+bool saveBinary(const SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+/**
+ * @brief Load a binary SfMData file.
+ * Only the sections of the requested parts are read.
+ * @param[out] sfmData The output SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData load flag
+ * @return true if completed
+ */
+bool loadBinary(SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+} // namespace sfm
+} // namespace aliceVision
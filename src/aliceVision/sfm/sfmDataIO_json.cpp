@@ -7,15 +7,23 @@
 #include "sfmDataIO_json.hpp"
 #include <aliceVision/camera/camera.hpp>
 #include <aliceVision/sfm/viewIO.hpp>
+#include <aliceVision/sfm/JsonReader.hpp>
+#include <aliceVision/sfm/JsonWriter.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/property_tree/json_parser.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
+#include <algorithm>
 #include <memory>
 #include <cassert>
 
 namespace aliceVision {
 namespace sfm {
 
+namespace bip = boost::interprocess;
+
 void saveView(const std::string& name, const View& view, bpt::ptree& parentTree)
 {
   bpt::ptree viewTree;
@@ -242,73 +250,483 @@ void loadLandmark(IndexT& landmarkId, Landmark& landmark, bpt::ptree& landmarkTr
   }
 }
 
+namespace {
 
-bool saveJSON(const SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+void writePose3(JsonWriter& writer, const char* key, const geometry::Pose3& pose)
 {
-  const Vec3 version = {1, 0, 0};
+  writer.beginObject(key);
+  writer.writeMatrix("rotation", pose.rotation());
+  writer.writeMatrix("center", pose.center());
+  writer.endObject();
+}
 
-  // save flags
-  const bool saveViews = (partFlag & VIEWS) == VIEWS;
-  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
-  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
-  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
-  const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+void readPose3(JsonReader& reader, geometry::Pose3& pose)
+{
+  Mat3 rotation;
+  Vec3 center;
+  int nbFields = 0;
+  std::string key;
 
-  // main tree
-  bpt::ptree fileTree;
+  reader.beginObject();
+  while(reader.nextKey(key))
+  {
+    if(key == "rotation")
+      reader.readMatrix(rotation), ++nbFields;
+    else if(key == "center")
+      reader.readMatrix(center), ++nbFields;
+    else
+      reader.skipValue();
+  }
 
-  // file version
-  saveMatrix("version", version, fileTree);
+  if(nbFields != 2)
+    reader.error("missing field in pose");
 
-  // folders
-  if(!sfmData.getRelativeFeaturesFolders().empty())
+  pose = geometry::Pose3(rotation, center);
+}
+
+void writeStrings(JsonWriter& writer, const char* key, const std::vector<std::string>& strings)
+{
+  writer.beginArray(key);
+  for(const std::string& str : strings)
+    writer.writeValue("", str);
+  writer.endArray();
+}
+
+void writeView(JsonWriter& writer, const View& view)
+{
+  writer.beginObject();
+
+  if(view.getViewId() != UndefinedIndexT)
+    writer.writeValue("viewId", view.getViewId());
+
+  if(view.getPoseId() != UndefinedIndexT)
+    writer.writeValue("poseId", view.getPoseId());
+
+  if(view.isPartOfRig())
   {
-    bpt::ptree featureFoldersTree;
+    writer.writeValue("rigId", view.getRigId());
+    writer.writeValue("subPoseId", view.getSubPoseId());
+  }
+
+  if(view.getIntrinsicId() != UndefinedIndexT)
+    writer.writeValue("intrinsicId", view.getIntrinsicId());
+
+  if(view.getResectionId() != UndefinedIndexT)
+    writer.writeValue("resectionId", view.getResectionId());
+
+  writer.writeValue("path", view.getImagePath());
+  writer.writeValue("width", view.getWidth());
+  writer.writeValue("height", view.getHeight());
+
+  // metadata
+  writer.beginObject("metadata");
+  for(const auto& metadataPair : view.getMetadata())
+    writer.writeValue(metadataPair.first.c_str(), metadataPair.second);
+  writer.endObject();
+
+  writer.endObject();
+}
 
-    for(const std::string& featuresFolder : sfmData.getRelativeFeaturesFolders())
+void readView(JsonReader& reader, View& view)
+{
+  IndexT rigId = UndefinedIndexT;
+  IndexT subPoseId = UndefinedIndexT;
+  bool hasPath = false;
+  std::string key;
+  std::string value;
+
+  reader.beginObject();
+  while(reader.nextKey(key))
+  {
+    if(key == "viewId")
+      view.setViewId(reader.readUnsigned<IndexT>());
+    else if(key == "poseId")
+      view.setPoseId(reader.readUnsigned<IndexT>());
+    else if(key == "rigId")
+      rigId = reader.readUnsigned<IndexT>();
+    else if(key == "subPoseId")
+      subPoseId = reader.readUnsigned<IndexT>();
+    else if(key == "intrinsicId")
+      view.setIntrinsicId(reader.readUnsigned<IndexT>());
+    else if(key == "resectionId")
+      view.setResectionId(reader.readUnsigned<IndexT>());
+    else if(key == "path")
+      view.setImagePath(reader.readString()), hasPath = true;
+    else if(key == "width")
+      view.setWidth(reader.readUnsigned<std::size_t>());
+    else if(key == "height")
+      view.setHeight(reader.readUnsigned<std::size_t>());
+    else if(key == "metadata")
     {
-      bpt::ptree featureFolderTree;
-      featureFolderTree.put("", featuresFolder);
-      featureFoldersTree.push_back(std::make_pair("", featureFolderTree));
+      std::string metadataKey;
+      reader.beginObject();
+      while(reader.nextKey(metadataKey))
+      {
+        if(reader.isContainer())
+        {
+          // no value for a metadata node with children
+          reader.skipValue();
+          value.clear();
+        }
+        else
+        {
+          reader.readString(value);
+        }
+        view.addMetadata(metadataKey, value);
+      }
     }
+    else
+      reader.skipValue();
+  }
 
-    fileTree.add_child("featuresFolders", featureFoldersTree);
+  if(!hasPath)
+    reader.error("missing field 'path' in view");
+
+  if(rigId != UndefinedIndexT)
+  {
+    if(subPoseId == UndefinedIndexT)
+      reader.error("missing field 'subPoseId' in view");
+    view.setRigAndSubPoseId(rigId, subPoseId);
   }
+}
 
-  if(!sfmData.getRelativeMatchesFolders().empty())
+void writeIntrinsic(JsonWriter& writer, IndexT intrinsicId, const camera::IntrinsicBase& intrinsic)
+{
+  const camera::EINTRINSIC intrinsicType = intrinsic.getType();
+
+  writer.beginObject();
+  writer.writeValue("intrinsicId", intrinsicId);
+  writer.writeValue("width", intrinsic.w());
+  writer.writeValue("height", intrinsic.h());
+  writer.writeValue("type", camera::EINTRINSIC_enumToString(intrinsicType));
+  writer.writeValue("serialNumber", intrinsic.serialNumber());
+  writer.writeValue("pxInitialFocalLength", intrinsic.initialFocalLengthPix());
+
+  if(camera::isPinhole(intrinsicType))
+  {
+    const camera::Pinhole& pinholeIntrinsic = dynamic_cast<const camera::Pinhole&>(intrinsic);
+
+    writer.writeValue("pxFocalLength", pinholeIntrinsic.getFocalLengthPix());
+    writer.writeMatrix("principalPoint", pinholeIntrinsic.getPrincipalPoint());
+
+    writer.beginArray("distortionParams");
+    for(double param : pinholeIntrinsic.getDistortionParams())
+      writer.writeValue("", param);
+    writer.endArray();
+  }
+
+  writer.endObject();
+}
+
+void readIntrinsic(JsonReader& reader, IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic)
+{
+  unsigned int width = 0;
+  unsigned int height = 0;
+  std::string intrinsicTypeName;
+  std::string serialNumber;
+  double pxInitialFocalLength = 0.0;
+  double pxFocalLength = 0.0;
+  Vec2 principalPoint;
+  std::vector<double> distortionParams;
+  int nbFields = 0;
+  std::string key;
+
+  reader.beginObject();
+  while(reader.nextKey(key))
   {
-    bpt::ptree matchingFoldersTree;
+    if(key == "intrinsicId")
+      intrinsicId = reader.readUnsigned<IndexT>(), ++nbFields;
+    else if(key == "width")
+      width = reader.readUnsigned<unsigned int>(), ++nbFields;
+    else if(key == "height")
+      height = reader.readUnsigned<unsigned int>(), ++nbFields;
+    else if(key == "type")
+      reader.readString(intrinsicTypeName), ++nbFields;
+    else if(key == "serialNumber")
+      reader.readString(serialNumber), ++nbFields;
+    else if(key == "pxInitialFocalLength")
+      pxInitialFocalLength = reader.readDouble(), ++nbFields;
+    else if(key == "pxFocalLength")
+      pxFocalLength = reader.readDouble(), ++nbFields;
+    else if(key == "principalPoint")
+      reader.readMatrix(principalPoint), ++nbFields;
+    else if(key == "distortionParams")
+    {
+      reader.beginArray();
+      while(reader.nextElement())
+        distortionParams.push_back(reader.readDouble());
+      ++nbFields;
+    }
+    else
+      reader.skipValue();
+  }
 
-    for(const std::string& matchesFolder : sfmData.getRelativeMatchesFolders())
+  const camera::EINTRINSIC intrinsicType = camera::EINTRINSIC_stringToEnum(intrinsicTypeName);
+
+  // check if the camera is a Pinhole model
+  if(!camera::isPinhole(intrinsicType))
+    throw std::out_of_range("Only Pinhole camera model supported");
+
+  if(nbFields != 9)
+    reader.error("missing field in intrinsic");
+
+  // pinhole parameters
+  std::shared_ptr<camera::Pinhole> pinholeIntrinsic = camera::createPinholeIntrinsic(intrinsicType, width, height, pxFocalLength, principalPoint(0), principalPoint(1));
+  pinholeIntrinsic->setInitialFocalLengthPix(pxInitialFocalLength);
+  pinholeIntrinsic->setSerialNumber(serialNumber);
+  pinholeIntrinsic->setDistortionParams(distortionParams);
+  intrinsic = std::static_pointer_cast<camera::IntrinsicBase>(pinholeIntrinsic);
+}
+
+void writeRig(JsonWriter& writer, IndexT rigId, const Rig& rig)
+{
+  writer.beginObject();
+  writer.writeValue("rigId", rigId);
+
+  writer.beginArray("subPoses");
+  for(const auto& rigSubPose : rig.getSubPoses())
+  {
+    writer.beginObject();
+    writer.writeValue("status", ERigSubPoseStatus_enumToString(rigSubPose.status));
+    writePose3(writer, "pose", rigSubPose.pose);
+    writer.endObject();
+  }
+  writer.endArray();
+
+  writer.endObject();
+}
+
+void readRig(JsonReader& reader, IndexT& rigId, Rig& rig)
+{
+  std::vector<RigSubPose> subPoses;
+  int nbFields = 0;
+  std::string key;
+
+  reader.beginObject();
+  while(reader.nextKey(key))
+  {
+    if(key == "rigId")
+    {
+      rigId = reader.readUnsigned<IndexT>();
+      ++nbFields;
+    }
+    else if(key == "subPoses")
     {
-      bpt::ptree matchingFolderTree;
-      matchingFolderTree.put("", matchesFolder);
-      matchingFoldersTree.push_back(std::make_pair("", matchingFolderTree));
+      reader.beginArray();
+      while(reader.nextElement())
+      {
+        RigSubPose subPose;
+        reader.beginObject();
+        while(reader.nextKey(key))
+        {
+          if(key == "status")
+            subPose.status = ERigSubPoseStatus_stringToEnum(reader.readString());
+          else if(key == "pose")
+            readPose3(reader, subPose.pose);
+          else
+            reader.skipValue();
+        }
+        subPoses.push_back(subPose);
+      }
+      ++nbFields;
     }
+    else
+      reader.skipValue();
+  }
+
+  if(nbFields != 2)
+    reader.error("missing field in rig");
+
+  rig = Rig(subPoses.size());
+  for(std::size_t subPoseId = 0; subPoseId < subPoses.size(); ++subPoseId)
+    rig.setSubPose(subPoseId, subPoses[subPoseId]);
+}
+
+void writeLandmark(JsonWriter& writer, IndexT landmarkId, const Landmark& landmark)
+{
+  writer.beginObject();
+  writer.writeValue("landmarkId", landmarkId);
+  writer.writeValue("descType", feature::EImageDescriberType_enumToString(landmark.descType));
+
+  writer.writeMatrix("color", landmark.rgb);
+  writer.writeMatrix("X", landmark.X);
+
+  // observations
+  writer.beginArray("observations");
+  for(const auto& obsPair : landmark.observations)
+  {
+    const Observation& observation = obsPair.second;
 
-    fileTree.add_child("matchesFolders", matchingFoldersTree);
+    writer.beginObject();
+    writer.writeValue("observationId", obsPair.first);
+    writer.writeValue("featureId", observation.id_feat);
+    writer.writeMatrix("x", observation.x);
+    writer.endObject();
   }
+  writer.endArray();
+
+  writer.endObject();
+}
+
+void readLandmark(JsonReader& reader, IndexT& landmarkId, Landmark& landmark)
+{
+  int nbFields = 0;
+  std::string key;
+
+  reader.beginObject();
+  while(reader.nextKey(key))
+  {
+    if(key == "landmarkId")
+      landmarkId = reader.readUnsigned<IndexT>(), ++nbFields;
+    else if(key == "descType")
+      landmark.descType = feature::EImageDescriberType_stringToEnum(reader.readString()), ++nbFields;
+    else if(key == "color")
+      reader.readMatrix(landmark.rgb), ++nbFields;
+    else if(key == "X")
+      reader.readMatrix(landmark.X), ++nbFields;
+    else if(key == "observations")
+    {
+      reader.beginArray();
+      while(reader.nextElement())
+      {
+        IndexT viewId = UndefinedIndexT;
+        Observation observation;
+        int nbObservationFields = 0;
+
+        reader.beginObject();
+        while(reader.nextKey(key))
+        {
+          if(key == "observationId")
+            viewId = reader.readUnsigned<IndexT>(), ++nbObservationFields;
+          else if(key == "featureId")
+            observation.id_feat = reader.readUnsigned<IndexT>(), ++nbObservationFields;
+          else if(key == "x")
+            reader.readMatrix(observation.x), ++nbObservationFields;
+          else
+            reader.skipValue();
+        }
+
+        if(nbObservationFields != 3)
+          reader.error("missing field in observation");
+
+        // observations are saved sorted by view id
+        landmark.observations.emplace_hint(landmark.observations.end(), viewId, observation);
+      }
+      ++nbFields;
+    }
+    else
+      reader.skipValue();
+  }
+
+  if(nbFields != 5)
+    reader.error("missing field in landmark");
+}
+
+void writeLandmarks(JsonWriter& writer, const char* key, const Landmarks& landmarks)
+{
+  // number of landmarks serialized by a thread at once
+  const std::size_t chunkSize = 1000;
+
+  std::vector<Landmarks::const_iterator> chunks;
+  std::size_t landmarkIndex = 0;
+  for(auto it = landmarks.begin(); it != landmarks.end(); ++it, ++landmarkIndex)
+  {
+    if(landmarkIndex % chunkSize == 0)
+      chunks.push_back(it);
+  }
+  const int nbChunks = chunks.size();
+  chunks.push_back(landmarks.end());
+
+  writer.beginArray(key);
+
+  // the chunks are serialized in parallel by blocks, and appended in order
+  const int blockSize = 4 * omp_get_max_threads();
+  std::vector<std::unique_ptr<JsonWriter>> fragments(blockSize);
+
+  for(int blockBegin = 0; blockBegin < nbChunks; blockBegin += blockSize)
+  {
+    const int blockEnd = std::min(nbChunks, blockBegin + blockSize);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = blockBegin; c < blockEnd; ++c)
+    {
+      std::unique_ptr<JsonWriter>& fragment = fragments.at(c - blockBegin);
+      fragment.reset(new JsonWriter(writer.getDepth()));
+
+      for(auto it = chunks.at(c); it != chunks.at(c + 1); ++it)
+        writeLandmark(*fragment, it->first, it->second);
+    }
+
+    for(int c = blockBegin; c < blockEnd; ++c)
+    {
+      writer.appendFragment(*fragments.at(c - blockBegin));
+      fragments.at(c - blockBegin).reset();
+    }
+  }
+
+  writer.endArray();
+}
+
+void readLandmarks(JsonReader& reader, Landmarks& landmarks)
+{
+  reader.beginArray();
+  while(reader.nextElement())
+  {
+    IndexT landmarkId = UndefinedIndexT;
+    Landmark landmark;
+
+    readLandmark(reader, landmarkId, landmark);
+
+    landmarks.emplace(landmarkId, std::move(landmark));
+  }
+}
+
+} // namespace
+
+bool saveJSON(const SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  const Vec3 version = {1, 0, 0};
+
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+
+  // the file is written while the data is serialized
+  JsonWriter writer(filename);
+
+  // file version
+  writer.writeMatrix("version", version);
+
+  // folders
+  if(!sfmData.getRelativeFeaturesFolders().empty())
+    writeStrings(writer, "featuresFolders", sfmData.getRelativeFeaturesFolders());
+
+  if(!sfmData.getRelativeMatchesFolders().empty())
+    writeStrings(writer, "matchesFolders", sfmData.getRelativeMatchesFolders());
 
   // views
   if(saveViews && !sfmData.GetViews().empty())
   {
-    bpt::ptree viewsTree;
+    writer.beginArray("views");
 
     for(const auto& viewPair : sfmData.GetViews())
-      saveView("", *(viewPair.second), viewsTree);
+      writeView(writer, *(viewPair.second));
 
-    fileTree.add_child("views", viewsTree);
+    writer.endArray();
   }
 
   // intrinsics
   if(saveIntrinsics && !sfmData.GetIntrinsics().empty())
   {
-    bpt::ptree intrinsicsTree;
+    writer.beginArray("intrinsics");
 
     for(const auto& intrinsicPair : sfmData.GetIntrinsics())
-      saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
+      writeIntrinsic(writer, intrinsicPair.first, *(intrinsicPair.second));
 
-    fileTree.add_child("intrinsics", intrinsicsTree);
+    writer.endArray();
   }
 
   //extrinsics
@@ -317,57 +735,40 @@ bool saveJSON(const SfMData& sfmData, const std::string& filename, ESfMData part
     // poses
     if(!sfmData.GetPoses().empty())
     {
-      bpt::ptree posesTree;
+      writer.beginArray("poses");
 
       for(const auto& posePair : sfmData.GetPoses())
       {
-        bpt::ptree poseTree;
-
-        poseTree.put("poseId", posePair.first);
-        savePose3("pose", posePair.second, poseTree);
-        posesTree.push_back(std::make_pair("", poseTree));
+        writer.beginObject();
+        writer.writeValue("poseId", posePair.first);
+        writePose3(writer, "pose", posePair.second);
+        writer.endObject();
       }
 
-      fileTree.add_child("poses", posesTree);
+      writer.endArray();
     }
 
     // rigs
     if(!sfmData.getRigs().empty())
     {
-      bpt::ptree rigsTree;
+      writer.beginArray("rigs");
 
       for(const auto& rigPair : sfmData.getRigs())
-        saveRig("", rigPair.first, rigPair.second, rigsTree);
+        writeRig(writer, rigPair.first, rigPair.second);
 
-      fileTree.add_child("rigs", rigsTree);
+      writer.endArray();
     }
   }
 
   // structure
   if(saveStructure && !sfmData.GetLandmarks().empty())
-  {
-    bpt::ptree structureTree;
-
-    for(const auto& structurePair : sfmData.GetLandmarks())
-      saveLandmark("", structurePair.first, structurePair.second, structureTree);
-
-    fileTree.add_child("structure", structureTree);
-  }
+    writeLandmarks(writer, "structure", sfmData.GetLandmarks());
 
   // control points
   if(saveControlPoints && !sfmData.GetControl_Points().empty())
-  {
-    bpt::ptree controlPointTree;
-
-    for(const auto& controlPointPair : sfmData.GetControl_Points())
-      saveLandmark("", controlPointPair.first, controlPointPair.second, controlPointTree);
-
-    fileTree.add_child("controlPoints", controlPointTree);
-  }
+    writeLandmarks(writer, "controlPoints", sfmData.GetControl_Points());
 
-  // write the json file with the tree
-
-  bpt::write_json(filename, fileTree);
+  writer.close();
 
   return true;
 }
@@ -383,143 +784,140 @@ bool loadJSON(SfMData& sfmData, const std::string& filename, ESfMData partFlag,
   const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
   const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
 
-  // main tree
-  bpt::ptree fileTree;
-
-  // read the json file and initialize the tree
-  bpt::read_json(filename, fileTree);
+  // the file is parsed directly from memory, the sections which are not loaded are skipped
+  const bip::file_mapping mapping(filename.c_str(), bip::read_only);
+  const bip::mapped_region region(mapping, bip::read_only);
+  const char* fileData = static_cast<const char*>(region.get_address());
 
-  // version
-  loadMatrix("version", version, fileTree);
-
-  // folders
-  if(fileTree.count("featuresFolders"))
-    for(bpt::ptree::value_type& featureFolderNode : fileTree.get_child("featuresFolders"))
-      sfmData.addFeaturesFolder(featureFolderNode.second.get_value<std::string>());
+  JsonReader reader(fileData, fileData + region.get_size());
+  std::string key;
 
-  if(fileTree.count("matchesFolders"))
-    for(bpt::ptree::value_type& matchingFolderNode : fileTree.get_child("matchesFolders"))
-      sfmData.addMatchesFolder(matchingFolderNode.second.get_value<std::string>());
-
-  // views
-  if(loadViews && fileTree.count("views"))
+  reader.beginObject();
+  while(reader.nextKey(key))
   {
-    Views& views = sfmData.GetViews();
-
-    if(incompleteViews)
+    if(key == "version")
     {
-      // store incomplete views in a vector
-      std::vector<View> incompleteViews(fileTree.get_child("views").size());
-
-      int viewIndex = 0;
-      for(bpt::ptree::value_type &viewNode : fileTree.get_child("views"))
+      reader.readMatrix(version);
+    }
+    else if(key == "featuresFolders" || key == "matchesFolders")
+    {
+      // folders
+      const bool isFeaturesFolders = (key == "featuresFolders");
+      reader.beginArray();
+      while(reader.nextElement())
       {
-        loadView(incompleteViews.at(viewIndex), viewNode.second);
-        ++viewIndex;
+        if(isFeaturesFolders)
+          sfmData.addFeaturesFolder(reader.readString());
+        else
+          sfmData.addMatchesFolder(reader.readString());
       }
-
-      // update incomplete views
-      #pragma omp parallel for
-      for(int i = 0; i < incompleteViews.size(); ++i)
-        updateIncompleteView(incompleteViews.at(i));
-
-      // copy complete views in the SfMData views map
-      for(const View& view : incompleteViews)
-        views.emplace(view.getViewId(), std::make_shared<View>(view));
     }
-    else
+    else if(loadViews && key == "views")
     {
-      // store directly in the SfMData views map
-      for(bpt::ptree::value_type &viewNode : fileTree.get_child("views"))
+      Views& views = sfmData.GetViews();
+
+      if(incompleteViews)
       {
-        View view;
-        loadView(view, viewNode.second);
-        views.emplace(view.getViewId(), std::make_shared<View>(view));
+        // store incomplete views in a vector
+        std::vector<View> incompleteViews;
+
+        reader.beginArray();
+        while(reader.nextElement())
+        {
+          incompleteViews.emplace_back();
+          readView(reader, incompleteViews.back());
+        }
+
+        // update incomplete views
+        #pragma omp parallel for
+        for(int i = 0; i < incompleteViews.size(); ++i)
+          updateIncompleteView(incompleteViews.at(i));
+
+        // copy complete views in the SfMData views map
+        for(const View& view : incompleteViews)
+          views.emplace(view.getViewId(), std::make_shared<View>(view));
+      }
+      else
+      {
+        // store directly in the SfMData views map
+        reader.beginArray();
+        while(reader.nextElement())
+        {
+          std::shared_ptr<View> view = std::make_shared<View>();
+          readView(reader, *view);
+          views.emplace(view->getViewId(), view);
+        }
       }
     }
-  }
-
-  // intrinsics
-  if(loadIntrinsics && fileTree.count("intrinsics"))
-  {
-    Intrinsics& intrinsics = sfmData.GetIntrinsics();
-
-    for(bpt::ptree::value_type &intrinsicNode : fileTree.get_child("intrinsics"))
+    else if(loadIntrinsics && key == "intrinsics")
     {
-      IndexT intrinsicId;
-      std::shared_ptr<camera::IntrinsicBase> intrinsic;
+      Intrinsics& intrinsics = sfmData.GetIntrinsics();
 
-      loadIntrinsic(intrinsicId, intrinsic, intrinsicNode.second);
+      reader.beginArray();
+      while(reader.nextElement())
+      {
+        IndexT intrinsicId = UndefinedIndexT;
+        std::shared_ptr<camera::IntrinsicBase> intrinsic;
 
-      intrinsics.emplace(intrinsicId, intrinsic);
-    }
-  }
+        readIntrinsic(reader, intrinsicId, intrinsic);
 
-  // extrinsics
-  if(loadExtrinsics)
-  {
-    // poses
-    if(fileTree.count("poses"))
+        intrinsics.emplace(intrinsicId, intrinsic);
+      }
+    }
+    else if(loadExtrinsics && key == "poses")
     {
       Poses& poses = sfmData.GetPoses();
 
-      for(bpt::ptree::value_type &poseNode : fileTree.get_child("poses"))
+      reader.beginArray();
+      while(reader.nextElement())
       {
-        bpt::ptree& poseTree = poseNode.second;
+        IndexT poseId = UndefinedIndexT;
         geometry::Pose3 pose;
-
-        loadPose3("pose", pose, poseTree);
-
-        poses.emplace(poseTree.get<IndexT>("poseId"), pose);
+        int nbFields = 0;
+
+        reader.beginObject();
+        while(reader.nextKey(key))
+        {
+          if(key == "poseId")
+            poseId = reader.readUnsigned<IndexT>(), ++nbFields;
+          else if(key == "pose")
+            readPose3(reader, pose), ++nbFields;
+          else
+            reader.skipValue();
+        }
+
+        if(nbFields != 2)
+          reader.error("missing field in pose");
+
+        poses.emplace(poseId, pose);
       }
     }
-
-    // rigs
-    if(fileTree.count("rigs"))
+    else if(loadExtrinsics && key == "rigs")
     {
       Rigs& rigs = sfmData.getRigs();
 
-      for(bpt::ptree::value_type &rigNode : fileTree.get_child("rigs"))
+      reader.beginArray();
+      while(reader.nextElement())
       {
-        IndexT rigId;
+        IndexT rigId = UndefinedIndexT;
         Rig rig;
 
-        loadRig(rigId, rig, rigNode.second);
+        readRig(reader, rigId, rig);
 
         rigs.emplace(rigId, rig);
       }
     }
-  }
-
-  // structure
-  if(loadStructure && fileTree.count("structure"))
-  {
-    Landmarks& structure = sfmData.GetLandmarks();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("structure"))
+    else if(loadStructure && key == "structure")
     {
-      IndexT landmarkId;
-      Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
-
-      structure.emplace(landmarkId, landmark);
+      readLandmarks(reader, sfmData.GetLandmarks());
     }
-  }
-
-  // control points
-  if(loadControlPoints && fileTree.count("controlPoints"))
-  {
-    Landmarks& controlPoints = sfmData.GetControl_Points();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("controlPoints"))
+    else if(loadControlPoints && key == "controlPoints")
     {
-      IndexT landmarkId;
-      Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
-
-      controlPoints.emplace(landmarkId, landmark);
+      readLandmarks(reader, sfmData.GetControl_Points());
+    }
+    else
+    {
+      reader.skipValue();
     }
   }
 
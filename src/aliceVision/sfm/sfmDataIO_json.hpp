@@ -161,7 +161,9 @@ void saveLandmark(const std::string& name, IndexT landmarkId, const Landmark& la
 void loadLandmark(IndexT& landmarkId, Landmark& landmark, bpt::ptree& landmarkTree);
 
 /**
- * @brief Save an SfMData in a JSON file with a boost property tree.
+ * @brief Save an SfMData in a JSON file.
+ * The file is streamed with the same layout as boost::property_tree::write_json
+ * and the structure is serialized in parallel.
  * @param[in] sfmData The input SfMData
  * @param[in] filename The filename
  * @param[in] partFlag The ESfMData save flag
@@ -171,6 +173,8 @@ bool saveJSON(const SfMData& sfmData, const std::string& filename, ESfMData part
 
 /**
  * @brief Load a JSON SfMData file.
+ * The file is parsed in place (memory-mapped) and the data is stored directly in the SfMData,
+ * the parts which are not requested are skipped.
  * @param[out] sfmData The output SfMData
  * @param[in] filename The filename
  * @param[in] partFlag The ESfMData load flag
@@ -7,9 +7,13 @@
 
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/sfmDataIO_json.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
+#include <fstream>
+#include <iterator>
 #include <sstream>
 
 #define BOOST_TEST_MODULE sfmDataIO
@@ -71,7 +75,7 @@ SfMData createTestScene(std::size_t viewsCount = 2, std::size_t observationCount
 
 BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
 
-  const std::vector<std::string> ext_Type = {"sfm","json"};
+  const std::vector<std::string> ext_Type = {"sfm","json","sfmbin"};
 
   for(int i = 0; i < ext_Type.size(); ++i)
   {
@@ -172,11 +176,143 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_BINARY) {
+
+  SfMData sfmData = createTestScene(4, 10, false);
+  sfmData.structure[1] = sfmData.structure[0];
+  sfmData.structure[1].descType = feature::EImageDescriberType::AKAZE;
+  sfmData.structure[1].rgb = image::RGBColor(10, 20, 30);
+  sfmData.control_points[0] = sfmData.structure[0];
+  sfmData.addFeaturesFolder("features");
+  sfmData.addMatchesFolder("matches");
+
+  // same content than the JSON file
+  BOOST_CHECK( Save(sfmData, "SAVE_LOAD_BINARY.sfm", ALL) );
+  BOOST_CHECK( Save(sfmData, "SAVE_LOAD_BINARY.sfmbin", ALL) );
+
+  SfMData sfmDataJson;
+  SfMData sfmDataBinary;
+  BOOST_CHECK( Load(sfmDataJson, "SAVE_LOAD_BINARY.sfm", ALL) );
+  BOOST_CHECK( Load(sfmDataBinary, "SAVE_LOAD_BINARY.sfmbin", ALL) );
+  BOOST_CHECK( sfmDataBinary == sfmDataJson );
+  BOOST_CHECK( sfmDataBinary.getRelativeFeaturesFolders() == sfmData.getRelativeFeaturesFolders() );
+  BOOST_CHECK( sfmDataBinary.getRelativeMatchesFolders() == sfmData.getRelativeMatchesFolders() );
+  BOOST_CHECK( sfmDataBinary.structure.at(1).rgb == sfmData.structure.at(1).rgb );
+  BOOST_CHECK( sfmDataBinary.structure.at(1).descType == feature::EImageDescriberType::AKAZE );
+
+  // structure without the observations
+  {
+    SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, "SAVE_LOAD_BINARY.sfmbin", STRUCTURE) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), sfmData.structure.size() );
+    BOOST_CHECK( sfmDataLoad.structure.at(0).X == sfmData.structure.at(0).X );
+    BOOST_CHECK( sfmDataLoad.structure.at(0).observations.empty() );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), 0 );
+  }
+
+  // not a binary SfMData file
+  {
+    SfMData sfmDataLoad;
+    fs::copy_file("SAVE_LOAD_BINARY.sfm", "SAVE_LOAD_INVALID.sfmbin", fs::copy_option::overwrite_if_exists);
+    BOOST_CHECK( !Load(sfmDataLoad, "SAVE_LOAD_INVALID.sfmbin", ALL) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_PropertyTreeCompatibility) {
+
+  SfMData sfmData = createTestScene(3, 5, false);
+  sfmData.addFeaturesFolder("features");
+  sfmData.addMatchesFolder("matches");
+
+  // metadata with characters to escape
+  sfmData.views.at(0)->addMetadata("Make", "Camera \"1\"\t/\\");
+  sfmData.views.at(1)->addMetadata("Exif:FocalLength", "35.0");
+
+  // rig
+  Rig rig(2);
+  rig.setSubPose(0, RigSubPose(Pose3(RotationAroundX(0.1), Vec3(1.0 / 3.0, 2, 3)), ERigSubPoseStatus::ESTIMATED));
+  sfmData.getRigs()[0] = rig;
+  sfmData.views.at(2)->setRigAndSubPoseId(0, 1);
+
+  // poses and landmarks with non trivial values
+  sfmData.setPose(*sfmData.views.at(1), Pose3(RotationAroundY(0.7), Vec3(-1e-8, 1e12, 0.1)));
+  sfmData.structure[0].X = Vec3(0.1, -2.0 / 3.0, 1e-300);
+  sfmData.structure[0].rgb = image::RGBColor(0, 128, 255);
+  sfmData.structure[1].descType = feature::EImageDescriberType::AKAZE; // without observations
+  sfmData.control_points[3] = sfmData.structure[0];
+
+  BOOST_CHECK( saveJSON(sfmData, "JSON_STREAM.sfm", ALL) );
+
+  // reference file written with boost::property_tree
+  {
+    bpt::ptree fileTree;
+    saveMatrix("version", Vec3(1, 0, 0), fileTree);
+
+    bpt::ptree featuresFoldersTree, matchesFoldersTree, viewsTree, intrinsicsTree, posesTree, rigsTree, structureTree, controlPointsTree;
+    featuresFoldersTree.push_back(std::make_pair("", bpt::ptree("features")));
+    matchesFoldersTree.push_back(std::make_pair("", bpt::ptree("matches")));
+    fileTree.add_child("featuresFolders", featuresFoldersTree);
+    fileTree.add_child("matchesFolders", matchesFoldersTree);
+
+    for(const auto& viewPair : sfmData.views)
+      saveView("", *viewPair.second, viewsTree);
+    fileTree.add_child("views", viewsTree);
+
+    for(const auto& intrinsicPair : sfmData.intrinsics)
+      saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
+    fileTree.add_child("intrinsics", intrinsicsTree);
+
+    for(const auto& posePair : sfmData.GetPoses())
+    {
+      bpt::ptree poseTree;
+      poseTree.put("poseId", posePair.first);
+      savePose3("pose", posePair.second, poseTree);
+      posesTree.push_back(std::make_pair("", poseTree));
+    }
+    fileTree.add_child("poses", posesTree);
+
+    for(const auto& rigPair : sfmData.getRigs())
+      saveRig("", rigPair.first, rigPair.second, rigsTree);
+    fileTree.add_child("rigs", rigsTree);
+
+    for(const auto& landmarkPair : sfmData.structure)
+      saveLandmark("", landmarkPair.first, landmarkPair.second, structureTree);
+    fileTree.add_child("structure", structureTree);
+
+    for(const auto& landmarkPair : sfmData.control_points)
+      saveLandmark("", landmarkPair.first, landmarkPair.second, controlPointsTree);
+    fileTree.add_child("controlPoints", controlPointsTree);
+
+    bpt::write_json("JSON_PTREE.sfm", fileTree);
+  }
+
+  // same bytes
+  {
+    std::ifstream streamFile("JSON_STREAM.sfm", std::ios::binary);
+    std::ifstream ptreeFile("JSON_PTREE.sfm", std::ios::binary);
+    const std::string streamContent((std::istreambuf_iterator<char>(streamFile)), std::istreambuf_iterator<char>());
+    const std::string ptreeContent((std::istreambuf_iterator<char>(ptreeFile)), std::istreambuf_iterator<char>());
+    BOOST_CHECK( !streamContent.empty() );
+    BOOST_CHECK( streamContent == ptreeContent );
+  }
+
+  // exact round trip
+  {
+    SfMData sfmDataLoad;
+    BOOST_CHECK( loadJSON(sfmDataLoad, "JSON_PTREE.sfm", ALL) );
+    BOOST_CHECK( sfmDataLoad == sfmData );
+    BOOST_CHECK( sfmDataLoad.views.at(0)->getMetadata() == sfmData.views.at(0)->getMetadata() );
+    BOOST_CHECK( sfmDataLoad.structure.at(0).rgb == sfmData.structure.at(0).rgb );
+    BOOST_CHECK( sfmDataLoad.structure.at(1).observations.empty() );
+    BOOST_CHECK_EQUAL( sfmDataLoad.control_points.size(), 1 );
+  }
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
   const int nbViews = 1000;
   const int nbObservationPerView = 100000;
-  std::vector<std::string> ext_Type = {"sfm","json"};
+  std::vector<std::string> ext_Type = {"sfm","json","sfmbin"};
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
   ext_Type.push_back("abc");
@@ -13,11 +13,14 @@
 
 #if defined(__WINDOWS__)
 #include <windows.h>
+#include <psapi.h>
 #elif defined(__LINUX__)
 #include <sys/sysinfo.h>
+#include <sys/resource.h>
 #elif defined(__APPLE__)
 #include <sys/types.h>
 #include <sys/sysctl.h>
+#include <sys/resource.h>
 #include <mach/vm_statistics.h>
 #include <mach/mach_types.h>
 #include <mach/mach_init.h>
@@ -99,6 +102,24 @@ MemoryInfo getMemoryInfo()
     return infos;
 }
 
+std::size_t getPeakMemoryUsage()
+{
+#if defined(__WINDOWS__)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+#elif defined(__LINUX__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024; // in KB
+#elif defined(__APPLE__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+        return static_cast<std::size_t>(usage.ru_maxrss); // in bytes
+#endif
+    return 0;
+}
+
 std::ostream& operator<<(std::ostream& os, const MemoryInfo& infos)
 {
   const float convertionGb = std::pow(2,30);
@@ -24,6 +24,12 @@ struct MemoryInfo
 
 MemoryInfo getMemoryInfo();
 
+/**
+ * @brief Get the peak resident memory of the current process.
+ * @return the peak memory in bytes (0 if not available)
+ */
+std::size_t getPeakMemoryUsage();
+
 std::ostream& operator<<(std::ostream& os, const MemoryInfo& infos);
 
 }
@@ -164,3 +164,68 @@ int get_total_cpus(void)
 
 #endif /* GET_TOTAL_CPUS_DEFINED */
 
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+namespace aliceVision {
+namespace system {
+
+/* cpuid leaf 7 flags, after checking that the OS saves the AVX (and AVX-512) registers */
+static bool cpu_supports_leaf7(int ebxMask, unsigned long long xcr0Mask)
+{
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool fma = (info[2] & (1 << 12)) != 0;
+	if (!osxsave || !fma || (_xgetbv(0) & xcr0Mask) != xcr0Mask)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & ebxMask) == ebxMask;
+}
+
+bool cpu_supports_avx2(void)
+{
+	return cpu_supports_leaf7(1 << 5, 0x6);
+}
+
+bool cpu_supports_avx512(void)
+{
+	/* AVX512F (bit 16) and AVX512BW (bit 30), opmask and ZMM states saved */
+	return cpu_supports_avx2() && cpu_supports_leaf7((1 << 16) | (1 << 30), 0xE6);
+}
+}}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+namespace aliceVision {
+namespace system {
+
+bool cpu_supports_avx2(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+bool cpu_supports_avx512(void)
+{
+	__builtin_cpu_init();
+	return cpu_supports_avx2() && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+}
+}}
+#else
+namespace aliceVision {
+namespace system {
+
+bool cpu_supports_avx2(void)
+{
+	return false;
+}
+
+bool cpu_supports_avx512(void)
+{
+	return false;
+}
+}}
+#endif
@@ -22,6 +22,16 @@ int cpu_clock_by_os();
  */
 int get_total_cpus();
 
+/**
+ * @brief Returns true if the CPU and the OS support the AVX2 and FMA instructions.
+ */
+bool cpu_supports_avx2();
+
+/**
+ * @brief Returns true if the CPU and the OS support the AVX-512 F and BW instructions.
+ */
+bool cpu_supports_avx512();
+
 }
 }
 
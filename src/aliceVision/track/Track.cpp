@@ -7,81 +7,197 @@
 
 #include "Track.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+
 namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
+
+namespace {
+
+typedef std::vector<std::atomic<std::size_t>> UnionFindParents;
+
+/// Find the root of a feature, with path halving
+inline std::size_t findRoot(UnionFindParents& parents, std::size_t node)
+{
+  while(true)
+  {
+    std::size_t parent = parents[node].load(std::memory_order_relaxed);
+    if(parent == node)
+      return node;
+    const std::size_t grandParent = parents[parent].load(std::memory_order_relaxed);
+    // another thread may have updated the parent, it is only an optimization
+    if(parent != grandParent)
+      parents[node].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+    node = grandParent;
+  }
+}
+
+/// Merge the sets of two features, the largest root is linked to the smallest one
+inline void unite(UnionFindParents& parents, std::size_t a, std::size_t b)
+{
+  while(true)
+  {
+    a = findRoot(parents, a);
+    b = findRoot(parents, b);
+    if(a == b)
+      return;
+    if(a < b)
+      std::swap(a, b);
+    std::size_t expected = a;
+    // fails if a is no more a root, retry from the new roots
+    if(parents[a].compare_exchange_strong(expected, b))
+      return;
+  }
+}
+
+/// Matches of an image pair for one describer type
+struct MatchesJob
+{
+  MatchesJob(std::size_t I, std::size_t J, feature::EImageDescriberType descType, const IndMatches* matches)
+    : I(I), J(J), descType(descType), matches(matches)
+  {}
+
+  std::size_t I;
+  std::size_t J;
+  feature::EImageDescriberType descType;
+  const IndMatches* matches;
+  std::size_t blockI = 0;
+  std::size_t blockJ = 0;
+};
+
+} // namespace
 
 /// Build tracks for a given series of pairWise matches
 bool TracksBuilder::Build( const PairwiseMatches &  pairwiseMatches)
 {
-  typedef std::set<IndexedFeaturePair> SetIndexedPair;
-  // Set of all features of all images: (imageIndex, featureIndex)
-  SetIndexedPair allFeatures;
-  // For each couple of images
+  _blocks.clear();
+  _trackOffsets.clear();
+  _trackFeatures.clear();
 
-  // Make the union according the pair matches
+  std::vector<MatchesJob> jobs;
   for(const auto& matchesPerDescIt: pairwiseMatches)
   {
-    const size_t & I = matchesPerDescIt.first.first;
-    const size_t & J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
-
-    for(const auto& matchesIt: matchesPerDesc)
+    for(const auto& matchesIt: matchesPerDescIt.second)
     {
-      const feature::EImageDescriberType descType = matchesIt.first;
-      const IndMatches& matches = matchesIt.second;
-      // We have correspondences between I and J image index.
-      for(const IndMatch& m: matches)
-      {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        allFeatures.insert(pairI);
-        allFeatures.insert(pairJ);
-      }
+      if(!matchesIt.second.empty())
+        jobs.emplace_back(matchesPerDescIt.first.first, matchesPerDescIt.first.second, matchesIt.first, &matchesIt.second);
     }
   }
 
-  // Build the node indirection for each referenced feature
-  MapIndexToNode map_indexToNode;
-  map_indexToNode.reserve(allFeatures.size());
-  _map_nodeToIndex.reserve(allFeatures.size());
+  // Features blocks sorted by (viewId, descType), with the jobs matching each block
+  // and whether the block is their first view
+  typedef std::pair<std::size_t, feature::EImageDescriberType> BlockKey;
+  typedef std::vector<std::pair<MatchesJob*, bool>> BlockJobs;
+  std::map<BlockKey, BlockJobs> jobsPerBlock;
+  for(MatchesJob& job: jobs)
+  {
+    jobsPerBlock[BlockKey(job.I, job.descType)].emplace_back(&job, true);
+    jobsPerBlock[BlockKey(job.J, job.descType)].emplace_back(&job, false);
+  }
 
-  for (const IndexedFeaturePair& featPair: allFeatures)
+  if(jobsPerBlock.size() > std::numeric_limits<IndexT>::max())
+    throw std::runtime_error("Too many views to build the tracks.");
+
+  std::vector<const BlockJobs*> blocksJobs;
+  blocksJobs.reserve(jobsPerBlock.size());
+  _blocks.reserve(jobsPerBlock.size());
+  for(const auto& blockJobs: jobsPerBlock)
   {
-    lemon::ListDigraph::Node node = _graph.addNode();
-    map_indexToNode.insert(std::make_pair(featPair, node));
-    _map_nodeToIndex.insert(std::make_pair(node, featPair));
+    for(const auto& jobSide: blockJobs.second)
+      (jobSide.second ? jobSide.first->blockI : jobSide.first->blockJ) = _blocks.size();
+    _blocks.push_back({blockJobs.first.first, blockJobs.first.second, 0});
+    blocksJobs.push_back(&blockJobs.second);
   }
 
-  // Add the element of myset to the UnionFind insert method.
-  _index = std::unique_ptr<IndexMap>( new IndexMap(_graph) );
-  _tracksUF = std::unique_ptr<UnionFindObject>( new UnionFindObject(*_index));
-  for(ListDigraph::NodeIt it(_graph); it != INVALID; ++it)
+  // Matched features of each block, sorted: the position of a feature in its block is
+  // its dense index, so the unmatched features of a view take no room in the union-find
+  std::vector<std::vector<IndexT>> blocksFeatures(_blocks.size());
+  #pragma omp parallel for schedule(dynamic)
+  for(int b = 0; b < static_cast<int>(blocksFeatures.size()); ++b)
   {
-    _tracksUF->insert(it);
+    std::vector<IndexT>& features = blocksFeatures[b];
+    for(const auto& jobSide: *blocksJobs[b])
+    {
+      const bool isI = jobSide.second;
+      for(const IndMatch& m: *jobSide.first->matches)
+        features.push_back(isI ? m._i : m._j);
+    }
+    std::sort(features.begin(), features.end());
+    features.erase(std::unique(features.begin(), features.end()), features.end());
   }
 
+  // Contiguous offsets of the blocks
+  std::size_t nbFeatures = 0;
+  for(std::size_t b = 0; b < _blocks.size(); ++b)
+  {
+    _blocks[b].offset = nbFeatures;
+    nbFeatures += blocksFeatures[b].size();
+  }
+
+  // Offset of a matched feature in the union-find
+  const auto featureOffset = [&](std::size_t block, IndexT featIndex) {
+    const std::vector<IndexT>& features = blocksFeatures[block];
+    return _blocks[block].offset + static_cast<std::size_t>(std::lower_bound(features.begin(), features.end(), featIndex) - features.begin());
+  };
+
+  // Union-find forest on the feature offsets
+  UnionFindParents parents(nbFeatures);
+
+  #pragma omp parallel for
+  for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(nbFeatures); ++i)
+    parents[i].store(i, std::memory_order_relaxed);
+
   // Make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(jobs.size()); ++i)
   {
-    const size_t & I = matchesPerDescIt.first.first;
-    const size_t & J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
+    const MatchesJob& job = jobs[i];
+    for(const IndMatch& m: *job.matches)
+      unite(parents, featureOffset(job.blockI, m._i), featureOffset(job.blockJ, m._j));
+  }
 
-    for(const auto& matchesIt: matchesPerDesc)
+  // Flatten the forest: the parent of each feature is its root
+  #pragma omp parallel for
+  for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(nbFeatures); ++i)
+    parents[i].store(findRoot(parents, i), std::memory_order_relaxed);
+
+  // Number of features per set
+  const IndexT noTrack = std::numeric_limits<IndexT>::max();
+  std::vector<IndexT> setSize(nbFeatures, 0);
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+    ++setSize[parents[i].load(std::memory_order_relaxed)];
+
+  // Track offsets, the tracks are ordered by root (their smallest feature offset)
+  // setSize becomes the track id of each root
+  _trackOffsets.push_back(0);
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+  {
+    if(setSize[i] < 2)
     {
-      const feature::EImageDescriberType descType = matchesIt.first;
-      const IndMatches& matches = matchesIt.second;
-      // We have correspondences between I and J image index.
-      for(const IndMatch& m: matches)
-      {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        _tracksUF->join(map_indexToNode[pairI], map_indexToNode[pairJ]);
-      }
+      setSize[i] = noTrack;
+      continue;
     }
+    _trackOffsets.push_back(_trackOffsets.back() + setSize[i]);
+    setSize[i] = static_cast<IndexT>(_trackOffsets.size() - 2);
+  }
+
+  // Fill the tracks, the features are visited in offset order so they are sorted by view in each track
+  std::vector<std::size_t> trackCursor(_trackOffsets.begin(), _trackOffsets.end() - 1);
+  _trackFeatures.resize(_trackOffsets.back());
+  IndexT block = 0;
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+  {
+    while(block + 1 < _blocks.size() && _blocks[block + 1].offset <= i)
+      ++block;
+    const IndexT trackId = setSize[parents[i].load(std::memory_order_relaxed)];
+    if(trackId == noTrack)
+      continue;
+    _trackFeatures[trackCursor[trackId]++] = {block, blocksFeatures[block][i - _blocks[block].offset]};
   }
   return false;
 }
@@ -92,44 +208,51 @@ bool TracksBuilder::Filter(size_t nLengthSupTo, bool bMultithread)
   // - track that are too short,
   // - track with id conflicts (many times the same image index)
 
-  std::set<int> set_classToErase;
+  const std::size_t nbTracks = NbTracks();
+  std::vector<char> validTracks(nbTracks);
 
-  #pragma omp parallel if(bMultithread)
-  for ( lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit) {
+  #pragma omp parallel for if(bMultithread)
+  for(std::ptrdiff_t t = 0; t < static_cast<std::ptrdiff_t>(nbTracks); ++t)
+  {
+    const std::size_t begin = _trackOffsets[t];
+    const std::size_t end = _trackOffsets[t + 1];
+    bool valid = (end - begin >= nLengthSupTo);
+    // the features are sorted by view
+    for(std::size_t i = begin + 1; valid && i < end; ++i)
+      valid = (_blocks[_trackFeatures[i].block].viewId != _blocks[_trackFeatures[i - 1].block].viewId);
+    validTracks[t] = valid;
+  }
 
-    #pragma omp single nowait
-    {
-      size_t cpt = 0;
-      std::set<size_t> myset;
-      for (lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit) {
-        myset.insert(_map_nodeToIndex[ iit ].first);
-        ++cpt;
-      }
-      if (myset.size() != cpt || myset.size() < nLengthSupTo)
-      {
-        #pragma omp critical
-        set_classToErase.insert(cit.operator int());
-      }
-    }
+  // Compact the valid tracks
+  std::size_t nbValidTracks = 0;
+  std::size_t nbValidFeatures = 0;
+  for(std::size_t t = 0; t < nbTracks; ++t)
+  {
+    if(!validTracks[t])
+      continue;
+    const std::size_t begin = _trackOffsets[t];
+    const std::size_t end = _trackOffsets[t + 1];
+    std::copy(_trackFeatures.begin() + begin, _trackFeatures.begin() + end, _trackFeatures.begin() + nbValidFeatures);
+    nbValidFeatures += end - begin;
+    _trackOffsets[++nbValidTracks] = nbValidFeatures;
   }
-  std::for_each (set_classToErase.begin(), set_classToErase.end(),
-    std::bind1st( std::mem_fun( &UnionFindObject::eraseClass ), _tracksUF.get() ));
+  if(!_trackOffsets.empty())
+    _trackOffsets.resize(nbValidTracks + 1);
+  _trackFeatures.resize(nbValidFeatures);
   return false;
 }
 
 bool TracksBuilder::ExportToStream(std::ostream & os)
 {
-  size_t cpt = 0;
-  for ( lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit) {
-    os << "Class: " << cpt++ << std::endl;
-    size_t cptTrackLength = 0;
-    for (lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit) {
-      ++cptTrackLength;
-    }
-    os << "\t" << "track length: " << cptTrackLength << std::endl;
+  for(std::size_t t = 0; t < NbTracks(); ++t)
+  {
+    os << "Class: " << t << std::endl;
+    os << "\t" << "track length: " << _trackOffsets[t + 1] - _trackOffsets[t] << std::endl;
 
-    for (lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit) {
-      os << _map_nodeToIndex[ iit ].first << "  " << _map_nodeToIndex[ iit ].second << std::endl;
+    for(std::size_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
+    {
+      const IndexedFeaturePair feature = getFeature(_trackFeatures[i]);
+      os << feature.first << "  " << feature.second << std::endl;
     }
   }
   return os.good();
@@ -139,22 +262,30 @@ void TracksBuilder::ExportToSTL(TracksMap & allTracks) const
 {
   allTracks.clear();
 
-  size_t trackIndex = 0;
-  for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit, ++trackIndex)
+  const std::size_t nbTracks = NbTracks();
+  std::vector<std::pair<std::size_t, Track>> tracks(nbTracks);
+
+  #pragma omp parallel for
+  for(std::ptrdiff_t t = 0; t < static_cast<std::ptrdiff_t>(nbTracks); ++t)
   {
     // Create the output track
-    std::pair<TracksMap::iterator, bool> ret = allTracks.insert(std::make_pair(trackIndex, Track()));
-
-    Track& outTrack = ret.first->second;
+    tracks[t].first = t;
+    Track& outTrack = tracks[t].second;
+    outTrack.featPerView.reserve(_trackOffsets[t + 1] - _trackOffsets[t]);
 
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
+    for(std::size_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
     {
-      const IndexedFeaturePair & currentPair = _map_nodeToIndex.at(iit);
+      const IndexedFeaturePair currentPair = getFeature(_trackFeatures[i]);
       // all descType inside the track will be the same
       outTrack.descType = currentPair.second.descType;
       outTrack.featPerView[currentPair.first] = currentPair.second.featIndex;
     }
   }
+
+  // the tracks are already sorted by id
+  allTracks.insert(boost::container::ordered_unique_range,
+                   std::make_move_iterator(tracks.begin()),
+                   std::make_move_iterator(tracks.end()));
 }
 
 bool TracksUtilsMap::GetCommonTracksInImages(
@@ -13,9 +13,6 @@
 #include <aliceVision/stl/FlatMap.hpp>
 #include <aliceVision/stl/FlatSet.hpp>
 
-#include <lemon/list_graph.h>
-#include <lemon/unionfind.h>
-
 #include <algorithm>
 #include <iostream>
 #include <functional>
@@ -28,7 +25,6 @@ namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
 
 
 /**
@@ -117,6 +113,12 @@ inline std::ostream& operator<<(std::ostream& os, const KeypointId& k)
  *
  * From map< [imageI,ImageJ], [indexed matches array] > it builds tracks.
  *
+ * The features are identified by their offset in a contiguous array: each (view, describer type)
+ * has a block of the size of its largest matched feature index. The union-find forest is a
+ * parent array on these offsets, the matches are merged in parallel with lock-free unions
+ * (the largest root is linked to the smallest one). The tracks are then stored as
+ * contiguous lists of features, ordered by their smallest feature offset.
+ *
  * Usage:
  * @code{.cpp}
  *  PairWiseMatches map_Matches;
@@ -135,19 +137,6 @@ struct TracksBuilder
 {
   /// IndexedFeaturePair is: map<viewId, keypointId>
   typedef std::pair<std::size_t, KeypointId> IndexedFeaturePair;
-  typedef ListDigraph::NodeMap<std::size_t> IndexMap;
-  typedef lemon::UnionFindEnum< IndexMap > UnionFindObject;
-
-  typedef stl::flat_map< lemon::ListDigraph::Node, IndexedFeaturePair> MapNodeToIndex;
-  typedef stl::flat_map< IndexedFeaturePair, lemon::ListDigraph::Node > MapIndexToNode;
-
-  lemon::ListDigraph _graph; //Graph container to create the node
-  MapNodeToIndex _map_nodeToIndex; //Node to index map
-  std::unique_ptr<IndexMap> _index;
-  std::unique_ptr<UnionFindObject> _tracksUF;
-
-  const UnionFindObject & getUnionFindEnum() const {return *_tracksUF; }
-  const MapNodeToIndex & getReverseMap() const {return _map_nodeToIndex;}
 
   /// Build tracks for a given series of pairWise matches
   bool Build(const PairwiseMatches&  pairwiseMatches);
@@ -157,13 +146,10 @@ struct TracksBuilder
 
   bool ExportToStream(std::ostream & os);
 
-  /// Return the number of connected set in the UnionFind structure (tree forest)
+  /// Return the number of tracks
   size_t NbTracks() const
   {
-    size_t cpt = 0;
-    for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
-      ++cpt;
-    return cpt;
+    return _trackOffsets.empty() ? 0 : _trackOffsets.size() - 1;
   }
 
   /**
@@ -171,6 +157,35 @@ struct TracksBuilder
    *        {TrackIndex => {(imageIndex, keypointId), ... ,(imageIndex, keypointId)}
    */
   void ExportToSTL(TracksMap & allTracks) const;
+
+private:
+  /// Features of a (view, describer type) in the union-find array
+  struct FeaturesBlock
+  {
+    std::size_t viewId;
+    feature::EImageDescriberType descType;
+    std::size_t offset;
+  };
+
+  /// Feature of a track: its block and its index in the view
+  struct TrackFeature
+  {
+    IndexT block;
+    IndexT featIndex;
+  };
+
+  IndexedFeaturePair getFeature(const TrackFeature& feature) const
+  {
+    const FeaturesBlock& block = _blocks[feature.block];
+    return IndexedFeaturePair(block.viewId, KeypointId(block.descType, feature.featIndex));
+  }
+
+  /// blocks sorted by (viewId, descType)
+  std::vector<FeaturesBlock> _blocks;
+  /// features of the track i are in [_trackOffsets[i], _trackOffsets[i+1])
+  std::vector<std::size_t> _trackOffsets;
+  /// features of all the tracks, sorted by view inside each track
+  std::vector<TrackFeature> _trackFeatures;
 };
 
 struct TracksUtilsMap
@@ -10,6 +10,9 @@
 
 #include <vector>
 #include <utility>
+#include <numeric>
+#include <random>
+#include <set>
 
 #define BOOST_TEST_MODULE Track
 #include <boost/test/included/unit_test.hpp>
@@ -178,6 +181,92 @@ BOOST_AUTO_TEST_CASE(Track_Conflict) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(Track_RandomTracks) {
+
+  // Create random tracks with several describer types, the matches are the links
+  // between the consecutive views of each track
+  std::mt19937 generator(42);
+  const std::size_t nbViews = 20;
+  const EImageDescriberType descTypes[] = {EImageDescriberType::SIFT, EImageDescriberType::AKAZE};
+
+  std::map<std::pair<EImageDescriberType, std::size_t>, std::size_t> nbFeaturesPerView;
+  std::set<std::pair<EImageDescriberType, std::vector<std::pair<std::size_t, std::size_t>>>> GT_Tracks;
+  PairwiseMatches map_pairwisematches;
+
+  for(std::size_t t = 0; t < 2000; ++t)
+  {
+    const EImageDescriberType descType = descTypes[t % 2];
+    std::vector<std::size_t> views(nbViews);
+    std::iota(views.begin(), views.end(), 0);
+    std::shuffle(views.begin(), views.end(), generator);
+    views.resize(2 + generator() % 5);
+
+    std::vector<std::pair<std::size_t, std::size_t>> track;
+    for(std::size_t view: views)
+      track.emplace_back(view, nbFeaturesPerView[std::make_pair(descType, view)]++);
+
+    for(std::size_t i = 1; i < track.size(); ++i)
+    {
+      const auto& a = std::min(track[i-1], track[i]);
+      const auto& b = std::max(track[i-1], track[i]);
+      map_pairwisematches[std::make_pair(a.first, b.first)][descType].emplace_back(a.second, b.second);
+    }
+    std::sort(track.begin(), track.end());
+    GT_Tracks.emplace(descType, track);
+  }
+
+  TracksBuilder trackBuilder;
+  trackBuilder.Build(map_pairwisematches);
+  BOOST_CHECK_EQUAL(GT_Tracks.size(), trackBuilder.NbTracks());
+  trackBuilder.Filter(3);
+
+  TracksMap map_tracks;
+  trackBuilder.ExportToSTL(map_tracks);
+
+  std::size_t nbFilteredTracks = 0;
+  for(const auto& track: GT_Tracks)
+    nbFilteredTracks += (track.second.size() >= 3);
+  BOOST_CHECK_EQUAL(nbFilteredTracks, map_tracks.size());
+
+  std::size_t i = 0;
+  for(const auto& trackIt: map_tracks)
+  {
+    BOOST_CHECK_EQUAL(i++, trackIt.first);
+    const std::vector<std::pair<std::size_t, std::size_t>> track(trackIt.second.featPerView.begin(), trackIt.second.featPerView.end());
+    BOOST_CHECK_EQUAL(1, GT_Tracks.count(std::make_pair(trackIt.second.descType, track)));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Track_SparseFeatureIndexes) {
+
+  // Matches of a few features with large indexes: the union-find only
+  // contains the matched features, not all the indexes up to the largest one
+  //A             B             C
+  //4000000000 -> 7          -> 3000000000
+  //12         -> 2000000000
+  const aliceVision::IndexT large = 4000000000u;
+  PairwiseMatches map_pairwisematches;
+  map_pairwisematches[std::make_pair(0, 1)][EImageDescriberType::SIFT] = {IndMatch(large, 7), IndMatch(12, 2000000000u)};
+  map_pairwisematches[std::make_pair(1, 2)][EImageDescriberType::SIFT] = {IndMatch(7, 3000000000u)};
+
+  TracksBuilder trackBuilder;
+  trackBuilder.Build(map_pairwisematches);
+  BOOST_CHECK_EQUAL(2, trackBuilder.NbTracks());
+
+  TracksMap map_tracks;
+  trackBuilder.ExportToSTL(map_tracks);
+
+  // the tracks are ordered by their first feature
+  typedef std::vector<std::pair<std::size_t, std::size_t>> TrackFeatures;
+  const TrackFeatures GT_Track0 = {{0, 12}, {1, 2000000000u}};
+  const TrackFeatures GT_Track1 = {{0, large}, {1, 7}, {2, 3000000000u}};
+  BOOST_REQUIRE_EQUAL(2, map_tracks.size());
+  const TrackFeatures track0(map_tracks.at(0).featPerView.begin(), map_tracks.at(0).featPerView.end());
+  const TrackFeatures track1(map_tracks.at(1).featPerView.begin(), map_tracks.at(1).featPerView.end());
+  BOOST_CHECK(track0 == GT_Track0);
+  BOOST_CHECK(track1 == GT_Track1);
+}
+
 BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
 {
   {
@@ -5,9 +5,8 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Database.hpp"
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/tail.hpp>
-#include <boost/progress.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <stdexcept>
@@ -26,6 +25,21 @@ std::ostream& operator<<(std::ostream& os, const SparseHistogram &dv)
 	return os;
 }
 
+EDistanceMethod EDistanceMethod_stringToEnum(const std::string& distanceMethod)
+{
+  if(distanceMethod == "classic")
+    return EDistanceMethod::CLASSIC;
+  if(distanceMethod == "commonPoints")
+    return EDistanceMethod::COMMON_POINTS;
+  if(distanceMethod == "strongCommonPoints")
+    return EDistanceMethod::STRONG_COMMON_POINTS;
+  if(distanceMethod == "weightedStrongCommonPoints")
+    return EDistanceMethod::WEIGHTED_STRONG_COMMON_POINTS;
+  if(distanceMethod == "inversedWeightedCommonPoints")
+    return EDistanceMethod::INVERSED_WEIGHTED_COMMON_POINTS;
+  throw std::invalid_argument("distance method "+ distanceMethod +" unknown!");
+}
+
 Database::Database(uint32_t num_words)
 : word_files_(num_words),
 word_weights_( num_words, 1.0f ) { }
@@ -35,18 +49,24 @@ DocId Database::insert(DocId doc_id, const SparseHistogram& document)
   // Ensure that the new document to insert is not already there.
   assert(database_.find(doc_id) == database_.end());
 
+  const uint32_t doc_index = doc_ids_.size();
+  uint32_t doc_size = 0;
+
   // For each word, retrieve its inverted file and increment the count for doc_id.
   for(SparseHistogram::const_iterator it = document.begin(), end = document.end(); it != end; ++it)
   {
     Word word = it->first;
     InvertedFile& file = word_files_[word];
     if(file.empty() || file.back().id != doc_id)
-      file.push_back(WordFrequency(doc_id, it->second.size()));
+      file.push_back(WordFrequency(doc_id, doc_index, it->second.size()));
     else
       file.back().count += it->second.size();
+    doc_size += it->second.size();
   }
 
   database_[doc_id] = document;
+  doc_ids_.push_back(doc_id);
+  doc_sizes_.push_back(doc_size);
 
   return doc_id;
 }
@@ -66,20 +86,19 @@ void Database::sanityCheck(size_t N, std::map<size_t, DocMatches>& matches) cons
     N = std::min(N, this->size());
   }
 
+  // query all the documents of the database in parallel
+  std::vector<SparseHistogram> queries;
+  queries.reserve(database_.size());
+  for(const auto &doc : database_)
+    queries.push_back(doc.second);
+
+  std::vector<DocMatches> queriesMatches;
+  find(queries, N, queriesMatches, "strongCommonPoints");
+
   matches.clear();
-  // since we already know the size of the vectors, in order to parallelize the 
-  // query allocate the whole memory
-  boost::progress_display display(database_.size());
-  
-  //#pragma omp parallel for default(none) shared(database_)
+  std::size_t i = 0;
   for(const auto &doc : database_)
-  {
-    std::vector<DocMatch> m;
-    find(doc.second, N, m);
-    //		matches.emplace_back( m );
-    matches[doc.first] = m;
-    ++display;
-  }
+    matches[doc.first] = std::move(queriesMatches[i++]);
 }
 
 /**
@@ -110,23 +129,117 @@ void Database::find(const std::vector<Word>& document, size_t N, std::vector<Doc
  */
 void Database::find( const SparseHistogram& query, size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
 {
-  // Accumulate the best N matches
-  using bestN_tag = boost::accumulators::tag::tail<boost::accumulators::left>;
-  boost::accumulators::accumulator_set<DocMatch, boost::accumulators::features<bestN_tag> > acc(bestN_tag::cache_size = N);
+  QueryBuffers buffers;
+  find(query, N, EDistanceMethod_stringToEnum(distanceMethod), buffers, matches);
+}
 
-  /// @todo Try only computing distances against documents sharing at least one word
-  for(const auto& document: database_)
+void Database::find(const std::vector<SparseHistogram>& queries, size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod) const
+{
+  const EDistanceMethod method = EDistanceMethod_stringToEnum(distanceMethod);
+  matches.resize(queries.size());
+
+  #pragma omp parallel
   {
-    // for each document/image in the database compute the distance between the 
-    // histograms of the query image and the others
-    float distance = sparseDistance(query, document.second, distanceMethod, word_weights_);
-    acc(DocMatch(document.first, distance));
+    QueryBuffers buffers;
+
+    #pragma omp for schedule(dynamic)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(queries.size()); ++i)
+      find(queries[i], N, method, buffers, matches[i]);
   }
+}
 
-  // extract the best N
-  boost::accumulators::extractor<bestN_tag> bestN;
-  matches.resize(std::min(N, database_.size()));
-  std::copy(bestN(acc).begin(), bestN(acc).end(), matches.begin());
+void Database::find(const SparseHistogram& query, size_t N, EDistanceMethod distanceMethod, QueryBuffers& buffers, std::vector<DocMatch>& matches) const
+{
+  const std::size_t nbDocs = doc_ids_.size();
+  std::vector<float>& scores = buffers.scores;
+  std::vector<char>& visited = buffers.visited;
+  std::vector<uint32_t>& touched = buffers.touched;
+
+  // Documents sharing no word with the query keep their initial score:
+  // the L1 norm of both histograms for "classic", 0 for the other methods.
+  if(distanceMethod == EDistanceMethod::CLASSIC)
+  {
+    uint32_t query_size = 0;
+    for(const auto& word : query)
+      query_size += word.second.size();
+
+    scores.resize(nbDocs);
+    for(std::size_t i = 0; i < nbDocs; ++i)
+      scores[i] = query_size + doc_sizes_[i];
+  }
+  else
+  {
+    scores.assign(nbDocs, 0.0f);
+  }
+  visited.assign(nbDocs, 0);
+  touched.clear();
+
+  // Accumulate the contribution of the common words over the posting lists of the query words
+  for(const auto& word : query)
+  {
+    if(word.first < 0 || word.first >= static_cast<Word>(word_files_.size()))
+      continue;
+
+    const uint32_t query_count = word.second.size();
+    const float weight = word_weights_[word.first];
+
+    for(const WordFrequency& wf : word_files_[word.first])
+    {
+      if(!visited[wf.index])
+      {
+        visited[wf.index] = 1;
+        touched.push_back(wf.index);
+      }
+
+      const uint32_t min_count = std::min(query_count, wf.count);
+      switch(distanceMethod)
+      {
+        case EDistanceMethod::CLASSIC:
+          // |a - b| = a + b - 2 * min(a, b)
+          scores[wf.index] -= 2.0f * min_count;
+          break;
+        case EDistanceMethod::COMMON_POINTS:
+          scores[wf.index] -= min_count;
+          break;
+        case EDistanceMethod::STRONG_COMMON_POINTS:
+          if(query_count == 1 && wf.count == 1)
+            scores[wf.index] -= 1.0f;
+          break;
+        case EDistanceMethod::WEIGHTED_STRONG_COMMON_POINTS:
+          if(query_count == 1 && wf.count == 1)
+            scores[wf.index] -= weight;
+          break;
+        case EDistanceMethod::INVERSED_WEIGHTED_COMMON_POINTS:
+          scores[wf.index] -= weight / min_count;
+          break;
+      }
+    }
+  }
+
+  // Only the documents sharing a word can be better than the others (score 0),
+  // except for "classic" where all the documents have a different score.
+  matches.clear();
+  if(distanceMethod != EDistanceMethod::CLASSIC && touched.size() >= N)
+  {
+    matches.reserve(touched.size());
+    for(const uint32_t i : touched)
+      matches.emplace_back(doc_ids_[i], scores[i]);
+  }
+  else
+  {
+    matches.reserve(nbDocs);
+    for(std::size_t i = 0; i < nbDocs; ++i)
+      matches.emplace_back(doc_ids_[i], scores[i]);
+  }
+
+  // Extract the best N
+  const std::size_t nbMatches = std::min(N, matches.size());
+  std::partial_sort(matches.begin(), matches.begin() + nbMatches, matches.end(),
+    [](const DocMatch& a, const DocMatch& b)
+    {
+      return a.score < b.score || (a.score == b.score && a.id < b.id);
+    });
+  matches.resize(nbMatches);
 }
 
 /**
@@ -177,6 +290,111 @@ void Database::loadWeights(const std::string& file)
   }
 }
 
+namespace {
+
+/// "AVVD" and version of the database file format
+const uint32_t databaseMagic = 0x44565641;
+const uint32_t databaseVersion = 1;
+
+template<typename T>
+void writeValue(std::ostream& out, const T& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T readValue(std::istream& in)
+{
+  T value;
+  in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return value;
+}
+
+} // namespace
+
+void Database::save(const std::string& file) const
+{
+  std::ofstream out(file.c_str(), std::ios_base::binary);
+  if(!out.is_open())
+    throw std::runtime_error((boost::format("Failed to open database file '%s' for writing") % file).str());
+
+  writeValue<uint32_t>(out, databaseMagic);
+  writeValue<uint32_t>(out, databaseVersion);
+
+  const uint32_t num_words = word_weights_.size();
+  writeValue<uint32_t>(out, num_words);
+  out.write((const char*) word_weights_.data(), num_words * sizeof (float));
+
+  // documents in insertion order
+  writeValue<uint32_t>(out, doc_ids_.size());
+  for(const DocId doc_id : doc_ids_)
+  {
+    const SparseHistogram& document = database_.at(doc_id);
+    writeValue<uint32_t>(out, doc_id);
+    writeValue<uint32_t>(out, document.size());
+    for(const auto& word : document)
+    {
+      writeValue<int32_t>(out, word.first);
+      writeValue<uint32_t>(out, word.second.size());
+      out.write((const char*) word.second.data(), word.second.size() * sizeof (IndexT));
+    }
+  }
+
+  if(!out.good())
+    throw std::runtime_error((boost::format("Failed to write database file '%s'") % file).str());
+}
+
+void Database::load(const std::string& file)
+{
+  std::ifstream in;
+  in.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
+
+  try
+  {
+    in.open(file.c_str(), std::ios_base::binary);
+
+    if(readValue<uint32_t>(in) != databaseMagic)
+      throw std::runtime_error((boost::format("Invalid database file '%s'") % file).str());
+    const uint32_t version = readValue<uint32_t>(in);
+    if(version != databaseVersion)
+      throw std::runtime_error((boost::format("Unsupported database file version %d in '%s'") % version % file).str());
+
+    const uint32_t num_words = readValue<uint32_t>(in);
+    word_files_.assign(num_words, InvertedFile());
+    word_weights_.resize(num_words);
+    in.read((char*) word_weights_.data(), num_words * sizeof (float));
+
+    database_.clear();
+    doc_ids_.clear();
+    doc_sizes_.clear();
+
+    const uint32_t num_docs = readValue<uint32_t>(in);
+    doc_ids_.reserve(num_docs);
+    doc_sizes_.reserve(num_docs);
+    for(uint32_t i = 0; i < num_docs; ++i)
+    {
+      const DocId doc_id = readValue<uint32_t>(in);
+      const uint32_t num_doc_words = readValue<uint32_t>(in);
+      SparseHistogram document;
+      for(uint32_t j = 0; j < num_doc_words; ++j)
+      {
+        const Word word = readValue<int32_t>(in);
+        std::vector<IndexT>& features = document[word];
+        features.resize(readValue<uint32_t>(in));
+        in.read((char*) features.data(), features.size() * sizeof (IndexT));
+
+        if(word < 0 || word >= static_cast<Word>(num_words))
+          throw std::runtime_error((boost::format("Invalid word %d in database file '%s'") % word % file).str());
+      }
+      insert(doc_id, document);
+    }
+  }
+  catch(std::ifstream::failure& e)
+  {
+    throw std::runtime_error((boost::format("Failed to load database file '%s'") % file).str());
+  }
+}
+
 ///**
 // * Normalize a document vector representing the histogram of visual words for a given image
 // * 
@@ -51,6 +51,24 @@ struct DocMatch
 
 typedef std::vector<DocMatch> DocMatches;
 
+/**
+ * @brief Distance methods between two sparse histograms (see sparseDistance).
+ */
+enum class EDistanceMethod
+{
+  CLASSIC,
+  COMMON_POINTS,
+  STRONG_COMMON_POINTS,
+  WEIGHTED_STRONG_COMMON_POINTS,
+  INVERSED_WEIGHTED_COMMON_POINTS
+};
+
+/**
+ * @brief Convert a distance method name ("classic", "commonPoints", ...) into its enum value.
+ * @throw std::invalid_argument if the name is unknown
+ */
+EDistanceMethod EDistanceMethod_stringToEnum(const std::string& distanceMethod);
+
 /**
  * @brief Class for efficiently matching a bag-of-words representation of a document (image) against
  * a database of known documents.
@@ -75,6 +93,16 @@ public:
    */
   DocId insert(DocId doc_id, const SparseHistogram& document);
 
+  /**
+   * @brief Check if a document has already been inserted.
+   * @param doc_id ID of the document
+   * @return true if the document is in the database
+   */
+  bool hasDocument(DocId doc_id) const
+  {
+    return database_.find(doc_id) != database_.end();
+  }
+
   /**
    * @brief Perform a sanity check of the database by querying each document
    * of the database and finding its top N matches
@@ -104,6 +132,17 @@ public:
    */
   void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
 
+  /**
+   * @brief Find the top N matches in the database for each query document.
+   * The queries are processed in parallel.
+   *
+   * @param[in] queries The query documents, normalized sets of quantized words.
+   * @param[in] N        The number of matches to return for each query.
+   * @param[out] matches  IDs and scores for the top N matching database documents, one entry per query.
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void find(const std::vector<SparseHistogram>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
    * training examples into the database.
@@ -118,14 +157,30 @@ public:
    */
   std::size_t size() const;
 
+  /// Get the number of words of the vocabulary.
+  uint32_t words() const
+  {
+    return word_files_.size();
+  }
+
   /// Save the vocabulary word weights to a file.
   void saveWeights(const std::string& file) const;
   /// Load the vocabulary word weights from a file.
   void loadWeights(const std::string& file);
 
-  // Save weights and documents
-  //void save(const std::string& file) const;
-  //void load(const std::string& file);
+  /**
+   * @brief Save the word weights and the documents (with their sparse histograms) to a file.
+   * New documents can be inserted in the loaded database without quantizing the previous ones again.
+   * @param file the output file path
+   */
+  void save(const std::string& file) const;
+
+  /**
+   * @brief Load the word weights and the documents saved by save(), the current content is replaced.
+   * The documents are inserted in the same order as in the saved database.
+   * @param file the input file path
+   */
+  void load(const std::string& file);
 
   const SparseHistogramPerImage& getSparseHistogramPerImage() const
   {
@@ -137,18 +192,36 @@ private:
   struct WordFrequency
   {
     DocId id;
+    /// index of the document in doc_ids_
+    uint32_t index;
     uint32_t count;
 
     WordFrequency() = default;
-    WordFrequency(DocId _id, uint32_t _count)
+    WordFrequency(DocId _id, uint32_t _index, uint32_t _count)
       : id(_id)
+      , index(_index)
       , count(_count)
     {}
   };
 
-  // Stored in increasing order by DocId
+  // Stored in insertion order of the documents
   typedef std::vector<WordFrequency> InvertedFile;
 
+  /// Per thread buffers used to score the documents of the database against a query
+  struct QueryBuffers
+  {
+    std::vector<float> scores;
+    std::vector<char> visited;
+    std::vector<uint32_t> touched;
+  };
+
+  /**
+   * @brief Score all the documents of the database against the query using the inverted files,
+   * only the posting lists of the query words are visited.
+   */
+  void find(const SparseHistogram& query, std::size_t N, EDistanceMethod distanceMethod,
+            QueryBuffers& buffers, std::vector<DocMatch>& matches) const;
+
   /// @todo Use sorted vector?
   // typedef std::vector< std::pair<Word, float> > DocumentVector;
   
@@ -157,6 +230,8 @@ private:
   std::vector<InvertedFile> word_files_;
   std::vector<float> word_weights_;
   SparseHistogramPerImage database_; // Precomputed for inserted documents
+  std::vector<DocId> doc_ids_; // Inserted documents in insertion order
+  std::vector<uint32_t> doc_sizes_; // Number of features of each inserted document
 
   /**
    * Normalize a document vector representing the histogram of visual words for a given image
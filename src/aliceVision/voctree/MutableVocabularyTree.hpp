@@ -16,6 +16,7 @@ namespace voctree {
  * intended for building a new tree.
  *
  * When loading and using an existing vocabulary tree, use VocabularyTree instead.
+ * The centers are not flattened, the features are quantized with the distance functor.
  */
 template<class Feature, template<typename, typename> class Distance = L2,
 class FeatureAllocator = typename DefaultAllocator<Feature>::type>
@@ -59,6 +60,12 @@ public:
   {
     return this->valid_centers_;
   }
+
+  /// Load vocabulary from a file, keeping the editable centers.
+  void load(const std::string& file) override
+  {
+    BaseClass::loadCenters(file);
+  }
 };
 
 }
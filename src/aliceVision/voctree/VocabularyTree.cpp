@@ -6,6 +6,8 @@
 
 #include "VocabularyTree.hpp"
 
+#include <cstdlib>
+
 namespace aliceVision {
 namespace voctree {
 
@@ -34,7 +36,7 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
       }
       else
       {
-        distance += fabs(i1->second.size() - i2->second.size());
+        distance += std::abs(static_cast<int>(i1->second.size()) - static_cast<int>(i2->second.size()));
         ++i1;
         ++i2;
       }
@@ -160,6 +162,8 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
         N1 += i1->second.size()*word_weights[i1->first];
          ++i1;
       }
+      else
+      {
         if( ( fabs(i1->second.size() - 1.0) < epsilon ) && ( fabs(i2->second.size() - 1.0) < epsilon) )
         {
           score += word_weights[i1->first];
@@ -168,6 +172,7 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
         }
         ++i1;
         ++i2;
+      }
     }
 
     while(i1 != i1e)
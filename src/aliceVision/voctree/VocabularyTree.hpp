@@ -17,6 +17,9 @@
 #include <aliceVision/system/Logger.hpp>
 
 #include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <type_traits>
 #include <vector>
 #include <map>
 #include <cassert>
@@ -88,6 +91,36 @@ public:
 
 inline IVocabularyTree::~IVocabularyTree() {}
 
+namespace detail {
+
+/// Type of the flattened centers values (unused if the distance is not element-wise)
+template<class Feature, bool ElementWise>
+struct FlatCenterValue
+{
+  typedef uint8_t type;
+};
+
+template<class Feature>
+struct FlatCenterValue<Feature, true>
+{
+  typedef typename Feature::value_type type;
+};
+
+/**
+ * @brief Type used to accumulate the squared differences on the flattened centers.
+ * The sums of byte values are exact in 32 bits integers (up to 33025 dimensions) and
+ * equal to the sums in double, the other types use double like L2.
+ */
+template<typename ValueA, typename ValueB>
+struct FlatL2Accumulator
+{
+  typedef typename std::conditional<std::is_integral<ValueA>::value && sizeof(ValueA) == 1 &&
+                                    std::is_integral<ValueB>::value && sizeof(ValueB) == 1,
+                                    int32_t, double>::type type;
+};
+
+} // namespace detail
+
 /**
  * @brief Optimized vocabulary tree quantizer, templated on feature type and distance metric
  * for maximum efficiency.
@@ -99,6 +132,9 @@ inline IVocabularyTree::~IVocabularyTree() {}
  * a metric; distances simply need to be comparable.
  *
  * \c FeatureAllocator is an STL-compatible allocator used to allocate Features internally.
+ *
+ * If the distance is element-wise (see IsElementWiseL2), the loaded centers are only kept in a flattened layout
+ * suited to the quantization of the descriptors by blocks.
  */
 template<class Feature, template<typename, typename> class Distance = L2, // TODO: rename Feature into Descriptor
 class FeatureAllocator = typename DefaultAllocator<Feature>::type>
@@ -149,6 +185,7 @@ public:
   bool operator==(const VocabularyTree& other) const
   {
     return (centers_ == other.centers_) &&
+        (flat_centers_ == other.flat_centers_) &&
         (valid_centers_ == other.valid_centers_) &&
         (k_ == other.k_) &&
         (levels_ == other.levels_) &&
@@ -157,7 +194,16 @@ public:
   }
 
 protected:
-  std::vector<Feature, FeatureAllocator> centers_;
+  /// True if the distance can be evaluated on the flattened centers
+  static const bool flatDistance = IsElementWiseL2< Distance<Feature, Feature> >::value;
+  typedef typename detail::FlatCenterValue<Feature, flatDistance>::type FlatValue;
+
+  /// Number of descriptors quantized together
+  static const std::size_t quantizeBlockSize = 64;
+  /// Number of children whose distances are computed together (children padded to a multiple)
+  static const uint32_t flatLanes = 4;
+
+  std::vector<Feature, FeatureAllocator> centers_; // empty if the centers are flattened
   std::vector<uint8_t> valid_centers_; /// @todo Consider bit-vector
 
   uint32_t k_; // splits, or branching factor
@@ -165,23 +211,77 @@ protected:
   uint32_t num_words_; // number of leaf nodes
   uint32_t word_start_; // number of non-leaf nodes, or offset to the first leaf node
 
+  /**
+   * Centers of the children of each non-leaf node (virtual root first, then level by level).
+   * The children of a node are stored by groups of flatLanes children, dimension-major:
+   * [flat_splits_ / flatLanes][dimension][flatLanes], so that the distances to the children
+   * of a group are computed together. Empty if the centers are not flattened.
+   */
+  std::vector<FlatValue> flat_centers_;
+  std::vector<uint32_t> flat_valid_children_; // number of children before the first invalid one
+  uint32_t flat_dimension_;
+  uint32_t flat_splits_; // splits padded to a multiple of flatLanes
+
   bool initialized() const
   {
     return num_words_ != 0;
   }
 
+  /// True if the flattened centers have the layout of the tree size
+  bool hasFlatCenters() const
+  {
+    const std::size_t nbCenters = std::size_t(word_start_) + num_words_;
+    return k_ != 0 && flat_dimension_ != 0 &&
+        flat_splits_ == (k_ + flatLanes - 1) / flatLanes * flatLanes &&
+        valid_centers_.size() == nbCenters &&
+        flat_valid_children_.size() * k_ == nbCenters &&
+        flat_centers_.size() == flat_valid_children_.size() * flat_dimension_ * flat_splits_;
+  }
+
   void setNodeCounts();
+
+  /// Read the tree size and the centers of a vocabulary file.
+  void loadCenters(const std::string& file);
+
+private:
+  /// Move centers_ to the flattened centers if the distance is element-wise.
+  void flattenCenters(std::false_type) {}
+  void flattenCenters(std::true_type);
+
+  /// Get a center from centers_ or from the flattened centers.
+  Feature getCenter(std::size_t index) const;
+
+  template<class DescriptorT>
+  void quantizeBlock(const DescriptorT* features, std::size_t count, Word* words) const
+  {
+    quantizeBlock(features, count, words, std::integral_constant<bool, flatDistance &&
+                  IsElementWiseL2< Distance<DescriptorT, Feature> >::value>());
+  }
+
+  template<class DescriptorT>
+  void quantizeBlock(const DescriptorT* features, std::size_t count, Word* words, std::false_type) const
+  {
+    for(std::size_t i = 0; i < count; ++i)
+      words[i] = quantizeNaive(features[i]);
+  }
+
+  template<class DescriptorT>
+  void quantizeBlock(const DescriptorT* features, std::size_t count, Word* words, std::true_type) const;
+
+  /// Quantize a feature with the distance functor on the centers.
+  template<class DescriptorT>
+  Word quantizeNaive(const DescriptorT& feature) const;
 };
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 VocabularyTree<Feature, Distance, FeatureAllocator>::VocabularyTree()
-: k_(0), levels_(0), num_words_(0), word_start_(0)
+: k_(0), levels_(0), num_words_(0), word_start_(0), flat_dimension_(0), flat_splits_(0)
 {
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 VocabularyTree<Feature, Distance, FeatureAllocator>::VocabularyTree(const std::string& file)
-: k_(0), levels_(0), num_words_(0), word_start_(0)
+: k_(0), levels_(0), num_words_(0), word_start_(0), flat_dimension_(0), flat_splits_(0)
 {
   load(file);
 }
@@ -189,12 +289,42 @@ VocabularyTree<Feature, Distance, FeatureAllocator>::VocabularyTree(const std::s
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 template<class DescriptorT>
 Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const DescriptorT& feature) const
+{
+  Word word;
+  quantizeBlock(&feature, 1, &word);
+  return word;
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const std::vector<DescriptorT>& features) const
+{
+  // ALICEVISION_LOG_DEBUG("VocabularyTree quantize: " << features.size());
+  std::vector<Word> imgVisualWords(features.size(), 0);
+
+  // quantize the features by blocks
+  const std::size_t blockSize = quantizeBlockSize;
+  const std::ptrdiff_t nbBlocks = (features.size() + blockSize - 1) / blockSize;
+  #pragma omp parallel for
+  for(std::ptrdiff_t b = 0; b < nbBlocks; ++b)
+  {
+    const std::size_t begin = b * blockSize;
+    const std::size_t count = std::min(blockSize, features.size() - begin);
+    // store the visual words associated to the features in the temporary list
+    quantizeBlock(&features[begin], count, &imgVisualWords[begin]);
+  }
+
+  // add the vector to the documents
+  return imgVisualWords;
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantizeNaive(const DescriptorT& feature) const
 {
   typedef typename Distance<Feature, DescriptorT>::result_type distance_type;
 
-  //	printf("asserting\n");
   assert(initialized());
-  //	printf("initialized\n");
   int32_t index = -1; // virtual "root" index, which has no associated center.
   for(unsigned level = 0; level < levels_; ++level)
   {
@@ -207,7 +337,9 @@ Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const Descrip
     {
       if(!valid_centers_[child])
         break; // Fewer than splits() children.
-      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers_[child]);
+      distance_type child_distance = centers_.empty() ?
+            Distance<DescriptorT, Feature>()(feature, getCenter(child)) :
+            Distance<DescriptorT, Feature>()(feature, centers_[child]);
       if(child_distance < best_distance)
       {
         best_child = child;
@@ -222,21 +354,69 @@ Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const Descrip
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 template<class DescriptorT>
-std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const std::vector<DescriptorT>& features) const
+void VocabularyTree<Feature, Distance, FeatureAllocator>::quantizeBlock(const DescriptorT* features, std::size_t count, Word* words, std::true_type) const
 {
-  // ALICEVISION_LOG_DEBUG("VocabularyTree quantize: " << features.size());
-  std::vector<Word> imgVisualWords(features.size(), 0);
+  if(!hasFlatCenters())
+  {
+    quantizeBlock(features, count, words, std::false_type());
+    return;
+  }
 
-  // quantize the features
-  #pragma omp parallel for
-  for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(features.size()); ++j)
+  typedef typename detail::FlatL2Accumulator<typename DescriptorT::value_type, FlatValue>::type Accumulator;
+
+  assert(initialized());
+  const std::size_t nodeSize = std::size_t(flat_dimension_) * flat_splits_;
+  assert(count <= quantizeBlockSize);
+  // scratch buffer reused by the calls of the thread
+  static thread_local std::vector<Accumulator> distances;
+  distances.resize(flat_splits_);
+  std::array<int32_t, quantizeBlockSize> indexes;
+  indexes.fill(-1); // virtual "root" index, which has no associated center.
+
+  // go down the tree level by level for all the features of the block
+  for(unsigned level = 0; level < levels_; ++level)
   {
-    // store the visual word associated to the feature in the temporary list
-    imgVisualWords[j] = quantize<DescriptorT>(features[j]);
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      const DescriptorT& feature = features[i];
+      assert(feature.size() == flat_dimension_);
+      const int32_t parent = indexes[i] + 1;
+      const FlatValue* children = &flat_centers_[parent * nodeSize];
+
+      // distances to the children, in the same order of operations as L2 for each child
+      for(uint32_t group = 0; group < flat_splits_; group += flatLanes)
+      {
+        const FlatValue* groupCenters = children + group * std::size_t(flat_dimension_);
+        Accumulator groupDistances[flatLanes] = {};
+        for(std::size_t d = 0; d < flat_dimension_; ++d)
+        {
+          const Accumulator value = static_cast<Accumulator>(feature[d]);
+          for(uint32_t l = 0; l < flatLanes; ++l)
+          {
+            const Accumulator diff = value - static_cast<Accumulator>(groupCenters[d * flatLanes + l]);
+            groupDistances[l] += diff * diff;
+          }
+        }
+        std::copy(groupDistances, groupDistances + flatLanes, &distances[group]);
+      }
+
+      // find the first closest valid child
+      uint32_t best_child = 0;
+      Accumulator best_distance = std::numeric_limits<Accumulator>::max();
+      for(uint32_t c = 0; c < flat_valid_children_[parent]; ++c)
+      {
+        if(distances[c] < best_distance)
+        {
+          best_child = c;
+          best_distance = distances[c];
+        }
+      }
+      indexes[i] = parent * k_ + best_child;
+    }
   }
 
-  // add the vector to the documents
-  return imgVisualWords;
+  for(std::size_t i = 0; i < count; ++i)
+    words[i] = indexes[i] - word_start_;
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -272,7 +452,9 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::clear()
 {
   centers_.clear();
   valid_centers_.clear();
-  k_ = levels_ = num_words_ = word_start_ = 0;
+  flat_centers_.clear();
+  flat_valid_children_.clear();
+  k_ = levels_ = num_words_ = word_start_ = flat_dimension_ = flat_splits_ = 0;
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -285,14 +467,32 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::save(const std::string
   std::ofstream out(file.c_str(), std::ios_base::binary);
   out.write((char*) (&k_), sizeof (uint32_t));
   out.write((char*) (&levels_), sizeof (uint32_t));
-  uint32_t size = centers_.size();
+  uint32_t size = valid_centers_.size();
   out.write((char*) (&size), sizeof (uint32_t));
-  out.write((char*) (&centers_[0]), centers_.size() * sizeof (Feature));
+  if(!centers_.empty())
+  {
+    out.write((char*) (&centers_[0]), centers_.size() * sizeof (Feature));
+  }
+  else
+  {
+    for(std::size_t i = 0; i < size; ++i)
+    {
+      const Feature center = getCenter(i);
+      out.write((const char*) (&center), sizeof (Feature));
+    }
+  }
   out.write((char*) (&valid_centers_[0]), valid_centers_.size());
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 void VocabularyTree<Feature, Distance, FeatureAllocator>::load(const std::string& file)
+{
+  loadCenters(file);
+  flattenCenters(std::integral_constant<bool, flatDistance>());
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::loadCenters(const std::string& file)
 {
   clear();
 
@@ -317,7 +517,8 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::load(const std::string
   }
 
   setNodeCounts();
-  assert(size == num_words_ + word_start_);
+  if(size != num_words_ + word_start_)
+    throw std::runtime_error("Invalid number of centers in the vocabulary tree file " + file);
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -332,6 +533,60 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::setNodeCounts()
   }
 }
 
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::flattenCenters(std::true_type)
+{
+  flat_centers_.clear();
+  flat_valid_children_.clear();
+  flat_dimension_ = flat_splits_ = 0;
+  if(k_ == 0 || centers_.empty())
+    return;
+
+  const std::size_t nbNodes = centers_.size() / k_;
+  flat_dimension_ = centers_.front().size();
+  flat_splits_ = (k_ + flatLanes - 1) / flatLanes * flatLanes;
+  const std::size_t nodeSize = std::size_t(flat_dimension_) * flat_splits_;
+
+  flat_centers_.assign(nbNodes * nodeSize, FlatValue(0));
+  flat_valid_children_.assign(nbNodes, 0);
+
+  for(std::size_t node = 0; node < nbNodes; ++node)
+  {
+    FlatValue* children = &flat_centers_[node * nodeSize];
+    uint32_t nbValid = 0;
+    while(nbValid < k_ && valid_centers_[node * k_ + nbValid])
+      ++nbValid;
+    flat_valid_children_[node] = nbValid;
+
+    for(uint32_t c = 0; c < k_; ++c)
+    {
+      const Feature& center = centers_[node * k_ + c];
+      FlatValue* groupCenters = children + (c / flatLanes) * flatLanes * std::size_t(flat_dimension_);
+      for(std::size_t d = 0; d < flat_dimension_; ++d)
+        groupCenters[d * flatLanes + c % flatLanes] = center[d];
+    }
+  }
+
+  // the flattened centers are the only copy
+  std::vector<Feature, FeatureAllocator>().swap(centers_);
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+Feature VocabularyTree<Feature, Distance, FeatureAllocator>::getCenter(std::size_t index) const
+{
+  if(!centers_.empty())
+    return centers_[index];
+
+  assert(hasFlatCenters());
+  const std::size_t nodeSize = std::size_t(flat_dimension_) * flat_splits_;
+  const std::size_t child = index % k_;
+  const FlatValue* groupCenters = &flat_centers_[(index / k_) * nodeSize + (child / flatLanes) * flatLanes * std::size_t(flat_dimension_)];
+  Feature center;
+  for(std::size_t d = 0; d < flat_dimension_; ++d)
+    center[d] = groupCenters[d * flatLanes + child % flatLanes];
+  return center;
+}
+
 /**
  * @brief compute the sparse distance between two histograms according to the chosen distance method.
  * 
@@ -20,7 +20,9 @@ class SfMData;
 namespace voctree {
 
 /**
- * @brief Given a vocabulary tree and a set of features it builds a database
+ * @brief Given a vocabulary tree and a set of features it builds a database.
+ * The images already in the database are skipped, so that a loaded database can be completed
+ * with the new images only.
  *
  * @param[in] fileFullPath A file containing the path the features to load, it could be a .txt or an AliceVision .json
  * @param[in] descFolder The folder containing the descriptor files (optional)
@@ -28,7 +30,7 @@ namespace voctree {
  * @param[out] db The built database
  * @param[out] documents A map containing for each image the list of associated visual words
  * @param[in] Nmax The maximum number of features loaded in each desc file. For Nmax = 0 (default), all the descriptors are loaded.
- * @return the number of overall features read
+ * @return the number of overall features read (for the new images)
  */
 template<class DescriptorT, class VocDescriptorT>
 std::size_t populateDatabase(const sfm::SfMData &sfmData,
@@ -10,6 +10,8 @@
 //#include <iostream>
 #include <Eigen/Core>
 
+#include <type_traits>
+
 namespace aliceVision {
 namespace voctree {
 
@@ -57,5 +59,20 @@ struct L2< Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>, Eigen::
   }
 };
 
+/**
+ * @brief Trait telling if a distance functor is the default element-wise L2,
+ * i.e. a sum of squared differences computed in double in the order of the elements.
+ * VocabularyTree evaluates such distances on its flattened centers with the same results.
+ */
+template<class Distance>
+struct IsElementWiseL2 : std::false_type {};
+
+template<class DescriptorA, class DescriptorB>
+struct IsElementWiseL2< L2<DescriptorA, DescriptorB> > : std::true_type {};
+
+/// The Eigen specialization sums the squared differences in Scalar with Eigen's own reduction order.
+template<typename Scalar, int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+struct IsElementWiseL2< L2< Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>, Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols> > > : std::false_type {};
+
 }
 }
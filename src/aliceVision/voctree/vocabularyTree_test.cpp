@@ -5,9 +5,16 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/MutableVocabularyTree.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <random>
 #include <vector>
 
 #define BOOST_TEST_MODULE vocabularyTree
@@ -17,6 +24,33 @@
 using namespace std;
 using namespace aliceVision::voctree;
 
+namespace {
+
+/// Documents of random words, with repeated words
+vector<SparseHistogram> createRandomDocuments(int cardDocuments, int cardWords, int cardFeatures)
+{
+  std::srand(0);
+  vector<SparseHistogram> documents(cardDocuments);
+  for(SparseHistogram& document : documents)
+  {
+    vector<Word> words(cardFeatures);
+    for(int j = 0; j < cardFeatures; ++j)
+      words[j] = std::rand() % cardWords;
+    computeSparseHistogram(words, document);
+  }
+  return documents;
+}
+
+/// Insert the first documents in a database and compute its weights
+void fillDatabase(Database& db, const vector<SparseHistogram>& documents, int cardDocuments)
+{
+  for(int i = 0; i < cardDocuments; ++i)
+    db.insert(i, documents[i]);
+  db.computeTfIdfWeights();
+}
+
+} // namespace
+
 BOOST_AUTO_TEST_CASE(database)
 {
   const int cardDocuments = 10;
@@ -57,3 +91,262 @@ BOOST_AUTO_TEST_CASE(database)
     BOOST_CHECK_SMALL(static_cast<double>(match[0].score), 0.001);
   }
 }
+
+BOOST_AUTO_TEST_CASE(database_invertedFileScoring)
+{
+  const int cardDocuments = 50;
+  const int cardWords = 200;
+  const int cardFeatures = 80;
+  const std::size_t nbMatches = 10;
+
+  // Create documents sharing random words
+  const vector<SparseHistogram> documents = createRandomDocuments(cardDocuments, cardWords, cardFeatures);
+  Database db(cardWords);
+  fillDatabase(db, documents, cardDocuments);
+
+  // Read back the weights to compute the reference distances
+  const std::string weightsFile = "database_invertedFileScoring_weights.bin";
+  db.saveWeights(weightsFile);
+  vector<float> weights(cardWords);
+  {
+    ifstream in(weightsFile, std::ios_base::binary);
+    uint32_t nbWords = 0;
+    in.read((char*)&nbWords, sizeof(uint32_t));
+    BOOST_CHECK_EQUAL(nbWords, cardWords);
+    in.read((char*)&weights[0], cardWords * sizeof(float));
+  }
+  std::remove(weightsFile.c_str());
+
+  const vector<string> distanceMethods = {"classic", "commonPoints", "strongCommonPoints",
+                                          "weightedStrongCommonPoints", "inversedWeightedCommonPoints"};
+
+  for(const string& distanceMethod : distanceMethods)
+  {
+    vector<DocMatches> batchMatches;
+    db.find(documents, nbMatches, batchMatches, distanceMethod);
+    BOOST_CHECK_EQUAL(batchMatches.size(), documents.size());
+
+    for(int i = 0; i < cardDocuments; ++i)
+    {
+      // Reference: linear scan over all the documents
+      DocMatches reference;
+      for(int j = 0; j < cardDocuments; ++j)
+        reference.emplace_back(j, sparseDistance(documents[i], documents[j], distanceMethod, weights));
+      std::sort(reference.begin(), reference.end());
+
+      DocMatches matches;
+      db.find(documents[i], nbMatches, matches, distanceMethod);
+      BOOST_CHECK_EQUAL(matches.size(), nbMatches);
+      BOOST_CHECK(matches == batchMatches[i]);
+
+      for(std::size_t k = 0; k < nbMatches; ++k)
+      {
+        // the best scores are the same (ids can differ in case of equal scores)
+        BOOST_CHECK_CLOSE(matches[k].score, reference[k].score, 0.01);
+        BOOST_CHECK_CLOSE(matches[k].score, sparseDistance(documents[i], documents[matches[k].id], distanceMethod, weights), 0.01);
+      }
+    }
+  }
+
+  DocMatches matches;
+  BOOST_CHECK_THROW(db.find(documents[0], nbMatches, matches, "unknown"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(database_saveLoad)
+{
+  const int cardDocuments = 30;
+  const int cardNewDocuments = 10;
+  const int cardWords = 100;
+  const int cardFeatures = 50;
+  const std::size_t nbMatches = 5;
+
+  const vector<SparseHistogram> documents = createRandomDocuments(cardDocuments + cardNewDocuments, cardWords, cardFeatures);
+
+  // database of the first documents, saved and loaded
+  Database db(cardWords);
+  fillDatabase(db, documents, cardDocuments);
+
+  const std::string databaseFile = "database_saveLoad.db";
+  db.save(databaseFile);
+  Database loadedDb;
+  loadedDb.load(databaseFile);
+  std::remove(databaseFile.c_str());
+
+  BOOST_CHECK_EQUAL(loadedDb.size(), db.size());
+  BOOST_CHECK_EQUAL(loadedDb.words(), db.words());
+  BOOST_CHECK(loadedDb.getSparseHistogramPerImage() == db.getSparseHistogramPerImage());
+  BOOST_CHECK(loadedDb.hasDocument(0));
+  BOOST_CHECK(!loadedDb.hasDocument(cardDocuments));
+
+  // append the new documents to the loaded database and to a database built from scratch
+  Database fullDb(cardWords);
+  for(int i = 0; i < cardDocuments + cardNewDocuments; ++i)
+  {
+    fullDb.insert(i, documents[i]);
+    if(!loadedDb.hasDocument(i))
+      loadedDb.insert(i, documents[i]);
+  }
+  fullDb.computeTfIdfWeights();
+  loadedDb.computeTfIdfWeights();
+
+  for(const string distanceMethod : {"classic", "strongCommonPoints", "weightedStrongCommonPoints"})
+  {
+    vector<DocMatches> matches, fullMatches;
+    loadedDb.find(documents, nbMatches, matches, distanceMethod);
+    fullDb.find(documents, nbMatches, fullMatches, distanceMethod);
+    BOOST_CHECK(matches == fullMatches);
+  }
+
+  BOOST_CHECK_THROW(loadedDb.load("database_saveLoad_missing.db"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(database_loadWithWeights)
+{
+  const int cardDocuments = 30;
+  const int cardNewDocuments = 10;
+  const int cardWords = 100;
+  const int cardFeatures = 50;
+  const std::size_t nbMatches = 5;
+
+  const vector<SparseHistogram> documents = createRandomDocuments(cardDocuments + cardNewDocuments, cardWords, cardFeatures);
+
+  // user weights, computed on other documents than the database ones
+  const std::string weightsFile = "database_loadWithWeights.weights";
+  {
+    Database weightsDb(cardWords);
+    for(int i = 0; i < cardNewDocuments; ++i)
+      weightsDb.insert(i, documents[cardDocuments + i]);
+    weightsDb.computeTfIdfWeights();
+    weightsDb.saveWeights(weightsFile);
+  }
+
+  // database of the first documents with its own weights
+  const std::string databaseFile = "database_loadWithWeights.db";
+  {
+    Database db(cardWords);
+    fillDatabase(db, documents, cardDocuments);
+    db.save(databaseFile);
+  }
+
+  // incremental run: the user weights are loaded after the database
+  Database loadedDb(cardWords);
+  loadedDb.load(databaseFile);
+  loadedDb.loadWeights(weightsFile);
+  Database fullDb(cardWords);
+  fullDb.loadWeights(weightsFile);
+  std::remove(databaseFile.c_str());
+  std::remove(weightsFile.c_str());
+
+  for(int i = 0; i < cardDocuments + cardNewDocuments; ++i)
+  {
+    fullDb.insert(i, documents[i]);
+    if(!loadedDb.hasDocument(i))
+      loadedDb.insert(i, documents[i]);
+  }
+
+  // the scores use the user weights, not the weights saved in the database
+  for(const string distanceMethod : {"classic", "strongCommonPoints", "weightedStrongCommonPoints"})
+  {
+    vector<DocMatches> matches, fullMatches;
+    loadedDb.find(documents, nbMatches, matches, distanceMethod);
+    fullDb.find(documents, nbMatches, fullMatches, distanceMethod);
+    BOOST_CHECK(matches == fullMatches);
+  }
+}
+
+/**
+ * @brief Reference quantization: distance to each child center until the first invalid one.
+ */
+template<class FeatureT, class DescriptorT>
+Word quantizeReference(const MutableVocabularyTree<FeatureT>& tree, const DescriptorT& feature)
+{
+  const int32_t wordStart = tree.nodes() - tree.words();
+  int32_t index = -1;
+  for(unsigned level = 0; level < tree.levels(); ++level)
+  {
+    const int32_t firstChild = (index + 1) * tree.splits();
+    int32_t bestChild = firstChild;
+    double bestDistance = std::numeric_limits<double>::max();
+    for(int32_t child = firstChild; child < firstChild + (int32_t) tree.splits(); ++child)
+    {
+      if(!tree.validCenters()[child])
+        break;
+      const double distance = L2<DescriptorT, FeatureT>()(feature, tree.centers()[child]);
+      if(distance < bestDistance)
+      {
+        bestChild = child;
+        bestDistance = distance;
+      }
+    }
+    index = bestChild;
+  }
+  return index - wordStart;
+}
+
+template<class TreeT, class FeatureT, class DescriptorT>
+void checkQuantization(const TreeT& tree, const MutableVocabularyTree<FeatureT>& referenceTree, const std::vector<DescriptorT>& features)
+{
+  const std::vector<Word> words = tree.quantize(features);
+  BOOST_CHECK_EQUAL(words.size(), features.size());
+  for(std::size_t i = 0; i < features.size(); ++i)
+  {
+    const Word reference = quantizeReference(referenceTree, features[i]);
+    BOOST_CHECK_EQUAL(words[i], reference);
+    BOOST_CHECK_EQUAL(tree.quantize(features[i]), reference);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(vocabularyTree_flatQuantization)
+{
+  typedef aliceVision::feature::Descriptor<unsigned char, 128> DescriptorUChar;
+  typedef aliceVision::feature::Descriptor<float, 128> DescriptorFloat;
+  typedef MutableVocabularyTree<DescriptorUChar> Tree;
+
+  const uint32_t levels = 3;
+  const uint32_t splits = 10;
+  std::mt19937 generator(0);
+  // few values to get equal distances
+  std::uniform_int_distribution<int> value(0, 3);
+
+  Tree tree;
+  tree.setSize(levels, splits);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters().resize(tree.nodes());
+  for(std::size_t i = 0; i < tree.nodes(); ++i)
+  {
+    for(std::size_t d = 0; d < DescriptorUChar::static_size; ++d)
+      tree.centers()[i][d] = value(generator);
+    // some nodes have fewer or no children, and an invalid child hides the next ones
+    tree.validCenters()[i] = ((i % splits < 7 || i % 7 != 0) && i % 23 != 10) ? 1 : 0;
+  }
+
+  std::vector<DescriptorUChar> featuresUChar(500);
+  std::vector<DescriptorFloat> featuresFloat(featuresUChar.size());
+  std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+  for(std::size_t i = 0; i < featuresUChar.size(); ++i)
+  {
+    for(std::size_t d = 0; d < DescriptorUChar::static_size; ++d)
+    {
+      featuresUChar[i][d] = value(generator);
+      featuresFloat[i][d] = featuresUChar[i][d] + noise(generator);
+    }
+  }
+
+  // quantization with the centers
+  checkQuantization(tree, tree, featuresUChar);
+  checkQuantization(tree, tree, featuresFloat);
+
+  // quantization with the flattened centers, computed on load
+  const std::string treeName = "vocabularyTree_flatQuantization.tree";
+  tree.save(treeName);
+  VocabularyTree<DescriptorUChar> loadedTree(treeName);
+  checkQuantization(loadedTree, tree, featuresUChar);
+  checkQuantization(loadedTree, tree, featuresFloat);
+
+  // the centers saved from the flattened centers are unchanged
+  loadedTree.save(treeName);
+  Tree reloadedTree;
+  reloadedTree.load(treeName);
+  std::remove(treeName.c_str());
+  BOOST_CHECK(reloadedTree == tree);
+}
@@ -0,0 +1,217 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/image/all.hpp>
+#include <aliceVision/feature/akaze/AKAZE.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::image;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Generate a textured image with random blobs.
+ */
+void generateImage(int width, int height, Image<float>& image)
+{
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+
+  image.resize(width, height);
+  image.fill(0.5f);
+
+  const int nbBlobs = width * height / 2000;
+  for(int b = 0; b < nbBlobs; ++b)
+  {
+    const float x = distribution(generator) * width;
+    const float y = distribution(generator) * height;
+    const float radius = 2.f + distribution(generator) * 20.f;
+    const float value = distribution(generator) - 0.5f;
+
+    for(int i = std::max(0, int(y - radius)); i < std::min(height, int(y + radius) + 1); ++i)
+      for(int j = std::max(0, int(x - radius)); j < std::min(width, int(x + radius) + 1); ++j)
+        if((i - y) * (i - y) + (j - x) * (j - x) < radius * radius)
+          image(i, j) = std::min(1.f, std::max(0.f, image(i, j) + value));
+  }
+}
+
+/**
+ * @brief Build a SIFT-like Gaussian pyramid: each octave is a cascade of Gaussian blurs,
+ *        the next octave starts from the half sampling of the last scale.
+ */
+template<typename ImageT>
+void buildGaussianPyramid(const ImageT& image, int nbOctaves, int nbScales, std::vector<ImageT>& pyramid)
+{
+  const double sigmaMin = 1.6;
+  const double k = std::pow(2.0, 1.0 / nbScales);
+
+  pyramid.resize(nbOctaves * (nbScales + 3));
+  ImageGaussianFilter(image, sigmaMin, pyramid[0]);
+
+  for(int o = 0; o < nbOctaves; ++o)
+  {
+    ImageT* octave = &pyramid[o * (nbScales + 3)];
+    if(o > 0)
+      ImageHalfSample(*(octave - 3), octave[0]);
+
+    for(int s = 1; s < nbScales + 3; ++s)
+    {
+      // incremental blur from the previous scale
+      const double sigma = sigmaMin * std::pow(k, s - 1) * std::sqrt(k * k - 1.0);
+      ImageGaussianFilter(octave[s - 1], sigma, octave[s]);
+    }
+  }
+}
+
+template<typename ImageT>
+void genericSeparableConvolution(const ImageT& image, const Vec& kernel, ImageT& out)
+{
+  typedef Eigen::Matrix<typename Accumulator<typename ImageT::Tpixel>::Type, Eigen::Dynamic, 1> VecKernel;
+  const VecKernel kernelCast = kernel.cast<typename Accumulator<typename ImageT::Tpixel>::Type>();
+  ImageT tmp;
+  ImageHorizontalConvolution(image, kernelCast, tmp);
+  ImageVerticalConvolution(tmp, kernelCast, out);
+}
+
+void printResult(const std::string& name, double time, int nbRuns)
+{
+  std::cout << std::left << std::setw(40) << name
+            << std::right << std::fixed << std::setprecision(2)
+            << "time: " << std::setw(10) << 1000.0 * time / nbRuns << " ms" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  int width = 4000;
+  int height = 3000;
+  int nbRuns = 5;
+  int nbThreads = 0;
+  int nbOctaves = 4;
+  int nbScales = 3;
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::EVerboseLevel::Warning);
+
+  po::options_description allParams("Benchmark of the image convolutions and pyramids (AKAZE and SIFT scale spaces).");
+  allParams.add_options()
+    ("help,h", "Show this help.")
+    ("width", po::value<int>(&width)->default_value(width),
+      "Width of the generated image.")
+    ("height", po::value<int>(&height)->default_value(height),
+      "Height of the generated image.")
+    ("nbRuns", po::value<int>(&nbRuns)->default_value(nbRuns),
+      "Number of runs of each workload.")
+    ("nbThreads", po::value<int>(&nbThreads)->default_value(nbThreads),
+      "Number of threads (0 for all the available threads).")
+    ("nbOctaves", po::value<int>(&nbOctaves)->default_value(nbOctaves),
+      "Number of octaves of the Gaussian pyramid.")
+    ("nbScales", po::value<int>(&nbScales)->default_value(nbScales),
+      "Number of scales per octave of the Gaussian pyramid.")
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+
+    if(width <= 0 || height <= 0 || nbRuns <= 0 || nbOctaves <= 0 || nbScales <= 0)
+      throw po::error("the image size, the number of runs, octaves and scales must be positive");
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(nbThreads > 0)
+    omp_set_num_threads(nbThreads);
+
+  Image<float> imageFloat;
+  generateImage(width, height, imageFloat);
+  const Image<unsigned char> imageUChar(Image<unsigned char>((imageFloat * 255.f).cast<unsigned char>()));
+
+  std::cout << "Image: " << width << "x" << height << ", " << omp_get_max_threads() << " thread(s), "
+            << nbRuns << " run(s) per workload" << std::endl;
+
+  const Vec kernel = ComputeGaussianKernel(0, 1.6);
+  {
+    Image<float> out;
+    system::Timer timer;
+    for(int r = 0; r < nbRuns; ++r)
+      genericSeparableConvolution(imageFloat, kernel, out);
+    printResult("convolution float (generic)", timer.elapsed(), nbRuns);
+
+    timer.reset();
+    for(int r = 0; r < nbRuns; ++r)
+      ImageSeparableConvolution(imageFloat, kernel, kernel, out);
+    printResult("convolution float", timer.elapsed(), nbRuns);
+  }
+  {
+    Image<unsigned char> out;
+    system::Timer timer;
+    for(int r = 0; r < nbRuns; ++r)
+      genericSeparableConvolution(imageUChar, kernel, out);
+    printResult("convolution uchar (generic)", timer.elapsed(), nbRuns);
+
+    timer.reset();
+    for(int r = 0; r < nbRuns; ++r)
+      ImageSeparableConvolution(imageUChar, kernel, kernel, out);
+    printResult("convolution uchar", timer.elapsed(), nbRuns);
+  }
+  {
+    Image<float> out;
+    system::Timer timer;
+    for(int r = 0; r < nbRuns; ++r)
+      ImageHalfSample(imageFloat, out);
+    printResult("half sample float", timer.elapsed(), nbRuns);
+  }
+  {
+    std::vector<Image<float>> pyramid;
+    system::Timer timer;
+    for(int r = 0; r < nbRuns; ++r)
+      buildGaussianPyramid(imageFloat, nbOctaves, nbScales, pyramid);
+    printResult("SIFT pyramid float", timer.elapsed(), nbRuns);
+  }
+  {
+    std::vector<Image<unsigned char>> pyramid;
+    system::Timer timer;
+    for(int r = 0; r < nbRuns; ++r)
+      buildGaussianPyramid(imageUChar, nbOctaves, nbScales, pyramid);
+    printResult("SIFT pyramid uchar", timer.elapsed(), nbRuns);
+  }
+  {
+    system::Timer timer;
+    for(int r = 0; r < nbRuns; ++r)
+    {
+      feature::AKAZE akaze(imageFloat, feature::AKAZEConfig());
+      akaze.Compute_AKAZEScaleSpace();
+    }
+    printResult("AKAZE scale space", timer.elapsed(), nbRuns);
+  }
+
+  return EXIT_SUCCESS;
+}
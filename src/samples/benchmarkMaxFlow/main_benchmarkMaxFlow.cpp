@@ -0,0 +1,197 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/MaxFlowGraph.hpp>
+#include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_PushRelabel.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Generate a 3D grid graph with random capacities, similar to the graph of a tetrahedralization
+ * (each node is connected to its neighbors in both directions and to the source or the sink).
+ * The nodes inside a sphere are mostly linked to the sink (full) and the others to the source (empty).
+ */
+void generateGridGraph(int gridSize, MaxFlowGraph& graph)
+{
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> distribution(0.f, 1.f);
+
+    const std::size_t nbNodes = std::size_t(gridSize) * gridSize * gridSize;
+    const float center = 0.5f * gridSize;
+    const float radius = 0.35f * gridSize;
+    graph = MaxFlowGraph(nbNodes);
+    for(int z = 0; z < gridSize; ++z)
+    {
+        for(int y = 0; y < gridSize; ++y)
+        {
+            for(int x = 0; x < gridSize; ++x)
+            {
+                const std::size_t n = (std::size_t(z) * gridSize + y) * gridSize + x;
+                const float dx = x - center;
+                const float dy = y - center;
+                const float dz = z - center;
+                const bool inside = (dx * dx + dy * dy + dz * dz < radius * radius);
+                const float source = distribution(generator) * (inside ? 1.f : 3.f);
+                const float sink = distribution(generator) * (inside ? 3.f : 1.f);
+                graph.addNode(n, source, sink);
+            }
+        }
+    }
+    for(int z = 0; z < gridSize; ++z)
+    {
+        for(int y = 0; y < gridSize; ++y)
+        {
+            for(int x = 0; x < gridSize; ++x)
+            {
+                const std::size_t n = (std::size_t(z) * gridSize + y) * gridSize + x;
+                const std::size_t neighbors[3] = {n + 1, n + gridSize, n + std::size_t(gridSize) * gridSize};
+                const bool hasNeighbor[3] = {x + 1 < gridSize, y + 1 < gridSize, z + 1 < gridSize};
+                for(int i = 0; i < 3; ++i)
+                {
+                    if(!hasNeighbor[i])
+                        continue;
+                    const float w1 = 2.f * distribution(generator);
+                    const float w2 = 2.f * distribution(generator);
+                    // like DelaunayGraphCut, the edge is added from both cells
+                    graph.addEdge(n, neighbors[i], w1, w2);
+                    graph.addEdge(neighbors[i], n, w2, w1);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Compute the maxflow of the graph with a solver
+ * @param[out] isTarget the target (full) status of each node
+ */
+template <typename MaxFlow>
+void runBenchmark(EMaxFlowSolver solver, const MaxFlowGraph& graph, std::vector<bool>& isTarget)
+{
+    system::Timer timer;
+    MaxFlow maxFlow(graph.getNbNodes());
+    graph.fill(maxFlow);
+    const double buildTime = timer.elapsed();
+
+    timer.reset();
+    const float flow = maxFlow.compute();
+    const double computeTime = timer.elapsed();
+
+    isTarget.resize(graph.getNbNodes());
+    std::size_t nbTargets = 0;
+    for(std::size_t n = 0; n < graph.getNbNodes(); ++n)
+    {
+        isTarget[n] = maxFlow.isTarget(n);
+        nbTargets += isTarget[n];
+    }
+
+    std::cout << std::left << std::setw(24) << EMaxFlowSolver_enumToString(solver)
+              << std::right << std::fixed << std::setprecision(3)
+              << "build: " << std::setw(10) << buildTime << " s"
+              << "   compute: " << std::setw(10) << computeTime << " s"
+              << "   flow: " << std::setprecision(1) << flow
+              << "   full nodes: " << nbTargets << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> inputGraphs;
+    std::vector<std::string> solvers = {EMaxFlowSolver_enumToString(EMaxFlowSolver::BOYKOV_KOLMOGOROV),
+                                        EMaxFlowSolver_enumToString(EMaxFlowSolver::PUSH_RELABEL)};
+    int gridSize = 100;
+    std::string verboseLevel = system::EVerboseLevel_enumToString(system::EVerboseLevel::Warning);
+
+    po::options_description allParams("Benchmark of the maxflow solvers of the meshing.\n"
+                                      "The graphs are saved by the meshing with the setting 'delaunaycut.saveMaxflowGraph' of the mvs.ini file.");
+    allParams.add_options()
+        ("help,h", "Show this help.")
+        ("input,i", po::value<std::vector<std::string>>(&inputGraphs)->multitoken(),
+            "Maxflow graph files. If empty, a random 3D grid graph is used.")
+        ("solvers", po::value<std::vector<std::string>>(&solvers)->multitoken(),
+            "Maxflow solvers: boykov_kolmogorov, push_relabel. The cut of each solver is compared to the first one.")
+        ("gridSize", po::value<int>(&gridSize)->default_value(gridSize),
+            "Size of the random 3D grid graph.")
+        ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+            "verbosity level (fatal, error, warning, info, debug, trace).");
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, allParams), vm);
+        if(vm.count("help"))
+        {
+            ALICEVISION_COUT(allParams);
+            return EXIT_SUCCESS;
+        }
+        po::notify(vm);
+    }
+    catch(boost::program_options::error& e)
+    {
+        ALICEVISION_CERR("ERROR: " << e.what());
+        ALICEVISION_COUT("Usage:\n\n" << allParams);
+        return EXIT_FAILURE;
+    }
+
+    system::Logger::get()->setLogLevel(verboseLevel);
+
+    if(inputGraphs.empty())
+        inputGraphs.push_back("");
+
+    for(const std::string& inputGraph : inputGraphs)
+    {
+        MaxFlowGraph graph;
+        if(inputGraph.empty())
+        {
+            generateGridGraph(gridSize, graph);
+            std::cout << std::endl << "Random 3D grid graph (" << gridSize << "^3)";
+        }
+        else
+        {
+            graph.load(inputGraph);
+            std::cout << std::endl << inputGraph;
+        }
+        std::cout << ": " << graph.getNbNodes() << " nodes, " << graph.getNbEdges() << " edges" << std::endl;
+
+        std::vector<bool> referenceIsTarget;
+        for(const std::string& solverName : solvers)
+        {
+            const EMaxFlowSolver solver = EMaxFlowSolver_stringToEnum(solverName);
+            std::vector<bool> isTarget;
+            switch(solver)
+            {
+                case EMaxFlowSolver::BOYKOV_KOLMOGOROV: runBenchmark<MaxFlow_AdjList>(solver, graph, isTarget); break;
+                case EMaxFlowSolver::PUSH_RELABEL:      runBenchmark<MaxFlow_PushRelabel>(solver, graph, isTarget); break;
+            }
+
+            if(referenceIsTarget.empty())
+            {
+                referenceIsTarget.swap(isTarget);
+                continue;
+            }
+            std::size_t nbDifferences = 0;
+            for(std::size_t n = 0; n < isTarget.size(); ++n)
+                nbDifferences += (isTarget[n] != referenceIsTarget[n]);
+            std::cout << "    nodes with a different status than " << solvers.front() << ": " << nbDifferences << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
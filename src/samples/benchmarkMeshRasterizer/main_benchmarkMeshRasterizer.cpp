@@ -0,0 +1,161 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/meshRasterizer.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace po = boost::program_options;
+namespace bfs = boost::filesystem;
+
+void printResult(const std::string& name, double time, int nbCoveredPixels, int nbVisibleTris)
+{
+    std::cout << "    " << std::left << std::setw(20) << name
+              << std::right << std::fixed << std::setprecision(3)
+              << "time: " << std::setw(10) << time << " s"
+              << "   covered pixels: " << std::setw(10) << nbCoveredPixels
+              << "   visible triangles: " << nbVisibleTris << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::string iniFilepath;
+    std::string meshFilepath;
+    std::vector<int> cams;
+    int scale = 2;
+    int nbThreads = 0;
+    std::string verboseLevel = system::EVerboseLevel_enumToString(system::EVerboseLevel::Warning);
+
+    po::options_description allParams("Benchmark of the mesh rendering in the cameras with the tiled z-buffer rasterizer (rasterizeMesh):\n"
+                                      "single thread against the available threads.");
+    allParams.add_options()
+        ("help,h", "Show this help.")
+        ("ini", po::value<std::string>(&iniFilepath)->required(),
+            "Configuration file (mvs.ini).")
+        ("mesh", po::value<std::string>(&meshFilepath)->required(),
+            "Mesh file (.obj or .bin).")
+        ("cams", po::value<std::vector<int>>(&cams)->multitoken(),
+            "Indexes of the cameras. If empty, the first camera is used.")
+        ("scale", po::value<int>(&scale)->default_value(scale),
+            "Downscale factor of the rendering.")
+        ("nbThreads", po::value<int>(&nbThreads)->default_value(nbThreads),
+            "Number of threads of the parallel rendering (0 for all the available threads).")
+        ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+            "verbosity level (fatal, error, warning, info, debug, trace).");
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, allParams), vm);
+        if(vm.count("help"))
+        {
+            ALICEVISION_COUT(allParams);
+            return EXIT_SUCCESS;
+        }
+        po::notify(vm);
+
+        if(scale <= 0)
+            throw po::error("the downscale factor must be positive");
+    }
+    catch(boost::program_options::error& e)
+    {
+        ALICEVISION_CERR("ERROR: " << e.what());
+        ALICEVISION_COUT("Usage:\n\n" << allParams);
+        return EXIT_FAILURE;
+    }
+
+    system::Logger::get()->setLogLevel(verboseLevel);
+
+    if(nbThreads > 0)
+        omp_set_num_threads(nbThreads);
+
+    mvsUtils::MultiViewParams mp(iniFilepath);
+
+    Mesh mesh;
+    bool loaded = false;
+    if(boost::algorithm::to_lower_copy(bfs::path(meshFilepath).extension().string()) == ".bin")
+    {
+        loaded = mesh.loadFromBin(meshFilepath);
+    }
+    else
+    {
+        int nmtls = 0;
+        StaticVector<int> trisMtlIds;
+        StaticVector<Point3d> normals;
+        StaticVector<Voxel> trisNormalsIds;
+        StaticVector<Point2d> uvCoords;
+        StaticVector<Voxel> trisUvIds;
+        loaded = mesh.loadFromObjAscii(nmtls, trisMtlIds, normals, trisNormalsIds, uvCoords, trisUvIds, meshFilepath);
+    }
+    if(!loaded)
+    {
+        ALICEVISION_LOG_ERROR("Unable to load the mesh: " << meshFilepath);
+        return EXIT_FAILURE;
+    }
+
+    if(cams.empty())
+        cams.push_back(0);
+
+    std::cout << "Mesh: " << mesh.pts->size() << " points, " << mesh.tris->size() << " triangles, "
+              << omp_get_max_threads() << " thread(s)" << std::endl;
+
+    for(int rc : cams)
+    {
+        if(rc < 0 || rc >= mp.ncams)
+        {
+            ALICEVISION_LOG_ERROR("Invalid camera index: " << rc);
+            return EXIT_FAILURE;
+        }
+
+        const int w = mp.getWidth(rc) / scale;
+        const int h = mp.getHeight(rc) / scale;
+        std::cout << std::endl << "Camera " << rc << " (view " << mp.getViewId(rc) << "): " << w << "x" << h << std::endl;
+
+        const int nbParallelThreads = omp_get_max_threads();
+        double singleThreadTime = 0.0;
+        for(const int threads : {1, nbParallelThreads})
+        {
+            omp_set_num_threads(threads);
+            system::Timer timer;
+            MeshRendering rendering;
+            rasterizeMesh(mesh, mp, rc, w, h, rendering);
+            const double time = timer.elapsed();
+
+            int nbCoveredPixels = 0;
+            for(int i = 0; i < rendering.trisMap.size(); ++i)
+                nbCoveredPixels += (rendering.trisMap[i] >= 0);
+            int nbVisibleTris = 0;
+            for(int i = 0; i < rendering.visibility.size(); ++i)
+                nbVisibleTris += (rendering.visibility[i] != 0);
+            printResult(std::to_string(threads) + " thread(s)", time, nbCoveredPixels, nbVisibleTris);
+
+            if(threads == 1)
+                singleThreadTime = time;
+            else
+                std::cout << "    speedup: " << std::setprecision(1) << singleThreadTime / std::max(time, 1e-9) << "x" << std::endl;
+        }
+        omp_set_num_threads(nbParallelThreads);
+    }
+
+    return EXIT_SUCCESS;
+}
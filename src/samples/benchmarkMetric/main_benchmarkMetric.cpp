@@ -0,0 +1,142 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/matching/metric.hpp>
+#include <aliceVision/matching/metricSimd.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::matching;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Compute the distances between all the query and database descriptors
+ * @return the sum of the distances (to check the results and avoid dead code elimination)
+ */
+template<typename T, typename DistanceFunctor>
+double runBenchmark(const std::string& name, const std::vector<T>& queries, const std::vector<T>& database,
+                    std::size_t dimension, int nbIterations, const DistanceFunctor& distance)
+{
+  const std::size_t nbQueries = queries.size() / dimension;
+  const std::size_t nbDatabase = database.size() / dimension;
+
+  double sum = 0.0;
+  system::Timer timer;
+  for(int it = 0; it < nbIterations; ++it)
+  {
+    for(std::size_t i = 0; i < nbQueries; ++i)
+      for(std::size_t j = 0; j < nbDatabase; ++j)
+        sum += distance(&queries[i * dimension], &database[j * dimension], dimension);
+  }
+  const double elapsed = timer.elapsed();
+  const double nbDistances = double(nbIterations) * nbQueries * nbDatabase;
+
+  std::cout << std::left << std::setw(32) << name
+            << std::right << std::setw(12) << std::fixed << std::setprecision(3) << elapsed * 1000.0 << " ms"
+            << std::setw(12) << std::setprecision(1) << nbDistances / elapsed / 1e6 << " Mdist/s"
+            << "   (checksum: " << std::setprecision(0) << sum << ")" << std::endl;
+  return sum;
+}
+
+template<typename T, typename Generator, typename Distribution>
+std::vector<T> randomDescriptors(std::size_t nbDescriptors, std::size_t dimension, Generator& generator, Distribution& distribution)
+{
+  std::vector<T> descriptors(nbDescriptors * dimension);
+  for(T& value : descriptors)
+    value = static_cast<T>(distribution(generator));
+  return descriptors;
+}
+
+int main(int argc, char** argv)
+{
+  int nbQueries = 256;
+  int nbDatabase = 4096;
+  int nbIterations = 4;
+
+  po::options_description allParams("Benchmark of the descriptor distance kernels (scalar, AVX2, AVX-512)");
+  allParams.add_options()
+    ("help,h", "Show this help.")
+    ("nbQueries", po::value<int>(&nbQueries)->default_value(nbQueries),
+      "Number of query descriptors.")
+    ("nbDatabase", po::value<int>(&nbDatabase)->default_value(nbDatabase),
+      "Number of database descriptors.")
+    ("nbIterations", po::value<int>(&nbIterations)->default_value(nbIterations),
+      "Number of iterations.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> floatDistribution(0.f, 1.f);
+  std::uniform_int_distribution<int> ucharDistribution(0, 255);
+
+  // SIFT float and uchar descriptors, AKAZE binary descriptors (61 bytes)
+  const std::size_t siftDimension = 128;
+  const std::size_t binaryDimension = 61;
+
+  const std::vector<float> floatQueries = randomDescriptors<float>(nbQueries, siftDimension, generator, floatDistribution);
+  const std::vector<float> floatDatabase = randomDescriptors<float>(nbDatabase, siftDimension, generator, floatDistribution);
+  const std::vector<unsigned char> ucharQueries = randomDescriptors<unsigned char>(nbQueries, siftDimension, generator, ucharDistribution);
+  const std::vector<unsigned char> ucharDatabase = randomDescriptors<unsigned char>(nbDatabase, siftDimension, generator, ucharDistribution);
+  const std::vector<unsigned char> binaryQueries = randomDescriptors<unsigned char>(nbQueries, binaryDimension, generator, ucharDistribution);
+  const std::vector<unsigned char> binaryDatabase = randomDescriptors<unsigned char>(nbDatabase, binaryDimension, generator, ucharDistribution);
+
+  std::cout << "Best instruction set: " << simd::EInstructionSet_enumToString(simd::getBestInstructionSet()) << std::endl;
+
+  std::cout << std::endl << "L2 float (" << siftDimension << ")" << std::endl;
+  runBenchmark("L2_Simple<float>", floatQueries, floatDatabase, siftDimension, nbIterations, L2_Simple<float>());
+  for(simd::EInstructionSet instructionSet : {simd::EInstructionSet::SCALAR, simd::EInstructionSet::AVX2, simd::EInstructionSet::AVX512})
+  {
+    const simd::DistanceKernels* kernels = simd::getKernels(instructionSet);
+    if(kernels != nullptr)
+      runBenchmark(simd::EInstructionSet_enumToString(instructionSet), floatQueries, floatDatabase, siftDimension, nbIterations, kernels->l2Float);
+  }
+
+  std::cout << std::endl << "L2 uchar (" << siftDimension << ")" << std::endl;
+  runBenchmark("L2_Simple<unsigned char>", ucharQueries, ucharDatabase, siftDimension, nbIterations, L2_Simple<unsigned char>());
+  for(simd::EInstructionSet instructionSet : {simd::EInstructionSet::SCALAR, simd::EInstructionSet::AVX2, simd::EInstructionSet::AVX512})
+  {
+    const simd::DistanceKernels* kernels = simd::getKernels(instructionSet);
+    if(kernels != nullptr)
+      runBenchmark(simd::EInstructionSet_enumToString(instructionSet), ucharQueries, ucharDatabase, siftDimension, nbIterations, kernels->l2Uchar);
+  }
+
+  std::cout << std::endl << "Hamming (" << binaryDimension << " bytes)" << std::endl;
+  for(simd::EInstructionSet instructionSet : {simd::EInstructionSet::SCALAR, simd::EInstructionSet::AVX2, simd::EInstructionSet::AVX512})
+  {
+    const simd::DistanceKernels* kernels = simd::getKernels(instructionSet);
+    if(kernels != nullptr)
+      runBenchmark(simd::EInstructionSet_enumToString(instructionSet), binaryQueries, binaryDatabase, binaryDimension, nbIterations, kernels->hamming);
+  }
+
+  return EXIT_SUCCESS;
+}
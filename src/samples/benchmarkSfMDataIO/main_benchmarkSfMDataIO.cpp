@@ -0,0 +1,282 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/sfm/sfmDataIO.hpp>
+#include <aliceVision/sfm/sfmDataIO_json.hpp>
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Peak resident memory of the process in MB (0 if not available)
+ */
+double getPeakMemoryMB()
+{
+#ifndef _WIN32
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) == 0)
+    return usage.ru_maxrss / 1024.0; // KB on Linux
+#endif
+  return 0.0;
+}
+
+/**
+ * @brief Generate a random scene with tracks of consecutive views.
+ */
+void generateScene(int nbViews, int nbLandmarks, int nbObservations, SfMData& sfmData)
+{
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+  sfmData.intrinsics[0] = std::make_shared<camera::PinholeRadialK3>(4000, 3000, 3200.0, 2000.0, 1500.0, 0.01, -0.02, 0.003);
+
+  for(int i = 0; i < nbViews; ++i)
+  {
+    std::shared_ptr<View> view = std::make_shared<View>("dataset/IMG_" + std::to_string(i) + ".jpg", i, 0, i, 4000, 3000);
+    view->addMetadata("Make", "Camera");
+    view->addMetadata("Exif:FocalLength", "35");
+    sfmData.views[i] = view;
+    sfmData.setPose(*view, geometry::Pose3(RotationAroundY(distribution(generator)), Vec3(distribution(generator), distribution(generator), distribution(generator))));
+  }
+
+  for(int i = 0; i < nbLandmarks; ++i)
+  {
+    Landmark& landmark = sfmData.structure[i];
+    landmark.X = Vec3(distribution(generator), distribution(generator), distribution(generator));
+    landmark.descType = feature::EImageDescriberType::SIFT;
+    landmark.rgb = image::RGBColor(i % 256, (i / 256) % 256, 128);
+
+    const int firstView = i % nbViews;
+    for(int o = 0; o < nbObservations && o < nbViews; ++o)
+      landmark.observations[(firstView + o) % nbViews] = Observation(Vec2(2000.0 * (1.0 + distribution(generator)), 1500.0 * (1.0 + distribution(generator))), i);
+  }
+}
+
+/**
+ * @brief Save an SfMData as the previous implementation, with a boost property tree.
+ */
+void savePropertyTree(const SfMData& sfmData, const std::string& filename)
+{
+  bpt::ptree fileTree;
+  saveMatrix("version", Vec3(1, 0, 0), fileTree);
+
+  bpt::ptree viewsTree, intrinsicsTree, posesTree, structureTree;
+
+  for(const auto& viewPair : sfmData.GetViews())
+    saveView("", *viewPair.second, viewsTree);
+  fileTree.add_child("views", viewsTree);
+
+  for(const auto& intrinsicPair : sfmData.GetIntrinsics())
+    saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
+  fileTree.add_child("intrinsics", intrinsicsTree);
+
+  for(const auto& posePair : sfmData.GetPoses())
+  {
+    bpt::ptree poseTree;
+    poseTree.put("poseId", posePair.first);
+    savePose3("pose", posePair.second, poseTree);
+    posesTree.push_back(std::make_pair("", poseTree));
+  }
+  fileTree.add_child("poses", posesTree);
+
+  for(const auto& landmarkPair : sfmData.GetLandmarks())
+    saveLandmark("", landmarkPair.first, landmarkPair.second, structureTree);
+  fileTree.add_child("structure", structureTree);
+
+  bpt::write_json(filename, fileTree);
+}
+
+/**
+ * @brief Load an SfMData as the previous implementation, with a boost property tree.
+ */
+void loadPropertyTree(SfMData& sfmData, const std::string& filename)
+{
+  bpt::ptree fileTree;
+  bpt::read_json(filename, fileTree);
+
+  if(fileTree.count("views"))
+  {
+    for(bpt::ptree::value_type& viewNode : fileTree.get_child("views"))
+    {
+      View view;
+      loadView(view, viewNode.second);
+      sfmData.views.emplace(view.getViewId(), std::make_shared<View>(view));
+    }
+  }
+
+  if(fileTree.count("intrinsics"))
+  {
+    for(bpt::ptree::value_type& intrinsicNode : fileTree.get_child("intrinsics"))
+    {
+      IndexT intrinsicId;
+      std::shared_ptr<camera::IntrinsicBase> intrinsic;
+      loadIntrinsic(intrinsicId, intrinsic, intrinsicNode.second);
+      sfmData.intrinsics.emplace(intrinsicId, intrinsic);
+    }
+  }
+
+  if(fileTree.count("poses"))
+  {
+    for(bpt::ptree::value_type& poseNode : fileTree.get_child("poses"))
+    {
+      geometry::Pose3 pose;
+      loadPose3("pose", pose, poseNode.second);
+      sfmData.GetPoses().emplace(poseNode.second.get<IndexT>("poseId"), pose);
+    }
+  }
+
+  if(fileTree.count("structure"))
+  {
+    for(bpt::ptree::value_type& landmarkNode : fileTree.get_child("structure"))
+    {
+      IndexT landmarkId;
+      Landmark landmark;
+      loadLandmark(landmarkId, landmark, landmarkNode.second);
+      sfmData.structure.emplace(landmarkId, landmark);
+    }
+  }
+}
+
+void printResult(const std::string& name, double time)
+{
+  std::cout << std::left << std::setw(32) << name
+            << std::right << std::fixed << std::setprecision(3)
+            << "time: " << std::setw(10) << time << " s"
+            << "   peak memory: " << std::setw(10) << std::setprecision(1) << getPeakMemoryMB() << " MB" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::string inputFilename;
+  std::string outputFilename;
+  std::string reader = "stream";
+  int nbViews = 10000;
+  int nbLandmarks = 1000000;
+  int nbObservations = 5;
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::EVerboseLevel::Warning);
+
+  po::options_description allParams("Benchmark of the SfMData JSON serialization.\n"
+                                    "The peak memory is the one of the process: run the loading once per reader to compare them.\n"
+                                    "Generate a scene: --output scene.sfm\n"
+                                    "Load a scene:     --input scene.sfm --reader stream|ptree");
+  allParams.add_options()
+    ("help,h", "Show this help.")
+    ("input,i", po::value<std::string>(&inputFilename),
+      "SfMData file to load.")
+    ("output,o", po::value<std::string>(&outputFilename),
+      "SfMData file to generate (.sfm, .json or .sfmbin). For a JSON file, it is also written with a property tree.")
+    ("reader", po::value<std::string>(&reader)->default_value(reader),
+      "Reader used to load the input file: stream (sfmDataIO), ptree (boost property tree, JSON only).")
+    ("nbViews", po::value<int>(&nbViews)->default_value(nbViews),
+      "Number of views of the generated scene.")
+    ("nbLandmarks", po::value<int>(&nbLandmarks)->default_value(nbLandmarks),
+      "Number of landmarks of the generated scene.")
+    ("nbObservations", po::value<int>(&nbObservations)->default_value(nbObservations),
+      "Number of observations per landmark of the generated scene.")
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+
+    if(inputFilename.empty() && outputFilename.empty())
+      throw po::error("an input or an output file is required");
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(!outputFilename.empty())
+  {
+    SfMData sfmData;
+    generateScene(nbViews, nbLandmarks, nbObservations, sfmData);
+    std::cout << "Generated scene: " << nbViews << " views, " << nbLandmarks << " landmarks, "
+              << nbObservations << " observations per landmark" << std::endl;
+    printResult("generation", 0.0);
+
+    system::Timer timer;
+    if(!Save(sfmData, outputFilename, ESfMData(ALL)))
+    {
+      ALICEVISION_LOG_ERROR("Cannot save the SfMData file: " << outputFilename);
+      return EXIT_FAILURE;
+    }
+    printResult("save (sfmDataIO)", timer.elapsed());
+
+    if(boost::filesystem::extension(outputFilename) != ".sfmbin")
+    {
+      timer.reset();
+      savePropertyTree(sfmData, outputFilename + ".ptree.json");
+      printResult("save (property tree)", timer.elapsed());
+    }
+  }
+
+  if(!inputFilename.empty())
+  {
+    SfMData sfmData;
+    system::Timer timer;
+
+    if(reader == "stream")
+    {
+      if(!Load(sfmData, inputFilename, ESfMData(ALL)))
+      {
+        ALICEVISION_LOG_ERROR("Cannot load the SfMData file: " << inputFilename);
+        return EXIT_FAILURE;
+      }
+    }
+    else if(reader == "ptree")
+    {
+      loadPropertyTree(sfmData, inputFilename);
+    }
+    else
+    {
+      ALICEVISION_LOG_ERROR("Unknown reader: " << reader);
+      return EXIT_FAILURE;
+    }
+
+    std::size_t nbObservationsLoaded = 0;
+    for(const auto& landmarkPair : sfmData.GetLandmarks())
+      nbObservationsLoaded += landmarkPair.second.observations.size();
+
+    printResult("load (" + reader + ")", timer.elapsed());
+    std::cout << "Loaded scene: " << sfmData.GetViews().size() << " views, " << sfmData.GetLandmarks().size() << " landmarks, "
+              << nbObservationsLoaded << " observations" << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
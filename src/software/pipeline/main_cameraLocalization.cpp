@@ -370,8 +370,10 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
   
-  // create the feedProvider
-  dataio::FeedProvider feed(mediaFilepath, calibFile);
+  // create the feedProvider, the next frames are decoded in grayscale during the localization
+  dataio::PrefetchOptions prefetchOptions;
+  prefetchOptions.grayscale = true;
+  dataio::FeedProvider feed(mediaFilepath, calibFile, prefetchOptions);
   if(!feed.isInit())
   {
     ALICEVISION_CERR("ERROR while initializing the FeedProvider!");
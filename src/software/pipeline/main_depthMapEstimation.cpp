@@ -53,6 +53,9 @@ int main(int argc, char* argv[])
     double refineGammaP = 8.0;
     bool refineUseTcOrRcPixSize = false;
 
+    // use the CUDA plane sweeping if a compatible device is available
+    bool useCUDA = true;
+
     po::options_description allParams("AliceVision depthMapEstimation\n"
                                       "Estimate depth map for each input image");
 
@@ -96,7 +99,9 @@ int main(int argc, char* argv[])
         ("refineGammaP", po::value<double>(&refineGammaP)->default_value(refineGammaP),
             "Refine: GammaP threshold.")
         ("refineUseTcOrRcPixSize", po::value<bool>(&refineUseTcOrRcPixSize)->default_value(refineUseTcOrRcPixSize),
-            "Refine: Use current camera pixel size or minimum pixel size of neighbour cameras.");
+            "Refine: Use current camera pixel size or minimum pixel size of neighbour cameras.")
+        ("useCUDA", po::value<bool>(&useCUDA)->default_value(useCUDA),
+            "Use the CUDA plane sweeping if a CUDA-Enabled GPU is available, otherwise the CPU implementation is used.");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -142,10 +147,10 @@ int main(int argc, char* argv[])
     ALICEVISION_LOG_INFO(system::gpuInformationCUDA());
 
     // check if the gpu suppport CUDA compute capability 2.0
-    if(!system::gpuSupportCUDA(2,0))
+    if(useCUDA && !system::gpuSupportCUDA(2,0))
     {
-      ALICEVISION_LOG_ERROR("This program needs a CUDA-Enabled GPU (with at least compute capablility 2.0).");
-      return EXIT_FAILURE;
+      ALICEVISION_LOG_WARNING("No CUDA-Enabled GPU (with at least compute capablility 2.0), use the CPU implementation.");
+      useCUDA = false;
     }
 
     // check if the scale is correct
@@ -160,6 +165,8 @@ int main(int argc, char* argv[])
 
     // set params in bpt
 
+    mp._ini.put("global.useCUDA", useCUDA);
+
     // semiGlobalMatching
     mp._ini.put("semiGlobalMatching.maxTCams", sgmMaxTCams);
     mp._ini.put("semiGlobalMatching.wsh", sgmWSH);
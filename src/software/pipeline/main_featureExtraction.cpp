@@ -11,6 +11,7 @@
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/feature.hpp>
+#include <aliceVision/feature/RegionsContainer.hpp>
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_POPSIFT) \
  || ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
 #define ALICEVISION_HAVE_GPU_FEATURES
@@ -32,6 +33,12 @@
 #include <functional>
 #include <memory>
 #include <limits>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 using namespace aliceVision;
 
@@ -117,6 +124,15 @@ public:
     _outputFolder = folder;
   }
 
+  /**
+   * @brief Also export the extracted regions in a binary regions container file
+   * @param[in] filepath the regions container file path (*.regions)
+   */
+  void setRegionsContainer(const std::string& filepath)
+  {
+    _regionsContainer.reset(new feature::RegionsContainerWriter(filepath));
+  }
+
   void addImageDescriber(std::shared_ptr<feature::ImageDescriber>& imageDescriber)
   {
     _imageDescribers.push_back(imageDescriber);
@@ -163,31 +179,27 @@ public:
       if(jobMaxMemoryConsuption == 0)
         throw std::runtime_error("Can't compute feature extraction job max memory consuption.");
 
-      std::size_t nbThreads =  (0.9 * memoryInformation.freeRam) / jobMaxMemoryConsuption;
+      std::size_t memoryBudget = 0.9 * memoryInformation.freeRam;
 
       if(memoryInformation.freeRam == 0)
       {
         ALICEVISION_LOG_WARNING("Can't find available system memory, this can be due to OS limitations.\n"
-                                "Use only one thread for CPU feature extraction.");
-        nbThreads = 1;
+                                "Run only one CPU feature extraction job at a time.");
       }
 
-      // nbThreads should not be higher than user maxThreads param
-      if(_maxThreads > 0)
-        nbThreads = std::min(static_cast<std::size_t>(_maxThreads), nbThreads);
+      std::size_t nbWorkers = omp_get_num_procs();
 
-      // nbThreads should not be higher than the core number
-      nbThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), nbThreads);
+      // nbWorkers should not be higher than user maxThreads param
+      if(_maxThreads > 0)
+        nbWorkers = std::min(static_cast<std::size_t>(_maxThreads), nbWorkers);
 
-      // nbThreads should not be higher than the job number
-      nbThreads = std::min(_cpuJobs.size(), nbThreads);
+      // nbWorkers should not be higher than the job number
+      nbWorkers = std::min(_cpuJobs.size(), nbWorkers);
 
-      ALICEVISION_LOG_DEBUG("# threads for extraction: " << nbThreads);
-      omp_set_nested(1);
+      ALICEVISION_LOG_DEBUG("# threads for extraction: " << nbWorkers);
+      ALICEVISION_LOG_DEBUG("Memory budget for extraction: " << memoryBudget << " B");
 
-#pragma omp parallel for num_threads(nbThreads)
-      for(int i = 0; i < _cpuJobs.size(); ++i)
-        computeViewJob(_cpuJobs.at(i));
+      processCpuJobs(memoryBudget, nbWorkers);
     }
 
     if(!_gpuJobs.empty())
@@ -195,16 +207,226 @@ public:
       for(const auto& job : _gpuJobs)
         computeViewJob(job, true);
     }
+
+    if(_regionsContainer)
+      _regionsContainer->close();
+
+    ALICEVISION_LOG_INFO("Feature extraction stages (cumulated time of all the threads):" << std::endl
+                         << "\t- read image: " << _stageTimings.read << " s" << std::endl
+                         << "\t- describe:   " << _stageTimings.describe << " s" << std::endl
+                         << "\t- write:      " << _stageTimings.write << " s" << std::endl
+                         << "\t- peak estimated memory of the CPU jobs: " << (_peakJobsMemory / (1024 * 1024)) << " MB" << std::endl
+                         << "\t- peak memory of the process: " << (system::getPeakMemoryUsage() / (1024 * 1024)) << " MB");
   }
 
 private:
 
+  /// regions extracted from a view, waiting to be written
+  struct ViewRegions
+  {
+    const ViewJob* job = nullptr;
+    std::vector<std::pair<std::size_t, std::unique_ptr<feature::Regions>>> regionsPerDescriber;
+  };
+
+  /// cumulated time of each extraction stage, in seconds
+  struct StageTimings
+  {
+    double read = 0.0;
+    double describe = 0.0;
+    double write = 0.0;
+  };
+
+  /**
+   * @brief Run the CPU jobs in parallel under a global memory budget.
+   *
+   * The idle workers take the biggest pending job that fits in the remaining budget,
+   * so the small images fill the memory left by the big ones. A job bigger than the budget runs alone.
+   * The OpenMP threads of the image describers are shared between the running jobs,
+   * and the regions are written by a dedicated thread while the workers read and describe the next images.
+   * @param[in] memoryBudget the memory available for the running jobs
+   * @param[in] nbWorkers the maximum number of concurrent jobs
+   */
+  void processCpuJobs(std::size_t memoryBudget, std::size_t nbWorkers)
+  {
+    _pendingJobs.clear();
+    for(const ViewJob& job : _cpuJobs)
+      _pendingJobs.push_back(&job);
+
+    // biggest jobs first
+    std::stable_sort(_pendingJobs.begin(), _pendingJobs.end(), [](const ViewJob* a, const ViewJob* b) {
+      return a->memoryConsuption > b->memoryConsuption;
+    });
+
+    _memoryBudget = memoryBudget;
+    _maxPendingWrites = nbWorkers;
+    _nbRunningWorkers = nbWorkers;
+
+    std::thread writer(&FeatureExtractor::cpuWriter, this);
+    std::vector<std::thread> workers;
+    for(std::size_t i = 0; i < nbWorkers; ++i)
+      workers.emplace_back(&FeatureExtractor::cpuWorker, this);
+
+    for(std::thread& worker : workers)
+      worker.join();
+    writer.join();
+
+    if(_error)
+      std::rethrow_exception(_error);
+  }
+
+  void cpuWorker()
+  {
+    try
+    {
+      while(const ViewJob* job = admitJob())
+      {
+        std::unique_ptr<ViewRegions> viewRegions(new ViewRegions);
+        viewRegions->job = job;
+
+        try
+        {
+          describeView(*job, false, *viewRegions);
+        }
+        catch(...)
+        {
+          endJob(*job);
+          throw;
+        }
+        endJob(*job);
+
+        pushRegions(std::move(viewRegions));
+      }
+    }
+    catch(...)
+    {
+      setError(std::current_exception());
+    }
+
+    std::lock_guard<std::mutex> lock(_schedulerMutex);
+    --_nbRunningWorkers;
+    _writeCondition.notify_all();
+  }
+
+  void cpuWriter()
+  {
+    for(;;)
+    {
+      std::unique_ptr<ViewRegions> viewRegions;
+      {
+        std::unique_lock<std::mutex> lock(_schedulerMutex);
+        _writeCondition.wait(lock, [this]() { return !_pendingWrites.empty() || _nbRunningWorkers == 0; });
+        if(_pendingWrites.empty())
+          return;
+        viewRegions = std::move(_pendingWrites.front());
+        _pendingWrites.pop_front();
+        _writeCondition.notify_all();
+      }
+
+      try
+      {
+        writeRegions(*viewRegions);
+      }
+      catch(...)
+      {
+        setError(std::current_exception());
+      }
+    }
+  }
+
+  /**
+   * @brief Wait for a pending job that fits in the memory budget
+   * @return the job, or nullptr if there is no more job to run
+   */
+  const ViewJob* admitJob()
+  {
+    std::unique_lock<std::mutex> lock(_schedulerMutex);
+    for(;;)
+    {
+      if(_pendingJobs.empty())
+        return nullptr;
+
+      auto it = std::find_if(_pendingJobs.begin(), _pendingJobs.end(), [this](const ViewJob* job) {
+        return _jobsMemory + job->memoryConsuption <= _memoryBudget;
+      });
+
+      if(it == _pendingJobs.end() && _nbRunningJobs == 0)
+        it = _pendingJobs.begin();
+
+      if(it != _pendingJobs.end())
+      {
+        const ViewJob* job = *it;
+        _pendingJobs.erase(it);
+        _jobsMemory += job->memoryConsuption;
+        _peakJobsMemory = std::max(_peakJobsMemory, _jobsMemory);
+        ++_nbRunningJobs;
+        return job;
+      }
+      _jobCondition.wait(lock);
+    }
+  }
+
+  void endJob(const ViewJob& job)
+  {
+    std::lock_guard<std::mutex> lock(_schedulerMutex);
+    _jobsMemory -= job.memoryConsuption;
+    --_nbRunningJobs;
+    _jobCondition.notify_all();
+  }
+
+  /// Give the regions to the writer thread, wait if too many regions are not written yet
+  void pushRegions(std::unique_ptr<ViewRegions> viewRegions)
+  {
+    std::unique_lock<std::mutex> lock(_schedulerMutex);
+    _writeCondition.wait(lock, [this]() { return _pendingWrites.size() < _maxPendingWrites; });
+    _pendingWrites.push_back(std::move(viewRegions));
+    _writeCondition.notify_all();
+  }
+
+  /// Keep the first error and cancel the pending jobs
+  void setError(std::exception_ptr error)
+  {
+    std::lock_guard<std::mutex> lock(_schedulerMutex);
+    if(!_error)
+      _error = error;
+    _pendingJobs.clear();
+    _jobCondition.notify_all();
+  }
+
+  void addStageTime(double StageTimings::* stage, double time)
+  {
+    std::lock_guard<std::mutex> lock(_schedulerMutex);
+    _stageTimings.*stage += time;
+  }
+
   void computeViewJob(const ViewJob& job, bool useGPU = false)
+  {
+    ViewRegions viewRegions;
+    viewRegions.job = &job;
+    describeView(job, useGPU, viewRegions);
+    writeRegions(viewRegions);
+  }
+
+  void describeView(const ViewJob& job, bool useGPU, ViewRegions& viewRegions)
   {
     image::Image<float> imageGrayFloat;
     image::Image<unsigned char> imageGrayUChar;
 
+    system::Timer timer;
     image::readImage(job.view.getImagePath(), imageGrayFloat);
+    addStageTime(&StageTimings::read, timer.elapsed());
+
+    if(!useGPU)
+    {
+      // share the cores between the running jobs, a single big image uses all of them
+      std::size_t nbRunningJobs;
+      {
+        std::lock_guard<std::mutex> lock(_schedulerMutex);
+        nbRunningJobs = std::max(_nbRunningJobs, std::size_t(1));
+      }
+      // the threads of all the jobs should not be more than the user maxThreads param
+      const int nbThreads = (_maxThreads > 0) ? std::min(_maxThreads, omp_get_num_procs()) : omp_get_num_procs();
+      omp_set_num_threads(std::max(1, static_cast<int>(nbThreads / nbRunningJobs)));
+    }
 
     const auto imageDescriberIndexes = useGPU ? job.gpuImageDescriberIndexes : job.cpuImageDescriberIndexes;
 
@@ -214,9 +436,10 @@ private:
       const feature::EImageDescriberType imageDescriberType = imageDescriber->getDescriberType();
       const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
 
-      // Compute features and descriptors and export them to files
+      // Compute features and descriptors
       ALICEVISION_LOG_INFO("Extracting " << imageDescriberTypeName  << " features from view '" << job.view.getImagePath() << "' " << (useGPU ? "[gpu]" : "[cpu]"));
 
+      timer.reset();
       std::unique_ptr<feature::Regions> regions;
       if(imageDescriber->useFloatImage())
       {
@@ -230,9 +453,30 @@ private:
           imageGrayUChar = (imageGrayFloat.GetMat() * 255.f).cast<unsigned char>();
         imageDescriber->describe(imageGrayUChar, regions);
       }
-      imageDescriber->Save(regions.get(), job.getFeaturesPath(imageDescriberType), job.getDescriptorPath(imageDescriberType));
+      addStageTime(&StageTimings::describe, timer.elapsed());
+
       ALICEVISION_LOG_INFO(std::left << std::setw(6) << " " << regions->RegionCount() << " " << imageDescriberTypeName  << " features extracted from view '" << job.view.getImagePath() << "'");
+      viewRegions.regionsPerDescriber.emplace_back(imageDescriberIndex, std::move(regions));
+    }
+  }
+
+  /// Export the regions to the features and descriptors files
+  void writeRegions(const ViewRegions& viewRegions)
+  {
+    const ViewJob& job = *viewRegions.job;
+    system::Timer timer;
+
+    for(const auto& describerRegions : viewRegions.regionsPerDescriber)
+    {
+      const auto& imageDescriber = _imageDescribers.at(describerRegions.first);
+      const feature::EImageDescriberType imageDescriberType = imageDescriber->getDescriberType();
+      const feature::Regions& regions = *describerRegions.second;
+
+      imageDescriber->Save(&regions, job.getFeaturesPath(imageDescriberType), job.getDescriptorPath(imageDescriberType));
+      if(_regionsContainer)
+        _regionsContainer->add(job.view.getViewId(), imageDescriberType, regions);
     }
+    addStageTime(&StageTimings::write, timer.elapsed());
   }
 
   const sfm::SfMData& _sfmData;
@@ -243,6 +487,22 @@ private:
   int _maxThreads = -1;
   std::vector<ViewJob> _cpuJobs;
   std::vector<ViewJob> _gpuJobs;
+  std::unique_ptr<feature::RegionsContainerWriter> _regionsContainer;
+
+  // CPU jobs scheduling
+  std::mutex _schedulerMutex;
+  std::condition_variable _jobCondition;
+  std::condition_variable _writeCondition;
+  std::vector<const ViewJob*> _pendingJobs;
+  std::deque<std::unique_ptr<ViewRegions>> _pendingWrites;
+  std::size_t _maxPendingWrites = 1;
+  std::size_t _memoryBudget = 0;
+  std::size_t _jobsMemory = 0;
+  std::size_t _peakJobsMemory = 0;
+  std::size_t _nbRunningJobs = 0;
+  std::size_t _nbRunningWorkers = 0;
+  std::exception_ptr _error;
+  StageTimings _stageTimings;
 };
 
 
@@ -265,6 +525,7 @@ int main(int argc, char **argv)
   int rangeSize = 1;
   int maxThreads = 0;
   bool forceCpuExtraction = false;
+  bool exportRegionsContainer = false;
 
   po::options_description allParams("AliceVision featureExtraction");
 
@@ -291,7 +552,10 @@ int main(int argc, char **argv)
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
       "Range size.")
     ("maxThreads", po::value<int>(&maxThreads)->default_value(maxThreads),
-      "Specifies the maximum number of threads to run simultaneously (0 for automatic mode).");
+      "Specifies the maximum number of threads to run simultaneously (0 for automatic mode).")
+    ("regionsContainer", po::value<bool>(&exportRegionsContainer)->default_value(exportRegionsContainer),
+      "Also export the features and descriptors in a binary container file (*.regions) "
+      "read in priority by the next steps.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -383,6 +647,13 @@ int main(int argc, char **argv)
     extractor.setRange(rangeStart, rangeSize);
   }
 
+  // set regions container (one per range)
+  if(exportRegionsContainer)
+  {
+    const std::string containerName = (rangeStart != -1) ? ("regions_" + std::to_string(rangeStart)) : "regions";
+    extractor.setRegionsContainer((fs::path(outputFolder) / (containerName + feature::REGIONS_CONTAINER_EXTENSION)).string());
+  }
+
   // initialize feature extractor imageDescribers
   {
     std::vector<feature::EImageDescriberType> imageDescriberTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
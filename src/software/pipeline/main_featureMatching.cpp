@@ -34,6 +34,7 @@
 #include <cstdlib>
 #include <fstream>
 #include <cctype>
+#include <random>
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -107,11 +108,13 @@ int main(int argc, char **argv)
   bool savePutativeMatches = false;
   bool guidedMatching = false;
   int maxIteration = 2048;
+  int nbParallelHypotheses = 1;
+  int randomSeed = std::mt19937::default_seed;
   bool matchFilePerImage = true;
   size_t numMatchesToKeep = 0;
   bool useGridSort = true;
   bool exportDebugFiles = false;
-  const std::string fileExtension = "txt";
+  std::string fileExtension = "txt";
 
   po::options_description allParams(
      "Compute corresponding features between a series of views:\n"
@@ -144,6 +147,7 @@ int main(int argc, char **argv)
     ("photometricMatchingMethod,p", po::value<std::string>(&nearestMatchingMethod)->default_value(nearestMatchingMethod),
       "For Scalar based regions descriptor:\n"
       "* BRUTE_FORCE_L2: L2 BruteForce matching\n"
+      "* BRUTE_FORCE_BLOCKED_L2: L2 BruteForce matching computed by blocks of descriptors (faster than BRUTE_FORCE_L2)\n"
       "* ANN_L2: L2 Approximate Nearest Neighbor matching\n"
       "* CASCADE_HASHING_L2: L2 Cascade Hashing matching\n"
       "* FAST_CASCADE_HASHING_L2: L2 Cascade Hashing with precomputed hashed regions\n"
@@ -163,10 +167,20 @@ int main(int argc, char **argv)
       "Use the found model to improve the pairwise correspondences.")
     ("matchFilePerImage", po::value<bool>(&matchFilePerImage)->default_value(matchFilePerImage),
       "Save matches in a separate file per image.")
+    ("matchFileFormat", po::value<std::string>(&fileExtension)->default_value(fileExtension),
+      "Matches file format:\n"
+      "* txt: text file\n"
+      "* bin: compact binary file with per image pair random access")
     ("distanceRatio", po::value<float>(&distRatio)->default_value(distRatio),
       "Distance ratio to discard non meaningful matches.")
     ("maxIteration", po::value<int>(&maxIteration)->default_value(maxIteration),
       "Maximum number of iterations allowed in ransac step.")
+    ("nbParallelHypotheses", po::value<int>(&nbParallelHypotheses)->default_value(nbParallelHypotheses),
+      "Number of hypotheses evaluated together in the ACRansac step of each image pair. "
+      "The matches depend on this value, not on the number of threads.")
+    ("randomSeed", po::value<int>(&randomSeed)->default_value(randomSeed),
+      "Seed of the random samples of the ransac step, the same for each image pair. "
+      "Set -1 to use a random seed.")
     ("useGridSort", po::value<bool>(&useGridSort)->default_value(useGridSort),
       "Use matching grid sort.")
     ("exportDebugFiles", po::value<bool>(&exportDebugFiles)->default_value(exportDebugFiles),
@@ -227,6 +241,12 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  if(fileExtension != "txt" && fileExtension != "bin")
+  {
+    ALICEVISION_LOG_ERROR("Invalid matches file format: " + fileExtension);
+    return EXIT_FAILURE;
+  }
+
   if(featuresFolder.empty())
   {
     ALICEVISION_LOG_INFO("Using matchesFolder as featuresFolder");
@@ -403,6 +423,9 @@ int main(int argc, char **argv)
 
   GeometricFilter geometricFilter(&sfmData, regionPerView);
 
+  const std::mt19937::result_type geometricSeed = (randomSeed == -1) ? std::random_device()() : randomSeed;
+  ALICEVISION_LOG_INFO("Geometric filtering random seed: " << geometricSeed);
+
   timer.reset();
   ALICEVISION_LOG_INFO("Geometric filtering");
 
@@ -412,7 +435,7 @@ int main(int argc, char **argv)
     case HOMOGRAPHY_MATRIX:
     {
       const bool bGeometric_only_guided_matching = true;
-      geometricFilter.Robust_model_estimation(GeometricFilterMatrix_H_AC(std::numeric_limits<double>::infinity(), maxIteration),
+      geometricFilter.Robust_model_estimation(GeometricFilterMatrix_H_AC(std::numeric_limits<double>::infinity(), maxIteration, nbParallelHypotheses, geometricSeed),
         mapPutativesMatches, guidedMatching,
         bGeometric_only_guided_matching ? -1.0 : 0.6);
       map_GeometricMatches = geometricFilter.Get_geometric_matches();
@@ -420,14 +443,14 @@ int main(int argc, char **argv)
     break;
     case FUNDAMENTAL_MATRIX:
     {
-      geometricFilter.Robust_model_estimation(GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator),
+      geometricFilter.Robust_model_estimation(GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator, nbParallelHypotheses, geometricSeed),
         mapPutativesMatches, guidedMatching);
       map_GeometricMatches = geometricFilter.Get_geometric_matches();
     }
     break;
     case ESSENTIAL_MATRIX:
     {
-      geometricFilter.Robust_model_estimation(GeometricFilterMatrix_E_AC(std::numeric_limits<double>::infinity(), maxIteration),
+      geometricFilter.Robust_model_estimation(GeometricFilterMatrix_E_AC(std::numeric_limits<double>::infinity(), maxIteration, nbParallelHypotheses, geometricSeed),
         mapPutativesMatches, guidedMatching);
       map_GeometricMatches = geometricFilter.Get_geometric_matches();
 
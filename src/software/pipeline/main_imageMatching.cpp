@@ -223,6 +223,40 @@ void convertAllMatchesToPairList(const PairList &allMatches, const std::size_t n
   }
 }
 
+/**
+ * It processes the matching images of the images queried in an incremental run (the new images)
+ * and adds the first numMatches ones of each image to the pair list, without repetitions.
+ * Unlike convertAllMatchesToPairList, the matching images can be images of a previous run
+ * that are not queried again.
+ *
+ * @param[in] newMatches A pairlist containing the matching images for each new image
+ * @param[in] numMatches The maximum number of matching images to consider for each image
+ * @param[out] outPairList The pairs, each one stored in the list of its smallest image ID
+ */
+void convertNewMatchesToPairList(const PairList &newMatches, const std::size_t numMatches, OrderedPairList &outPairList)
+{
+  outPairList.clear();
+
+  for(const auto& imageMatches : newMatches)
+  {
+    const ImageID currImageId = imageMatches.first;
+    std::size_t numFound = 0;
+
+    for(const ImageID currMatchId : imageMatches.second)
+    {
+      if(numFound == numMatches)
+        break;
+
+      // avoid self-matching
+      if(currMatchId == currImageId)
+        continue;
+
+      outPairList[std::min(currImageId, currMatchId)].insert(std::max(currImageId, currMatchId));
+      ++numFound;
+    }
+  }
+}
+
 void generateAllMatchesInOneMap(const std::map<IndexT, std::string>& descriptorsFiles, OrderedPairList& outPairList)
 {
   for(const auto& descItA: descriptorsFiles)
@@ -301,6 +335,10 @@ int main(int argc, char** argv)
   std::string weightsName;
   /// flag for the optional weights file
   bool withWeights = false;
+  /// the database of a previous run
+  std::string inputDatabase;
+  /// the file in which to save the database
+  std::string outputDatabase;
 
   // multiple SfM parameters
 
@@ -342,7 +380,12 @@ int main(int argc, char** argv)
       "The number of matches to retrieve for each image (If 0 it will "
       "retrieve all the matches).")
     ("weights,w", po::value<std::string>(&weightsName),
-      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.");
+      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.")
+    ("inputDatabase", po::value<std::string>(&inputDatabase),
+      "Database file saved by a previous run (see outputDatabase). Its images are not quantized again "
+      "and only the new images are queried: the output pair list only contains pairs with a new image.")
+    ("outputDatabase", po::value<std::string>(&outputDatabase),
+      "Output file path to save the database (images histograms and word weights) for an incremental run.");
 
   po::options_description multiSfMParams("Multiple SfM");
   multiSfMParams.add_options()
@@ -456,6 +499,26 @@ int main(int argc, char** argv)
     // add each object (document) to the database
     aliceVision::voctree::Database db(tree.words());
 
+    // images of a previous run, already in the database
+    const bool incremental = !inputDatabase.empty();
+    std::set<IndexT> previousImages;
+
+    if(incremental)
+    {
+      ALICEVISION_LOG_INFO("Loading database: " << inputDatabase);
+      db.load(inputDatabase);
+      if(db.words() != tree.words())
+      {
+        ALICEVISION_LOG_ERROR("The database '" << inputDatabase << "' has " << db.words() << " words, "
+                              "it has not been created with this vocabulary tree (" << tree.words() << " words).");
+        return EXIT_FAILURE;
+      }
+      for(const auto& document : db.getSparseHistogramPerImage())
+        previousImages.insert(document.first);
+      ALICEVISION_LOG_INFO("Database loaded with " << previousImages.size() << " images");
+    }
+
+    // the weights are loaded after the database, which has its own weights
     if(withWeights)
     {
       ALICEVISION_LOG_INFO("Loading weights...");
@@ -485,13 +548,14 @@ int main(int argc, char** argv)
     }
     auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
 
-    if((nbFeaturesLoadedInputA == 0) && (modeMultiSfM == EImageMatchingMultiSfM::A_AB))
+    // in an incremental run, all the images may already be in the database
+    if((nbFeaturesLoadedInputA == 0) && (modeMultiSfM == EImageMatchingMultiSfM::A_AB) && !incremental)
     {
       ALICEVISION_LOG_ERROR("No descriptors loaded in '" + sfmDataFilenameA + "'");
       return EXIT_FAILURE;
     }
 
-    if(useMultiSfM && nbFeaturesLoadedInputB == 0)
+    if(useMultiSfM && nbFeaturesLoadedInputB == 0 && !incremental)
     {
       ALICEVISION_LOG_ERROR("No descriptors loaded in '" + sfmDataFilenameB + "'");
       return EXIT_FAILURE;
@@ -507,6 +571,12 @@ int main(int argc, char** argv)
       db.computeTfIdfWeights();
     }
 
+    if(!outputDatabase.empty())
+    {
+      ALICEVISION_LOG_INFO("Saving database: " << outputDatabase);
+      db.save(outputDatabase);
+    }
+
     // query the database to get all the pair list
 
     if(numImageQuery == 0)
@@ -517,17 +587,24 @@ int main(int argc, char** argv)
 
     PairList allMatches;
 
-    ALICEVISION_LOG_INFO("Query all documents");
+    // in an incremental run, the images of A from the previous run have already been queried
+    std::vector<std::pair<IndexT, std::string>> queryFilesA;
+    for(const auto& descriptorsFileA : descriptorsFilesA)
+    {
+      if(modeMultiSfM == EImageMatchingMultiSfM::A_AB && previousImages.count(descriptorsFileA.first))
+        continue;
+      queryFilesA.push_back(descriptorsFileA);
+    }
+
+    ALICEVISION_LOG_INFO("Query " << queryFilesA.size() << " documents");
     detect_start = std::chrono::steady_clock::now();
 
     // now query each document
     #pragma omp parallel for
-    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFilesA.size()); ++i)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(queryFilesA.size()); ++i)
     {
-      auto itA = descriptorsFilesA.cbegin();
-      std::advance(itA, i);
-      const IndexT viewIdA = itA->first;
-      const std::string featuresPathA = itA->second;
+      const IndexT viewIdA = queryFilesA[i].first;
+      const std::string& featuresPathA = queryFilesA[i].second;
 
       aliceVision::voctree::SparseHistogram imageSH;
       if(modeMultiSfM == EImageMatchingMultiSfM::A_AB)
@@ -574,7 +651,10 @@ int main(int argc, char** argv)
     detect_start = std::chrono::steady_clock::now();
 
     ALICEVISION_LOG_INFO("Convert all matches to pairList");
-    convertAllMatchesToPairList(allMatches, numImageQuery, selectedPairs);
+    if(incremental)
+      convertNewMatchesToPairList(allMatches, numImageQuery, selectedPairs);
+    else
+      convertAllMatchesToPairList(allMatches, numImageQuery, selectedPairs);
     detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
     ALICEVISION_LOG_INFO("Convert all matches to pairList took " << detect_elapsed.count() << " sec.");
   }
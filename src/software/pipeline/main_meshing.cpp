@@ -16,6 +16,7 @@
 #include <aliceVision/fuseCut/LargeScale.hpp>
 #include <aliceVision/fuseCut/ReconstructionPlan.hpp>
 #include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+#include <aliceVision/fuseCut/MaxFlowGraph.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 
 #include <boost/program_options.hpp>
@@ -90,6 +91,8 @@ int main(int argc, char* argv[])
     int maxPtsPerVoxel = 6000000;
 
     fuseCut::FuseParams fuseParams;
+    fuseCut::EMaxFlowSolver maxflowSolver = fuseCut::EMaxFlowSolver::BOYKOV_KOLMOGOROV;
+    std::string maxflowGraphFilepath;
 
     po::options_description allParams("AliceVision meshing");
 
@@ -107,9 +110,14 @@ int main(int argc, char* argv[])
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
         ("maxInputPoints", po::value<int>(&fuseParams.maxInputPoints)->default_value(fuseParams.maxInputPoints),
-            "Max input points loaded from images.")
+            "Max input points loaded from images. It defines the density of the depth values sampled in the depth maps, not a memory limit.")
         ("maxPoints", po::value<int>(&fuseParams.maxPoints)->default_value(fuseParams.maxPoints),
             "Max points at the end of the depth maps fusion.")
+        ("maxMemory", po::value<int>(&fuseParams.maxMemory)->default_value(fuseParams.maxMemory),
+            "Memory budget (in MB) to load and filter the depth maps points. The points are spilled to disk and filtered by spatial buckets fitting in this budget. "
+            "0 to load all the points in memory.")
+        ("tmpFolder", po::value<std::string>(&fuseParams.tmpFolder)->default_value(fuseParams.tmpFolder),
+            "Folder for the temporary files of the depth maps fusion with a memory budget (output folder by default).")
         ("maxPointsPerVoxel", po::value<int>(&maxPtsPerVoxel)->default_value(maxPtsPerVoxel),
             "Max points per voxel.")
         ("minStep", po::value<int>(&fuseParams.minStep)->default_value(fuseParams.minStep),
@@ -141,7 +149,11 @@ int main(int argc, char* argv[])
             ("minAngleThreshold", po::value<double>(&fuseParams.minAngleThreshold)->default_value(fuseParams.minAngleThreshold),
                 "minAngleThreshold")
             ("refineFuse", po::value<bool>(&fuseParams.refineFuse)->default_value(fuseParams.refineFuse),
-                "refineFuse");
+                "refineFuse")
+            ("maxflowSolver", po::value<fuseCut::EMaxFlowSolver>(&maxflowSolver)->default_value(maxflowSolver),
+                "Maxflow solver of the graph-cut: 'boykov_kolmogorov' (single thread) or 'push_relabel' (multithreaded, less memory).")
+            ("saveMaxflowGraph", po::value<std::string>(&maxflowGraphFilepath),
+                "Save the maxflow graph in this file (to replay it with the maxflow benchmark).");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -187,6 +199,10 @@ int main(int argc, char* argv[])
     mvsUtils::MultiViewParams mp(iniFilepath, depthMapFolder, depthMapFilterFolder, true);
     mvsUtils::PreMatchCams pc(&mp);
 
+    mp._ini.put("delaunaycut.maxflowSolver", fuseCut::EMaxFlowSolver_enumToString(maxflowSolver));
+    if(!maxflowGraphFilepath.empty())
+        mp._ini.put("delaunaycut.saveMaxflowGraph", maxflowGraphFilepath);
+
     int ocTreeDim = mp._ini.get<int>("LargeScale.gridLevel0", 1024);
     const auto baseDir = mp._ini.get<std::string>("LargeScale.baseDirName", "root01024");
 
@@ -196,6 +212,9 @@ int main(int argc, char* argv[])
 
     bfs::path tmpDirectory = outDirectory / "tmp";
 
+    if(fuseParams.tmpFolder.empty())
+        fuseParams.tmpFolder = tmpDirectory.string();
+
     ALICEVISION_LOG_WARNING("repartitionMode: " << repartitionMode);
     ALICEVISION_LOG_WARNING("partitioningMode: " << partitioningMode);
 